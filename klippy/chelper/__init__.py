@@ -14,19 +14,32 @@ import cffi
 GCC_CMD = "gcc"
 COMPILE_ARGS = ("-Wall -g -O2 -shared -fPIC"
                 " -flto -fwhole-program -fno-use-linker-plugin"
+                " -fno-math-errno"
                 " -o %s %s")
 SSE_FLAGS = "-mfpmath=sse -msse2"
 SOURCE_FILES = [
     'pyhelper.c', 'serialqueue.c', 'stepcompress.c', 'steppersync.c',
-    'itersolve.c', 'trapq.c', 'pollreactor.c', 'msgblock.c', 'trdispatch.c',
+    'itersolve.c', 'trapq.c', 'lookahead.c', 'pollreactor.c', 'hostreactor.c',
+    'msgblock.c', 'msgproto.c', 'gcodeparse.c', 'zmesh.c', 'arcs.c',
+    'clocksync.c', 'polygonset.c', 'accelsamples.c', 'bulksamples.c',
+    'anglesamples.c', 'ledframe.c', 'shmring.c',
+    'trdispatch.c', 'coorddesc.c', 'psd.c', 'displayfb.c', 'tempconv.c',
+    'transformchain.c',
+    'kincheck.c',
     'kin_cartesian.c', 'kin_corexy.c', 'kin_corexz.c', 'kin_delta.c',
     'kin_deltesian.c', 'kin_polar.c', 'kin_rotary_delta.c', 'kin_winch.c',
-    'kin_extruder.c', 'kin_shaper.c', 'kin_idex.c', 'kin_generic.c'
+    'kin_extruder.c', 'kin_shaper.c', 'kin_idex.c', 'kin_generic.c',
+    'kin_skew.c'
 ]
 DEST_LIB = "c_helper.so"
 OTHER_FILES = [
     'list.h', 'serialqueue.h', 'stepcompress.h', 'steppersync.h',
-    'itersolve.h', 'pyhelper.h', 'trapq.h', 'pollreactor.h', 'msgblock.h'
+    'itersolve.h', 'pyhelper.h', 'trapq.h', 'lookahead.h', 'pollreactor.h',
+    'hostreactor.h', 'msgblock.h', 'msgproto.h', 'gcodeparse.h', 'zmesh.h',
+    'arcs.h', 'clocksync.h', 'polygonset.h', 'accelsamples.h',
+    'bulksamples.h', 'anglesamples.h', 'ledframe.h', 'shmring.h',
+    'transformchain.h',
+    'coorddesc.h', 'psd.h', 'displayfb.h', 'kincheck.h'
 ]
 
 defs_stepcompress = """
@@ -38,14 +51,22 @@ defs_stepcompress = """
 
     void stepcompress_fill(struct stepcompress *sc, uint32_t oid
         , uint32_t max_error, int32_t queue_step_msgtag
-        , int32_t set_next_step_dir_msgtag);
+        , int32_t set_next_step_dir_msgtag
+        , int32_t queue_step_repeat_msgtag
+        , int32_t queue_step_pack_msgtag);
+    void stepcompress_set_error_velocity(struct stepcompress *sc
+        , uint32_t highspeed_error, double vel_ref);
     void stepcompress_set_invert_sdir(struct stepcompress *sc
         , uint32_t invert_sdir);
+    void stepcompress_set_export(struct stepcompress *sc, struct shmring *sr);
     int stepcompress_reset(struct stepcompress *sc, uint64_t last_step_clock);
     int stepcompress_set_last_position(struct stepcompress *sc
         , uint64_t clock, int64_t last_position);
     int64_t stepcompress_find_past_position(struct stepcompress *sc
         , uint64_t clock);
+    void stepcompress_find_past_positions(struct stepcompress *sc
+        , uint64_t start_clock, uint64_t interval_clock, int count
+        , int64_t *positions);
     int stepcompress_extract_old(struct stepcompress *sc
         , struct pull_history_steps *p, int max
         , uint64_t start_clock, uint64_t end_clock);
@@ -59,12 +80,15 @@ defs_steppersync = """
         struct syncemitter *se);
     void syncemitter_queue_msg(struct syncemitter *se, uint64_t req_clock
         , uint32_t *data, int len);
+    double syncemitter_get_min_margin(struct syncemitter *se, int reset);
     struct syncemitter *steppersync_alloc_syncemitter(struct steppersync *ss
         , char name[16], int alloc_stepcompress);
     void steppersync_setup_movequeue(struct steppersync *ss
         , struct serialqueue *sq, int move_num);
     void steppersync_set_time(struct steppersync *ss
         , double time_offset, double mcu_freq);
+    void steppersync_get_margin_stats(struct steppersync *ss, int reset
+        , double *min_margin, uint32_t *hist);
     struct steppersyncmgr *steppersyncmgr_alloc(void);
     void steppersyncmgr_free(struct steppersyncmgr *ssm);
     struct steppersync *steppersyncmgr_alloc_steppersync(
@@ -90,6 +114,14 @@ defs_itersolve = """
 """
 
 defs_trapq = """
+    struct push_move {
+        double print_time;
+        double accel_t, cruise_t, decel_t;
+        double start_x, start_y, start_z;
+        double x_r, y_r, z_r;
+        double start_v, cruise_v, accel;
+    };
+
     struct pull_move {
         double print_time, move_t;
         double start_v, accel;
@@ -104,12 +136,250 @@ defs_trapq = """
         , double start_pos_x, double start_pos_y, double start_pos_z
         , double axes_r_x, double axes_r_y, double axes_r_z
         , double start_v, double cruise_v, double accel);
+    void trapq_append_moves(struct trapq *tq, struct push_move *p, int count);
+    void trapq_set_export(struct trapq *tq, struct shmring *sr
+        , uint32_t export_id);
     void trapq_finalize_moves(struct trapq *tq, double print_time
         , double clear_history_time);
     void trapq_set_position(struct trapq *tq, double print_time
         , double pos_x, double pos_y, double pos_z);
     int trapq_extract_old(struct trapq *tq, struct pull_move *p, int max
         , double start_time, double end_time);
+    int trapq_extract_changed(struct trapq *tq, struct pull_move *p, int max
+        , uint64_t *generation);
+"""
+
+defs_gcodeparse = """
+    struct gc_param {
+        int key_pos, key_len, value_pos, value_len;
+        double fvalue;
+        int fvalid;
+    };
+
+    int gcodeparse_line(const char *data, int len, struct gc_param *params
+        , int max_params, int *cmd_bounds);
+
+    struct gc_lookup;
+    struct gc_lookup *gc_lookup_alloc(void);
+    void gc_lookup_free(struct gc_lookup *gl);
+    void gc_lookup_clear(struct gc_lookup *gl);
+    int gc_lookup_add(struct gc_lookup *gl, const char *name, int len, int id);
+    int gcodeparse_lookup(struct gc_lookup *gl, const char *data
+        , int *cmd_bounds);
+"""
+
+defs_zmesh = """
+    struct zmesh *zmesh_alloc(const double *z, int x_count, int y_count
+        , double min_x, double x_dist, double min_y, double y_dist);
+    void zmesh_free(struct zmesh *zm);
+    void zmesh_set_offsets(struct zmesh *zm, double x_offset
+        , double y_offset);
+    double zmesh_calc_z(struct zmesh *zm, double x, double y);
+    double zmesh_next_split(struct zmesh *zm, double prev_x, double prev_y
+        , double next_x, double next_y, double move_len
+        , double dist_checked, double check_dist
+        , double z_offset, double split_delta_z
+        , double z_factor, double fade_offset, double *next_z);
+"""
+
+defs_arcs = """
+    void arcs_expand(double *coords, int segments
+        , double offset_p, double offset_q
+        , double center_p, double center_q, double helical_start
+        , double theta_per_segment, double linear_per_segment
+        , int alpha_axis, int beta_axis, int helical_axis
+        , double target_alpha, double target_beta, double target_helical);
+"""
+
+defs_clocksync = """
+    struct clockfilter {
+        double mcu_freq;
+        uint64_t last_clock;
+        double min_half_rtt, min_rtt_time;
+        double time_avg, time_variance;
+        double clock_avg, clock_covariance;
+        double prediction_variance, last_prediction_time;
+        double est_sample_time, est_clock, est_freq;
+        double last_clock_diff;
+    };
+
+    enum {
+        CF_NO_SENT_TIME = 1, CF_NEW_MIN_RTT = 2,
+        CF_SAMPLE_IGNORED = 4, CF_VARIANCE_RESET = 8,
+    };
+
+    struct clockfilter *clockfilter_alloc(void);
+    void clockfilter_init(struct clockfilter *cf, double mcu_freq
+        , uint64_t clock, double sent_time);
+    int clockfilter_update(struct clockfilter *cf, struct serialqueue *sq
+        , uint32_t clock32, double sent_time, double receive_time);
+"""
+
+defs_polygonset = """
+    struct polygonset *polygonset_alloc(void);
+    void polygonset_free(struct polygonset *ps);
+    int polygonset_add(struct polygonset *ps, const double *points
+        , int num_points);
+    int polygonset_find(struct polygonset *ps, double x, double y);
+    void polygonset_batch(struct polygonset *ps, const double *xy, int count
+        , int *results);
+"""
+
+defs_shmring = """
+    struct shmring *shmring_open(const char *filename, uint32_t record_size
+        , uint32_t num_records);
+    void shmring_close(struct shmring *sr);
+    uint32_t shm_motion_record_size(void);
+"""
+
+defs_accelsamples = """
+    enum {
+        ACCEL_FMT_ADXL345 = 0, ACCEL_FMT_INT16_BE = 1,
+        ACCEL_FMT_INT16_LE = 2,
+    };
+
+    struct accel_samples *accel_samples_alloc(int format);
+    void accel_samples_set_axes(struct accel_samples *as, const int *axes_pos
+        , const double *axes_scale);
+    int accel_samples_get_errors(struct accel_samples *as);
+    void accel_samples_reset_errors(struct accel_samples *as);
+    int accel_samples_decode(struct accel_samples *as, const uint8_t *data
+        , int len, double time_base, double inv_freq, double chip_start
+        , double *out);
+"""
+
+defs_anglesamples = """
+    struct angle_samples *angle_samples_alloc(void);
+    void angle_samples_set_calibration(struct angle_samples *as
+        , const int32_t *table, int count, int reversed);
+    void angle_samples_setup_batch(struct angle_samples *as
+        , double start_clock, uint32_t sample_ticks, uint32_t burst_count
+        , int time_shift, double time_base, double inv_freq
+        , double static_delay);
+    void angle_samples_setup_tcode_absolute(struct angle_samples *as
+        , double last_chip_mcu_clock, double last_chip_clock
+        , double chip_freq);
+    int angle_samples_get_errors(struct angle_samples *as);
+    void angle_samples_reset_errors(struct angle_samples *as);
+    int angle_samples_decode(struct angle_samples *as, const uint8_t *data
+        , int len, uint64_t sample_count, double *out);
+"""
+
+defs_ledframe = """
+    enum {
+        LED_EFFECT_GRADIENT = 0, LED_EFFECT_CHASE = 1,
+        LED_EFFECT_BREATHE = 2, LED_EFFECT_PROGRESS = 3,
+    };
+
+    struct led_frame *led_frame_alloc(int led_count);
+    void led_frame_setup_effect(struct led_frame *lf, int effect, double rate
+        , double scale, const double *color1, const double *color2);
+    int led_frame_render(struct led_frame *lf, double time, double progress
+        , double *out);
+"""
+
+defs_transformchain = """
+    struct transform_chain *transform_chain_alloc(void);
+    int transform_chain_set(struct transform_chain *tc, const double *m
+        , const double *offset);
+    void transform_chain_apply(struct transform_chain *tc, double *pos);
+    void transform_chain_unapply(struct transform_chain *tc, double *pos);
+"""
+
+defs_bulksamples = """
+    enum {
+        BULK_FMT_INT32_LE = 0, BULK_FMT_INT32_BE = 1,
+        BULK_FMT_UINT32_LE = 2, BULK_FMT_UINT32_BE = 3,
+    };
+
+    struct bulk_samples *bulk_samples_alloc(int format);
+    int bulk_samples_decode(struct bulk_samples *bs, const uint8_t *data
+        , int len, double time_base, double inv_freq, double chip_start
+        , double *out);
+"""
+
+defs_hostreactor = """
+    struct hr_fd_event {
+        int fd, flags;
+    };
+
+    struct hostreactor *hostreactor_alloc(void);
+    void hostreactor_free(struct hostreactor *hr);
+    int hostreactor_register_fd(struct hostreactor *hr, int fd);
+    void hostreactor_unregister_fd(struct hostreactor *hr, int fd);
+    void hostreactor_set_fd_wake(struct hostreactor *hr, int fd, int flags);
+    int hostreactor_wait(struct hostreactor *hr, double timeout
+        , struct hr_fd_event *events, int max);
+    int hostreactor_alloc_timer(struct hostreactor *hr, double waketime);
+    void hostreactor_free_timer(struct hostreactor *hr, int id);
+    void hostreactor_update_timer(struct hostreactor *hr, int id
+        , double waketime);
+    void hostreactor_set_timer_jitter(struct hostreactor *hr, int id
+        , double jitter);
+    double hostreactor_next_timer(struct hostreactor *hr);
+    int hostreactor_check_timers(struct hostreactor *hr, double eventtime
+        , int *ids, int max);
+"""
+
+defs_msgproto = """
+    struct mp_value {
+        int64_t iv;
+        int32_t spos, slen;
+    };
+
+    struct mp_format *msgproto_format_alloc(const char *msgid_bytes
+        , int num_msgid_bytes, const char *param_types, int num_params);
+    int msgproto_parse(struct mp_format *mf, const char *data, int len
+        , int pos, struct mp_value *values);
+    int msgproto_encode(struct mp_format *mf, char *buf
+        , struct mp_value *values);
+"""
+
+defs_lookahead = """
+    struct lookahead_move {
+        double move_d, accel;
+        double max_start_v2, max_cruise_v2, delta_v2;
+        double max_mcr_start_v2, mcr_delta_v2;
+        double start_x, start_y, start_z;
+        double x_r, y_r, z_r;
+        int is_kinematic;
+        double start_v, cruise_v, end_v;
+        double accel_t, cruise_t, decel_t;
+        double c_start_v2, c_cruise_v2, c_next_start_v2;
+    };
+
+    double lookahead_calc_junction(double prev_axes_r_x, double prev_axes_r_y
+        , double prev_axes_r_z, double axes_r_x, double axes_r_y
+        , double axes_r_z, double jd_accel, double prev_jd_accel
+        , double delta_v2, double prev_delta_v2, double max_start_v2);
+    int lookahead_flush(struct lookahead_move *moves, int count, int lazy);
+    double trapq_append_lookahead(struct trapq *tq, double print_time
+        , struct lookahead_move *moves, int count);
+"""
+
+defs_kincheck = """
+    struct kin_limits {
+        double limits[3][2];
+        double max_z_velocity, max_z_accel;
+        double max_velocity, max_accel;
+        int need_home;
+        double max_xy2, slow_xy2, very_slow_xy2;
+        double radius, min_arm2, min_arm_length;
+        double min_z, max_z, limit_z;
+        double home_x, home_y, home_z;
+        double limit_xy2;
+    };
+
+    enum {
+        KC_OK = 0, KC_LIMIT_SPEED = 1, KC_MOVE_ERROR = -1, KC_MUST_HOME = -2,
+    };
+
+    int kincheck_cart_move(struct kin_limits *kl, double move_d
+        , double start_x, double start_y, double start_z
+        , double end_x, double end_y, double end_z, double *move_limits);
+    int kincheck_delta_move(struct kin_limits *kl, double move_d
+        , double start_x, double start_y, double start_z
+        , double end_x, double end_y, double end_z, double *move_limits);
 """
 
 defs_kin_cartesian = """
@@ -160,17 +430,31 @@ defs_kin_extruder = """
     void extruder_stepper_free(struct stepper_kinematics *sk);
     void extruder_set_pressure_advance(struct stepper_kinematics *sk
         , double print_time, double pressure_advance, double smooth_time);
+    void extruder_set_pressure_advance_table(struct stepper_kinematics *sk
+        , double print_time, double *advances, int count, double vel_step
+        , double smooth_time);
 """
 
 defs_kin_shaper = """
     int input_shaper_set_shaper_params(struct stepper_kinematics *sk, char axis
         , int n, double a[], double t[]);
+    int input_shaper_schedule_shaper_params(struct stepper_kinematics *sk
+        , char axis, int n, double a[], double t[]
+        , double swap_time, double fade_time);
     int input_shaper_set_sk(struct stepper_kinematics *sk
         , struct stepper_kinematics *orig_sk);
     void input_shaper_update_sk(struct stepper_kinematics *sk);
     struct stepper_kinematics * input_shaper_alloc(void);
 """
 
+defs_kin_skew = """
+    int skew_correction_set_sk(struct stepper_kinematics *sk
+        , struct stepper_kinematics *orig_sk);
+    void skew_correction_set_params(struct stepper_kinematics *sk
+        , double xy_factor, double xz_factor, double yz_factor);
+    struct stepper_kinematics * skew_correction_alloc(void);
+"""
+
 defs_kin_idex = """
     void dual_carriage_set_sk(struct stepper_kinematics *sk
         , struct stepper_kinematics *orig_sk);
@@ -194,18 +478,48 @@ defs_serialqueue = """
     void serialqueue_free(struct serialqueue *sq);
     struct command_queue *serialqueue_alloc_commandqueue(void);
     void serialqueue_free_commandqueue(struct command_queue *cq);
+    void serialqueue_set_commandqueue_lane(struct command_queue *cq, int lane);
     void serialqueue_send(struct serialqueue *sq, struct command_queue *cq
         , uint8_t *msg, int len, uint64_t min_clock, uint64_t req_clock
         , uint64_t notify_id);
+    void serialqueue_send_template(struct serialqueue *sq
+        , struct command_queue *cq, struct mp_format *mf, int64_t *params
+        , int num_cmds, uint64_t min_clock, uint64_t req_clock);
     void serialqueue_pull(struct serialqueue *sq
         , struct pull_queue_message *pqm);
+    struct bulk_sample {
+        double receive_time;
+        uint32_t len;
+        uint8_t data[59];
+    };
+    struct bulkreader *serialqueue_alloc_bulkreader(
+        struct serialqueue *sq, uint8_t *prefix, int prefix_len
+        , int num_int_params, int ring_size);
+    void serialqueue_free_bulkreader(struct serialqueue *sq
+        , struct bulkreader *br);
+    int serialqueue_bulkreader_count(struct bulkreader *br);
+    struct bulk_sample *serialqueue_bulkreader_peek(struct bulkreader *br
+        , int idx);
+    void serialqueue_bulkreader_pop(struct bulkreader *br, int count);
+    int serialqueue_bulkreader_overflows(struct bulkreader *br);
+    void serialqueue_set_secondary_fd(struct serialqueue *sq
+        , int secondary_fd);
+    void serialqueue_set_canbus_fd(struct serialqueue *sq);
     void serialqueue_set_wire_frequency(struct serialqueue *sq
         , double frequency);
+    int serialqueue_set_cpu_layout(struct serialqueue *sq, int cpu
+        , int rt_priority);
+    int serialqueue_get_thread_id(struct serialqueue *sq);
     void serialqueue_set_receive_window(struct serialqueue *sq
         , int receive_window);
     void serialqueue_set_clock_est(struct serialqueue *sq, double est_freq
         , double conv_time, uint64_t conv_clock, uint64_t last_clock);
+    int serialqueue_start_record(struct serialqueue *sq, const char *filename
+        , uint32_t num_records);
+    void serialqueue_stop_record(struct serialqueue *sq);
     void serialqueue_get_stats(struct serialqueue *sq, char *buf, int len);
+    void serialqueue_get_latency_histograms(struct serialqueue *sq
+        , uint32_t *buf);
     int serialqueue_extract_old(struct serialqueue *sq, int sentq
         , struct pull_queue_message *q, int max);
 """
@@ -217,12 +531,52 @@ defs_trdispatch = """
     struct trdispatch_mcu *trdispatch_mcu_alloc(struct trdispatch *td
         , struct serialqueue *sq, struct command_queue *cq, uint32_t trsync_oid
         , uint32_t set_timeout_msgtag, uint32_t trigger_msgtag
-        , uint32_t state_msgtag);
+        , uint32_t set_window_msgtag, uint32_t state_msgtag);
+    void trdispatch_mcu_set_trigger_window(struct trdispatch_mcu *tdm
+        , uint64_t clock, uint32_t report_ticks);
     void trdispatch_mcu_setup(struct trdispatch_mcu *tdm
         , uint64_t last_status_clock, uint64_t expire_clock
         , uint64_t expire_ticks, uint64_t min_extend_ticks);
 """
 
+defs_coorddesc = """
+    typedef void (*coorddesc_eval_fn)(double *errors, const double *params
+        , int count, int num_params);
+
+    double coorddesc_solve(int num_params, double *params, double threshold
+        , int max_rounds, int *rounds_out, coorddesc_eval_fn eval);
+    void coorddesc_trilateration(const double *sphere_coords
+        , const double *radius2, double *out);
+    void coorddesc_trilateration_batch(const double *sphere_coords
+        , const double *radius2, double *out, int count);
+"""
+
+defs_psd = """
+    struct psd_accum *psd_accum_alloc(int nfft);
+    void psd_accum_free(struct psd_accum *pa);
+    void psd_accum_add(struct psd_accum *pa, const double *samples, int count);
+    int psd_accum_get_num_windows(struct psd_accum *pa);
+    int psd_accum_get_nfft(struct psd_accum *pa);
+    void psd_accum_finalize(struct psd_accum *pa, double fs, double *freqs
+        , double *psd_x, double *psd_y, double *psd_z);
+    void shaper_estimate_response(const double *shaper_a
+        , const double *shaper_t, int n, double damping_ratio
+        , const double *freqs, int count, double *out);
+"""
+
+defs_displayfb = """
+    int displayfb_find_dirty(uint8_t *new_data, uint8_t *old_data, int len
+        , int max_gap, int max_batch, int *runs);
+"""
+
+defs_tempconv = """
+    struct temp_conversion;
+    struct temp_conversion *temp_conversion_alloc(int count);
+    void temp_conversion_fill(struct temp_conversion *tc, double adc_base
+        , double adc_step, double *temps);
+    double temp_conversion_calc_temp(struct temp_conversion *tc, double adc);
+"""
+
 defs_pyhelper = """
     void set_python_logging_callback(void (*func)(const char *));
     double get_monotonic(void);
@@ -234,12 +588,20 @@ defs_std = """
 """
 
 defs_all = [
-    defs_pyhelper, defs_serialqueue, defs_std, defs_stepcompress,
-    defs_steppersync, defs_itersolve, defs_trapq, defs_trdispatch,
+    defs_pyhelper, defs_serialqueue, defs_std, defs_shmring,
+    defs_stepcompress,
+    defs_steppersync, defs_itersolve, defs_trapq, defs_lookahead,
+    defs_kincheck,
+    defs_msgproto, defs_hostreactor, defs_gcodeparse, defs_zmesh, defs_arcs,
+    defs_clocksync, defs_polygonset, defs_accelsamples, defs_bulksamples,
+    defs_anglesamples, defs_ledframe,
+    defs_trdispatch,
+    defs_coorddesc, defs_psd, defs_displayfb, defs_tempconv,
+    defs_transformchain,
     defs_kin_cartesian, defs_kin_corexy, defs_kin_corexz, defs_kin_delta,
     defs_kin_deltesian, defs_kin_polar, defs_kin_rotary_delta, defs_kin_winch,
     defs_kin_extruder, defs_kin_shaper, defs_kin_idex,
-    defs_kin_generic_cartesian,
+    defs_kin_generic_cartesian, defs_kin_skew,
 ]
 
 # Update filenames to an absolute path
@@ -292,6 +654,14 @@ def check_build_c_library():
         cmd = "%s %s %s" % (GCC_CMD, SSE_FLAGS, COMPILE_ARGS)
     else:
         cmd = "%s %s" % (GCC_CMD, COMPILE_ARGS)
+    # Allow per-machine tuning flags (eg, "-mcpu=cortex-a7" on armhf hosts)
+    extra_flags = os.environ.get("CHELPER_EXTRA_COMPILE_ARGS", "")
+    if extra_flags:
+        if check_gcc_option(extra_flags):
+            cmd = cmd.replace(GCC_CMD, "%s %s" % (GCC_CMD, extra_flags), 1)
+        else:
+            logging.warning("Ignoring unsupported CHELPER_EXTRA_COMPILE_ARGS"
+                            " '%s'", extra_flags)
     # Invoke compiler
     logging.info("Building C code module %s", DEST_LIB)
     tempdestlib = get_abs_files(srcdir, ["_temp_" + DEST_LIB])[0]
@@ -326,6 +696,33 @@ def get_ffi():
     return FFI_main, FFI_lib
 
 
+######################################################################
+# Standalone benchmark harness
+######################################################################
+
+BENCH_COMPILE_ARGS = "-Wall -g -O2 -fno-math-errno -o %s %s -lpthread -lm"
+BENCH_SOURCE_FILES = [
+    'bench.c', 'pyhelper.c', 'shmring.c', 'msgblock.c', 'trapq.c',
+    'itersolve.c', 'stepcompress.c', 'kin_cartesian.c', 'kin_corexy.c',
+    'kin_delta.c', 'kin_shaper.c'
+]
+BENCH_TARGET = "bench"
+
+# Build (if needed) and run the chelper benchmark harness
+def run_benchmark(args):
+    srcdir = os.path.dirname(os.path.realpath(__file__))
+    srcfiles = get_abs_files(srcdir, BENCH_SOURCE_FILES)
+    ofiles = get_abs_files(srcdir, OTHER_FILES)
+    dest = get_abs_files(srcdir, [BENCH_TARGET])[0]
+    if check_build_code(srcfiles + ofiles, dest):
+        logging.info("Building C benchmark %s", BENCH_TARGET)
+        cmd = "%s %s" % (GCC_CMD, BENCH_COMPILE_ARGS)
+        if check_gcc_option(SSE_FLAGS):
+            cmd = "%s %s %s" % (GCC_CMD, SSE_FLAGS, BENCH_COMPILE_ARGS)
+        do_build_code(cmd % (dest, ' '.join(srcfiles)))
+    os.execv(dest, [dest] + args)
+
+
 ######################################################################
 # hub-ctrl hub power controller
 ######################################################################
@@ -348,4 +745,7 @@ def run_hub_ctrl(enable_power):
 
 
 if __name__ == '__main__':
+    import sys
+    if len(sys.argv) > 1 and sys.argv[1] == 'bench':
+        run_benchmark(sys.argv[2:])
     get_ffi()
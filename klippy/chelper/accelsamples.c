@@ -0,0 +1,105 @@
+// Decoding of bulk accelerometer samples
+//
+// Copyright (C) 2025  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // nearbyint
+#include <stdint.h> // uint8_t
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "accelsamples.h" // accel_samples_alloc
+
+struct accel_samples {
+    int format, bytes_per_sample;
+    int axes_pos[3];
+    double axes_scale[3];
+    int error_count;
+};
+
+// Allocate a decoder for one of the ACCEL_FMT_xxx sample encodings
+struct accel_samples * __visible
+accel_samples_alloc(int format)
+{
+    struct accel_samples *as = malloc(sizeof(*as));
+    memset(as, 0, sizeof(*as));
+    as->format = format;
+    as->bytes_per_sample = format == ACCEL_FMT_ADXL345 ? 5 : 6;
+    as->axes_scale[0] = as->axes_scale[1] = as->axes_scale[2] = 1.;
+    return as;
+}
+
+// Set the raw axis to x/y/z mapping and per-axis scaling
+void __visible
+accel_samples_set_axes(struct accel_samples *as, const int *axes_pos
+                       , const double *axes_scale)
+{
+    int i;
+    for (i = 0; i < 3; i++) {
+        as->axes_pos[i] = axes_pos[i];
+        as->axes_scale[i] = axes_scale[i];
+    }
+}
+
+int __visible
+accel_samples_get_errors(struct accel_samples *as)
+{
+    return as->error_count;
+}
+
+void __visible
+accel_samples_reset_errors(struct accel_samples *as)
+{
+    as->error_count = 0;
+}
+
+static double
+round6(double v)
+{
+    return nearbyint(v * 1000000.) / 1000000.;
+}
+
+// Decode one sensor_bulk_data payload into (time, x, y, z) rows.
+// Returns the number of rows written (error frames are dropped, but
+// still advance the sample time).
+int __visible
+accel_samples_decode(struct accel_samples *as, const uint8_t *data, int len
+                     , double time_base, double inv_freq, double chip_start
+                     , double *out)
+{
+    int num_samples = len / as->bytes_per_sample, count = 0, i;
+    for (i = 0; i < num_samples; i++) {
+        const uint8_t *d = &data[i * as->bytes_per_sample];
+        int32_t raw_xyz[3];
+        if (as->format == ACCEL_FMT_ADXL345) {
+            int32_t xlow = d[0], ylow = d[1], zlow = d[2];
+            int32_t xzhigh = d[3], yzhigh = d[4];
+            if (yzhigh & 0x80) {
+                as->error_count++;
+                continue;
+            }
+            raw_xyz[0] = (xlow | ((xzhigh & 0x1f) << 8))
+                - ((xzhigh & 0x10) << 9);
+            raw_xyz[1] = (ylow | ((yzhigh & 0x1f) << 8))
+                - ((yzhigh & 0x10) << 9);
+            raw_xyz[2] = (zlow | ((xzhigh & 0xe0) << 3)
+                          | ((yzhigh & 0xe0) << 6)) - ((yzhigh & 0x40) << 7);
+        } else if (as->format == ACCEL_FMT_INT16_BE) {
+            int j;
+            for (j = 0; j < 3; j++)
+                raw_xyz[j] = (int16_t)((d[2*j] << 8) | d[2*j + 1]);
+        } else {
+            int j;
+            for (j = 0; j < 3; j++)
+                raw_xyz[j] = (int16_t)((d[2*j + 1] << 8) | d[2*j]);
+        }
+        double *row = &out[4 * count++];
+        row[0] = round6(time_base + (chip_start + i) * inv_freq);
+        int j;
+        for (j = 0; j < 3; j++)
+            row[1 + j] = round6(raw_xyz[as->axes_pos[j]]
+                                * as->axes_scale[j]);
+    }
+    return count;
+}
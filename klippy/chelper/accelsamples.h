@@ -0,0 +1,19 @@
+#ifndef ACCELSAMPLES_H
+#define ACCELSAMPLES_H
+
+#include <stdint.h> // uint8_t
+
+enum {
+    ACCEL_FMT_ADXL345 = 0, ACCEL_FMT_INT16_BE = 1, ACCEL_FMT_INT16_LE = 2,
+};
+
+struct accel_samples *accel_samples_alloc(int format);
+void accel_samples_set_axes(struct accel_samples *as, const int *axes_pos
+                            , const double *axes_scale);
+int accel_samples_get_errors(struct accel_samples *as);
+void accel_samples_reset_errors(struct accel_samples *as);
+int accel_samples_decode(struct accel_samples *as, const uint8_t *data
+                         , int len, double time_base, double inv_freq
+                         , double chip_start, double *out);
+
+#endif // accelsamples.h
@@ -0,0 +1,165 @@
+// Decoding and calibration of bulk angle sensor samples
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // nearbyint
+#include <stdint.h> // uint8_t
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "anglesamples.h" // angle_samples_alloc
+
+#define ANGLE_BITS 16 // angles range from 0..65535
+#define CALIBRATION_BITS 6 // 64 entries
+#define CALIBRATION_COUNT (1 << CALIBRATION_BITS)
+#define BYTES_PER_SAMPLE 3
+#define TCODE_ERROR 0xff
+
+struct angle_samples {
+    // Batch timing parameters
+    double start_clock, time_base, inv_freq, static_delay;
+    uint32_t sample_ticks, burst_count;
+    int time_shift, is_tcode_absolute;
+    // tle5012b chip clock tracking
+    double last_chip_mcu_clock, last_chip_clock, chip_freq, inv_chip_freq;
+    // Calibration table (linear interpolation buckets)
+    int have_calibration, calibration_reversed;
+    int32_t calibration[CALIBRATION_COUNT + 1];
+    // Decode state
+    int64_t last_angle;
+    int error_count;
+};
+
+// Allocate an angle sample decoder
+struct angle_samples * __visible
+angle_samples_alloc(void)
+{
+    struct angle_samples *as = malloc(sizeof(*as));
+    memset(as, 0, sizeof(*as));
+    as->burst_count = 1;
+    return as;
+}
+
+// Set (or clear) the angle calibration interpolation table
+void __visible
+angle_samples_set_calibration(struct angle_samples *as, const int32_t *table
+                              , int count, int reversed)
+{
+    if (count != CALIBRATION_COUNT + 1) {
+        as->have_calibration = 0;
+        return;
+    }
+    memcpy(as->calibration, table, sizeof(as->calibration));
+    as->calibration_reversed = reversed;
+    as->have_calibration = 1;
+}
+
+// Set the sample timing parameters for a batch of messages
+void __visible
+angle_samples_setup_batch(struct angle_samples *as, double start_clock
+                          , uint32_t sample_ticks, uint32_t burst_count
+                          , int time_shift, double time_base, double inv_freq
+                          , double static_delay)
+{
+    as->start_clock = start_clock;
+    as->sample_ticks = sample_ticks;
+    as->burst_count = burst_count ? burst_count : 1;
+    as->time_shift = time_shift;
+    as->time_base = time_base;
+    as->inv_freq = inv_freq;
+    as->static_delay = static_delay;
+    as->is_tcode_absolute = 0;
+}
+
+// Switch to tle5012b style decoding (tcode is a chip frame counter)
+void __visible
+angle_samples_setup_tcode_absolute(struct angle_samples *as
+                                   , double last_chip_mcu_clock
+                                   , double last_chip_clock, double chip_freq)
+{
+    as->last_chip_mcu_clock = last_chip_mcu_clock;
+    as->last_chip_clock = last_chip_clock;
+    as->chip_freq = chip_freq;
+    as->inv_chip_freq = 1. / chip_freq;
+    as->is_tcode_absolute = 1;
+}
+
+int __visible
+angle_samples_get_errors(struct angle_samples *as)
+{
+    return as->error_count;
+}
+
+void __visible
+angle_samples_reset_errors(struct angle_samples *as)
+{
+    as->error_count = 0;
+}
+
+static double
+round6(double v)
+{
+    return nearbyint(v * 1000000.) / 1000000.;
+}
+
+// Decode one spi_angle_data payload into (time, angle) rows.  Returns
+// the number of rows written (error frames are dropped).
+int __visible
+angle_samples_decode(struct angle_samples *as, const uint8_t *data, int len
+                     , uint64_t sample_count, double *out)
+{
+    int num_samples = len / BYTES_PER_SAMPLE, count = 0, i;
+    int interp_bits = ANGLE_BITS - CALIBRATION_BITS;
+    int32_t interp_mask = (1 << interp_bits) - 1;
+    int32_t interp_round = 1 << (interp_bits - 1);
+    for (i = 0; i < num_samples; i++) {
+        const uint8_t *d = &data[i * BYTES_PER_SAMPLE];
+        int32_t tcode = d[0];
+        if (tcode == TCODE_ERROR) {
+            as->error_count++;
+            continue;
+        }
+        // Unwrap the raw 16bit angle
+        int32_t raw_angle = d[1] | (d[2] << 8);
+        int32_t angle_diff = (raw_angle - as->last_angle) & 0xffff;
+        angle_diff -= (angle_diff & 0x8000) << 1;
+        as->last_angle += angle_diff;
+        int64_t angle = as->last_angle;
+        // Apply calibration (linear interpolation between buckets)
+        if (as->have_calibration) {
+            int bucket = (angle & 0xffff) >> interp_bits;
+            int32_t cal1 = as->calibration[bucket];
+            int32_t cal2 = as->calibration[bucket + 1];
+            int32_t adj = (angle & interp_mask) * (cal2 - cal1);
+            adj = cal1 + ((adj + interp_round) >> interp_bits);
+            int32_t cdiff = (adj - angle) & 0xffff;
+            cdiff -= (cdiff & 0x8000) << 1;
+            angle += cdiff;
+            if (as->calibration_reversed)
+                angle = -angle;
+        }
+        // Samples in a burst share their event's nominal clock
+        uint64_t event = (sample_count + i) / as->burst_count;
+        double moff = event * (double)as->sample_ticks;
+        double soff;
+        if (as->is_tcode_absolute) {
+            // tcode is the tle5012b frame counter
+            double mclock = as->start_clock + moff;
+            double mdiff = mclock - as->last_chip_mcu_clock;
+            int64_t chip_mclock = as->last_chip_clock
+                + (int64_t)(mdiff * as->chip_freq + .5);
+            int32_t cdiff = ((tcode << 10) - chip_mclock) & 0xffff;
+            cdiff -= (cdiff & 0x8000) << 1;
+            soff = moff + (cdiff - 0x800) * as->inv_chip_freq;
+        } else {
+            // tcode is an mcu clock offset shifted by time_shift
+            soff = moff + (double)(tcode << as->time_shift);
+        }
+        double *row = &out[2 * count++];
+        row[0] = round6(as->time_base + soff*as->inv_freq - as->static_delay);
+        row[1] = angle;
+    }
+    return count;
+}
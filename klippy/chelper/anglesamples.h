@@ -0,0 +1,23 @@
+#ifndef ANGLESAMPLES_H
+#define ANGLESAMPLES_H
+
+#include <stdint.h> // uint8_t
+
+struct angle_samples *angle_samples_alloc(void);
+void angle_samples_set_calibration(struct angle_samples *as
+                                   , const int32_t *table, int count
+                                   , int reversed);
+void angle_samples_setup_batch(struct angle_samples *as, double start_clock
+                               , uint32_t sample_ticks, uint32_t burst_count
+                               , int time_shift, double time_base
+                               , double inv_freq, double static_delay);
+void angle_samples_setup_tcode_absolute(struct angle_samples *as
+                                        , double last_chip_mcu_clock
+                                        , double last_chip_clock
+                                        , double chip_freq);
+int angle_samples_get_errors(struct angle_samples *as);
+void angle_samples_reset_errors(struct angle_samples *as);
+int angle_samples_decode(struct angle_samples *as, const uint8_t *data
+                         , int len, uint64_t sample_count, double *out);
+
+#endif // anglesamples.h
@@ -0,0 +1,40 @@
+// G2/G3 arc expansion into linear segments
+//
+// Copyright (C) 2019-2026  Aleksej Vasiljkovic <achmed21@gmail.com>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // cos
+#include "compiler.h" // __visible
+#include "arcs.h" // arcs_expand
+
+// Generate the segment end coordinates approximating an arc.  Each
+// segment writes an x/y/z triple into 'coords'; the alpha/beta axes
+// trace the arc in the active plane and the helical axis travels
+// linearly.  The final segment lands exactly on the target position.
+void __visible
+arcs_expand(double *coords, int segments
+            , double offset_p, double offset_q
+            , double center_p, double center_q, double helical_start
+            , double theta_per_segment, double linear_per_segment
+            , int alpha_axis, int beta_axis, int helical_axis
+            , double target_alpha, double target_beta, double target_helical)
+{
+    int i;
+    for (i = 1; i <= segments; i++) {
+        double *c = &coords[(i - 1) * 3];
+        if (i == segments) {
+            c[alpha_axis] = target_alpha;
+            c[beta_axis] = target_beta;
+            c[helical_axis] = target_helical;
+            break;
+        }
+        double c_theta = i * theta_per_segment;
+        double cos_ti = cos(c_theta), sin_ti = sin(c_theta);
+        double r_p = -offset_p * cos_ti + offset_q * sin_ti;
+        double r_q = -offset_p * sin_ti - offset_q * cos_ti;
+        c[alpha_axis] = center_p + r_p;
+        c[beta_axis] = center_q + r_q;
+        c[helical_axis] = helical_start + i * linear_per_segment;
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef ARCS_H
+#define ARCS_H
+
+void arcs_expand(double *coords, int segments
+                 , double offset_p, double offset_q
+                 , double center_p, double center_q, double helical_start
+                 , double theta_per_segment, double linear_per_segment
+                 , int alpha_axis, int beta_axis, int helical_axis
+                 , double target_alpha, double target_beta
+                 , double target_helical);
+
+#endif // arcs.h
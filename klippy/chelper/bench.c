@@ -0,0 +1,351 @@
+// Standalone microbenchmark for the step generation code
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+// Build and run with: python3 klippy/chelper/__init__.py bench
+//
+// The harness replays a trapezoid move workload through the full
+// itersolve + stepcompress pipeline for several kinematics and reports
+// ns/step and steps/sec for each, along with standalone timings of
+// trapq_append and of the step compression queue.  By default two
+// synthetic workloads are used (a raster infill pattern and a short
+// segment arc stress).  A captured workload may be replayed instead by
+// passing a file name - one move per line with the thirteen
+// trapq_append() arguments as floats:
+//   print_time accel_t cruise_t decel_t start_x start_y start_z
+//   axes_r_x axes_r_y axes_r_z start_v cruise_v accel
+
+#include <inttypes.h> // PRIu64
+#include <math.h> // sqrt
+#include <stdio.h> // printf
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include <time.h> // clock_gettime
+#include "itersolve.h" // itersolve_generate_steps
+#include "list.h" // list_init
+#include "msgblock.h" // message_queue_free
+#include "stepcompress.h" // stepcompress_alloc
+#include "trapq.h" // trapq_append
+
+// Kinematics allocators (exported for cffi; not declared in a header)
+struct stepper_kinematics *cartesian_stepper_alloc(char axis);
+struct stepper_kinematics *corexy_stepper_alloc(char type);
+struct stepper_kinematics *delta_stepper_alloc(double arm2, double tower_x
+                                               , double tower_y);
+struct stepper_kinematics *input_shaper_alloc(void);
+int input_shaper_set_sk(struct stepper_kinematics *sk
+                        , struct stepper_kinematics *orig_sk);
+int input_shaper_set_shaper_params(struct stepper_kinematics *sk, char axis
+                                   , int n, double a[], double t[]);
+
+#define MCU_FREQ 180000000.
+#define STEP_DIST .0025
+#define MAX_MOVES 8192
+#define MAX_HIST (1<<20)
+
+struct bench_move {
+    double print_time, accel_t, cruise_t, decel_t;
+    double start_x, start_y, start_z;
+    double axes_r_x, axes_r_y, axes_r_z;
+    double start_v, cruise_v, accel;
+};
+
+static uint64_t
+monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+trapq_append_move(struct trapq *tq, struct bench_move *m)
+{
+    trapq_append(tq, m->print_time, m->accel_t, m->cruise_t, m->decel_t
+                 , m->start_x, m->start_y, m->start_z
+                 , m->axes_r_x, m->axes_r_y, m->axes_r_z
+                 , m->start_v, m->cruise_v, m->accel);
+}
+
+static double
+move_duration(struct bench_move *m)
+{
+    return m->accel_t + m->cruise_t + m->decel_t;
+}
+
+
+/****************************************************************
+ * Workload generation
+ ****************************************************************/
+
+// Append a full stop-to-stop trapezoid move between two points
+static int
+add_line(struct bench_move *moves, int num_moves, double *ptime
+         , double sx, double sy, double sz, double ex, double ey, double ez
+         , double speed, double accel)
+{
+    if (num_moves >= MAX_MOVES) {
+        fprintf(stderr, "bench: workload overflows move buffer\n");
+        exit(1);
+    }
+    struct bench_move *m = &moves[num_moves];
+    memset(m, 0, sizeof(*m));
+    double dx = ex - sx, dy = ey - sy, dz = ez - sz;
+    double dist = sqrt(dx*dx + dy*dy + dz*dz);
+    m->print_time = *ptime;
+    m->start_x = sx, m->start_y = sy, m->start_z = sz;
+    m->axes_r_x = dx / dist, m->axes_r_y = dy / dist, m->axes_r_z = dz / dist;
+    m->accel = accel;
+    double accel_dist = .5 * speed * speed / accel;
+    if (2. * accel_dist > dist)
+        // Distance too short to reach full speed
+        speed = sqrt(dist * accel);
+    m->cruise_v = speed;
+    m->accel_t = m->decel_t = speed / accel;
+    m->cruise_t = (dist - speed * speed / accel) / speed;
+    *ptime += move_duration(m);
+    return num_moves + 1;
+}
+
+// Raster infill style pattern - long alternating moves with small steps
+static int
+build_raster(struct bench_move *moves)
+{
+    double ptime = 1., y = -40.;
+    int num_moves = 0;
+    for (int i = 0; i < 100; i++) {
+        double sx = i & 1 ? 60. : -60., ex = -sx;
+        num_moves = add_line(moves, num_moves, &ptime
+                             , sx, y, 5., ex, y, 5., 150., 3000.);
+        num_moves = add_line(moves, num_moves, &ptime
+                             , ex, y, 5., ex, y + .8, 5., 30., 3000.);
+        y += .8;
+    }
+    return num_moves;
+}
+
+// Arc stress pattern - many short constant speed segments along a circle
+static int
+build_segments(struct bench_move *moves)
+{
+    double ptime = 1., speed = 60., radius = 50., seglen = .5;
+    int num_segs = 4000;
+    double seg_angle = seglen / radius;
+    int num_moves = 0;
+    for (int i = 0; i < num_segs; i++) {
+        if (num_moves >= MAX_MOVES) {
+            fprintf(stderr, "bench: workload overflows move buffer\n");
+            exit(1);
+        }
+        struct bench_move *m = &moves[num_moves++];
+        memset(m, 0, sizeof(*m));
+        double a1 = i * seg_angle, a2 = (i + 1) * seg_angle;
+        double sx = radius * cos(a1), sy = radius * sin(a1);
+        double dx = radius * cos(a2) - sx, dy = radius * sin(a2) - sy;
+        double dist = sqrt(dx*dx + dy*dy);
+        m->print_time = ptime;
+        m->start_x = sx, m->start_y = sy, m->start_z = 5.;
+        m->axes_r_x = dx / dist, m->axes_r_y = dy / dist;
+        m->start_v = m->cruise_v = speed;
+        m->cruise_t = dist / speed;
+        ptime += m->cruise_t;
+    }
+    return num_moves;
+}
+
+// Load a captured trapq workload from a text file
+static int
+load_capture(struct bench_move *moves, const char *fname)
+{
+    FILE *f = fopen(fname, "r");
+    if (!f) {
+        fprintf(stderr, "bench: unable to open '%s'\n", fname);
+        exit(1);
+    }
+    int num_moves = 0;
+    for (;;) {
+        if (num_moves >= MAX_MOVES) {
+            fprintf(stderr, "bench: workload overflows move buffer\n");
+            exit(1);
+        }
+        struct bench_move *m = &moves[num_moves];
+        int ret = fscanf(f, "%lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf"
+                         " %lf %lf"
+                         , &m->print_time, &m->accel_t, &m->cruise_t
+                         , &m->decel_t, &m->start_x, &m->start_y, &m->start_z
+                         , &m->axes_r_x, &m->axes_r_y, &m->axes_r_z
+                         , &m->start_v, &m->cruise_v, &m->accel);
+        if (ret != 13)
+            break;
+        num_moves++;
+    }
+    fclose(f);
+    if (!num_moves) {
+        fprintf(stderr, "bench: no moves parsed from '%s'\n", fname);
+        exit(1);
+    }
+    return num_moves;
+}
+
+
+/****************************************************************
+ * Benchmarks
+ ****************************************************************/
+
+// Replay a workload through itersolve_generate_steps and stepcompress
+static void
+bench_kinematics(const char *name, struct stepper_kinematics *sk
+                 , struct bench_move *moves, int num_moves)
+{
+    struct trapq *tq = trapq_alloc();
+    for (int i = 0; i < num_moves; i++)
+        trapq_append_move(tq, &moves[i]);
+    trapq_check_sentinels(tq);
+    struct list_head msg_queue;
+    list_init(&msg_queue);
+    struct stepcompress *sc = stepcompress_alloc(&msg_queue);
+    stepcompress_fill(sc, 1, (uint32_t)(.000025 * MCU_FREQ), 11, 12, 13, 0);
+    stepcompress_set_time(sc, 0., MCU_FREQ);
+    itersolve_set_trapq(sk, tq, STEP_DIST);
+    struct bench_move *m0 = &moves[0], *ml = &moves[num_moves-1];
+    itersolve_set_position(sk, m0->start_x, m0->start_y, m0->start_z);
+    double end_time = ml->print_time + move_duration(ml) + .5;
+    // Generate and compress steps in batches (as the host code does)
+    uint64_t start_ns = monotonic_ns();
+    for (double ft = m0->print_time; ; ft += .100) {
+        if (ft > end_time)
+            ft = end_time;
+        int32_t ret = itersolve_generate_steps(sk, sc, ft);
+        if (!ret)
+            ret = stepcompress_flush(sc, (uint64_t)(ft * MCU_FREQ));
+        if (ret) {
+            fprintf(stderr, "bench: %s step generation error %d\n", name, ret);
+            exit(1);
+        }
+        trapq_finalize_moves(tq, ft - .5, ft - .5);
+        if (ft >= end_time)
+            break;
+    }
+    uint64_t elapsed_ns = monotonic_ns() - start_ns;
+    // Tally the generated steps from the step compress history
+    struct pull_history_steps *hist = malloc(MAX_HIST * sizeof(*hist));
+    int num_msgs = stepcompress_extract_old(sc, hist, MAX_HIST
+                                            , 0, UINT64_MAX);
+    uint64_t steps = 0;
+    for (int i = 0; i < num_msgs; i++)
+        steps += labs((long)hist[i].step_count);
+    free(hist);
+    if (!steps) {
+        fprintf(stderr, "bench: %s generated no steps\n", name);
+        exit(1);
+    }
+    printf("  %-22s %8.1f ns/step %12.0f steps/sec"
+           "  (%" PRIu64 " steps, %d msgs)\n"
+           , name, (double)elapsed_ns / steps, steps * 1e9 / elapsed_ns
+           , steps, num_msgs);
+    stepcompress_free(sc);
+    message_queue_free(&msg_queue);
+    trapq_finalize_moves(tq, end_time + 1., end_time + 1.);
+    trapq_free(tq);
+}
+
+// Measure the cost of queuing moves on a trapq
+static void
+bench_trapq_append(struct bench_move *moves, int num_moves)
+{
+    int rounds = 250;
+    struct trapq *tq = trapq_alloc();
+    uint64_t start_ns = monotonic_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < num_moves; i++)
+            trapq_append_move(tq, &moves[i]);
+        trapq_finalize_moves(tq, 1e30, 1e30);
+    }
+    uint64_t elapsed_ns = monotonic_ns() - start_ns;
+    uint64_t total = (uint64_t)rounds * num_moves;
+    printf("  %-22s %8.1f ns/move %12.0f moves/sec\n"
+           , "trapq_append", (double)elapsed_ns / total
+           , total * 1e9 / elapsed_ns);
+    trapq_free(tq);
+}
+
+// Measure step compression in isolation on a synthetic velocity ramp
+static void
+bench_stepcompress(void)
+{
+    int num_steps = 2000000;
+    struct list_head msg_queue;
+    list_init(&msg_queue);
+    struct stepcompress *sc = stepcompress_alloc(&msg_queue);
+    stepcompress_fill(sc, 1, (uint32_t)(.000025 * MCU_FREQ), 11, 12, 13, 0);
+    stepcompress_set_time(sc, 0., MCU_FREQ);
+    double step_time = 1., velocity = 500.;
+    uint64_t start_ns = monotonic_ns();
+    for (int i = 0; i < num_steps; i++) {
+        // Accelerate at 0.5M steps/sec^2 up to 200K steps/sec
+        velocity = sqrt(velocity * velocity + 1000000.);
+        if (velocity > 200000.)
+            velocity = 200000.;
+        step_time += 1. / velocity;
+        int ret = stepcompress_append(sc, 1, 0., step_time);
+        if (!ret && !(i % 16384))
+            ret = stepcompress_flush(sc, (uint64_t)(step_time * MCU_FREQ));
+        if (ret) {
+            fprintf(stderr, "bench: step compress error %d\n", ret);
+            exit(1);
+        }
+    }
+    stepcompress_flush(sc, (uint64_t)((step_time + 1.) * MCU_FREQ));
+    uint64_t elapsed_ns = monotonic_ns() - start_ns;
+    printf("  %-22s %8.1f ns/step %12.0f steps/sec\n"
+           , "stepcompress", (double)elapsed_ns / num_steps
+           , num_steps * 1e9 / elapsed_ns);
+    stepcompress_free(sc);
+    message_queue_free(&msg_queue);
+}
+
+static void
+bench_workload(const char *name, struct bench_move *moves, int num_moves)
+{
+    printf("%s (%d moves):\n", name, num_moves);
+    bench_trapq_append(moves, num_moves);
+    double shaper_a[] = { .15, .7, .15 }, shaper_t[] = { 0., .0125, .025 };
+    struct stepper_kinematics *sk;
+    // Basic kinematics
+    bench_kinematics("cartesian x", cartesian_stepper_alloc('x')
+                     , moves, num_moves);
+    bench_kinematics("corexy a", corexy_stepper_alloc('+'), moves, num_moves);
+    bench_kinematics("delta a"
+                     , delta_stepper_alloc(122500., -129.9, -75.)
+                     , moves, num_moves);
+    // Input shaper wrappers (linear and generic solver paths)
+    sk = input_shaper_alloc();
+    input_shaper_set_sk(sk, cartesian_stepper_alloc('x'));
+    input_shaper_set_shaper_params(sk, 'x', 3, shaper_a, shaper_t);
+    bench_kinematics("cartesian x + shaper", sk, moves, num_moves);
+    sk = input_shaper_alloc();
+    input_shaper_set_sk(sk, delta_stepper_alloc(122500., -129.9, -75.));
+    input_shaper_set_shaper_params(sk, 'x', 3, shaper_a, shaper_t);
+    input_shaper_set_shaper_params(sk, 'y', 3, shaper_a, shaper_t);
+    bench_kinematics("delta a + shaper", sk, moves, num_moves);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct bench_move *moves = malloc(MAX_MOVES * sizeof(*moves));
+    if (argc > 1) {
+        int num_moves = load_capture(moves, argv[1]);
+        bench_workload(argv[1], moves, num_moves);
+    } else {
+        int num_moves = build_raster(moves);
+        bench_workload("raster infill", moves, num_moves);
+        num_moves = build_segments(moves);
+        bench_workload("arc segments", moves, num_moves);
+    }
+    bench_stepcompress();
+    free(moves);
+    return 0;
+}
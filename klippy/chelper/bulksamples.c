@@ -0,0 +1,59 @@
+// Decoding of generic fixed frequency bulk sensor samples
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // nearbyint
+#include <stdint.h> // uint8_t
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "bulksamples.h" // bulk_samples_alloc
+
+struct bulk_samples {
+    int format;
+};
+
+// Allocate a decoder for one of the BULK_FMT_xxx sample encodings
+struct bulk_samples * __visible
+bulk_samples_alloc(int format)
+{
+    struct bulk_samples *bs = malloc(sizeof(*bs));
+    memset(bs, 0, sizeof(*bs));
+    bs->format = format;
+    return bs;
+}
+
+static double
+round6(double v)
+{
+    return nearbyint(v * 1000000.) / 1000000.;
+}
+
+// Decode one sensor_bulk_data payload into (time, value) rows.
+// Returns the number of rows written.
+int __visible
+bulk_samples_decode(struct bulk_samples *bs, const uint8_t *data, int len
+                    , double time_base, double inv_freq, double chip_start
+                    , double *out)
+{
+    int num_samples = len / 4, i;
+    for (i = 0; i < num_samples; i++) {
+        const uint8_t *d = &data[i * 4];
+        uint32_t raw;
+        if (bs->format == BULK_FMT_INT32_BE || bs->format == BULK_FMT_UINT32_BE)
+            raw = ((uint32_t)d[0] << 24) | ((uint32_t)d[1] << 16)
+                | ((uint32_t)d[2] << 8) | d[3];
+        else
+            raw = ((uint32_t)d[3] << 24) | ((uint32_t)d[2] << 16)
+                | ((uint32_t)d[1] << 8) | d[0];
+        double *row = &out[2 * i];
+        row[0] = round6(time_base + (chip_start + i) * inv_freq);
+        if (bs->format == BULK_FMT_INT32_LE || bs->format == BULK_FMT_INT32_BE)
+            row[1] = (int32_t)raw;
+        else
+            row[1] = raw;
+    }
+    return num_samples;
+}
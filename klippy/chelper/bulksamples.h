@@ -0,0 +1,16 @@
+#ifndef BULKSAMPLES_H
+#define BULKSAMPLES_H
+
+#include <stdint.h> // uint8_t
+
+enum {
+    BULK_FMT_INT32_LE = 0, BULK_FMT_INT32_BE = 1,
+    BULK_FMT_UINT32_LE = 2, BULK_FMT_UINT32_BE = 3,
+};
+
+struct bulk_samples *bulk_samples_alloc(int format);
+int bulk_samples_decode(struct bulk_samples *bs, const uint8_t *data
+                        , int len, double time_base, double inv_freq
+                        , double chip_start, double *out);
+
+#endif // bulksamples.h
@@ -0,0 +1,107 @@
+// Micro-controller clock synchronization filter
+//
+// Copyright (C) 2016-2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // sqrt
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "clocksync.h" // struct clockfilter
+#include "serialqueue.h" // serialqueue_set_clock_est
+
+#define RTT_AGE (.000010 / (60. * 60.))
+#define DECAY (1. / 30.)
+#define TRANSMIT_EXTRA .001
+
+struct clockfilter * __visible
+clockfilter_alloc(void)
+{
+    struct clockfilter *cf = malloc(sizeof(*cf));
+    if (!cf)
+        return NULL;
+    memset(cf, 0, sizeof(*cf));
+    cf->min_half_rtt = 999999999.9;
+    return cf;
+}
+
+// Load the initial clock and frequency estimate
+void __visible
+clockfilter_init(struct clockfilter *cf, double mcu_freq
+                 , uint64_t clock, double sent_time)
+{
+    memset(cf, 0, sizeof(*cf));
+    cf->mcu_freq = mcu_freq;
+    cf->last_clock = clock;
+    cf->clock_avg = clock;
+    cf->time_avg = sent_time;
+    cf->est_sample_time = sent_time;
+    cf->est_clock = cf->clock_avg;
+    cf->est_freq = mcu_freq;
+    cf->prediction_variance = (.001 * mcu_freq) * (.001 * mcu_freq);
+    cf->min_half_rtt = 999999999.9;
+}
+
+// Process a clock sample - run the convergence filter and update the
+// serialqueue clock estimate.  Returns CF_xxx flags for host logging.
+int __visible
+clockfilter_update(struct clockfilter *cf, struct serialqueue *sq
+                   , uint32_t clock32, double sent_time, double receive_time)
+{
+    // Extend clock to 64bit
+    uint64_t last_clock = cf->last_clock;
+    uint64_t clock = last_clock + (uint64_t)(clock32 - (uint32_t)last_clock);
+    cf->last_clock = clock;
+    if (!sent_time)
+        return CF_NO_SENT_TIME;
+    int ret = 0;
+    // Check if this is the best round-trip-time seen so far
+    double half_rtt = .5 * (receive_time - sent_time);
+    double aged_rtt = (sent_time - cf->min_rtt_time) * RTT_AGE;
+    if (half_rtt < cf->min_half_rtt + aged_rtt) {
+        cf->min_half_rtt = half_rtt;
+        cf->min_rtt_time = sent_time;
+        ret |= CF_NEW_MIN_RTT;
+    }
+    // Filter out samples that are extreme outliers
+    double exp_clock = ((sent_time - cf->time_avg) * cf->est_freq
+                        + cf->clock_avg);
+    double clock_diff = (double)clock - exp_clock;
+    double clock_diff2 = clock_diff * clock_diff;
+    cf->last_clock_diff = clock_diff;
+    if (clock_diff2 > 25. * cf->prediction_variance
+        && clock_diff2 > ((.000500 * cf->mcu_freq)
+                          * (.000500 * cf->mcu_freq))) {
+        if (clock_diff > 0.
+            && sent_time < cf->last_prediction_time + 10.)
+            return ret | CF_SAMPLE_IGNORED;
+        cf->prediction_variance = (.001 * cf->mcu_freq) * (.001 * cf->mcu_freq);
+        ret |= CF_VARIANCE_RESET;
+    } else {
+        cf->last_prediction_time = sent_time;
+        cf->prediction_variance = (1. - DECAY) * (cf->prediction_variance
+                                                  + clock_diff2 * DECAY);
+    }
+    // Add clock and sent_time to linear regression
+    double diff_sent_time = sent_time - cf->time_avg;
+    cf->time_avg += DECAY * diff_sent_time;
+    cf->time_variance = (1. - DECAY) * (cf->time_variance
+                                        + diff_sent_time * diff_sent_time
+                                        * DECAY);
+    double diff_clock = (double)clock - cf->clock_avg;
+    cf->clock_avg += DECAY * diff_clock;
+    cf->clock_covariance = (1. - DECAY) * (cf->clock_covariance
+                                           + diff_sent_time * diff_clock
+                                           * DECAY);
+    // Update prediction from linear regression
+    double new_freq = cf->clock_covariance / cf->time_variance;
+    double pred_stddev = sqrt(cf->prediction_variance);
+    serialqueue_set_clock_est(sq, new_freq, cf->time_avg + TRANSMIT_EXTRA
+                              , (uint64_t)(cf->clock_avg - 3. * pred_stddev)
+                              , clock);
+    cf->est_sample_time = cf->time_avg + cf->min_half_rtt;
+    cf->est_clock = cf->clock_avg;
+    cf->est_freq = new_freq;
+    return ret;
+}
@@ -0,0 +1,30 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <stdint.h> // uint64_t
+
+struct clockfilter {
+    double mcu_freq;
+    uint64_t last_clock;
+    double min_half_rtt, min_rtt_time;
+    double time_avg, time_variance;
+    double clock_avg, clock_covariance;
+    double prediction_variance, last_prediction_time;
+    double est_sample_time, est_clock, est_freq;
+    double last_clock_diff;
+};
+
+enum {
+    CF_NO_SENT_TIME = 1<<0, CF_NEW_MIN_RTT = 1<<1,
+    CF_SAMPLE_IGNORED = 1<<2, CF_VARIANCE_RESET = 1<<3,
+};
+
+struct serialqueue;
+struct clockfilter *clockfilter_alloc(void);
+void clockfilter_init(struct clockfilter *cf, double mcu_freq
+                      , uint64_t clock, double sent_time);
+int clockfilter_update(struct clockfilter *cf, struct serialqueue *sq
+                       , uint32_t clock32, double sent_time
+                       , double receive_time);
+
+#endif // clocksync.h
@@ -0,0 +1,127 @@
+// Coordinate descent solver and trilateration for calibration math
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // sqrt
+#include <stdlib.h> // malloc
+#include <string.h> // memcpy
+#include "compiler.h" // __visible
+#include "coorddesc.h" // coorddesc_solve
+
+// Run coordinate descent on an externally supplied objective function.
+// The solver adjusts 'params' in place; the objective is invoked with a
+// batch of candidate parameter vectors (count rows of num_params values)
+// so the caller can amortize its per-evaluation overhead.  Both trial
+// adjustments of a parameter are requested in one batch - the second
+// result is simply ignored when the first shows an improvement, which
+// matches the classic sequential accept/reject order.
+double __visible
+coorddesc_solve(int num_params, double *params, double threshold
+                , int max_rounds, int *rounds_out, coorddesc_eval_fn eval)
+{
+    double *dp = malloc((3 * num_params + 2) * sizeof(double));
+    double *cand = &dp[num_params], *errs = &cand[2 * num_params];
+    int i;
+    for (i = 0; i < num_params; i++)
+        dp[i] = 1.;
+    double best_err;
+    eval(&best_err, params, 1, num_params);
+    int rounds = 0;
+    for (;;) {
+        double dp_sum = 0.;
+        for (i = 0; i < num_params; i++)
+            dp_sum += dp[i];
+        if (dp_sum <= threshold || rounds >= max_rounds)
+            break;
+        rounds++;
+        for (i = 0; i < num_params; i++) {
+            double orig = params[i];
+            memcpy(cand, params, num_params * sizeof(double));
+            memcpy(&cand[num_params], params, num_params * sizeof(double));
+            cand[i] = orig + dp[i];
+            cand[num_params + i] = orig - dp[i];
+            eval(errs, cand, 2, num_params);
+            if (errs[0] < best_err) {
+                // There was some improvement
+                best_err = errs[0];
+                params[i] = orig + dp[i];
+                dp[i] *= 1.1;
+            } else if (errs[1] < best_err) {
+                // There was some improvement
+                best_err = errs[1];
+                params[i] = orig - dp[i];
+                dp[i] *= 1.1;
+            } else {
+                dp[i] *= 0.9;
+            }
+        }
+    }
+    if (rounds_out)
+        *rounds_out = rounds;
+    free(dp);
+    return best_err;
+}
+
+static inline void
+vsub(double *d, const double *a, const double *b)
+{
+    d[0] = a[0] - b[0];
+    d[1] = a[1] - b[1];
+    d[2] = a[2] - b[2];
+}
+
+static inline double
+vdot(const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// Trilateration finds the intersection of three spheres.  See the
+// wikipedia article for the details of the algorithm.  'sphere_coords'
+// is the three sphere centers (9 doubles), 'radius2' the three squared
+// radii, and the intersection point is stored in 'out' (3 doubles).
+void __visible
+coorddesc_trilateration(const double *sphere_coords, const double *radius2
+                        , double *out)
+{
+    const double *sc1 = &sphere_coords[0];
+    const double *sc2 = &sphere_coords[3];
+    const double *sc3 = &sphere_coords[6];
+    double s21[3], s31[3];
+    vsub(s21, sc2, sc1);
+    vsub(s31, sc3, sc1);
+
+    double d = sqrt(vdot(s21, s21));
+    double inv_d = 1. / d;
+    double ex[3] = { s21[0]*inv_d, s21[1]*inv_d, s21[2]*inv_d };
+    double i = vdot(ex, s31);
+    double vect_ey[3] = { s31[0] - ex[0]*i, s31[1] - ex[1]*i
+                          , s31[2] - ex[2]*i };
+    double inv_ey = 1. / sqrt(vdot(vect_ey, vect_ey));
+    double ey[3] = { vect_ey[0]*inv_ey, vect_ey[1]*inv_ey, vect_ey[2]*inv_ey };
+    double ez[3] = { ex[1]*ey[2] - ex[2]*ey[1], ex[2]*ey[0] - ex[0]*ey[2]
+                     , ex[0]*ey[1] - ex[1]*ey[0] };
+    double j = vdot(ey, s31);
+
+    double x = (radius2[0] - radius2[1] + d*d) / (2. * d);
+    double xi = x - i;
+    double y = (radius2[0] - radius2[2] - x*x + xi*xi + j*j) / (2. * j);
+    double z = -sqrt(radius2[0] - x*x - y*y);
+
+    out[0] = sc1[0] + ex[0]*x + ey[0]*y + ez[0]*z;
+    out[1] = sc1[1] + ex[1]*x + ey[1]*y + ez[1]*z;
+    out[2] = sc1[2] + ex[2]*x + ey[2]*y + ez[2]*z;
+}
+
+// Solve 'count' independent trilateration problems in one call
+void __visible
+coorddesc_trilateration_batch(const double *sphere_coords
+                              , const double *radius2, double *out, int count)
+{
+    int i;
+    for (i = 0; i < count; i++)
+        coorddesc_trilateration(&sphere_coords[9*i], &radius2[3*i]
+                                , &out[3*i]);
+}
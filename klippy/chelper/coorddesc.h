@@ -0,0 +1,16 @@
+#ifndef COORDDESC_H
+#define COORDDESC_H
+
+typedef void (*coorddesc_eval_fn)(double *errors, const double *params
+                                  , int count, int num_params);
+
+double coorddesc_solve(int num_params, double *params, double threshold
+                       , int max_rounds, int *rounds_out
+                       , coorddesc_eval_fn eval);
+void coorddesc_trilateration(const double *sphere_coords
+                             , const double *radius2, double *out);
+void coorddesc_trilateration_batch(const double *sphere_coords
+                                   , const double *radius2, double *out
+                                   , int count);
+
+#endif // coorddesc.h
@@ -0,0 +1,40 @@
+// Dirty region extraction for graphics display framebuffers
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <string.h> // memmove
+#include "compiler.h" // __visible
+#include "displayfb.h" // displayfb_find_dirty
+
+// Find the byte ranges that differ between two copies of a display
+// framebuffer.  Nearby changes are merged so that each resulting range
+// can be sent to the display in a single command.  Each range is
+// stored in 'runs' as a (position, count) pair; the caller must supply
+// space for len*2 integers.  Returns the number of ranges found.
+int __visible
+displayfb_find_dirty(uint8_t *new_data, uint8_t *old_data, int len
+                     , int max_gap, int max_batch, int *runs)
+{
+    // Find the position of all changed bytes
+    int num_runs = 0, i;
+    for (i = 0; i < len; i++)
+        if (new_data[i] != old_data[i]) {
+            runs[num_runs*2] = i;
+            runs[num_runs*2 + 1] = 1;
+            num_runs++;
+        }
+    // Batch together changes that are close to each other
+    for (i = num_runs - 2; i >= 0; i--) {
+        int pos = runs[i*2], nextpos = runs[(i+1)*2];
+        int nextcount = runs[(i+1)*2 + 1];
+        if (pos + max_gap >= nextpos && nextcount < max_batch) {
+            runs[i*2 + 1] = nextcount + (nextpos - pos);
+            memmove(&runs[(i+1)*2], &runs[(i+2)*2]
+                    , (num_runs - (i+2)) * 2 * sizeof(*runs));
+            num_runs--;
+        }
+    }
+    return num_runs;
+}
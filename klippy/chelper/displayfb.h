@@ -0,0 +1,9 @@
+#ifndef DISPLAYFB_H
+#define DISPLAYFB_H
+
+#include <stdint.h> // uint8_t
+
+int displayfb_find_dirty(uint8_t *new_data, uint8_t *old_data, int len
+                         , int max_gap, int max_batch, int *runs);
+
+#endif // displayfb.h
@@ -0,0 +1,239 @@
+// G-Code command line tokenizing
+//
+// Copyright (C) 2016-2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <ctype.h> // isspace
+#include <stdlib.h> // strtod
+#include <string.h> // memcpy
+#include "compiler.h" // __visible
+#include "gcodeparse.h" // struct gc_param
+
+// Interning table mapping command names to the integer ids assigned
+// at registration time
+struct gc_cmd {
+    int id, len;
+    char name[GC_CMD_MAX + 1];
+};
+
+struct gc_lookup {
+    int count, alloc;
+    struct gc_cmd *cmds;
+};
+
+struct gc_lookup * __visible
+gc_lookup_alloc(void)
+{
+    struct gc_lookup *gl = malloc(sizeof(*gl));
+    memset(gl, 0, sizeof(*gl));
+    return gl;
+}
+
+void __visible
+gc_lookup_free(struct gc_lookup *gl)
+{
+    free(gl->cmds);
+    free(gl);
+}
+
+void __visible
+gc_lookup_clear(struct gc_lookup *gl)
+{
+    gl->count = 0;
+}
+
+static int
+gc_cmd_compare(const struct gc_cmd *c, const char *name, int len)
+{
+    if (c->len != len)
+        return c->len - len;
+    return memcmp(c->name, name, len);
+}
+
+// Binary search for a command name.  Returns the matching (or
+// insertion) position and reports whether a match was found.
+static int
+gc_lookup_pos(struct gc_lookup *gl, const char *name, int len, int *found)
+{
+    int lo = 0, hi = gl->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = gc_cmd_compare(&gl->cmds[mid], name, len);
+        if (!cmp) {
+            *found = 1;
+            return mid;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *found = 0;
+    return lo;
+}
+
+// Add a command name to the table.  Returns -1 if the name can not be
+// interned (too long, or already present).
+int __visible
+gc_lookup_add(struct gc_lookup *gl, const char *name, int len, int id)
+{
+    if (len <= 0 || len > GC_CMD_MAX)
+        return -1;
+    int found, pos = gc_lookup_pos(gl, name, len, &found);
+    if (found)
+        return -1;
+    if (gl->count >= gl->alloc) {
+        int alloc = gl->alloc ? 2 * gl->alloc : 64;
+        struct gc_cmd *cmds = realloc(gl->cmds, alloc * sizeof(*cmds));
+        if (!cmds)
+            return -1;
+        gl->cmds = cmds;
+        gl->alloc = alloc;
+    }
+    memmove(&gl->cmds[pos + 1], &gl->cmds[pos]
+            , (gl->count - pos) * sizeof(struct gc_cmd));
+    struct gc_cmd *c = &gl->cmds[pos];
+    c->id = id;
+    c->len = len;
+    memcpy(c->name, name, len);
+    c->name[len] = '\0';
+    gl->count++;
+    return 0;
+}
+
+// Map the command name reported by gcodeparse_line() to its interned
+// id (or -1 if the command was not interned)
+int __visible
+gcodeparse_lookup(struct gc_lookup *gl, const char *data, int *cmd_bounds)
+{
+    int len = cmd_bounds[1] - cmd_bounds[0];
+    if (len <= 0 || len > GC_CMD_MAX)
+        return -1;
+    int found, pos = gc_lookup_pos(gl, &data[cmd_bounds[0]], len, &found);
+    if (!found)
+        return -1;
+    return gl->cmds[pos].id;
+}
+
+// Check for the argument name characters recognized by gcode.py
+static int
+is_key_char(char c)
+{
+    return (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// Attempt to parse a parameter value as a float.  Only plain decimal
+// notation is accepted - anything else is left for the host to parse.
+static void
+parse_float(const char *data, int pos, int len, struct gc_param *p)
+{
+    p->fvalid = 0;
+    if (!len || len >= 32)
+        return;
+    const char *s = &data[pos], *end = &data[pos + len];
+    const char *c = s;
+    if (*c == '+' || *c == '-')
+        c++;
+    int digits = 0;
+    while (c < end && *c >= '0' && *c <= '9')
+        c++, digits++;
+    if (c < end && *c == '.') {
+        c++;
+        while (c < end && *c >= '0' && *c <= '9')
+            c++, digits++;
+    }
+    if (!digits)
+        return;
+    if (c < end && *c == 'E') {
+        c++;
+        if (c < end && (*c == '+' || *c == '-'))
+            c++;
+        if (c >= end)
+            return;
+        while (c < end && *c >= '0' && *c <= '9')
+            c++;
+    }
+    if (c != end)
+        return;
+    char buf[32];
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    p->fvalue = strtod(buf, NULL);
+    p->fvalid = 1;
+}
+
+// Split an upper-cased gcode line into its command name and parameters.
+// Parameter names are runs of 'A'-'Z' and '_' characters (or a single
+// '*'); each parameter value is the whitespace-stripped text up to the
+// next parameter name.  Returns the number of parameters found (or -1
+// if there are more than 'max_params').  The command name is reported
+// as start/end offsets in 'cmd_bounds'.
+int __visible
+gcodeparse_line(const char *data, int len, struct gc_param *params
+                , int max_params, int *cmd_bounds)
+{
+    int count = 0, pos = 0;
+    while (pos < len) {
+        char c = data[pos];
+        if (!is_key_char(c) && c != '*') {
+            pos++;
+            continue;
+        }
+        // Found a parameter name
+        if (count >= max_params)
+            return -1;
+        struct gc_param *p = &params[count++];
+        p->key_pos = pos;
+        if (c == '*') {
+            pos++;
+        } else {
+            while (pos < len && is_key_char(data[pos]))
+                pos++;
+        }
+        p->key_len = pos - p->key_pos;
+        // Find the raw value (text up to the next parameter name)
+        int vstart = pos;
+        while (pos < len && !is_key_char(data[pos]) && data[pos] != '*')
+            pos++;
+        int vend = pos;
+        // Strip leading and trailing whitespace from the value
+        while (vstart < vend && isspace((unsigned char)data[vstart]))
+            vstart++;
+        while (vend > vstart && isspace((unsigned char)data[vend-1]))
+            vend--;
+        p->value_pos = vstart;
+        p->value_len = vend - vstart;
+        parse_float(data, vstart, vend - vstart, p);
+    }
+    // Determine the command name
+    int cmd_start = 0, cmd_end = 0;
+    if (count && params[0].key_pos == 0 && params[0].key_len == 1
+        && data[0] == 'N') {
+        // Skip line number at start of command
+        if (count >= 2) {
+            struct gc_param *p = &params[1];
+            cmd_start = p->key_pos;
+            cmd_end = (p->value_len ? p->value_pos + p->value_len
+                       : p->key_pos + p->key_len);
+        }
+    } else if (count) {
+        struct gc_param *p = &params[0];
+        cmd_end = (p->value_len ? p->value_pos + p->value_len
+                   : p->key_pos + p->key_len);
+        while (cmd_start < cmd_end
+               && isspace((unsigned char)data[cmd_start]))
+            cmd_start++;
+    } else {
+        // No parameter names - command is the stripped line
+        cmd_end = len;
+        while (cmd_end > 0 && isspace((unsigned char)data[cmd_end-1]))
+            cmd_end--;
+        while (cmd_start < cmd_end
+               && isspace((unsigned char)data[cmd_start]))
+            cmd_start++;
+    }
+    cmd_bounds[0] = cmd_start;
+    cmd_bounds[1] = cmd_end;
+    return count;
+}
@@ -0,0 +1,23 @@
+#ifndef GCODEPARSE_H
+#define GCODEPARSE_H
+
+struct gc_param {
+    int key_pos, key_len, value_pos, value_len;
+    double fvalue;
+    int fvalid;
+};
+
+// Maximum length of an internable command name
+#define GC_CMD_MAX 31
+
+struct gc_lookup;
+struct gc_lookup *gc_lookup_alloc(void);
+void gc_lookup_free(struct gc_lookup *gl);
+void gc_lookup_clear(struct gc_lookup *gl);
+int gc_lookup_add(struct gc_lookup *gl, const char *name, int len, int id);
+int gcodeparse_line(const char *data, int len, struct gc_param *params
+                    , int max_params, int *cmd_bounds);
+int gcodeparse_lookup(struct gc_lookup *gl, const char *data
+                      , int *cmd_bounds);
+
+#endif // gcodeparse.h
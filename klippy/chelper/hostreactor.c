@@ -0,0 +1,346 @@
+// Timer and file descriptor event core for the main klippy reactor
+//
+// Copyright (C) 2016-2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <errno.h> // EINTR
+#include <math.h> // ceil
+#include <stdint.h> // uint32_t
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "hostreactor.h" // hostreactor_alloc
+#include "pyhelper.h" // report_errno
+
+// Use epoll where available (the reactor.py poll based code is the
+// fallback on other systems)
+#if defined(__has_include) && __has_include(<sys/epoll.h>)
+#define HAVE_EPOLL 1
+#include <sys/epoll.h> // epoll_create1
+#include <unistd.h> // close
+#endif
+
+#define HR_NEVER 9999999999999999.
+#define HR_MAX_EVENTS 64
+
+// A registered timer slot.  Timers are kept in a binary min-heap keyed
+// by deadline (waketime plus the declared jitter tolerance); heap_pos
+// is -1 while a timer is not scheduled (popped by
+// hostreactor_check_timers or freed).
+struct hr_timer {
+    double waketime, jitter, deadline;
+    int heap_pos;
+};
+
+struct hostreactor {
+    int epfd;
+    // Timer heap
+    struct hr_timer *timers;
+    int *heap, *free_slots;
+    int num_alloc, heap_size, num_free;
+#if HAVE_EPOLL
+    struct epoll_event events[HR_MAX_EVENTS];
+#endif
+};
+
+// Allocate a new 'struct hostreactor' object
+struct hostreactor * __visible
+hostreactor_alloc(void)
+{
+#if HAVE_EPOLL
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+        return NULL;
+    struct hostreactor *hr = malloc(sizeof(*hr));
+    if (!hr) {
+        close(epfd);
+        return NULL;
+    }
+    memset(hr, 0, sizeof(*hr));
+    hr->epfd = epfd;
+    return hr;
+#else
+    return NULL;
+#endif
+}
+
+// Free resources associated with a 'struct hostreactor' object
+void __visible
+hostreactor_free(struct hostreactor *hr)
+{
+#if HAVE_EPOLL
+    close(hr->epfd);
+#endif
+    free(hr->timers);
+    free(hr->heap);
+    free(hr->free_slots);
+    free(hr);
+}
+
+
+/****************************************************************
+ * File descriptor waiting
+ ****************************************************************/
+
+#if HAVE_EPOLL
+
+// Translate HR_READ/HR_WRITE flags to epoll events
+static uint32_t
+hr_epoll_events(int flags)
+{
+    return (EPOLLHUP | (flags & HR_READ ? EPOLLIN : 0)
+            | (flags & HR_WRITE ? EPOLLOUT : 0));
+}
+
+// Start watching a file descriptor for readability
+int __visible
+hostreactor_register_fd(struct hostreactor *hr, int fd)
+{
+    struct epoll_event ev = { .events = hr_epoll_events(HR_READ)
+                              , .data = { .fd = fd } };
+    int ret = epoll_ctl(hr->epfd, EPOLL_CTL_ADD, fd, &ev);
+    if (ret < 0)
+        report_errno("epoll_ctl add", ret);
+    return ret;
+}
+
+// Stop watching a file descriptor
+void __visible
+hostreactor_unregister_fd(struct hostreactor *hr, int fd)
+{
+    epoll_ctl(hr->epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+// Update the readable/writeable events to wait for on a descriptor
+void __visible
+hostreactor_set_fd_wake(struct hostreactor *hr, int fd, int flags)
+{
+    struct epoll_event ev = { .events = hr_epoll_events(flags)
+                              , .data = { .fd = fd } };
+    int ret = epoll_ctl(hr->epfd, EPOLL_CTL_MOD, fd, &ev);
+    if (ret < 0)
+        report_errno("epoll_ctl mod", ret);
+}
+
+// Wait up to 'timeout' seconds for file descriptor activity.  Returns
+// the number of ready descriptors reported in 'events'.
+int __visible
+hostreactor_wait(struct hostreactor *hr, double timeout
+                 , struct hr_fd_event *events, int max)
+{
+    int ms = timeout <= 0. ? 0 : (int)ceil(timeout * 1000.);
+    if (max > HR_MAX_EVENTS)
+        max = HR_MAX_EVENTS;
+    int ret = epoll_wait(hr->epfd, hr->events, max, ms);
+    if (ret < 0) {
+        if (errno == EINTR)
+            return 0;
+        report_errno("epoll_wait", ret);
+        return -1;
+    }
+    int i;
+    for (i = 0; i < ret; i++) {
+        uint32_t ev = hr->events[i].events;
+        events[i].fd = hr->events[i].data.fd;
+        events[i].flags = ((ev & (EPOLLIN|EPOLLHUP|EPOLLERR) ? HR_READ : 0)
+                           | (ev & EPOLLOUT ? HR_WRITE : 0));
+    }
+    return ret;
+}
+
+#else
+
+int __visible
+hostreactor_register_fd(struct hostreactor *hr, int fd)
+{
+    return -1;
+}
+
+void __visible
+hostreactor_unregister_fd(struct hostreactor *hr, int fd)
+{
+}
+
+void __visible
+hostreactor_set_fd_wake(struct hostreactor *hr, int fd, int flags)
+{
+}
+
+int __visible
+hostreactor_wait(struct hostreactor *hr, double timeout
+                 , struct hr_fd_event *events, int max)
+{
+    return -1;
+}
+
+#endif // HAVE_EPOLL
+
+
+/****************************************************************
+ * Timer heap
+ ****************************************************************/
+
+// Move a heap entry towards the heap root
+static void
+hr_sift_up(struct hostreactor *hr, int pos)
+{
+    int slot = hr->heap[pos];
+    double deadline = hr->timers[slot].deadline;
+    while (pos) {
+        int parent_pos = (pos - 1) / 2;
+        int parent = hr->heap[parent_pos];
+        if (hr->timers[parent].deadline <= deadline)
+            break;
+        hr->heap[pos] = parent;
+        hr->timers[parent].heap_pos = pos;
+        pos = parent_pos;
+    }
+    hr->heap[pos] = slot;
+    hr->timers[slot].heap_pos = pos;
+}
+
+// Move a heap entry towards the heap leaves
+static void
+hr_sift_down(struct hostreactor *hr, int pos)
+{
+    int slot = hr->heap[pos];
+    double deadline = hr->timers[slot].deadline;
+    for (;;) {
+        int child_pos = 2*pos + 1;
+        if (child_pos >= hr->heap_size)
+            break;
+        if (child_pos + 1 < hr->heap_size
+            && (hr->timers[hr->heap[child_pos+1]].deadline
+                < hr->timers[hr->heap[child_pos]].deadline))
+            child_pos++;
+        int child = hr->heap[child_pos];
+        if (deadline <= hr->timers[child].deadline)
+            break;
+        hr->heap[pos] = child;
+        hr->timers[child].heap_pos = pos;
+        pos = child_pos;
+    }
+    hr->heap[pos] = slot;
+    hr->timers[slot].heap_pos = pos;
+}
+
+// Remove a timer from the heap
+static void
+hr_heap_remove(struct hostreactor *hr, int slot)
+{
+    int pos = hr->timers[slot].heap_pos;
+    hr->timers[slot].heap_pos = -1;
+    int last = hr->heap[--hr->heap_size];
+    if (last == slot)
+        return;
+    hr->heap[pos] = last;
+    hr->timers[last].heap_pos = pos;
+    hr_sift_down(hr, pos);
+    hr_sift_up(hr, pos);
+}
+
+// Allocate a timer slot.  Returns the timer id (or -1 on error).
+int __visible
+hostreactor_alloc_timer(struct hostreactor *hr, double waketime)
+{
+    if (!hr->num_free) {
+        // Grow the timer slot, heap, and free list storage
+        int na = hr->num_alloc ? 2 * hr->num_alloc : 16;
+        struct hr_timer *timers = realloc(hr->timers, na * sizeof(*timers));
+        if (!timers)
+            return -1;
+        hr->timers = timers;
+        int *heap = realloc(hr->heap, na * sizeof(*heap));
+        if (!heap)
+            return -1;
+        hr->heap = heap;
+        int *free_slots = realloc(hr->free_slots, na * sizeof(*free_slots));
+        if (!free_slots)
+            return -1;
+        hr->free_slots = free_slots;
+        int i;
+        for (i = na - 1; i >= hr->num_alloc; i--)
+            hr->free_slots[hr->num_free++] = i;
+        hr->num_alloc = na;
+    }
+    int slot = hr->free_slots[--hr->num_free];
+    hr->timers[slot].waketime = waketime;
+    hr->timers[slot].jitter = 0.;
+    hr->timers[slot].deadline = waketime;
+    hr->heap[hr->heap_size++] = slot;
+    hr_sift_up(hr, hr->heap_size - 1);
+    return slot;
+}
+
+// Release a timer slot
+void __visible
+hostreactor_free_timer(struct hostreactor *hr, int id)
+{
+    if (hr->timers[id].heap_pos >= 0)
+        hr_heap_remove(hr, id);
+    hr->free_slots[hr->num_free++] = id;
+}
+
+// Reposition a timer in the heap after its deadline changed
+static void
+hr_heap_reschedule(struct hostreactor *hr, int id)
+{
+    struct hr_timer *t = &hr->timers[id];
+    if (t->heap_pos < 0) {
+        hr->heap[hr->heap_size++] = id;
+        hr_sift_up(hr, hr->heap_size - 1);
+    } else {
+        hr_sift_down(hr, t->heap_pos);
+        hr_sift_up(hr, t->heap_pos);
+    }
+}
+
+// Set the wake-up time of a timer (scheduling it if necessary)
+void __visible
+hostreactor_update_timer(struct hostreactor *hr, int id, double waketime)
+{
+    struct hr_timer *t = &hr->timers[id];
+    t->waketime = waketime;
+    t->deadline = waketime + t->jitter;
+    hr_heap_reschedule(hr, id);
+}
+
+// Declare the jitter a timer tolerates.  The timer never forces a
+// wake-up before waketime+jitter, but runs at any wake-up that occurs
+// after its waketime (coalescing it with other events).
+void __visible
+hostreactor_set_timer_jitter(struct hostreactor *hr, int id, double jitter)
+{
+    struct hr_timer *t = &hr->timers[id];
+    t->jitter = jitter;
+    t->deadline = t->waketime + jitter;
+    if (t->heap_pos >= 0)
+        hr_heap_reschedule(hr, id);
+}
+
+// Report the next timer deadline (latest wake-up satisfying all timers)
+double __visible
+hostreactor_next_timer(struct hostreactor *hr)
+{
+    if (!hr->heap_size)
+        return HR_NEVER;
+    return hr->timers[hr->heap[0]].deadline;
+}
+
+// Pop the timers due at 'eventtime' into 'ids'.  Popped timers are
+// descheduled - the caller reschedules each after running its callback.
+int __visible
+hostreactor_check_timers(struct hostreactor *hr, double eventtime
+                         , int *ids, int max)
+{
+    int count = 0;
+    while (count < max && hr->heap_size) {
+        int slot = hr->heap[0];
+        if (hr->timers[slot].waketime > eventtime)
+            break;
+        hr_heap_remove(hr, slot);
+        ids[count++] = slot;
+    }
+    return count;
+}
@@ -0,0 +1,27 @@
+#ifndef HOSTREACTOR_H
+#define HOSTREACTOR_H
+
+#define HR_READ  0x01
+#define HR_WRITE 0x02
+
+struct hr_fd_event {
+    int fd, flags;
+};
+
+struct hostreactor *hostreactor_alloc(void);
+void hostreactor_free(struct hostreactor *hr);
+int hostreactor_register_fd(struct hostreactor *hr, int fd);
+void hostreactor_unregister_fd(struct hostreactor *hr, int fd);
+void hostreactor_set_fd_wake(struct hostreactor *hr, int fd, int flags);
+int hostreactor_wait(struct hostreactor *hr, double timeout
+                     , struct hr_fd_event *events, int max);
+int hostreactor_alloc_timer(struct hostreactor *hr, double waketime);
+void hostreactor_free_timer(struct hostreactor *hr, int id);
+void hostreactor_update_timer(struct hostreactor *hr, int id, double waketime);
+void hostreactor_set_timer_jitter(struct hostreactor *hr, int id
+                                  , double jitter);
+double hostreactor_next_timer(struct hostreactor *hr);
+int hostreactor_check_timers(struct hostreactor *hr, double eventtime
+                             , int *ids, int max);
+
+#endif // hostreactor.h
@@ -14,6 +14,122 @@
 #include "trapq.h" // struct move
 
 
+/****************************************************************
+ * Analytic solver for linear kinematics
+ ****************************************************************/
+
+// Find the root of A*t^2 + B*t + C within [t0, t1] (the quadratic is
+// known to be monotonic over the interval and to cross zero in it)
+static double
+quadratic_root(double A, double B, double C, double t0, double t1)
+{
+    double t;
+    if (!A) {
+        t = -C / B;
+    } else {
+        double disc = B*B - 4.*A*C;
+        if (disc < 0.)
+            disc = 0.;
+        double sq = sqrt(disc);
+        double q = -.5 * (B + (B >= 0. ? sq : -sq));
+        if (!q) {
+            t = 0.;
+        } else {
+            t = q / A;
+            if (!(t >= t0 && t <= t1))
+                t = C / q;
+        }
+    }
+    if (!(t >= t0))
+        t = t0;
+    if (t > t1)
+        t = t1;
+    return t;
+}
+
+// Generate step times analytically for kinematics where the stepper
+// position is an affine function of the move distance.  Within a trapq
+// 'struct move' the position is then a quadratic polynomial of time,
+// so step crossings can be found by direct inversion instead of the
+// secant search.
+static int32_t
+itersolve_gen_steps_quadratic(struct stepper_kinematics *sk
+                              , struct stepcompress *sc, struct move *m
+                              , double abs_start, double abs_end)
+{
+    double base, ratio;
+    sk->calc_move_coeffs_cb(sk, m, &base, &ratio);
+    double start = abs_start - m->print_time, end = abs_end - m->print_time;
+    if (start < 0.)
+        start = 0.;
+    if (end > m->move_t)
+        end = m->move_t;
+    int sdir = stepcompress_get_step_dir(sc);
+    double half_step = .5 * sk->step_dist, step = sk->step_dist;
+    double target = sk->commanded_pos + (sdir ? half_step : -half_step);
+    // Position is pos(t) = A*t^2 + B*t + base
+    double A = ratio * m->half_accel, B = ratio * m->start_v;
+    double seg_start = start;
+    double pos_seg_start = base + (B + A*seg_start) * seg_start;
+    while (ratio && seg_start < end) {
+        // Split the range into monotonic segments at the velocity zero
+        double seg_end = end;
+        if (A) {
+            double tx = -B / (2. * A);
+            if (tx > seg_start && tx < seg_end)
+                seg_end = tx;
+        }
+        double pos_seg_end = base + (B + A*seg_end) * seg_end;
+        if (pos_seg_end > pos_seg_start) {
+            if (!sdir) {
+                if (pos_seg_end >= target + step) {
+                    // Direction change
+                    sdir = 1;
+                    target += step;
+                } else {
+                    goto next_segment;
+                }
+            }
+            while (target <= pos_seg_end) {
+                double t = quadratic_root(A, B, base - target
+                                          , seg_start, seg_end);
+                int ret = stepcompress_append(sc, sdir, m->print_time, t);
+                if (ret)
+                    return ret;
+                target += step;
+            }
+        } else if (pos_seg_end < pos_seg_start) {
+            if (sdir) {
+                if (pos_seg_end <= target - step) {
+                    // Direction change
+                    sdir = 0;
+                    target -= step;
+                } else {
+                    goto next_segment;
+                }
+            }
+            while (target >= pos_seg_end) {
+                double t = quadratic_root(A, B, base - target
+                                          , seg_start, seg_end);
+                int ret = stepcompress_append(sc, sdir, m->print_time, t);
+                if (ret)
+                    return ret;
+                target -= step;
+            }
+        }
+    next_segment:
+        pos_seg_start = pos_seg_end;
+        if (seg_end <= seg_start)
+            break;
+        seg_start = seg_end;
+    }
+    sk->commanded_pos = target - (sdir ? half_step : -half_step);
+    if (sk->post_cb)
+        sk->post_cb(sk);
+    return 0;
+}
+
+
 /****************************************************************
  * Main iterative solver
  ****************************************************************/
@@ -24,11 +140,66 @@ struct timepos {
 
 #define SEEK_TIME_RESET 0.000100
 
+// Number of candidate times evaluated per batched callback invocation
+#define SEEK_BATCH 4
+
+// Try to bracket the next step crossing using a batched position
+// callback.  Evaluates SEEK_BATCH evenly spaced candidate times in one
+// call and, on success, updates the secant guesses and search bounds so
+// the main loop starts with a tight bracket.
+static void
+itersolve_batch_seek(struct stepper_kinematics *sk, struct move *m
+                     , double target, int sdir
+                     , struct timepos *guess, struct timepos *old_guess
+                     , double *low_time, double *high_time, int *have_bracket)
+{
+    sk_calc_batch_callback batch_cb = sk->calc_position_batch_cb;
+    double low = *low_time, high = *high_time;
+    if (!batch_cb || high - low <= SEEK_BATCH * .000000001)
+        return;
+    double times[SEEK_BATCH], positions[SEEK_BATCH];
+    double pitch = (high - low) / SEEK_BATCH;
+    int i;
+    for (i=0; i<SEEK_BATCH; i++)
+        times[i] = low + (i + 1) * pitch;
+    batch_cb(sk, m, times, positions, SEEK_BATCH);
+    double half_step = .5 * sk->step_dist;
+    struct timepos prev = *guess;
+    for (i=0; i<SEEK_BATCH; i++) {
+        double rel_dist = sdir ? positions[i] - target : target - positions[i];
+        if (rel_dist > 0.) {
+            // Found sample past target - use it as the bracket
+            *old_guess = prev;
+            guess->time = times[i];
+            guess->position = positions[i];
+            *low_time = prev.time;
+            *high_time = times[i];
+            *have_bracket = 1;
+            return;
+        }
+        if (rel_dist < -(half_step + half_step))
+            // Possible direction change - let the main loop handle it
+            return;
+        prev.time = times[i];
+        prev.position = positions[i];
+    }
+    // All samples short of target - advance the lower bound
+    *old_guess = *guess;
+    *guess = prev;
+    *low_time = prev.time;
+}
+
 // Generate step times for a portion of a move
 static int32_t
 itersolve_gen_steps_range(struct stepper_kinematics *sk, struct stepcompress *sc
                           , struct move *m, double abs_start, double abs_end)
 {
+    // Report the move's commanded velocity (at its midpoint) so the
+    // step compressor can scale its error budget
+    stepcompress_note_velocity(sc, m->start_v + m->half_accel * m->move_t);
+    if (sk->calc_move_coeffs_cb)
+        // Kinematics is affine in move distance - solve analytically
+        return itersolve_gen_steps_quadratic(sk, sc, m, abs_start, abs_end);
     sk_calc_callback calc_position_cb = sk->calc_position_cb;
     double half_step = .5 * sk->step_dist;
     double start = abs_start - m->print_time, end = abs_end - m->print_time;
@@ -40,9 +211,15 @@ itersolve_gen_steps_range(struct stepper_kinematics *sk, struct stepcompress *sc
     int sdir = stepcompress_get_step_dir(sc);
     int is_dir_change = 0, have_bracket = 0, check_oscillate = 0;
     double target = sk->commanded_pos + (sdir ? half_step : -half_step);
-    double last_time=start, low_time=start, high_time=start + SEEK_TIME_RESET;
+    // Seed the initial search window from the recent step interval average
+    double seek_time = SEEK_TIME_RESET;
+    if (sk->seek_interval && sk->seek_interval * 1.5 < seek_time)
+        seek_time = sk->seek_interval * 1.5;
+    double last_time=start, low_time=start, high_time=start + seek_time;
     if (high_time > end)
         high_time = end;
+    itersolve_batch_seek(sk, m, target, sdir, &guess, &old_guess
+                         , &low_time, &high_time, &have_bracket);
     for (;;) {
         // Use the "secant method" to guess a new time from previous guesses
         double guess_dist = guess.position - target;
@@ -109,6 +286,8 @@ itersolve_gen_steps_range(struct stepper_kinematics *sk, struct stepcompress *sc
         if (ret)
             return ret;
         target = sdir ? target+half_step+half_step : target-half_step-half_step;
+        // Track an average of step intervals to seed future seek windows
+        sk->seek_interval += .5 * ((guess.time - last_time) - sk->seek_interval);
         // Reset bounds checking
         double seek_time_delta = 1.5 * (guess.time - last_time);
         if (seek_time_delta < .000000001)
@@ -120,6 +299,8 @@ itersolve_gen_steps_range(struct stepper_kinematics *sk, struct stepcompress *sc
         if (high_time > end)
             high_time = end;
         is_dir_change = have_bracket = check_oscillate = 0;
+        itersolve_batch_seek(sk, m, target, sdir, &guess, &old_guess
+                             , &low_time, &high_time, &have_bracket);
     }
     sk->commanded_pos = target - (sdir ? half_step : -half_step);
     if (sk->post_cb)
@@ -7,10 +7,20 @@ enum {
     AF_X = 1 << 0, AF_Y = 1 << 1, AF_Z = 1 << 2,
 };
 
+// Maximum number of candidate times passed to a batch position callback
+#define ITERSOLVE_BATCH_MAX 8
+
 struct stepper_kinematics;
 struct move;
 typedef double (*sk_calc_callback)(struct stepper_kinematics *sk, struct move *m
                                    , double move_time);
+typedef void (*sk_calc_batch_callback)(struct stepper_kinematics *sk
+                                       , struct move *m
+                                       , const double *move_times
+                                       , double *positions, int count);
+typedef void (*sk_calc_coeffs_callback)(struct stepper_kinematics *sk
+                                        , struct move *m
+                                        , double *base, double *ratio);
 typedef void (*sk_post_callback)(struct stepper_kinematics *sk);
 struct stepper_kinematics {
     double step_dist, commanded_pos;
@@ -20,9 +30,17 @@ struct stepper_kinematics {
     struct trapq *tq;
     int active_flags;
     double gen_steps_pre_active, gen_steps_post_active;
+    // Average of recent step intervals (seeds the secant search window)
+    double seek_interval;
 
     sk_calc_callback calc_position_cb;
+    sk_calc_batch_callback calc_position_batch_cb;
+    sk_calc_coeffs_callback calc_move_coeffs_cb;
     sk_post_callback post_cb;
+
+    // Per-axis factors when the stepper position is a fixed linear
+    // function of the axis positions (all zero otherwise)
+    double lin_coeffs[3];
 };
 
 int32_t itersolve_generate_steps(struct stepper_kinematics *sk
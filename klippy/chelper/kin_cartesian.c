@@ -32,6 +32,67 @@ cart_stepper_z_calc_position(struct stepper_kinematics *sk, struct move *m
     return move_get_coord(m, move_time).z;
 }
 
+static void
+cart_stepper_calc_position_batch(struct move *m, int axis
+                                 , const double *move_times
+                                 , double *positions, int count)
+{
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    double start = m->start_pos.axis[axis], ratio = m->axes_r.axis[axis];
+    move_get_distance_batch(m, move_times, move_dists, count);
+    int i;
+    for (i=0; i<count; i++)
+        positions[i] = start + ratio * move_dists[i];
+}
+
+static void
+cart_stepper_x_calc_move_coeffs(struct stepper_kinematics *sk, struct move *m
+                                , double *base, double *ratio)
+{
+    *base = m->start_pos.x;
+    *ratio = m->axes_r.x;
+}
+
+static void
+cart_stepper_y_calc_move_coeffs(struct stepper_kinematics *sk, struct move *m
+                                , double *base, double *ratio)
+{
+    *base = m->start_pos.y;
+    *ratio = m->axes_r.y;
+}
+
+static void
+cart_stepper_z_calc_move_coeffs(struct stepper_kinematics *sk, struct move *m
+                                , double *base, double *ratio)
+{
+    *base = m->start_pos.z;
+    *ratio = m->axes_r.z;
+}
+
+static void
+cart_stepper_x_calc_position_batch(struct stepper_kinematics *sk
+                                   , struct move *m, const double *move_times
+                                   , double *positions, int count)
+{
+    cart_stepper_calc_position_batch(m, 0, move_times, positions, count);
+}
+
+static void
+cart_stepper_y_calc_position_batch(struct stepper_kinematics *sk
+                                   , struct move *m, const double *move_times
+                                   , double *positions, int count)
+{
+    cart_stepper_calc_position_batch(m, 1, move_times, positions, count);
+}
+
+static void
+cart_stepper_z_calc_position_batch(struct stepper_kinematics *sk
+                                   , struct move *m, const double *move_times
+                                   , double *positions, int count)
+{
+    cart_stepper_calc_position_batch(m, 2, move_times, positions, count);
+}
+
 struct stepper_kinematics * __visible
 cartesian_stepper_alloc(char axis)
 {
@@ -39,12 +100,21 @@ cartesian_stepper_alloc(char axis)
     memset(sk, 0, sizeof(*sk));
     if (axis == 'x') {
         sk->calc_position_cb = cart_stepper_x_calc_position;
+        sk->calc_position_batch_cb = cart_stepper_x_calc_position_batch;
+        sk->calc_move_coeffs_cb = cart_stepper_x_calc_move_coeffs;
+        sk->lin_coeffs[0] = 1.;
         sk->active_flags = AF_X;
     } else if (axis == 'y') {
         sk->calc_position_cb = cart_stepper_y_calc_position;
+        sk->calc_position_batch_cb = cart_stepper_y_calc_position_batch;
+        sk->calc_move_coeffs_cb = cart_stepper_y_calc_move_coeffs;
+        sk->lin_coeffs[1] = 1.;
         sk->active_flags = AF_Y;
     } else if (axis == 'z') {
         sk->calc_position_cb = cart_stepper_z_calc_position;
+        sk->calc_position_batch_cb = cart_stepper_z_calc_position_batch;
+        sk->calc_move_coeffs_cb = cart_stepper_z_calc_move_coeffs;
+        sk->lin_coeffs[2] = 1.;
         sk->active_flags = AF_Z;
     }
     return sk;
@@ -26,15 +26,73 @@ corexy_stepper_minus_calc_position(struct stepper_kinematics *sk, struct move *m
     return c.x - c.y;
 }
 
+static void
+corexy_stepper_calc_position_batch(struct move *m, double y_sign
+                                   , const double *move_times
+                                   , double *positions, int count)
+{
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    double start = m->start_pos.x + y_sign * m->start_pos.y;
+    double ratio = m->axes_r.x + y_sign * m->axes_r.y;
+    move_get_distance_batch(m, move_times, move_dists, count);
+    int i;
+    for (i=0; i<count; i++)
+        positions[i] = start + ratio * move_dists[i];
+}
+
+static void
+corexy_stepper_plus_calc_move_coeffs(struct stepper_kinematics *sk
+                                     , struct move *m
+                                     , double *base, double *ratio)
+{
+    *base = m->start_pos.x + m->start_pos.y;
+    *ratio = m->axes_r.x + m->axes_r.y;
+}
+
+static void
+corexy_stepper_minus_calc_move_coeffs(struct stepper_kinematics *sk
+                                      , struct move *m
+                                      , double *base, double *ratio)
+{
+    *base = m->start_pos.x - m->start_pos.y;
+    *ratio = m->axes_r.x - m->axes_r.y;
+}
+
+static void
+corexy_stepper_plus_calc_position_batch(struct stepper_kinematics *sk
+                                        , struct move *m
+                                        , const double *move_times
+                                        , double *positions, int count)
+{
+    corexy_stepper_calc_position_batch(m, 1., move_times, positions, count);
+}
+
+static void
+corexy_stepper_minus_calc_position_batch(struct stepper_kinematics *sk
+                                         , struct move *m
+                                         , const double *move_times
+                                         , double *positions, int count)
+{
+    corexy_stepper_calc_position_batch(m, -1., move_times, positions, count);
+}
+
 struct stepper_kinematics * __visible
 corexy_stepper_alloc(char type)
 {
     struct stepper_kinematics *sk = malloc(sizeof(*sk));
     memset(sk, 0, sizeof(*sk));
-    if (type == '+')
+    if (type == '+') {
         sk->calc_position_cb = corexy_stepper_plus_calc_position;
-    else if (type == '-')
+        sk->calc_position_batch_cb = corexy_stepper_plus_calc_position_batch;
+        sk->calc_move_coeffs_cb = corexy_stepper_plus_calc_move_coeffs;
+        sk->lin_coeffs[0] = sk->lin_coeffs[1] = 1.;
+    } else if (type == '-') {
         sk->calc_position_cb = corexy_stepper_minus_calc_position;
+        sk->calc_position_batch_cb = corexy_stepper_minus_calc_position_batch;
+        sk->calc_move_coeffs_cb = corexy_stepper_minus_calc_move_coeffs;
+        sk->lin_coeffs[0] = 1.;
+        sk->lin_coeffs[1] = -1.;
+    }
     sk->active_flags = AF_X | AF_Y;
     return sk;
 }
@@ -27,6 +27,41 @@ delta_stepper_calc_position(struct stepper_kinematics *sk, struct move *m
     return sqrt(ds->arm2 - dx*dx - dy*dy) + c.z;
 }
 
+// Vector of doubles sized to match AVX2 registers (lowered to paired
+// 128bit operations on SSE2 and NEON targets)
+typedef double vec4double __attribute__((vector_size(4 * sizeof(double))));
+
+static void
+delta_stepper_calc_position_batch(struct stepper_kinematics *sk
+                                  , struct move *m, const double *move_times
+                                  , double *positions, int count)
+{
+    struct delta_stepper *ds = container_of(sk, struct delta_stepper, sk);
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    move_get_distance_batch(m, move_times, move_dists, count);
+    double tx = ds->tower_x - m->start_pos.x;
+    double ty = ds->tower_y - m->start_pos.y;
+    double rx = m->axes_r.x, ry = m->axes_r.y, rz = m->axes_r.z;
+    double sz = m->start_pos.z, arm2 = ds->arm2;
+    int i = 0;
+    while (count - i >= 4) {
+        // Compiled to packed sqrt instructions (build uses -fno-math-errno)
+        vec4double d;
+        memcpy(&d, &move_dists[i], sizeof(d));
+        vec4double dx = tx - rx * d, dy = ty - ry * d;
+        vec4double a = arm2 - dx*dx - dy*dy;
+        vec4double pos = { __builtin_sqrt(a[0]), __builtin_sqrt(a[1])
+                           , __builtin_sqrt(a[2]), __builtin_sqrt(a[3]) };
+        pos += sz + rz * d;
+        memcpy(&positions[i], &pos, sizeof(pos));
+        i += 4;
+    }
+    for (; i<count; i++) {
+        double dx = tx - rx * move_dists[i], dy = ty - ry * move_dists[i];
+        positions[i] = sqrt(arm2 - dx*dx - dy*dy) + sz + rz * move_dists[i];
+    }
+}
+
 struct stepper_kinematics * __visible
 delta_stepper_alloc(double arm2, double tower_x, double tower_y)
 {
@@ -36,6 +71,7 @@ delta_stepper_alloc(double arm2, double tower_x, double tower_y)
     ds->tower_x = tower_x;
     ds->tower_y = tower_y;
     ds->sk.calc_position_cb = delta_stepper_calc_position;
+    ds->sk.calc_position_batch_cb = delta_stepper_calc_position_batch;
     ds->sk.active_flags = AF_X | AF_Y | AF_Z;
     return &ds->sk;
 }
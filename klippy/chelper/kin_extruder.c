@@ -13,8 +13,17 @@
 #include "pyhelper.h" // errorf
 #include "trapq.h" // move_get_distance
 
+// Host-computed advance curve (velocity -> advance distance) sampled
+// at uniform velocity intervals for O(1) lookup
+struct pa_table {
+    int count;
+    double inv_vel_step;
+    double advances[];
+};
+
 struct pa_params {
     double pressure_advance, active_print_time;
+    struct pa_table *table;
     struct list_node node;
 };
 
@@ -56,6 +65,35 @@ extruder_integrate_time(double base, double start_v, double half_accel
     return ei - si;
 }
 
+// Lookup advance distance for a given velocity (linear interpolation)
+static double
+pa_table_lookup(struct pa_table *pt, double velocity)
+{
+    double pos = velocity * pt->inv_vel_step;
+    if (pos <= 0.)
+        return pt->advances[0];
+    if (pos >= pt->count - 1)
+        return pt->advances[pt->count - 1];
+    int idx = (int)pos;
+    double frac = pos - idx;
+    return pt->advances[idx] * (1. - frac) + pt->advances[idx + 1] * frac;
+}
+
+// Precomputed Gauss-Legendre nodes and weights (for the interval [-1:1])
+#define PA_GAUSS 8
+static const double pa_gauss_x[PA_GAUSS] = {
+    -0.9602898564975363, -0.7966664774136267,
+    -0.5255324099163290, -0.1834346424956498,
+    0.1834346424956498, 0.5255324099163290,
+    0.7966664774136267, 0.9602898564975363
+};
+static const double pa_gauss_w[PA_GAUSS] = {
+    0.1012285362903763, 0.2223810344533745,
+    0.3137066458778873, 0.3626837833783620,
+    0.3626837833783620, 0.3137066458778873,
+    0.2223810344533745, 0.1012285362903763
+};
+
 // Calculate the definitive integral of extruder for a given move
 static double
 pa_move_integrate(struct move *m, struct list_head *pa_list
@@ -68,6 +106,7 @@ pa_move_integrate(struct move *m, struct list_head *pa_list
     // Determine pressure_advance value
     int can_pressure_advance = m->axes_r.y != 0.;
     double pressure_advance = 0.;
+    struct pa_table *table = NULL;
     if (can_pressure_advance) {
         struct pa_params *pa = list_last_entry(pa_list, struct pa_params, node);
         while (unlikely(pa->active_print_time > m->print_time) &&
@@ -75,15 +114,33 @@ pa_move_integrate(struct move *m, struct list_head *pa_list
             pa = list_prev_entry(pa, node);
         }
         pressure_advance = pa->pressure_advance;
+        table = pa->table;
     }
     // Calculate base position and velocity with pressure advance
-    base += pressure_advance * m->start_v;
-    double start_v = m->start_v + pressure_advance * 2. * m->half_accel;
+    double start_v = m->start_v;
+    if (!table) {
+        base += pressure_advance * m->start_v;
+        start_v += pressure_advance * 2. * m->half_accel;
+    }
     // Calculate definitive integral
     double ha = m->half_accel;
     double iext = extruder_integrate(base, start_v, ha, start, end);
     double wgt_ext = extruder_integrate_time(base, start_v, ha, start, end);
-    return wgt_ext - time_offset * iext;
+    double res = wgt_ext - time_offset * iext;
+    if (table) {
+        // Table driven advance - integrate advance(velocity(t)) numerically
+        // (velocity is linear within a move, so fixed node quadrature with
+        // precomputed weights is accurate)
+        double c = .5 * (start + end), hdt = .5 * (end - start);
+        int i;
+        for (i = 0; i < PA_GAUSS; i++) {
+            double t = c + hdt * pa_gauss_x[i];
+            double v = m->start_v + 2. * m->half_accel * t;
+            res += hdt * pa_gauss_w[i] * (t - time_offset)
+                * pa_table_lookup(table, v);
+        }
+    }
+    return res;
 }
 
 // Calculate the definitive integral of the extruder over a range of moves
@@ -135,32 +192,44 @@ extruder_calc_position(struct stepper_kinematics *sk, struct move *m
     return m->start_pos.x + area * es->inv_half_smooth_time2;
 }
 
-void __visible
-extruder_set_pressure_advance(struct stepper_kinematics *sk, double print_time
-                              , double pressure_advance, double smooth_time)
+// Update smooth time and cleanup old pressure advance parameters
+static void
+extruder_update_smooth_time(struct extruder_stepper *es, double smooth_time)
 {
-    struct extruder_stepper *es = container_of(sk, struct extruder_stepper, sk);
     double hst = smooth_time * .5, old_hst = es->half_smooth_time;
     es->half_smooth_time = hst;
     es->sk.gen_steps_pre_active = es->sk.gen_steps_post_active = hst;
 
     // Cleanup old pressure advance parameters
-    double cleanup_time = sk->last_flush_time - (old_hst > hst ? old_hst : hst);
+    double cleanup_time = es->sk.last_flush_time
+        - (old_hst > hst ? old_hst : hst);
     struct pa_params *first_pa = list_first_entry(
             &es->pa_list, struct pa_params, node);
     while (!list_is_last(&first_pa->node, &es->pa_list)) {
         struct pa_params *next_pa = list_next_entry(first_pa, node);
         if (next_pa->active_print_time >= cleanup_time) break;
         list_del(&first_pa->node);
+        free(first_pa->table);
+        free(first_pa);
         first_pa = next_pa;
     }
 
-    if (! hst)
+    if (hst)
+        es->inv_half_smooth_time2 = 1. / (hst * hst);
+}
+
+void __visible
+extruder_set_pressure_advance(struct stepper_kinematics *sk, double print_time
+                              , double pressure_advance, double smooth_time)
+{
+    struct extruder_stepper *es = container_of(sk, struct extruder_stepper, sk);
+    extruder_update_smooth_time(es, smooth_time);
+    if (! es->half_smooth_time)
         return;
-    es->inv_half_smooth_time2 = 1. / (hst * hst);
 
-    if (list_last_entry(&es->pa_list, struct pa_params, node)->pressure_advance
-            == pressure_advance) {
+    struct pa_params *last_pa = list_last_entry(
+            &es->pa_list, struct pa_params, node);
+    if (!last_pa->table && last_pa->pressure_advance == pressure_advance) {
         // Retain old pa_params
         return;
     }
@@ -172,6 +241,29 @@ extruder_set_pressure_advance(struct stepper_kinematics *sk, double print_time
     list_add_tail(&pa->node, &es->pa_list);
 }
 
+void __visible
+extruder_set_pressure_advance_table(struct stepper_kinematics *sk
+                                    , double print_time, double *advances
+                                    , int count, double vel_step
+                                    , double smooth_time)
+{
+    struct extruder_stepper *es = container_of(sk, struct extruder_stepper, sk);
+    extruder_update_smooth_time(es, smooth_time);
+    if (! es->half_smooth_time || count < 2 || vel_step <= 0.)
+        return;
+
+    // Add new pressure advance parameters with advance lookup table
+    struct pa_table *pt = malloc(sizeof(*pt) + count * sizeof(double));
+    pt->count = count;
+    pt->inv_vel_step = 1. / vel_step;
+    memcpy(pt->advances, advances, count * sizeof(double));
+    struct pa_params *pa = malloc(sizeof(*pa));
+    memset(pa, 0, sizeof(*pa));
+    pa->table = pt;
+    pa->active_print_time = print_time;
+    list_add_tail(&pa->node, &es->pa_list);
+}
+
 struct stepper_kinematics * __visible
 extruder_stepper_alloc(void)
 {
@@ -194,6 +286,7 @@ extruder_stepper_free(struct stepper_kinematics *sk)
         struct pa_params *pa = list_first_entry(
                 &es->pa_list, struct pa_params, node);
         list_del(&pa->node);
+        free(pa->table);
         free(pa);
     }
     free(sk);
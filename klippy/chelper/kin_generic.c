@@ -26,6 +26,36 @@ generic_cartesian_stepper_calc_position(struct stepper_kinematics *sk
     return cs->a.x * c.x + cs->a.y * c.y + cs->a.z * c.z;
 }
 
+// Collapse the coefficient row against a move so the stepper position
+// is a scalar affine function of the move distance
+static void
+generic_cartesian_stepper_calc_move_coeffs(struct stepper_kinematics *sk
+                                           , struct move *m
+                                           , double *base, double *ratio)
+{
+    struct generic_cartesian_stepper *cs = container_of(
+            sk, struct generic_cartesian_stepper, sk);
+    *base = (cs->a.x * m->start_pos.x + cs->a.y * m->start_pos.y
+             + cs->a.z * m->start_pos.z);
+    *ratio = (cs->a.x * m->axes_r.x + cs->a.y * m->axes_r.y
+              + cs->a.z * m->axes_r.z);
+}
+
+static void
+generic_cartesian_stepper_calc_position_batch(struct stepper_kinematics *sk
+                                              , struct move *m
+                                              , const double *move_times
+                                              , double *positions, int count)
+{
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    double base, ratio;
+    generic_cartesian_stepper_calc_move_coeffs(sk, m, &base, &ratio);
+    move_get_distance_batch(m, move_times, move_dists, count);
+    int i;
+    for (i=0; i<count; i++)
+        positions[i] = base + ratio * move_dists[i];
+}
+
 void __visible
 generic_cartesian_stepper_set_coeffs(struct stepper_kinematics *sk
                                      , double a_x, double a_y, double a_z)
@@ -35,6 +65,9 @@ generic_cartesian_stepper_set_coeffs(struct stepper_kinematics *sk
     cs->a.x = a_x;
     cs->a.y = a_y;
     cs->a.z = a_z;
+    cs->sk.lin_coeffs[0] = a_x;
+    cs->sk.lin_coeffs[1] = a_y;
+    cs->sk.lin_coeffs[2] = a_z;
     cs->sk.active_flags = 0;
     if (a_x) cs->sk.active_flags |= AF_X;
     if (a_y) cs->sk.active_flags |= AF_Y;
@@ -47,6 +80,9 @@ generic_cartesian_stepper_alloc(double a_x, double a_y, double a_z)
     struct generic_cartesian_stepper *cs = malloc(sizeof(*cs));
     memset(cs, 0, sizeof(*cs));
     cs->sk.calc_position_cb = generic_cartesian_stepper_calc_position;
+    cs->sk.calc_position_batch_cb
+        = generic_cartesian_stepper_calc_position_batch;
+    cs->sk.calc_move_coeffs_cb = generic_cartesian_stepper_calc_move_coeffs;
     generic_cartesian_stepper_set_coeffs(&cs->sk, a_x, a_y, a_z);
     return &cs->sk;
 }
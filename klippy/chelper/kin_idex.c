@@ -4,6 +4,7 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include <math.h> // fabs
 #include <stddef.h> // offsetof
 #include <stdlib.h> // malloc
 #include <string.h> // memset
@@ -18,6 +19,9 @@ struct dual_carriage_stepper {
     struct stepper_kinematics *orig_sk;
     struct move m;
     double x_scale, x_offs, y_scale, y_offs;
+    // Carriage transform folded into affine kinematics coefficients
+    int have_coeffs;
+    double c_x, c_y, c_z, c_base;
 };
 
 double
@@ -27,12 +31,49 @@ dual_carriage_calc_position(struct stepper_kinematics *sk, struct move *m
     struct dual_carriage_stepper *dc = container_of(
             sk, struct dual_carriage_stepper, sk);
     struct coord pos = move_get_coord(m, move_time);
+    if (likely(dc->have_coeffs))
+        return dc->c_base + pos.x*dc->c_x + pos.y*dc->c_y + pos.z*dc->c_z;
     dc->m.start_pos.x = pos.x * dc->x_scale + dc->x_offs;
     dc->m.start_pos.y = pos.y * dc->y_scale + dc->y_offs;
     dc->m.start_pos.z = pos.z;
     return dc->orig_sk->calc_position_cb(dc->orig_sk, &dc->m, DUMMY_T);
 }
 
+// Query the wrapped kinematics at a fixed coordinate
+static double
+probe_position(struct dual_carriage_stepper *dc, double x, double y, double z)
+{
+    dc->m.start_pos.x = x;
+    dc->m.start_pos.y = y;
+    dc->m.start_pos.z = z;
+    return dc->orig_sk->calc_position_cb(dc->orig_sk, &dc->m, DUMMY_T);
+}
+
+// Extract the affine coefficients of the wrapped kinematics and fold
+// the carriage scale/offset into them, so steady-state solving is a
+// single dot product with no second kinematics callback.  Leaves the
+// per-call transform path in place if the kinematics is not affine.
+static void
+update_coeffs(struct dual_carriage_stepper *dc)
+{
+    dc->have_coeffs = 0;
+    if (!dc->orig_sk)
+        return;
+    double base = probe_position(dc, 0., 0., 0.);
+    double a_x = probe_position(dc, 1., 0., 0.) - base;
+    double a_y = probe_position(dc, 0., 1., 0.) - base;
+    double a_z = probe_position(dc, 0., 0., 1.) - base;
+    double check = probe_position(dc, -2., 3., 5.);
+    if (!(fabs(base - 2.*a_x + 3.*a_y + 5.*a_z - check) <= 1e-9))
+        // Not affine (or not finite) - keep the generic path
+        return;
+    dc->c_x = a_x * dc->x_scale;
+    dc->c_y = a_y * dc->y_scale;
+    dc->c_z = a_z;
+    dc->c_base = base + a_x * dc->x_offs + a_y * dc->y_offs;
+    dc->have_coeffs = 1;
+}
+
 void __visible
 dual_carriage_set_sk(struct stepper_kinematics *sk
                      , struct stepper_kinematics *orig_sk)
@@ -42,6 +83,7 @@ dual_carriage_set_sk(struct stepper_kinematics *sk
     dc->sk.calc_position_cb = dual_carriage_calc_position;
     dc->sk.active_flags = orig_sk->active_flags;
     dc->orig_sk = orig_sk;
+    update_coeffs(dc);
 }
 
 int __visible
@@ -57,6 +99,7 @@ dual_carriage_set_transform(struct stepper_kinematics *sk, char axis
             dc->sk.active_flags &= ~AF_X;
         else if (scale && dc->orig_sk->active_flags & AF_X)
             dc->sk.active_flags |= AF_X;
+        update_coeffs(dc);
         return 0;
     }
     if (axis == 'y') {
@@ -66,6 +109,7 @@ dual_carriage_set_transform(struct stepper_kinematics *sk, char axis
             dc->sk.active_flags &= ~AF_Y;
         else if (scale && dc->orig_sk->active_flags & AF_Y)
             dc->sk.active_flags |= AF_Y;
+        update_coeffs(dc);
         return 0;
     }
     return -1;
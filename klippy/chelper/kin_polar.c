@@ -33,6 +33,62 @@ polar_stepper_angle_calc_position(struct stepper_kinematics *sk, struct move *m
     return angle;
 }
 
+static void
+polar_stepper_radius_calc_position_batch(struct stepper_kinematics *sk
+                                         , struct move *m
+                                         , const double *move_times
+                                         , double *positions, int count)
+{
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    move_get_distance_batch(m, move_times, move_dists, count);
+    double sx = m->start_pos.x, sy = m->start_pos.y;
+    double rx = m->axes_r.x, ry = m->axes_r.y;
+    // Radius along a linear xy path is sqrt(s2 + 2*sr*d + rr*d^2)
+    double s2 = sx*sx + sy*sy, sr = sx*rx + sy*ry, rr = rx*rx + ry*ry;
+    int i;
+    for (i=0; i<count; i++) {
+        double d = move_dists[i];
+        positions[i] = sqrt(s2 + (2.*sr + rr*d)*d);
+    }
+}
+
+static void
+polar_stepper_angle_calc_position_batch(struct stepper_kinematics *sk
+                                        , struct move *m
+                                        , const double *move_times
+                                        , double *positions, int count)
+{
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    move_get_distance_batch(m, move_times, move_dists, count);
+    double sx = m->start_pos.x, sy = m->start_pos.y;
+    double rx = m->axes_r.x, ry = m->axes_r.y;
+    // Angle along a linear xy path rotates away from the start angle
+    // by atan2(cross*d, s2 + sr*d)
+    double s2 = sx*sx + sy*sy, sr = sx*rx + sy*ry;
+    double cross = sx*ry - sy*rx;
+    double base = atan2(sy, sx);
+    int i;
+    for (i=0; i<count; i++) {
+        double d = move_dists[i];
+        double angle;
+        if (likely(s2 > 1e-18)) {
+            angle = base + atan2(cross*d, s2 + sr*d);
+            if (angle > M_PI)
+                angle -= 2. * M_PI;
+            else if (angle < -M_PI)
+                angle += 2. * M_PI;
+        } else {
+            // Move starts at the origin - no usable start angle
+            angle = atan2(sy + ry*d, sx + rx*d);
+        }
+        if (angle - sk->commanded_pos > M_PI)
+            angle -= 2. * M_PI;
+        else if (angle - sk->commanded_pos < -M_PI)
+            angle += 2. * M_PI;
+        positions[i] = angle;
+    }
+}
+
 static void
 polar_stepper_angle_post_fixup(struct stepper_kinematics *sk)
 {
@@ -50,8 +106,10 @@ polar_stepper_alloc(char type)
     memset(sk, 0, sizeof(*sk));
     if (type == 'r') {
         sk->calc_position_cb = polar_stepper_radius_calc_position;
+        sk->calc_position_batch_cb = polar_stepper_radius_calc_position_batch;
     } else if (type == 'a') {
         sk->calc_position_cb = polar_stepper_angle_calc_position;
+        sk->calc_position_batch_cb = polar_stepper_angle_calc_position_batch;
         sk->post_cb = polar_stepper_angle_post_fixup;
     }
     sk->active_flags = AF_X | AF_Y;
@@ -55,6 +55,27 @@ rotary_stepper_calc_position(struct stepper_kinematics *sk, struct move *m
                                , rs->lower_arm2 - sjz*sjz);
 }
 
+static void
+rotary_stepper_calc_position_batch(struct stepper_kinematics *sk
+                                   , struct move *m, const double *move_times
+                                   , double *positions, int count)
+{
+    struct rotary_stepper *rs = container_of(sk, struct rotary_stepper, sk);
+    double move_dists[ITERSOLVE_BATCH_MAX];
+    move_get_distance_batch(m, move_times, move_dists, count);
+    int i;
+    for (i=0; i<count; i++) {
+        double x = m->start_pos.x + m->axes_r.x * move_dists[i];
+        double y = m->start_pos.y + m->axes_r.y * move_dists[i];
+        double z = m->start_pos.z + m->axes_r.z * move_dists[i];
+        double sjz = y * rs->cos - x * rs->sin;
+        double sjx = x * rs->cos + y * rs->sin - rs->shoulder_radius;
+        double sjy = z - rs->shoulder_height;
+        positions[i] = rotary_two_arm_calc(sjx, sjy, rs->upper_arm2
+                                           , rs->lower_arm2 - sjz*sjz);
+    }
+}
+
 struct stepper_kinematics * __visible
 rotary_delta_stepper_alloc(double shoulder_radius, double shoulder_height
                            , double angle, double upper_arm, double lower_arm)
@@ -68,6 +89,7 @@ rotary_delta_stepper_alloc(double shoulder_radius, double shoulder_height
     rs->upper_arm2 = upper_arm * upper_arm;
     rs->lower_arm2 = lower_arm * lower_arm;
     rs->sk.calc_position_cb = rotary_stepper_calc_position;
+    rs->sk.calc_position_batch_cb = rotary_stepper_calc_position_batch;
     rs->sk.active_flags = AF_X | AF_Y | AF_Z;
     return &rs->sk;
 }
@@ -76,31 +76,33 @@ get_axis_position(struct move *m, int axis, double move_time)
     return start_pos + axis_r * move_dist;
 }
 
-static inline double
-get_axis_position_across_moves(struct move *m, int axis, double time)
-{
-    while (likely(time < 0.)) {
-        m = list_prev_entry(m, node);
-        time += m->move_t;
-    }
-    while (likely(time > m->move_t)) {
-        time -= m->move_t;
-        m = list_next_entry(m, node);
-    }
-    return get_axis_position(m, axis, time);
-}
-
 // Calculate the position from the convolution of the shaper with input signal
 static inline double
 calc_position(struct move *m, int axis, double move_time
               , struct shaper_pulses *sp)
 {
-    double res = 0.;
     int num_pulses = sp->num_pulses, i;
-    for (i = 0; i < num_pulses; ++i) {
-        double t = sp->pulses[i].t, a = sp->pulses[i].a;
-        res += a * get_axis_position_across_moves(m, axis, move_time + t);
+    double positions[ARRAY_SIZE(sp->pulses)];
+    // Pulses are sorted by time - evaluate all taps in one ordered
+    // traversal of the move list instead of rewalking it per pulse
+    double t = move_time + sp->pulses[0].t;
+    while (likely(t < 0.)) {
+        m = list_prev_entry(m, node);
+        t += m->move_t;
     }
+    for (i = 0;;) {
+        while (likely(t > m->move_t)) {
+            t -= m->move_t;
+            m = list_next_entry(m, node);
+        }
+        positions[i] = get_axis_position(m, axis, t);
+        if (++i >= num_pulses)
+            break;
+        t += sp->pulses[i].t - sp->pulses[i-1].t;
+    }
+    double res = 0.;
+    for (i = 0; i < num_pulses; ++i)
+        res += sp->pulses[i].a * positions[i];
     return res;
 }
 
@@ -111,23 +113,54 @@ calc_position(struct move *m, int axis, double move_time
 
 #define DUMMY_T 500.0
 
+// Shaper parameters scheduled to take effect at a future print time
+struct pending_shaper {
+    int pending;
+    double fade_start, fade_end, inv_fade;
+    struct shaper_pulses sp;
+};
+
 struct input_shaper {
     struct stepper_kinematics sk;
     struct stepper_kinematics *orig_sk;
     struct move m;
     struct shaper_pulses sp[3];
+    struct pending_shaper pending[3];
 };
 
+// Calculate a shaped axis position, crossfading to any scheduled
+// parameter swap so the commanded position stays continuous
+static double
+shaper_axis_position(struct input_shaper *is, int ax, struct move *m
+                     , double move_time)
+{
+    struct shaper_pulses *sp = &is->sp[ax];
+    double pos = sp->num_pulses ? calc_position(m, 'x' + ax, move_time, sp)
+        : get_axis_position(m, 'x' + ax, move_time);
+    struct pending_shaper *ps = &is->pending[ax];
+    if (likely(!ps->pending))
+        return pos;
+    double abs_time = m->print_time + move_time;
+    if (abs_time <= ps->fade_start)
+        return pos;
+    struct shaper_pulses *nsp = &ps->sp;
+    double npos = nsp->num_pulses
+        ? calc_position(m, 'x' + ax, move_time, nsp)
+        : get_axis_position(m, 'x' + ax, move_time);
+    if (abs_time >= ps->fade_end)
+        return npos;
+    return pos + (npos - pos) * (abs_time - ps->fade_start) * ps->inv_fade;
+}
+
 // Optimized calc_position when only x axis is needed
 static double
 shaper_x_calc_position(struct stepper_kinematics *sk, struct move *m
                        , double move_time)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
-    struct shaper_pulses *sx = &is->sp[0];
-    if (!sx->num_pulses)
+    if (!is->sp[0].num_pulses && !is->pending[0].pending)
         return is->orig_sk->calc_position_cb(is->orig_sk, m, move_time);
-    is->m.start_pos.x = calc_position(m, 'x', move_time, sx);
+    is->m.start_pos.x = shaper_axis_position(is, 0, m, move_time);
     return is->orig_sk->calc_position_cb(is->orig_sk, &is->m, DUMMY_T);
 }
 
@@ -137,10 +170,9 @@ shaper_y_calc_position(struct stepper_kinematics *sk, struct move *m
                        , double move_time)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
-    struct shaper_pulses *sy = &is->sp[1];
-    if (!sy->num_pulses)
+    if (!is->sp[1].num_pulses && !is->pending[1].pending)
         return is->orig_sk->calc_position_cb(is->orig_sk, m, move_time);
-    is->m.start_pos.y = calc_position(m, 'y', move_time, sy);
+    is->m.start_pos.y = shaper_axis_position(is, 1, m, move_time);
     return is->orig_sk->calc_position_cb(is->orig_sk, &is->m, DUMMY_T);
 }
 
@@ -150,10 +182,9 @@ shaper_z_calc_position(struct stepper_kinematics *sk, struct move *m
                        , double move_time)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
-    struct shaper_pulses *sz = &is->sp[2];
-    if (!sz->num_pulses)
+    if (!is->sp[2].num_pulses && !is->pending[2].pending)
         return is->orig_sk->calc_position_cb(is->orig_sk, m, move_time);
-    is->m.start_pos.z = calc_position(m, 'z', move_time, sz);
+    is->m.start_pos.z = shaper_axis_position(is, 2, m, move_time);
     return is->orig_sk->calc_position_cb(is->orig_sk, &is->m, DUMMY_T);
 }
 
@@ -163,61 +194,99 @@ shaper_xyz_calc_position(struct stepper_kinematics *sk, struct move *m
                          , double move_time)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
-    if (!is->sp[0].num_pulses && !is->sp[1].num_pulses && !is->sp[2].num_pulses)
+    int i, active = 0;
+    for (i = 0; i < 3; ++i)
+        if (is->sp[i].num_pulses || is->pending[i].pending)
+            active = 1;
+    if (!active)
         return is->orig_sk->calc_position_cb(is->orig_sk, m, move_time);
     is->m.start_pos = move_get_coord(m, move_time);
-    if (is->sp[0].num_pulses)
-        is->m.start_pos.x = calc_position(m, 'x', move_time, &is->sp[0]);
-    if (is->sp[1].num_pulses)
-        is->m.start_pos.y = calc_position(m, 'y', move_time, &is->sp[1]);
-    if (is->sp[2].num_pulses)
-        is->m.start_pos.z = calc_position(m, 'z', move_time, &is->sp[2]);
+    for (i = 0; i < 3; ++i)
+        if (is->sp[i].num_pulses || is->pending[i].pending)
+            is->m.start_pos.axis[i] = shaper_axis_position(is, i, m, move_time);
     return is->orig_sk->calc_position_cb(is->orig_sk, &is->m, DUMMY_T);
 }
 
-// A callback that forwards post_cb call to the original kinematics
-static void
-shaper_commanded_pos_post_fixup(struct stepper_kinematics *sk)
+// Fused calc_position for kinematics that are a fixed linear function
+// of the axis positions (cartesian, corexy, corexz, generic cartesian).
+// Evaluates the shaped axes directly - no dispatch through the original
+// kinematics callback and no substitute move construction.
+static double
+shaper_linear_calc_position(struct stepper_kinematics *sk, struct move *m
+                            , double move_time)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
-    is->orig_sk->commanded_pos = sk->commanded_pos;
-    is->orig_sk->post_cb(is->orig_sk);
-    sk->commanded_pos = is->orig_sk->commanded_pos;
+    double res = 0.;
+    int i;
+    for (i = 0; i < 3; ++i) {
+        double coeff = is->orig_sk->lin_coeffs[i];
+        if (!coeff)
+            continue;
+        res += coeff * shaper_axis_position(is, i, m, move_time);
+    }
+    return res;
 }
 
 static void
 shaper_note_generation_time(struct input_shaper *is)
 {
     double pre_active = 0., post_active = 0.;
-    struct shaper_pulses *sx = &is->sp[0];
-    if ((is->sk.active_flags & AF_X) && sx->num_pulses) {
-        pre_active = sx->pulses[sx->num_pulses-1].t;
-        post_active = -sx->pulses[0].t;
-    }
-    struct shaper_pulses *sy = &is->sp[1];
-    if ((is->sk.active_flags & AF_Y) && sy->num_pulses) {
-        pre_active = sy->pulses[sy->num_pulses-1].t > pre_active
-            ? sy->pulses[sy->num_pulses-1].t : pre_active;
-        post_active = -sy->pulses[0].t > post_active
-            ? -sy->pulses[0].t : post_active;
-    }
-    struct shaper_pulses *sz = &is->sp[2];
-    if ((is->sk.active_flags & AF_Z) && sz->num_pulses) {
-        pre_active = sz->pulses[sz->num_pulses-1].t > pre_active
-            ? sz->pulses[sz->num_pulses-1].t : pre_active;
-        post_active = -sz->pulses[0].t > post_active
-            ? -sz->pulses[0].t : post_active;
+    int i;
+    for (i = 0; i < 3; ++i) {
+        if (!(is->sk.active_flags & KIN_FLAGS[i]))
+            continue;
+        // Scan windows must cover a scheduled shaper too until it is
+        // fully in effect
+        struct shaper_pulses *sps[2] = { &is->sp[i], &is->pending[i].sp };
+        int j, num_sps = is->pending[i].pending ? 2 : 1;
+        for (j = 0; j < num_sps; ++j) {
+            struct shaper_pulses *sp = sps[j];
+            if (!sp->num_pulses)
+                continue;
+            if (sp->pulses[sp->num_pulses-1].t > pre_active)
+                pre_active = sp->pulses[sp->num_pulses-1].t;
+            if (-sp->pulses[0].t > post_active)
+                post_active = -sp->pulses[0].t;
+        }
     }
     is->sk.gen_steps_pre_active = pre_active;
     is->sk.gen_steps_post_active = post_active;
 }
 
+// A callback run after each generation pass - makes a scheduled shaper
+// current once generation has advanced past its crossfade window and
+// forwards the call to the original kinematics post_cb (if any)
+static void
+shaper_post_cb(struct stepper_kinematics *sk)
+{
+    struct input_shaper *is = container_of(sk, struct input_shaper, sk);
+    int i, changed = 0;
+    for (i = 0; i < 3; ++i) {
+        struct pending_shaper *ps = &is->pending[i];
+        if (ps->pending && sk->last_flush_time >= ps->fade_end) {
+            is->sp[i] = ps->sp;
+            ps->pending = 0;
+            changed = 1;
+        }
+    }
+    if (unlikely(changed))
+        shaper_note_generation_time(is);
+    if (is->orig_sk->post_cb) {
+        is->orig_sk->commanded_pos = sk->commanded_pos;
+        is->orig_sk->post_cb(is->orig_sk);
+        sk->commanded_pos = is->orig_sk->commanded_pos;
+    }
+}
+
 void __visible
 input_shaper_update_sk(struct stepper_kinematics *sk)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
     int kin_flags = is->orig_sk->active_flags & (AF_X | AF_Y | AF_Z);
-    if (kin_flags == AF_X)
+    double *lc = is->orig_sk->lin_coeffs;
+    if (lc[0] || lc[1] || lc[2])
+        is->sk.calc_position_cb = shaper_linear_calc_position;
+    else if (kin_flags == AF_X)
         is->sk.calc_position_cb = shaper_x_calc_position;
     else if (kin_flags == AF_Y)
         is->sk.calc_position_cb = shaper_y_calc_position;
@@ -234,24 +303,25 @@ input_shaper_set_sk(struct stepper_kinematics *sk
                     , struct stepper_kinematics *orig_sk)
 {
     struct input_shaper *is = container_of(sk, struct input_shaper, sk);
-    if (orig_sk->active_flags == AF_X)
+    double *lc = orig_sk->lin_coeffs;
+    if (!(orig_sk->active_flags & (AF_X | AF_Y | AF_Z)))
+        return -1;
+    if (lc[0] || lc[1] || lc[2])
+        is->sk.calc_position_cb = shaper_linear_calc_position;
+    else if (orig_sk->active_flags == AF_X)
         is->sk.calc_position_cb = shaper_x_calc_position;
     else if (orig_sk->active_flags == AF_Y)
         is->sk.calc_position_cb = shaper_y_calc_position;
     else if (orig_sk->active_flags == AF_Z)
         is->sk.calc_position_cb = shaper_z_calc_position;
-    else if (orig_sk->active_flags & (AF_X | AF_Y | AF_Z))
-        is->sk.calc_position_cb = shaper_xyz_calc_position;
     else
-        return -1;
+        is->sk.calc_position_cb = shaper_xyz_calc_position;
     is->sk.active_flags = orig_sk->active_flags;
     is->orig_sk = orig_sk;
     is->sk.commanded_pos = orig_sk->commanded_pos;
     is->sk.last_flush_time = orig_sk->last_flush_time;
     is->sk.last_move_time = orig_sk->last_move_time;
-    if (orig_sk->post_cb) {
-        is->sk.post_cb = shaper_commanded_pos_post_fixup;
-    }
+    is->sk.post_cb = shaper_post_cb;
     return 0;
 }
 
@@ -267,12 +337,66 @@ input_shaper_set_shaper_params(struct stepper_kinematics *sk, char axis
     int status = 0;
     // Ignore input shaper update if the axis is not active
     if (is->orig_sk->active_flags & KIN_FLAGS[axis_ind]) {
+        is->pending[axis_ind].pending = 0;
         status = init_shaper(n, a, t, sp);
         shaper_note_generation_time(is);
     }
     return status;
 }
 
+// Schedule a parameter change to take effect at 'swap_time', with the
+// commanded position crossfaded from the old to the new shaper over
+// 'fade_time' seconds to avoid a discontinuity (a fade_time <= 0.
+// selects a duration derived from the pulse spans of both shapers).
+// This allows changing the parameters without flushing the generation
+// pipeline first.
+int __visible
+input_shaper_schedule_shaper_params(struct stepper_kinematics *sk, char axis
+                                    , int n, double a[], double t[]
+                                    , double swap_time, double fade_time)
+{
+    int axis_ind = axis-'x';
+    if (axis_ind < 0 || axis_ind >= ARRAY_SIZE(KIN_FLAGS))
+        return -1;
+    struct input_shaper *is = container_of(sk, struct input_shaper, sk);
+    // Ignore input shaper update if the axis is not active
+    if (!(is->orig_sk->active_flags & KIN_FLAGS[axis_ind]))
+        return 0;
+    struct pending_shaper *ps = &is->pending[axis_ind];
+    if (ps->pending) {
+        // A prior swap is still in flight - make it current first (any
+        // resulting step in the commanded position is within the
+        // smoothing of the shapers themselves)
+        is->sp[axis_ind] = ps->sp;
+        ps->pending = 0;
+    }
+    struct shaper_pulses sp;
+    int status = init_shaper(n, a, t, &sp);
+    if (status) {
+        shaper_note_generation_time(is);
+        return status;
+    }
+    if (fade_time <= 0.) {
+        struct shaper_pulses *osp = &is->sp[axis_ind];
+        if (osp->num_pulses)
+            fade_time = osp->pulses[osp->num_pulses-1].t - osp->pulses[0].t;
+        if (sp.num_pulses) {
+            double span = sp.pulses[sp.num_pulses-1].t - sp.pulses[0].t;
+            if (span > fade_time)
+                fade_time = span;
+        }
+        if (fade_time < .005)
+            fade_time = .005;
+    }
+    ps->sp = sp;
+    ps->fade_start = swap_time;
+    ps->fade_end = swap_time + fade_time;
+    ps->inv_fade = 1. / fade_time;
+    ps->pending = 1;
+    shaper_note_generation_time(is);
+    return 0;
+}
+
 struct stepper_kinematics * __visible
 input_shaper_alloc(void)
 {
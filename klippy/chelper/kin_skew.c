@@ -0,0 +1,119 @@
+// Printer skew correction applied during step generation
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <stddef.h> // offsetof
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "itersolve.h" // struct stepper_kinematics
+#include "trapq.h" // struct move
+
+#define DUMMY_T 500.0
+
+struct skew_correction {
+    struct stepper_kinematics sk;
+    struct stepper_kinematics *orig_sk;
+    struct move m;
+    double xy_factor, xz_comb_factor, yz_factor;
+};
+
+// Calculate a stepper position from the skew corrected axis positions
+static double
+skew_calc_position(struct stepper_kinematics *sk, struct move *m
+                   , double move_time)
+{
+    struct skew_correction *sc = container_of(
+        sk, struct skew_correction, sk);
+    if (!sc->xy_factor && !sc->xz_comb_factor && !sc->yz_factor)
+        return sc->orig_sk->calc_position_cb(sc->orig_sk, m, move_time);
+    struct coord coord = move_get_coord(m, move_time);
+    double *lc = sc->sk.lin_coeffs;
+    if (lc[0] || lc[1] || lc[2])
+        // Fast path - skew composed into the linear coefficients
+        return lc[0] * coord.x + lc[1] * coord.y + lc[2] * coord.z;
+    sc->m.start_pos.x = (coord.x - coord.y * sc->xy_factor
+                         - coord.z * sc->xz_comb_factor);
+    sc->m.start_pos.y = coord.y - coord.z * sc->yz_factor;
+    sc->m.start_pos.z = coord.z;
+    return sc->orig_sk->calc_position_cb(sc->orig_sk, &sc->m, DUMMY_T);
+}
+
+// A callback that forwards post_cb call to the original kinematics
+static void
+skew_commanded_pos_post_fixup(struct stepper_kinematics *sk)
+{
+    struct skew_correction *sc = container_of(
+        sk, struct skew_correction, sk);
+    sc->orig_sk->commanded_pos = sk->commanded_pos;
+    sc->orig_sk->post_cb(sc->orig_sk);
+    sk->commanded_pos = sc->orig_sk->commanded_pos;
+}
+
+// Update active flags and composed linear coefficients
+static void
+skew_update_sk(struct skew_correction *sc)
+{
+    struct stepper_kinematics *orig_sk = sc->orig_sk;
+    int flags = orig_sk->active_flags;
+    if (flags & AF_X) {
+        if (sc->xy_factor)
+            flags |= AF_Y;
+        if (sc->xz_comb_factor)
+            flags |= AF_Z;
+    }
+    if ((flags & AF_Y) && sc->yz_factor)
+        flags |= AF_Z;
+    sc->sk.active_flags = flags;
+    // Compose the skew into the linear coefficients (when the original
+    // kinematics are linear) so outer wrappers such as the input
+    // shaper can continue to use their fused linear position path
+    double cx = orig_sk->lin_coeffs[0], cy = orig_sk->lin_coeffs[1];
+    double cz = orig_sk->lin_coeffs[2];
+    sc->sk.lin_coeffs[0] = cx;
+    sc->sk.lin_coeffs[1] = cy - cx * sc->xy_factor;
+    sc->sk.lin_coeffs[2] = cz - cx * sc->xz_comb_factor - cy * sc->yz_factor;
+}
+
+int __visible
+skew_correction_set_sk(struct stepper_kinematics *sk
+                       , struct stepper_kinematics *orig_sk)
+{
+    struct skew_correction *sc = container_of(
+        sk, struct skew_correction, sk);
+    if (!(orig_sk->active_flags & (AF_X | AF_Y)))
+        // Skew does not alter the position of this stepper
+        return -1;
+    sc->sk.calc_position_cb = skew_calc_position;
+    sc->orig_sk = orig_sk;
+    sc->sk.commanded_pos = orig_sk->commanded_pos;
+    sc->sk.last_flush_time = orig_sk->last_flush_time;
+    sc->sk.last_move_time = orig_sk->last_move_time;
+    if (orig_sk->post_cb)
+        sc->sk.post_cb = skew_commanded_pos_post_fixup;
+    skew_update_sk(sc);
+    return 0;
+}
+
+void __visible
+skew_correction_set_params(struct stepper_kinematics *sk, double xy_factor
+                           , double xz_factor, double yz_factor)
+{
+    struct skew_correction *sc = container_of(
+        sk, struct skew_correction, sk);
+    sc->xy_factor = xy_factor;
+    sc->xz_comb_factor = xz_factor - xy_factor * yz_factor;
+    sc->yz_factor = yz_factor;
+    skew_update_sk(sc);
+}
+
+struct stepper_kinematics * __visible
+skew_correction_alloc(void)
+{
+    struct skew_correction *sc = malloc(sizeof(*sc));
+    memset(sc, 0, sizeof(*sc));
+    sc->m.move_t = 2. * DUMMY_T;
+    return &sc->sk;
+}
@@ -0,0 +1,116 @@
+// Kinematic move validation (axis range and boundary speed checks)
+//
+// Copyright (C) 2016-2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // sqrt
+#include "compiler.h" // __visible
+#include "kincheck.h" // struct kin_limits
+
+// Verify each moving axis stays within its homed range
+static int
+check_endstops(struct kin_limits *kl, double end_pos[3], double axes_d[3])
+{
+    int i;
+    for (i = 0; i < 3; i++) {
+        if (!axes_d[i])
+            continue;
+        if (end_pos[i] < kl->limits[i][0] || end_pos[i] > kl->limits[i][1]) {
+            if (kl->limits[i][0] > kl->limits[i][1])
+                return KC_MUST_HOME;
+            return KC_MOVE_ERROR;
+        }
+    }
+    return KC_OK;
+}
+
+// Validate a move on cartesian style kinematics.  A KC_LIMIT_SPEED
+// return indicates the caller must apply the returned velocity and
+// accel limits to the move.
+int __visible
+kincheck_cart_move(struct kin_limits *kl, double move_d
+                   , double start_x, double start_y, double start_z
+                   , double end_x, double end_y, double end_z
+                   , double *move_limits)
+{
+    double end_pos[3] = { end_x, end_y, end_z };
+    double axes_d[3] = { end_x - start_x, end_y - start_y, end_z - start_z };
+    if (end_x < kl->limits[0][0] || end_x > kl->limits[0][1]
+        || end_y < kl->limits[1][0] || end_y > kl->limits[1][1]) {
+        int ret = check_endstops(kl, end_pos, axes_d);
+        if (ret)
+            return ret;
+    }
+    if (!axes_d[2])
+        // Normal XY move - use defaults
+        return KC_OK;
+    // Move with Z - update velocity and accel for slower Z axis
+    int ret = check_endstops(kl, end_pos, axes_d);
+    if (ret)
+        return ret;
+    double z_ratio = move_d / fabs(axes_d[2]);
+    move_limits[0] = kl->max_z_velocity * z_ratio;
+    move_limits[1] = kl->max_z_accel * z_ratio;
+    return KC_LIMIT_SPEED;
+}
+
+// Validate a move on linear delta kinematics
+int __visible
+kincheck_delta_move(struct kin_limits *kl, double move_d
+                    , double start_x, double start_y, double start_z
+                    , double end_x, double end_y, double end_z
+                    , double *move_limits)
+{
+    double end_xy2 = end_x*end_x + end_y*end_y;
+    double dz = end_z - start_z;
+    if (end_xy2 <= kl->limit_xy2 && !dz)
+        // Normal XY move
+        return KC_OK;
+    if (kl->need_home)
+        return KC_MUST_HOME;
+    double limit_xy2 = kl->max_xy2;
+    if (end_z > kl->limit_z) {
+        // Radius tapers as the effector rises above the taper height
+        double above_z_limit = end_z - kl->limit_z;
+        double arm_xy = kl->min_arm_length - above_z_limit;
+        double allowed_radius = kl->radius - sqrt(kl->min_arm2 - arm_xy*arm_xy);
+        limit_xy2 = fmin(limit_xy2, allowed_radius * allowed_radius);
+    }
+    if (end_xy2 > limit_xy2 || end_z > kl->max_z || end_z < kl->min_z) {
+        // Move out of range - verify not a homing move
+        if (end_x != kl->home_x || end_y != kl->home_y
+            || end_z < kl->min_z || end_z > kl->home_z)
+            return KC_MOVE_ERROR;
+        limit_xy2 = -1.;
+    }
+    int ret = KC_OK;
+    double limit_v = 0., limit_a = 0.;
+    if (dz) {
+        double z_ratio = move_d / fabs(dz);
+        limit_v = kl->max_z_velocity * z_ratio;
+        limit_a = kl->max_z_accel * z_ratio;
+        ret = KC_LIMIT_SPEED;
+        limit_xy2 = -1.;
+    }
+    // Limit the speed/accel of this move if is is at the extreme
+    // end of the build envelope
+    double start_xy2 = start_x*start_x + start_y*start_y;
+    double extreme_xy2 = fmax(end_xy2, start_xy2);
+    if (extreme_xy2 > kl->slow_xy2) {
+        double r = extreme_xy2 > kl->very_slow_xy2 ? .25 : .5;
+        if (ret == KC_LIMIT_SPEED) {
+            limit_v = fmin(limit_v, kl->max_velocity * r);
+            limit_a = fmin(limit_a, kl->max_accel * r);
+        } else {
+            limit_v = kl->max_velocity * r;
+            limit_a = kl->max_accel * r;
+            ret = KC_LIMIT_SPEED;
+        }
+        limit_xy2 = -1.;
+    }
+    kl->limit_xy2 = fmin(limit_xy2, kl->slow_xy2);
+    move_limits[0] = limit_v;
+    move_limits[1] = limit_a;
+    return ret;
+}
@@ -0,0 +1,34 @@
+#ifndef KINCHECK_H
+#define KINCHECK_H
+
+struct kin_limits {
+    // Allowed travel on each axis (min > max means axis not homed)
+    double limits[3][2];
+    // Velocity and accel limits applied to moves with a Z component
+    double max_z_velocity, max_z_accel;
+    // Overall velocity limits (used by delta boundary slowdowns)
+    double max_velocity, max_accel;
+    // Delta limit geometry (precomputed by the delta kinematics)
+    int need_home;
+    double max_xy2, slow_xy2, very_slow_xy2;
+    double radius, min_arm2, min_arm_length;
+    double min_z, max_z, limit_z;
+    double home_x, home_y, home_z;
+    // Radius of the delta fast-path (maintained by kincheck_delta_move)
+    double limit_xy2;
+};
+
+enum {
+    KC_OK = 0, KC_LIMIT_SPEED = 1, KC_MOVE_ERROR = -1, KC_MUST_HOME = -2,
+};
+
+int kincheck_cart_move(struct kin_limits *kl, double move_d
+                       , double start_x, double start_y, double start_z
+                       , double end_x, double end_y, double end_z
+                       , double *move_limits);
+int kincheck_delta_move(struct kin_limits *kl, double move_d
+                        , double start_x, double start_y, double start_z
+                        , double end_x, double end_y, double end_z
+                        , double *move_limits);
+
+#endif // kincheck.h
@@ -0,0 +1,93 @@
+// Rendering of animated LED strip frames
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // sin
+#include <stdint.h> // uint8_t
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "ledframe.h" // led_frame_alloc
+
+struct led_frame {
+    int led_count, effect;
+    double rate, scale;
+    double color1[4], color2[4];
+    // Quantized copy of the last rendered frame (for dirty detection)
+    int have_prev;
+    uint8_t prev[];
+};
+
+// Allocate a frame renderer for a strip of led_count leds
+struct led_frame * __visible
+led_frame_alloc(int led_count)
+{
+    struct led_frame *lf = malloc(sizeof(*lf) + 4 * led_count);
+    memset(lf, 0, sizeof(*lf) + 4 * led_count);
+    lf->led_count = led_count;
+    lf->rate = lf->scale = 1.;
+    return lf;
+}
+
+// Select one of the LED_EFFECT_xxx animations
+void __visible
+led_frame_setup_effect(struct led_frame *lf, int effect, double rate
+                       , double scale, const double *color1
+                       , const double *color2)
+{
+    lf->effect = effect;
+    lf->rate = rate;
+    lf->scale = scale > 0. ? scale : 1.;
+    memcpy(lf->color1, color1, sizeof(lf->color1));
+    memcpy(lf->color2, color2, sizeof(lf->color2));
+    lf->have_prev = 0;
+}
+
+// Render one frame into (red, green, blue, white) rows.  Returns 1 if
+// the frame differs from the previously rendered frame.
+int __visible
+led_frame_render(struct led_frame *lf, double time, double progress
+                 , double *out)
+{
+    int count = lf->led_count, i, j;
+    double phase = time * lf->rate;
+    for (i = 0; i < count; i++) {
+        // Determine blend factor (0.0 is color2, 1.0 is color1)
+        double blend;
+        if (lf->effect == LED_EFFECT_GRADIENT) {
+            // Sine gradient of 'scale' waves scrolling along the strip
+            blend = .5 + .5*sin(2.*M_PI * (phase + i*lf->scale/count));
+        } else if (lf->effect == LED_EFFECT_CHASE) {
+            // Pulse of 'scale' leds circling the strip
+            double pos = (phase - floor(phase)) * count;
+            double dist = fabs(i - pos);
+            if (count - dist < dist)
+                dist = count - dist;
+            blend = 1. - dist/lf->scale;
+            if (blend < 0.)
+                blend = 0.;
+        } else if (lf->effect == LED_EFFECT_BREATHE) {
+            // Whole strip fading between the two colors
+            blend = .5 - .5*cos(2.*M_PI * phase);
+        } else {
+            // Fill the first 'progress' fraction of the strip
+            blend = progress*count - i;
+            blend = blend < 0. ? 0. : (blend > 1. ? 1. : blend);
+        }
+        double *row = &out[4 * i];
+        for (j = 0; j < 4; j++)
+            row[j] = lf->color2[j] + (lf->color1[j] - lf->color2[j])*blend;
+    }
+    // Report if the frame changed (at 8 bit resolution)
+    int dirty = !lf->have_prev;
+    for (i = 0; i < 4 * count; i++) {
+        uint8_t q = out[i] * 255. + .5;
+        if (q != lf->prev[i])
+            dirty = 1;
+        lf->prev[i] = q;
+    }
+    lf->have_prev = 1;
+    return dirty;
+}
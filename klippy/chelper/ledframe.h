@@ -0,0 +1,16 @@
+#ifndef LEDFRAME_H
+#define LEDFRAME_H
+
+enum {
+    LED_EFFECT_GRADIENT = 0, LED_EFFECT_CHASE = 1,
+    LED_EFFECT_BREATHE = 2, LED_EFFECT_PROGRESS = 3,
+};
+
+struct led_frame *led_frame_alloc(int led_count);
+void led_frame_setup_effect(struct led_frame *lf, int effect, double rate
+                            , double scale, const double *color1
+                            , const double *color2);
+int led_frame_render(struct led_frame *lf, double time, double progress
+                     , double *out);
+
+#endif // ledframe.h
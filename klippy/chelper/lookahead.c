@@ -0,0 +1,121 @@
+// Move queue "look-ahead" junction speed calculations
+//
+// Copyright (C) 2016-2025  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // sqrt
+#include "compiler.h" // __visible
+#include "lookahead.h" // struct lookahead_move
+
+// Find maximum junction speed between two moves using "approximated
+// centripetal velocity".  Returns the junction speed limit (squared).
+double __visible
+lookahead_calc_junction(double prev_axes_r_x, double prev_axes_r_y
+                        , double prev_axes_r_z, double axes_r_x
+                        , double axes_r_y, double axes_r_z
+                        , double jd_accel, double prev_jd_accel
+                        , double delta_v2, double prev_delta_v2
+                        , double max_start_v2)
+{
+    double junction_cos_theta = -(axes_r_x * prev_axes_r_x
+                                  + axes_r_y * prev_axes_r_y
+                                  + axes_r_z * prev_axes_r_z);
+    double sin_theta_d2 = sqrt(fmax(.5*(1.0-junction_cos_theta), 0.));
+    double cos_theta_d2 = sqrt(fmax(.5*(1.0+junction_cos_theta), 0.));
+    double one_minus_sin_theta_d2 = 1. - sin_theta_d2;
+    if (one_minus_sin_theta_d2 > 0. && cos_theta_d2 > 0.) {
+        double R_jd = sin_theta_d2 / one_minus_sin_theta_d2;
+        double move_jd_v2 = R_jd * jd_accel;
+        double pmove_jd_v2 = R_jd * prev_jd_accel;
+        // Approximated circle must contact moves no further than mid-move
+        double quarter_tan_theta_d2 = .25 * sin_theta_d2 / cos_theta_d2;
+        double move_centripetal_v2 = delta_v2 * quarter_tan_theta_d2;
+        double pmove_centripetal_v2 = prev_delta_v2 * quarter_tan_theta_d2;
+        max_start_v2 = fmin(max_start_v2, fmin(
+            fmin(move_jd_v2, pmove_jd_v2)
+            , fmin(move_centripetal_v2, pmove_centripetal_v2)));
+    }
+    return max_start_v2;
+}
+
+// Determine the start, cruise, and end velocities of a move along with
+// the time spent in each portion of the move
+static void
+set_junction(struct lookahead_move *m, double start_v2, double cruise_v2
+             , double end_v2)
+{
+    // Determine accel, cruise, and decel portions of the move distance
+    double half_inv_accel = .5 / m->accel;
+    double accel_d = (cruise_v2 - start_v2) * half_inv_accel;
+    double decel_d = (cruise_v2 - end_v2) * half_inv_accel;
+    double cruise_d = m->move_d - accel_d - decel_d;
+    // Determine move velocities
+    double start_v = m->start_v = sqrt(start_v2);
+    double cruise_v = m->cruise_v = sqrt(cruise_v2);
+    double end_v = m->end_v = sqrt(end_v2);
+    // Determine time spent in each portion of move (time is the
+    // distance divided by average velocity)
+    m->accel_t = accel_d / ((start_v + cruise_v) * .5);
+    m->cruise_t = cruise_d / cruise_v;
+    m->decel_t = decel_d / ((end_v + cruise_v) * .5);
+}
+
+// Determine junction speeds for the pending moves.  Returns the number
+// of moves ready to be processed (zero on a lazy flush that has not yet
+// found a speed "peak" in the queue).
+int __visible
+lookahead_flush(struct lookahead_move *moves, int count, int lazy)
+{
+    int update_flush_count = lazy, flush_count = count, i;
+    // Traverse queue from last to first move and determine maximum
+    // junction speed assuming the robot comes to a complete stop
+    // after the last move.
+    double next_start_v2 = 0., next_mcr_start_v2 = 0., peak_cruise_v2 = 0.;
+    int pending_cv2_assign = 0;
+    for (i = count - 1; i >= 0; i--) {
+        struct lookahead_move *m = &moves[i];
+        double reachable_start_v2 = next_start_v2 + m->delta_v2;
+        double start_v2 = fmin(m->max_start_v2, reachable_start_v2);
+        double cruise_v2 = -1.;
+        pending_cv2_assign++;
+        double reach_mcr_start_v2 = next_mcr_start_v2 + m->mcr_delta_v2;
+        double mcr_start_v2 = fmin(m->max_mcr_start_v2, reach_mcr_start_v2);
+        if (mcr_start_v2 < reach_mcr_start_v2) {
+            // It's possible for this move to accelerate
+            if (mcr_start_v2 + m->mcr_delta_v2 > next_mcr_start_v2
+                || pending_cv2_assign > 1) {
+                // This move can both accel and decel, or this is a
+                // full accel move followed by a full decel move
+                if (update_flush_count && peak_cruise_v2) {
+                    flush_count = i + pending_cv2_assign;
+                    update_flush_count = 0;
+                }
+                peak_cruise_v2 = (mcr_start_v2 + reach_mcr_start_v2) * .5;
+            }
+            cruise_v2 = fmin(fmin((start_v2 + reachable_start_v2) * .5
+                                  , m->max_cruise_v2), peak_cruise_v2);
+            pending_cv2_assign = 0;
+        }
+        m->c_start_v2 = start_v2;
+        m->c_cruise_v2 = cruise_v2;
+        m->c_next_start_v2 = next_start_v2;
+        next_start_v2 = start_v2;
+        next_mcr_start_v2 = mcr_start_v2;
+    }
+    if (update_flush_count || !flush_count)
+        return 0;
+    // Traverse queue in forward direction to propagate cruise_v2
+    double prev_cruise_v2 = 0.;
+    for (i = 0; i < flush_count; i++) {
+        struct lookahead_move *m = &moves[i];
+        double cruise_v2 = m->c_cruise_v2;
+        if (cruise_v2 < 0.)
+            // This move can't accelerate - propagate cruise_v2 from previous
+            cruise_v2 = fmin(prev_cruise_v2, m->c_start_v2);
+        set_junction(m, fmin(m->c_start_v2, cruise_v2), cruise_v2
+                     , fmin(m->c_next_start_v2, cruise_v2));
+        prev_cruise_v2 = cruise_v2;
+    }
+    return flush_count;
+}
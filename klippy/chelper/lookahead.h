@@ -0,0 +1,27 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+struct lookahead_move {
+    // Input fields (filled by the host when a move is queued)
+    double move_d, accel;
+    double max_start_v2, max_cruise_v2, delta_v2;
+    double max_mcr_start_v2, mcr_delta_v2;
+    double start_x, start_y, start_z;
+    double x_r, y_r, z_r;
+    int is_kinematic;
+    // Output fields (filled by lookahead_flush)
+    double start_v, cruise_v, end_v;
+    double accel_t, cruise_t, decel_t;
+    // Internal scratch (backward pass results)
+    double c_start_v2, c_cruise_v2, c_next_start_v2;
+};
+
+double lookahead_calc_junction(double prev_axes_r_x, double prev_axes_r_y
+                               , double prev_axes_r_z, double axes_r_x
+                               , double axes_r_y, double axes_r_z
+                               , double jd_accel, double prev_jd_accel
+                               , double delta_v2, double prev_delta_v2
+                               , double max_start_v2);
+int lookahead_flush(struct lookahead_move *moves, int count, int lazy);
+
+#endif // lookahead.h
@@ -17,6 +17,9 @@
 #define MESSAGE_DEST 0x10
 #define MESSAGE_SYNC 0x7E
 
+// Maximum move queue slots trackable per command via move_offsets
+#define QM_MAX_MOVES 16
+
 struct queue_message {
     int len;
     uint8_t msg[MESSAGE_MAX];
@@ -24,12 +27,22 @@ struct queue_message {
         // Filled when on a command queue
         struct {
             uint64_t min_clock, req_clock;
+            // Number of mcu move queue slots the command consumes
+            // (zero is treated as one slot)
+            int num_moves;
+            // Clock ticks between successive slot releases - the mcu
+            // frees slot i only once run i-1 completes.  A uniform
+            // stride (queue_step_repeat), or zero with explicit per
+            // slot offsets from min_clock (queue_step_pack)
+            uint32_t move_stride;
+            uint32_t move_offsets[QM_MAX_MOVES];
         };
         // Filled when in sent/receive queues
         struct {
             double sent_time, receive_time;
         };
     };
+    double queued_time;
     uint64_t notify_id;
     struct list_node node;
 };
@@ -41,11 +54,13 @@ struct clock_estimate {
 
 uint16_t msgblock_crc16_ccitt(uint8_t *buf, uint8_t len);
 int msgblock_check(uint8_t *need_sync, uint8_t *buf, int buf_len);
+uint8_t *msgblock_encode_int(uint8_t *p, uint32_t v);
 int msgblock_decode(uint32_t *data, int data_len, uint8_t *msg, int msg_len);
 struct queue_message *message_alloc(void);
 struct queue_message *message_fill(uint8_t *data, int len);
 struct queue_message *message_alloc_and_encode(uint32_t *data, int len);
 void message_free(struct queue_message *qm);
+int message_pool_occupancy(void);
 void message_queue_free(struct list_head *root);
 uint64_t clock_from_clock32(struct clock_estimate *ce, uint32_t clock32);
 double clock_to_time(struct clock_estimate *ce, uint64_t clock);
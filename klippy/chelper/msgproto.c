@@ -0,0 +1,144 @@
+// Micro-controller message parsing and encoding
+//
+// Copyright (C) 2016-2025  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <stdlib.h> // malloc
+#include <string.h> // memcpy
+#include "compiler.h" // __visible
+#include "msgproto.h" // struct mp_value
+
+// Message parameter types (mirrors msgproto.py MessageTypes)
+enum {
+    MP_UINT32, MP_INT32, MP_UINT16, MP_INT16, MP_BYTE, MP_STRING
+};
+
+#define MAX_MSGID_BYTES 8
+
+// Compiled parse/encode description of a message format
+struct mp_format {
+    int num_msgid_bytes, num_params;
+    uint8_t msgid_bytes[MAX_MSGID_BYTES];
+    uint8_t param_types[0];
+};
+
+// Allocate a message format description (freed with free())
+struct mp_format * __visible
+msgproto_format_alloc(const char *msgid_bytes, int num_msgid_bytes
+                      , const char *param_types, int num_params)
+{
+    if (num_msgid_bytes > MAX_MSGID_BYTES)
+        return NULL;
+    struct mp_format *mf = malloc(sizeof(*mf) + num_params);
+    if (!mf)
+        return NULL;
+    mf->num_msgid_bytes = num_msgid_bytes;
+    mf->num_params = num_params;
+    memcpy(mf->msgid_bytes, msgid_bytes, num_msgid_bytes);
+    memcpy(mf->param_types, param_types, num_params);
+    return mf;
+}
+
+// Parse a variable length quantity integer
+static int
+parse_vlq(const uint8_t *data, int len, int pos, int64_t *pv)
+{
+    if (pos >= len)
+        return -1;
+    uint8_t c = data[pos++];
+    int64_t v = c & 0x7f;
+    if ((c & 0x60) == 0x60)
+        v |= -0x20;
+    while (c & 0x80) {
+        if (pos >= len)
+            return -1;
+        c = data[pos++];
+        v = (v << 7) | (c & 0x7f);
+    }
+    *pv = v;
+    return pos;
+}
+
+// Parse the parameters of a message.  String parameters are reported
+// as a position and length within the message data.  Returns the
+// position after the last parameter (or -1 on a malformed message).
+int __visible
+msgproto_parse(struct mp_format *mf, const char *data, int len
+               , int pos, struct mp_value *values)
+{
+    const uint8_t *d = (const uint8_t *)data;
+    pos += mf->num_msgid_bytes;
+    int i;
+    for (i = 0; i < mf->num_params; i++) {
+        struct mp_value *mv = &values[i];
+        uint8_t ptype = mf->param_types[i];
+        if (ptype == MP_STRING) {
+            if (pos >= len)
+                return -1;
+            int l = d[pos];
+            if (pos + l + 1 > len)
+                return -1;
+            mv->spos = pos + 1;
+            mv->slen = l;
+            pos += l + 1;
+        } else {
+            int64_t v;
+            pos = parse_vlq(d, len, pos, &v);
+            if (pos < 0)
+                return -1;
+            if (ptype != MP_INT32 && ptype != MP_INT16)
+                v &= 0xffffffff;
+            mv->iv = v;
+        }
+    }
+    return pos;
+}
+
+// Encode an integer as a variable length quantity
+static int
+encode_vlq(uint8_t *buf, int pos, int64_t v)
+{
+    if (v >= 0xc000000 || v < -0x4000000)
+        buf[pos++] = ((v>>28) & 0x7f) | 0x80;
+    if (v >= 0x180000 || v < -0x80000)
+        buf[pos++] = ((v>>21) & 0x7f) | 0x80;
+    if (v >= 0x3000 || v < -0x1000)
+        buf[pos++] = ((v>>14) & 0x7f) | 0x80;
+    if (v >= 0x60 || v < -0x20)
+        buf[pos++] = ((v>>7) & 0x7f) | 0x80;
+    buf[pos++] = v & 0x7f;
+    return pos;
+}
+
+// Encode the message id and integer parameters of a message.  The
+// caller must provide a buffer with room for the encoded message.
+// Returns the number of bytes written.
+int __visible
+msgproto_encode(struct mp_format *mf, char *buf, struct mp_value *values)
+{
+    uint8_t *b = (uint8_t *)buf;
+    memcpy(b, mf->msgid_bytes, mf->num_msgid_bytes);
+    int pos = mf->num_msgid_bytes, i;
+    for (i = 0; i < mf->num_params; i++)
+        pos = encode_vlq(b, pos, values[i].iv);
+    return pos;
+}
+
+// As above, but taking the parameters from a flat integer array
+int
+msgproto_encode_ints(struct mp_format *mf, uint8_t *buf, int64_t *params)
+{
+    memcpy(buf, mf->msgid_bytes, mf->num_msgid_bytes);
+    int pos = mf->num_msgid_bytes, i;
+    for (i = 0; i < mf->num_params; i++)
+        pos = encode_vlq(buf, pos, params[i]);
+    return pos;
+}
+
+// Return the number of parameters in a message format
+int
+msgproto_format_num_params(struct mp_format *mf)
+{
+    return mf->num_params;
+}
@@ -0,0 +1,21 @@
+#ifndef MSGPROTO_H
+#define MSGPROTO_H
+
+#include <stdint.h> // int64_t
+
+struct mp_value {
+    int64_t iv;
+    int32_t spos, slen;
+};
+
+struct mp_format *msgproto_format_alloc(const char *msgid_bytes
+                                        , int num_msgid_bytes
+                                        , const char *param_types
+                                        , int num_params);
+int msgproto_parse(struct mp_format *mf, const char *data, int len
+                   , int pos, struct mp_value *values);
+int msgproto_encode(struct mp_format *mf, char *buf, struct mp_value *values);
+int msgproto_encode_ints(struct mp_format *mf, uint8_t *buf, int64_t *params);
+int msgproto_format_num_params(struct mp_format *mf);
+
+#endif // msgproto.h
@@ -4,14 +4,29 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include <errno.h> // EINTR
 #include <fcntl.h> // fcntl
 #include <math.h> // ceil
 #include <poll.h> // poll
+#include <stdint.h> // uintptr_t
 #include <stdlib.h> // malloc
 #include <string.h> // memset
+#include <sys/epoll.h> // epoll_create1
+#include <sys/timerfd.h> // timerfd_create
+#include <unistd.h> // close
 #include "pollreactor.h" // pollreactor_alloc
 #include "pyhelper.h" // report_errno
 
+// Use the io_uring backend where the kernel headers provide it - the
+// ring is probed at runtime and poll() remains the fallback
+#if defined(__has_include) && __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#include <linux/io_uring.h> // struct io_uring_params
+#include <sys/mman.h> // mmap
+#include <sys/syscall.h> // __NR_io_uring_setup
+#include <unistd.h> // syscall
+#endif
+
 struct pollreactor_timer {
     double waketime;
     double (*callback)(void *data, double eventtime);
@@ -24,8 +39,150 @@ struct pollreactor {
     struct pollfd *fds;
     void (**fd_callbacks)(void *data, double eventtime);
     struct pollreactor_timer *timers;
+    // epoll backend (epoll_fd is negative when using the poll() backend)
+    int epoll_fd, timer_fd;
+    double timerfd_deadline;
+#if HAVE_IO_URING
+    // io_uring state (ring_fd is negative when using the poll() backend)
+    int ring_fd;
+    void *sq_ring, *sqes;
+    size_t sq_ring_size, sqes_size;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    int *fd_armed;
+    struct __kernel_timespec ring_ts;
+#endif
 };
 
+#if HAVE_IO_URING
+
+// Completion marker for the kernel-side wakeup timeout
+#define URING_UD_TIMEOUT ((uint64_t)-1)
+
+// Attempt to create an io_uring instance (silently ignore failures)
+static void
+pollreactor_uring_setup(struct pollreactor *pr)
+{
+    pr->ring_fd = -1;
+    unsigned entries = 16;
+    if (pr->num_fds + 2 > entries)
+        return;
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0)
+        return;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        close(fd);
+        return;
+    }
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+    pr->sq_ring_size = sq_size > cq_size ? sq_size : cq_size;
+    pr->sq_ring = mmap(NULL, pr->sq_ring_size, PROT_READ|PROT_WRITE
+                       , MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (pr->sq_ring == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    pr->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    pr->sqes = mmap(NULL, pr->sqes_size, PROT_READ|PROT_WRITE
+                    , MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (pr->sqes == MAP_FAILED) {
+        munmap(pr->sq_ring, pr->sq_ring_size);
+        close(fd);
+        return;
+    }
+    pr->sq_head = pr->sq_ring + p.sq_off.head;
+    pr->sq_tail = pr->sq_ring + p.sq_off.tail;
+    pr->sq_mask = pr->sq_ring + p.sq_off.ring_mask;
+    pr->sq_array = pr->sq_ring + p.sq_off.array;
+    pr->cq_head = pr->sq_ring + p.cq_off.head;
+    pr->cq_tail = pr->sq_ring + p.cq_off.tail;
+    pr->cq_mask = pr->sq_ring + p.cq_off.ring_mask;
+    pr->cqes = pr->sq_ring + p.cq_off.cqes;
+    pr->fd_armed = malloc(pr->num_fds * sizeof(*pr->fd_armed));
+    memset(pr->fd_armed, 0, pr->num_fds * sizeof(*pr->fd_armed));
+    pr->ring_fd = fd;
+}
+
+// Release io_uring resources
+static void
+pollreactor_uring_free(struct pollreactor *pr)
+{
+    if (pr->ring_fd < 0)
+        return;
+    munmap(pr->sqes, pr->sqes_size);
+    munmap(pr->sq_ring, pr->sq_ring_size);
+    close(pr->ring_fd);
+    pr->ring_fd = -1;
+    free(pr->fd_armed);
+    pr->fd_armed = NULL;
+}
+
+// Claim the next submission queue entry (the caller bounds usage)
+static struct io_uring_sqe *
+pollreactor_uring_sqe(struct pollreactor *pr)
+{
+    unsigned tail = *pr->sq_tail, idx = tail & *pr->sq_mask;
+    struct io_uring_sqe *sqe = &((struct io_uring_sqe *)pr->sqes)[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    pr->sq_array[idx] = idx;
+    __atomic_store_n(pr->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+#endif // HAVE_IO_URING
+
+// The timerfd is registered in the epoll set with this marker
+#define EPOLL_UD_TIMERFD ((uint32_t)-1)
+// Maximum events dispatched per epoll_wait() call
+#define EPOLL_EVENTS_MAX 16
+
+// Attempt to create an epoll set with a timerfd for timer deadlines
+static void
+pollreactor_epoll_setup(struct pollreactor *pr)
+{
+    pr->epoll_fd = pr->timer_fd = -1;
+    int efd = epoll_create1(EPOLL_CLOEXEC);
+    if (efd < 0)
+        return;
+    // The timer deadlines are in the get_monotonic() timebase
+    // (CLOCK_MONOTONIC_RAW) which a timerfd can not be created on, so
+    // the timerfd is armed with relative intervals instead.  The ppm
+    // scale drift between the clocks is harmless over those intervals.
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {
+        close(efd);
+        return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = EPOLL_UD_TIMERFD;
+    int ret = epoll_ctl(efd, EPOLL_CTL_ADD, tfd, &ev);
+    if (ret < 0) {
+        close(tfd);
+        close(efd);
+        return;
+    }
+    pr->epoll_fd = efd;
+    pr->timer_fd = tfd;
+    pr->timerfd_deadline = 0.;
+}
+
+// Release epoll backend resources
+static void
+pollreactor_epoll_free(struct pollreactor *pr)
+{
+    if (pr->epoll_fd < 0)
+        return;
+    close(pr->timer_fd);
+    close(pr->epoll_fd);
+    pr->epoll_fd = pr->timer_fd = -1;
+}
+
 // Allocate a new 'struct pollreactor' object
 struct pollreactor *
 pollreactor_alloc(int num_fds, int num_timers, void *callback_data)
@@ -46,6 +203,13 @@ pollreactor_alloc(int num_fds, int num_timers, void *callback_data)
     int i;
     for (i=0; i<num_timers; i++)
         pr->timers[i].waketime = PR_NEVER;
+    pr->epoll_fd = pr->timer_fd = -1;
+#if HAVE_IO_URING
+    pollreactor_uring_setup(pr);
+    if (pr->ring_fd >= 0)
+        return pr;
+#endif
+    pollreactor_epoll_setup(pr);
     return pr;
 }
 
@@ -53,6 +217,10 @@ pollreactor_alloc(int num_fds, int num_timers, void *callback_data)
 void
 pollreactor_free(struct pollreactor *pr)
 {
+#if HAVE_IO_URING
+    pollreactor_uring_free(pr);
+#endif
+    pollreactor_epoll_free(pr);
     free(pr->fds);
     pr->fds = NULL;
     free(pr->fd_callbacks);
@@ -71,6 +239,20 @@ pollreactor_add_fd(struct pollreactor *pr, int pos, int fd, void *callback
     pr->fds[pos].events = POLLHUP | (write_only ? 0 : POLLIN);
     pr->fds[pos].revents = 0;
     pr->fd_callbacks[pos] = callback;
+    if (pr->epoll_fd >= 0 && fd >= 0) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLHUP | (write_only ? 0 : EPOLLIN);
+        ev.data.u32 = pos;
+        int ret = epoll_ctl(pr->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        if (ret < 0) {
+            if (errno == EPERM)
+                // Regular file (debug output) - fall back to poll()
+                pollreactor_epoll_free(pr);
+            else
+                report_errno("epoll_ctl add", ret);
+        }
+    }
 }
 
 // Add a timer callback
@@ -124,10 +306,140 @@ pollreactor_check_timers(struct pollreactor *pr, double eventtime, int busy)
     return timeout < 1. ? 1 : (timeout > 1000. ? 1000 : (int)timeout);
 }
 
+#if HAVE_IO_URING
+
+// Main event loop using io_uring for fd readiness and timeouts
+static void
+pollreactor_uring_run(struct pollreactor *pr)
+{
+    double eventtime = get_monotonic();
+    int busy = 1;
+    while (! pr->must_exit) {
+        int timeout = pollreactor_check_timers(pr, eventtime, busy);
+        busy = 0;
+        // Arm a one-shot poll request on each fd lacking one
+        unsigned to_submit = 0;
+        int i;
+        for (i=0; i<pr->num_fds; i++) {
+            if (pr->fd_armed[i] || !pr->fd_callbacks[i] || pr->fds[i].fd < 0)
+                continue;
+            struct io_uring_sqe *sqe = pollreactor_uring_sqe(pr);
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = pr->fds[i].fd;
+            sqe->poll_events = pr->fds[i].events;
+            sqe->user_data = i;
+            pr->fd_armed[i] = 1;
+            to_submit++;
+        }
+        // Kernel-side wakeup at the next timer deadline (the count of
+        // one makes any other completion also complete the timeout)
+        pr->ring_ts.tv_sec = timeout / 1000;
+        pr->ring_ts.tv_nsec = (timeout % 1000) * 1000000L;
+        struct io_uring_sqe *sqe = pollreactor_uring_sqe(pr);
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->addr = (uintptr_t)&pr->ring_ts;
+        sqe->len = 1;
+        sqe->off = 1;
+        sqe->user_data = URING_UD_TIMEOUT;
+        to_submit++;
+        int ret = syscall(__NR_io_uring_enter, pr->ring_fd, to_submit, 1
+                          , IORING_ENTER_GETEVENTS, NULL, 0);
+        eventtime = get_monotonic();
+        if (ret < 0 && errno != EINTR) {
+            report_errno("io_uring_enter", ret);
+            pr->must_exit = 1;
+            break;
+        }
+        // Dispatch fd completions
+        unsigned head = *pr->cq_head;
+        unsigned tail = __atomic_load_n(pr->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &pr->cqes[head & *pr->cq_mask];
+            if (cqe->user_data != URING_UD_TIMEOUT) {
+                busy = 1;
+                int pos = cqe->user_data;
+                pr->fd_armed[pos] = 0;
+                pr->fd_callbacks[pos](pr->callback_data, eventtime);
+            }
+            __atomic_store_n(pr->cq_head, head + 1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+#endif // HAVE_IO_URING
+
+// Main event loop using epoll for fd readiness and a timerfd for
+// sub-millisecond timer deadlines
+static void
+pollreactor_epoll_run(struct pollreactor *pr)
+{
+    double eventtime = get_monotonic();
+    int busy = 1;
+    while (! pr->must_exit) {
+        int timeout = pollreactor_check_timers(pr, eventtime, busy);
+        busy = 0;
+        if (timeout) {
+            // Rearm the timerfd if the wakeup deadline has changed
+            double deadline = pr->next_timer;
+            if (deadline > eventtime + 1.0)
+                deadline = eventtime + 1.0;
+            if (deadline != pr->timerfd_deadline) {
+                double delta = deadline - eventtime;
+                struct itimerspec its;
+                memset(&its, 0, sizeof(its));
+                its.it_value.tv_sec = (time_t)delta;
+                its.it_value.tv_nsec = (delta - (time_t)delta) * 1000000000.;
+                if (!its.it_value.tv_sec && !its.it_value.tv_nsec)
+                    its.it_value.tv_nsec = 1;
+                int ret = timerfd_settime(pr->timer_fd, 0, &its, NULL);
+                if (ret < 0)
+                    report_errno("timerfd_settime", ret);
+                pr->timerfd_deadline = deadline;
+            }
+        }
+        struct epoll_event events[EPOLL_EVENTS_MAX];
+        int ret = epoll_wait(pr->epoll_fd, events, EPOLL_EVENTS_MAX
+                             , timeout ? -1 : 0);
+        eventtime = get_monotonic();
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            report_errno("epoll_wait", ret);
+            pr->must_exit = 1;
+            break;
+        }
+        int i;
+        for (i=0; i<ret; i++) {
+            uint32_t pos = events[i].data.u32;
+            if (pos == EPOLL_UD_TIMERFD) {
+                // Timer deadline reached - drain and force a rearm
+                uint64_t ticks;
+                int rret = read(pr->timer_fd, &ticks, sizeof(ticks));
+                if (rret < 0 && errno != EAGAIN)
+                    report_errno("timerfd read", rret);
+                pr->timerfd_deadline = 0.;
+            } else {
+                busy = 1;
+                pr->fd_callbacks[pos](pr->callback_data, eventtime);
+            }
+        }
+    }
+}
+
 // Repeatedly check for timer and fd events and invoke their callbacks
 void
 pollreactor_run(struct pollreactor *pr)
 {
+#if HAVE_IO_URING
+    if (pr->ring_fd >= 0) {
+        pollreactor_uring_run(pr);
+        return;
+    }
+#endif
+    if (pr->epoll_fd >= 0) {
+        pollreactor_epoll_run(pr);
+        return;
+    }
     double eventtime = get_monotonic();
     int busy = 1;
     while (! pr->must_exit) {
@@ -0,0 +1,211 @@
+// Point containment tests on a set of 2d polygons
+//
+// Copyright (C) 2025  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // ceil, sqrt
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+#include "polygonset.h" // polygonset_alloc
+
+#define GRID_MAX_DIM 64
+
+struct polygon {
+    int num_points;
+    double *points;
+    double min_x, max_x, min_y, max_y;
+};
+
+struct polygonset {
+    int num_polys, polys_alloc;
+    struct polygon *polys;
+    // Uniform grid index (rebuilt lazily after polygons are added)
+    int built, grid_x, grid_y;
+    double grid_min_x, grid_min_y, cell_width, cell_height;
+    int *cell_start, *candidates;
+};
+
+// Allocate a new polygonset object
+struct polygonset * __visible
+polygonset_alloc(void)
+{
+    struct polygonset *ps = malloc(sizeof(*ps));
+    memset(ps, 0, sizeof(*ps));
+    return ps;
+}
+
+// Free memory associated with a polygonset object
+void __visible
+polygonset_free(struct polygonset *ps)
+{
+    int i;
+    for (i = 0; i < ps->num_polys; i++)
+        free(ps->polys[i].points);
+    free(ps->polys);
+    free(ps->cell_start);
+    free(ps->candidates);
+    free(ps);
+}
+
+// Add a polygon (flattened x,y pairs); returns its index or -1 on error
+int __visible
+polygonset_add(struct polygonset *ps, const double *points, int num_points)
+{
+    if (num_points < 3)
+        return -1;
+    if (ps->num_polys >= ps->polys_alloc) {
+        int alloc = ps->polys_alloc ? 2 * ps->polys_alloc : 8;
+        struct polygon *np = malloc(alloc * sizeof(*np));
+        memcpy(np, ps->polys, ps->num_polys * sizeof(*np));
+        free(ps->polys);
+        ps->polys = np;
+        ps->polys_alloc = alloc;
+    }
+    struct polygon *p = &ps->polys[ps->num_polys];
+    p->num_points = num_points;
+    p->points = malloc(2 * num_points * sizeof(double));
+    memcpy(p->points, points, 2 * num_points * sizeof(double));
+    p->min_x = p->max_x = points[0];
+    p->min_y = p->max_y = points[1];
+    int i;
+    for (i = 1; i < num_points; i++) {
+        double x = points[2*i], y = points[2*i + 1];
+        if (x < p->min_x)
+            p->min_x = x;
+        if (x > p->max_x)
+            p->max_x = x;
+        if (y < p->min_y)
+            p->min_y = y;
+        if (y > p->max_y)
+            p->max_y = y;
+    }
+    ps->built = 0;
+    return ps->num_polys++;
+}
+
+// Even-odd rule point in polygon test
+static int
+point_in_polygon(const struct polygon *p, double x, double y)
+{
+    if (x < p->min_x || x > p->max_x || y < p->min_y || y > p->max_y)
+        return 0;
+    int inside = 0, i, j, n = p->num_points;
+    for (i = 0, j = n - 1; i < n; j = i++) {
+        double xi = p->points[2*i], yi = p->points[2*i + 1];
+        double xj = p->points[2*j], yj = p->points[2*j + 1];
+        if ((yi > y) != (yj > y)
+            && x < (xj - xi) * (y - yi) / (yj - yi) + xi)
+            inside = !inside;
+    }
+    return inside;
+}
+
+// Build uniform grid of per-cell candidate polygon lists
+static void
+build_grid(struct polygonset *ps)
+{
+    free(ps->cell_start);
+    free(ps->candidates);
+    ps->cell_start = ps->candidates = NULL;
+    ps->built = 1;
+    if (!ps->num_polys)
+        return;
+    double min_x = ps->polys[0].min_x, max_x = ps->polys[0].max_x;
+    double min_y = ps->polys[0].min_y, max_y = ps->polys[0].max_y;
+    int i;
+    for (i = 1; i < ps->num_polys; i++) {
+        struct polygon *p = &ps->polys[i];
+        if (p->min_x < min_x)
+            min_x = p->min_x;
+        if (p->max_x > max_x)
+            max_x = p->max_x;
+        if (p->min_y < min_y)
+            min_y = p->min_y;
+        if (p->max_y > max_y)
+            max_y = p->max_y;
+    }
+    int dim = 2 * (int)ceil(sqrt(ps->num_polys));
+    if (dim > GRID_MAX_DIM)
+        dim = GRID_MAX_DIM;
+    ps->grid_x = ps->grid_y = dim;
+    ps->grid_min_x = min_x;
+    ps->grid_min_y = min_y;
+    ps->cell_width = (max_x - min_x) / dim;
+    ps->cell_height = (max_y - min_y) / dim;
+    if (ps->cell_width <= 0.)
+        ps->cell_width = 1.;
+    if (ps->cell_height <= 0.)
+        ps->cell_height = 1.;
+    // Count candidates per cell, then fill lists (CSR layout)
+    int num_cells = dim * dim;
+    int *counts = malloc((num_cells + 1) * sizeof(int));
+    memset(counts, 0, (num_cells + 1) * sizeof(int));
+    int pass;
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < ps->num_polys; i++) {
+            struct polygon *p = &ps->polys[i];
+            int cx0 = (p->min_x - min_x) / ps->cell_width;
+            int cx1 = (p->max_x - min_x) / ps->cell_width;
+            int cy0 = (p->min_y - min_y) / ps->cell_height;
+            int cy1 = (p->max_y - min_y) / ps->cell_height;
+            if (cx1 >= dim)
+                cx1 = dim - 1;
+            if (cy1 >= dim)
+                cy1 = dim - 1;
+            int cx, cy;
+            for (cy = cy0; cy <= cy1; cy++) {
+                for (cx = cx0; cx <= cx1; cx++) {
+                    int cell = cy * dim + cx;
+                    if (!pass)
+                        counts[cell + 1]++;
+                    else
+                        ps->candidates[counts[cell]++] = i;
+                }
+            }
+        }
+        if (!pass) {
+            // Prefix sum so counts[cell] is the cell's fill position
+            for (i = 0; i < num_cells; i++)
+                counts[i + 1] += counts[i];
+            ps->candidates = malloc(counts[num_cells] * sizeof(int));
+        }
+    }
+    // After filling, counts[cell] holds the end offset of each cell
+    memmove(counts + 1, counts, num_cells * sizeof(int));
+    counts[0] = 0;
+    ps->cell_start = counts;
+}
+
+// Find the first polygon containing the given point (or -1 if none)
+int __visible
+polygonset_find(struct polygonset *ps, double x, double y)
+{
+    if (!ps->built)
+        build_grid(ps);
+    if (!ps->num_polys)
+        return -1;
+    int cx = (x - ps->grid_min_x) / ps->cell_width;
+    int cy = (y - ps->grid_min_y) / ps->cell_height;
+    if (cx < 0 || cx >= ps->grid_x || cy < 0 || cy >= ps->grid_y)
+        return -1;
+    int cell = cy * ps->grid_x + cx;
+    int i, start = ps->cell_start[cell], end = ps->cell_start[cell + 1];
+    for (i = start; i < end; i++) {
+        int pi = ps->candidates[i];
+        if (point_in_polygon(&ps->polys[pi], x, y))
+            return pi;
+    }
+    return -1;
+}
+
+// Batch query; fills 'results' with the containing polygon index per point
+void __visible
+polygonset_batch(struct polygonset *ps, const double *xy, int count
+                 , int *results)
+{
+    int i;
+    for (i = 0; i < count; i++)
+        results[i] = polygonset_find(ps, xy[2*i], xy[2*i + 1]);
+}
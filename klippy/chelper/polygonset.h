@@ -0,0 +1,12 @@
+#ifndef POLYGONSET_H
+#define POLYGONSET_H
+
+struct polygonset *polygonset_alloc(void);
+void polygonset_free(struct polygonset *ps);
+int polygonset_add(struct polygonset *ps, const double *points
+                   , int num_points);
+int polygonset_find(struct polygonset *ps, double x, double y);
+void polygonset_batch(struct polygonset *ps, const double *xy, int count
+                      , int *results);
+
+#endif // polygonset.h
@@ -0,0 +1,222 @@
+// Streaming Welch power spectral density and input shaper response
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // sqrt
+#include <stdlib.h> // malloc
+#include <string.h> // memmove
+#include "compiler.h" // __visible
+#include "psd.h" // psd_accum_alloc
+
+#define KAISER_BETA 6.
+
+// The accumulator implements Welch's method incrementally: incoming
+// (x, y, z) samples fill a fixed window buffer and each time it fills
+// the windowed FFT power is added to per-axis accumulators, keeping
+// memory usage bounded by the FFT size regardless of capture length.
+struct psd_accum {
+    int nfft, nbins, buf_pos, num_windows;
+    double *window; // nfft windowing coefficients
+    double *buf; // 3 * nfft pending samples
+    double *accum; // 3 * nbins accumulated raw power
+    double *re, *im; // nfft fft scratch space
+    double win_sumsq;
+};
+
+// Modified Bessel function of the first kind, order zero
+static double
+bessel_i0(double x)
+{
+    double sum = 1., term = 1.;
+    int k;
+    for (k = 1; k < 64; k++) {
+        term *= (x * x * .25) / (double)(k * k);
+        sum += term;
+        if (term < 1e-17 * sum)
+            break;
+    }
+    return sum;
+}
+
+// In-place radix-2 complex fft (n must be a power of two)
+static void
+fft_inplace(double *re, double *im, int n)
+{
+    int i, j = 0;
+    for (i = 1; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    int len;
+    for (len = 2; len <= n; len <<= 1) {
+        double ang = -2. * M_PI / len;
+        double wr = cos(ang), wi = sin(ang);
+        for (i = 0; i < n; i += len) {
+            double cr = 1., ci = 0.;
+            int k, half = len >> 1;
+            for (k = 0; k < half; k++) {
+                int a = i + k, b = a + half;
+                double tr = re[b]*cr - im[b]*ci;
+                double ti = re[b]*ci + im[b]*cr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+                double ncr = cr*wr - ci*wi;
+                ci = cr*wi + ci*wr;
+                cr = ncr;
+            }
+        }
+    }
+}
+
+struct psd_accum * __visible
+psd_accum_alloc(int nfft)
+{
+    int nbins = nfft / 2 + 1;
+    struct psd_accum *pa = malloc(sizeof(*pa)
+                                  + (6*nfft + 3*nbins) * sizeof(double));
+    memset(pa, 0, sizeof(*pa));
+    pa->nfft = nfft;
+    pa->nbins = nbins;
+    pa->window = (double*)(pa + 1);
+    pa->buf = &pa->window[nfft];
+    pa->re = &pa->buf[3*nfft];
+    pa->im = &pa->re[nfft];
+    pa->accum = &pa->im[nfft];
+    memset(pa->accum, 0, 3*nbins * sizeof(double));
+    // Kaiser window (matches numpy.kaiser(nfft, KAISER_BETA))
+    double alpha = (nfft - 1) * .5, inv_i0 = 1. / bessel_i0(KAISER_BETA);
+    int i;
+    for (i = 0; i < nfft; i++) {
+        double r = (i - alpha) / alpha;
+        pa->window[i] = bessel_i0(KAISER_BETA * sqrt(1. - r*r)) * inv_i0;
+        pa->win_sumsq += pa->window[i] * pa->window[i];
+    }
+    return pa;
+}
+
+void __visible
+psd_accum_free(struct psd_accum *pa)
+{
+    free(pa);
+}
+
+// Window, detrend, and fft one full buffer, accumulating the raw power
+static void
+psd_accum_process_window(struct psd_accum *pa)
+{
+    int nfft = pa->nfft, axis, i;
+    for (axis = 0; axis < 3; axis++) {
+        double *data = &pa->buf[axis * nfft];
+        double mean = 0.;
+        for (i = 0; i < nfft; i++)
+            mean += data[i];
+        mean /= nfft;
+        for (i = 0; i < nfft; i++) {
+            pa->re[i] = pa->window[i] * (data[i] - mean);
+            pa->im[i] = 0.;
+        }
+        fft_inplace(pa->re, pa->im, nfft);
+        double *accum = &pa->accum[axis * pa->nbins];
+        for (i = 0; i < pa->nbins; i++)
+            accum[i] += pa->re[i]*pa->re[i] + pa->im[i]*pa->im[i];
+    }
+    pa->num_windows++;
+    // Keep the second half of the buffer (50% window overlap)
+    int half = nfft / 2;
+    for (axis = 0; axis < 3; axis++) {
+        double *data = &pa->buf[axis * nfft];
+        memmove(data, &data[half], half * sizeof(double));
+    }
+    pa->buf_pos = half;
+}
+
+// Add accelerometer samples ('count' interleaved x, y, z triplets)
+void __visible
+psd_accum_add(struct psd_accum *pa, const double *samples, int count)
+{
+    int nfft = pa->nfft, i;
+    for (i = 0; i < count; i++) {
+        pa->buf[pa->buf_pos] = samples[3*i];
+        pa->buf[nfft + pa->buf_pos] = samples[3*i + 1];
+        pa->buf[2*nfft + pa->buf_pos] = samples[3*i + 2];
+        if (++pa->buf_pos >= nfft)
+            psd_accum_process_window(pa);
+    }
+}
+
+int __visible
+psd_accum_get_num_windows(struct psd_accum *pa)
+{
+    return pa->num_windows;
+}
+
+int __visible
+psd_accum_get_nfft(struct psd_accum *pa)
+{
+    return pa->nfft;
+}
+
+// Store the averaged power spectral density and its frequency bins.
+// The sampling frequency is only needed for final scaling, so it may
+// be estimated after the capture completes.
+void __visible
+psd_accum_finalize(struct psd_accum *pa, double fs, double *freqs
+                   , double *psd_x, double *psd_y, double *psd_z)
+{
+    int nbins = pa->nbins, i;
+    double scale = 0.;
+    if (pa->num_windows)
+        scale = 1. / (pa->win_sumsq * fs * pa->num_windows);
+    double *out[3] = { psd_x, psd_y, psd_z };
+    int axis;
+    for (axis = 0; axis < 3; axis++) {
+        double *accum = &pa->accum[axis * nbins];
+        for (i = 0; i < nbins; i++) {
+            double v = accum[i] * scale;
+            // Double one-sided response (except DC and Nyquist terms)
+            if (i && i != nbins - 1)
+                v *= 2.;
+            out[axis][i] = v;
+        }
+    }
+    double freq_per_bin = fs / pa->nfft;
+    for (i = 0; i < nbins; i++)
+        freqs[i] = i * freq_per_bin;
+}
+
+// Evaluate an input shaper's residual vibration response at the given
+// frequencies (assuming a harmonic oscillator with 'damping_ratio')
+void __visible
+shaper_estimate_response(const double *shaper_a, const double *shaper_t
+                         , int n, double damping_ratio, const double *freqs
+                         , int count, double *out)
+{
+    double inv_d = 0.;
+    int i, j;
+    for (i = 0; i < n; i++)
+        inv_d += shaper_a[i];
+    inv_d = 1. / inv_d;
+    double t_last = shaper_t[n-1];
+    double v = sqrt(1. - damping_ratio*damping_ratio);
+    for (j = 0; j < count; j++) {
+        double omega = 2. * M_PI * freqs[j];
+        double damping = damping_ratio * omega, omega_d = omega * v;
+        double s = 0., c = 0.;
+        for (i = 0; i < n; i++) {
+            double w = shaper_a[i] * exp(-damping * (t_last - shaper_t[i]));
+            s += w * sin(omega_d * shaper_t[i]);
+            c += w * cos(omega_d * shaper_t[i]);
+        }
+        out[j] = sqrt(s*s + c*c) * inv_d;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef PSD_H
+#define PSD_H
+
+struct psd_accum;
+
+struct psd_accum *psd_accum_alloc(int nfft);
+void psd_accum_free(struct psd_accum *pa);
+void psd_accum_add(struct psd_accum *pa, const double *samples, int count);
+int psd_accum_get_num_windows(struct psd_accum *pa);
+int psd_accum_get_nfft(struct psd_accum *pa);
+void psd_accum_finalize(struct psd_accum *pa, double fs, double *freqs
+                        , double *psd_x, double *psd_y, double *psd_z);
+void shaper_estimate_response(const double *shaper_a, const double *shaper_t
+                              , int n, double damping_ratio
+                              , const double *freqs, int count, double *out);
+
+#endif // psd.h
@@ -12,19 +12,27 @@
 // clock times, prioritizes commands, and handles retransmissions.  A
 // background thread is launched to do this work and minimize latency.
 
+#define _GNU_SOURCE // sendmmsg
+#include <fcntl.h> // open
 #include <linux/can.h> // // struct can_frame
 #include <math.h> // fabs
 #include <pthread.h> // pthread_mutex_lock
+#include <sched.h> // CPU_SET
 #include <stddef.h> // offsetof
 #include <stdint.h> // uint64_t
 #include <stdio.h> // snprintf
 #include <stdlib.h> // malloc
 #include <string.h> // memset
+#include <sys/eventfd.h> // eventfd
+#include <sys/mman.h> // mmap
+#include <sys/socket.h> // sendmmsg
+#include <sys/syscall.h> // SYS_gettid
 #include <termios.h> // tcflush
 #include <unistd.h> // pipe
 #include "compiler.h" // __visible
 #include "list.h" // list_add_tail
 #include "msgblock.h" // message_alloc
+#include "msgproto.h" // msgproto_encode_ints
 #include "pollreactor.h" // pollreactor_alloc
 #include "pyhelper.h" // get_monotonic
 #include "serialqueue.h" // struct queue_message
@@ -36,6 +44,7 @@ struct message_sub_queue {
 
 struct command_queue {
     struct message_sub_queue ready, upcoming;
+    int lane;
 };
 
 struct receiver {
@@ -46,27 +55,74 @@ struct receiver {
     struct list_head old_receive;
 };
 
+// Size of the submission ring (must be a power of two)
+#define SUBMIT_RING_SIZE 1024
+
 struct transmit_requests {
-    int pipe_fds[2];
-    pthread_mutex_t lock; // protects variables below
+    int kick_fd;
+    // Serializes producer-side ring pushes (also held for teardown
+    // and stats snapshots)
+    pthread_mutex_t lock;
+    // State below is owned by the background thread
     struct list_head upcoming_queues;
     int upcoming_bytes;
-    uint64_t need_kick_clock, min_release_clock;
+    uint64_t min_release_clock;
+    // Multi-producer single-consumer handoff ring.  Submitting
+    // threads append at ring_tail (under 'lock') and the background
+    // thread consumes at ring_head without locking; need_kick_clock
+    // is the consumer's announced sleep threshold (all accessed with
+    // atomic operations).
+    uint64_t need_kick_clock;
+    struct {
+        struct command_queue *cq;
+        struct queue_message *qm;
+    } ring[SUBMIT_RING_SIZE];
+    uint32_t ring_head, ring_tail;
+};
+
+// Number of fast reader dispatch buckets (hashed on the message prefix)
+#define FASTREADER_BUCKETS 64
+
+// Log-scale latency histograms (bucket k covers [2**k, 2**(k+1)) usecs)
+#define LATENCY_BUCKETS 32
+
+// On-disk layout of the optional traffic recorder (little-endian)
+#define RECORD_MAGIC 0x4b515253 // "SRQK"
+#define RECORD_VERSION 1
+enum {
+    RT_SENT = 1, RT_RECEIVED = 2, RT_RETRANSMIT = 3, RT_ACK_LATENCY = 4,
+};
+
+struct record_header {
+    uint32_t magic, version;
+    uint32_t num_records, next_index;
+};
+
+struct record_entry {
+    double eventtime;
+    uint32_t kind, len;
+    uint8_t data[MESSAGE_MAX];
 };
 
 struct serialqueue {
     // Input reading
     struct pollreactor *pr;
-    int serial_fd, serial_fd_type, client_id;
+    int serial_fd, serial_fd_type, client_id, canbus_fd;
     uint8_t input_buf[4096];
     uint8_t need_sync;
     int input_pos;
+    // Optional bonded secondary link
+    int secondary_fd;
+    uint8_t secondary_input_buf[4096];
+    uint8_t secondary_need_sync;
+    int secondary_input_pos;
     // Multi-threaded support for pushing and pulling messages
     struct receiver receiver;
     struct transmit_requests transmit_requests;
     // Threading
     char name[16];
     pthread_t tid;
+    int ktid;
     pthread_mutex_t lock; // protects variables below
     // Baud / clock tracking
     int receive_window;
@@ -78,23 +134,41 @@ struct serialqueue {
     uint64_t ignore_nak_seq, last_ack_seq, retransmit_seq, rtt_sample_seq;
     struct list_head sent_queue;
     double srtt, rttvar, rto;
+    double link_srtt[2];
+    int rtt_sample_link;
+    // Adaptive in-flight window
+    double min_rtt, min_rtt_time;
+    double delivery_rate, delivery_rate_time, ack_time;
+    int adaptive_window;
     // Pending transmission message queues
-    struct list_head ready_queues;
+    struct list_head ready_queues[SQ_NUM_LANES];
     int ready_bytes, need_ack_bytes, last_ack_bytes;
     struct list_head notify_queue;
     double last_write_fail_time;
     // Fastreader support
     pthread_mutex_t fast_reader_dispatch_lock;
-    struct list_head fast_readers;
+    struct list_head fast_readers[FASTREADER_BUCKETS], fast_readers_any;
+    // Bulk consumer rings
+    struct list_head bulk_readers;
+    // Traffic recording
+    struct record_header *record_hdr;
+    struct record_entry *record_buf;
+    size_t record_size;
+    // Latency histograms
+    uint32_t dwell_hist[LATENCY_BUCKETS];
+    uint32_t rtt_hist[LATENCY_BUCKETS];
+    uint32_t wakeup_hist[LATENCY_BUCKETS];
+    uint64_t kick_time_bits;
     // Debugging
     struct list_head old_sent;
     // Stats
     uint32_t bytes_write, bytes_read, bytes_retransmit, bytes_invalid;
 };
 
-#define SQPF_SERIAL 0
-#define SQPF_PIPE   1
-#define SQPF_NUM    2
+#define SQPF_SERIAL    0
+#define SQPF_KICK      1
+#define SQPF_SECONDARY 2
+#define SQPF_NUM       3
 
 #define SQPT_RETRANSMIT 0
 #define SQPT_COMMAND    1
@@ -107,7 +181,13 @@ struct serialqueue {
 #define MIN_RTO 0.025
 #define MAX_RTO 5.000
 #define MAX_PENDING_BLOCKS 12
+// Maximum CAN frames exchanged in one sendmmsg()/recvmmsg() call
+#define CAN_BATCH_MAX DIV_ROUND_UP(MESSAGE_MAX * MAX_PENDING_BLOCKS + 1, 8)
 #define MIN_REQTIME_DELTA 0.100
+#define LANE_STARVATION_TIME 0.025
+#define ADAPTIVE_WINDOW_GAIN 2.0
+#define ADAPTIVE_WINDOW_MIN (2 * MESSAGE_MAX)
+#define ADAPTIVE_WINDOW_EXPIRE 10.0
 #define MIN_BACKGROUND_DELTA 0.005
 #define IDLE_QUERY_TIME 1.0
 
@@ -159,13 +239,30 @@ receive_append_wake(struct receiver *receiver, struct list_head *msgs)
         pthread_cond_signal(&receiver->cond);
 }
 
+// Add a duration measurement to a log-scale latency histogram
+static void
+latency_record(uint32_t counts[LATENCY_BUCKETS], double delta)
+{
+    double us = delta * 1000000.;
+    int bucket = us >= 1. ? ilogb(us) : 0;
+    if (bucket >= LATENCY_BUCKETS)
+        bucket = LATENCY_BUCKETS - 1;
+    counts[bucket]++;
+}
+
 // Write to the internal pipe to wake the background thread if in poll
 static void
 kick_bg_thread(struct serialqueue *sq)
 {
-    int ret = write(sq->transmit_requests.pipe_fds[1], ".", 1);
+    // Note the time of the first unserviced kick (for wakeup latency)
+    union { double time; uint64_t bits; } kick = { .time = get_monotonic() };
+    uint64_t expect = 0;
+    __atomic_compare_exchange_n(&sq->kick_time_bits, &expect, kick.bits, 0
+                                , __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    uint64_t one = 1;
+    int ret = write(sq->transmit_requests.kick_fd, &one, sizeof(one));
     if (ret < 0)
-        report_errno("pipe write", ret);
+        report_errno("eventfd write", ret);
 }
 
 // Minimum number of bits in a canbus message
@@ -185,12 +282,31 @@ calculate_bittime(struct serialqueue *sq, uint32_t bytes)
     }
 }
 
+// Append an entry to the traffic recording ring (caller holds sq->lock)
+static void
+record_event(struct serialqueue *sq, int kind, double eventtime
+             , const void *data, int len)
+{
+    struct record_header *hdr = sq->record_hdr;
+    if (!hdr)
+        return;
+    struct record_entry *re = &sq->record_buf[hdr->next_index];
+    re->eventtime = eventtime;
+    re->kind = kind;
+    if (len > MESSAGE_MAX)
+        len = MESSAGE_MAX;
+    re->len = len;
+    memcpy(re->data, data, len);
+    hdr->next_index = (hdr->next_index + 1) % hdr->num_records;
+}
+
 // Update internal state when the receive sequence increases
 static void
 update_receive_seq(struct serialqueue *sq, double eventtime, uint64_t rseq)
 {
     // Remove from sent queue
     uint64_t sent_seq = sq->receive_seq;
+    int acked_bytes = 0;
     for (;;) {
         struct queue_message *sent = list_first_entry(
             &sq->sent_queue, struct queue_message, node);
@@ -201,6 +317,7 @@ update_receive_seq(struct serialqueue *sq, double eventtime, uint64_t rseq)
             break;
         }
         sq->need_ack_bytes -= sent->len;
+        acked_bytes += sent->len;
         list_del(&sent->node);
         debug_queue_add(&sq->old_sent, sent);
         sent_seq++;
@@ -235,6 +352,32 @@ update_receive_seq(struct serialqueue *sq, double eventtime, uint64_t rseq)
         else if (sq->rto > MAX_RTO)
             sq->rto = MAX_RTO;
         sq->rtt_sample_seq = 0;
+        record_event(sq, RT_ACK_LATENCY, eventtime, &delta, sizeof(delta));
+        latency_record(sq->rtt_hist, delta);
+        // Per-link smoothed round-trip time (for bonded secondary link)
+        double *lsrtt = &sq->link_srtt[sq->rtt_sample_link];
+        *lsrtt = *lsrtt ? (7.0 * *lsrtt + delta) / 8.0 : delta;
+        // Windowed minimum of the measured ack round-trip time
+        if (!sq->min_rtt || delta < sq->min_rtt
+            || eventtime > sq->min_rtt_time + ADAPTIVE_WINDOW_EXPIRE) {
+            sq->min_rtt = delta;
+            sq->min_rtt_time = eventtime;
+        }
+    }
+    // Update adaptive in-flight window from measured delivery rate
+    if (acked_bytes && sq->ack_time && eventtime > sq->ack_time) {
+        double rate = acked_bytes / (eventtime - sq->ack_time);
+        if (rate > sq->delivery_rate
+            || eventtime > sq->delivery_rate_time + ADAPTIVE_WINDOW_EXPIRE) {
+            sq->delivery_rate = rate;
+            sq->delivery_rate_time = eventtime;
+        }
+    }
+    sq->ack_time = eventtime;
+    if (sq->delivery_rate && sq->min_rtt) {
+        int aw = ADAPTIVE_WINDOW_GAIN * sq->delivery_rate * sq->min_rtt;
+        sq->adaptive_window = aw > ADAPTIVE_WINDOW_MIN ? aw
+            : ADAPTIVE_WINDOW_MIN;
     }
     if (list_empty(&sq->sent_queue)) {
         pollreactor_update_timer(sq->pr, SQPT_RETRANSMIT, PR_NEVER);
@@ -246,14 +389,98 @@ update_receive_seq(struct serialqueue *sq, double eventtime, uint64_t rseq)
     }
 }
 
+// Select the fast reader dispatch bucket for a two byte message prefix
+static int
+fastreader_bucket(uint8_t b0, uint8_t b1)
+{
+    return (b0 * 33 + b1) % FASTREADER_BUCKETS;
+}
+
+// Invoke the first fast reader in a bucket matching the input message.
+// The caller must hold sq->lock; it is released on a match.
+static int
+dispatch_fast_readers(struct serialqueue *sq, struct list_head *frs
+                      , uint8_t *data, int len)
+{
+    struct fastreader *fr;
+    list_for_each_entry(fr, frs, node) {
+        if (len < fr->prefix_len + MESSAGE_MIN
+            || memcmp(&data[MESSAGE_HEADER_SIZE]
+                      , fr->prefix, fr->prefix_len) != 0)
+            continue;
+        // Release main lock and invoke callback
+        pthread_mutex_lock(&sq->fast_reader_dispatch_lock);
+        pthread_mutex_unlock(&sq->lock);
+        fr->func(fr, data, len);
+        pthread_mutex_unlock(&sq->fast_reader_dispatch_lock);
+        return 1;
+    }
+    return 0;
+}
+
+// A consumer-owned single-producer single-consumer sample ring.  The
+// background thread copies matching message payloads directly into the
+// ring at ring_tail; the consumer reads at ring_head (both accessed
+// with atomic operations).  This avoids the queue_message allocation
+// and per-message host dispatch overhead on high-rate bulk streams.
+struct bulkreader {
+    struct list_node node;
+    int prefix_len, num_int_params;
+    uint8_t prefix[MESSAGE_MAX];
+    uint32_t ring_size, ring_head, ring_tail;
+    uint32_t overflows;
+    struct bulk_sample ring[];
+};
+
+// Copy a matching data message payload into a registered consumer ring
+static int
+dispatch_bulk_readers(struct serialqueue *sq, uint8_t *data, int len)
+{
+    uint8_t *payload = &data[MESSAGE_HEADER_SIZE];
+    int plen = len - MESSAGE_MIN;
+    struct bulkreader *br;
+    list_for_each_entry(br, &sq->bulk_readers, node) {
+        if (plen < br->prefix_len
+            || memcmp(payload, br->prefix, br->prefix_len) != 0)
+            continue;
+        // Verify the block contains exactly one matching command
+        uint8_t *p = &payload[br->prefix_len], *end = &payload[plen];
+        int i;
+        for (i = 0; i < br->num_int_params && p < end; i++) {
+            while (p < end && *p & 0x80)
+                p++;
+            p++;
+        }
+        if (p < end)
+            p += *p + 1;
+        if (p != end)
+            continue;
+        uint32_t tail = br->ring_tail;
+        uint32_t head = __atomic_load_n(&br->ring_head, __ATOMIC_ACQUIRE);
+        if (tail - head >= br->ring_size) {
+            // Consumer is not keeping up - drop the sample
+            br->overflows++;
+            return 1;
+        }
+        struct bulk_sample *bs = &br->ring[tail % br->ring_size];
+        bs->receive_time = get_monotonic() - calculate_bittime(sq, len);
+        bs->len = plen - br->prefix_len;
+        memcpy(bs->data, &payload[br->prefix_len], bs->len);
+        __atomic_store_n(&br->ring_tail, tail + 1, __ATOMIC_RELEASE);
+        return 1;
+    }
+    return 0;
+}
+
 // Process a well formed input message
 static void
-handle_message(struct serialqueue *sq, double eventtime, int len)
+handle_message(struct serialqueue *sq, double eventtime, uint8_t *data
+               , int len)
 {
     pthread_mutex_lock(&sq->lock);
 
     // Calculate receive sequence number
-    uint32_t rseq_delta = ((sq->input_buf[MESSAGE_POS_SEQ] - sq->receive_seq)
+    uint32_t rseq_delta = ((data[MESSAGE_POS_SEQ] - sq->receive_seq)
                            & MESSAGE_SEQ_MASK);
     uint64_t rseq = sq->receive_seq + rseq_delta;
     if (rseq != sq->receive_seq) {
@@ -267,6 +494,7 @@ handle_message(struct serialqueue *sq, double eventtime, int len)
         update_receive_seq(sq, eventtime, rseq);
     }
     sq->bytes_read += len;
+    record_event(sq, RT_RECEIVED, eventtime, data, len);
 
     // Check for pending messages on notify_queue
     struct list_head received;
@@ -293,9 +521,9 @@ handle_message(struct serialqueue *sq, double eventtime, int len)
         else if (rseq > sq->ignore_nak_seq && !list_empty(&sq->sent_queue))
             // Duplicate Ack is a Nak - do fast retransmit
             pollreactor_update_timer(sq->pr, SQPT_RETRANSMIT, PR_NOW);
-    } else {
+    } else if (!dispatch_bulk_readers(sq, data, len)) {
         // Data message - add to receive queue
-        struct queue_message *qm = message_fill(sq->input_buf, len);
+        struct queue_message *qm = message_fill(data, len);
         qm->sent_time = (rseq > sq->retransmit_seq
                          ? sq->last_receive_sent_time : 0.);
         qm->receive_time = get_monotonic(); // must be time post read()
@@ -306,39 +534,76 @@ handle_message(struct serialqueue *sq, double eventtime, int len)
     if (!list_empty(&received))
         receive_append_wake(&sq->receiver, &received);
 
-    // Check fast readers
-    struct fastreader *fr;
-    list_for_each_entry(fr, &sq->fast_readers, node) {
-        if (len < fr->prefix_len + MESSAGE_MIN
-            || memcmp(&sq->input_buf[MESSAGE_HEADER_SIZE]
-                      , fr->prefix, fr->prefix_len) != 0)
-            continue;
-        // Release main lock and invoke callback
-        pthread_mutex_lock(&sq->fast_reader_dispatch_lock);
-        pthread_mutex_unlock(&sq->lock);
-        fr->func(fr, sq->input_buf, len);
-        pthread_mutex_unlock(&sq->fast_reader_dispatch_lock);
+    // Check fast readers (hashed on the leading msgid/oid bytes)
+    uint8_t *payload = &data[MESSAGE_HEADER_SIZE];
+    int bucket = fastreader_bucket(payload[0], payload[1]);
+    if (dispatch_fast_readers(sq, &sq->fast_readers[bucket], data, len)
+        || dispatch_fast_readers(sq, &sq->fast_readers_any, data, len))
         return;
-    }
     pthread_mutex_unlock(&sq->lock);
 }
 
+// Parse and dispatch complete message blocks in a link's input buffer
+static void
+parse_input(struct serialqueue *sq, double eventtime, uint8_t *need_sync
+            , uint8_t *input_buf, int *input_pos)
+{
+    for (;;) {
+        int len = msgblock_check(need_sync, input_buf, *input_pos);
+        if (!len)
+            // Need more data
+            return;
+        if (len > 0) {
+            // Received a valid message
+            handle_message(sq, eventtime, input_buf, len);
+        } else {
+            // Skip bad data at beginning of input
+            len = -len;
+            pthread_mutex_lock(&sq->lock);
+            sq->bytes_invalid += len;
+            pthread_mutex_unlock(&sq->lock);
+        }
+        *input_pos -= len;
+        if (*input_pos)
+            memmove(input_buf, &input_buf[len], *input_pos);
+    }
+}
+
 // Callback for input activity on the serial fd
 static void
 input_event(struct serialqueue *sq, double eventtime)
 {
     if (sq->serial_fd_type == SQT_CAN) {
-        struct can_frame cf;
-        int ret = read(sq->serial_fd, &cf, sizeof(cf));
+        // Read all pending frames that fit with a single recvmmsg().
+        // A canfd_frame is used for reading as it is layout compatible
+        // with can_frame and also accepts 64 byte CAN-FD frames.
+        struct canfd_frame cf[CAN_BATCH_MAX];
+        struct iovec iov[CAN_BATCH_MAX];
+        struct mmsghdr msgs[CAN_BATCH_MAX];
+        memset(msgs, 0, sizeof(msgs));
+        int frame_max = sq->canbus_fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+        int i, max_frames = ((sizeof(sq->input_buf) - sq->input_pos)
+                             / frame_max);
+        if (max_frames > CAN_BATCH_MAX)
+            max_frames = CAN_BATCH_MAX;
+        for (i=0; i<max_frames; i++) {
+            iov[i].iov_base = &cf[i];
+            iov[i].iov_len = sizeof(cf[i]);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int ret = recvmmsg(sq->serial_fd, msgs, max_frames, 0, NULL);
         if (ret <= 0) {
             report_errno("can read", ret);
             pollreactor_do_exit(sq->pr);
             return;
         }
-        if (cf.can_id != sq->client_id + 1)
-            return;
-        memcpy(&sq->input_buf[sq->input_pos], cf.data, cf.can_dlc);
-        sq->input_pos += cf.can_dlc;
+        for (i=0; i<ret; i++) {
+            if (cf[i].can_id != sq->client_id + 1)
+                continue;
+            memcpy(&sq->input_buf[sq->input_pos], cf[i].data, cf[i].len);
+            sq->input_pos += cf[i].len;
+        }
     } else {
         int ret = read(sq->serial_fd, &sq->input_buf[sq->input_pos]
                        , sizeof(sq->input_buf) - sq->input_pos);
@@ -352,38 +617,53 @@ input_event(struct serialqueue *sq, double eventtime)
         }
         sq->input_pos += ret;
     }
-    for (;;) {
-        int len = msgblock_check(&sq->need_sync, sq->input_buf, sq->input_pos);
-        if (!len)
-            // Need more data
-            return;
-        if (len > 0) {
-            // Received a valid message
-            handle_message(sq, eventtime, len);
-        } else {
-            // Skip bad data at beginning of input
-            len = -len;
-            pthread_mutex_lock(&sq->lock);
-            sq->bytes_invalid += len;
-            pthread_mutex_unlock(&sq->lock);
-        }
-        sq->input_pos -= len;
-        if (sq->input_pos)
-            memmove(sq->input_buf, &sq->input_buf[len], sq->input_pos);
+    parse_input(sq, eventtime, &sq->need_sync, sq->input_buf, &sq->input_pos);
+}
+
+// Callback for input activity on the bonded secondary link
+static void
+secondary_input_event(struct serialqueue *sq, double eventtime)
+{
+    int pos = sq->secondary_input_pos;
+    int ret = read(sq->secondary_fd, &sq->secondary_input_buf[pos]
+                   , sizeof(sq->secondary_input_buf) - pos);
+    if (ret <= 0) {
+        if (ret < 0)
+            report_errno("secondary read", ret);
+        else
+            errorf("Got EOF when reading from secondary device");
+        pollreactor_do_exit(sq->pr);
+        return;
     }
+    sq->secondary_input_pos += ret;
+    parse_input(sq, eventtime, &sq->secondary_need_sync
+                , sq->secondary_input_buf, &sq->secondary_input_pos);
 }
 
-// Callback for input activity on the pipe fd (wakes command_event)
+// Callback for input activity on the eventfd (wakes command_event)
 static void
 kick_event(struct serialqueue *sq, double eventtime)
 {
-    char dummy[4096];
-    int ret = read(sq->transmit_requests.pipe_fds[0], dummy, sizeof(dummy));
+    uint64_t count;
+    int ret = read(sq->transmit_requests.kick_fd, &count, sizeof(count));
     if (ret < 0)
-        report_errno("pipe read", ret);
+        report_errno("eventfd read", ret);
     pollreactor_update_timer(sq->pr, SQPT_COMMAND, PR_NOW);
 }
 
+// Largest valid CAN-FD frame size that can be completely filled from
+// 'len' pending bytes (frames are never padded as the mcu serial
+// framing would treat pad bytes as corrupt data)
+static int
+canfd_frame_size(int len)
+{
+    static const uint8_t sizes[] = {12, 16, 20, 24, 32, 48, 64};
+    int i, best = len > 8 ? 8 : len;
+    for (i = 0; i < ARRAY_SIZE(sizes) && sizes[i] <= len; i++)
+        best = sizes[i];
+    return best;
+}
+
 // OS write of data to be sent to the mcu
 static void
 do_write(struct serialqueue *sq, void *buf, int buflen)
@@ -394,14 +674,30 @@ do_write(struct serialqueue *sq, void *buf, int buflen)
             report_errno("write", ret);
         return;
     }
-    // Write to CAN fd
-    struct can_frame cf;
+    // Write to CAN fd - gather frames and submit with one sendmmsg()
+    struct canfd_frame cf[CAN_BATCH_MAX];
+    struct iovec iov[CAN_BATCH_MAX];
+    struct mmsghdr msgs[CAN_BATCH_MAX];
+    memset(msgs, 0, sizeof(msgs));
+    int fd_mode = sq->canbus_fd, num_frames = 0;
     while (buflen) {
-        int size = buflen > 8 ? 8 : buflen;
-        cf.can_id = sq->client_id;
-        cf.can_dlc = size;
-        memcpy(cf.data, buf, size);
-        int ret = write(sq->serial_fd, &cf, sizeof(cf));
+        int size = fd_mode ? canfd_frame_size(buflen)
+            : (buflen > 8 ? 8 : buflen);
+        cf[num_frames].can_id = sq->client_id;
+        cf[num_frames].len = size;
+        cf[num_frames].flags = fd_mode ? CANFD_BRS : 0;
+        memcpy(cf[num_frames].data, buf, size);
+        iov[num_frames].iov_base = &cf[num_frames];
+        iov[num_frames].iov_len = fd_mode ? CANFD_MTU : CAN_MTU;
+        msgs[num_frames].msg_hdr.msg_iov = &iov[num_frames];
+        msgs[num_frames].msg_hdr.msg_iovlen = 1;
+        num_frames++;
+        buf += size;
+        buflen -= size;
+    }
+    int sent = 0;
+    while (sent < num_frames) {
+        int ret = sendmmsg(sq->serial_fd, &msgs[sent], num_frames - sent, 0);
         if (ret < 0) {
             report_errno("can write", ret);
             double curtime = get_monotonic();
@@ -414,8 +710,7 @@ do_write(struct serialqueue *sq, void *buf, int buflen)
             return;
         }
         sq->last_write_fail_time = 0.0;
-        buf += size;
-        buflen -= size;
+        sent += ret;
     }
 }
 
@@ -441,6 +736,7 @@ retransmit_event(struct serialqueue *sq, double eventtime)
         buflen += qm->len;
         if (!first_buflen)
             first_buflen = qm->len + 1;
+        record_event(sq, RT_RETRANSMIT, eventtime, qm->msg, qm->len);
     }
     do_write(sq, buf, buflen);
     sq->bytes_retransmit += buflen;
@@ -458,6 +754,13 @@ retransmit_event(struct serialqueue *sq, double eventtime)
         if (sq->rto > MAX_RTO)
             sq->rto = MAX_RTO;
         sq->ignore_nak_seq = sq->send_seq;
+        // Assume the link is congested - shrink the in-flight window
+        sq->delivery_rate *= 0.5;
+        if (sq->adaptive_window) {
+            sq->adaptive_window /= 2;
+            if (sq->adaptive_window < ADAPTIVE_WINDOW_MIN)
+                sq->adaptive_window = ADAPTIVE_WINDOW_MIN;
+        }
     }
     sq->retransmit_seq = sq->send_seq;
     sq->rtt_sample_seq = 0;
@@ -468,18 +771,50 @@ retransmit_event(struct serialqueue *sq, double eventtime)
     return waketime;
 }
 
-// Construct a block of data to be sent to the serial port
+// Select the ready_queues lane to drain next.  Lanes are drained in
+// strict priority order; a lower priority lane whose oldest message
+// has waited more than LANE_STARVATION_TIME is promoted so bulk
+// traffic can not be starved indefinitely.
+static struct list_head *
+select_ready_lane(struct serialqueue *sq, double eventtime)
+{
+    struct list_head *lq = NULL;
+    int lane;
+    for (lane = 0; lane < SQ_NUM_LANES; lane++) {
+        struct list_head *rq = &sq->ready_queues[lane];
+        if (list_empty(rq))
+            continue;
+        if (!lq) {
+            lq = rq;
+            continue;
+        }
+        // Check if this lower priority lane is being starved
+        struct command_queue *q;
+        list_for_each_entry(q, rq, ready.node) {
+            struct queue_message *m = list_first_entry(
+                &q->ready.msg_queue, struct queue_message, node);
+            if (m->queued_time + LANE_STARVATION_TIME < eventtime)
+                return rq;
+        }
+    }
+    return lq;
+}
+
+// Construct a block of data to be sent to the serial port.  Sets
+// 'is_bulk' if the block only contains background priority messages
+// (and may thus be routed to a bonded secondary link).
 static int
 build_and_send_command(struct serialqueue *sq, uint8_t *buf, int pending
-                       , double eventtime)
+                       , double eventtime, int *is_bulk)
 {
-    int len = MESSAGE_HEADER_SIZE;
+    int len = MESSAGE_HEADER_SIZE, bulk = 1;
     while (sq->ready_bytes) {
-        // Find highest priority message (message with lowest req_clock)
+        // Find next message in lane (message with lowest req_clock)
+        struct list_head *lq = select_ready_lane(sq, eventtime);
         uint64_t min_clock = MAX_CLOCK;
         struct command_queue *q, *cq = NULL;
         struct queue_message *qm = NULL;
-        list_for_each_entry(q, &sq->ready_queues, ready.node) {
+        list_for_each_entry(q, lq, ready.node) {
             struct queue_message *m = list_first_entry(
                 &q->ready.msg_queue, struct queue_message, node);
             if (m->req_clock < min_clock) {
@@ -494,6 +829,9 @@ build_and_send_command(struct serialqueue *sq, uint8_t *buf, int pending
         list_del(&qm->node);
         if (list_empty(&cq->ready.msg_queue))
             list_del(&cq->ready.node);
+        if (qm->req_clock != BACKGROUND_PRIORITY_CLOCK)
+            bulk = 0;
+        latency_record(sq->dwell_hist, eventtime - qm->queued_time);
         memcpy(&buf[len], qm->msg, qm->len);
         len += qm->len;
         sq->ready_bytes -= qm->len;
@@ -514,6 +852,7 @@ build_and_send_command(struct serialqueue *sq, uint8_t *buf, int pending
     buf[len - MESSAGE_TRAILER_CRC] = crc >> 8;
     buf[len - MESSAGE_TRAILER_CRC+1] = crc & 0xff;
     buf[len - MESSAGE_TRAILER_SYNC] = MESSAGE_SYNC;
+    record_event(sq, RT_SENT, eventtime, buf, len);
 
     // Store message block
     double idletime = eventtime > sq->idle_time ? eventtime : sq->idle_time;
@@ -525,25 +864,56 @@ build_and_send_command(struct serialqueue *sq, uint8_t *buf, int pending
     out->receive_time = idletime;
     if (list_empty(&sq->sent_queue))
         pollreactor_update_timer(sq->pr, SQPT_RETRANSMIT, idletime + sq->rto);
-    if (!sq->rtt_sample_seq)
+    *is_bulk = sq->secondary_fd >= 0 && bulk && len > MESSAGE_MIN;
+    if (!sq->rtt_sample_seq) {
         sq->rtt_sample_seq = sq->send_seq;
+        sq->rtt_sample_link = *is_bulk;
+    }
     sq->send_seq++;
     sq->need_ack_bytes += len;
     list_add_tail(&out->node, &sq->sent_queue);
     return len;
 }
 
+// Add a message to a command_queue's upcoming queue (background thread)
+static void
+add_upcoming_message(struct serialqueue *sq, struct command_queue *cq
+                     , struct queue_message *qm)
+{
+    struct transmit_requests *tr = &sq->transmit_requests;
+    if (list_empty(&cq->upcoming.msg_queue))
+        list_add_tail(&cq->upcoming.node, &tr->upcoming_queues);
+    if (qm->min_clock < tr->min_release_clock)
+        tr->min_release_clock = qm->min_clock;
+    list_add_tail(&qm->node, &cq->upcoming.msg_queue);
+    tr->upcoming_bytes += qm->len;
+}
+
+// Drain the submission ring into the upcoming queues
+static void
+drain_submit_ring(struct serialqueue *sq)
+{
+    struct transmit_requests *tr = &sq->transmit_requests;
+    uint32_t head = tr->ring_head;
+    uint32_t tail = __atomic_load_n(&tr->ring_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        struct command_queue *cq = tr->ring[head % SUBMIT_RING_SIZE].cq;
+        struct queue_message *qm = tr->ring[head % SUBMIT_RING_SIZE].qm;
+        add_upcoming_message(sq, cq, qm);
+        __atomic_store_n(&tr->ring_head, head + 1, __ATOMIC_RELEASE);
+    }
+}
+
 // Move messages from upcoming queues to ready queues
 static uint64_t
 check_upcoming_queues(struct serialqueue *sq, uint64_t ack_clock)
 {
-    pthread_mutex_lock(&sq->transmit_requests.lock);
-    sq->transmit_requests.need_kick_clock = 0;
+    __atomic_store_n(&sq->transmit_requests.need_kick_clock, 0
+                     , __ATOMIC_SEQ_CST);
+    drain_submit_ring(sq);
     uint64_t min_release_clock = sq->transmit_requests.min_release_clock;
-    if (ack_clock < min_release_clock) {
-        pthread_mutex_unlock(&sq->transmit_requests.lock);
+    if (ack_clock < min_release_clock)
         return min_release_clock;
-    }
 
     uint64_t min_stalled_clock = MAX_CLOCK;
     struct command_queue *cq, *_ncq;
@@ -568,10 +938,9 @@ check_upcoming_queues(struct serialqueue *sq, uint64_t ack_clock)
             list_del(&cq->upcoming.node);
         // Add to ready queues
         if (not_in_ready_queues && !list_empty(&cq->ready.msg_queue))
-            list_add_tail(&cq->ready.node, &sq->ready_queues);
+            list_add_tail(&cq->ready.node, &sq->ready_queues[cq->lane]);
     }
     sq->transmit_requests.min_release_clock = min_stalled_clock;
-    pthread_mutex_unlock(&sq->transmit_requests.lock);
     return min_stalled_clock;
 }
 
@@ -579,13 +948,14 @@ check_upcoming_queues(struct serialqueue *sq, uint64_t ack_clock)
 static int
 update_need_kick_clock(struct serialqueue *sq, uint64_t wantclock)
 {
-    pthread_mutex_lock(&sq->transmit_requests.lock);
-    if (wantclock > sq->transmit_requests.min_release_clock) {
-        pthread_mutex_unlock(&sq->transmit_requests.lock);
+    struct transmit_requests *tr = &sq->transmit_requests;
+    if (wantclock > tr->min_release_clock)
+        return -1;
+    __atomic_store_n(&tr->need_kick_clock, wantclock, __ATOMIC_SEQ_CST);
+    // Recheck the ring - a message may have arrived before the update
+    uint32_t tail = __atomic_load_n(&tr->ring_tail, __ATOMIC_SEQ_CST);
+    if (tail != tr->ring_head)
         return -1;
-    }
-    sq->transmit_requests.need_kick_clock = wantclock;
-    pthread_mutex_unlock(&sq->transmit_requests.lock);
     return 0;
 }
 
@@ -612,6 +982,10 @@ check_send_command(struct serialqueue *sq, int pending, double eventtime)
             // Wait for ack from past messages before sending next message
             return eventtime + 0.250;
     }
+    if (sq->send_seq > sq->receive_seq && sq->adaptive_window
+        && sq->need_ack_bytes + MESSAGE_MAX > sq->adaptive_window)
+        // Estimated link capacity is in use - wait for an ack
+        return eventtime + 0.250;
 
     // Check if a block is fully ready to send
     if (sq->ready_bytes >= MESSAGE_PAYLOAD_MAX)
@@ -629,17 +1003,20 @@ check_send_command(struct serialqueue *sq, int pending, double eventtime)
     // Check if it is still needed to send messages from the ready_queues
     uint64_t min_ready_clock = MAX_CLOCK;
     struct command_queue *cq;
-    list_for_each_entry(cq, &sq->ready_queues, ready.node) {
-        // Update min_ready_clock
-        struct queue_message *qm = list_first_entry(
-            &cq->ready.msg_queue, struct queue_message, node);
-        uint64_t req_clock = qm->req_clock;
-        double bgtime = pending ? idletime : sq->idle_time;
-        double bgoffset = MIN_REQTIME_DELTA + MIN_BACKGROUND_DELTA;
-        if (req_clock == BACKGROUND_PRIORITY_CLOCK)
-            req_clock = clock_from_time(&sq->ce, bgtime + bgoffset);
-        if (req_clock < min_ready_clock)
-            min_ready_clock = req_clock;
+    int lane;
+    for (lane = 0; lane < SQ_NUM_LANES; lane++) {
+        list_for_each_entry(cq, &sq->ready_queues[lane], ready.node) {
+            // Update min_ready_clock
+            struct queue_message *qm = list_first_entry(
+                &cq->ready.msg_queue, struct queue_message, node);
+            uint64_t req_clock = qm->req_clock;
+            double bgtime = pending ? idletime : sq->idle_time;
+            double bgoffset = MIN_REQTIME_DELTA + MIN_BACKGROUND_DELTA;
+            if (req_clock == BACKGROUND_PRIORITY_CLOCK)
+                req_clock = clock_from_time(&sq->ce, bgtime + bgoffset);
+            if (req_clock < min_ready_clock)
+                min_ready_clock = req_clock;
+        }
     }
     uint64_t reqclock_delta = MIN_REQTIME_DELTA * sq->ce.est_freq;
     if (min_ready_clock <= ack_clock + reqclock_delta)
@@ -664,21 +1041,41 @@ static double
 command_event(struct serialqueue *sq, double eventtime)
 {
     pthread_mutex_lock(&sq->lock);
+    union { uint64_t bits; double time; } kick;
+    kick.bits = __atomic_exchange_n(&sq->kick_time_bits, 0, __ATOMIC_SEQ_CST);
+    if (kick.bits && eventtime > kick.time)
+        latency_record(sq->wakeup_hist, eventtime - kick.time);
     uint8_t buf[MESSAGE_MAX * MAX_PENDING_BLOCKS];
-    int buflen = 0;
+    uint8_t bulk_buf[MESSAGE_MAX * MAX_PENDING_BLOCKS];
+    int buflen = 0, bulk_len = 0;
     double waketime;
     for (;;) {
-        waketime = check_send_command(sq, buflen, eventtime);
+        waketime = check_send_command(sq, buflen + bulk_len, eventtime);
         if (waketime != PR_NOW)
             break;
-        buflen += build_and_send_command(sq, &buf[buflen], buflen, eventtime);
-        if (buflen + MESSAGE_MAX > sizeof(buf))
+        int is_bulk;
+        int len = build_and_send_command(sq, &buf[buflen], buflen + bulk_len
+                                         , eventtime, &is_bulk);
+        if (is_bulk) {
+            // Route background-only block to the bonded secondary link
+            memcpy(&bulk_buf[bulk_len], &buf[buflen], len);
+            bulk_len += len;
+        } else {
+            buflen += len;
+        }
+        if (buflen + bulk_len + MESSAGE_MAX > sizeof(buf))
             break;
     }
-    if (buflen) {
+    if (buflen || bulk_len) {
         // Write message blocks
-        do_write(sq, buf, buflen);
-        sq->bytes_write += buflen;
+        if (buflen)
+            do_write(sq, buf, buflen);
+        if (bulk_len) {
+            int ret = write(sq->secondary_fd, bulk_buf, bulk_len);
+            if (ret < 0)
+                report_errno("secondary write", ret);
+        }
+        sq->bytes_write += buflen + bulk_len;
         double idletime = eventtime > sq->idle_time ? eventtime : sq->idle_time;
         sq->idle_time = idletime + calculate_bittime(sq, buflen);
         waketime = PR_NOW;
@@ -692,6 +1089,7 @@ static void *
 background_thread(void *data)
 {
     struct serialqueue *sq = data;
+    sq->ktid = syscall(SYS_gettid);
     set_thread_name(sq->name);
     pollreactor_run(sq->pr);
 
@@ -716,21 +1114,21 @@ serialqueue_alloc(int serial_fd, char serial_fd_type, int client_id
     strncpy(sq->name, name, sizeof(sq->name));
     sq->name[sizeof(sq->name)-1] = '\0';
 
-    int ret = pipe(sq->transmit_requests.pipe_fds);
-    if (ret)
+    int ret = sq->transmit_requests.kick_fd = eventfd(0, EFD_NONBLOCK);
+    if (ret < 0)
         goto fail;
 
     // Reactor setup
     sq->pr = pollreactor_alloc(SQPF_NUM, SQPT_NUM, sq);
     pollreactor_add_fd(sq->pr, SQPF_SERIAL, serial_fd, input_event
                        , serial_fd_type==SQT_DEBUGFILE);
-    pollreactor_add_fd(sq->pr, SQPF_PIPE, sq->transmit_requests.pipe_fds[0]
+    pollreactor_add_fd(sq->pr, SQPF_KICK, sq->transmit_requests.kick_fd
                        , kick_event, 0);
+    sq->secondary_fd = -1;
+    pollreactor_add_fd(sq->pr, SQPF_SECONDARY, -1, secondary_input_event, 0);
     pollreactor_add_timer(sq->pr, SQPT_RETRANSMIT, retransmit_event);
     pollreactor_add_timer(sq->pr, SQPT_COMMAND, command_event);
     fd_set_non_blocking(serial_fd);
-    fd_set_non_blocking(sq->transmit_requests.pipe_fds[0]);
-    fd_set_non_blocking(sq->transmit_requests.pipe_fds[1]);
 
     // Retransmit setup
     sq->send_seq = 1;
@@ -748,11 +1146,17 @@ serialqueue_alloc(int serial_fd, char serial_fd_type, int client_id
     sq->transmit_requests.min_release_clock = MAX_CLOCK;
     list_init(&sq->transmit_requests.upcoming_queues);
     pthread_mutex_init(&sq->transmit_requests.lock, NULL);
-    list_init(&sq->ready_queues);
+    int lane;
+    for (lane=0; lane<SQ_NUM_LANES; lane++)
+        list_init(&sq->ready_queues[lane]);
     list_init(&sq->sent_queue);
     list_init(&sq->receiver.queue);
     list_init(&sq->notify_queue);
-    list_init(&sq->fast_readers);
+    int i;
+    for (i=0; i<FASTREADER_BUCKETS; i++)
+        list_init(&sq->fast_readers[i]);
+    list_init(&sq->fast_readers_any);
+    list_init(&sq->bulk_readers);
 
     // Debugging
     list_init(&sq->old_sent);
@@ -811,13 +1215,17 @@ serialqueue_free(struct serialqueue *sq)
     pthread_mutex_unlock(&sq->receiver.lock);
     message_queue_free(&sq->notify_queue);
     message_queue_free(&sq->old_sent);
-    while (!list_empty(&sq->ready_queues)) {
-        struct command_queue* cq = list_first_entry(
-            &sq->ready_queues, struct command_queue, ready.node);
-        list_del(&cq->ready.node);
-        message_queue_free(&cq->ready.msg_queue);
+    int lane;
+    for (lane=0; lane<SQ_NUM_LANES; lane++) {
+        while (!list_empty(&sq->ready_queues[lane])) {
+            struct command_queue* cq = list_first_entry(
+                &sq->ready_queues[lane], struct command_queue, ready.node);
+            list_del(&cq->ready.node);
+            message_queue_free(&cq->ready.msg_queue);
+        }
     }
     pthread_mutex_lock(&sq->transmit_requests.lock);
+    drain_submit_ring(sq);
     while (!list_empty(&sq->transmit_requests.upcoming_queues)) {
         struct command_queue *cq = list_first_entry(
             &sq->transmit_requests.upcoming_queues,
@@ -827,6 +1235,7 @@ serialqueue_free(struct serialqueue *sq)
     }
     pthread_mutex_unlock(&sq->transmit_requests.lock);
     pthread_mutex_unlock(&sq->lock);
+    serialqueue_stop_record(sq);
     pollreactor_free(sq->pr);
     free(sq);
 }
@@ -839,9 +1248,20 @@ serialqueue_alloc_commandqueue(void)
     memset(cq, 0, sizeof(*cq));
     list_init(&cq->ready.msg_queue);
     list_init(&cq->upcoming.msg_queue);
+    cq->lane = SQ_LANE_NORMAL;
     return cq;
 }
 
+// Assign a command_queue to a transmit priority lane.  Must be called
+// before the first message is sent on the queue.
+void __visible
+serialqueue_set_commandqueue_lane(struct command_queue *cq, int lane)
+{
+    if (lane < 0 || lane >= SQ_NUM_LANES)
+        return;
+    cq->lane = lane;
+}
+
 // Free a 'struct command_queue'
 void __visible
 serialqueue_free_commandqueue(struct command_queue *cq)
@@ -860,8 +1280,12 @@ serialqueue_free_commandqueue(struct command_queue *cq)
 void
 serialqueue_add_fastreader(struct serialqueue *sq, struct fastreader *fr)
 {
+    struct list_head *frs = &sq->fast_readers_any;
+    if (fr->prefix_len >= 2)
+        frs = &sq->fast_readers[fastreader_bucket(fr->prefix[0]
+                                                  , fr->prefix[1])];
     pthread_mutex_lock(&sq->lock);
-    list_add_tail(&fr->node, &sq->fast_readers);
+    list_add_tail(&fr->node, frs);
     pthread_mutex_unlock(&sq->lock);
 }
 
@@ -877,12 +1301,83 @@ serialqueue_rm_fastreader(struct serialqueue *sq, struct fastreader *fr)
     pthread_mutex_unlock(&sq->fast_reader_dispatch_lock);
 }
 
-// Add a batch of messages to the given command_queue
+// Register a bulk consumer ring.  Data messages holding exactly one
+// command that starts with 'prefix' (encoded msgid and leading
+// parameters - typically the oid) are diverted into the ring and no
+// longer reported via serialqueue_pull().  The command must consist of
+// 'num_int_params' vlq integers after the prefix followed by at most
+// one buffer parameter.
+struct bulkreader * __visible
+serialqueue_alloc_bulkreader(struct serialqueue *sq, uint8_t *prefix
+                             , int prefix_len, int num_int_params
+                             , int ring_size)
+{
+    struct bulkreader *br = malloc(sizeof(*br)
+                                   + ring_size * sizeof(br->ring[0]));
+    memset(br, 0, sizeof(*br));
+    memcpy(br->prefix, prefix, prefix_len);
+    br->prefix_len = prefix_len;
+    br->num_int_params = num_int_params;
+    br->ring_size = ring_size;
+    pthread_mutex_lock(&sq->lock);
+    list_add_tail(&br->node, &sq->bulk_readers);
+    pthread_mutex_unlock(&sq->lock);
+    return br;
+}
+
+// Unregister and free a bulk consumer ring
+void __visible
+serialqueue_free_bulkreader(struct serialqueue *sq, struct bulkreader *br)
+{
+    if (!br)
+        return;
+    pthread_mutex_lock(&sq->lock);
+    list_del(&br->node);
+    pthread_mutex_unlock(&sq->lock);
+    free(br);
+}
+
+// Report the number of samples available in a bulk consumer ring
+int __visible
+serialqueue_bulkreader_count(struct bulkreader *br)
+{
+    uint32_t tail = __atomic_load_n(&br->ring_tail, __ATOMIC_ACQUIRE);
+    return tail - br->ring_head;
+}
+
+// Obtain a sample from a bulk consumer ring (without consuming it).
+// The sample remains valid until 'idx' samples are popped.
+struct bulk_sample * __visible
+serialqueue_bulkreader_peek(struct bulkreader *br, int idx)
+{
+    return &br->ring[(br->ring_head + idx) % br->ring_size];
+}
+
+// Release the oldest 'count' samples of a bulk consumer ring
+void __visible
+serialqueue_bulkreader_pop(struct bulkreader *br, int count)
+{
+    __atomic_store_n(&br->ring_head, br->ring_head + count
+                     , __ATOMIC_RELEASE);
+}
+
+// Report the number of samples dropped due to a full ring
+int __visible
+serialqueue_bulkreader_overflows(struct bulkreader *br)
+{
+    return br->overflows;
+}
+
+// Add a batch of messages to the given command_queue.  May be invoked
+// concurrently from multiple threads (cffi releases the GIL during C
+// calls) as well as from fastreader callbacks running on the
+// background thread itself.
 void
 serialqueue_send_batch(struct serialqueue *sq, struct command_queue *cq
                        , struct list_head *msgs)
 {
     // Make sure min_clock is set in list and calculate total bytes
+    double queued_time = get_monotonic();
     int len = 0;
     struct queue_message *qm;
     list_for_each_entry(qm, msgs, node) {
@@ -890,6 +1385,7 @@ serialqueue_send_batch(struct serialqueue *sq, struct command_queue *cq
             && qm->req_clock != BACKGROUND_PRIORITY_CLOCK)
             // Avoid mcu clock comparison 31-bit overflow issues
             qm->min_clock = qm->req_clock - (3LL<<29);
+        qm->queued_time = queued_time;
         len += qm->len;
     }
     if (! len)
@@ -897,26 +1393,50 @@ serialqueue_send_batch(struct serialqueue *sq, struct command_queue *cq
     qm = list_first_entry(msgs, struct queue_message, node);
     uint64_t min_clock = qm->min_clock;
 
-    // Add list to cq->upcoming_queue
-    int mustwake = 0;
-    pthread_mutex_lock(&sq->transmit_requests.lock);
-    if (list_empty(&cq->upcoming.msg_queue)) {
-        list_add_tail(&cq->upcoming.node,
-            &sq->transmit_requests.upcoming_queues);
-        if (min_clock < sq->transmit_requests.min_release_clock)
-            sq->transmit_requests.min_release_clock = min_clock;
-        if (min_clock < sq->transmit_requests.need_kick_clock) {
-            sq->transmit_requests.need_kick_clock = 0;
-            mustwake = 1;
+    struct transmit_requests *tr = &sq->transmit_requests;
+    if (pthread_equal(pthread_self(), sq->tid)) {
+        // Called from the background thread itself (eg, a fastreader
+        // callback in trdispatch.c) - waiting on ring space here
+        // could deadlock against ourselves, so add directly to the
+        // upcoming queues instead.  Drain the ring first to preserve
+        // per-queue message ordering.
+        drain_submit_ring(sq);
+        struct queue_message *_nqm;
+        list_for_each_entry_safe(qm, _nqm, msgs, node) {
+            list_del(&qm->node);
+            add_upcoming_message(sq, cq, qm);
         }
+        pollreactor_update_timer(sq->pr, SQPT_COMMAND, PR_NOW);
+        return;
     }
-    list_join_tail(msgs, &cq->upcoming.msg_queue);
-    sq->transmit_requests.upcoming_bytes += len;
-    pthread_mutex_unlock(&sq->transmit_requests.lock);
 
-    // Wake the background thread if necessary
-    if (mustwake)
+    // Push the messages onto the submission ring
+    pthread_mutex_lock(&tr->lock);
+    uint32_t tail = tr->ring_tail;
+    struct queue_message *_nqm;
+    list_for_each_entry_safe(qm, _nqm, msgs, node) {
+        uint32_t head = __atomic_load_n(&tr->ring_head, __ATOMIC_ACQUIRE);
+        while (tail - head >= SUBMIT_RING_SIZE) {
+            // Ring full - wake the background thread and wait for space
+            kick_bg_thread(sq);
+            usleep(100);
+            head = __atomic_load_n(&tr->ring_head, __ATOMIC_ACQUIRE);
+        }
+        list_del(&qm->node);
+        tr->ring[tail % SUBMIT_RING_SIZE].cq = cq;
+        tr->ring[tail % SUBMIT_RING_SIZE].qm = qm;
+        tail++;
+        __atomic_store_n(&tr->ring_tail, tail, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&tr->lock);
+
+    // Wake the background thread if it announced a later sleep target
+    uint64_t kick_clock = __atomic_load_n(&tr->need_kick_clock
+                                          , __ATOMIC_SEQ_CST);
+    if (min_clock < kick_clock) {
+        __atomic_store_n(&tr->need_kick_clock, 0, __ATOMIC_SEQ_CST);
         kick_bg_thread(sq);
+    }
 }
 
 // Helper to send a single message
@@ -930,6 +1450,29 @@ serialqueue_send_one(struct serialqueue *sq, struct command_queue *cq
     serialqueue_send_batch(sq, cq, &msgs);
 }
 
+// Encode a series of commands that share one message template and
+// schedule their transmission.  'params' contains the integer
+// parameters of all the commands back to back.
+void __visible
+serialqueue_send_template(struct serialqueue *sq, struct command_queue *cq
+                          , struct mp_format *mf, int64_t *params
+                          , int num_cmds, uint64_t min_clock
+                          , uint64_t req_clock)
+{
+    int num_params = msgproto_format_num_params(mf);
+    struct list_head msgs;
+    list_init(&msgs);
+    int i;
+    for (i = 0; i < num_cmds; i++) {
+        struct queue_message *qm = message_alloc();
+        qm->len = msgproto_encode_ints(mf, qm->msg, &params[i * num_params]);
+        qm->min_clock = min_clock;
+        qm->req_clock = req_clock;
+        list_add_tail(&qm->node, &msgs);
+    }
+    serialqueue_send_batch(sq, cq, &msgs);
+}
+
 // Schedule the transmission of a message on the serial port at a
 // given time and priority.
 void __visible
@@ -983,6 +1526,17 @@ exit:
     pthread_mutex_unlock(&receiver->lock);
 }
 
+// Switch a canbus connection to CAN-FD framing with bit-rate
+// switching.  Called once the identify handshake (done with classic
+// frames) reports that the firmware was built with CAN-FD support.
+void __visible
+serialqueue_set_canbus_fd(struct serialqueue *sq)
+{
+    pthread_mutex_lock(&sq->lock);
+    sq->canbus_fd = 1;
+    pthread_mutex_unlock(&sq->lock);
+}
+
 void __visible
 serialqueue_set_wire_frequency(struct serialqueue *sq, double frequency)
 {
@@ -996,6 +1550,22 @@ serialqueue_set_wire_frequency(struct serialqueue *sq, double frequency)
     pthread_mutex_unlock(&sq->lock);
 }
 
+// Bond a second physical link carrying the same message stream.  Must
+// be called before the first command is sent.  Blocks containing only
+// background priority messages are routed to the secondary link; acks,
+// step traffic, and retransmits stay on the (lower latency) primary.
+void __visible
+serialqueue_set_secondary_fd(struct serialqueue *sq, int secondary_fd)
+{
+    fd_set_non_blocking(secondary_fd);
+    pthread_mutex_lock(&sq->lock);
+    pollreactor_add_fd(sq->pr, SQPF_SECONDARY, secondary_fd
+                       , secondary_input_event, 0);
+    sq->secondary_fd = secondary_fd;
+    pthread_mutex_unlock(&sq->lock);
+    kick_bg_thread(sq);
+}
+
 void __visible
 serialqueue_set_receive_window(struct serialqueue *sq, int receive_window)
 {
@@ -1004,6 +1574,35 @@ serialqueue_set_receive_window(struct serialqueue *sq, int receive_window)
     pthread_mutex_unlock(&sq->lock);
 }
 
+// Pin the background thread to a cpu (cpu < 0 leaves affinity
+// unchanged) and optionally give it a SCHED_FIFO transmit priority
+int __visible
+serialqueue_set_cpu_layout(struct serialqueue *sq, int cpu, int rt_priority)
+{
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        int ret = pthread_setaffinity_np(sq->tid, sizeof(cpus), &cpus);
+        if (ret)
+            return ret;
+    }
+    if (rt_priority > 0) {
+        struct sched_param sp = { .sched_priority = rt_priority };
+        int ret = pthread_setschedparam(sq->tid, SCHED_FIFO, &sp);
+        if (ret)
+            return ret;
+    }
+    return 0;
+}
+
+// Return the kernel thread id of the background thread
+int __visible
+serialqueue_get_thread_id(struct serialqueue *sq)
+{
+    return sq->ktid;
+}
+
 // Set the estimated clock rate of the mcu on the other end of the
 // serial port
 void __visible
@@ -1025,6 +1624,59 @@ serialqueue_get_clock_est(struct serialqueue *sq, struct clock_estimate *ce)
     pthread_mutex_unlock(&sq->lock);
 }
 
+// Start recording traffic to a memory-mapped capture file
+int __visible
+serialqueue_start_record(struct serialqueue *sq, const char *filename
+                         , uint32_t num_records)
+{
+    if (!num_records)
+        num_records = 16384;
+    int fd = open(filename, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) {
+        report_errno("record open", fd);
+        return -1;
+    }
+    size_t size = sizeof(struct record_header)
+        + num_records * sizeof(struct record_entry);
+    int ret = ftruncate(fd, size);
+    if (ret < 0) {
+        report_errno("record truncate", ret);
+        close(fd);
+        return -1;
+    }
+    void *m = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        report_errno("record mmap", -1);
+        return -1;
+    }
+    struct record_header *hdr = m;
+    hdr->magic = RECORD_MAGIC;
+    hdr->version = RECORD_VERSION;
+    hdr->num_records = num_records;
+    hdr->next_index = 0;
+    pthread_mutex_lock(&sq->lock);
+    sq->record_buf = (void *)(hdr + 1);
+    sq->record_size = size;
+    sq->record_hdr = hdr;
+    pthread_mutex_unlock(&sq->lock);
+    return 0;
+}
+
+// Stop recording and flush the capture file
+void __visible
+serialqueue_stop_record(struct serialqueue *sq)
+{
+    pthread_mutex_lock(&sq->lock);
+    struct record_header *hdr = sq->record_hdr;
+    size_t size = sq->record_size;
+    sq->record_hdr = NULL;
+    sq->record_buf = NULL;
+    pthread_mutex_unlock(&sq->lock);
+    if (hdr)
+        munmap(hdr, size);
+}
+
 // Return a string buffer containing statistics for the serial port
 void __visible
 serialqueue_get_stats(struct serialqueue *sq, char *buf, int len)
@@ -1040,13 +1692,30 @@ serialqueue_get_stats(struct serialqueue *sq, char *buf, int len)
              " bytes_retransmit=%u bytes_invalid=%u"
              " send_seq=%u receive_seq=%u retransmit_seq=%u"
              " srtt=%.3f rttvar=%.3f rto=%.3f"
-             " ready_bytes=%u upcoming_bytes=%u"
+             " link0_srtt=%.3f link1_srtt=%.3f"
+             " min_rtt=%.3f delivery_rate=%.0f adaptive_window=%d"
+             " ready_bytes=%u upcoming_bytes=%u msg_pool=%d"
              , stats.bytes_write, stats.bytes_read
              , stats.bytes_retransmit, stats.bytes_invalid
              , (int)stats.send_seq, (int)stats.receive_seq
              , (int)stats.retransmit_seq
              , stats.srtt, stats.rttvar, stats.rto
-             , stats.ready_bytes, stats.transmit_requests.upcoming_bytes);
+             , stats.link_srtt[0], stats.link_srtt[1]
+             , stats.min_rtt, stats.delivery_rate, stats.adaptive_window
+             , stats.ready_bytes, stats.transmit_requests.upcoming_bytes
+             , message_pool_occupancy());
+}
+
+// Fill 'buf' (3 * LATENCY_BUCKETS counters) with the latency histograms
+// (command queue dwell time, wire round-trip time, wakeup-to-write time)
+void __visible
+serialqueue_get_latency_histograms(struct serialqueue *sq, uint32_t *buf)
+{
+    pthread_mutex_lock(&sq->lock);
+    memcpy(&buf[0], sq->dwell_hist, sizeof(sq->dwell_hist));
+    memcpy(&buf[LATENCY_BUCKETS], sq->rtt_hist, sizeof(sq->rtt_hist));
+    memcpy(&buf[2*LATENCY_BUCKETS], sq->wakeup_hist, sizeof(sq->wakeup_hist));
+    pthread_mutex_unlock(&sq->lock);
 }
 
 // Extract old messages stored in the debug queues
@@ -8,6 +8,12 @@
 #define MAX_CLOCK 0x7fffffffffffffffLL
 #define BACKGROUND_PRIORITY_CLOCK 0x7fffffff00000000LL
 
+// Transmit priority lanes (drained in strict priority order)
+enum {
+    SQ_LANE_REALTIME = 0, SQ_LANE_NORMAL = 1, SQ_LANE_BULK = 2,
+    SQ_NUM_LANES = 3,
+};
+
 struct fastreader;
 typedef void (*fastreader_cb)(struct fastreader *fr, uint8_t *data, int len);
 
@@ -25,6 +31,16 @@ struct pull_queue_message {
     uint64_t notify_id;
 };
 
+#define BULK_SAMPLE_DATA_MAX (MESSAGE_MAX - MESSAGE_MIN)
+
+struct bulk_sample {
+    double receive_time;
+    uint32_t len;
+    uint8_t data[BULK_SAMPLE_DATA_MAX];
+};
+
+struct bulkreader;
+
 struct serialqueue;
 struct serialqueue *serialqueue_alloc(int serial_fd, char serial_fd_type
                                       , int client_id, char name[16]);
@@ -32,8 +48,19 @@ void serialqueue_exit(struct serialqueue *sq);
 void serialqueue_free(struct serialqueue *sq);
 struct command_queue *serialqueue_alloc_commandqueue(void);
 void serialqueue_free_commandqueue(struct command_queue *cq);
+void serialqueue_set_commandqueue_lane(struct command_queue *cq, int lane);
 void serialqueue_add_fastreader(struct serialqueue *sq, struct fastreader *fr);
 void serialqueue_rm_fastreader(struct serialqueue *sq, struct fastreader *fr);
+struct bulkreader *serialqueue_alloc_bulkreader(
+    struct serialqueue *sq, uint8_t *prefix, int prefix_len
+    , int num_int_params, int ring_size);
+void serialqueue_free_bulkreader(struct serialqueue *sq
+                                 , struct bulkreader *br);
+int serialqueue_bulkreader_count(struct bulkreader *br);
+struct bulk_sample *serialqueue_bulkreader_peek(struct bulkreader *br
+                                                , int idx);
+void serialqueue_bulkreader_pop(struct bulkreader *br, int count);
+int serialqueue_bulkreader_overflows(struct bulkreader *br);
 void serialqueue_send_batch(struct serialqueue *sq, struct command_queue *cq
                             , struct list_head *msgs);
 void serialqueue_send_one(struct serialqueue *sq, struct command_queue *cq
@@ -42,14 +69,23 @@ void serialqueue_send(struct serialqueue *sq, struct command_queue *cq
                       , uint8_t *msg, int len, uint64_t min_clock
                       , uint64_t req_clock, uint64_t notify_id);
 void serialqueue_pull(struct serialqueue *sq, struct pull_queue_message *pqm);
+void serialqueue_set_secondary_fd(struct serialqueue *sq, int secondary_fd);
+void serialqueue_set_canbus_fd(struct serialqueue *sq);
 void serialqueue_set_wire_frequency(struct serialqueue *sq, double frequency);
 void serialqueue_set_receive_window(struct serialqueue *sq, int receive_window);
+int serialqueue_set_cpu_layout(struct serialqueue *sq, int cpu
+                               , int rt_priority);
+int serialqueue_get_thread_id(struct serialqueue *sq);
 void serialqueue_set_clock_est(struct serialqueue *sq, double est_freq
                                , double conv_time, uint64_t conv_clock
                                , uint64_t last_clock);
 void serialqueue_get_clock_est(struct serialqueue *sq
                                , struct clock_estimate *ce);
+int serialqueue_start_record(struct serialqueue *sq, const char *filename
+                             , uint32_t num_records);
+void serialqueue_stop_record(struct serialqueue *sq);
 void serialqueue_get_stats(struct serialqueue *sq, char *buf, int len);
+void serialqueue_get_latency_histograms(struct serialqueue *sq, uint32_t *buf);
 int serialqueue_extract_old(struct serialqueue *sq, int sentq
                             , struct pull_queue_message *q, int max);
 
@@ -0,0 +1,94 @@
+// Shared memory ring buffer for exporting telemetry records
+//
+// Copyright (C) 2025  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+// External consumers mmap the ring file read-only.  The writer stores
+// a record into slot (sequence % num_records) and then publishes it
+// with a release store of the incremented sequence; a reader that
+// rechecks the sequence after copying a slot can detect torn reads
+// without any locking or socket traffic.
+
+#include <fcntl.h> // open
+#include <stdlib.h> // malloc
+#include <string.h> // memcpy
+#include <unistd.h> // close, ftruncate
+#include <sys/mman.h> // mmap
+#include "compiler.h" // __visible
+#include "shmring.h" // shmring_open
+
+#define SHMRING_MAGIC 0x4b4c5348 // "KLSH"
+#define SHMRING_VERSION 1
+
+struct shmring_hdr {
+    uint32_t magic, version;
+    uint32_t record_size, num_records;
+    uint64_t sequence;
+};
+
+struct shmring {
+    struct shmring_hdr *hdr;
+    char *records;
+    uint32_t record_size, num_records;
+    size_t map_size;
+};
+
+// Create (or overwrite) a ring file and map it for writing
+struct shmring * __visible
+shmring_open(const char *filename, uint32_t record_size
+             , uint32_t num_records)
+{
+    size_t map_size = (sizeof(struct shmring_hdr)
+                       + (size_t)record_size * num_records);
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return NULL;
+    int ret = ftruncate(fd, map_size);
+    if (ret) {
+        close(fd);
+        return NULL;
+    }
+    void *mem = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED
+                     , fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return NULL;
+    struct shmring *sr = malloc(sizeof(*sr));
+    memset(sr, 0, sizeof(*sr));
+    sr->hdr = mem;
+    sr->records = (char *)mem + sizeof(struct shmring_hdr);
+    sr->record_size = record_size;
+    sr->num_records = num_records;
+    sr->map_size = map_size;
+    memset(mem, 0, sizeof(struct shmring_hdr));
+    sr->hdr->record_size = record_size;
+    sr->hdr->num_records = num_records;
+    sr->hdr->version = SHMRING_VERSION;
+    __atomic_store_n(&sr->hdr->magic, SHMRING_MAGIC, __ATOMIC_RELEASE);
+    return sr;
+}
+
+// Unmap the ring file
+void __visible
+shmring_close(struct shmring *sr)
+{
+    munmap(sr->hdr, sr->map_size);
+    free(sr);
+}
+
+// Publish one record (only called from a single writer thread)
+void
+shmring_write(struct shmring *sr, const void *data)
+{
+    uint64_t seq = sr->hdr->sequence;
+    memcpy(&sr->records[(seq % sr->num_records) * sr->record_size]
+           , data, sr->record_size);
+    __atomic_store_n(&sr->hdr->sequence, seq + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t __visible
+shm_motion_record_size(void)
+{
+    return sizeof(struct shm_motion_record);
+}
@@ -0,0 +1,32 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdint.h> // uint32_t
+
+// Binary telemetry record exported via the shared memory ring
+struct shm_motion_record {
+    uint32_t record_type, oid;
+    union {
+        struct {
+            double print_time, move_t, start_v, accel;
+            double start_x, start_y, start_z, x_r, y_r, z_r;
+        } move;
+        struct {
+            uint64_t first_clock, last_clock;
+            int64_t start_position;
+            int32_t interval, count, add;
+        } steps;
+    };
+};
+
+enum {
+    SHM_RECORD_MOVE = 1, SHM_RECORD_STEPS = 2,
+};
+
+struct shmring *shmring_open(const char *filename, uint32_t record_size
+                             , uint32_t num_records);
+void shmring_close(struct shmring *sr);
+void shmring_write(struct shmring *sr, const void *data);
+uint32_t shm_motion_record_size(void);
+
+#endif // shmring.h
@@ -23,6 +23,7 @@
 #include "compiler.h" // DIV_ROUND_UP
 #include "pyhelper.h" // errorf
 #include "serialqueue.h" // struct queue_message
+#include "shmring.h" // shmring_write
 #include "stepcompress.h" // stepcompress_alloc
 
 #define CHECK_LINES 1
@@ -34,6 +35,20 @@ struct qstep {
     uint32_t clock32;
 };
 
+// Parameters of a single queue_step command
+struct step_move {
+    uint32_t interval;
+    uint16_t count;
+    int16_t add;
+};
+
+// Span of queued steps sharing one velocity derived error budget
+struct error_span {
+    uint64_t start_clock;
+    uint32_t max_error;
+};
+#define NUM_ERROR_SPANS 16
+
 // Main stepcompress object storage
 struct stepcompress {
     // Buffer management
@@ -41,35 +56,97 @@ struct stepcompress {
     // Internal tracking
     uint32_t max_error;
     double mcu_time_offset, mcu_freq, last_step_print_time;
+    // Velocity driven error budget
+    uint32_t highspeed_error, cur_error;
+    double error_vel_ref, last_move_velocity;
+    int num_error_spans, pending_error_span;
+    struct error_span error_spans[NUM_ERROR_SPANS];
     // Message generation
     uint64_t last_step_clock;
     struct list_head *msg_queue;
     uint32_t oid;
     int32_t queue_step_msgtag, set_next_step_dir_msgtag;
+    int32_t queue_step_repeat_msgtag;
     int sdir, invert_sdir;
+    // Coalescing of identical queue_step commands
+    struct step_move pending;
+    uint64_t pending_min_clock, pending_req_clock;
+    uint32_t pending_repeat;
+    // Limit on runs batched into one command (mcu move queue size)
+    uint32_t move_limit;
+    // Delta packing of consecutive queue_step commands
+    int32_t queue_step_pack_msgtag;
+    struct step_move pack_first;
+    uint32_t pack_last_interval;
+    int pack_len, pack_count;
+    uint64_t pack_min_clock, pack_req_clock;
+    uint8_t pack_data[48];
+    uint64_t pack_clocks[QM_MAX_MOVES];
     // Step+dir+step filter
     uint64_t next_step_clock;
     int next_step_dir;
-    // History tracking
+    // History tracking (ring of records ordered by clock)
     int64_t last_position;
-    struct list_head history_list;
-};
-
-// Parameters of a single queue_step command
-struct step_move {
-    uint32_t interval;
-    uint16_t count;
-    int16_t add;
+    struct history_steps *history;
+    int history_alloc, history_first, history_count;
+    // Cache of per-step bounds during compression
+    struct points *bounds_cache;
+    int bounds_cache_alloc;
+    // Optional shared memory telemetry export
+    struct shmring *export_ring;
 };
 
 // Storage for internal history of recently sent queue_step commands
 struct history_steps {
-    struct list_node node;
     uint64_t first_clock, last_clock;
     int64_t start_position;
     int step_count, interval, add;
 };
 
+#define HISTORY_START_SIZE 128
+
+// Access a history record (idx 0 is the oldest stored record)
+static inline struct history_steps *
+history_entry(struct stepcompress *sc, int idx)
+{
+    return &sc->history[(sc->history_first + idx) % sc->history_alloc];
+}
+
+// Append a new record to the history ring (clocks must be in order)
+static struct history_steps *
+history_append(struct stepcompress *sc)
+{
+    if (sc->history_count >= sc->history_alloc) {
+        // Grow the ring (copying the records back into clock order)
+        int alloc = sc->history_alloc ? 2 * sc->history_alloc
+            : HISTORY_START_SIZE;
+        struct history_steps *nh = malloc(alloc * sizeof(*nh));
+        int i;
+        for (i=0; i<sc->history_count; i++)
+            nh[i] = *history_entry(sc, i);
+        free(sc->history);
+        sc->history = nh;
+        sc->history_alloc = alloc;
+        sc->history_first = 0;
+    }
+    return history_entry(sc, sc->history_count++);
+}
+
+// Find the newest history record with first_clock <= clock (or -1)
+static int
+history_search(struct stepcompress *sc, uint64_t clock)
+{
+    int lo = 0, hi = sc->history_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (history_entry(sc, mid)->first_clock <= clock)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+
 
 /****************************************************************
  * Step compression
@@ -98,9 +175,20 @@ minmax_point(struct stepcompress *sc, struct qstep *pos)
 {
     uint32_t lsc = sc->last_step_clock, point = pos->clock32 - lsc;
     uint32_t prevpoint = pos > sc->queue_pos ? (pos-1)->clock32 - lsc : 0;
+    uint32_t budget = sc->max_error;
+    if (sc->num_error_spans) {
+        // Use the velocity derived budget covering this step
+        uint64_t abs_clock = sc->last_step_clock + point;
+        int i;
+        for (i = sc->num_error_spans - 1; i >= 0; i--)
+            if (sc->error_spans[i].start_clock <= abs_clock) {
+                budget = sc->error_spans[i].max_error;
+                break;
+            }
+    }
     uint32_t max_error = (point - prevpoint) / 2;
-    if (max_error > sc->max_error)
-        max_error = sc->max_error;
+    if (max_error > budget)
+        max_error = budget;
     return (struct points){ point - max_error, point };
 }
 
@@ -117,7 +205,20 @@ compress_bisect_add(struct stepcompress *sc)
     struct qstep *qlast = sc->queue_next;
     if (qlast > sc->queue_pos + 65535)
         qlast = sc->queue_pos + 65535;
-    struct points point = minmax_point(sc, sc->queue_pos);
+    // The per-step bounds are invariant while searching for the best
+    // (interval, count, add) - fill them on demand and reuse them
+    // across the bisection passes.
+    int avail = qlast - sc->queue_pos;
+    if (sc->bounds_cache_alloc < avail) {
+        sc->bounds_cache = realloc(sc->bounds_cache
+                                   , avail * sizeof(*sc->bounds_cache));
+        sc->bounds_cache_alloc = avail;
+    }
+    struct points *bounds = sc->bounds_cache;
+    bounds[0] = minmax_point(sc, sc->queue_pos);
+    int num_bounds = 1;
+    int32_t max_width = bounds[0].maxp - bounds[0].minp;
+    struct points point = bounds[0];
     int32_t outer_mininterval = point.minp, outer_maxinterval = point.maxp;
     int32_t add = 0, minadd = -0x8000, maxadd = 0x7fff;
     int32_t bestinterval = 0, bestcount = 1, bestadd = 1, bestreach = INT32_MIN;
@@ -135,7 +236,16 @@ compress_bisect_add(struct stepcompress *sc)
                 int32_t count = nextcount - 1;
                 return (struct step_move){ interval, count, add };
             }
-            nextpoint = minmax_point(sc, sc->queue_pos + nextcount - 1);
+            while (num_bounds < nextcount) {
+                bounds[num_bounds] = minmax_point(
+                    sc, sc->queue_pos + num_bounds);
+                int32_t width = (bounds[num_bounds].maxp
+                                 - bounds[num_bounds].minp);
+                if (width > max_width)
+                    max_width = width;
+                num_bounds++;
+            }
+            nextpoint = bounds[nextcount - 1];
             int32_t nextaddfactor = nextcount*(nextcount-1)/2;
             int32_t c = add*nextaddfactor;
             if (nextmininterval*nextcount < nextpoint.minp - c)
@@ -179,7 +289,9 @@ compress_bisect_add(struct stepcompress *sc)
         // The maximum valid deviation between two quadratic sequences
         // can be calculated and used to further limit the add range.
         if (count > 1) {
-            int32_t errdelta = sc->max_error*QUADRATIC_DEV / (count*count);
+            // The bound scales with the widest per-step window actually
+            // in use (error spans can widen or narrow it)
+            int32_t errdelta = max_width*QUADRATIC_DEV / (count*count);
             if (minadd < add - errdelta)
                 minadd = add - errdelta;
             if (maxadd > add + errdelta)
@@ -256,21 +368,85 @@ stepcompress_alloc(struct list_head *msg_queue)
 {
     struct stepcompress *sc = malloc(sizeof(*sc));
     memset(sc, 0, sizeof(*sc));
-    list_init(&sc->history_list);
     sc->sdir = -1;
     sc->msg_queue = msg_queue;
+    sc->move_limit = 0xffff;
     return sc;
 }
 
 // Fill message id information
 void __visible
 stepcompress_fill(struct stepcompress *sc, uint32_t oid, uint32_t max_error
-                  , int32_t queue_step_msgtag, int32_t set_next_step_dir_msgtag)
+                  , int32_t queue_step_msgtag, int32_t set_next_step_dir_msgtag
+                  , int32_t queue_step_repeat_msgtag
+                  , int32_t queue_step_pack_msgtag)
 {
     sc->oid = oid;
     sc->max_error = max_error;
     sc->queue_step_msgtag = queue_step_msgtag;
     sc->set_next_step_dir_msgtag = set_next_step_dir_msgtag;
+    sc->queue_step_repeat_msgtag = queue_step_repeat_msgtag;
+    sc->queue_step_pack_msgtag = queue_step_pack_msgtag;
+}
+
+// Configure the optional velocity driven error budget: moves at (or
+// above) vel_ref may use the larger highspeed_error budget, scaling
+// linearly down to the base max_error for stationary moves
+void __visible
+stepcompress_set_error_velocity(struct stepcompress *sc
+                                , uint32_t highspeed_error, double vel_ref)
+{
+    sc->highspeed_error = highspeed_error;
+    sc->error_vel_ref = vel_ref;
+}
+
+// Limit the number of runs batched into a single command (so one
+// command can not oversubscribe the mcu move queue)
+void
+stepcompress_set_move_limit(struct stepcompress *sc, int move_limit)
+{
+    if (move_limit < 1)
+        move_limit = 1;
+    if (move_limit > 0xffff)
+        move_limit = 0xffff;
+    sc->move_limit = move_limit;
+}
+
+// Note the commanded velocity of the move steps are being generated for
+void
+stepcompress_note_velocity(struct stepcompress *sc, double velocity)
+{
+    if (sc->error_vel_ref <= 0. || velocity == sc->last_move_velocity)
+        return;
+    sc->last_move_velocity = velocity;
+    double frac = velocity / sc->error_vel_ref;
+    if (frac > 1.)
+        frac = 1.;
+    uint32_t budget = sc->max_error + (uint32_t)(
+        ((double)sc->highspeed_error - (double)sc->max_error) * frac);
+    if (budget == sc->cur_error)
+        return;
+    sc->cur_error = budget;
+    sc->pending_error_span = 1;
+}
+
+// Start a new error budget span at the given step clock
+static void
+note_error_span(struct stepcompress *sc, uint64_t start_clock)
+{
+    sc->pending_error_span = 0;
+    if (sc->num_error_spans) {
+        struct error_span *last = &sc->error_spans[sc->num_error_spans - 1];
+        if (last->start_clock >= start_clock
+            || sc->num_error_spans >= NUM_ERROR_SPANS) {
+            // Replace a span not yet in effect (or merge when full)
+            last->max_error = sc->cur_error;
+            return;
+        }
+    }
+    struct error_span *es = &sc->error_spans[sc->num_error_spans++];
+    es->start_clock = start_clock;
+    es->max_error = sc->cur_error;
 }
 
 // Set the inverted stepper direction flag
@@ -289,13 +465,12 @@ stepcompress_set_invert_sdir(struct stepcompress *sc, uint32_t invert_sdir)
 void
 stepcompress_history_expire(struct stepcompress *sc, uint64_t end_clock)
 {
-    while (!list_empty(&sc->history_list)) {
-        struct history_steps *hs = list_last_entry(
-            &sc->history_list, struct history_steps, node);
+    while (sc->history_count) {
+        struct history_steps *hs = history_entry(sc, 0);
         if (hs->last_clock > end_clock)
             break;
-        list_del(&hs->node);
-        free(hs);
+        sc->history_first = (sc->history_first + 1) % sc->history_alloc;
+        sc->history_count--;
     }
 }
 
@@ -306,7 +481,8 @@ stepcompress_free(struct stepcompress *sc)
     if (!sc)
         return;
     free(sc->queue);
-    stepcompress_history_expire(sc, UINT64_MAX);
+    free(sc->bounds_cache);
+    free(sc->history);
     free(sc);
 }
 
@@ -343,7 +519,139 @@ stepcompress_set_time(struct stepcompress *sc
 // Maximium clock delta between messages in the queue
 #define CLOCK_DIFF_MAX (3<<28)
 
+// Maximum packed payload bytes in a queue_step_pack command (each
+// run encodes to at least 3 bytes, keeping runs within QM_MAX_MOVES)
+#define PACK_DATA_MAX 48
+
+// Generate the message for buffered delta packed queue_step commands
+static void
+flush_pack(struct stepcompress *sc)
+{
+    if (!sc->pack_count)
+        return;
+    struct queue_message *qm;
+    if (sc->pack_count == 1) {
+        // A lone run encodes smaller as a regular queue_step command
+        uint32_t msg[5] = {
+            sc->queue_step_msgtag, sc->oid, sc->pack_first.interval
+            , sc->pack_first.count, sc->pack_first.add
+        };
+        qm = message_alloc_and_encode(msg, 5);
+    } else {
+        qm = message_alloc();
+        uint8_t *p = qm->msg;
+        p = msgblock_encode_int(p, sc->queue_step_pack_msgtag);
+        p = msgblock_encode_int(p, sc->oid);
+        *p++ = sc->pack_len;
+        memcpy(p, sc->pack_data, sc->pack_len);
+        qm->len = p + sc->pack_len - qm->msg;
+        // Record when each run frees its mcu move queue slot
+        int i;
+        for (i = 0; i < sc->pack_count; i++)
+            qm->move_offsets[i] = sc->pack_clocks[i] - sc->pack_min_clock;
+    }
+    qm->min_clock = sc->pack_min_clock;
+    qm->req_clock = sc->pack_req_clock;
+    qm->num_moves = sc->pack_count;
+    list_add_tail(&qm->node, sc->msg_queue);
+    sc->pack_count = sc->pack_len = 0;
+}
+
+// Add a run of steps to the delta packed buffer
+static void
+add_move_pack(struct stepcompress *sc, struct step_move *move
+              , uint64_t min_clock, uint64_t req_clock)
+{
+    for (;;) {
+        // Encode (interval delta, count, add) for this run
+        uint32_t prev_interval = sc->pack_count ? sc->pack_last_interval : 0;
+        uint8_t scratch[16], *p = scratch;
+        p = msgblock_encode_int(p, move->interval - prev_interval);
+        p = msgblock_encode_int(p, move->count);
+        p = msgblock_encode_int(p, move->add);
+        int tlen = p - scratch;
+        if (!sc->pack_count) {
+            sc->pack_first = *move;
+            sc->pack_min_clock = min_clock;
+            sc->pack_req_clock = req_clock;
+        } else if (sc->pack_len + tlen > PACK_DATA_MAX
+                   || sc->pack_count >= sc->move_limit) {
+            // Buffer full - emit it and restart with an absolute interval
+            flush_pack(sc);
+            continue;
+        }
+        memcpy(&sc->pack_data[sc->pack_len], scratch, tlen);
+        sc->pack_len += tlen;
+        sc->pack_clocks[sc->pack_count] = min_clock;
+        sc->pack_count++;
+        sc->pack_last_interval = move->interval;
+        return;
+    }
+}
+
+// Generate the message for a buffered run of queue_step commands
+static void
+flush_pending_move(struct stepcompress *sc)
+{
+    if (!sc->pending_repeat)
+        return;
+    struct step_move *move = &sc->pending;
+    if (sc->pending_repeat == 1 && sc->queue_step_pack_msgtag) {
+        // Buffer the run for delta packing with its neighbors
+        add_move_pack(sc, move, sc->pending_min_clock, sc->pending_req_clock);
+        sc->pending_repeat = 0;
+        return;
+    }
+    // Emit any packed runs first (messages must stay in order)
+    flush_pack(sc);
+    struct queue_message *qm;
+    if (sc->pending_repeat > 1) {
+        uint32_t msg[6] = {
+            sc->queue_step_repeat_msgtag, sc->oid, move->interval
+            , move->count, move->add, sc->pending_repeat
+        };
+        qm = message_alloc_and_encode(msg, 6);
+        int32_t addfactor = move->count*(move->count-1)/2;
+        qm->move_stride = move->add*addfactor + move->interval*move->count;
+    } else {
+        uint32_t msg[5] = {
+            sc->queue_step_msgtag, sc->oid, move->interval, move->count
+            , move->add
+        };
+        qm = message_alloc_and_encode(msg, 5);
+    }
+    qm->min_clock = sc->pending_min_clock;
+    qm->req_clock = sc->pending_req_clock;
+    qm->num_moves = sc->pending_repeat;
+    list_add_tail(&qm->node, sc->msg_queue);
+    sc->pending_repeat = 0;
+}
+
 // Helper to create a queue_step command from a 'struct step_move'
+// Publish a history entry to the shared memory telemetry ring
+static void
+export_history_steps(struct stepcompress *sc, struct history_steps *hs)
+{
+    struct shm_motion_record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.record_type = SHM_RECORD_STEPS;
+    rec.oid = sc->oid;
+    rec.steps.first_clock = hs->first_clock;
+    rec.steps.last_clock = hs->last_clock;
+    rec.steps.start_position = hs->start_position;
+    rec.steps.interval = hs->interval;
+    rec.steps.count = hs->step_count;
+    rec.steps.add = hs->add;
+    shmring_write(sc->export_ring, &rec);
+}
+
+// Attach (or detach) a shared memory telemetry ring
+void __visible
+stepcompress_set_export(struct stepcompress *sc, struct shmring *sr)
+{
+    sc->export_ring = sr;
+}
+
 static void
 add_move(struct stepcompress *sc, uint64_t first_clock, struct step_move *move)
 {
@@ -351,19 +659,25 @@ add_move(struct stepcompress *sc, uint64_t first_clock, struct step_move *move)
     uint32_t ticks = move->add*addfactor + move->interval*(move->count-1);
     uint64_t last_clock = first_clock + ticks;
 
-    // Create and queue a queue_step command
-    uint32_t msg[5] = {
-        sc->queue_step_msgtag, sc->oid, move->interval, move->count, move->add
-    };
-    struct queue_message *qm = message_alloc_and_encode(msg, 5);
-    qm->min_clock = qm->req_clock = sc->last_step_clock;
-    if (move->count == 1 && first_clock >= sc->last_step_clock + CLOCK_DIFF_MAX)
-        qm->req_clock = first_clock;
-    list_add_tail(&qm->node, sc->msg_queue);
+    // Queue the queue_step command (coalescing runs of identical moves)
+    if (sc->pending_repeat && sc->pending_repeat < sc->move_limit
+        && sc->queue_step_repeat_msgtag
+        && move->interval == sc->pending.interval
+        && move->count == sc->pending.count && move->add == sc->pending.add) {
+        sc->pending_repeat++;
+    } else {
+        flush_pending_move(sc);
+        sc->pending = *move;
+        sc->pending_repeat = 1;
+        sc->pending_min_clock = sc->pending_req_clock = sc->last_step_clock;
+        if (move->count == 1
+            && first_clock >= sc->last_step_clock + CLOCK_DIFF_MAX)
+            sc->pending_req_clock = first_clock;
+    }
     sc->last_step_clock = last_clock;
 
     // Create and store move in history tracking
-    struct history_steps *hs = malloc(sizeof(*hs));
+    struct history_steps *hs = history_append(sc);
     hs->first_clock = first_clock;
     hs->last_clock = last_clock;
     hs->start_position = sc->last_position;
@@ -371,20 +685,33 @@ add_move(struct stepcompress *sc, uint64_t first_clock, struct step_move *move)
     hs->add = move->add;
     hs->step_count = sc->sdir ? move->count : -move->count;
     sc->last_position += hs->step_count;
-    list_add_head(&hs->node, &sc->history_list);
+    if (sc->export_ring)
+        export_history_steps(sc, hs);
 }
 
 // Convert previously scheduled steps into commands for the mcu
 static int
 queue_flush(struct stepcompress *sc, uint64_t move_clock)
 {
-    if (sc->queue_pos >= sc->queue_next)
+    if (sc->queue_pos >= sc->queue_next) {
+        flush_pack(sc);
         return 0;
+    }
     while (sc->last_step_clock < move_clock) {
+        // Expire error spans fully superseded by a newer span
+        while (sc->num_error_spans > 1
+               && sc->error_spans[1].start_clock <= sc->last_step_clock) {
+            memmove(&sc->error_spans[0], &sc->error_spans[1]
+                    , (sc->num_error_spans - 1) * sizeof(sc->error_spans[0]));
+            sc->num_error_spans--;
+        }
         struct step_move move = compress_bisect_add(sc);
         int ret = check_line(sc, move);
-        if (ret)
+        if (ret) {
+            flush_pending_move(sc);
+            flush_pack(sc);
             return ret;
+        }
 
         add_move(sc, sc->last_step_clock + move.interval, &move);
 
@@ -394,6 +721,8 @@ queue_flush(struct stepcompress *sc, uint64_t move_clock)
         }
         sc->queue_pos += move.count;
     }
+    flush_pending_move(sc);
+    flush_pack(sc);
     calc_last_step_print_time(sc);
     return 0;
 }
@@ -404,6 +733,7 @@ stepcompress_flush_far(struct stepcompress *sc, uint64_t abs_step_clock)
 {
     struct step_move move = { abs_step_clock - sc->last_step_clock, 1, 0 };
     add_move(sc, abs_step_clock, &move);
+    flush_pending_move(sc);
     calc_last_step_print_time(sc);
     return 0;
 }
@@ -512,6 +842,8 @@ stepcompress_append(struct stepcompress *sc, int sdir
     double offset = print_time - sc->last_step_print_time;
     double rel_sc = (step_time + offset) * sc->mcu_freq;
     uint64_t step_clock = sc->last_step_clock + (uint64_t)rel_sc;
+    if (unlikely(sc->pending_error_span))
+        note_error_span(sc, step_clock);
     // Flush previous pending step (if any)
     if (sc->next_step_clock) {
         if (unlikely(sdir != sc->next_step_dir)) {
@@ -563,6 +895,9 @@ stepcompress_reset(struct stepcompress *sc, uint64_t last_step_clock)
         return ret;
     sc->last_step_clock = last_step_clock;
     sc->sdir = -1;
+    sc->num_error_spans = sc->pending_error_span = 0;
+    sc->cur_error = 0;
+    sc->last_move_velocity = 0.;
     calc_last_step_print_time(sc);
     return 0;
 }
@@ -577,42 +912,72 @@ stepcompress_set_last_position(struct stepcompress *sc, uint64_t clock
         return ret;
     sc->last_position = last_position;
 
-    // Add a marker to the history list
-    struct history_steps *hs = malloc(sizeof(*hs));
+    // Add a marker to the history ring
+    struct history_steps *hs = history_append(sc);
     memset(hs, 0, sizeof(*hs));
     hs->first_clock = hs->last_clock = clock;
     hs->start_position = last_position;
-    list_add_head(&hs->node, &sc->history_list);
+    if (sc->export_ring)
+        export_history_steps(sc, hs);
     return 0;
 }
 
+// Calculate the position described by a history entry at a given clock
+static int64_t
+history_calc_position(struct history_steps *hs, uint64_t clock)
+{
+    if (clock >= hs->last_clock)
+        return hs->start_position + hs->step_count;
+    int32_t interval = hs->interval, add = hs->add;
+    int32_t ticks = (int32_t)(clock - hs->first_clock) + interval, offset;
+    if (!add) {
+        offset = ticks / interval;
+    } else {
+        // Solve for "count" using quadratic formula
+        double a = .5 * add, b = interval - .5 * add, c = -ticks;
+        offset = (sqrt(b*b - 4*a*c) - b) / (2. * a);
+    }
+    if (hs->step_count < 0)
+        return hs->start_position - offset;
+    return hs->start_position + offset;
+}
+
 // Search history of moves to find a past position at a given clock
 int64_t __visible
 stepcompress_find_past_position(struct stepcompress *sc, uint64_t clock)
 {
-    int64_t last_position = sc->last_position;
-    struct history_steps *hs;
-    list_for_each_entry(hs, &sc->history_list, node) {
-        if (clock < hs->first_clock) {
-            last_position = hs->start_position;
+    int idx = history_search(sc, clock);
+    if (idx < 0) {
+        if (sc->history_count)
+            // Clock predates all stored history
+            return history_entry(sc, 0)->start_position;
+        return sc->last_position;
+    }
+    return history_calc_position(history_entry(sc, idx), clock);
+}
+
+// Fill 'positions' with past positions sampled at regular clock intervals
+void __visible
+stepcompress_find_past_positions(struct stepcompress *sc, uint64_t start_clock
+                                 , uint64_t interval_clock, int count
+                                 , int64_t *positions)
+{
+    uint64_t clock = start_clock;
+    int idx = history_search(sc, clock);
+    for (int i = 0; i < count; i++, clock += interval_clock) {
+        // Advance to the newest entry starting at or before 'clock'
+        while (idx + 1 < sc->history_count
+               && history_entry(sc, idx + 1)->first_clock <= clock)
+            idx++;
+        if (idx < 0) {
+            // Clock predates all stored history
+            positions[i] = (sc->history_count
+                            ? history_entry(sc, 0)->start_position
+                            : sc->last_position);
             continue;
         }
-        if (clock >= hs->last_clock)
-            return hs->start_position + hs->step_count;
-        int32_t interval = hs->interval, add = hs->add;
-        int32_t ticks = (int32_t)(clock - hs->first_clock) + interval, offset;
-        if (!add) {
-            offset = ticks / interval;
-        } else {
-            // Solve for "count" using quadratic formula
-            double a = .5 * add, b = interval - .5 * add, c = -ticks;
-            offset = (sqrt(b*b - 4*a*c) - b) / (2. * a);
-        }
-        if (hs->step_count < 0)
-            return hs->start_position - offset;
-        return hs->start_position + offset;
+        positions[i] = history_calc_position(history_entry(sc, idx), clock);
     }
-    return last_position;
 }
 
 // Return history of queue_step commands
@@ -621,8 +986,10 @@ stepcompress_extract_old(struct stepcompress *sc, struct pull_history_steps *p
                          , int max, uint64_t start_clock, uint64_t end_clock)
 {
     int res = 0;
-    struct history_steps *hs;
-    list_for_each_entry(hs, &sc->history_list, node) {
+    // Start from the newest record that may overlap the range
+    int idx = history_search(sc, end_clock - 1);
+    for (; idx >= 0; idx--) {
+        struct history_steps *hs = history_entry(sc, idx);
         if (start_clock >= hs->last_clock || res >= max)
             break;
         if (end_clock <= hs->first_clock)
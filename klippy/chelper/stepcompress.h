@@ -12,12 +12,21 @@ struct pull_history_steps {
 };
 
 struct list_head;
+struct shmring;
 struct stepcompress *stepcompress_alloc(struct list_head *msg_queue);
 void stepcompress_fill(struct stepcompress *sc, uint32_t oid, uint32_t max_error
                        , int32_t queue_step_msgtag
-                       , int32_t set_next_step_dir_msgtag);
+                       , int32_t set_next_step_dir_msgtag
+                       , int32_t queue_step_repeat_msgtag
+                       , int32_t queue_step_pack_msgtag);
+void stepcompress_set_error_velocity(struct stepcompress *sc
+                                     , uint32_t highspeed_error
+                                     , double vel_ref);
+void stepcompress_note_velocity(struct stepcompress *sc, double velocity);
+void stepcompress_set_move_limit(struct stepcompress *sc, int move_limit);
 void stepcompress_set_invert_sdir(struct stepcompress *sc
                                   , uint32_t invert_sdir);
+void stepcompress_set_export(struct stepcompress *sc, struct shmring *sr);
 void stepcompress_history_expire(struct stepcompress *sc, uint64_t end_clock);
 void stepcompress_free(struct stepcompress *sc);
 uint32_t stepcompress_get_oid(struct stepcompress *sc);
@@ -33,6 +42,10 @@ int stepcompress_set_last_position(struct stepcompress *sc, uint64_t clock
                                    , int64_t last_position);
 int64_t stepcompress_find_past_position(struct stepcompress *sc
                                         , uint64_t clock);
+void stepcompress_find_past_positions(struct stepcompress *sc
+                                      , uint64_t start_clock
+                                      , uint64_t interval_clock, int count
+                                      , int64_t *positions);
 int stepcompress_extract_old(struct stepcompress *sc
                              , struct pull_history_steps *p, int max
                              , uint64_t start_clock, uint64_t end_clock);
@@ -11,10 +11,12 @@
 // mcu step queue is ordered between steppers so that no stepper
 // starves the other steppers of space in the mcu step queue.
 
+#include <math.h> // ilogb
 #include <pthread.h> // pthread_mutex_lock
 #include <stddef.h> // offsetof
 #include <stdlib.h> // malloc
 #include <string.h> // memset
+#include <unistd.h> // sysconf
 #include "compiler.h" // __visible
 #include "pyhelper.h" // set_thread_name
 #include "itersolve.h" // itersolve_generate_steps
@@ -28,24 +30,38 @@
  * SyncEmitter - message generation for each stepper
  ****************************************************************/
 
+// A unit of work processed by the steppersyncmgr worker pool
+struct ssm_job {
+    struct list_node node;
+    // Process the job (called without the pool lock held)
+    void (*run)(struct ssm_job *j);
+    // Queue any dependent jobs (called with the pool lock held)
+    void (*chain)(struct steppersyncmgr *ssm, struct ssm_job *j);
+};
+
 struct syncemitter {
     // List node for storage in steppersync list
     struct list_node ss_node;
+    struct steppersync *ss;
     // Transmit message queue
     struct list_head msg_queue;
-    // Thread for step generation
+    // Step generation state
     struct stepcompress *sc;
     struct stepper_kinematics *sk;
     char name[16];
-    pthread_t tid;
-    pthread_mutex_t lock; // protects variables below
-    pthread_cond_t cond;
-    int have_work;
+    // Pending work (pool lock protects variables below)
+    struct ssm_job gen_job;
     double bg_gen_steps_time;
     uint64_t bg_flush_clock, bg_clear_history_clock;
     int32_t bg_result;
+    // Flush deadline margin telemetry
+    uint64_t batch_min_clock;
+    double min_margin;
 };
 
+// Sentinel margin reported when no flushes have been recorded
+#define MARGIN_NONE 9999999.
+
 // Return this emitters 'struct stepcompress' (or NULL if not allocated)
 struct stepcompress * __visible
 syncemitter_get_stepcompress(struct syncemitter *se)
@@ -80,13 +96,11 @@ syncemitter_queue_msg(struct syncemitter *se, uint64_t req_clock
 
 // Generate steps (via itersolve) and flush
 static int32_t
-se_generate_steps(struct syncemitter *se)
+se_generate_steps(struct syncemitter *se, double gen_steps_time
+                  , uint64_t flush_clock, uint64_t clear_history_clock)
 {
     if (!se->sc || !se->sk)
         return 0;
-    double gen_steps_time = se->bg_gen_steps_time;
-    uint64_t flush_clock = se->bg_flush_clock;
-    uint64_t clear_history_clock = se->bg_clear_history_clock;
     // Generate steps
     int32_t ret = itersolve_generate_steps(se->sk, se->sc, gen_steps_time);
     if (ret)
@@ -100,68 +114,7 @@ se_generate_steps(struct syncemitter *se)
     return 0;
 }
 
-// Main background thread for generating steps
-static void *
-se_background_thread(void *data)
-{
-    struct syncemitter *se = data;
-    set_thread_name(se->name);
-
-    pthread_mutex_lock(&se->lock);
-    for (;;) {
-        if (!se->have_work) {
-            pthread_cond_wait(&se->cond, &se->lock);
-            continue;
-        }
-        if (se->have_work < 0)
-            // Exit request
-            break;
-
-        // Request to generate steps
-        se->bg_result = se_generate_steps(se);
-        if (se->bg_result)
-            errorf("Error in syncemitter '%s' step generation", se->name);
-        se->have_work = 0;
-        pthread_cond_signal(&se->cond);
-    }
-    pthread_mutex_unlock(&se->lock);
-
-    return NULL;
-}
-
-// Signal background thread to start step generation
-static void
-se_start_gen_steps(struct syncemitter *se, double gen_steps_time
-                   , uint64_t flush_clock, uint64_t clear_history_clock)
-{
-    if (!se->sc || !se->sk)
-        return;
-    pthread_mutex_lock(&se->lock);
-    while (se->have_work)
-        pthread_cond_wait(&se->cond, &se->lock);
-    se->bg_gen_steps_time = gen_steps_time;
-    se->bg_flush_clock = flush_clock;
-    se->bg_clear_history_clock = clear_history_clock;
-    se->have_work = 1;
-    pthread_mutex_unlock(&se->lock);
-    pthread_cond_signal(&se->cond);
-}
-
-// Wait for background thread to complete last step generation request
-static int32_t
-se_finalize_gen_steps(struct syncemitter *se)
-{
-    if (!se->sc || !se->sk)
-        return 0;
-    pthread_mutex_lock(&se->lock);
-    while (se->have_work)
-        pthread_cond_wait(&se->cond, &se->lock);
-    int32_t res = se->bg_result;
-    pthread_mutex_unlock(&se->lock);
-    return res;
-}
-
-// Allocate syncemitter and start thread
+// Allocate a syncemitter
 static struct syncemitter *
 syncemitter_alloc(char name[16], int alloc_stepcompress)
 {
@@ -170,42 +123,20 @@ syncemitter_alloc(char name[16], int alloc_stepcompress)
     list_init(&se->msg_queue);
     strncpy(se->name, name, sizeof(se->name));
     se->name[sizeof(se->name)-1] = '\0';
-    if (!alloc_stepcompress)
-        return se;
-    se->sc = stepcompress_alloc(&se->msg_queue);
-    int ret = pthread_mutex_init(&se->lock, NULL);
-    if (ret)
-        goto fail;
-    ret = pthread_cond_init(&se->cond, NULL);
-    if (ret)
-        goto fail;
-    ret = pthread_create(&se->tid, NULL, se_background_thread, se);
-    if (ret)
-        goto fail;
+    se->min_margin = MARGIN_NONE;
+    if (alloc_stepcompress)
+        se->sc = stepcompress_alloc(&se->msg_queue);
     return se;
-fail:
-    report_errno("se alloc", ret);
-    return NULL;
 }
 
-// Free syncemitter and exit background thread
+// Free syncemitter
 static void
 syncemitter_free(struct syncemitter *se)
 {
     if (!se)
         return;
-    if (se->sc) {
-        pthread_mutex_lock(&se->lock);
-        while (se->have_work)
-            pthread_cond_wait(&se->cond, &se->lock);
-        se->have_work = -1;
-        pthread_cond_signal(&se->cond);
-        pthread_mutex_unlock(&se->lock);
-        int ret = pthread_join(se->tid, NULL);
-        if (ret)
-            report_errno("se pthread_join", ret);
+    if (se->sc)
         stepcompress_free(se->sc);
-    }
     message_queue_free(&se->msg_queue);
     free(se);
 }
@@ -228,6 +159,14 @@ struct steppersync {
     // Storage for list of pending move clocks
     uint64_t *move_clocks;
     int num_move_clocks;
+    // Pending work (pool lock protects variables below)
+    struct ssm_job flush_job;
+    int flush_pending;
+    uint64_t bg_flush_clock;
+    int32_t gen_result;
+    // Flush deadline margin telemetry
+    double min_margin;
+    uint32_t margin_hist[SS_MARGIN_BUCKETS];
 };
 
 // Allocate a new syncemitter instance
@@ -236,8 +175,12 @@ steppersync_alloc_syncemitter(struct steppersync *ss, char name[16]
                               , int alloc_stepcompress)
 {
     struct syncemitter *se = syncemitter_alloc(name, alloc_stepcompress);
-    if (se)
+    if (se) {
+        se->ss = ss;
         list_add_tail(&se->ss_node, &ss->se_list);
+        if (se->sc && ss->num_move_clocks)
+            stepcompress_set_move_limit(se->sc, ss->num_move_clocks);
+    }
     return se;
 }
 
@@ -255,6 +198,13 @@ steppersync_setup_movequeue(struct steppersync *ss, struct serialqueue *sq
     ss->move_clocks = malloc(sizeof(*ss->move_clocks)*move_num);
     memset(ss->move_clocks, 0, sizeof(*ss->move_clocks)*move_num);
     ss->num_move_clocks = move_num;
+
+    // Bound the runs batched into one command by the move queue size
+    struct syncemitter *se;
+    list_for_each_entry(se, &ss->se_list, ss_node) {
+        if (se->sc)
+            stepcompress_set_move_limit(se->sc, move_num);
+    }
 }
 
 // Set the conversion rate of 'print_time' to mcu clock
@@ -295,6 +245,41 @@ heap_replace(struct steppersync *ss, uint64_t req_clock)
     }
 }
 
+// Add a margin measurement to a log-scale histogram (bucket k covers
+// [2**k, 2**(k+1)) usecs; negative margins land in bucket zero)
+static void
+margin_record(uint32_t counts[SS_MARGIN_BUCKETS], double margin)
+{
+    double us = margin * 1000000.;
+    int bucket = us >= 1. ? ilogb(us) : 0;
+    if (bucket >= SS_MARGIN_BUCKETS)
+        bucket = SS_MARGIN_BUCKETS - 1;
+    counts[bucket]++;
+}
+
+// Record the margin between flushed step clocks and the mcu clock estimate
+static void
+steppersync_note_margins(struct steppersync *ss, uint64_t batch_min_clock)
+{
+    struct clock_estimate ce;
+    serialqueue_get_clock_est(ss->sq, &ce);
+    if (!ce.est_freq)
+        return;
+    double est_time = get_monotonic();
+    double margin = clock_to_time(&ce, batch_min_clock) - est_time;
+    if (margin < ss->min_margin)
+        ss->min_margin = margin;
+    margin_record(ss->margin_hist, margin);
+    struct syncemitter *se;
+    list_for_each_entry(se, &ss->se_list, ss_node) {
+        if (se->batch_min_clock == MAX_CLOCK)
+            continue;
+        double se_margin = clock_to_time(&ce, se->batch_min_clock) - est_time;
+        if (se_margin < se->min_margin)
+            se->min_margin = se_margin;
+    }
+}
+
 // Find and transmit any scheduled steps prior to the given 'move_clock'
 static void
 steppersync_flush(struct steppersync *ss, uint64_t move_clock)
@@ -302,30 +287,51 @@ steppersync_flush(struct steppersync *ss, uint64_t move_clock)
     // Order commands by the reqclock of each pending command
     struct list_head msgs;
     list_init(&msgs);
+    uint64_t batch_min_clock = MAX_CLOCK;
+    struct syncemitter *se;
+    list_for_each_entry(se, &ss->se_list, ss_node)
+        se->batch_min_clock = MAX_CLOCK;
     for (;;) {
         // Find message with lowest reqclock
         uint64_t req_clock = MAX_CLOCK;
         struct queue_message *qm = NULL;
-        struct syncemitter *se;
+        struct syncemitter *qm_se = NULL;
         list_for_each_entry(se, &ss->se_list, ss_node) {
             if (!list_empty(&se->msg_queue)) {
                 struct queue_message *m = list_first_entry(
                     &se->msg_queue, struct queue_message, node);
                 if (m->req_clock < req_clock) {
                     qm = m;
+                    qm_se = se;
                     req_clock = m->req_clock;
                 }
             }
         }
         if (!qm || (qm->min_clock && req_clock > move_clock))
             break;
+        if (req_clock < batch_min_clock)
+            batch_min_clock = req_clock;
+        if (req_clock < qm_se->batch_min_clock)
+            qm_se->batch_min_clock = req_clock;
 
         uint64_t next_avail = ss->move_clocks[0];
-        if (qm->min_clock)
+        if (qm->min_clock) {
             // The qm->min_clock field is overloaded to indicate that
             // the command uses the 'move queue' and to store the time
             // that move queue item becomes available.
             heap_replace(ss, qm->min_clock);
+            // Commands carrying multiple runs (queue_step_repeat and
+            // queue_step_pack) consume one mcu move queue slot per
+            // contained run, with slot i freed only once run i-1
+            // completes
+            int i;
+            for (i = 1; i < qm->num_moves; i++) {
+                next_avail = ss->move_clocks[0];
+                uint64_t offset = qm->move_stride
+                    ? (uint64_t)qm->move_stride * i : qm->move_offsets[i];
+                heap_replace(ss, qm->min_clock + offset);
+            }
+        }
         // Reset the min_clock to its normal meaning (minimum transmit time)
         qm->min_clock = next_avail;
 
@@ -335,8 +341,35 @@ steppersync_flush(struct steppersync *ss, uint64_t move_clock)
     }
 
     // Transmit commands
-    if (!list_empty(&msgs))
+    if (!list_empty(&msgs)) {
+        if (batch_min_clock != MAX_CLOCK)
+            steppersync_note_margins(ss, batch_min_clock);
         serialqueue_send_batch(ss->sq, ss->cq, &msgs);
+    }
+}
+
+// Report (and optionally reset) flush deadline margin telemetry
+void __visible
+steppersync_get_margin_stats(struct steppersync *ss, int reset
+                             , double *min_margin
+                             , uint32_t hist[SS_MARGIN_BUCKETS])
+{
+    *min_margin = ss->min_margin;
+    memcpy(hist, ss->margin_hist, sizeof(ss->margin_hist));
+    if (reset) {
+        ss->min_margin = MARGIN_NONE;
+        memset(ss->margin_hist, 0, sizeof(ss->margin_hist));
+    }
+}
+
+// Report (and optionally reset) the minimum margin seen by one emitter
+double __visible
+syncemitter_get_min_margin(struct syncemitter *se, int reset)
+{
+    double res = se->min_margin;
+    if (reset)
+        se->min_margin = MARGIN_NONE;
+    return res;
 }
 
 
@@ -346,8 +379,116 @@ steppersync_flush(struct steppersync *ss, uint64_t move_clock)
 
 struct steppersyncmgr {
     struct list_head ss_list;
+    // Worker pool for step generation
+    pthread_mutex_t lock; // protects variables below
+    pthread_cond_t wake_cond, done_cond;
+    struct list_head job_queue;
+    int jobs_pending, num_workers, shutdown;
+    pthread_t *worker_tids;
 };
 
+// Run step generation for one emitter
+static void
+se_gen_job_run(struct ssm_job *j)
+{
+    struct syncemitter *se = container_of(j, struct syncemitter, gen_job);
+    se->bg_result = se_generate_steps(se, se->bg_gen_steps_time
+                                      , se->bg_flush_clock
+                                      , se->bg_clear_history_clock);
+    if (se->bg_result)
+        errorf("Error in syncemitter '%s' step generation", se->name);
+}
+
+// Merge and transmit the messages generated for one mcu
+static void
+ss_flush_job_run(struct ssm_job *j)
+{
+    struct steppersync *ss = container_of(j, struct steppersync, flush_job);
+    if (!ss->gen_result)
+        steppersync_flush(ss, ss->bg_flush_clock);
+}
+
+// Queue an mcu transmit job once all of its emitters have completed
+static void
+se_gen_job_chain(struct steppersyncmgr *ssm, struct ssm_job *j)
+{
+    struct syncemitter *se = container_of(j, struct syncemitter, gen_job);
+    struct steppersync *ss = se->ss;
+    if (se->bg_result)
+        ss->gen_result = se->bg_result;
+    if (--ss->flush_pending)
+        return;
+    list_add_tail(&ss->flush_job.node, &ssm->job_queue);
+    ssm->jobs_pending++;
+    pthread_cond_broadcast(&ssm->wake_cond);
+}
+
+// Pop and run pending jobs (caller must hold ssm->lock)
+static void
+ssm_run_jobs(struct steppersyncmgr *ssm)
+{
+    while (!list_empty(&ssm->job_queue)) {
+        struct ssm_job *j = list_first_entry(
+            &ssm->job_queue, struct ssm_job, node);
+        list_del(&j->node);
+        pthread_mutex_unlock(&ssm->lock);
+        j->run(j);
+        pthread_mutex_lock(&ssm->lock);
+        if (j->chain)
+            j->chain(ssm, j);
+        if (!--ssm->jobs_pending)
+            pthread_cond_signal(&ssm->done_cond);
+    }
+}
+
+// Main background thread for pool workers
+static void *
+ssm_worker_thread(void *data)
+{
+    struct steppersyncmgr *ssm = data;
+    char name[16] = "stepgen";
+    set_thread_name(name);
+
+    pthread_mutex_lock(&ssm->lock);
+    while (!ssm->shutdown) {
+        if (list_empty(&ssm->job_queue)) {
+            pthread_cond_wait(&ssm->wake_cond, &ssm->lock);
+            continue;
+        }
+        ssm_run_jobs(ssm);
+    }
+    pthread_mutex_unlock(&ssm->lock);
+
+    return NULL;
+}
+
+// Ensure the worker pool is large enough for the given job count
+static void
+ssm_grow_workers(struct steppersyncmgr *ssm, int num_jobs)
+{
+    // Size pool to the host cpu count (the calling thread also runs jobs)
+    int nproc = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nproc < 1)
+        nproc = 1;
+    int want = num_jobs < nproc ? num_jobs : nproc;
+    want--;
+    if (want <= ssm->num_workers)
+        return;
+    pthread_t *tids = malloc(sizeof(*tids) * want);
+    memcpy(tids, ssm->worker_tids, sizeof(*tids) * ssm->num_workers);
+    free(ssm->worker_tids);
+    ssm->worker_tids = tids;
+    while (ssm->num_workers < want) {
+        int ret = pthread_create(&tids[ssm->num_workers], NULL
+                                 , ssm_worker_thread, ssm);
+        if (ret) {
+            report_errno("ssm pthread_create", ret);
+            break;
+        }
+        ssm->num_workers++;
+    }
+}
+
 // Allocate a new 'steppersyncmgr' object
 struct steppersyncmgr * __visible
 steppersyncmgr_alloc(void)
@@ -355,6 +496,10 @@ steppersyncmgr_alloc(void)
     struct steppersyncmgr *ssm = malloc(sizeof(*ssm));
     memset(ssm, 0, sizeof(*ssm));
     list_init(&ssm->ss_list);
+    list_init(&ssm->job_queue);
+    pthread_mutex_init(&ssm->lock, NULL);
+    pthread_cond_init(&ssm->wake_cond, NULL);
+    pthread_cond_init(&ssm->done_cond, NULL);
     return ssm;
 }
 
@@ -364,6 +509,17 @@ steppersyncmgr_free(struct steppersyncmgr *ssm)
 {
     if (!ssm)
         return;
+    pthread_mutex_lock(&ssm->lock);
+    ssm->shutdown = 1;
+    pthread_cond_broadcast(&ssm->wake_cond);
+    pthread_mutex_unlock(&ssm->lock);
+    int i;
+    for (i=0; i<ssm->num_workers; i++) {
+        int ret = pthread_join(ssm->worker_tids[i], NULL);
+        if (ret)
+            report_errno("ssm pthread_join", ret);
+    }
+    free(ssm->worker_tids);
     while (!list_empty(&ssm->ss_list)) {
         struct steppersync *ss = list_first_entry(
             &ssm->ss_list, struct steppersync, ssm_node);
@@ -388,6 +544,7 @@ steppersyncmgr_alloc_steppersync(struct steppersyncmgr *ssm)
     struct steppersync *ss = malloc(sizeof(*ss));
     memset(ss, 0, sizeof(*ss));
     list_init(&ss->se_list);
+    ss->min_margin = MARGIN_NONE;
     list_add_tail(&ss->ssm_node, &ssm->ss_list);
     return ss;
 }
@@ -409,28 +566,51 @@ steppersyncmgr_gen_steps(struct steppersyncmgr *ssm, double flush_time
                 trapq_check_sentinels(tq);
         }
     }
-    // Start step generation threads
+    // Queue a step generation job for each active emitter
+    pthread_mutex_lock(&ssm->lock);
+    int num_jobs = 0;
     list_for_each_entry(ss, &ssm->ss_list, ssm_node) {
         uint64_t flush_clock = clock_from_time(&ss->ce, flush_time);
         uint64_t clear_clock = clock_from_time(&ss->ce, clear_history_time);
+        ss->bg_flush_clock = flush_clock;
+        ss->gen_result = 0;
+        ss->flush_job.run = ss_flush_job_run;
+        ss->flush_job.chain = NULL;
+        int num_active = 0;
         struct syncemitter *se;
         list_for_each_entry(se, &ss->se_list, ss_node) {
-            se_start_gen_steps(se, gen_steps_time, flush_clock, clear_clock);
+            if (!se->sc || !se->sk)
+                continue;
+            se->bg_gen_steps_time = gen_steps_time;
+            se->bg_flush_clock = flush_clock;
+            se->bg_clear_history_clock = clear_clock;
+            se->gen_job.run = se_gen_job_run;
+            se->gen_job.chain = se_gen_job_chain;
+            list_add_tail(&se->gen_job.node, &ssm->job_queue);
+            num_jobs++;
+            num_active++;
+        }
+        // The mcu transmit job is queued once its last emitter completes
+        // (or immediately if this mcu has no step generation)
+        ss->flush_pending = num_active;
+        if (!num_active) {
+            list_add_tail(&ss->flush_job.node, &ssm->job_queue);
+            num_jobs++;
         }
     }
-    // Wait for step generation threads to complete
+    ssm->jobs_pending = num_jobs;
+    // Wake pool workers and drain jobs on the calling thread as well
+    ssm_grow_workers(ssm, num_jobs);
+    pthread_cond_broadcast(&ssm->wake_cond);
+    ssm_run_jobs(ssm);
+    while (ssm->jobs_pending)
+        pthread_cond_wait(&ssm->done_cond, &ssm->lock);
+    pthread_mutex_unlock(&ssm->lock);
+    // Collect results
     int32_t res = 0;
     list_for_each_entry(ss, &ssm->ss_list, ssm_node) {
-        struct syncemitter *se;
-        list_for_each_entry(se, &ss->se_list, ss_node) {
-            int32_t ret = se_finalize_gen_steps(se);
-            if (ret)
-                res = ret;
-        }
-        if (res)
-            continue;
-        uint64_t flush_clock = clock_from_time(&ss->ce, flush_time);
-        steppersync_flush(ss, flush_clock);
+        if (ss->gen_result)
+            res = ss->gen_result;
     }
     return res;
 }
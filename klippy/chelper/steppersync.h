@@ -3,6 +3,9 @@
 
 #include <stdint.h> // uint64_t
 
+// Log-scale flush margin histogram buckets
+#define SS_MARGIN_BUCKETS 32
+
 struct syncemitter;
 struct stepcompress *syncemitter_get_stepcompress(struct syncemitter *se);
 void syncemitter_set_stepper_kinematics(struct syncemitter *se
@@ -11,6 +14,7 @@ struct stepper_kinematics *syncemitter_get_stepper_kinematics(
     struct syncemitter *se);
 void syncemitter_queue_msg(struct syncemitter *se, uint64_t req_clock
                            , uint32_t *data, int len);
+double syncemitter_get_min_margin(struct syncemitter *se, int reset);
 
 struct steppersync;
 struct syncemitter *steppersync_alloc_syncemitter(
@@ -19,6 +23,9 @@ void steppersync_setup_movequeue(struct steppersync *ss, struct serialqueue *sq
                                  , int move_num);
 void steppersync_set_time(struct steppersync *ss, double time_offset
                           , double mcu_freq);
+void steppersync_get_margin_stats(struct steppersync *ss, int reset
+                                  , double *min_margin
+                                  , uint32_t hist[SS_MARGIN_BUCKETS]);
 
 struct steppersyncmgr *steppersyncmgr_alloc(void);
 void steppersyncmgr_free(struct steppersyncmgr *ssm);
@@ -0,0 +1,49 @@
+// ADC to temperature conversion via a precomputed lookup table
+//
+// Copyright (C) 2016-2024  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include "compiler.h" // __visible
+
+// Temperatures are tabulated at evenly spaced adc values - converting
+// a sample is an index calculation and a linear interpolation
+struct temp_conversion {
+    int count;
+    double adc_base, inv_adc_step;
+    double temps[];
+};
+
+struct temp_conversion * __visible
+temp_conversion_alloc(int count)
+{
+    struct temp_conversion *tc = malloc(
+        sizeof(*tc) + (count + 1) * sizeof(double));
+    memset(tc, 0, sizeof(*tc));
+    tc->count = count;
+    return tc;
+}
+
+void __visible
+temp_conversion_fill(struct temp_conversion *tc, double adc_base
+                     , double adc_step, double *temps)
+{
+    tc->adc_base = adc_base;
+    tc->inv_adc_step = 1. / adc_step;
+    memcpy(tc->temps, temps, (tc->count + 1) * sizeof(double));
+}
+
+double __visible
+temp_conversion_calc_temp(struct temp_conversion *tc, double adc)
+{
+    double pos = (adc - tc->adc_base) * tc->inv_adc_step;
+    if (pos <= 0.)
+        return tc->temps[0];
+    if (pos >= tc->count)
+        return tc->temps[tc->count];
+    int idx = (int)pos;
+    double frac = pos - idx;
+    return tc->temps[idx] * (1. - frac) + tc->temps[idx + 1] * frac;
+}
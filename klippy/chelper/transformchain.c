@@ -0,0 +1,95 @@
+// Composed affine g-code coordinate transforms
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // fabs
+#include <stdlib.h> // malloc
+#include <string.h> // memcpy
+#include "compiler.h" // __visible
+#include "transformchain.h" // transform_chain_alloc
+
+// A stack of affine coordinate transforms folded into one matrix:
+// out = m * pos + offset (with the inverse precomputed so position
+// queries can be mapped back without walking a transform chain).
+struct transform_chain {
+    double m[9], offset[3];
+    double inv_m[9], inv_offset[3];
+    int is_identity;
+};
+
+struct transform_chain * __visible
+transform_chain_alloc(void)
+{
+    struct transform_chain *tc = malloc(sizeof(*tc));
+    memset(tc, 0, sizeof(*tc));
+    tc->m[0] = tc->m[4] = tc->m[8] = 1.;
+    tc->inv_m[0] = tc->inv_m[4] = tc->inv_m[8] = 1.;
+    tc->is_identity = 1;
+    return tc;
+}
+
+// Set the folded transform.  Returns -1 if the matrix is not invertible.
+int __visible
+transform_chain_set(struct transform_chain *tc, const double *m
+                    , const double *offset)
+{
+    double det = (m[0] * (m[4]*m[8] - m[5]*m[7])
+                  - m[1] * (m[3]*m[8] - m[5]*m[6])
+                  + m[2] * (m[3]*m[7] - m[4]*m[6]));
+    if (fabs(det) < 1e-12)
+        return -1;
+    memcpy(tc->m, m, sizeof(tc->m));
+    memcpy(tc->offset, offset, sizeof(tc->offset));
+    // Invert via the adjugate matrix
+    double inv_det = 1. / det;
+    double *im = tc->inv_m;
+    im[0] = (m[4]*m[8] - m[5]*m[7]) * inv_det;
+    im[1] = (m[2]*m[7] - m[1]*m[8]) * inv_det;
+    im[2] = (m[1]*m[5] - m[2]*m[4]) * inv_det;
+    im[3] = (m[5]*m[6] - m[3]*m[8]) * inv_det;
+    im[4] = (m[0]*m[8] - m[2]*m[6]) * inv_det;
+    im[5] = (m[2]*m[3] - m[0]*m[5]) * inv_det;
+    im[6] = (m[3]*m[7] - m[4]*m[6]) * inv_det;
+    im[7] = (m[1]*m[6] - m[0]*m[7]) * inv_det;
+    im[8] = (m[0]*m[4] - m[1]*m[3]) * inv_det;
+    int i;
+    for (i = 0; i < 3; i++)
+        tc->inv_offset[i] = -(im[3*i+0]*offset[0] + im[3*i+1]*offset[1]
+                              + im[3*i+2]*offset[2]);
+    tc->is_identity = 1;
+    for (i = 0; i < 9; i++)
+        if (m[i] != (i % 4 ? 0. : 1.))
+            tc->is_identity = 0;
+    if (offset[0] || offset[1] || offset[2])
+        tc->is_identity = 0;
+    return 0;
+}
+
+static void
+affine_apply(const double *m, const double *offset, double *pos)
+{
+    double x = pos[0], y = pos[1], z = pos[2];
+    pos[0] = m[0]*x + m[1]*y + m[2]*z + offset[0];
+    pos[1] = m[3]*x + m[4]*y + m[5]*z + offset[1];
+    pos[2] = m[6]*x + m[7]*y + m[8]*z + offset[2];
+}
+
+// Apply the transform in place to an (x, y, z) coordinate
+void __visible
+transform_chain_apply(struct transform_chain *tc, double *pos)
+{
+    if (tc->is_identity)
+        return;
+    affine_apply(tc->m, tc->offset, pos);
+}
+
+// Apply the inverse transform in place to an (x, y, z) coordinate
+void __visible
+transform_chain_unapply(struct transform_chain *tc, double *pos)
+{
+    if (tc->is_identity)
+        return;
+    affine_apply(tc->inv_m, tc->inv_offset, pos);
+}
@@ -0,0 +1,10 @@
+#ifndef TRANSFORMCHAIN_H
+#define TRANSFORMCHAIN_H
+
+struct transform_chain *transform_chain_alloc(void);
+int transform_chain_set(struct transform_chain *tc, const double *m
+                        , const double *offset);
+void transform_chain_apply(struct transform_chain *tc, double *pos);
+void transform_chain_unapply(struct transform_chain *tc, double *pos);
+
+#endif // transformchain.h
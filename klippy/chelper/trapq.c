@@ -9,17 +9,49 @@
 #include <stdlib.h> // malloc
 #include <string.h> // memset
 #include "compiler.h" // unlikely
+#include "lookahead.h" // struct lookahead_move
+#include "pyhelper.h" // report_errno
+#include "shmring.h" // shmring_write
 #include "trapq.h" // move_get_coord
 
-// Allocate a new 'move' object
-struct move *
-move_alloc(void)
+// Number of 'struct move' objects allocated per arena slab
+#define MOVES_PER_ARENA 128
+
+// Slab of moves allocated in one malloc() call
+struct move_arena {
+    struct move_arena *next;
+    struct move moves[MOVES_PER_ARENA];
+};
+
+// Allocate a 'move' object from the trapq arena
+static struct move *
+tq_alloc_move(struct trapq *tq)
 {
-    struct move *m = malloc(sizeof(*m));
+    if (list_empty(&tq->free_moves)) {
+        // Allocate a new cache-line aligned slab of moves for the freelist
+        struct move_arena *a = NULL;
+        int ret = posix_memalign((void **)&a, 64, sizeof(*a));
+        if (ret)
+            report_errno("posix_memalign", ret);
+        a->next = tq->arena_list;
+        tq->arena_list = a;
+        int i;
+        for (i=0; i<MOVES_PER_ARENA; i++)
+            list_add_head(&a->moves[i].node, &tq->free_moves);
+    }
+    struct move *m = list_first_entry(&tq->free_moves, struct move, node);
+    list_del(&m->node);
     memset(m, 0, sizeof(*m));
     return m;
 }
 
+// Return a 'move' object to the trapq arena
+static void
+tq_free_move(struct trapq *tq, struct move *m)
+{
+    list_add_head(&m->node, &tq->free_moves);
+}
+
 // Return the distance moved given a time in a move
 inline double
 move_get_distance(struct move *m, double move_time)
@@ -27,6 +59,31 @@ move_get_distance(struct move *m, double move_time)
     return (m->start_v + m->half_accel * move_time) * move_time;
 }
 
+// Vector of doubles sized to match AVX2 registers (lowered to paired
+// 128bit operations on SSE2 and NEON targets)
+typedef double vec4double __attribute__((vector_size(4 * sizeof(double))));
+
+// Batched variant of move_get_distance() for a vector of times
+void
+move_get_distance_batch(struct move *m, const double *move_times
+                        , double *move_dists, int count)
+{
+    double start_v = m->start_v, half_accel = m->half_accel;
+    while (count >= 4) {
+        vec4double t;
+        memcpy(&t, move_times, sizeof(t));
+        vec4double dist = (start_v + half_accel * t) * t;
+        memcpy(move_dists, &dist, sizeof(dist));
+        move_times += 4;
+        move_dists += 4;
+        count -= 4;
+    }
+    while (count--) {
+        double t = *move_times++;
+        *move_dists++ = (start_v + half_accel * t) * t;
+    }
+}
+
 // Return the XYZ coordinates given a time in a move
 inline struct coord
 move_get_coord(struct move *m, double move_time)
@@ -48,7 +105,9 @@ trapq_alloc(void)
     memset(tq, 0, sizeof(*tq));
     list_init(&tq->moves);
     list_init(&tq->history);
-    struct move *head_sentinel = move_alloc(), *tail_sentinel = move_alloc();
+    list_init(&tq->free_moves);
+    struct move *head_sentinel = tq_alloc_move(tq);
+    struct move *tail_sentinel = tq_alloc_move(tq);
     head_sentinel->print_time = -1.0;
     tail_sentinel->print_time = tail_sentinel->move_t = NEVER_TIME;
     list_add_head(&head_sentinel->node, &tq->moves);
@@ -60,19 +119,61 @@ trapq_alloc(void)
 void __visible
 trapq_free(struct trapq *tq)
 {
-    while (!list_empty(&tq->moves)) {
-        struct move *m = list_first_entry(&tq->moves, struct move, node);
-        list_del(&m->node);
-        free(m);
-    }
-    while (!list_empty(&tq->history)) {
-        struct move *m = list_first_entry(&tq->history, struct move, node);
-        list_del(&m->node);
-        free(m);
+    struct move_arena *a = tq->arena_list;
+    while (a) {
+        struct move_arena *next = a->next;
+        free(a);
+        a = next;
     }
+    free(tq->hist_idx);
     free(tq);
 }
 
+// Add a move to the head of the history list and the time index.
+// Moves enter the history in time order, so the index is an
+// append-only array ordered oldest to newest.
+static void
+history_add(struct trapq *tq, struct move *m)
+{
+    list_add_head(&m->node, &tq->history);
+    m->history_gen = ++tq->history_gen;
+    if (tq->hist_idx_start + tq->hist_idx_count >= tq->hist_idx_size) {
+        int count = tq->hist_idx_count;
+        if (count * 2 >= tq->hist_idx_size) {
+            // Grow the index array
+            int nsize = tq->hist_idx_size ? tq->hist_idx_size * 2 : 256;
+            struct move **ni = malloc(nsize * sizeof(*ni));
+            if (count)
+                memcpy(ni, &tq->hist_idx[tq->hist_idx_start]
+                       , count * sizeof(*ni));
+            free(tq->hist_idx);
+            tq->hist_idx = ni;
+            tq->hist_idx_size = nsize;
+        } else {
+            // Compact expired entries from the front
+            memmove(&tq->hist_idx[0], &tq->hist_idx[tq->hist_idx_start]
+                    , count * sizeof(*tq->hist_idx));
+        }
+        tq->hist_idx_start = 0;
+    }
+    tq->hist_idx[tq->hist_idx_start + tq->hist_idx_count++] = m;
+}
+
+// Forget the oldest history entry (expired from the list tail)
+static void
+history_drop_oldest(struct trapq *tq)
+{
+    tq->hist_idx_start++;
+    tq->hist_idx_count--;
+}
+
+// Forget the newest history entry (pruned from the list head)
+static void
+history_drop_newest(struct trapq *tq)
+{
+    tq->hist_idx_count--;
+}
+
 // Update the list sentinels
 void
 trapq_check_sentinels(struct trapq *tq)
@@ -102,7 +203,7 @@ trapq_add_move(struct trapq *tq, struct move *m)
     struct move *prev = list_prev_entry(tail_sentinel, node);
     if (prev->print_time + prev->move_t < m->print_time) {
         // Add a null move to fill time gap
-        struct move *null_move = move_alloc();
+        struct move *null_move = tq_alloc_move(tq);
         null_move->start_pos = m->start_pos;
         if (prev->print_time <= 0. && m->print_time > MAX_NULL_MOVE)
             // Limit the first null move to improve numerical stability
@@ -127,7 +228,7 @@ trapq_append(struct trapq *tq, double print_time
     struct coord start_pos = { .x=start_pos_x, .y=start_pos_y, .z=start_pos_z };
     struct coord axes_r = { .x=axes_r_x, .y=axes_r_y, .z=axes_r_z };
     if (accel_t) {
-        struct move *m = move_alloc();
+        struct move *m = tq_alloc_move(tq);
         m->print_time = print_time;
         m->move_t = accel_t;
         m->start_v = start_v;
@@ -140,7 +241,7 @@ trapq_append(struct trapq *tq, double print_time
         start_pos = move_get_coord(m, accel_t);
     }
     if (cruise_t) {
-        struct move *m = move_alloc();
+        struct move *m = tq_alloc_move(tq);
         m->print_time = print_time;
         m->move_t = cruise_t;
         m->start_v = cruise_v;
@@ -153,7 +254,7 @@ trapq_append(struct trapq *tq, double print_time
         start_pos = move_get_coord(m, cruise_t);
     }
     if (decel_t) {
-        struct move *m = move_alloc();
+        struct move *m = tq_alloc_move(tq);
         m->print_time = print_time;
         m->move_t = decel_t;
         m->start_v = cruise_v;
@@ -164,6 +265,69 @@ trapq_append(struct trapq *tq, double print_time
     }
 }
 
+// Add a batch of moves to the trapezoid velocity queue in one call
+void __visible
+trapq_append_moves(struct trapq *tq, struct push_move *p, int count)
+{
+    while (count--) {
+        trapq_append(tq, p->print_time
+                     , p->accel_t, p->cruise_t, p->decel_t
+                     , p->start_x, p->start_y, p->start_z
+                     , p->x_r, p->y_r, p->z_r
+                     , p->start_v, p->cruise_v, p->accel);
+        p++;
+    }
+}
+
+// Add flushed lookahead moves directly to the trapezoid velocity
+// queue.  Returns the print_time at the end of the last move.
+double __visible
+trapq_append_lookahead(struct trapq *tq, double print_time
+                       , struct lookahead_move *moves, int count)
+{
+    int i;
+    for (i = 0; i < count; i++) {
+        struct lookahead_move *m = &moves[i];
+        if (m->is_kinematic)
+            trapq_append(tq, print_time
+                         , m->accel_t, m->cruise_t, m->decel_t
+                         , m->start_x, m->start_y, m->start_z
+                         , m->x_r, m->y_r, m->z_r
+                         , m->start_v, m->cruise_v, m->accel);
+        print_time += m->accel_t + m->cruise_t + m->decel_t;
+    }
+    return print_time;
+}
+
+// Publish a completed move to the shared memory telemetry ring
+static void
+trapq_export_move(struct trapq *tq, struct move *m)
+{
+    struct shm_motion_record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.record_type = SHM_RECORD_MOVE;
+    rec.oid = tq->export_id;
+    rec.move.print_time = m->print_time;
+    rec.move.move_t = m->move_t;
+    rec.move.start_v = m->start_v;
+    rec.move.accel = 2. * m->half_accel;
+    rec.move.start_x = m->start_pos.x;
+    rec.move.start_y = m->start_pos.y;
+    rec.move.start_z = m->start_pos.z;
+    rec.move.x_r = m->axes_r.x;
+    rec.move.y_r = m->axes_r.y;
+    rec.move.z_r = m->axes_r.z;
+    shmring_write(tq->export_ring, &rec);
+}
+
+// Attach (or detach) a shared memory telemetry ring
+void __visible
+trapq_set_export(struct trapq *tq, struct shmring *sr, uint32_t export_id)
+{
+    tq->export_ring = sr;
+    tq->export_id = export_id;
+}
+
 // Expire any moves older than `print_time` from the trapezoid velocity queue
 void __visible
 trapq_finalize_moves(struct trapq *tq, double print_time
@@ -181,10 +345,13 @@ trapq_finalize_moves(struct trapq *tq, double print_time
         if (m->print_time + m->move_t > print_time)
             break;
         list_del(&m->node);
-        if (m->start_v || m->half_accel)
-            list_add_head(&m->node, &tq->history);
-        else
-            free(m);
+        if (m->start_v || m->half_accel) {
+            if (tq->export_ring)
+                trapq_export_move(tq, m);
+            history_add(tq, m);
+        } else {
+            tq_free_move(tq, m);
+        }
     }
     // Free old moves from history list
     if (list_empty(&tq->history))
@@ -195,7 +362,8 @@ trapq_finalize_moves(struct trapq *tq, double print_time
         if (m == latest || m->print_time + m->move_t > clear_history_time)
             break;
         list_del(&m->node);
-        free(m);
+        history_drop_oldest(tq);
+        tq_free_move(tq, m);
     }
 }
 
@@ -216,16 +384,17 @@ trapq_set_position(struct trapq *tq, double print_time
             break;
         }
         list_del(&m->node);
-        free(m);
+        history_drop_newest(tq);
+        tq_free_move(tq, m);
     }
 
     // Add a marker to the trapq history
-    struct move *m = move_alloc();
+    struct move *m = tq_alloc_move(tq);
     m->print_time = print_time;
     m->start_pos.x = pos_x;
     m->start_pos.y = pos_y;
     m->start_pos.z = pos_z;
-    list_add_head(&m->node, &tq->history);
+    history_add(tq, m);
 }
 
 // Copy the info in a 'struct move' to a 'struct pull_move'
@@ -260,14 +429,56 @@ trapq_extract_old(struct trapq *tq, struct pull_move *p, int max
         p++;
         res++;
     }
-    list_for_each_entry(m, &tq->history, node) {
-        if (start_time >= m->print_time + m->move_t || res >= max)
+    // Binary search the time index for the newest history move
+    // started before end_time, then emit newest to oldest
+    struct move **idx = tq->hist_idx + tq->hist_idx_start;
+    int lo = 0, hi = tq->hist_idx_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (idx[mid]->print_time < end_time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    int i;
+    for (i = lo - 1; i >= 0 && res < max; i--) {
+        m = idx[i];
+        if (start_time >= m->print_time + m->move_t)
             break;
-        if (end_time <= m->print_time)
-            continue;
         copy_pull_move(p, m);
         p++;
         res++;
     }
     return res;
 }
+
+// Return history moves added since a previous query.  The caller
+// passes the generation from its last query (zero initially); moves
+// are returned oldest first and the generation is advanced past the
+// last move returned.
+int __visible
+trapq_extract_changed(struct trapq *tq, struct pull_move *p, int max
+                      , uint64_t *generation)
+{
+    uint64_t gen = *generation;
+    struct move **idx = tq->hist_idx + tq->hist_idx_start;
+    int count = tq->hist_idx_count;
+    // Binary search for the first move newer than the generation
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (idx[mid]->history_gen <= gen)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    int res = 0;
+    while (lo + res < count && res < max) {
+        copy_pull_move(p, idx[lo + res]);
+        p++;
+        res++;
+    }
+    if (res)
+        *generation = idx[lo + res - 1]->history_gen;
+    return res;
+}
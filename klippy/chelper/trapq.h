@@ -1,6 +1,8 @@
 #ifndef TRAPQ_H
 #define TRAPQ_H
 
+#include <stdint.h> // uint32_t
+#include "compiler.h" // __aligned
 #include "list.h" // list_node
 
 struct coord {
@@ -12,16 +14,39 @@ struct coord {
     };
 };
 
+// Align moves to cache lines so the kinematic fields read on every
+// solver evaluation stay in the first line of each arena slot
 struct move {
+    // Timing and velocity coefficients (hot - read per evaluation)
     double print_time, move_t;
     double start_v, half_accel;
     struct coord start_pos, axes_r;
 
+    // Queue management (cold)
     struct list_node node;
-};
+    uint64_t history_gen;
+} __aligned(64);
 
 struct trapq {
     struct list_head moves, history;
+    // Time-ordered pointer index over the history list
+    struct move **hist_idx;
+    int hist_idx_start, hist_idx_count, hist_idx_size;
+    uint64_t history_gen;
+    // Arena storage for 'struct move' objects
+    struct list_head free_moves;
+    struct move_arena *arena_list;
+    // Optional shared memory telemetry export
+    struct shmring *export_ring;
+    uint32_t export_id;
+};
+
+struct push_move {
+    double print_time;
+    double accel_t, cruise_t, decel_t;
+    double start_x, start_y, start_z;
+    double x_r, y_r, z_r;
+    double start_v, cruise_v, accel;
 };
 
 struct pull_move {
@@ -31,8 +56,11 @@ struct pull_move {
     double x_r, y_r, z_r;
 };
 
-struct move *move_alloc(void);
+struct shmring;
+struct lookahead_move;
 double move_get_distance(struct move *m, double move_time);
+void move_get_distance_batch(struct move *m, const double *move_times
+                             , double *move_dists, int count);
 struct coord move_get_coord(struct move *m, double move_time);
 struct trapq *trapq_alloc(void);
 void trapq_free(struct trapq *tq);
@@ -43,11 +71,18 @@ void trapq_append(struct trapq *tq, double print_time
                   , double start_pos_x, double start_pos_y, double start_pos_z
                   , double axes_r_x, double axes_r_y, double axes_r_z
                   , double start_v, double cruise_v, double accel);
+void trapq_append_moves(struct trapq *tq, struct push_move *p, int count);
+double trapq_append_lookahead(struct trapq *tq, double print_time
+                              , struct lookahead_move *moves, int count);
 void trapq_finalize_moves(struct trapq *tq, double print_time
                           , double clear_history_time);
+void trapq_set_export(struct trapq *tq, struct shmring *sr
+                      , uint32_t export_id);
 void trapq_set_position(struct trapq *tq, double print_time
                         , double pos_x, double pos_y, double pos_z);
 int trapq_extract_old(struct trapq *tq, struct pull_move *p, int max
                       , double start_time, double end_time);
+int trapq_extract_changed(struct trapq *tq, struct pull_move *p, int max
+                          , uint64_t *generation);
 
 #endif // trapq.h
@@ -17,8 +17,11 @@
 struct trdispatch {
     struct list_head tdm_list;
 
-    pthread_mutex_t lock; // protects variables below
+    // Trigger state (accessed atomically so that trigger detection
+    // and stop requests never wait on the lock below)
     uint32_t is_active, can_trigger, dispatch_reason;
+
+    pthread_mutex_t lock; // protects per-mcu status fields
 };
 
 struct trdispatch_mcu {
@@ -28,6 +31,7 @@ struct trdispatch_mcu {
     struct serialqueue *sq;
     struct command_queue *cq;
     uint32_t trsync_oid, set_timeout_msgtag, trigger_msgtag;
+    uint32_t set_window_msgtag;
 
     // Remaining fields protected by trdispatch lock
     uint64_t last_status_clock, expire_clock;
@@ -58,6 +62,18 @@ send_trsync_set_timeout(struct trdispatch_mcu *tdm)
     serialqueue_send_one(tdm->sq, tdm->cq, qm);
 }
 
+// Send: trsync_set_trigger_window oid=%c clock=%u report_ticks=%u
+static void
+send_trsync_set_trigger_window(struct trdispatch_mcu *tdm, uint64_t clock
+                               , uint32_t report_ticks)
+{
+    uint32_t msg[4] = {
+        tdm->set_window_msgtag, tdm->trsync_oid, clock, report_ticks
+    };
+    struct queue_message *qm = message_alloc_and_encode(msg, ARRAY_SIZE(msg));
+    serialqueue_send_one(tdm->sq, tdm->cq, qm);
+}
+
 // Handle a trsync_state message (callback from serialqueue fastreader)
 static void
 handle_trsync_state(struct fastreader *fr, uint8_t *data, int len)
@@ -73,20 +89,33 @@ handle_trsync_state(struct fastreader *fr, uint8_t *data, int len)
 
     // Process message
     struct trdispatch *td = tdm->td;
-    pthread_mutex_lock(&td->lock);
-    if (!td->can_trigger)
-        goto done;
+    if (!__atomic_load_n(&td->can_trigger, __ATOMIC_ACQUIRE))
+        return;
 
     if (!can_trigger) {
-        // mcu reports trigger or timeout - propagate to all mcus
-        td->can_trigger = 0;
+        // mcu reports trigger or timeout - propagate to all mcus.
+        // Claim the trigger via compare-and-swap so this path never
+        // waits on the dispatch lock (which may be held by a status
+        // update blocked on another mcu's transmit lock).
+        uint32_t expect = 1;
+        if (!__atomic_compare_exchange_n(&td->can_trigger, &expect, 0, 0
+                                         , __ATOMIC_ACQ_REL
+                                         , __ATOMIC_RELAXED))
+            return;
         struct trdispatch_mcu *m;
         list_for_each_entry(m, &td->tdm_list, node) {
             send_trsync_trigger(m);
         }
-        goto done;
+        return;
     }
 
+    // The timeout extension below is advisory - if another thread
+    // holds the lock, skip it and rely on the next status report
+    if (pthread_mutex_trylock(&td->lock))
+        return;
+    if (!__atomic_load_n(&td->can_trigger, __ATOMIC_ACQUIRE))
+        goto done;
+
     // mcu is still working okay - update last_status_clock
     serialqueue_get_clock_est(tdm->sq, &tdm->ce);
     tdm->last_status_clock = clock_from_clock32(&tdm->ce, clock);
@@ -126,14 +155,11 @@ done:
 void __visible
 trdispatch_start(struct trdispatch *td, uint32_t dispatch_reason)
 {
-    pthread_mutex_lock(&td->lock);
-    if (td->is_active || list_empty(&td->tdm_list)) {
-        pthread_mutex_unlock(&td->lock);
+    if (list_empty(&td->tdm_list)
+        || __atomic_exchange_n(&td->is_active, 1, __ATOMIC_ACQ_REL))
         return;
-    }
     td->dispatch_reason = dispatch_reason;
-    td->is_active = td->can_trigger = 1;
-    pthread_mutex_unlock(&td->lock);
+    __atomic_store_n(&td->can_trigger, 1, __ATOMIC_RELEASE);
 
     // Register handle_trsync_state message parser for each mcu
     struct trdispatch_mcu *tdm;
@@ -146,13 +172,8 @@ trdispatch_start(struct trdispatch *td, uint32_t dispatch_reason)
 void __visible
 trdispatch_stop(struct trdispatch *td)
 {
-    pthread_mutex_lock(&td->lock);
-    if (!td->is_active) {
-        pthread_mutex_unlock(&td->lock);
+    if (!__atomic_exchange_n(&td->is_active, 0, __ATOMIC_ACQ_REL))
         return;
-    }
-    td->is_active = 0;
-    pthread_mutex_unlock(&td->lock);
 
     // Unregister handle_trsync_state message parsers
     struct trdispatch_mcu *tdm;
@@ -183,7 +204,7 @@ struct trdispatch_mcu * __visible
 trdispatch_mcu_alloc(struct trdispatch *td, struct serialqueue *sq
                      , struct command_queue *cq, uint32_t trsync_oid
                      , uint32_t set_timeout_msgtag, uint32_t trigger_msgtag
-                     , uint32_t state_msgtag)
+                     , uint32_t set_window_msgtag, uint32_t state_msgtag)
 {
     struct trdispatch_mcu *tdm = malloc(sizeof(*tdm));
     memset(tdm, 0, sizeof(*tdm));
@@ -193,6 +214,7 @@ trdispatch_mcu_alloc(struct trdispatch *td, struct serialqueue *sq
     tdm->trsync_oid = trsync_oid;
     tdm->set_timeout_msgtag = set_timeout_msgtag;
     tdm->trigger_msgtag = trigger_msgtag;
+    tdm->set_window_msgtag = set_window_msgtag;
 
     // Setup fastreader to match trsync_state messages
     uint32_t state_prefix[] = {state_msgtag, trsync_oid};
@@ -209,6 +231,16 @@ trdispatch_mcu_alloc(struct trdispatch *td, struct serialqueue *sq
     return tdm;
 }
 
+// Request tighter mcu reporting around an anticipated trigger clock
+void __visible
+trdispatch_mcu_set_trigger_window(struct trdispatch_mcu *tdm, uint64_t clock
+                                  , uint32_t report_ticks)
+{
+    struct trdispatch *td = tdm->td;
+    if (__atomic_load_n(&td->can_trigger, __ATOMIC_ACQUIRE))
+        send_trsync_set_trigger_window(tdm, clock, report_ticks);
+}
+
 // Setup for a trigger test
 void __visible
 trdispatch_mcu_setup(struct trdispatch_mcu *tdm
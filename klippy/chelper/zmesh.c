@@ -0,0 +1,120 @@
+// Bed mesh Z height lookups
+//
+// Copyright (C) 2016-2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <math.h> // floor
+#include <stdlib.h> // malloc
+#include <string.h> // memcpy
+#include "compiler.h" // __visible
+#include "zmesh.h" // struct zmesh
+
+struct zmesh {
+    int x_count, y_count;
+    double min_x, x_dist, min_y, y_dist;
+    double x_offset, y_offset;
+    double z[0];
+};
+
+// Allocate a mesh from a fully interpolated z matrix (row major, y rows)
+struct zmesh * __visible
+zmesh_alloc(const double *z, int x_count, int y_count
+            , double min_x, double x_dist, double min_y, double y_dist)
+{
+    if (x_count < 2 || y_count < 2)
+        return NULL;
+    int zsize = x_count * y_count * sizeof(double);
+    struct zmesh *zm = malloc(sizeof(*zm) + zsize);
+    if (!zm)
+        return NULL;
+    memset(zm, 0, sizeof(*zm));
+    zm->x_count = x_count;
+    zm->y_count = y_count;
+    zm->min_x = min_x;
+    zm->x_dist = x_dist;
+    zm->min_y = min_y;
+    zm->y_dist = y_dist;
+    memcpy(zm->z, z, zsize);
+    return zm;
+}
+
+void __visible
+zmesh_free(struct zmesh *zm)
+{
+    free(zm);
+}
+
+void __visible
+zmesh_set_offsets(struct zmesh *zm, double x_offset, double y_offset)
+{
+    zm->x_offset = x_offset;
+    zm->y_offset = y_offset;
+}
+
+static double
+lerp(double t, double v0, double v1)
+{
+    return (1. - t) * v0 + t * v1;
+}
+
+// Find the grid cell containing 'coord' and the fractional position in it
+static double
+get_linear_index(double coord, double mesh_min, double mesh_dist
+                 , int mesh_cnt, int *idx_out)
+{
+    int idx = (int)floor((coord - mesh_min) / mesh_dist);
+    if (idx < 0)
+        idx = 0;
+    else if (idx > mesh_cnt - 2)
+        idx = mesh_cnt - 2;
+    double t = (coord - (mesh_min + mesh_dist * idx)) / mesh_dist;
+    if (t < 0.)
+        t = 0.;
+    else if (t > 1.)
+        t = 1.;
+    *idx_out = idx;
+    return t;
+}
+
+// Bilinear interpolation of the mesh z height at a position
+double __visible
+zmesh_calc_z(struct zmesh *zm, double x, double y)
+{
+    int xidx, yidx;
+    double tx = get_linear_index(x + zm->x_offset, zm->min_x, zm->x_dist
+                                 , zm->x_count, &xidx);
+    double ty = get_linear_index(y + zm->y_offset, zm->min_y, zm->y_dist
+                                 , zm->y_count, &yidx);
+    const double *row0 = &zm->z[yidx * zm->x_count];
+    const double *row1 = &row0[zm->x_count];
+    double z0 = lerp(tx, row0[xidx], row0[xidx+1]);
+    double z1 = lerp(tx, row1[xidx], row1[xidx+1]);
+    return lerp(ty, z0, z1);
+}
+
+// Scan along a move for the next point where the z adjustment changes
+// by at least 'split_delta_z'.  Returns the distance from the start of
+// the move at which to split it (with the new adjustment in 'next_z'),
+// or -1 if the remainder of the move does not need splitting.
+double __visible
+zmesh_next_split(struct zmesh *zm, double prev_x, double prev_y
+                 , double next_x, double next_y, double move_len
+                 , double dist_checked, double check_dist
+                 , double z_offset, double split_delta_z
+                 , double z_factor, double fade_offset
+                 , double *next_z)
+{
+    while (dist_checked + check_dist < move_len) {
+        dist_checked += check_dist;
+        double t = dist_checked / move_len;
+        double x = lerp(t, prev_x, next_x), y = lerp(t, prev_y, next_y);
+        double z = zmesh_calc_z(zm, x, y);
+        double zo = z_factor * (z - fade_offset) + fade_offset;
+        if (fabs(zo - z_offset) >= split_delta_z) {
+            *next_z = zo;
+            return dist_checked;
+        }
+    }
+    return -1.;
+}
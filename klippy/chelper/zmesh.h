@@ -0,0 +1,17 @@
+#ifndef ZMESH_H
+#define ZMESH_H
+
+struct zmesh *zmesh_alloc(const double *z, int x_count, int y_count
+                          , double min_x, double x_dist
+                          , double min_y, double y_dist);
+void zmesh_free(struct zmesh *zm);
+void zmesh_set_offsets(struct zmesh *zm, double x_offset, double y_offset);
+double zmesh_calc_z(struct zmesh *zm, double x, double y);
+double zmesh_next_split(struct zmesh *zm, double prev_x, double prev_y
+                        , double next_x, double next_y, double move_len
+                        , double dist_checked, double check_dist
+                        , double z_offset, double split_delta_z
+                        , double z_factor, double fade_offset
+                        , double *next_z);
+
+#endif // zmesh.h
@@ -4,10 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging, math
-
-RTT_AGE = .000010 / (60. * 60.)
-DECAY = 1. / 30.
-TRANSMIT_EXTRA = .001
+import chelper
 
 class ClockSync:
     def __init__(self, reactor):
@@ -19,28 +16,26 @@ class ClockSync:
         self.mcu_freq = 1.
         self.last_clock = 0
         self.clock_est = (0., 0., 0.)
-        # Minimum round-trip-time tracking
-        self.min_half_rtt = 999999999.9
-        self.min_rtt_time = 0.
-        # Linear regression of mcu clock and system sent_time
-        self.time_avg = self.time_variance = 0.
-        self.clock_avg = self.clock_covariance = 0.
-        self.prediction_variance = 0.
-        self.last_prediction_time = 0.
+        # Convergence filter state lives in a C helper
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.cfilter = self.ffi_main.gc(self.ffi_lib.clockfilter_alloc(),
+                                        self.ffi_lib.free)
+        self.serialqueue = None
     def connect(self, serial):
         self.serial = serial
+        self.serialqueue = serial.get_serialqueue()
         self.mcu_freq = serial.msgparser.get_constant_float('CLOCK_FREQ')
         # Load initial clock and frequency
         params = serial.send_with_response('get_uptime', 'uptime')
         self.last_clock = (params['high'] << 32) | params['clock']
-        self.clock_avg = self.last_clock
-        self.time_avg = params['#sent_time']
-        self.clock_est = (self.time_avg, self.clock_avg, self.mcu_freq)
-        self.prediction_variance = (.001 * self.mcu_freq)**2
+        self.ffi_lib.clockfilter_init(self.cfilter, self.mcu_freq,
+                                      self.last_clock, params['#sent_time'])
+        self.clock_est = (params['#sent_time'], float(self.last_clock),
+                          self.mcu_freq)
         # Enable periodic get_clock timer
         for i in range(8):
             self.reactor.pause(self.reactor.monotonic() + 0.050)
-            self.last_prediction_time = -9999.
+            self.cfilter.last_prediction_time = -9999.
             params = serial.send_with_response('get_clock', 'clock')
             self._handle_clock(params)
         self.get_clock_cmd = serial.get_msgparser().create_command('get_clock')
@@ -60,65 +55,37 @@ class ClockSync:
         self.serial.raw_send(self.get_clock_cmd, 0, 0, self.cmd_queue)
         self.queries_pending += 1
         # Use an unusual time for the next event so clock messages
-        # don't resonate with other periodic events.
-        return eventtime + .9839
+        # don't resonate with other periodic events.  The filter runs
+        # natively, so sampling can be faster than the historic 1Hz.
+        return eventtime + .3839
     def _handle_clock(self, params):
         self.queries_pending = 0
-        # Extend clock to 64bit
-        last_clock = self.last_clock
-        clock_delta = (params['clock'] - last_clock) & 0xffffffff
-        self.last_clock = clock = last_clock + clock_delta
-        # Check if this is the best round-trip-time seen so far
+        cf = self.cfilter
+        ffi_lib = self.ffi_lib
         sent_time = params['#sent_time']
-        if not sent_time:
+        prev_freq = cf.est_freq
+        prev_variance = cf.prediction_variance
+        flags = ffi_lib.clockfilter_update(cf, self.serialqueue,
+                                           params['clock'], sent_time,
+                                           params['#receive_time'])
+        self.last_clock = cf.last_clock
+        if flags & ffi_lib.CF_NO_SENT_TIME:
             return
-        receive_time = params['#receive_time']
-        half_rtt = .5 * (receive_time - sent_time)
-        aged_rtt = (sent_time - self.min_rtt_time) * RTT_AGE
-        if half_rtt < self.min_half_rtt + aged_rtt:
-            self.min_half_rtt = half_rtt
-            self.min_rtt_time = sent_time
+        if flags & ffi_lib.CF_NEW_MIN_RTT:
             logging.debug("new minimum rtt %.3f: hrtt=%.6f freq=%d",
-                          sent_time, half_rtt, self.clock_est[2])
-        # Filter out samples that are extreme outliers
-        exp_clock = ((sent_time - self.time_avg) * self.clock_est[2]
-                     + self.clock_avg)
-        clock_diff2 = (clock - exp_clock)**2
-        if (clock_diff2 > 25. * self.prediction_variance
-            and clock_diff2 > (.000500 * self.mcu_freq)**2):
-            if clock > exp_clock and sent_time < self.last_prediction_time+10.:
-                logging.debug("Ignoring clock sample %.3f:"
-                              " freq=%d diff=%d stddev=%.3f",
-                              sent_time, self.clock_est[2], clock - exp_clock,
-                              math.sqrt(self.prediction_variance))
-                return
+                          sent_time, cf.min_half_rtt, prev_freq)
+        if flags & ffi_lib.CF_SAMPLE_IGNORED:
+            logging.debug("Ignoring clock sample %.3f:"
+                          " freq=%d diff=%d stddev=%.3f",
+                          sent_time, prev_freq, cf.last_clock_diff,
+                          math.sqrt(prev_variance))
+            return
+        if flags & ffi_lib.CF_VARIANCE_RESET:
             logging.info("Resetting prediction variance %.3f:"
                          " freq=%d diff=%d stddev=%.3f",
-                         sent_time, self.clock_est[2], clock - exp_clock,
-                         math.sqrt(self.prediction_variance))
-            self.prediction_variance = (.001 * self.mcu_freq)**2
-        else:
-            self.last_prediction_time = sent_time
-            self.prediction_variance = (
-                (1. - DECAY) * (self.prediction_variance + clock_diff2 * DECAY))
-        # Add clock and sent_time to linear regression
-        diff_sent_time = sent_time - self.time_avg
-        self.time_avg += DECAY * diff_sent_time
-        self.time_variance = (1. - DECAY) * (
-            self.time_variance + diff_sent_time**2 * DECAY)
-        diff_clock = clock - self.clock_avg
-        self.clock_avg += DECAY * diff_clock
-        self.clock_covariance = (1. - DECAY) * (
-            self.clock_covariance + diff_sent_time * diff_clock * DECAY)
-        # Update prediction from linear regression
-        new_freq = self.clock_covariance / self.time_variance
-        pred_stddev = math.sqrt(self.prediction_variance)
-        self.serial.set_clock_est(new_freq, self.time_avg + TRANSMIT_EXTRA,
-                                  int(self.clock_avg - 3. * pred_stddev), clock)
-        self.clock_est = (self.time_avg + self.min_half_rtt,
-                          self.clock_avg, new_freq)
-        #logging.debug("regr %.3f: freq=%.3f d=%d(%.3f)",
-        #              sent_time, new_freq, clock - exp_clock, pred_stddev)
+                         sent_time, prev_freq, cf.last_clock_diff,
+                         math.sqrt(prev_variance))
+        self.clock_est = (cf.est_sample_time, cf.est_clock, cf.est_freq)
     # clock frequency conversions
     def print_time_to_clock(self, print_time):
         return int(print_time * self.mcu_freq)
@@ -140,18 +107,21 @@ class ClockSync:
         clock_diff -= (clock_diff & 0x80000000) << 1
         return last_clock + clock_diff
     def is_active(self):
-        return self.queries_pending <= 4
+        # Allow the same wall-clock response timeout as the prior 1Hz
+        # query rate permitted
+        return self.queries_pending <= 12
     def dump_debug(self):
+        cf = self.cfilter
         sample_time, clock, freq = self.clock_est
         return ("clocksync state: mcu_freq=%d last_clock=%d"
                 " clock_est=(%.3f %d %.3f) min_half_rtt=%.6f min_rtt_time=%.3f"
                 " time_avg=%.3f(%.3f) clock_avg=%.3f(%.3f)"
                 " pred_variance=%.3f" % (
                     self.mcu_freq, self.last_clock, sample_time, clock, freq,
-                    self.min_half_rtt, self.min_rtt_time,
-                    self.time_avg, self.time_variance,
-                    self.clock_avg, self.clock_covariance,
-                    self.prediction_variance))
+                    cf.min_half_rtt, cf.min_rtt_time,
+                    cf.time_avg, cf.time_variance,
+                    cf.clock_avg, cf.clock_covariance,
+                    cf.prediction_variance))
     def stats(self, eventtime):
         sample_time, clock, freq = self.clock_est
         return "freq=%d" % (freq,)
@@ -4,6 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import sys, os, glob, re, time, logging, configparser, io
+import hashlib, pickle
 
 error = configparser.Error
 
@@ -179,7 +180,7 @@ class ConfigFileReader:
         self.append_fileconfig(fileconfig, data, filename)
         return fileconfig
     def _resolve_include(self, source_filename, include_spec, fileconfig,
-                         visited):
+                         visited, ccache=None):
         dirname = os.path.dirname(source_filename)
         include_spec = include_spec.strip()
         include_glob = os.path.join(dirname, include_spec)
@@ -188,12 +189,16 @@ class ConfigFileReader:
             # Empty set is OK if wildcard but not for direct file reference
             raise error("Include file '%s' does not exist" % (include_glob,))
         include_filenames.sort()
+        if ccache is not None:
+            ccache.note_include_glob(include_glob, include_filenames)
         for include_filename in include_filenames:
             include_data = self.read_config_file(include_filename)
+            if ccache is not None:
+                ccache.note_include_file(include_filename, include_data)
             self._parse_config(include_data, include_filename, fileconfig,
-                               visited)
+                               visited, ccache)
         return include_filenames
-    def _parse_config(self, data, filename, fileconfig, visited):
+    def _parse_config(self, data, filename, fileconfig, visited, ccache=None):
         path = os.path.abspath(filename)
         if path in visited:
             raise error("Recursive include of config file '%s'" % (filename))
@@ -215,17 +220,95 @@ class ConfigFileReader:
                 del buf[:]
                 include_spec = header[8:].strip()
                 self._resolve_include(filename, include_spec, fileconfig,
-                                      visited)
+                                      visited, ccache)
             else:
                 buf.append(line)
         self.append_fileconfig(fileconfig, '\n'.join(buf), filename)
         visited.remove(path)
-    def build_fileconfig_with_includes(self, data, filename):
+    def build_fileconfig_with_includes(self, data, filename, ccache=None):
         fileconfig = self._create_fileconfig()
-        self._parse_config(data, filename, fileconfig, set())
+        self._parse_config(data, filename, fileconfig, set(), ccache)
         return fileconfig
 
 
+######################################################################
+# Parsed config caching
+######################################################################
+
+CONFIG_CACHE_VERSION = 1
+
+# Cache of a fully parsed (include resolved) config, keyed on the
+# content of the main config and every included file, so restarts
+# skip re-parsing an unchanged config
+class ConfigCache:
+    def __init__(self, filename):
+        self.filename = filename
+        self.cache_filename = filename + '.cache'
+        self.include_globs = []
+        self.include_files = []
+    def _calc_hash(self, data):
+        return hashlib.sha256(data.encode('utf-8')).hexdigest()
+    def note_include_glob(self, include_glob, include_filenames):
+        self.include_globs.append((include_glob, include_filenames))
+    def note_include_file(self, include_filename, include_data):
+        self.include_files.append((include_filename,
+                                   self._calc_hash(include_data)))
+    def lookup(self, cfgrdr, data):
+        if sys.version_info.major < 3:
+            return None
+        try:
+            f = open(self.cache_filename, 'rb')
+            cache = pickle.load(f)
+            f.close()
+        except Exception:
+            return None
+        try:
+            version = (CONFIG_CACHE_VERSION, tuple(sys.version_info[:2]))
+            if (type(cache) is not dict or cache.get('version') != version
+                or cache.get('main_hash') != self._calc_hash(data)):
+                return None
+            # Validate that the resolved includes have not changed
+            for include_glob, include_filenames in cache['include_globs']:
+                if sorted(glob.glob(include_glob)) != include_filenames:
+                    return None
+            for include_filename, include_hash in cache['include_files']:
+                include_data = cfgrdr.read_config_file(include_filename)
+                if self._calc_hash(include_data) != include_hash:
+                    return None
+            # Rebuild the fileconfig from the cached sections
+            fileconfig = cfgrdr._create_fileconfig()
+            fileconfig.read_dict(cache['sections'])
+            logging.info("Loaded parsed config cache %s",
+                         self.cache_filename)
+            return fileconfig
+        except Exception:
+            logging.exception("Error loading parsed config cache %s",
+                              self.cache_filename)
+            return None
+    def store(self, data, fileconfig):
+        if sys.version_info.major < 3:
+            return
+        sections = {s: {o: fileconfig.get(s, o)
+                        for o in fileconfig.options(s)}
+                    for s in fileconfig.sections()}
+        cache = {'version': (CONFIG_CACHE_VERSION,
+                             tuple(sys.version_info[:2])),
+                 'main_hash': self._calc_hash(data),
+                 'include_globs': self.include_globs,
+                 'include_files': self.include_files,
+                 'sections': sections}
+        try:
+            tmpname = self.cache_filename + '.tmp'
+            f = open(tmpname, 'wb')
+            pickle.dump(cache, f, pickle.HIGHEST_PROTOCOL)
+            f.close()
+            os.rename(tmpname, self.cache_filename)
+        except Exception:
+            # A read-only config directory is not an error
+            logging.info("Unable to write parsed config cache %s",
+                         self.cache_filename)
+
+
 ######################################################################
 # Config auto save helper
 ######################################################################
@@ -242,6 +325,8 @@ class ConfigAutoSave:
         self.fileconfig = None
         self.status_save_pending = {}
         self.save_config_pending = False
+        self.status_generation = 0
+        self._status_cache = None
         gcode = self.printer.lookup_object('gcode')
         gcode.register_command("SAVE_CONFIG", self.cmd_SAVE_CONFIG,
                                desc=self.cmd_SAVE_CONFIG_help)
@@ -297,17 +382,28 @@ class ConfigAutoSave:
         cfgrdr = ConfigFileReader()
         data = cfgrdr.read_config_file(filename)
         regular_data, autosave_data = self._find_autosave_data(data)
-        regular_fileconfig = cfgrdr.build_fileconfig_with_includes(
-            regular_data, filename)
+        ccache = ConfigCache(filename)
+        regular_fileconfig = ccache.lookup(cfgrdr, regular_data)
+        if regular_fileconfig is None:
+            regular_fileconfig = cfgrdr.build_fileconfig_with_includes(
+                regular_data, filename, ccache)
+            ccache.store(regular_data, regular_fileconfig)
         autosave_data = self._strip_duplicates(autosave_data,
                                                regular_fileconfig)
         self.fileconfig = cfgrdr.build_fileconfig(autosave_data, filename)
         cfgrdr.append_fileconfig(regular_fileconfig,
                                  autosave_data, '*AUTOSAVE*')
         return regular_fileconfig, self.fileconfig
+    def _note_status_change(self):
+        # Invalidate the cached get_status() snapshot
+        self.status_generation += 1
+        self._status_cache = None
     def get_status(self, eventtime):
-        return {'save_config_pending': self.save_config_pending,
+        if self._status_cache is None:
+            self._status_cache = {
+                'save_config_pending': self.save_config_pending,
                 'save_config_pending_items': self.status_save_pending}
+        return self._status_cache
     def set(self, section, option, value):
         if not self.fileconfig.has_section(section):
             self.fileconfig.add_section(section)
@@ -321,6 +417,7 @@ class ConfigAutoSave:
         pending[section][option] = svalue
         self.status_save_pending = pending
         self.save_config_pending = True
+        self._note_status_change()
         logging.info("save_config: set [%s] %s = %s", section, option, svalue)
     def remove_section(self, section):
         if self.fileconfig.has_section(section):
@@ -329,12 +426,14 @@ class ConfigAutoSave:
             pending[section] = None
             self.status_save_pending = pending
             self.save_config_pending = True
+            self._note_status_change()
         elif (section in self.status_save_pending and
               self.status_save_pending[section] is not None):
             pending = dict(self.status_save_pending)
             del pending[section]
             self.status_save_pending = pending
             self.save_config_pending = True
+            self._note_status_change()
     def _disallow_include_conflicts(self, regular_fileconfig):
         for section in self.fileconfig.sections():
             for option in self.fileconfig.options(section):
@@ -342,10 +441,93 @@ class ConfigAutoSave:
                     msg = ("SAVE_CONFIG section '%s' option '%s' conflicts "
                            "with included value" % (section, option))
                     raise self.printer.command_error(msg)
+    def _try_incremental_save(self, gcmd):
+        # Attempt to persist pending changes by appending only the
+        # changed options as additional autosave lines.  Duplicate
+        # sections and options in the autosave block apply linearly on
+        # the next startup, so the append acts as a journal that the
+        # next full SAVE_CONFIG compacts.
+        pending = self.status_save_pending
+        if not pending or None in pending.values():
+            # Section removals can not be expressed as an append
+            return False
+        cfgrdr = ConfigFileReader()
+        cfgname = self.printer.get_start_args()['config_file']
+        try:
+            data = cfgrdr.read_config_file(cfgname)
+        except error as e:
+            msg = "Unable to read existing config on SAVE_CONFIG"
+            logging.exception(msg)
+            raise gcmd.error(msg)
+        regular_data, autosave_data = self._find_autosave_data(data)
+        if data.find(AUTOSAVE_HEADER) >= 0:
+            if not autosave_data.strip():
+                # Existing autosave block is corrupted
+                return False
+            if data != data.rstrip('\n') + '\n':
+                # Trailing blank lines would corrupt an appended block
+                return False
+        try:
+            regular_fileconfig = cfgrdr.build_fileconfig_with_includes(
+                regular_data, cfgname)
+        except error as e:
+            return False
+        for section, options in pending.items():
+            for option in options:
+                if regular_fileconfig.has_option(section, option):
+                    # The main config defines this option and would
+                    # override an appended value on the next startup -
+                    # the full rewrite is needed to comment it out
+                    return False
+        # Build journal containing just the pending options
+        journal_fileconfig = cfgrdr.build_fileconfig("", cfgname)
+        for section in sorted(pending):
+            journal_fileconfig.add_section(section)
+            for option in sorted(pending[section]):
+                journal_fileconfig.set(section, option,
+                                       self.fileconfig.get(section, option))
+        journal_data = cfgrdr.build_config_string(journal_fileconfig)
+        lines = [('#*# ' + l).strip() for l in journal_data.split('\n')]
+        if data.find(AUTOSAVE_HEADER) < 0:
+            lines.insert(0, "\n" + AUTOSAVE_HEADER.rstrip())
+        journal = '\n'.join(lines) + '\n'
+        if data and not data.endswith('\n'):
+            journal = '\n' + journal
+        # Verify the resulting file parses before touching it
+        new_regular_data, new_autosave_data = self._find_autosave_data(
+            data + journal)
+        try:
+            cfgrdr.build_fileconfig(new_autosave_data, cfgname)
+        except error as e:
+            logging.exception("SAVE_CONFIG append validation failed")
+            return False
+        if not new_autosave_data.strip():
+            return False
+        # Append journal to the config file
+        logging.info("SAVE_CONFIG append to '%s'", cfgname)
+        try:
+            f = open(cfgname, 'a')
+            f.write(journal)
+            f.flush()
+            os.fsync(f.fileno())
+            f.close()
+        except:
+            msg = "Unable to append config file during SAVE_CONFIG"
+            logging.exception(msg)
+            raise gcmd.error(msg)
+        return True
+    def _clear_pending(self):
+        self.status_save_pending = {}
+        self.save_config_pending = False
+        self._note_status_change()
     cmd_SAVE_CONFIG_help = "Overwrite config file and restart"
     def cmd_SAVE_CONFIG(self, gcmd):
         if not self.fileconfig.sections():
             return
+        do_restart = gcmd.get_int('RESTART', 1, minval=0, maxval=1)
+        if not do_restart and self._try_incremental_save(gcmd):
+            self._clear_pending()
+            return
         # Create string containing autosave data
         cfgrdr = ConfigFileReader()
         autosave_data = cfgrdr.build_config_string(self.fileconfig)
@@ -398,6 +580,11 @@ class ConfigAutoSave:
             msg = "Unable to write config file during SAVE_CONFIG"
             logging.exception(msg)
             raise gcmd.error(msg)
+        if not do_restart:
+            # Saved state matches the file; the running session keeps
+            # its current settings until the next restart
+            self._clear_pending()
+            return
         # Request a restart
         gcode = self.printer.lookup_object('gcode')
         gcode.request_restart('restart')
@@ -464,6 +651,9 @@ class PrinterConfig:
         self.deprecated = {}
         self.status_raw_config = {}
         self.status_warnings = []
+        self.status_generation = 0
+        self._status_cache = None
+        self._status_cache_gen = None
     def get_printer(self):
         return self.printer
     def read_config(self, filename):
@@ -494,6 +684,7 @@ class PrinterConfig:
             return False
         self.deprecated[key] = True
         self.status_warnings = self.status_warnings + [data]
+        self.status_generation += 1
         return True
     def runtime_warning(self, msg):
         res = {'type': 'runtime_warning', 'message': msg}
@@ -547,12 +738,18 @@ class PrinterConfig:
             self.status_raw_config[section.get_name()] = section_status = {}
             for option in section.get_prefix_options(''):
                 section_status[option] = section.get(option, note_valid=False)
+        self.status_generation += 1
     def get_status(self, eventtime):
-        status = {'config': self.status_raw_config,
-                  'warnings': self.status_warnings}
-        status.update(self.autosave.get_status(eventtime))
-        status.update(self.validate.get_status(eventtime))
-        return status
+        # Serve a cached snapshot while no component has changed
+        gen = (self.status_generation, self.autosave.status_generation)
+        if self._status_cache is None or self._status_cache_gen != gen:
+            status = {'config': self.status_raw_config,
+                      'warnings': self.status_warnings}
+            status.update(self.autosave.get_status(eventtime))
+            status.update(self.validate.get_status(eventtime))
+            self._status_cache = status
+            self._status_cache_gen = gen
+        return self._status_cache
     # Autosave functions
     def set(self, section, option, value):
         self.autosave.set(section, option, value)
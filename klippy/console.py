@@ -15,6 +15,7 @@ help_txt = """
     FLOOD : Send a command many times (eg, "FLOOD 22 .01 get_uptime")
     SUPPRESS : Suppress a response message (eg, "SUPPRESS analog_in_state 4")
     SET   : Create a local variable (eg, "SET myvar 123.4")
+    JITTER : Report a stepper jitter histogram (eg, "JITTER 0")
     DUMP  : Dump memory (eg, "DUMP 0x12345678 100 32")
     FILEDUMP : Dump to file (eg, "FILEDUMP data.bin 0x12345678 100 32")
     STATS : Report serial statistics
@@ -47,7 +48,7 @@ class KeyboardReader:
         reactor.register_fd(self.fd, self.process_kbd)
         reactor.register_callback(self.connect)
         self.local_commands = {
-            "SET": self.command_SET,
+            "SET": self.command_SET, "JITTER": self.command_JITTER,
             "DUMP": self.command_DUMP, "FILEDUMP": self.command_FILEDUMP,
             "DELAY": self.command_DELAY, "FLOOD": self.command_FLOOD,
             "SUPPRESS": self.command_SUPPRESS, "STATS": self.command_STATS,
@@ -99,6 +100,35 @@ class KeyboardReader:
         except ValueError:
             pass
         self.eval_globals[parts[1]] = val
+    def command_JITTER(self, parts):
+        # Query and report a stepper step dispatch latency histogram
+        try:
+            oid = int(parts[1])
+        except (IndexError, ValueError) as e:
+            self.output("Error: JITTER <stepper oid>")
+            return
+        cmd = "stepper_get_jitter oid=%d" % (oid,)
+        try:
+            params = self.ser.send_with_response(cmd, "stepper_jitter")
+        except Exception as e:
+            self.output("Error: %s" % (str(e),))
+            return
+        data = bytearray(params['counts'])
+        counts = [sum([data[p*4 + b] << (8 * b) for b in range(4)])
+                  for p in range(len(data) // 4)]
+        ticks_to_us = 1000000. / self.mcu_freq
+        self.output("Stepper %d dispatch latency (%d samples, max %.3fus):"
+                    % (oid, sum(counts), params['max'] * ticks_to_us))
+        for i, count in enumerate(counts):
+            if not count:
+                continue
+            lo = 0 if not i else 1 << i
+            if i == len(counts) - 1:
+                self.output("  >=%9.3fus: %d" % (lo * ticks_to_us, count))
+            else:
+                hi = (1 << (i + 1)) - 1
+                self.output("  %9.3fus - %9.3fus: %d"
+                            % (lo * ticks_to_us, hi * ticks_to_us, count))
     def command_DUMP(self, parts, filename=None):
         # Extract command args
         try:
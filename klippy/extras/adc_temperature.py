@@ -4,6 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging, bisect
+import chelper
 
 
 ######################################################################
@@ -14,6 +15,7 @@ SAMPLE_TIME = 0.001
 SAMPLE_COUNT = 8
 REPORT_TIME = 0.300
 RANGE_CHECK_COUNT = 4
+CONV_TABLE_SIZE = 1024
 
 # Interface between ADC and heater temperature callbacks
 class PrinterADCtoTemperature:
@@ -24,17 +26,46 @@ class PrinterADCtoTemperature:
         self.mcu_adc.setup_adc_callback(self.adc_callback)
         self.diag_helper = HelperTemperatureDiagnostics(
             config, self.mcu_adc, adc_convert.calc_temp)
+        self.ffi_lib = self.c_conv = None
     def setup_callback(self, temperature_callback):
         self.temperature_callback = temperature_callback
     def get_report_time_delta(self):
         return REPORT_TIME
+    def get_mcu_adc(self):
+        return self.mcu_adc
+    def calc_adc(self, temp):
+        return self.adc_convert.calc_adc(temp)
     def adc_callback(self, samples):
         read_time, read_value = samples[-1]
-        temp = self.adc_convert.calc_temp(read_value)
+        if self.c_conv is not None:
+            temp = self.ffi_lib.temp_conversion_calc_temp(self.c_conv,
+                                                          read_value)
+        else:
+            temp = self.adc_convert.calc_temp(read_value)
         self.temperature_callback(read_time + SAMPLE_COUNT * SAMPLE_TIME, temp)
+    def _build_conversion_table(self, min_adc, max_adc):
+        # Tabulate the conversion over the valid adc range so reports
+        # convert via a table lookup (readings outside the range clamp
+        # to the table ends - they already request an mcu shutdown)
+        if not max_adc > min_adc:
+            return
+        adc_step = (max_adc - min_adc) / CONV_TABLE_SIZE
+        try:
+            temps = [self.adc_convert.calc_temp(min_adc + i * adc_step)
+                     for i in range(CONV_TABLE_SIZE + 1)]
+        except Exception:
+            logging.exception("Unable to tabulate adc conversion")
+            return
+        ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.c_conv = ffi_main.gc(
+            self.ffi_lib.temp_conversion_alloc(CONV_TABLE_SIZE),
+            self.ffi_lib.free)
+        self.ffi_lib.temp_conversion_fill(self.c_conv, min_adc, adc_step,
+                                          temps)
     def setup_minmax(self, min_temp, max_temp):
         arange = [self.adc_convert.calc_adc(t) for t in [min_temp, max_temp]]
         min_adc, max_adc = sorted(arange)
+        self._build_conversion_table(min_adc, max_adc)
         self.mcu_adc.setup_adc_sample(REPORT_TIME, SAMPLE_TIME, SAMPLE_COUNT,
                                       minval=min_adc, maxval=max_adc,
                                       range_check_count=RANGE_CHECK_COUNT)
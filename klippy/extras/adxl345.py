@@ -207,7 +207,8 @@ class ADXL345:
         mcu.register_config_callback(self._build_config)
         # Bulk sample message reading
         chip_smooth = self.data_rate * BATCH_UPDATES * 2
-        self.ffreader = bulk_sensor.FixedFreqReader(mcu, chip_smooth, "BBBBB")
+        self.ffreader = bulk_sensor.AccelSampleReader(mcu, chip_smooth,
+                                                      'adxl345', self.axes_map)
         self.last_error_count = 0
         # Process messages in batches
         self.batch_bulk = bulk_sensor.BatchBulkHelper(
@@ -240,25 +241,6 @@ class ADXL345:
         aqh = AccelQueryHelper(self.printer)
         self.batch_bulk.add_client(aqh.handle_batch)
         return aqh
-    # Measurement decoding
-    def _convert_samples(self, samples):
-        (x_pos, x_scale), (y_pos, y_scale), (z_pos, z_scale) = self.axes_map
-        count = 0
-        for ptime, xlow, ylow, zlow, xzhigh, yzhigh in samples:
-            if yzhigh & 0x80:
-                self.last_error_count += 1
-                continue
-            rx = (xlow | ((xzhigh & 0x1f) << 8)) - ((xzhigh & 0x10) << 9)
-            ry = (ylow | ((yzhigh & 0x1f) << 8)) - ((yzhigh & 0x10) << 9)
-            rz = ((zlow | ((xzhigh & 0xe0) << 3) | ((yzhigh & 0xe0) << 6))
-                  - ((yzhigh & 0x40) << 7))
-            raw_xyz = (rx, ry, rz)
-            x = round(raw_xyz[x_pos] * x_scale, 6)
-            y = round(raw_xyz[y_pos] * y_scale, 6)
-            z = round(raw_xyz[z_pos] * z_scale, 6)
-            samples[count] = (round(ptime, 6), x, y, z)
-            count += 1
-        del samples[count:]
     # Start, stop, and process message batches
     def _start_measurements(self):
         # In case of miswiring, testing ADXL345 device ID prevents treating
@@ -292,7 +274,7 @@ class ADXL345:
         logging.info("ADXL345 finished '%s' measurements", self.name)
     def _process_batch(self, eventtime):
         samples = self.ffreader.pull_samples()
-        self._convert_samples(samples)
+        self.last_error_count = self.ffreader.get_error_count()
         if not samples:
             return {}
         return {'data': samples, 'errors': self.last_error_count,
@@ -4,6 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging, math
+import chelper
 from . import bus, bulk_sensor
 
 MIN_MSG_TIME = 0.100
@@ -19,6 +20,7 @@ class AngleCalibration:
     def __init__(self, config):
         self.printer = config.get_printer()
         self.name = config.get_name()
+        self.calibration_version = 0
         self.stepper_name = config.get('stepper', None)
         if self.stepper_name is None:
             # No calibration
@@ -71,28 +73,17 @@ class AngleCalibration:
             phase_diff -= phases
         # Store final offset
         self.mcu_pos_offset = mcu_pos - (angle_mpos - phase_diff)
-    def apply_calibration(self, samples):
-        calibration = self.calibration
-        if not calibration:
+    def get_calibration(self):
+        # Return interpolation table for the C helper sample decoder
+        if self.stepper_name is None:
+            return [], False
+        return self.calibration, self.calibration_reversed
+    def get_position_offset(self, sample):
+        # Determine the stepper position offset of calibrated samples
+        if self.stepper_name is None or not self.calibration:
             return None
-        calibration_reversed = self.calibration_reversed
-        interp_bits = ANGLE_BITS - CALIBRATION_BITS
-        interp_mask = (1 << interp_bits) - 1
-        interp_round = 1 << (interp_bits - 1)
-        for i, (samp_time, angle) in enumerate(samples):
-            bucket = (angle & 0xffff) >> interp_bits
-            cal1 = calibration[bucket]
-            cal2 = calibration[bucket + 1]
-            adj = (angle & interp_mask) * (cal2 - cal1)
-            adj = cal1 + ((adj + interp_round) >> interp_bits)
-            angle_diff = (adj - angle) & 0xffff
-            angle_diff -= (angle_diff & 0x8000) << 1
-            new_angle = angle + angle_diff
-            if calibration_reversed:
-                new_angle = -new_angle
-            samples[i] = (samp_time, new_angle)
         if self.mcu_pos_offset is None:
-            self.calc_mcu_pos_offset(samples[0])
+            self.calc_mcu_pos_offset(sample)
             if self.mcu_pos_offset is None:
                 return None
         return self.mcu_stepper.mcu_to_commanded_position(self.mcu_pos_offset)
@@ -128,6 +119,7 @@ class AngleCalibration:
         sol = numpy.linalg.lstsq(eqs, ans, rcond=None)[0]
         isol = [int(s + .5) for s in sol]
         self.calibration = isol + [isol[0] + angle_max]
+        self.calibration_version += 1
     def lookup_tmc(self):
         for driver in TRINAMIC_DRIVERS:
             driver_name = "%s %s" % (driver, self.stepper_name)
@@ -228,10 +220,12 @@ class AngleCalibration:
         # Perform calibration movement and capture
         old_calibration = self.calibration
         self.calibration = []
+        self.calibration_version += 1
         try:
             fcal, rcal = self.do_calibration_moves()
         finally:
             self.calibration = old_calibration
+            self.calibration_version += 1
         # Calculate each step position average and variance
         microsteps, full_steps = self.get_microsteps()
         fangles, fstd, ftotal = self.calc_angles(fcal)
@@ -612,10 +606,18 @@ class Angle:
         self.printer = config.get_printer()
         self.sample_period = config.getfloat('sample_period', SAMPLE_PERIOD,
                                              above=0.)
+        self.burst_count = config.getint('burst_count', 1, minval=1,
+                                         maxval=SAMPLES_PER_BLOCK)
         self.calibration = AngleCalibration(config)
-        # Measurement conversion
+        # Measurement conversion (decoded in the C helper)
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.decoder = self.ffi_main.gc(self.ffi_lib.angle_samples_alloc(),
+                                        self.ffi_lib.free)
+        self.pushed_cal_version = -1
+        self.out_alloc = 64 * SAMPLES_PER_BLOCK
+        self.out = self.ffi_main.new('double[]', 2 * self.out_alloc)
         self.start_clock = self.time_shift = self.sample_ticks = 0
-        self.last_sequence = self.last_angle = 0
+        self.last_sequence = 0
         # Sensor type
         sensors = { "a1333": HelperA1333,
                     "as5047d": HelperAS5047D,
@@ -634,6 +636,9 @@ class Angle:
         mcu.add_config_cmd(
             "config_spi_angle oid=%d spi_oid=%d spi_angle_type=%s"
             % (oid, self.spi.get_oid(), sensor_type))
+        if self.burst_count > 1:
+            mcu.add_config_cmd("spi_angle_set_burst oid=%d count=%d"
+                               % (oid, self.burst_count))
         mcu.add_config_cmd(
             "query_spi_angle oid=%d clock=0 rest_ticks=0 time_shift=0"
             % (oid,), on_restart=True)
@@ -661,59 +666,54 @@ class Angle:
         self.batch_bulk.add_client(client_cb)
     # Measurement decoding
     def _extract_samples(self, raw_samples):
-        # Load variables to optimize inner loop below
-        sample_ticks = self.sample_ticks
+        ffi_main, ffi_lib, decoder = self.ffi_main, self.ffi_lib, self.decoder
+        # Push calibration table to the decoder (when changed)
+        if self.calibration.calibration_version != self.pushed_cal_version:
+            table, cal_reversed = self.calibration.get_calibration()
+            ffi_lib.angle_samples_set_calibration(decoder, table, len(table),
+                                                  cal_reversed)
+            self.pushed_cal_version = self.calibration.calibration_version
+        # Determine batch timing parameters
         start_clock = self.start_clock
         clock_to_print_time = self.mcu.clock_to_print_time
-        last_sequence = self.last_sequence
-        last_angle = self.last_angle
-        time_shift = 0
-        static_delay = 0.
-        last_chip_mcu_clock = last_chip_clock = chip_freq = inv_chip_freq = 0.
-        is_tcode_absolute = self.sensor_helper.is_tcode_absolute
-        if is_tcode_absolute:
-            tparams = self.sensor_helper.get_tcode_params()
-            last_chip_mcu_clock, last_chip_clock, chip_freq = tparams
-            inv_chip_freq = 1. / chip_freq
+        time_base = clock_to_print_time(start_clock)
+        inv_freq = (clock_to_print_time(start_clock + (1 << 20))
+                    - time_base) / (1 << 20)
+        if self.sensor_helper.is_tcode_absolute:
+            time_shift = 0
+            static_delay = 0.
         else:
             time_shift = self.time_shift
             static_delay = self.sensor_helper.get_static_delay()
-        # Process every message in raw_samples
-        count = error_count = 0
-        samples = [None] * (len(raw_samples) * SAMPLES_PER_BLOCK)
+        ffi_lib.angle_samples_setup_batch(
+            decoder, float(start_clock), self.sample_ticks, self.burst_count,
+            time_shift, time_base, inv_freq, static_delay)
+        if self.sensor_helper.is_tcode_absolute:
+            tparams = self.sensor_helper.get_tcode_params()
+            last_chip_mcu_clock, last_chip_clock, chip_freq = tparams
+            ffi_lib.angle_samples_setup_tcode_absolute(
+                decoder, float(last_chip_mcu_clock), float(last_chip_clock),
+                chip_freq)
+        # Decode every message in raw_samples via the C helper
+        last_sequence = self.last_sequence
+        max_samples = len(raw_samples) * SAMPLES_PER_BLOCK
+        if max_samples > self.out_alloc:
+            self.out_alloc = max_samples
+            self.out = ffi_main.new('double[]', 2 * self.out_alloc)
+        count = 0
         for params in raw_samples:
             seq_diff = (params['sequence'] - last_sequence) & 0xffff
             last_sequence += seq_diff
             samp_count = last_sequence * SAMPLES_PER_BLOCK
-            msg_mclock = start_clock + samp_count*sample_ticks
-            d = bytearray(params['data'])
-            for i in range(len(d) // BYTES_PER_SAMPLE):
-                d_ta = d[i*BYTES_PER_SAMPLE:(i+1)*BYTES_PER_SAMPLE]
-                tcode = d_ta[0]
-                if tcode == TCODE_ERROR:
-                    error_count += 1
-                    continue
-                raw_angle = d_ta[1] | (d_ta[2] << 8)
-                angle_diff = (raw_angle - last_angle) & 0xffff
-                angle_diff -= (angle_diff & 0x8000) << 1
-                last_angle += angle_diff
-                mclock = msg_mclock + i*sample_ticks
-                if is_tcode_absolute:
-                    # tcode is tle5012b frame counter
-                    mdiff = mclock - last_chip_mcu_clock
-                    chip_mclock = last_chip_clock + int(mdiff * chip_freq + .5)
-                    cdiff = ((tcode << 10) - chip_mclock) & 0xffff
-                    cdiff -= (cdiff & 0x8000) << 1
-                    sclock = mclock + (cdiff - 0x800) * inv_chip_freq
-                else:
-                    # tcode is mcu clock offset shifted by time_shift
-                    sclock = mclock + (tcode<<time_shift)
-                ptime = round(clock_to_print_time(sclock) - static_delay, 6)
-                samples[count] = (ptime, last_angle)
-                count += 1
+            data = params['data']
+            count += ffi_lib.angle_samples_decode(
+                decoder, ffi_main.from_buffer('uint8_t[]', data), len(data),
+                samp_count, self.out + 2 * count)
         self.last_sequence = last_sequence
-        self.last_angle = last_angle
-        del samples[count:]
+        error_count = ffi_lib.angle_samples_get_errors(decoder)
+        ffi_lib.angle_samples_reset_errors(decoder)
+        flat = ffi_main.unpack(self.out, 2 * count)
+        samples = list(zip(flat[0::2], flat[1::2]))
         return samples, error_count
     # Start, stop, and process message batches
     def _is_measuring(self):
@@ -727,7 +727,8 @@ class Angle:
         systime = self.printer.get_reactor().monotonic()
         print_time = self.mcu.estimated_print_time(systime) + MIN_MSG_TIME
         self.start_clock = reqclock = self.mcu.print_time_to_clock(print_time)
-        rest_ticks = self.mcu.seconds_to_clock(self.sample_period)
+        rest_ticks = self.mcu.seconds_to_clock(self.sample_period
+                                               * self.burst_count)
         self.sample_ticks = rest_ticks
         self.query_spi_angle_cmd.send([self.oid, reqclock, rest_ticks,
                                        self.time_shift], reqclock=reqclock)
@@ -746,7 +747,7 @@ class Angle:
         samples, error_count = self._extract_samples(raw_samples)
         if not samples:
             return {}
-        offset = self.calibration.apply_calibration(samples)
+        offset = self.calibration.get_position_offset(samples[0])
         return {'data': samples, 'errors': error_count,
                 'position_offset': offset}
 
@@ -4,6 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging, math, json, collections
+import chelper
 from . import probe
 
 PROFILE_VERSION = 1
@@ -1263,6 +1264,8 @@ class MoveSplitter:
         self.z_mesh = None
         self.fade_offset = 0.
         self.gcode = gcode
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.next_z = self.ffi_main.new('double[1]')
     def initialize(self, mesh, fade_offset):
         self.z_mesh = mesh
         self.fade_offset = fade_offset
@@ -1295,16 +1298,34 @@ class MoveSplitter:
         if not self.traverse_complete:
             if self.axis_move[0] or self.axis_move[1]:
                 # X and/or Y axis move, traverse if necessary
-                while self.distance_checked + self.move_check_distance \
-                        < self.total_move_length:
-                    self.distance_checked += self.move_check_distance
-                    self._set_next_move(self.distance_checked)
-                    next_z = self._calc_z_offset(self.current_pos)
-                    if abs(next_z - self.z_offset) >= self.split_delta_z:
-                        self.z_offset = next_z
+                c_mesh = self.z_mesh.get_c_mesh()
+                if c_mesh is not None:
+                    px, py = self.prev_pos[:2]
+                    nx = self.next_pos[0] if self.axis_move[0] else px
+                    ny = self.next_pos[1] if self.axis_move[1] else py
+                    dist = self.ffi_lib.zmesh_next_split(
+                        c_mesh, px, py, nx, ny, self.total_move_length,
+                        self.distance_checked, self.move_check_distance,
+                        self.z_offset, self.split_delta_z,
+                        self.z_factor, self.fade_offset, self.next_z)
+                    if dist >= 0.:
+                        self.distance_checked = dist
+                        self._set_next_move(dist)
+                        self.z_offset = self.next_z[0]
                         newpos = list(self.current_pos)
                         newpos[2] += self.z_offset
                         return newpos
+                else:
+                    while self.distance_checked + self.move_check_distance \
+                            < self.total_move_length:
+                        self.distance_checked += self.move_check_distance
+                        self._set_next_move(self.distance_checked)
+                        next_z = self._calc_z_offset(self.current_pos)
+                        if abs(next_z - self.z_offset) >= self.split_delta_z:
+                            self.z_offset = next_z
+                            newpos = list(self.current_pos)
+                            newpos[2] += self.z_offset
+                            return newpos
             # end of move reached
             self.current_pos[:] = self.next_pos
             self.z_offset = self._calc_z_offset(self.current_pos)
@@ -1324,6 +1345,8 @@ class ZMesh:
         self.probed_matrix = self.mesh_matrix = None
         self.mesh_params = params
         self.mesh_offsets = [0., 0.]
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.c_mesh = None
         logging.debug('bed_mesh: probe/mesh parameters:')
         for key, value in self.mesh_params.items():
             logging.debug("%s :  %s" % (key, value))
@@ -1405,7 +1428,22 @@ class ZMesh:
     def build_mesh(self, z_matrix):
         self.probed_matrix = z_matrix
         self._sample(z_matrix)
+        self._build_c_mesh()
         self.print_mesh(logging.debug)
+    def _build_c_mesh(self):
+        # Bake the interpolated matrix into a C lookup helper
+        flat_z = [z for row in self.mesh_matrix for z in row]
+        cm = self.ffi_lib.zmesh_alloc(
+            flat_z, self.mesh_x_count, self.mesh_y_count,
+            self.mesh_x_min, self.mesh_x_dist,
+            self.mesh_y_min, self.mesh_y_dist)
+        if cm == self.ffi_main.NULL:
+            raise BedMeshError("bed_mesh: Unable to allocate mesh")
+        self.c_mesh = self.ffi_main.gc(cm, self.ffi_lib.zmesh_free)
+        self.ffi_lib.zmesh_set_offsets(
+            self.c_mesh, self.mesh_offsets[0], self.mesh_offsets[1])
+    def get_c_mesh(self):
+        return self.c_mesh
     def set_zero_reference(self, xpos, ypos):
         offset = self.calc_z(xpos, ypos)
         logging.info(
@@ -1416,15 +1454,21 @@ class ZMesh:
             for yidx in range(len(matrix)):
                 for xidx in range(len(matrix[yidx])):
                     matrix[yidx][xidx] -= offset
+        self._build_c_mesh()
     def set_mesh_offsets(self, offsets):
         for i, o in enumerate(offsets):
             if o is not None:
                 self.mesh_offsets[i] = o
+        if self.c_mesh is not None:
+            self.ffi_lib.zmesh_set_offsets(
+                self.c_mesh, self.mesh_offsets[0], self.mesh_offsets[1])
     def get_x_coordinate(self, index):
         return self.mesh_x_min + self.mesh_x_dist * index
     def get_y_coordinate(self, index):
         return self.mesh_y_min + self.mesh_y_dist * index
     def calc_z(self, x, y):
+        if self.c_mesh is not None:
+            return self.ffi_lib.zmesh_calc_z(self.c_mesh, x, y)
         if self.mesh_matrix is not None:
             tbl = self.mesh_matrix
             tx, xidx = self._get_linear_index(x + self.mesh_offsets[0], 0)
@@ -1631,6 +1675,9 @@ class ProfileManager:
         self.gcode = self.printer.lookup_object('gcode')
         self.bedmesh = bedmesh
         self.profiles = {}
+        # Cache of fully built meshes (with their baked C lookup
+        # helpers) so switching between profiles does not resample
+        self.mesh_cache = {}
         self.incompatible_profiles = []
         # Fetch stored profiles from Config
         stored_profs = config.get_prefix_sections(self.name)
@@ -1704,6 +1751,10 @@ class ProfileManager:
         profile['points'] = probed_matrix
         profile['mesh_params'] = collections.OrderedDict(mesh_params)
         self.profiles = profiles
+        if z_mesh.get_profile_name() == prof_name:
+            self.mesh_cache[prof_name] = z_mesh
+        else:
+            self.mesh_cache.pop(prof_name, None)
         self.bedmesh.update_status()
         self.gcode.respond_info(
             "Bed Mesh state has been saved to profile [%s]\n"
@@ -1715,13 +1766,20 @@ class ProfileManager:
         if profile is None:
             raise self.gcode.error(
                 "bed_mesh: Unknown profile [%s]" % prof_name)
-        probed_matrix = profile['points']
-        mesh_params = profile['mesh_params']
-        z_mesh = ZMesh(mesh_params, prof_name)
-        try:
-            z_mesh.build_mesh(probed_matrix)
-        except BedMeshError as e:
-            raise self.gcode.error(str(e))
+        z_mesh = self.mesh_cache.get(prof_name)
+        if z_mesh is None:
+            probed_matrix = profile['points']
+            mesh_params = profile['mesh_params']
+            z_mesh = ZMesh(mesh_params, prof_name)
+            try:
+                z_mesh.build_mesh(probed_matrix)
+            except BedMeshError as e:
+                raise self.gcode.error(str(e))
+            self.mesh_cache[prof_name] = z_mesh
+        else:
+            # Cached meshes are fully built - just clear any runtime
+            # offsets a previous activation may have applied
+            z_mesh.set_mesh_offsets([0., 0.])
         self.bedmesh.set_mesh(z_mesh)
     def remove_profile(self, prof_name):
         if prof_name in self.profiles:
@@ -1730,6 +1788,7 @@ class ProfileManager:
             profiles = dict(self.profiles)
             del profiles[prof_name]
             self.profiles = profiles
+            self.mesh_cache.pop(prof_name, None)
             self.bedmesh.update_status()
             self.gcode.respond_info(
                 "Profile [%s] removed from storage for this session.\n"
@@ -10,34 +10,25 @@ from . import probe
 class BedTilt:
     def __init__(self, config):
         self.printer = config.get_printer()
-        self.printer.register_event_handler("klippy:connect",
-                                            self.handle_connect)
         self.x_adjust = config.getfloat('x_adjust', 0.)
         self.y_adjust = config.getfloat('y_adjust', 0.)
         self.z_adjust = config.getfloat('z_adjust', 0.)
         if config.get('points', None) is not None:
             BedTiltCalibrate(config, self)
-        self.toolhead = None
         # Register move transform with g-code class
         gcode_move = self.printer.load_object(config, 'gcode_move')
-        gcode_move.set_move_transform(self)
-    def handle_connect(self):
-        self.toolhead = self.printer.lookup_object('toolhead')
-    def get_position(self):
-        pos = self.toolhead.get_position()
-        x, y, z = pos[:3]
-        z -= x*self.x_adjust + y*self.y_adjust + self.z_adjust
-        return [x, y, z] + pos[3:]
-    def move(self, newpos, speed):
-        x, y, z = newpos[:3]
-        z += x*self.x_adjust + y*self.y_adjust + self.z_adjust
-        self.toolhead.move([x, y, z] + newpos[3:], speed)
+        gcode_move.set_affine_transform(self)
+    def get_affine(self):
+        return ([1., 0., 0.,
+                 0., 1., 0.,
+                 self.x_adjust, self.y_adjust, 1.],
+                [0., 0., self.z_adjust])
     def update_adjust(self, x_adjust, y_adjust, z_adjust):
         self.x_adjust = x_adjust
         self.y_adjust = y_adjust
         self.z_adjust = z_adjust
         gcode_move = self.printer.lookup_object('gcode_move')
-        gcode_move.reset_last_position()
+        gcode_move.update_affine_transform()
         configfile = self.printer.lookup_object('configfile')
         configfile.set('bed_tilt', 'x_adjust', "%.6f" % (x_adjust,))
         configfile.set('bed_tilt', 'y_adjust', "%.6f" % (y_adjust,))
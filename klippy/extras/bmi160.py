@@ -72,7 +72,9 @@ class BMI160:
         mcu.register_config_callback(self._build_config)
         # Bulk sample message reading
         chip_smooth = self.data_rate * BATCH_UPDATES * 2
-        self.ffreader = bulk_sensor.FixedFreqReader(mcu, chip_smooth, "<hhh")
+        self.ffreader = bulk_sensor.AccelSampleReader(mcu, chip_smooth,
+                                                      '<hhh',
+                                                      self.axes_map)
         self.last_error_count = 0
         # Process messages in batches
         self.batch_bulk = bulk_sensor.BatchBulkHelper(
@@ -118,17 +120,6 @@ class BMI160:
         aqh = adxl345.AccelQueryHelper(self.printer)
         self.batch_bulk.add_client(aqh.handle_batch)
         return aqh
-    def _convert_samples(self, samples):
-        (x_pos, x_scale), (y_pos, y_scale), (z_pos, z_scale) = self.axes_map
-        count = 0
-        for ptime, rx, ry, rz in samples:
-            raw_xyz = (rx, ry, rz)
-            x = round(raw_xyz[x_pos] * x_scale, 6)
-            y = round(raw_xyz[y_pos] * y_scale, 6)
-            z = round(raw_xyz[z_pos] * z_scale, 6)
-            samples[count] = (round(ptime, 6), x, y, z)
-            count += 1
-        del samples[count:]
     def _start_measurements(self):
         # 1. Force SPI Mode (Dummy Read)
         if self.bus_type == 'spi':
@@ -175,7 +166,6 @@ class BMI160:
         logging.info("BMI160 finished '%s' measurements", self.name)
     def _process_batch(self, eventtime):
         samples = self.ffreader.pull_samples()
-        self._convert_samples(samples)
         if not samples:
             return {}
         return {'data': samples, 'errors': self.last_error_count,
@@ -4,6 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging, threading, struct
+import chelper
 
 # This "bulk sensor" module facilitates the processing of sensor chip
 # measurements that do not require the host to respond with low
@@ -117,6 +118,12 @@ SENSOR_BULK_FMT = "sensor_bulk_data oid=%c sequence=%hu data=%*s"
 # Helper class to store incoming messages in a queue
 class BulkDataQueue:
     def __init__(self, mcu, msg_fmt=SENSOR_BULK_FMT, oid=None):
+        self.mcu = mcu
+        self.msg_fmt = msg_fmt
+        self.oid = oid
+        # Serialqueue consumer ring (allocated lazily as the serial
+        # connection may not be established yet)
+        self.bulk_reader = None
         # Measurement storage (accessed from background thread)
         self.lock = threading.Lock()
         self.raw_samples = []
@@ -126,6 +133,22 @@ class BulkDataQueue:
         with self.lock:
             self.raw_samples.append(params)
     def pull_queue(self):
+        if self.bulk_reader is None:
+            self.bulk_reader = self.mcu.alloc_bulk_reader(self.msg_fmt,
+                                                          self.oid)
+        if self.bulk_reader is not None:
+            # Read samples diverted into the consumer ring.  The
+            # returned memoryviews remain valid until the next pull.
+            raw_samples = self.bulk_reader.pull()
+            with self.lock:
+                stray_samples = self.raw_samples
+                self.raw_samples = []
+            if stray_samples:
+                # A message coalesced with another response arrived
+                # via the regular receive path - restore message order
+                raw_samples.extend(stray_samples)
+                raw_samples.sort(key=lambda params: params['#receive_time'])
+            return raw_samples
         with self.lock:
             raw_samples = self.raw_samples
             self.raw_samples = []
@@ -204,6 +227,11 @@ MAX_BULK_MSG_SIZE = 51
 
 # Read sensor_bulk_data and calculate timestamps for devices that take
 # samples at a fixed frequency (and produce fixed data size samples).
+_BULK_DECODE_FORMATS = {
+    '<i': 'BULK_FMT_INT32_LE', '>i': 'BULK_FMT_INT32_BE',
+    '<I': 'BULK_FMT_UINT32_LE', '>I': 'BULK_FMT_UINT32_BE',
+}
+
 class FixedFreqReader:
     def __init__(self, mcu, chip_clock_smooth, unpack_fmt):
         self.mcu = mcu
@@ -215,6 +243,17 @@ class FixedFreqReader:
         self.last_sequence = self.max_query_duration = 0
         self.last_overflows = 0
         self.bulk_queue = self.oid = self.query_status_cmd = None
+        # Decode single field samples in the C helper when possible
+        self.ffi_main = self.ffi_lib = self.decoder = None
+        c_format = _BULK_DECODE_FORMATS.get(unpack_fmt)
+        if c_format is not None:
+            self.ffi_main, self.ffi_lib = chelper.get_ffi()
+            self.decoder = self.ffi_main.gc(
+                self.ffi_lib.bulk_samples_alloc(
+                    getattr(self.ffi_lib, c_format)),
+                self.ffi_lib.free)
+            self.out_alloc = 64 * self.samples_per_block
+            self.out = self.ffi_main.new('double[]', 2 * self.out_alloc)
     def setup_query_command(self, msgformat, oid, cq):
         # Lookup sensor query command (that responds with sensor_bulk_status)
         self.oid = oid
@@ -274,6 +313,8 @@ class FixedFreqReader:
         raw_samples = self.bulk_queue.pull_queue()
         if not raw_samples:
             return []
+        if self.decoder is not None:
+            return self._pull_samples_c(raw_samples)
         # Load variables to optimize inner loop below
         last_sequence = self.last_sequence
         time_base, chip_base, inv_freq = self.clock_sync.get_time_translation()
@@ -297,3 +338,91 @@ class FixedFreqReader:
         self.clock_sync.set_last_chip_clock(seq * samples_per_block + i)
         del samples[count:]
         return samples
+    # Decode messages via the C helper (one ffi call per message)
+    def _pull_samples_c(self, raw_samples):
+        last_sequence = self.last_sequence
+        time_base, chip_base, inv_freq = self.clock_sync.get_time_translation()
+        bytes_per_sample = self.bytes_per_sample
+        samples_per_block = self.samples_per_block
+        max_samples = len(raw_samples) * samples_per_block
+        if max_samples > self.out_alloc:
+            self.out_alloc = max_samples
+            self.out = self.ffi_main.new('double[]', 2 * self.out_alloc)
+        count = seq = num_samples = 0
+        for params in raw_samples:
+            seq_diff = (params['sequence'] - last_sequence) & 0xffff
+            seq_diff -= (seq_diff & 0x8000) << 1
+            seq = last_sequence + seq_diff
+            msg_cdiff = seq * samples_per_block - chip_base
+            data = params['data']
+            num_samples = len(data) // bytes_per_sample
+            count += self.ffi_lib.bulk_samples_decode(
+                self.decoder, self.ffi_main.from_buffer('uint8_t[]', data),
+                len(data),
+                time_base, inv_freq, msg_cdiff, self.out + 2 * count)
+        self.clock_sync.set_last_chip_clock(seq * samples_per_block
+                                            + num_samples - 1)
+        flat = self.ffi_main.unpack(self.out, 2 * count)
+        return list(zip(flat[0::2], flat[1::2]))
+
+# Sample encodings handled by the C accel_samples decoder
+ACCEL_DECODE_FORMATS = {
+    'adxl345': ("BBBBB", 'ACCEL_FMT_ADXL345'),
+    '>hhh': (">hhh", 'ACCEL_FMT_INT16_BE'),
+    '<hhh': ("<hhh", 'ACCEL_FMT_INT16_LE'),
+}
+
+# Variant of FixedFreqReader that decodes and scales accelerometer
+# samples in the C helper (one ffi call per sensor_bulk_data message)
+class AccelSampleReader(FixedFreqReader):
+    def __init__(self, mcu, chip_clock_smooth, decode_fmt, axes_map):
+        unpack_fmt, c_format = ACCEL_DECODE_FORMATS[decode_fmt]
+        FixedFreqReader.__init__(self, mcu, chip_clock_smooth, unpack_fmt)
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.decoder = self.ffi_main.gc(
+            self.ffi_lib.accel_samples_alloc(getattr(self.ffi_lib, c_format)),
+            self.ffi_lib.free)
+        (x_pos, x_scale), (y_pos, y_scale), (z_pos, z_scale) = axes_map
+        self.ffi_lib.accel_samples_set_axes(self.decoder,
+                                            [x_pos, y_pos, z_pos],
+                                            [x_scale, y_scale, z_scale])
+        self.out_alloc = 64 * self.samples_per_block
+        self.out = self.ffi_main.new('double[]', 4 * self.out_alloc)
+    def get_error_count(self):
+        return self.ffi_lib.accel_samples_get_errors(self.decoder)
+    def note_start(self):
+        self.ffi_lib.accel_samples_reset_errors(self.decoder)
+        FixedFreqReader.note_start(self)
+    # Convert sensor_bulk_data responses into list of (time, x, y, z)
+    def pull_samples(self):
+        # Query MCU for sample timing and update clock synchronization
+        self._update_clock()
+        # Pull sensor_bulk_data messages from local queue
+        raw_samples = self.bulk_queue.pull_queue()
+        if not raw_samples:
+            return []
+        last_sequence = self.last_sequence
+        time_base, chip_base, inv_freq = self.clock_sync.get_time_translation()
+        bytes_per_sample = self.bytes_per_sample
+        samples_per_block = self.samples_per_block
+        max_samples = len(raw_samples) * samples_per_block
+        if max_samples > self.out_alloc:
+            self.out_alloc = max_samples
+            self.out = self.ffi_main.new('double[]', 4 * self.out_alloc)
+        # Decode every message in raw_samples via the C helper
+        count = seq = num_samples = 0
+        for params in raw_samples:
+            seq_diff = (params['sequence'] - last_sequence) & 0xffff
+            seq_diff -= (seq_diff & 0x8000) << 1
+            seq = last_sequence + seq_diff
+            msg_cdiff = seq * samples_per_block - chip_base
+            data = params['data']
+            num_samples = len(data) // bytes_per_sample
+            count += self.ffi_lib.accel_samples_decode(
+                self.decoder, self.ffi_main.from_buffer('uint8_t[]', data),
+                len(data),
+                time_base, inv_freq, msg_cdiff, self.out + 4 * count)
+        self.clock_sync.set_last_chip_clock(seq * samples_per_block
+                                            + num_samples - 1)
+        flat = self.ffi_main.unpack(self.out, 4 * count)
+        return list(zip(flat[0::4], flat[1::4], flat[2::4], flat[3::4]))
@@ -159,95 +159,46 @@ class MCU_ADC_buttons:
 # Rotary Encoders
 ######################################################################
 
-# Rotary encoder handler https://github.com/brianlow/Rotary
-# Copyright 2011 Ben Buxton (bb@cactii.net).
-# Licenced under the GNU GPL Version 3.
-class BaseRotaryEncoder:
-    R_START     = 0x0
-    R_DIR_CW    = 0x10
-    R_DIR_CCW   = 0x20
-    R_DIR_MSK   = 0x30
+# Time between reports of accumulated encoder movement
+ENCODER_REPORT_TIME = 0.050
 
-    def __init__(self, cw_callback, ccw_callback):
+# Rotary encoder decoded on the micro-controller (net movement reports)
+class MCU_rotary_encoder:
+    def __init__(self, printer, pin1_params, pin2_params,
+                 cw_callback, ccw_callback, steps_per_detent):
+        self.reactor = printer.get_reactor()
+        self.mcu = pin1_params['chip']
+        self.pin1_params = pin1_params
+        self.pin2_params = pin2_params
         self.cw_callback = cw_callback
         self.ccw_callback = ccw_callback
-        self.encoder_state = self.R_START
-    def encoder_callback(self, eventtime, state):
-        es = self.ENCODER_STATES[self.encoder_state & 0xf][state & 0x3]
-        self.encoder_state = es
-        if es & self.R_DIR_MSK == self.R_DIR_CW:
-            self.cw_callback(eventtime)
-        elif es & self.R_DIR_MSK == self.R_DIR_CCW:
-            self.ccw_callback(eventtime)
-
-class FullStepRotaryEncoder(BaseRotaryEncoder):
-    R_CW_FINAL  = 0x1
-    R_CW_BEGIN  = 0x2
-    R_CW_NEXT   = 0x3
-    R_CCW_BEGIN = 0x4
-    R_CCW_FINAL = 0x5
-    R_CCW_NEXT  = 0x6
-
-    # Use the full-step state table (emits a code at 00 only)
-    ENCODER_STATES = (
-        # R_START
-        (BaseRotaryEncoder.R_START, R_CW_BEGIN, R_CCW_BEGIN,
-         BaseRotaryEncoder.R_START),
-
-        # R_CW_FINAL
-        (R_CW_NEXT, BaseRotaryEncoder.R_START, R_CW_FINAL,
-         BaseRotaryEncoder.R_START | BaseRotaryEncoder.R_DIR_CW),
-
-        # R_CW_BEGIN
-        (R_CW_NEXT, R_CW_BEGIN, BaseRotaryEncoder.R_START,
-         BaseRotaryEncoder.R_START),
-
-        # R_CW_NEXT
-        (R_CW_NEXT, R_CW_BEGIN, R_CW_FINAL, BaseRotaryEncoder.R_START),
-
-        # R_CCW_BEGIN
-        (R_CCW_NEXT, BaseRotaryEncoder.R_START, R_CCW_BEGIN,
-         BaseRotaryEncoder.R_START),
-
-        # R_CCW_FINAL
-        (R_CCW_NEXT, R_CCW_FINAL, BaseRotaryEncoder.R_START,
-         BaseRotaryEncoder.R_START | BaseRotaryEncoder.R_DIR_CCW),
-
-        # R_CCW_NEXT
-        (R_CCW_NEXT, R_CCW_FINAL, R_CCW_BEGIN, BaseRotaryEncoder.R_START)
-    )
-
-class HalfStepRotaryEncoder(BaseRotaryEncoder):
-    # Use the half-step state table (emits a code at 00 and 11)
-    R_CCW_BEGIN   = 0x1
-    R_CW_BEGIN    = 0x2
-    R_START_M     = 0x3
-    R_CW_BEGIN_M  = 0x4
-    R_CCW_BEGIN_M = 0x5
-
-    ENCODER_STATES = (
-        # R_START (00)
-        (R_START_M, R_CW_BEGIN, R_CCW_BEGIN, BaseRotaryEncoder.R_START),
-
-        # R_CCW_BEGIN
-        (R_START_M | BaseRotaryEncoder.R_DIR_CCW, BaseRotaryEncoder.R_START,
-         R_CCW_BEGIN, BaseRotaryEncoder.R_START),
-
-        # R_CW_BEGIN
-        (R_START_M | BaseRotaryEncoder.R_DIR_CW,  R_CW_BEGIN,
-         BaseRotaryEncoder.R_START, BaseRotaryEncoder.R_START),
-
-        # R_START_M (11)
-        (R_START_M, R_CCW_BEGIN_M, R_CW_BEGIN_M,  BaseRotaryEncoder.R_START),
-
-        # R_CW_BEGIN_M
-        (R_START_M, R_START_M, R_CW_BEGIN_M,
-         BaseRotaryEncoder.R_START | BaseRotaryEncoder.R_DIR_CW),
-
-        # R_CCW_BEGIN_M
-        (R_START_M, R_CCW_BEGIN_M, R_START_M,
-         BaseRotaryEncoder.R_START | BaseRotaryEncoder.R_DIR_CCW),
-    )
+        self.steps_per_detent = steps_per_detent
+        self.oid = self.mcu.create_oid()
+        self.mcu.register_config_callback(self.build_config)
+    def build_config(self):
+        invert = self.pin1_params['invert'] | (self.pin2_params['invert'] << 1)
+        self.mcu.add_config_cmd(
+            "config_encoder oid=%d pin_a=%s pull_up_a=%d pin_b=%s pull_up_b=%d"
+            " invert=%d steps_per_detent=%d" % (
+                self.oid, self.pin1_params['pin'], self.pin1_params['pullup'],
+                self.pin2_params['pin'], self.pin2_params['pullup'],
+                invert, self.steps_per_detent))
+        clock = self.mcu.get_query_slot(self.oid)
+        rest_ticks = self.mcu.seconds_to_clock(QUERY_TIME)
+        report_ticks = self.mcu.seconds_to_clock(ENCODER_REPORT_TIME)
+        self.mcu.add_config_cmd(
+            "encoder_query oid=%d clock=%d rest_ticks=%d report_ticks=%d" % (
+                self.oid, clock, rest_ticks, report_ticks), is_init=True)
+        self.mcu.register_serial_response(
+            self.handle_encoder_state, "encoder_state oid=%c count=%hi",
+            self.oid)
+    def handle_encoder_state(self, params):
+        count = params['count']
+        callback = self.cw_callback if count > 0 else self.ccw_callback
+        btime = params['#receive_time']
+        for i in range(abs(count)):
+            self.reactor.register_async_callback(
+                (lambda et, c=callback, bt=btime: c(bt)))
 
 class DebounceButton:
     def __init__(self, config, button_action):
@@ -327,14 +278,18 @@ class PrinterButtons:
         mcu_buttons.setup_buttons(pin_params_list, callback)
     def register_rotary_encoder(self, pin1, pin2, cw_callback, ccw_callback,
                                 steps_per_detent):
-        if steps_per_detent == 2:
-            re = HalfStepRotaryEncoder(cw_callback, ccw_callback)
-        elif steps_per_detent == 4:
-            re = FullStepRotaryEncoder(cw_callback, ccw_callback)
-        else:
+        if steps_per_detent not in (2, 4):
             raise self.printer.config_error(
                 "%d steps per detent not supported" % steps_per_detent)
-        self.register_buttons([pin1, pin2], re.encoder_callback)
+        ppins = self.printer.lookup_object('pins')
+        pin_params_list = [ppins.lookup_pin(pin, can_invert=True,
+                                            can_pullup=True)
+                           for pin in [pin1, pin2]]
+        if pin_params_list[0]['chip'] is not pin_params_list[1]['chip']:
+            raise ppins.error("encoder pins must be on same mcu")
+        MCU_rotary_encoder(self.printer, pin_params_list[0],
+                           pin_params_list[1], cw_callback, ccw_callback,
+                           steps_per_detent)
     def register_button_push(self, pin, callback):
         def helper(eventtime, state, callback=callback):
             if state:
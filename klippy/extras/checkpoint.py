@@ -0,0 +1,197 @@
+# Periodic power-loss resume checkpoints
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import os, mmap, struct, zlib
+
+# Checkpoints are written to a small mmap'd file holding two slots.
+# Each snapshot fills the inactive slot and then stores the slot
+# generation counter, so a write torn by the power cut fails its crc
+# check and the previous checkpoint remains valid.
+CHECKPOINT_MAGIC = b'KLCP'
+CHECKPOINT_VERSION = 1
+HEADER_FMT = '<4sI8x'
+# file offset, coordinate flags, speed and factors, gcode position
+# state, live toolhead position, file name (relative to sdcard path)
+PAYLOAD_FMT = '<QBB6x3d16d256s'
+SLOT_FMT = '<QI4x'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+PAYLOAD_SIZE = struct.calcsize(PAYLOAD_FMT)
+SLOT_SIZE = struct.calcsize(SLOT_FMT) + PAYLOAD_SIZE
+CHECKPOINT_FILE_SIZE = 4096
+
+SAVED_STATE_NAME = 'POWER_LOSS'
+
+class Checkpoint:
+    def __init__(self, config):
+        self.printer = config.get_printer()
+        self.reactor = self.printer.get_reactor()
+        filename = config.get('filename', '~/.klipper-checkpoint')
+        self.filename = os.path.normpath(os.path.expanduser(filename))
+        self.interval = config.getfloat('interval', 2., above=.1)
+        self.mmap = None
+        self.generation = 0
+        self.timer = None
+        self.virtual_sdcard = self.printer.load_object(config,
+                                                       'virtual_sdcard')
+        self.gcode_move = self.printer.load_object(config, 'gcode_move')
+        self.motion_report = self.printer.load_object(config, 'motion_report')
+        self.printer.register_event_handler("klippy:ready", self._handle_ready)
+        self.printer.register_event_handler("virtual_sdcard:reset_file",
+                                            self._handle_reset_file)
+        self.gcode = self.printer.lookup_object('gcode')
+        self.gcode.register_command("CHECKPOINT_INFO", self.cmd_CHECKPOINT_INFO,
+                                    desc=self.cmd_CHECKPOINT_INFO_help)
+        self.gcode.register_command("CHECKPOINT_RESUME",
+                                    self.cmd_CHECKPOINT_RESUME,
+                                    desc=self.cmd_CHECKPOINT_RESUME_help)
+        self.gcode.register_command("CHECKPOINT_CLEAR",
+                                    self.cmd_CHECKPOINT_CLEAR,
+                                    desc=self.cmd_CHECKPOINT_CLEAR_help)
+    def _handle_ready(self):
+        self._open_file()
+        self.timer = self.reactor.register_timer(
+            self._checkpoint_timer, self.reactor.monotonic() + self.interval)
+    def _handle_reset_file(self):
+        # File unloaded outside of a print - drop any stale checkpoint
+        if self.mmap is not None and not self.virtual_sdcard.is_active():
+            self._write_slot(self._clear_payload())
+    def _open_file(self):
+        fd = os.open(self.filename, os.O_RDWR | os.O_CREAT, 0o644)
+        try:
+            if os.fstat(fd).st_size < CHECKPOINT_FILE_SIZE:
+                os.ftruncate(fd, CHECKPOINT_FILE_SIZE)
+            self.mmap = mmap.mmap(fd, CHECKPOINT_FILE_SIZE)
+        finally:
+            os.close(fd)
+        magic, version = struct.unpack_from(HEADER_FMT, self.mmap, 0)
+        if magic != CHECKPOINT_MAGIC or version != CHECKPOINT_VERSION:
+            self.mmap[:] = bytes(CHECKPOINT_FILE_SIZE)
+            struct.pack_into(HEADER_FMT, self.mmap, 0,
+                             CHECKPOINT_MAGIC, CHECKPOINT_VERSION)
+            self.mmap.flush()
+        # Continue the generation sequence of any existing checkpoint
+        for slot in range(2):
+            gen = struct.unpack_from(SLOT_FMT, self.mmap,
+                                     self._slot_offset(slot))[0]
+            if gen > self.generation:
+                self.generation = gen
+    def _slot_offset(self, slot):
+        return HEADER_SIZE + slot * SLOT_SIZE
+    def _checkpoint_timer(self, eventtime):
+        if self.virtual_sdcard.is_active():
+            payload = self._collect_payload(eventtime)
+            if payload is not None:
+                self._write_slot(payload)
+        return eventtime + self.interval
+    def _collect_payload(self, eventtime):
+        vsd = self.virtual_sdcard
+        file_path = vsd.file_path()
+        if file_path is None:
+            return None
+        fname = os.path.relpath(file_path, vsd.sdcard_dirname)
+        gm = self.gcode_move
+        live = self.motion_report.get_status(eventtime)['live_position']
+        return struct.pack(
+            PAYLOAD_FMT, vsd.file_position,
+            gm.absolute_coord, gm.absolute_extrude,
+            gm.speed, gm.speed_factor, gm.extrude_factor,
+            *gm.last_position[:4], *gm.base_position[:4],
+            *gm.homing_position[:4], *live[:4],
+            fname.encode()[:255])
+    def _clear_payload(self):
+        return struct.pack(PAYLOAD_FMT, 0, 0, 0, 0., 0., 0.,
+                           *([0.] * 16), b'')
+    def _write_slot(self, payload):
+        gen = self.generation + 1
+        offset = self._slot_offset(gen % 2)
+        self.mmap[offset+16:offset+16+PAYLOAD_SIZE] = payload
+        struct.pack_into(SLOT_FMT, self.mmap, offset, gen, zlib.crc32(payload))
+        self.mmap.flush()
+        self.generation = gen
+    def _read_checkpoint(self):
+        best = None
+        best_gen = 0
+        for slot in range(2):
+            offset = self._slot_offset(slot)
+            gen, crc = struct.unpack_from(SLOT_FMT, self.mmap, offset)
+            payload = bytes(self.mmap[offset+16:offset+16+PAYLOAD_SIZE])
+            if not gen or gen <= best_gen or crc != zlib.crc32(payload):
+                continue
+            best_gen = gen
+            best = payload
+        if best is None:
+            return None
+        fields = struct.unpack(PAYLOAD_FMT, best)
+        fname = fields[22].rstrip(b'\x00').decode()
+        if not fname:
+            return None
+        return {
+            'file_position': fields[0],
+            'absolute_coord': bool(fields[1]),
+            'absolute_extrude': bool(fields[2]),
+            'speed': fields[3], 'speed_factor': fields[4],
+            'extrude_factor': fields[5],
+            'last_position': list(fields[6:10]),
+            'base_position': list(fields[10:14]),
+            'homing_position': list(fields[14:18]),
+            'live_position': list(fields[18:22]),
+            'filename': fname,
+        }
+    cmd_CHECKPOINT_INFO_help = "Report the stored power-loss checkpoint"
+    def cmd_CHECKPOINT_INFO(self, gcmd):
+        ck = self._read_checkpoint()
+        if ck is None:
+            gcmd.respond_info("No checkpoint stored")
+            return
+        gcmd.respond_info(
+            "Checkpoint: file=%s offset=%d\n"
+            "gcode position: X=%.3f Y=%.3f Z=%.3f E=%.3f\n"
+            "last toolhead position: X=%.3f Y=%.3f Z=%.3f E=%.3f"
+            % (ck['filename'], ck['file_position'],
+               *ck['last_position'], *ck['live_position']))
+    cmd_CHECKPOINT_RESUME_help = (
+        "Resume a power interrupted print from the stored checkpoint"
+        " (printer must already be homed)")
+    def cmd_CHECKPOINT_RESUME(self, gcmd):
+        ck = self._read_checkpoint()
+        if ck is None:
+            raise gcmd.error("No checkpoint stored")
+        if self.virtual_sdcard.is_active():
+            raise gcmd.error("SD print in progress")
+        move = gcmd.get_int('MOVE', 1)
+        move_speed = gcmd.get_float('MOVE_SPEED', 0.)
+        # Select the file and seek to the checkpointed byte offset
+        self.gcode.run_script_from_command("M23 /%s" % (ck['filename'],))
+        self.gcode.run_script_from_command(
+            "M26 S%d" % (ck['file_position'],))
+        # Restore the g-code coordinate state (and optionally move the
+        # toolhead back to the checkpointed position)
+        self.gcode_move.saved_states[SAVED_STATE_NAME] = {
+            'absolute_coord': ck['absolute_coord'],
+            'absolute_extrude': ck['absolute_extrude'],
+            'base_position': list(ck['base_position']),
+            'last_position': list(ck['last_position']),
+            'homing_position': list(ck['homing_position']),
+            'speed': ck['speed'], 'speed_factor': ck['speed_factor'],
+            'extrude_factor': ck['extrude_factor'],
+        }
+        script = "RESTORE_GCODE_STATE NAME=%s MOVE=%d" % (
+            SAVED_STATE_NAME, move)
+        if move and move_speed:
+            script += " MOVE_SPEED=%.3f" % (move_speed,)
+        self.gcode.run_script_from_command(script)
+        gcmd.respond_info("Resuming %s at byte %d"
+                          % (ck['filename'], ck['file_position']))
+        self.gcode.run_script_from_command("M24")
+    cmd_CHECKPOINT_CLEAR_help = "Discard the stored power-loss checkpoint"
+    def cmd_CHECKPOINT_CLEAR(self, gcmd):
+        if self.mmap is None:
+            self._open_file()
+        self._write_slot(self._clear_payload())
+    def get_status(self, eventtime):
+        return {'generation': self.generation}
+
+def load_config(config):
+    return Checkpoint(config)
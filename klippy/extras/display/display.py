@@ -12,6 +12,8 @@ from . import aip31068_spi, hd44780, hd44780_spi, st7920, uc1701, menu
 REDRAW_TIME = 0.500
 # Minimum time between screen redraws
 REDRAW_MIN_TIME = 0.100
+# Time between screen redraws while the motion queue is busy
+REDRAW_BUSY_TIME = 1.000
 
 LCD_chips = {
     'st7920': st7920.ST7920, 'emulated_st7920': st7920.EmulatedST7920,
@@ -219,6 +221,15 @@ class PrinterLCD:
         # Start screen update timer
         self.reactor.update_timer(self.screen_update_timer, self.reactor.NOW)
     # Screen updating
+    def _redraw_interval(self, eventtime):
+        # Back off the refresh rate while the toolhead is busy
+        toolhead = self.printer.lookup_object('toolhead', None)
+        if toolhead is not None:
+            print_time, est_print_time, lookahead_empty = toolhead.check_busy(
+                eventtime)
+            if not lookahead_empty or est_print_time - print_time < 1.:
+                return REDRAW_BUSY_TIME
+        return REDRAW_TIME
     def screen_update_event(self, eventtime):
         if self.redraw_request_pending:
             self.redraw_request_pending = False
@@ -229,7 +240,7 @@ class PrinterLCD:
             ret = self.menu.screen_update_event(eventtime)
             if ret:
                 self.lcd_chip.flush()
-                return eventtime + REDRAW_TIME
+                return eventtime + self._redraw_interval(eventtime)
         # Update normal display
         try:
             self.show_data_group.show(self, self.display_templates, eventtime)
@@ -238,7 +249,7 @@ class PrinterLCD:
         self.lcd_chip.flush()
         if self.redraw_request_pending:
             return self.redraw_time
-        return eventtime + REDRAW_TIME
+        return eventtime + self._redraw_interval(eventtime)
     def request_redraw(self):
         if self.redraw_request_pending:
             return
@@ -0,0 +1,21 @@
+# Helper for locating changed regions of a display framebuffer
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import chelper
+
+# Merge changed regions separated by up to MAX_GAP unchanged bytes
+MAX_GAP = 5
+# Stop extending a merged region once it reaches MAX_BATCH bytes
+MAX_BATCH = 16
+
+# Return the changed (position, count) byte ranges of a framebuffer row
+def find_dirty(new_data, old_data):
+    ffi_main, ffi_lib = chelper.get_ffi()
+    runs = ffi_main.new('int[]', len(new_data) * 2)
+    count = ffi_lib.displayfb_find_dirty(
+        ffi_main.from_buffer('uint8_t[]', new_data),
+        ffi_main.from_buffer('uint8_t[]', old_data),
+        len(new_data), MAX_GAP, MAX_BATCH, runs)
+    return [(runs[i*2], runs[i*2 + 1]) for i in range(count)]
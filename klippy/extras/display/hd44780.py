@@ -7,6 +7,7 @@
 import logging
 
 BACKGROUND_PRIORITY_CLOCK = 0x7fffffff00000000
+LANE_BULK = 2
 LINE_LENGTH_DEFAULT=20
 LINE_LENGTH_OPTIONS=[16, 20]
 
@@ -55,7 +56,7 @@ class HD44780:
                 self.oid, self.pins[0], self.pins[1],
                 self.pins[2], self.pins[3], self.pins[4], self.pins[5],
                 self.mcu.seconds_to_clock(HD44780_DELAY)))
-        cmd_queue = self.mcu.alloc_command_queue()
+        cmd_queue = self.mcu.alloc_command_queue(LANE_BULK)
         self.send_cmds_cmd = self.mcu.lookup_command(
             "hd44780_send_cmds oid=%c cmds=%*s", cq=cmd_queue)
         self.send_data_cmd = self.mcu.lookup_command(
@@ -5,9 +5,10 @@
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging
 from .. import bus
-from . import font8x14
+from . import font8x14, framebuffer
 
 BACKGROUND_PRIORITY_CLOCK = 0x7fffffff00000000
+LANE_BULK = 2
 
 # Spec says 72us, but faster is possible in practice
 ST7920_CMD_DELAY  = .000020
@@ -37,17 +38,8 @@ class DisplayBase:
         for new_data, old_data, fb_id in self.all_framebuffers:
             if new_data == old_data:
                 continue
-            # Find the position of all changed bytes in this framebuffer
-            diffs = [[i, 1] for i, (n, o) in enumerate(zip(new_data, old_data))
-                     if n != o]
-            # Batch together changes that are close to each other
-            for i in range(len(diffs)-2, -1, -1):
-                pos, count = diffs[i]
-                nextpos, nextcount = diffs[i+1]
-                if pos + 5 >= nextpos and nextcount < 16:
-                    diffs[i][1] = nextcount + (nextpos - pos)
-                    del diffs[i+1]
-            # Transmit changes
+            # Find the dirty regions of this framebuffer and transmit them
+            diffs = framebuffer.find_dirty(new_data, old_data)
             for pos, count in diffs:
                 count += pos & 0x01
                 count += count & 0x01
@@ -166,7 +158,7 @@ class ST7920(DisplayBase):
                 self.oid, self.pins[0], self.pins[1], self.pins[2],
                 self.mcu.seconds_to_clock(ST7920_SYNC_DELAY),
                 self.mcu.seconds_to_clock(ST7920_CMD_DELAY)))
-        cmd_queue = self.mcu.alloc_command_queue()
+        cmd_queue = self.mcu.alloc_command_queue(LANE_BULK)
         self.send_cmds_cmd = self.mcu.lookup_command(
             "st7920_send_cmds oid=%c cmds=%*s", cq=cmd_queue)
         self.send_data_cmd = self.mcu.lookup_command(
@@ -7,12 +7,15 @@
 
 import logging
 import json
+import chelper
 
 class ExcludeObject:
     def __init__(self, config):
         self.printer = config.get_printer()
         self.gcode = self.printer.lookup_object('gcode')
         self.gcode_move = self.printer.load_object(config, 'gcode_move')
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.polyset = None
         self.printer.register_event_handler('klippy:connect',
                                         self._handle_connect)
         self.printer.register_event_handler("virtual_sdcard:reset_file",
@@ -77,6 +80,23 @@ class ExcludeObject:
         self.excluded_objects = []
         self.current_object = None
         self.in_excluded_region = False
+        self.polyset = None
+
+    def _build_polyset(self):
+        # Load the polygons of all excluded objects into a C polygonset
+        # so moves can be containment tested with a single ffi call
+        self.polyset = None
+        polygons = [obj['polygon'] for obj in self.objects
+                    if obj['name'] in self.excluded_objects
+                    and obj.get('polygon')]
+        if not polygons:
+            return
+        ps = self.ffi_main.gc(self.ffi_lib.polygonset_alloc(),
+                              self.ffi_lib.polygonset_free)
+        for polygon in polygons:
+            points = [float(coord) for point in polygon for coord in point]
+            self.ffi_lib.polygonset_add(ps, points, len(points) // 2)
+        self.polyset = ps
 
     def _reset_file(self):
         self._reset_state()
@@ -171,6 +191,13 @@ class ExcludeObject:
         return self.current_object in self.excluded_objects \
             and self.initial_extrusion_moves == 0
 
+    def _test_position_excluded(self, newpos):
+        # Containment test of the move target against excluded polygons
+        if self.polyset is None or self.initial_extrusion_moves > 0:
+            return False
+        return self.ffi_lib.polygonset_find(self.polyset,
+                                            newpos[0], newpos[1]) >= 0
+
     def get_status(self, eventtime=None):
         status = {
             "objects": self.objects,
@@ -181,6 +208,9 @@ class ExcludeObject:
 
     def move(self, newpos, speed):
         move_in_excluded_region = self._test_in_excluded_region()
+        if not move_in_excluded_region and self.current_object is None:
+            # Untagged move - test against excluded object polygons
+            move_in_excluded_region = self._test_position_excluded(newpos)
         self.last_speed = speed
 
         if move_in_excluded_region:
@@ -229,6 +259,7 @@ class ExcludeObject:
 
             else:
                 self.excluded_objects = []
+                self._build_polyset()
 
         elif name:
             if name.upper() not in self.excluded_objects:
@@ -275,12 +306,14 @@ class ExcludeObject:
     def _add_object_definition(self, definition):
         self.objects = sorted(self.objects + [definition],
                               key=lambda o: o["name"])
+        self._build_polyset()
 
     def _exclude_object(self, name):
         self._register_transform()
         self.gcode.respond_info('Excluding object {}'.format(name.upper()))
         if name not in self.excluded_objects:
             self.excluded_objects = sorted(self.excluded_objects + [name])
+            self._build_polyset()
 
     def _unexclude_object(self, name):
         self.gcode.respond_info('Unexcluding object {}'.format(name.upper()))
@@ -288,6 +321,7 @@ class ExcludeObject:
             excluded_objects = list(self.excluded_objects)
             excluded_objects.remove(name)
             self.excluded_objects = sorted(excluded_objects)
+            self._build_polyset()
 
     def _list_objects(self, gcmd):
         if gcmd.get('JSON', None) is not None:
@@ -90,9 +90,10 @@ class FanTachometer:
             self.ppr = config.getint('tachometer_ppr', 2, minval=1)
             poll_time = config.getfloat('tachometer_poll_interval',
                                         0.0015, above=0.)
+            hardware = config.getboolean('tachometer_hardware_counter', False)
             sample_time = 1.
             self._freq_counter = pulse_counter.FrequencyCounter(
-                printer, pin, sample_time, poll_time)
+                printer, pin, sample_time, poll_time, hardware)
 
     def get_status(self, eventtime):
         if self._freq_counter is not None:
@@ -4,7 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging
-from . import filament_switch_sensor
+from . import filament_switch_sensor, pulse_counter
 
 CHECK_RUNOUT_TIMEOUT = .250
 
@@ -16,9 +16,14 @@ class EncoderSensor:
         self.extruder_name = config.get('extruder')
         self.detection_length = config.getfloat(
                 'detection_length', 7., above=0.)
-        # Configure pins
-        buttons = self.printer.load_object(config, 'buttons')
-        buttons.register_buttons([switch_pin], self.encoder_event)
+        # Configure the mcu edge counter - the mcu counts encoder
+        # pulses continuously and reports totals per interval
+        poll_time = config.getfloat('poll_interval', 0.0015, above=0.)
+        hardware = config.getboolean('hardware_counter', False)
+        self._counter = pulse_counter.MCU_counter(
+                self.printer, switch_pin, CHECK_RUNOUT_TIMEOUT, poll_time,
+                hardware)
+        self._counter.setup_callback(self._counter_callback)
         # Get printer objects
         self.reactor = self.printer.get_reactor()
         self.runout_helper = filament_switch_sensor.RunoutHelper(config)
@@ -27,15 +32,11 @@ class EncoderSensor:
         self.estimated_print_time = None
         # Initialise internal state
         self.filament_runout_pos = None
-        # Register commands and event handlers
+        self.counter_state = (0, 0.)
+        self.last_count = 0
+        # Register event handlers
         self.printer.register_event_handler('klippy:ready',
                 self._handle_ready)
-        self.printer.register_event_handler('idle_timeout:printing',
-                self._handle_printing)
-        self.printer.register_event_handler('idle_timeout:ready',
-                self._handle_not_printing)
-        self.printer.register_event_handler('idle_timeout:idle',
-                self._handle_not_printing)
     def _update_filament_runout_pos(self, eventtime=None):
         if eventtime is None:
             eventtime = self.reactor.monotonic()
@@ -47,31 +48,34 @@ class EncoderSensor:
         self.estimated_print_time = (
                 self.printer.lookup_object('mcu').estimated_print_time)
         self._update_filament_runout_pos()
-        self._extruder_pos_update_timer = self.reactor.register_timer(
-                self._extruder_pos_update_event)
-    def _handle_printing(self, print_time):
-        self.reactor.update_timer(self._extruder_pos_update_timer,
-                self.reactor.NOW)
-    def _handle_not_printing(self, print_time):
-        self.reactor.update_timer(self._extruder_pos_update_timer,
-                self.reactor.NEVER)
     def _get_extruder_pos(self, eventtime=None):
         if eventtime is None:
             eventtime = self.reactor.monotonic()
         print_time = self.estimated_print_time(eventtime)
         return self.extruder.find_past_position(print_time)
-    def _extruder_pos_update_event(self, eventtime):
+    def _counter_callback(self, time, count, count_time):
+        # Called from a background thread - process in the reactor
+        self.counter_state = (count, count_time)
+        self.reactor.register_async_callback(self._process_counter_state)
+    def _process_counter_state(self, eventtime):
+        if self.extruder is None:
+            # Klipper initialization is not yet completed
+            return
+        count, count_time = self.counter_state
+        if count != self.last_count:
+            # Encoder pulses seen - compare the commanded extrusion at
+            # the time of the last pulse, not at the time of the report
+            self.last_count = count
+            self.filament_runout_pos = (
+                    self.extruder.find_past_position(count_time)
+                    + self.detection_length)
+            # Filament is always assumed to be present on encoder pulses
+            self.runout_helper.note_filament_present(eventtime, True)
+            return
+        # No pulses since the last report - check for filament runout
         extruder_pos = self._get_extruder_pos(eventtime)
-        # Check for filament runout
         self.runout_helper.note_filament_present(eventtime,
                 extruder_pos < self.filament_runout_pos)
-        return eventtime + CHECK_RUNOUT_TIMEOUT
-    def encoder_event(self, eventtime, state):
-        if self.extruder is not None:
-            self._update_filament_runout_pos(eventtime)
-            # Check for filament insertion
-            # Filament is always assumed to be present on an encoder event
-            self.runout_helper.note_filament_present(eventtime, True)
 
 def load_config_prefix(config):
     return EncoderSensor(config)
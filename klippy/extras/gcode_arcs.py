@@ -7,8 +7,9 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import math
+import chelper
 
-# Coordinates created by this are converted into G1 commands.
+# Coordinates created by this are submitted as G1 moves.
 #
 # supports XY, XZ & YZ planes with remaining axis as helical
 
@@ -42,6 +43,11 @@ class ArcSupport:
         # backwards compatibility, prior implementation only supported XY
         self.plane = ARC_PLANE_X_Y
 
+        # Segment coordinates are generated by a C helper
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.coords_alloc = 256
+        self.coords = self.ffi_main.new('double[]', 3 * self.coords_alloc)
+
     def cmd_G2(self, gcmd):
         self._cmd_inner(gcmd, True)
 
@@ -140,11 +146,15 @@ class ArcSupport:
         segments = max(1., math.floor(mm_of_travel / self.mm_per_arc_segment))
 
         # Generate coordinates
+        segments = int(segments)
         theta_per_segment = angular_travel / segments
         linear_per_segment = linear_travel / segments
 
         asE = gcmd.get_float("E", None)
         asF = gcmd.get_float("F", None)
+        if asF is not None and asF <= 0.:
+            raise gcmd.error("Invalid speed in '%s'"
+                             % (gcmd.get_commandline(),))
 
         e_per_move = e_base = 0.
         if asE is not None:
@@ -152,32 +162,41 @@ class ArcSupport:
                 e_base = currentPos[3]
             e_per_move = (asE - e_base) / segments
 
-        for i in range(1, int(segments) + 1):
-            dist_Helical = i * linear_per_segment
-            c_theta = i * theta_per_segment
-            cos_Ti = math.cos(c_theta)
-            sin_Ti = math.sin(c_theta)
-            r_P = -offset[0] * cos_Ti + offset[1] * sin_Ti
-            r_Q = -offset[0] * sin_Ti - offset[1] * cos_Ti
-
-            c = [None, None, None]
-            c[alpha_axis] = center_P + r_P
-            c[beta_axis] = center_Q + r_Q
-            c[helical_axis] = currentPos[helical_axis] + dist_Helical
-
-
-            if i == segments:
-                c = targetPos
-            # Convert coords into G1 commands
-            g1_params = {'X': c[0], 'Y': c[1], 'Z': c[2]}
+        if segments > self.coords_alloc:
+            self.coords_alloc = segments
+            self.coords = self.ffi_main.new('double[]', 3 * self.coords_alloc)
+        self.ffi_lib.arcs_expand(
+            self.coords, segments, offset[0], offset[1],
+            center_P, center_Q, currentPos[helical_axis],
+            theta_per_segment, linear_per_segment,
+            alpha_axis, beta_axis, helical_axis,
+            targetPos[alpha_axis], targetPos[beta_axis],
+            targetPos[helical_axis])
+
+        # Submit the segments directly, bypassing per-segment gcode
+        # parsing (equivalent to issuing absolute coordinate G1 moves)
+        gm = self.gcode_move
+        if asF is not None:
+            gm.speed = asF * gm.speed_factor
+        speed = gm.speed
+        coords = self.coords
+        last_position = gm.last_position
+        base_position = gm.base_position
+        extrude_factor = gm.extrude_factor
+        move_with_transform = gm.move_with_transform
+        for i in range(segments):
+            cpos = 3 * i
+            last_position[0] = coords[cpos] + base_position[0]
+            last_position[1] = coords[cpos+1] + base_position[1]
+            last_position[2] = coords[cpos+2] + base_position[2]
             if e_per_move:
-                g1_params['E'] = e_base + e_per_move
                 if absolut_extrude:
                     e_base += e_per_move
-            if asF is not None:
-                g1_params['F'] = asF
-            g1_gcmd = self.gcode.create_gcode_command("G1", "G1", g1_params)
-            self.gcode_move.cmd_G1(g1_gcmd)
+                    last_position[3] = (e_base * extrude_factor
+                                        + base_position[3])
+                else:
+                    last_position[3] += e_per_move * extrude_factor
+            move_with_transform(last_position, speed)
 
 def load_config(config):
     return ArcSupport(config)
@@ -4,7 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import traceback, logging, ast, copy, json
-import jinja2
+import jinja2, jinja2.nodes
 
 
 ######################################################################
@@ -46,12 +46,16 @@ class GetStatusWrapper:
 class TemplateWrapper:
     def __init__(self, printer, env, name, script):
         self.printer = printer
+        self.env = env
         self.name = name
+        self.reactor = printer.get_reactor()
         self.gcode = self.printer.lookup_object('gcode')
         gcode_macro = self.printer.lookup_object('gcode_macro')
         self.create_template_context = gcode_macro.create_template_context
+        self.render_count = 0
+        self.render_time = self.max_render_time = 0.
         try:
-            self.template = env.from_string(script)
+            self.template = gcode_macro.compile_template(name, script)
         except jinja2.exceptions.TemplateSyntaxError as e:
             lines = script.splitlines()
             msg = "Error loading template '%s'\nline %s: %s # %s" % (
@@ -63,16 +67,75 @@ class TemplateWrapper:
                  name, traceback.format_exception_only(type(e), e)[-1])
             logging.exception(msg)
             raise printer.config_error(msg)
+        self.fast_parts = self._build_fast_parts(script)
+        gcode_macro.register_template(self)
+    def _build_fast_parts(self, script):
+        # Templates without control flow reduce to literal text and
+        # simple attribute lookups; render those without the jinja vm
+        nodes = jinja2.nodes
+        try:
+            body = self.env.parse(script).body
+        except Exception:
+            return None
+        parts = []
+        for output in body:
+            if not isinstance(output, nodes.Output):
+                return None
+            for node in output.nodes:
+                if isinstance(node, nodes.TemplateData):
+                    parts.append(node.data)
+                    continue
+                attrs = []
+                while isinstance(node, nodes.Getattr):
+                    attrs.append(node.attr)
+                    node = node.node
+                if not isinstance(node, nodes.Name) or node.ctx != 'load':
+                    return None
+                attrs.append(node.name)
+                attrs.reverse()
+                parts.append(tuple(attrs))
+        return parts
+    def _render_fast(self, context):
+        env = self.env
+        out = []
+        for part in self.fast_parts:
+            if type(part) is str:
+                out.append(part)
+                continue
+            name = part[0]
+            if name in context:
+                val = context[name]
+            elif name in env.globals:
+                val = env.globals[name]
+            else:
+                val = env.undefined(name=name)
+            for attr in part[1:]:
+                val = env.getattr(val, attr)
+            out.append(str(val))
+        return "".join(out)
     def render(self, context=None):
         if context is None:
             context = self.create_template_context()
+        start_time = self.reactor.monotonic()
         try:
+            if self.fast_parts is not None:
+                return self._render_fast(context)
             return str(self.template.render(context))
         except Exception as e:
             msg = "Error evaluating '%s': %s" % (
                 self.name, traceback.format_exception_only(type(e), e)[-1])
             logging.exception(msg)
             raise self.gcode.error(msg)
+        finally:
+            rtime = self.reactor.monotonic() - start_time
+            self.render_count += 1
+            self.render_time += rtime
+            if rtime > self.max_render_time:
+                self.max_render_time = rtime
+    def get_render_stats(self):
+        return {'renders': self.render_count,
+                'render_time': round(self.render_time, 6),
+                'max_render_time': round(self.max_render_time, 6)}
     def run_gcode_from_command(self, context=None):
         self.gcode.run_script_from_command(self.render(context))
 
@@ -81,6 +144,36 @@ class PrinterGCodeMacro:
     def __init__(self, config):
         self.printer = config.get_printer()
         self.env = jinja2.Environment('{%', '%}', '{', '}')
+        self.templates = []
+        # Persistent cache of compiled template bytecode (stored in the
+        # system temporary directory; failures leave caching disabled)
+        try:
+            self.bytecode_cache = jinja2.FileSystemBytecodeCache(
+                pattern='klippy_jinja2_%s.cache')
+        except Exception:
+            logging.exception("Unable to setup jinja2 bytecode cache")
+            self.bytecode_cache = None
+    def compile_template(self, name, script):
+        if self.bytecode_cache is not None:
+            try:
+                bucket = self.bytecode_cache.get_bucket(self.env, name,
+                                                        None, script)
+                if bucket.code is None:
+                    bucket.code = self.env.compile(script)
+                    self.bytecode_cache.set_bucket(bucket)
+                return jinja2.Template.from_code(self.env, bucket.code,
+                                                 self.env.make_globals(None))
+            except jinja2.exceptions.TemplateSyntaxError:
+                raise
+            except Exception:
+                logging.exception("jinja2 bytecode cache error on '%s'"
+                                  % (name,))
+        return self.env.from_string(script)
+    def register_template(self, template):
+        self.templates.append(template)
+    def get_status(self, eventtime):
+        return {'render_stats': {t.name: t.get_render_stats()
+                                 for t in self.templates if t.render_count}}
     def load_template(self, config, option, default=None):
         name = "%s:%s" % (config.get_name(), option)
         if default is None:
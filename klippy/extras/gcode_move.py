@@ -4,6 +4,57 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging
+import chelper
+
+# Affine move transforms (transforms implementing get_affine()) are
+# folded into a single matrix at registration time and applied with one
+# C helper call per move, instead of each transform adding a Python
+# move() frame to the transform chain.
+class ComposedAffineTransform:
+    def __init__(self, gcode_move):
+        self.gcode_move = gcode_move
+        self.transforms = []
+        self.next_transform = None
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.c_chain = self.ffi_main.gc(self.ffi_lib.transform_chain_alloc(),
+                                        self.ffi_lib.free)
+        self.pos_buf = self.ffi_main.new('double[3]')
+    def add_transform(self, transform):
+        if not self.transforms:
+            self.next_transform = self.gcode_move.set_move_transform(
+                self, force=True)
+        self.transforms.append(transform)
+        self.compile_chain()
+    def compile_chain(self):
+        # Fold the transforms into one affine (later registrations, which
+        # would have wrapped the chain last, apply first)
+        m = [1., 0., 0., 0., 1., 0., 0., 0., 1.]
+        offset = [0., 0., 0.]
+        for transform in reversed(self.transforms):
+            affine = transform.get_affine()
+            if affine is None:
+                continue
+            tm, toffset = affine
+            m = [tm[3*i+0]*m[0+j] + tm[3*i+1]*m[3+j] + tm[3*i+2]*m[6+j]
+                 for i in range(3) for j in range(3)]
+            offset = [tm[3*i+0]*offset[0] + tm[3*i+1]*offset[1]
+                      + tm[3*i+2]*offset[2] + toffset[i] for i in range(3)]
+        res = self.ffi_lib.transform_chain_set(self.c_chain, m, offset)
+        if res < 0:
+            raise self.gcode_move.printer.command_error(
+                "Unable to invert composed g-code transform")
+    def move(self, newpos, speed):
+        pos_buf = self.pos_buf
+        pos_buf[0], pos_buf[1], pos_buf[2] = newpos[:3]
+        self.ffi_lib.transform_chain_apply(self.c_chain, pos_buf)
+        self.next_transform.move(
+            [pos_buf[0], pos_buf[1], pos_buf[2]] + newpos[3:], speed)
+    def get_position(self):
+        pos = self.next_transform.get_position()
+        pos_buf = self.pos_buf
+        pos_buf[0], pos_buf[1], pos_buf[2] = pos[:3]
+        self.ffi_lib.transform_chain_unapply(self.c_chain, pos_buf)
+        return [pos_buf[0], pos_buf[1], pos_buf[2]] + pos[3:]
 
 class GCodeMove:
     def __init__(self, config):
@@ -37,6 +88,7 @@ class GCodeMove:
         # G-Code state
         self.saved_states = {}
         self.move_transform = self.move_with_transform = None
+        self.composed_transform = None
         self.position_with_transform = (lambda: [0., 0., 0., 0.])
         # Register callbacks
         printer.register_event_handler("klippy:ready", self._handle_ready)
@@ -57,6 +109,11 @@ class GCodeMove:
                                        self._handle_home_rails_end)
     def _handle_ready(self):
         self.is_printer_ready = True
+        ct = self.composed_transform
+        if ct is not None and ct.next_transform is None:
+            # Composed transform was registered at config time (before
+            # the toolhead was available)
+            ct.next_transform = self.printer.lookup_object('toolhead')
         if self.move_transform is None:
             toolhead = self.printer.lookup_object('toolhead')
             self.move_with_transform = toolhead.move
@@ -91,6 +148,17 @@ class GCodeMove:
         self.move_with_transform = transform.move
         self.position_with_transform = transform.get_position
         return old_transform
+    def set_affine_transform(self, transform):
+        # Fold an affine transform into the composed chain (the
+        # transform must implement get_affine() returning a row major
+        # 3x3 matrix and (x, y, z) offset, or None when disabled)
+        if self.composed_transform is None:
+            self.composed_transform = ComposedAffineTransform(self)
+        self.composed_transform.add_transform(transform)
+    def update_affine_transform(self):
+        # An affine transform's coefficients changed - refold the chain
+        self.composed_transform.compile_chain()
+        self.reset_last_position()
     def _get_gcode_position(self):
         p = [lp - bp for lp, bp in zip(self.last_position, self.base_position)]
         p[3] /= self.extrude_factor
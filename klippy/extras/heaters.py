@@ -49,17 +49,22 @@ class Heater:
         self.next_pwm_time = 0.
         self.last_pwm_value = 0.
         # Setup control algorithm sub-class
-        algos = {'watermark': ControlBangBang, 'pid': ControlPID}
+        algos = {'watermark': ControlBangBang, 'pid': ControlPID,
+                 'mcu_pid': ControlMcuPID}
         algo = config.getchoice('control', algos)
         self.control = algo(self, config)
         # Setup output heater pin
         heater_pin = config.get('heater_pin')
         ppins = self.printer.lookup_object('pins')
-        self.mcu_pwm = ppins.setup_pin('pwm', heater_pin)
         pwm_cycle_time = config.getfloat('pwm_cycle_time', 0.100, above=0.,
                                          maxval=self.pwm_delay)
-        self.mcu_pwm.setup_cycle_time(pwm_cycle_time)
-        self.mcu_pwm.setup_max_duration(MAX_HEAT_TIME)
+        if hasattr(self.control, 'setup_heater_pin'):
+            self.mcu_pwm = self.control.setup_heater_pin(
+                ppins, heater_pin, pwm_cycle_time)
+        else:
+            self.mcu_pwm = ppins.setup_pin('pwm', heater_pin)
+            self.mcu_pwm.setup_cycle_time(pwm_cycle_time)
+            self.mcu_pwm.setup_max_duration(MAX_HEAT_TIME)
         # Load additional modules
         self.printer.load_object(config, "verify_heater %s" % (short_name,))
         self.printer.load_object(config, "pid_calibrate")
@@ -102,6 +107,11 @@ class Heater:
         return self.name
     def get_pwm_delay(self):
         return self.pwm_delay
+    def get_sensor(self):
+        return self.sensor
+    def note_pwm_value(self, value):
+        # Note output duty applied autonomously by the mcu
+        self.last_pwm_value = value
     def get_max_power(self):
         return self.max_power
     def get_smooth_time(self):
@@ -235,6 +245,137 @@ class ControlPID:
                 or abs(self.prev_temp_deriv) > PID_SETTLE_SLOPE)
 
 
+######################################################################
+# Micro-controller offloaded PID control algo
+######################################################################
+
+# Time between host keepalive refreshes of the mcu control loop
+PID_REFRESH_TIME = MAX_HEAT_TIME / 2.
+FIXED_POINT_MAX = (1 << 31) - 1
+
+# Helper to configure and communicate with a mcu "heater_pid" object
+class MCU_heater_pid:
+    def __init__(self, heater, mcu, pin, mcu_adc, cycle_time):
+        self.heater = heater
+        self.mcu = mcu
+        self.pin = pin
+        self.mcu_adc = mcu_adc
+        self.cycle_time = cycle_time
+        self.oid = mcu.create_oid()
+        self.pwm_max = 0.
+        self.set_gains_cmd = self.set_target_cmd = self.manual_cmd = None
+        mcu.register_config_callback(self._build_config)
+    def get_mcu(self):
+        return self.mcu
+    def get_pwm_max(self):
+        return self.pwm_max
+    def _build_config(self):
+        cycle_ticks = self.mcu.seconds_to_clock(self.cycle_time)
+        if cycle_ticks >= 1<<31:
+            raise self.mcu.get_printer().config_error(
+                "PWM pin cycle time too large")
+        self.mcu.add_config_cmd(
+            "config_heater_pid oid=%d pin=%s cycle_ticks=%d"
+            % (self.oid, self.pin, cycle_ticks))
+        self.mcu.add_config_cmd(
+            "analog_in_attach_heater_pid oid=%d heater_pid_oid=%d"
+            % (self.mcu_adc.get_oid(), self.oid))
+        self.pwm_max = self.mcu.get_constant_float("PWM_MAX")
+        cmd_queue = self.mcu.alloc_command_queue()
+        self.set_gains_cmd = self.mcu.lookup_command(
+            "heater_pid_set_gains oid=%c kp=%i ki=%i kd=%i"
+            " integ_min=%i integ_max=%i max_value=%hu", cq=cmd_queue)
+        self.set_target_cmd = self.mcu.lookup_command(
+            "heater_pid_set_target oid=%c clock=%u target=%i", cq=cmd_queue)
+        self.manual_cmd = self.mcu.lookup_command(
+            "heater_pid_manual oid=%c clock=%u value=%hu", cq=cmd_queue)
+        self.mcu.register_serial_response(self._handle_pid_pwm,
+                                          "heater_pid_pwm", self.oid)
+    def _handle_pid_pwm(self, params):
+        if self.pwm_max:
+            self.heater.note_pwm_value(params['pwm'] / self.pwm_max)
+    def set_gains(self, kp, ki, kd, integ_min, integ_max, max_value):
+        self.set_gains_cmd.send([self.oid, kp, ki, kd,
+                                 integ_min, integ_max, max_value])
+    def set_target(self, read_time, target_counts):
+        clock = self.mcu.print_time_to_clock(read_time + MAX_HEAT_TIME)
+        self.set_target_cmd.send([self.oid, clock, target_counts])
+    def set_pwm(self, print_time, value):
+        # Manual duty control (disables the mcu control loop)
+        clock = self.mcu.print_time_to_clock(print_time + MAX_HEAT_TIME)
+        v = int(max(0., min(1., value)) * self.pwm_max + .5)
+        self.manual_cmd.send([self.oid, clock, v])
+        self.heater.note_pwm_value(v / self.pwm_max)
+
+class ControlMcuPID:
+    def __init__(self, heater, config):
+        self.heater = heater
+        self.printer = config.get_printer()
+        self.heater_max_power = heater.get_max_power()
+        self.Kp = config.getfloat('pid_Kp') / PID_PARAM_BASE
+        self.Ki = config.getfloat('pid_Ki') / PID_PARAM_BASE
+        self.Kd = config.getfloat('pid_Kd') / PID_PARAM_BASE
+        sensor = heater.get_sensor()
+        if (not hasattr(sensor, 'get_mcu_adc')
+            or not hasattr(sensor, 'calc_adc')):
+            raise config.error(
+                "control: mcu_pid requires an analog (adc) sensor")
+        self.sensor = sensor
+        self.mcu_adc = sensor.get_mcu_adc()
+        self.mcu_pid = None
+        self.last_target = 0.
+        self.next_refresh_time = 0.
+    def setup_heater_pin(self, ppins, pin_name, cycle_time):
+        pin_params = ppins.lookup_pin(pin_name)
+        mcu = pin_params['chip']
+        if mcu is not self.mcu_adc.get_mcu():
+            raise self.printer.config_error(
+                "mcu_pid heater pin and sensor must be on the same mcu")
+        self.mcu_pid = MCU_heater_pid(self.heater, mcu, pin_params['pin'],
+                                      self.mcu_adc, cycle_time)
+        return self.mcu_pid
+    def _fixed_point(self, val):
+        return max(-FIXED_POINT_MAX, min(FIXED_POINT_MAX, int(val * 65536.)))
+    def _send_gains(self, target_temp):
+        # Linearize the sensor response around the target temperature
+        # and convert gains to pwm duty per raw adc count
+        max_adc = self.mcu_adc.get_max_adc()
+        dcounts = (self.sensor.calc_adc(target_temp + .5)
+                   - self.sensor.calc_adc(target_temp - .5)) * max_adc
+        if not dcounts:
+            raise self.printer.command_error(
+                "Unable to linearize sensor at %.1f for mcu_pid"
+                % (target_temp,))
+        pwm_max = self.mcu_pid.get_pwm_max()
+        update_time = self.heater.get_pwm_delay()
+        scale = pwm_max / dcounts
+        kp = self._fixed_point(self.Kp * scale)
+        ki = self._fixed_point(self.Ki * scale * update_time)
+        kd = self._fixed_point(self.Kd * scale / update_time)
+        max_value = int(self.heater_max_power * pwm_max + .5)
+        integ_min = integ_max = 0
+        if ki:
+            ilim = int(max_value * 65536. // ki)
+            integ_min, integ_max = min(0, ilim), max(0, ilim)
+        self.mcu_pid.set_gains(kp, ki, kd, integ_min, integ_max, max_value)
+    def temperature_update(self, read_time, temp, target_temp):
+        if target_temp != self.last_target:
+            if target_temp <= 0.:
+                self.mcu_pid.set_pwm(read_time, 0.)
+            else:
+                self._send_gains(target_temp)
+                self._send_target(read_time, target_temp)
+            self.last_target = target_temp
+        elif target_temp > 0. and read_time >= self.next_refresh_time:
+            self._send_target(read_time, target_temp)
+    def _send_target(self, read_time, target_temp):
+        counts = self.sensor.calc_adc(target_temp) * self.mcu_adc.get_max_adc()
+        self.mcu_pid.set_target(read_time, int(counts + .5))
+        self.next_refresh_time = read_time + PID_REFRESH_TIME
+    def check_busy(self, eventtime, smoothed_temp, target_temp):
+        return abs(target_temp - smoothed_temp) > PID_SETTLE_DELTA
+
+
 ######################################################################
 # Sensor and heater lookup
 ######################################################################
@@ -185,47 +185,128 @@ class Homing:
         return thcoord
     def set_homed_position(self, pos):
         self.toolhead.set_position(self._fill_coord(pos))
+    def _merge_coords(self, coords):
+        # Combine coordinates from independent homing requests
+        merged = list(coords[0])
+        for coord in coords[1:]:
+            for i, val in enumerate(coord):
+                if val is not None:
+                    merged[i] = val
+        return merged
+    def _calc_group_speed(self, requests, startpos, endpos, speeds):
+        # Scale a combined move so no axis exceeds its configured speed
+        if len(requests) == 1:
+            return speeds[0]
+        axes_d = [ep - sp for ep, sp in zip(endpos, startpos)]
+        move_d = math.sqrt(sum([d*d for d in axes_d[:3]]))
+        move_t = 0.
+        for (rails, forcepos, movepos), speed in zip(requests, speeds):
+            d = math.sqrt(sum([axes_d[i]*axes_d[i] for i in range(3)
+                               if forcepos[i] is not None]))
+            move_t = max(move_t, d / speed)
+        if move_d <= 0. or move_t <= 0.:
+            return min(speeds)
+        return move_d / move_t
     def home_rails(self, rails, forcepos, movepos):
+        self._home_rails_group([(rails, forcepos, movepos)])
+    def _request_info(self, request):
+        rails, forcepos, movepos = request
+        axes = set([i for i in range(3) if forcepos[i] is not None])
+        steppers = set([s.get_name() for rail in rails
+                        for s in rail.get_steppers()])
+        for rail in rails:
+            for es, name in rail.get_endstops():
+                steppers.update([s.get_name() for s in es.get_steppers()])
+        return axes, steppers
+    def home_rails_multi(self, requests):
+        # Home rails concurrently where mechanically independent; each
+        # endstop retains its own trigger group, so rails may be on
+        # different micro-controllers and halt at different times.
+        pending = list(requests)
+        while pending:
+            group = [pending.pop(0)]
+            axes, steppers = self._request_info(group[0])
+            while pending:
+                naxes, nsteppers = self._request_info(pending[0])
+                if axes & naxes or steppers & nsteppers:
+                    break
+                axes |= naxes
+                steppers |= nsteppers
+                group.append(pending.pop(0))
+            self._home_rails_group(group)
+    def _home_rails_group(self, requests):
         # Notify of upcoming homing operation
-        self.printer.send_event("homing:home_rails_begin", self, rails)
+        for rails, forcepos, movepos in requests:
+            self.printer.send_event("homing:home_rails_begin", self, rails)
         # Alter kinematics class to think printer is at forcepos
-        force_axes = [axis for axis in range(3) if forcepos[axis] is not None]
+        all_forcepos = [fp for rails, fp, mp in requests]
+        force_axes = [axis for axis in range(3)
+                      if any([fp[axis] is not None for fp in all_forcepos])]
         homing_axes = "".join(["xyz"[i] for i in force_axes])
-        startpos = self._fill_coord(forcepos)
-        homepos = self._fill_coord(movepos)
+        startpos = self._fill_coord(self._merge_coords(all_forcepos))
+        homepos = self._fill_coord(self._merge_coords(
+            [mp for rails, fp, mp in requests]))
         self.toolhead.set_position(startpos, homing_axes=homing_axes)
         # Perform first home
-        endstops = [es for rail in rails for es in rail.get_endstops()]
-        hi = rails[0].get_homing_info()
+        endstops = [es for rails, fp, mp in requests
+                    for rail in rails for es in rail.get_endstops()]
+        homing_infos = [rails[0].get_homing_info()
+                        for rails, fp, mp in requests]
+        speed = self._calc_group_speed(requests, startpos, homepos,
+                                       [hi.speed for hi in homing_infos])
         hmove = HomingMove(self.printer, endstops)
-        hmove.homing_move(homepos, hi.speed)
+        hmove.homing_move(homepos, speed)
+        trigger_mcu_pos = {sp.stepper_name: sp.trig_pos
+                           for sp in hmove.stepper_positions}
         # Perform second home
-        if hi.retract_dist:
+        r_requests = [req for req, hi in zip(requests, homing_infos)
+                      if hi.retract_dist]
+        if r_requests:
             # Retract
-            startpos = self._fill_coord(forcepos)
-            homepos = self._fill_coord(movepos)
+            startpos = self._fill_coord(self._merge_coords(
+                [fp for rails, fp, mp in r_requests]))
+            homepos = self._fill_coord(self._merge_coords(
+                [mp for rails, fp, mp in r_requests]))
             axes_d = [hp - sp for hp, sp in zip(homepos, startpos)]
-            move_d = math.sqrt(sum([d*d for d in axes_d[:3]]))
-            retract_r = min(1., hi.retract_dist / move_d)
-            retractpos = [hp - ad * retract_r
-                          for hp, ad in zip(homepos, axes_d)]
-            self.toolhead.move(retractpos, hi.retract_speed)
+            retractpos = list(homepos)
+            secondpos = list(homepos)
+            for rails, forcepos, movepos in r_requests:
+                hi = rails[0].get_homing_info()
+                raxes = [i for i in range(len(forcepos))
+                         if forcepos[i] is not None]
+                move_d = math.sqrt(sum([axes_d[i]*axes_d[i]
+                                        for i in raxes if i < 3]))
+                retract_r = min(1., hi.retract_dist / move_d)
+                for i in raxes:
+                    retractpos[i] -= axes_d[i] * retract_r
+                    secondpos[i] -= 2. * axes_d[i] * retract_r
+            retract_speed = self._calc_group_speed(
+                r_requests, homepos, retractpos,
+                [rails[0].get_homing_info().retract_speed
+                 for rails, fp, mp in r_requests])
+            self.toolhead.move(retractpos, retract_speed)
             # Home again
-            startpos = [rp - ad * retract_r
-                        for rp, ad in zip(retractpos, axes_d)]
-            self.toolhead.set_position(startpos)
+            self.toolhead.set_position(secondpos)
+            endstops = [es for rails, fp, mp in r_requests
+                        for rail in rails for es in rail.get_endstops()]
+            second_speed = self._calc_group_speed(
+                r_requests, secondpos, homepos,
+                [rails[0].get_homing_info().second_homing_speed
+                 for rails, fp, mp in r_requests])
             hmove = HomingMove(self.printer, endstops)
-            hmove.homing_move(homepos, hi.second_homing_speed)
+            hmove.homing_move(homepos, second_speed)
             if hmove.check_no_movement() is not None:
                 raise self.printer.command_error(
                     "Endstop %s still triggered after retract"
                     % (hmove.check_no_movement(),))
+            trigger_mcu_pos.update({sp.stepper_name: sp.trig_pos
+                                    for sp in hmove.stepper_positions})
         # Signal home operation complete
         self.toolhead.flush_step_generation()
-        self.trigger_mcu_pos = {sp.stepper_name: sp.trig_pos
-                                for sp in hmove.stepper_positions}
+        self.trigger_mcu_pos = trigger_mcu_pos
         self.adjust_pos = {}
-        self.printer.send_event("homing:home_rails_end", self, rails)
+        for rails, forcepos, movepos in requests:
+            self.printer.send_event("homing:home_rails_end", self, rails)
         if any(self.adjust_pos.values()):
             # Apply any homing offsets
             kin = self.toolhead.get_kinematics()
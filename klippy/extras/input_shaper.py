@@ -76,6 +76,17 @@ class AxisInputShaper:
         return success
     def is_enabled(self):
         return self.n > 0
+    def schedule_shaper_kinematics(self, sk, swap_time):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        success = ffi_lib.input_shaper_schedule_shaper_params(
+                sk, self.axis.encode(), self.n, self.A, self.T,
+                swap_time, 0.) == 0
+        if not success:
+            self.disable_shaping()
+            ffi_lib.input_shaper_schedule_shaper_params(
+                    sk, self.axis.encode(), self.n, self.A, self.T,
+                    swap_time, 0.)
+        return success
     def disable_shaping(self):
         if self.saved is None and self.n:
             self.saved = (self.n, self.A, self.T)
@@ -178,6 +189,35 @@ class InputShaper:
             error = error or self.printer.command_error
             raise error("Failed to configure shaper(s) %s with given parameters"
                         % (', '.join([s.get_name() for s in failed_shapers])))
+    def _schedule_input_shaping(self):
+        # Swap the shaper parameters at the end of the look-ahead queue
+        # without draining the step generation pipeline - the C code
+        # crossfades the commanded position from the old to the new
+        # shaper, so printing does not stall
+        kin = self.toolhead.get_kinematics()
+        steppers = [s for s in kin.get_steppers()
+                    if s.get_trapq() is not None]
+        if any(s.get_stepper_kinematics()
+               not in self.input_shaper_stepper_kinematics
+               for s in steppers):
+            # Some steppers are not wrapped yet - do a full update
+            self._update_input_shaping()
+            return
+        swap_time = self.toolhead.get_last_move_time()
+        failed_shapers = []
+        for s in steppers:
+            is_sk = s.get_stepper_kinematics()
+            for shaper in self.shapers:
+                if shaper in failed_shapers:
+                    continue
+                if not shaper.schedule_shaper_kinematics(is_sk, swap_time):
+                    failed_shapers.append(shaper)
+        motion_queuing = self.printer.lookup_object("motion_queuing")
+        motion_queuing.check_step_generation_scan_windows()
+        if failed_shapers:
+            raise self.printer.command_error(
+                    "Failed to configure shaper(s) %s with given parameters"
+                    % (', '.join([s.get_name() for s in failed_shapers])))
     def disable_shaping(self):
         for shaper in self.shapers:
             shaper.disable_shaping()
@@ -191,7 +231,7 @@ class InputShaper:
         if gcmd.get_command_parameters():
             for shaper in self.shapers:
                 shaper.update(gcmd)
-            self._update_input_shaping()
+            self._schedule_input_shaping()
         for ind, shaper in enumerate(self.shapers):
             if ind < 2 or shaper.is_enabled():
                 shaper.report(gcmd)
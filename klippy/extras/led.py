@@ -4,8 +4,18 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging
+import chelper
 from . import output_pin
 
+# Time between animated effect frames
+EFFECT_FRAME_TIME = 1. / 30.
+
+# Effects rendered by the C helper
+EFFECTS = {
+    'gradient': 'LED_EFFECT_GRADIENT', 'chase': 'LED_EFFECT_CHASE',
+    'breathe': 'LED_EFFECT_BREATHE', 'progress': 'LED_EFFECT_PROGRESS',
+}
+
 # Helper code for common LED initialization and control
 class LEDHelper:
     def __init__(self, config, update_func, led_count=1):
@@ -20,6 +30,13 @@ class LEDHelper:
         blue = config.getfloat('initial_BLUE', 0., minval=0., maxval=1.)
         white = config.getfloat('initial_WHITE', 0., minval=0., maxval=1.)
         self.led_state = [(red, green, blue, white)] * led_count
+        # Support animated effects rendered in the C helper
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.frame = self.ffi_main.gc(self.ffi_lib.led_frame_alloc(led_count),
+                                      self.ffi_lib.free)
+        self.frame_out = self.ffi_main.new('double[]', 4 * led_count)
+        self.effect_timer = None
+        self.effect_is_progress = False
         # Support setting an led template
         self.template_eval = output_pin.lookup_template_eval(config)
         self.tcallbacks = [(lambda text, s=self, index=i+1:
@@ -33,6 +50,9 @@ class LEDHelper:
         gcode.register_mux_command("SET_LED_TEMPLATE", "LED", name,
                                    self.cmd_SET_LED_TEMPLATE,
                                    desc=self.cmd_SET_LED_TEMPLATE_help)
+        gcode.register_mux_command("SET_LED_EFFECT", "LED", name,
+                                   self.cmd_SET_LED_EFFECT,
+                                   desc=self.cmd_SET_LED_EFFECT_help)
     def get_status(self, eventtime=None):
         return {'color_data': self.led_state}
     def _set_color(self, index, color):
@@ -70,8 +90,30 @@ class LEDHelper:
             except self.printer.command_error as e:
                 logging.exception("led update transmit error")
         self.printer.get_reactor().register_callback(reactor_cb)
+    # Animated effect rendering
+    def _stop_effect(self):
+        if self.effect_timer is None:
+            return
+        self.printer.get_reactor().unregister_timer(self.effect_timer)
+        self.effect_timer = None
+    def _render_effect(self, eventtime):
+        progress = 0.
+        if self.effect_is_progress:
+            dstatus = self.printer.lookup_object('display_status', None)
+            if dstatus is not None:
+                progress = dstatus.get_status(eventtime)['progress']
+        dirty = self.ffi_lib.led_frame_render(self.frame, eventtime, progress,
+                                              self.frame_out)
+        if dirty:
+            flat = self.ffi_main.unpack(self.frame_out, 4 * self.led_count)
+            self.led_state = [tuple(flat[i:i+4])
+                              for i in range(0, 4 * self.led_count, 4)]
+            self.need_transmit = True
+            self._check_transmit()
+        return eventtime + EFFECT_FRAME_TIME
     cmd_SET_LED_help = "Set the color of an LED"
     def cmd_SET_LED(self, gcmd):
+        self._stop_effect()
         # Parse parameters
         red = gcmd.get_float('RED', 0., minval=0., maxval=1.)
         green = gcmd.get_float('GREEN', 0., minval=0., maxval=1.)
@@ -95,6 +137,7 @@ class LEDHelper:
             lookahead_bgfunc(None)
     cmd_SET_LED_TEMPLATE_help = "Assign a display_template to an LED"
     def cmd_SET_LED_TEMPLATE(self, gcmd):
+        self._stop_effect()
         index = gcmd.get_int("INDEX", None, minval=1, maxval=self.led_count)
         set_template = self.template_eval.set_template
         if index is not None:
@@ -102,6 +145,28 @@ class LEDHelper:
         else:
             for i in range(self.led_count):
                 set_template(gcmd, self.tcallbacks[i], self._check_transmit)
+    cmd_SET_LED_EFFECT_help = "Animate an LED strip with a builtin effect"
+    def cmd_SET_LED_EFFECT(self, gcmd):
+        effect = gcmd.get('EFFECT')
+        if not effect or effect == 'off':
+            self._stop_effect()
+            return
+        if effect not in EFFECTS:
+            raise gcmd.error("Unknown led effect '%s'" % (effect,))
+        rate = gcmd.get_float('RATE', 1., above=0.)
+        scale = gcmd.get_float('SCALE', 1., above=0.)
+        color1 = [gcmd.get_float(c, 0., minval=0., maxval=1.)
+                  for c in ('RED', 'GREEN', 'BLUE', 'WHITE')]
+        color2 = [gcmd.get_float(c + '2', 0., minval=0., maxval=1.)
+                  for c in ('RED', 'GREEN', 'BLUE', 'WHITE')]
+        self.ffi_lib.led_frame_setup_effect(
+            self.frame, getattr(self.ffi_lib, EFFECTS[effect]),
+            rate, scale, color1, color2)
+        self.effect_is_progress = effect == 'progress'
+        if self.effect_timer is None:
+            reactor = self.printer.get_reactor()
+            self.effect_timer = reactor.register_timer(self._render_effect,
+                                                       reactor.NOW)
 
 # Handler for PWM controlled LEDs
 class PrinterPWMLED:
@@ -239,6 +239,8 @@ class LoadCellProbeConfigHelper:
         # triggering options
         self._trigger_force_param = intParamHelper(config, 'trigger_force',
             default=75, minval=10, maxval=250)
+        self._trigger_arm_force_param = intParamHelper(config,
+            'trigger_arm_force', default=0, minval=0, maxval=250)
         self._force_safety_limit_param = intParamHelper(config,
             'force_safety_limit', minval=100, maxval=5000, default=2000)
 
@@ -250,6 +252,13 @@ class LoadCellProbeConfigHelper:
     def get_trigger_force_grams(self, gcmd=None):
         return self._trigger_force_param.get(gcmd)
 
+    def get_trigger_arm_force_grams(self, gcmd=None):
+        arm_force = self._trigger_arm_force_param.get(gcmd)
+        if arm_force and arm_force >= self.get_trigger_force_grams(gcmd):
+            raise self._printer.command_error(
+                "trigger_arm_force must be less than trigger_force")
+        return arm_force
+
     def get_safety_limit_grams(self, gcmd=None):
         return self._force_safety_limit_param.get(gcmd)
 
@@ -328,7 +337,15 @@ class LoadCellProbingMove:
         # update trigger
         trigger_val = self._config_helper.get_trigger_force_grams(gcmd)
         trigger_frac_grams = trigger_val * FRAC_GRAMS_CONV
-        self._mcu_trigger_analog.set_trigger("abs_ge", trigger_frac_grams)
+        arm_val = self._config_helper.get_trigger_arm_force_grams(gcmd)
+        if arm_val:
+            # Dual threshold hysteresis - the trigger only arms after the
+            # filtered force settles below the arm threshold
+            self._mcu_trigger_analog.set_trigger(
+                "hyst_abs_ge", trigger_frac_grams,
+                arm_val * FRAC_GRAMS_CONV)
+        else:
+            self._mcu_trigger_analog.set_trigger("abs_ge", trigger_frac_grams)
 
     # Probe towards z_min until the trigger_analog on the MCU triggers
     def probing_move(self, gcmd):
@@ -4,7 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging
-import chelper
+import chelper, serialhdl
 
 BGFLUSH_LOW_TIME = 0.200
 BGFLUSH_HIGH_TIME = 0.400
@@ -20,6 +20,11 @@ SDS_CHECK_TIME = 0.001 # step+dir+step filter in stepcompress.c
 DRIP_SEGMENT_TIME = 0.050
 DRIP_TIME = 0.100
 
+# Number of log-scale flush margin buckets (must match steppersync.c)
+SS_MARGIN_BUCKETS = 32
+# Sentinel margin reported when no flushes were recorded
+MARGIN_NONE = 9999999.
+
 class PrinterMotionQueuing:
     def __init__(self, config):
         self.printer = printer = config.get_printer()
@@ -32,6 +37,7 @@ class PrinterMotionQueuing:
         self.steppersyncmgr = ffi_main.gc(ffi_lib.steppersyncmgr_alloc(),
                                           ffi_lib.steppersyncmgr_free)
         self.syncemitters = []
+        self.syncemitter_names = []
         self.steppersyncs = []
         self.steppersyncmgr_gen_steps = ffi_lib.steppersyncmgr_gen_steps
         # History expiration
@@ -58,6 +64,9 @@ class PrinterMotionQueuing:
         self.drip_start_times = []
         # Register handlers
         printer.register_event_handler("klippy:shutdown", self._handle_shutdown)
+        gcode = printer.lookup_object('gcode')
+        gcode.register_command("FLUSH_STATS", self.cmd_FLUSH_STATS,
+                               desc=self.cmd_FLUSH_STATS_help)
     # C trapq tracking
     def allocate_trapq(self):
         ffi_main, ffi_lib = chelper.get_ffi()
@@ -70,6 +79,12 @@ class PrinterMotionQueuing:
     def lookup_trapq_append(self):
         ffi_main, ffi_lib = chelper.get_ffi()
         return ffi_lib.trapq_append
+    def lookup_trapq_append_moves(self):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        return ffi_lib.trapq_append_moves
+    def lookup_trapq_append_lookahead(self):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        return ffi_lib.trapq_append_lookahead
     # C steppersync tracking
     def _lookup_steppersync(self, mcu):
         for ss_mcu, ss in self.steppersyncs:
@@ -80,11 +95,13 @@ class PrinterMotionQueuing:
         self.steppersyncs.append((mcu, ss))
         return ss
     def allocate_syncemitter(self, mcu, name, alloc_stepcompress=True):
-        name = name.encode("utf-8")[:15]
+        cname = name.encode("utf-8")[:15]
         ss = self._lookup_steppersync(mcu)
         ffi_main, ffi_lib = chelper.get_ffi()
-        se = ffi_lib.steppersync_alloc_syncemitter(ss, name, alloc_stepcompress)
+        se = ffi_lib.steppersync_alloc_syncemitter(ss, cname,
+                                                   alloc_stepcompress)
         self.syncemitters.append(se)
+        self.syncemitter_names.append(name)
         return se
     def setup_mcu_movequeue(self, mcu, serialqueue, move_count):
         # Setup steppersync object for the mcu's main movequeue
@@ -104,6 +121,34 @@ class PrinterMotionQueuing:
         est_print_time = self.mcu.estimated_print_time(eventtime)
         self.clear_history_time = max(0., est_print_time - MOVE_HISTORY_EXPIRE)
         return False, ""
+    cmd_FLUSH_STATS_help = "Report step flush deadline margins"
+    def cmd_FLUSH_STATS(self, gcmd):
+        # Report how close each steppersync flush came to its deadline
+        reset = gcmd.get_int('RESET', 0)
+        ffi_main, ffi_lib = chelper.get_ffi()
+        min_margin = ffi_main.new('double *')
+        hist = ffi_main.new('uint32_t[]', SS_MARGIN_BUCKETS)
+        msgs = []
+        for mcu, ss in self.steppersyncs:
+            ffi_lib.steppersync_get_margin_stats(ss, reset, min_margin, hist)
+            counts = list(hist)
+            total = sum(counts)
+            if not total:
+                msgs.append("mcu '%s': no flushes recorded" % (mcu.get_name(),))
+                continue
+            p01 = serialhdl.histogram_percentile(counts, .01)
+            p10 = serialhdl.histogram_percentile(counts, .10)
+            msgs.append("mcu '%s': flushes=%d min_margin=%.6f"
+                        " margin_p01=%.6f margin_p10=%.6f"
+                        % (mcu.get_name(), total, min_margin[0], p01, p10))
+        se_info = []
+        for name, se in zip(self.syncemitter_names, self.syncemitters):
+            se_min = ffi_lib.syncemitter_get_min_margin(se, reset)
+            if se_min < MARGIN_NONE:
+                se_info.append("%s=%.6f" % (name, se_min))
+        if se_info:
+            msgs.append("min_margin: %s" % (" ".join(se_info),))
+        gcmd.respond_info("\n".join(msgs))
     # Flush notification callbacks
     def register_flush_callback(self, callback, can_add_trapq=False):
         if can_add_trapq:
@@ -141,12 +141,16 @@ class DumpTrapQ:
         return {"data": d}
 
 STATUS_REFRESH_TIME = 0.250
+SHM_EXPORT_RECORDS = 32768
 
 class PrinterMotionReport:
     def __init__(self, config):
         self.printer = config.get_printer()
         self.steppers = {}
         self.dtrapqs = {}
+        # Optional shared memory export of move and step records
+        self.shm_export = config.get('shared_memory_export', None)
+        self.shm_ring = None
         # get_status information
         self.next_status_time = 0.
         gcode = self.printer.lookup_object('gcode')
@@ -184,6 +188,29 @@ class PrinterMotionReport:
         # Populate 'trapq' and 'steppers' in get_status result
         self.last_status['steppers'] = list(sorted(self.steppers.keys()))
         self.last_status['trapq'] = list(sorted(self.dtrapqs.keys()))
+        # Setup shared memory export
+        if self.shm_export is not None:
+            self._setup_shm_export()
+    def _setup_shm_export(self):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        rec_size = ffi_lib.shm_motion_record_size()
+        sr = ffi_lib.shmring_open(self.shm_export.encode(), rec_size,
+                                  SHM_EXPORT_RECORDS)
+        if sr == ffi_main.NULL:
+            raise self.printer.config_error(
+                "Unable to create shared memory export file '%s'"
+                % (self.shm_export,))
+        self.shm_ring = ffi_main.gc(sr, ffi_lib.shmring_close)
+        # Export trapq move records (record oid is the index below)
+        trapq_ids = {name: i
+                     for i, name in enumerate(sorted(self.dtrapqs.keys()))}
+        for name, dtrapq in self.dtrapqs.items():
+            ffi_lib.trapq_set_export(dtrapq.trapq, sr, trapq_ids[name])
+        # Export queue_step records (record oid is the stepper mcu oid)
+        for ds in self.steppers.values():
+            ds.mcu_stepper.set_shm_export(sr)
+        logging.info("motion_report: exporting motion records to '%s'"
+                     " (trapq ids: %s)", self.shm_export, trapq_ids)
     # Shutdown handling
     def _handle_analyze_shutdown(self, msg, details):
         if msg != "MCU shutdown":
@@ -215,6 +242,11 @@ class PrinterMotionReport:
         if pos is not None:
             logging.info("Requested toolhead position at shutdown time %.6f: %s"
                          , shutdown_time, pos)
+    # Bulk sampling of past stepper positions
+    def get_past_stepper_positions(self, start_print_time, sample_time, count):
+        return {name: ds.mcu_stepper.get_past_mcu_positions(
+                    start_print_time, sample_time, count)
+                for name, ds in self.steppers.items()}
     # Status reporting
     def get_status(self, eventtime):
         if eventtime < self.next_status_time or not self.dtrapqs:
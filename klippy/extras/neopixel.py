@@ -7,6 +7,7 @@ import logging
 from . import led
 
 BACKGROUND_PRIORITY_CLOCK = 0x7fffffff00000000
+LANE_BULK = 2
 
 BIT_MAX_TIME=.000004
 RESET_MIN_TIME=.000050
@@ -53,7 +54,7 @@ class PrinterNeoPixel:
                                 " bit_max_ticks=%d reset_min_ticks=%d"
                                 % (self.oid, self.pin, len(self.color_data),
                                    bmt, rmt))
-        cmd_queue = self.mcu.alloc_command_queue()
+        cmd_queue = self.mcu.alloc_command_queue(LANE_BULK)
         self.neopixel_update_cmd = self.mcu.lookup_command(
             "neopixel_update oid=%c pos=%hu data=%*s", cq=cmd_queue)
         self.neopixel_send_cmd = self.mcu.lookup_query_command(
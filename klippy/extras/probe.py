@@ -3,7 +3,7 @@
 # Copyright (C) 2017-2024  Kevin O'Connor <kevin@koconnor.net>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
-import logging
+import logging, math
 import pins
 from . import manual_probe
 
@@ -310,6 +310,7 @@ class ProbeParameterHelper:
                                                  minval=0.)
         self.samples_retries = config.getint('samples_tolerance_retries', 0,
                                              minval=0)
+        self.samples_adaptive = config.getboolean('samples_adaptive', False)
     def get_probe_params(self, gcmd=None):
         if gcmd is None:
             gcmd = self.dummy_gcode_cmd
@@ -323,13 +324,25 @@ class ProbeParameterHelper:
         samples_retries = gcmd.get_int("SAMPLES_TOLERANCE_RETRIES",
                                        self.samples_retries, minval=0)
         samples_result = gcmd.get("SAMPLES_RESULT", self.samples_result)
+        samples_adaptive = gcmd.get_int("SAMPLES_ADAPTIVE",
+                                        self.samples_adaptive,
+                                        minval=0, maxval=1)
         return {'probe_speed': probe_speed,
                 'lift_speed': lift_speed,
                 'samples': samples,
                 'sample_retract_dist': sample_retract_dist,
                 'samples_tolerance': samples_tolerance,
                 'samples_tolerance_retries': samples_retries,
-                'samples_result': samples_result}
+                'samples_result': samples_result,
+                'samples_adaptive': samples_adaptive}
+
+# Scheduling buffer for moves within a probe session.  Each print time
+# resync delays the following move by this amount, and a probe session
+# resyncs on every sample (once for the retract and once for the probing
+# move itself).  The probing "drip" moves only stream with a 0.100s
+# lead, so use the same margin for the session instead of the default
+# buffer sized for streaming prints.
+PROBE_SESSION_RESYNC_TIME = 0.100
 
 # Helper to track multiple probe attempts in a single command
 class ProbeSessionHelper:
@@ -339,6 +352,7 @@ class ProbeSessionHelper:
         self.start_session_cb = start_session_cb
         # Session state
         self.hw_probe_session = None
+        self.prev_resync_buffer_time = None
         self.results = []
         # Register event handlers
         self.printer.register_event_handler("gcode:command_error",
@@ -356,12 +370,18 @@ class ProbeSessionHelper:
         if self.hw_probe_session is not None:
             self._probe_state_error()
         self.hw_probe_session = self.start_session_cb(gcmd)
+        toolhead = self.printer.lookup_object('toolhead')
+        self.prev_resync_buffer_time = toolhead.set_resync_buffer_time(
+            PROBE_SESSION_RESYNC_TIME)
         self.results = []
         return self
     def end_probe_session(self):
         hw_probe_session = self.hw_probe_session
         if hw_probe_session is None:
             self._probe_state_error()
+        toolhead = self.printer.lookup_object('toolhead')
+        toolhead.set_resync_buffer_time(self.prev_resync_buffer_time)
+        self.prev_resync_buffer_time = None
         self.results = []
         self.hw_probe_session = None
         hw_probe_session.end_probe_session()
@@ -408,6 +428,9 @@ class ProbeSessionHelper:
                 gcmd.respond_info("Probe samples exceed tolerance. Retrying...")
                 retries += 1
                 positions = []
+            elif params['samples_adaptive'] and len(positions) >= 2:
+                # Samples already agree - skip the remaining samples
+                break
             # Retract
             if len(positions) < sample_count:
                 cur_z = toolhead.get_position()[2]
@@ -456,6 +479,8 @@ class ProbePointsHelper:
         def_move_z = config.getfloat('horizontal_move_z', 5.)
         self.default_horizontal_move_z = def_move_z
         self.speed = config.getfloat('speed', 50., above=0.)
+        self.path_optimize = config.getboolean('path_optimize', False)
+        self.travel_hop_z = config.getfloat('travel_hop_z', 0., minval=0.)
         self.use_offsets = False
         # Internal probing state
         self.lift_speed = self.speed
@@ -494,6 +519,57 @@ class ProbePointsHelper:
             nextpos[0] -= self.probe_offsets[0]
             nextpos[1] -= self.probe_offsets[1]
         self._move(nextpos, self.speed)
+    def _travel_next(self, probe_num, is_first):
+        # Raise the tool and travel to the next probe point
+        if is_first or not self.travel_hop_z:
+            self._raise_tool(is_first)
+            self._move_next(probe_num)
+            return
+        # Short vertical hop, then blend the remaining raise into the
+        # xy travel move so the lookahead can overlap them
+        nextpos = list(self.probe_points[probe_num])
+        if self.use_offsets:
+            nextpos[0] -= self.probe_offsets[0]
+            nextpos[1] -= self.probe_offsets[1]
+        cur_z = self.printer.lookup_object('toolhead').get_position()[2]
+        hop_z = min(cur_z + self.travel_hop_z, self.horizontal_move_z)
+        self._move([None, None, hop_z], self.lift_speed)
+        self._move(nextpos + [self.horizontal_move_z], self.speed)
+    def _plan_probe_order(self):
+        # Order the probe points to minimize xy travel (results are
+        # always reported in the configured point order)
+        points = self.probe_points
+        order = list(range(len(points)))
+        if not self.path_optimize or len(points) <= 2:
+            return order
+        def dist(i, j):
+            return math.sqrt((points[i][0] - points[j][0])**2
+                             + (points[i][1] - points[j][1])**2)
+        # Greedy nearest neighbor tour from the current position
+        curpos = self.printer.lookup_object('toolhead').get_position()[:2]
+        remaining = order
+        order = []
+        while remaining:
+            best = min(remaining, key=lambda i: (points[i][0] - curpos[0])**2
+                       + (points[i][1] - curpos[1])**2)
+            remaining.remove(best)
+            order.append(best)
+            curpos = points[best]
+        # Improve the tour with 2-opt segment reversals
+        for pass_num in range(10):
+            improved = False
+            for a in range(len(order) - 2):
+                for b in range(a + 2, len(order) - 1):
+                    delta = (dist(order[a], order[b])
+                             + dist(order[a+1], order[b+1])
+                             - dist(order[a], order[a+1])
+                             - dist(order[b], order[b+1]))
+                    if delta < -.000001:
+                        order[a+1:b+1] = reversed(order[a+1:b+1])
+                        improved = True
+            if not improved:
+                break
+        return order
     def start_probe(self, gcmd):
         manual_probe.verify_no_manual_probe(self.printer)
         # Lookup objects
@@ -516,17 +592,24 @@ class ProbePointsHelper:
             raise gcmd.error("horizontal_move_z can't be less than"
                              " probe's z_offset")
         probe_session = probe.start_probe_session(gcmd)
+        probe_order = self._plan_probe_order()
         probe_num = 0
         while 1:
-            self._raise_tool(not probe_num)
-            if probe_num >= len(self.probe_points):
-                results = probe_session.pull_probed_results()
+            is_first = not probe_num
+            if probe_num >= len(probe_order):
+                self._raise_tool()
+                res = probe_session.pull_probed_results()
+                # Restore results to the configured point order
+                results = [None] * len(probe_order)
+                for tour_pos, index in enumerate(probe_order):
+                    results[index] = res[tour_pos]
                 done = self._invoke_callback(results)
                 if done:
                     break
                 # Caller wants a "retry" - restart probing
                 probe_num = 0
-            self._move_next(probe_num)
+                is_first = True
+            self._travel_next(probe_order[probe_num], is_first)
             probe_session.run_probe(gcmd)
             probe_num += 1
         probe_session.end_probe_session()
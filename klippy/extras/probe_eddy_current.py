@@ -83,6 +83,28 @@ class EddyCalibration:
         offset = prev_freq - prev_zpos * gain
         freq = height * gain + offset
         return self.drift_comp.unadjust_freq(freq)
+    def build_linearize(self, convert_freq, max_segments=16):
+        # Reduce the calibration table to piecewise linear segments of
+        # (raw_start, gain, height) for the mcu trigger_analog code
+        num_cal = len(self.cal_freqs)
+        knots = sorted({i * (num_cal - 1) // max_segments
+                        for i in range(max_segments + 1)})
+        segments = []
+        for k0, k1 in zip(knots[:-1], knots[1:]):
+            raw0 = convert_freq(self.cal_freqs[k0])
+            raw1 = convert_freq(self.cal_freqs[k1])
+            if raw1 <= raw0:
+                continue
+            gain = (self.cal_zpos[k1] - self.cal_zpos[k0]) / (raw1 - raw0)
+            segments.append((raw0, gain, self.cal_zpos[k0]))
+        return segments
+    def get_drift_offset(self, convert_freq, height):
+        # Determine raw counts to add to a sample taken at the current
+        # temperature to obtain the calibration temperature equivalent
+        cur_freq = self.height_to_freq(height)
+        cur_temp = self.drift_comp.get_temperature()
+        cal_freq = self.drift_comp.adjust_freq(cur_freq, cur_temp)
+        return convert_freq(cal_freq) - convert_freq(cur_freq)
     def do_calibration_moves(self, move_speed):
         toolhead = self.printer.lookup_object('toolhead')
         kin = toolhead.get_kinematics()
@@ -391,6 +413,11 @@ def probe_results_from_avg(measures, toolhead_pos, calibration, offsets):
 
 MAX_VALID_RAW_VALUE=0x03ffffff
 
+# Scaling of heights sent to the mcu (heights in nanometers)
+HEIGHT_SCALE = 1000000.
+# Time between drift correction updates during a probe session
+DRIFT_UPDATE_TIME = 1.0
+
 # Helper for implementing PROBE style commands (descend until trigger)
 class EddyDescend:
     def __init__(self, config, sensor_helper, calibration,
@@ -403,19 +430,37 @@ class EddyDescend:
         self._trigger_analog = trigger_analog
         self._z_min_position = probe.lookup_minimum_z(config)
         self._gather = None
+        self._drift_timer = None
     def _prep_trigger_analog(self):
         sos_filter = self._trigger_analog.get_sos_filter()
         sos_filter.set_filter_design(None)
         sos_filter.set_offset_scale(0, 1.)
         self._trigger_analog.set_raw_range(0, MAX_VALID_RAW_VALUE)
+        # Trigger on mcu calculated height (via linearized calibration)
+        convert_freq = self._sensor_helper.convert_frequency
+        segments = self._calibration.build_linearize(convert_freq)
+        self._trigger_analog.set_linearize(
+            [(raw_start, gain * HEIGHT_SCALE, zpos * HEIGHT_SCALE)
+             for raw_start, gain, zpos in segments])
         z_offset = self._probe_offsets.get_offsets()[2]
-        trigger_freq = self._calibration.height_to_freq(z_offset)
-        conv_freq = self._sensor_helper.convert_frequency(trigger_freq)
-        self._trigger_analog.set_trigger('gt', conv_freq)
+        self._trigger_analog.set_trigger('le', z_offset * HEIGHT_SCALE)
+        self._update_drift()
+    def _update_drift(self):
+        # Keep the mcu drift offset in sync with the current temperature
+        convert_freq = self._sensor_helper.convert_frequency
+        z_offset = self._probe_offsets.get_offsets()[2]
+        drift = self._calibration.get_drift_offset(convert_freq, z_offset)
+        self._trigger_analog.set_drift(drift)
+    def _drift_update_event(self, eventtime):
+        self._update_drift()
+        return eventtime + DRIFT_UPDATE_TIME
     # Probe session interface
     def start_probe_session(self, gcmd):
         self._calibration.verify_calibrated()
         self._prep_trigger_analog()
+        reactor = self._printer.get_reactor()
+        self._drift_timer = reactor.register_timer(
+            self._drift_update_event, reactor.monotonic() + DRIFT_UPDATE_TIME)
         self._gather = EddyGatherSamples(self._printer, self._sensor_helper)
         return self
     def run_probe(self, gcmd):
@@ -437,6 +482,8 @@ class EddyDescend:
     def pull_probed_results(self):
         return self._gather.pull_probed()
     def end_probe_session(self):
+        self._printer.get_reactor().unregister_timer(self._drift_timer)
+        self._drift_timer = None
         self._gather.finish()
         self._gather = None
 
@@ -510,6 +557,9 @@ class EddyTap:
         sos_filter.set_filter_design(self._filter_design)
         sos_filter.set_offset_scale(0, 1., auto_offset=True)
         self._trigger_analog.set_raw_range(0, MAX_VALID_RAW_VALUE)
+        # Tap detection works on raw frequency differences
+        self._trigger_analog.set_linearize([])
+        self._trigger_analog.set_drift(0)
         convert_frequency = self._sensor_helper.convert_frequency
         tap_threshold = gcmd.get_float("TAP_THRESHOLD",
                                        self._tap_threshold, above=0.)
@@ -0,0 +1,104 @@
+# Support for cpu placement of the klippy host process threads
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import os, logging
+
+class ProcessLayout:
+    def __init__(self, config):
+        self.printer = config.get_printer()
+        self.main_cpu = config.getint('main_cpu', None, minval=0)
+        self.serial_cpus = self._parse_pairs(config, 'serial_cpus')
+        self.transmit_priority = config.getint('transmit_priority', 0,
+                                               minval=0, maxval=98)
+        self.irq_affinity = self._parse_pairs(config, 'irq_affinity')
+        self.layout = {}
+        self.tracked = []
+        self.migrations = 0
+        self.printer.register_event_handler("klippy:connect",
+                                            self._handle_connect)
+    def _parse_pairs(self, config, option):
+        # Parse an option formatted as "name=cpu, name=cpu, ..."
+        pairs = {}
+        for item in config.get(option, '').split(','):
+            item = item.strip()
+            if not item:
+                continue
+            parts = [p.strip() for p in item.split('=')]
+            try:
+                pairs[parts[0]] = int(parts[1])
+            except (IndexError, ValueError):
+                raise config.error(
+                    "Unable to parse option '%s' in section '%s'"
+                    % (option, config.get_name()))
+        return pairs
+    def _track(self, name, tid):
+        self.tracked.append([name, tid, -1])
+    def _read_thread_cpu(self, tid):
+        # Field 39 of /proc/<pid>/task/<tid>/stat is the last run cpu
+        try:
+            with open("/proc/%d/task/%d/stat" % (os.getpid(), tid)) as f:
+                data = f.read()
+            return int(data.rsplit(')', 1)[1].split()[36])
+        except (OSError, IndexError, ValueError):
+            return -1
+    def _handle_connect(self):
+        # Pin the main (reactor) thread
+        if self.main_cpu is not None:
+            try:
+                os.sched_setaffinity(0, {self.main_cpu})
+            except OSError:
+                logging.warning("process_layout: Unable to pin main thread"
+                                " to cpu %d", self.main_cpu)
+            else:
+                self.layout['main'] = self.main_cpu
+        self._track('main', os.getpid())
+        # Pin each serialqueue background thread
+        for name, mcu_obj in self.printer.lookup_objects(module='mcu'):
+            mcu_name = name.split()[-1] if ' ' in name else 'mcu'
+            serial = mcu_obj.get_serial()
+            sq = serial.get_serialqueue()
+            if sq is None:
+                continue
+            cpu = self.serial_cpus.get(mcu_name, -1)
+            ret = serial.ffi_lib.serialqueue_set_cpu_layout(
+                sq, cpu, self.transmit_priority)
+            if ret:
+                logging.warning("process_layout: Unable to set layout for"
+                                " '%s' serial thread (cpu=%d priority=%d)",
+                                mcu_name, cpu, self.transmit_priority)
+            elif cpu >= 0:
+                self.layout['serial_' + mcu_name] = cpu
+            tid = serial.ffi_lib.serialqueue_get_thread_id(sq)
+            if tid > 0:
+                self._track('serial_' + mcu_name, tid)
+        # Apply os interrupt affinity hints
+        for irq, cpu in self.irq_affinity.items():
+            try:
+                fname = "/proc/irq/%d/smp_affinity_list" % (int(irq),)
+                with open(fname, "w") as f:
+                    f.write("%d" % (cpu,))
+            except (OSError, ValueError):
+                logging.warning("process_layout: Unable to set affinity of"
+                                " irq %s to cpu %d (requires root)",
+                                irq, cpu)
+            else:
+                self.layout['irq_' + irq] = cpu
+        logging.info("process_layout: applied layout %s", self.layout)
+    def stats(self, eventtime):
+        # Count cpu migrations of the tracked threads
+        for info in self.tracked:
+            cpu = self._read_thread_cpu(info[1])
+            if cpu >= 0:
+                if info[2] >= 0 and cpu != info[2]:
+                    self.migrations += 1
+                info[2] = cpu
+        return (False, "cpu_migrations=%d" % (self.migrations,))
+    def get_status(self, eventtime):
+        return {'layout': dict(self.layout),
+                'thread_cpus': {i[0]: i[2] for i in self.tracked},
+                'cpu_migrations': self.migrations}
+
+def load_config(config):
+    return ProcessLayout(config)
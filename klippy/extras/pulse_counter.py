@@ -5,13 +5,17 @@
 # This file may be distributed under the terms of the GNU GPLv3 license.
 
 class MCU_counter:
-    def __init__(self, printer, pin, sample_time, poll_time):
+    def __init__(self, printer, pin, sample_time, poll_time, hardware=False):
         ppins = printer.lookup_object('pins')
         pin_params = ppins.lookup_pin(pin, can_pullup=True)
         self._mcu = pin_params['chip']
         self._oid = self._mcu.create_oid()
         self._pin = pin_params['pin']
         self._pullup = pin_params['pullup']
+        self._hardware = hardware
+        if hardware:
+            # A hardware counter only needs to be read once per sample
+            poll_time = sample_time
         self._poll_time = poll_time
         self._poll_ticks = 0
         self._sample_time = sample_time
@@ -20,8 +24,11 @@ class MCU_counter:
         self._mcu.register_config_callback(self.build_config)
 
     def build_config(self):
-        self._mcu.add_config_cmd("config_counter oid=%d pin=%s pull_up=%d"
-            % (self._oid, self._pin, self._pullup))
+        config_cmd = "config_counter"
+        if self._hardware:
+            config_cmd = "config_counter_hw"
+        self._mcu.add_config_cmd("%s oid=%d pin=%s pull_up=%d"
+            % (config_cmd, self._oid, self._pin, self._pullup))
         clock = self._mcu.get_query_slot(self._oid)
         self._poll_ticks = self._mcu.seconds_to_clock(self._poll_time)
         sample_ticks = self._mcu.seconds_to_clock(self._sample_time)
@@ -54,11 +61,12 @@ class MCU_counter:
             self._callback(time, count, count_time)
 
 class FrequencyCounter:
-    def __init__(self, printer, pin, sample_time, poll_time):
+    def __init__(self, printer, pin, sample_time, poll_time, hardware=False):
         self._callback = None
         self._last_time = self._last_count = None
         self._freq = 0.
-        self._counter = MCU_counter(printer, pin, sample_time, poll_time)
+        self._counter = MCU_counter(printer, pin, sample_time, poll_time,
+                                    hardware)
         self._counter.setup_callback(self._counter_callback)
 
     def _counter_callback(self, time, count, count_time):
@@ -330,15 +330,18 @@ class ResonanceTester:
                 if len(axes) > 1:
                     gcmd.respond_info("Testing axis %s" % axis.get_name())
 
+                # Accumulate the PSD during the capture itself when the
+                # raw samples do not need to be retained
+                streaming = helper if raw_name_suffix is None else None
                 raw_values = []
                 if accel_chips is None:
                     for chip_axis, chip in self.accel_chips:
                         if axis.matches(chip_axis):
-                            aclient = chip.start_internal_client()
+                            aclient = self._start_capture(chip, streaming)
                             raw_values.append((chip_axis, aclient, chip.name))
                 else:
                     for chip in accel_chips:
-                        aclient = chip.start_internal_client()
+                        aclient = self._start_capture(chip, streaming)
                         raw_values.append((axis, aclient, chip.name))
                 if not raw_values:
                     raise gcmd.error(
@@ -378,6 +381,13 @@ class ResonanceTester:
                     else:
                         calibration_data[axis].add_data(new_data)
         return calibration_data
+    def _start_capture(self, chip, helper):
+        if helper is not None and hasattr(chip, 'batch_bulk'):
+            aclient = helper.start_streaming_capture()
+            if aclient is not None:
+                chip.batch_bulk.add_client(aclient.handle_batch)
+                return aclient
+        return chip.start_internal_client()
     def _parse_chips(self, accel_chips):
         parsed_chips = []
         for chip_name in accel_chips.split(','):
@@ -0,0 +1,81 @@
+# Sampling profiler with reactor handler attribution
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import os, sys, time, threading
+
+class SamplingProfiler:
+    def __init__(self, config):
+        self.printer = config.get_printer()
+        self.reactor = self.printer.get_reactor()
+        self.sample_interval = config.getfloat('sample_interval', .010,
+                                               minval=.001)
+        # Samples are aggregated by (handler label, stack of code
+        # objects) - code objects are long lived, so a sample costs a
+        # stack walk and one dict update
+        self.lock = threading.Lock()
+        self.samples = {}
+        self.sample_count = 0
+        self.start_time = time.monotonic()
+        self.shutdown = False
+        self.thread = threading.Thread(target=self._sampler_thread)
+        self.thread.daemon = True
+        self.thread.start()
+        self.printer.register_event_handler("klippy:disconnect",
+                                            self._handle_disconnect)
+        webhooks = self.printer.lookup_object('webhooks')
+        webhooks.register_endpoint("sampling_profiler/dump_profile",
+                                   self._handle_dump_profile)
+    def _handle_disconnect(self):
+        self.shutdown = True
+    def _sampler_thread(self):
+        main_id = threading.main_thread().ident
+        interval = self.sample_interval
+        get_active_handler = self.reactor.get_active_handler
+        while not self.shutdown:
+            time.sleep(interval)
+            frame = sys._current_frames().get(main_id)
+            if frame is None:
+                continue
+            cb = get_active_handler()
+            if cb is None:
+                label = "reactor(idle)"
+            else:
+                label = "%s.%s" % (getattr(cb, '__module__', '?'),
+                                   getattr(cb, '__qualname__', '?'))
+            stack = []
+            while frame is not None:
+                stack.append(frame.f_code)
+                frame = frame.f_back
+            key = (label, tuple(stack))
+            with self.lock:
+                self.samples[key] = self.samples.get(key, 0) + 1
+                self.sample_count += 1
+    def _handle_dump_profile(self, web_request):
+        do_reset = web_request.get_int('reset', 0)
+        with self.lock:
+            samples = self.samples
+            sample_count = self.sample_count
+            if do_reset:
+                self.samples = {}
+                self.sample_count = 0
+        elapsed = time.monotonic() - self.start_time
+        if do_reset:
+            self.start_time = time.monotonic()
+        # Collapse to flamegraph "folded stack" format (leaf last)
+        folded = {}
+        for (label, stack), count in samples.items():
+            parts = [label]
+            for code in reversed(stack):
+                parts.append("%s:%s" % (os.path.basename(code.co_filename),
+                                        code.co_name))
+            key = ";".join(parts)
+            folded[key] = folded.get(key, 0) + count
+        web_request.send({'sample_interval': self.sample_interval,
+                          'sample_count': sample_count,
+                          'elapsed_time': elapsed,
+                          'folded_stacks': folded})
+
+def load_config(config):
+    return SamplingProfiler(config)
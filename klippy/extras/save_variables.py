@@ -6,23 +6,36 @@
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import os, logging, ast, configparser
 
+# Rewrite the variables file after this many journaled updates
+COMPACT_THRESHOLD = 100
+
 class SaveVariables:
     def __init__(self, config):
         self.printer = config.get_printer()
+        self.reactor = self.printer.get_reactor()
         self.filename = os.path.expanduser(config.get('filename'))
         self.allVariables = {}
+        # Updates are journaled - appended to the file from a deferred
+        # callback (coalescing back to back saves) and compacted into a
+        # full rewrite periodically
+        self.pending = {}
+        self.flush_request = None
+        self.journal_count = 0
+        self.need_rewrite = True
         try:
             if not os.path.exists(self.filename):
                 open(self.filename, "w").close()
             self.loadVariables()
         except self.printer.command_error as e:
             raise config.error(str(e))
+        self.printer.register_event_handler("klippy:disconnect",
+                                            self._handle_disconnect)
         gcode = self.printer.lookup_object('gcode')
         gcode.register_command('SAVE_VARIABLE', self.cmd_SAVE_VARIABLE,
                                desc=self.cmd_SAVE_VARIABLE_help)
     def loadVariables(self):
         allvars = {}
-        varfile = configparser.ConfigParser()
+        varfile = configparser.ConfigParser(strict=False)
         try:
             varfile.read(self.filename)
             if varfile.has_section('Variables'):
@@ -33,6 +46,38 @@ class SaveVariables:
             logging.exception(msg)
             raise self.printer.command_error(msg)
         self.allVariables = allvars
+    def _note_pending(self):
+        if self.flush_request is None:
+            self.flush_request = self.reactor.register_callback(self._flush)
+    def _flush(self, eventtime):
+        self.flush_request = None
+        pending = self.pending
+        self.pending = {}
+        if not pending:
+            return
+        try:
+            if self.need_rewrite or self.journal_count >= COMPACT_THRESHOLD:
+                self._write_full()
+            else:
+                f = open(self.filename, "a")
+                for name, val in sorted(pending.items()):
+                    f.write("%s = %s\n" % (name, repr(val)))
+                f.close()
+                self.journal_count += len(pending)
+        except:
+            logging.exception("Unable to save variable file")
+    def _write_full(self):
+        varfile = configparser.ConfigParser()
+        varfile.add_section('Variables')
+        for name, val in sorted(self.allVariables.items()):
+            varfile.set('Variables', name, repr(val))
+        f = open(self.filename, "w")
+        varfile.write(f)
+        f.close()
+        self.journal_count = 0
+        self.need_rewrite = False
+    def _handle_disconnect(self):
+        self._flush(None)
     cmd_SAVE_VARIABLE_help = "Save arbitrary variables to disk"
     def cmd_SAVE_VARIABLE(self, gcmd):
         varname = gcmd.get('VARIABLE')
@@ -45,20 +90,9 @@ class SaveVariables:
             raise gcmd.error("Unable to parse '%s' as a literal" % (value,))
         newvars = dict(self.allVariables)
         newvars[varname] = value
-        # Write file
-        varfile = configparser.ConfigParser()
-        varfile.add_section('Variables')
-        for name, val in sorted(newvars.items()):
-            varfile.set('Variables', name, repr(val))
-        try:
-            f = open(self.filename, "w")
-            varfile.write(f)
-            f.close()
-        except:
-            msg = "Unable to save variable"
-            logging.exception(msg)
-            raise gcmd.error(msg)
-        self.loadVariables()
+        self.allVariables = newvars
+        self.pending[varname] = value
+        self._note_pending()
     def get_status(self, eventtime):
         return {'variables': self.allVariables}
 
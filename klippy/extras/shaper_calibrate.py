@@ -57,6 +57,88 @@ class CalibrationData:
         return [self] + self.data_sets
 
 
+# Samples buffered before the FFT size is chosen from the sample rate
+MIN_STREAM_SAMPLES = 128
+
+class StreamingPsdHelper:
+    # Incrementally feeds accelerometer sample batches into the chelper
+    # Welch PSD accumulator, so memory use stays bounded by the FFT size
+    # and the spectrum is ready as soon as the capture completes.  This
+    # mimics the AccelQueryHelper client interface, though samples can
+    # only be trimmed to the measurement start time (samples cannot be
+    # dropped retroactively once the end time becomes known).
+    def __init__(self, printer, ffi_main, ffi_lib):
+        self.printer = printer
+        self.ffi_main = ffi_main
+        self.ffi_lib = ffi_lib
+        print_time = printer.lookup_object('toolhead').get_last_move_time()
+        self.request_start_time = self.request_end_time = print_time
+        self.is_finished = False
+        self.psd_accum = None
+        self.pending = []
+        self.num_samples = 0
+        self.first_time = self.last_time = None
+    def finish_measurements(self):
+        toolhead = self.printer.lookup_object('toolhead')
+        self.request_end_time = toolhead.get_last_move_time()
+        toolhead.wait_moves()
+        self.is_finished = True
+    def handle_batch(self, msg):
+        if self.is_finished:
+            return False
+        samples = [s for s in msg['data']
+                   if s[0] >= self.request_start_time]
+        if not samples:
+            return True
+        if self.first_time is None:
+            self.first_time = samples[0][0]
+        self.last_time = samples[-1][0]
+        self.num_samples += len(samples)
+        if self.psd_accum is None:
+            self.pending.extend(samples)
+            if (self.num_samples >= MIN_STREAM_SAMPLES
+                    and self.last_time > self.first_time):
+                self._setup_accum()
+            return True
+        self._add_samples(samples)
+        return True
+    def _estimate_sample_freq(self):
+        return (self.num_samples - 1) / (self.last_time - self.first_time)
+    def _setup_accum(self):
+        sample_freq = self._estimate_sample_freq()
+        # Round up to the nearest power of 2 for faster FFT
+        nfft = 1 << int(sample_freq * WINDOW_T_SEC - 1).bit_length()
+        self.psd_accum = self.ffi_main.gc(self.ffi_lib.psd_accum_alloc(nfft),
+                                          self.ffi_lib.psd_accum_free)
+        pending, self.pending = self.pending, []
+        self._add_samples(pending)
+    def _add_samples(self, samples):
+        flat = [v for s in samples for v in (s[1], s[2], s[3])]
+        c_samples = self.ffi_main.new("double[]", flat)
+        self.ffi_lib.psd_accum_add(self.psd_accum, c_samples, len(samples))
+    def has_valid_samples(self):
+        return self.num_samples > 0
+    def get_calibration_data(self, name, np):
+        if self.psd_accum is None:
+            return None
+        if not self.ffi_lib.psd_accum_get_num_windows(self.psd_accum):
+            return None
+        nfft = self.ffi_lib.psd_accum_get_nfft(self.psd_accum)
+        num_bins = nfft // 2 + 1
+        freq_bins = np.zeros(num_bins)
+        psd_x = np.zeros(num_bins)
+        psd_y = np.zeros(num_bins)
+        psd_z = np.zeros(num_bins)
+        self.ffi_lib.psd_accum_finalize(
+                self.psd_accum, self._estimate_sample_freq(),
+                self.ffi_main.from_buffer("double[]", freq_bins),
+                self.ffi_main.from_buffer("double[]", psd_x),
+                self.ffi_main.from_buffer("double[]", psd_y),
+                self.ffi_main.from_buffer("double[]", psd_z))
+        return CalibrationData(name, freq_bins, psd_x+psd_y+psd_z,
+                               psd_x, psd_y, psd_z)
+
+
 CalibrationResult = collections.namedtuple(
         'CalibrationResult',
         ('name', 'freq', 'freq_bins', 'vals', 'vibrs',
@@ -73,14 +155,27 @@ class ShaperCalibrate:
                     "Failed to import `numpy` module, make sure it was "
                     "installed via `~/klippy-env/bin/pip install` (refer to "
                     "docs/Measuring_Resonances.md for more details).")
+        self.ffi_main = self.ffi_lib = None
+        try:
+            import chelper
+            self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        except Exception:
+            # Fall back to pure python/numpy calculations
+            pass
+
+    def start_streaming_capture(self):
+        # Return a bounded-memory streaming PSD client (or None if the
+        # C helper is not available)
+        if self.printer is None or self.ffi_lib is None:
+            return None
+        return StreamingPsdHelper(self.printer, self.ffi_main, self.ffi_lib)
 
-    def background_process_exec(self, method, args):
-        if self.printer is None:
-            return method(*args)
-        import queuelogger
+    def _start_calculation(self, method, args):
         parent_conn, child_conn = multiprocessing.Pipe()
         def wrapper():
-            queuelogger.clear_bg_logging()
+            if self.printer is not None:
+                import queuelogger
+                queuelogger.clear_bg_logging()
             try:
                 res = method(*args)
             except:
@@ -99,16 +194,9 @@ class ShaperCalibrate:
         calc_proc = multiprocessing.Process(target=wrapper)
         calc_proc.daemon = True
         calc_proc.start()
-        # Wait for the process to finish
-        reactor = self.printer.get_reactor()
-        gcode = self.printer.lookup_object("gcode")
-        eventtime = last_report_time = reactor.monotonic()
-        while calc_proc.is_alive() and not parent_conn.poll():
-            if eventtime > last_report_time + 5.:
-                last_report_time = eventtime
-                gcode.respond_info("Wait for calculations..", log=False)
-            eventtime = reactor.pause(eventtime + .1)
-        # Return results
+        return calc_proc, parent_conn
+
+    def _collect_calculation(self, calc_proc, parent_conn):
         status, recv = parent_conn.recv()
         if recv is None:
             res = []
@@ -125,6 +213,59 @@ class ShaperCalibrate:
         parent_conn.close()
         return res
 
+    def background_process_exec(self, method, args):
+        if self.printer is None:
+            return method(*args)
+        return self.background_process_exec_multi([(method, args)])[0]
+
+    def background_process_exec_multi(self, calls):
+        # Run calculations in parallel background processes.  The forked
+        # workers share the input arrays with the parent (copy on write)
+        # - only the results travel over a pipe.
+        if self.printer is None:
+            if multiprocessing.get_start_method() != 'fork':
+                return [method(*args) for method, args in calls]
+            # No reactor - start everything and block on the results
+            procs = [self._start_calculation(method, args)
+                     for method, args in calls]
+            return [self._collect_calculation(calc_proc, parent_conn)
+                    for calc_proc, parent_conn in procs]
+        num_calls = len(calls)
+        max_parallel = max(1, multiprocessing.cpu_count() - 1)
+        procs = [None] * num_calls
+        results = [None] * num_calls
+        is_done = [False] * num_calls
+        num_started = num_done = 0
+        reactor = self.printer.get_reactor()
+        gcode = self.printer.lookup_object("gcode")
+        eventtime = last_report_time = reactor.monotonic()
+        while num_done < num_calls:
+            # Launch processes (bounded by the cpu count)
+            while (num_started < num_calls
+                   and num_started - num_done < max_parallel):
+                procs[num_started] = self._start_calculation(
+                        *calls[num_started])
+                num_started += 1
+            # Collect finished calculations
+            did_collect = False
+            for i in range(num_started):
+                if is_done[i]:
+                    continue
+                calc_proc, parent_conn = procs[i]
+                if calc_proc.is_alive() and not parent_conn.poll():
+                    continue
+                results[i] = self._collect_calculation(calc_proc, parent_conn)
+                is_done[i] = True
+                num_done += 1
+                did_collect = True
+            if did_collect:
+                continue
+            if eventtime > last_report_time + 5.:
+                last_report_time = eventtime
+                gcode.respond_info("Wait for calculations..", log=False)
+            eventtime = reactor.pause(eventtime + .1)
+        return results
+
     def _split_into_windows(self, x, window_size, overlap):
         # Memory-efficient algorithm to split an input 'x' into a series
         # of overlapping windows
@@ -193,8 +334,12 @@ class ShaperCalibrate:
         return CalibrationData(name, fx, px+py+pz, px, py, pz)
 
     def process_accelerometer_data(self, name, data):
-        calibration_data = self.background_process_exec(
-                self.calc_freq_response, (name, data))
+        if isinstance(data, StreamingPsdHelper):
+            # The PSD was accumulated during the capture itself
+            calibration_data = data.get_calibration_data(name, self.numpy)
+        else:
+            calibration_data = self.background_process_exec(
+                    self.calc_freq_response, (name, data))
         if calibration_data is None:
             raise self.error(
                     "Internal error processing accelerometer data %s" % (data,))
@@ -203,6 +348,17 @@ class ShaperCalibrate:
 
     def _estimate_shaper(self, shaper, test_damping_ratio, test_freqs):
         np = self.numpy
+        if self.ffi_lib is not None:
+            freqs = np.ascontiguousarray(test_freqs, dtype=np.float64)
+            vals = np.zeros(freqs.shape[0])
+            self.ffi_lib.shaper_estimate_response(
+                    self.ffi_main.new("double[]", list(shaper[0])),
+                    self.ffi_main.new("double[]", list(shaper[1])),
+                    len(shaper[0]), test_damping_ratio,
+                    self.ffi_main.from_buffer("double[]", freqs),
+                    freqs.shape[0],
+                    self.ffi_main.from_buffer("double[]", vals))
+            return vals
 
         A, T = np.array(shaper[0]), np.array(shaper[1])
         inv_D = 1. / A.sum()
@@ -359,12 +515,13 @@ class ShaperCalibrate:
         best_shaper = None
         all_shapers = []
         shapers = shapers or AUTOTUNE_SHAPERS
-        for shaper_cfg in shaper_defs.INPUT_SHAPERS:
-            if shaper_cfg.name not in shapers:
-                continue
-            fit_results = self.background_process_exec(self.fit_shaper, (
-                shaper_cfg, calibration_data, shaper_freqs, damping_ratio,
-                scv, max_smoothing, test_damping_ratios, max_freq))
+        # Fit all shaper candidates in parallel
+        calls = [(self.fit_shaper, (
+                    shaper_cfg, calibration_data, shaper_freqs, damping_ratio,
+                    scv, max_smoothing, test_damping_ratios, max_freq))
+                 for shaper_cfg in shaper_defs.INPUT_SHAPERS
+                 if shaper_cfg.name in shapers]
+        for fit_results in self.background_process_exec_multi(calls):
             shaper = fit_results[0]
             results = fit_results[1:]
             if (best_shaper is None or shaper.score * 1.2 < best_shaper.score or
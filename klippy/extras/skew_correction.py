@@ -10,6 +10,7 @@
 # This file may be distributed under the terms of the GNU GPLv3 license.
 
 import math
+import chelper
 
 def calc_skew_factor(ac, bd, ad):
     side = math.sqrt(2*ac*ac + 2*bd*bd - 4*ad*ad) / 2.
@@ -27,9 +28,13 @@ class PrinterSkew:
         self.yz_factor = 0.
         self.skew_profiles = {}
         self._load_storage(config)
+        self.printer.register_event_handler("klippy:mcu_identify",
+                                            self._handle_mcu_identify)
         self.printer.register_event_handler("klippy:connect",
                                             self._handle_connect)
-        self.next_transform = None
+        self.is_affine_transform = False
+        self.skew_stepper_kinematics = []
+        self.orig_stepper_kinematics = []
         gcode = self.printer.lookup_object('gcode')
         gcode.register_command('GET_CURRENT_SKEW', self.cmd_GET_CURRENT_SKEW,
                                desc=self.cmd_GET_CURRENT_SKEW_help)
@@ -40,9 +45,37 @@ class PrinterSkew:
                                desc=self.cmd_SET_SKEW_help)
         gcode.register_command('SKEW_PROFILE', self.cmd_SKEW_PROFILE,
                                desc=self.cmd_SKEW_PROFILE_help)
+    def _handle_mcu_identify(self):
+        if self.printer.lookup_object('dual_carriage', None) is not None:
+            # Carriage changes rebuild the stepper kinematics - fall
+            # back to the gcode transform (see _handle_connect)
+            return
+        # Wrap each stepper's kinematics so the skew is applied during
+        # step generation.  This runs before [input_shaper] connects so
+        # that the input shaper remains the outermost wrapper.
+        ffi_main, ffi_lib = chelper.get_ffi()
+        toolhead = self.printer.lookup_object('toolhead')
+        kin = toolhead.get_kinematics()
+        for s in kin.get_steppers():
+            if s.get_trapq() is None:
+                continue
+            orig_sk = s.get_stepper_kinematics()
+            skew_sk = ffi_main.gc(ffi_lib.skew_correction_alloc(),
+                                  ffi_lib.free)
+            s.set_stepper_kinematics(skew_sk)
+            res = ffi_lib.skew_correction_set_sk(skew_sk, orig_sk)
+            if res < 0:
+                # Skew does not alter this stepper (eg, a Z stepper)
+                s.set_stepper_kinematics(orig_sk)
+                continue
+            self.orig_stepper_kinematics.append(orig_sk)
+            self.skew_stepper_kinematics.append(skew_sk)
     def _handle_connect(self):
+        if self.skew_stepper_kinematics:
+            return
         gcode_move = self.printer.lookup_object('gcode_move')
-        self.next_transform = gcode_move.set_move_transform(self, force=True)
+        gcode_move.set_affine_transform(self)
+        self.is_affine_transform = True
     def _load_storage(self, config):
         stored_profs = config.get_prefix_sections(self.name)
         # Remove primary skew_correction section, as it is not a stored profile
@@ -55,27 +88,29 @@ class PrinterSkew:
                 'xz_skew': profile.getfloat("xz_skew"),
                 'yz_skew': profile.getfloat("yz_skew"),
             }
-    def calc_skew(self, pos):
-        skewed_x = pos[0] - pos[1] * self.xy_factor \
-            - pos[2] * (self.xz_factor - (self.xy_factor * self.yz_factor))
-        skewed_y = pos[1] - pos[2] * self.yz_factor
-        return [skewed_x, skewed_y] + pos[2:]
-    def calc_unskew(self, pos):
-        skewed_x = pos[0] + pos[1] * self.xy_factor \
-            + pos[2] * self.xz_factor
-        skewed_y = pos[1] + pos[2] * self.yz_factor
-        return [skewed_x, skewed_y] + pos[2:]
-    def get_position(self):
-        return self.calc_unskew(self.next_transform.get_position())
-    def move(self, newpos, speed):
-        corrected_pos = self.calc_skew(newpos)
-        self.next_transform.move(corrected_pos, speed)
+    def get_affine(self):
+        return ([1., -self.xy_factor,
+                 -(self.xz_factor - (self.xy_factor * self.yz_factor)),
+                 0., 1., -self.yz_factor,
+                 0., 0., 1.],
+                [0., 0., 0.])
+    def _update_sk_params(self):
+        if not self.skew_stepper_kinematics:
+            if self.is_affine_transform:
+                gcode_move = self.printer.lookup_object('gcode_move')
+                gcode_move.update_affine_transform()
+            return
+        toolhead = self.printer.lookup_object('toolhead')
+        toolhead.flush_step_generation()
+        ffi_main, ffi_lib = chelper.get_ffi()
+        for skew_sk in self.skew_stepper_kinematics:
+            ffi_lib.skew_correction_set_params(
+                skew_sk, self.xy_factor, self.xz_factor, self.yz_factor)
     def _update_skew(self, xy_factor, xz_factor, yz_factor):
         self.xy_factor = xy_factor
         self.xz_factor = xz_factor
         self.yz_factor = yz_factor
-        gcode_move = self.printer.lookup_object('gcode_move')
-        gcode_move.reset_last_position()
+        self._update_sk_params()
     cmd_GET_CURRENT_SKEW_help = "Report current printer skew"
     def cmd_GET_CURRENT_SKEW(self, gcmd):
         out = "Current Printer Skew:"
@@ -114,6 +149,7 @@ class PrinterSkew:
                         "plane [%s]\n%s" % (plane, gcmd.get_commandline()))
                 factor = plane.lower() + '_factor'
                 setattr(self, factor, calc_skew_factor(*lengths))
+        self._update_sk_params()
     cmd_SKEW_PROFILE_help = "Profile management for skew_correction"
     def cmd_SKEW_PROFILE(self, gcmd):
         if gcmd.get('LOAD', None) is not None:
@@ -15,6 +15,38 @@ from . import bus
 REPORT_TIME = 0.300
 MAX_INVALID_COUNT = 3
 
+# Demultiplex batched thermocouple reports from one micro-controller
+class BatchResultReader:
+    def __init__(self, mcu):
+        self.mcu = mcu
+        self.sensors = {}
+        self.slot_oid = None
+        self.query_clock = None
+        mcu.register_config_callback(self._build_config)
+    def _build_config(self):
+        self.mcu.register_serial_response(
+            self._handle_batch_results,
+            "thermocouple_batch_results next_clock=%u data=%*s")
+    def register(self, oid, callback):
+        if self.slot_oid is None:
+            self.slot_oid = oid
+        self.sensors[oid] = callback
+    def get_query_clock(self):
+        # All sensors share one query slot so reads batch into one report
+        if self.query_clock is None:
+            self.query_clock = self.mcu.get_query_slot(self.slot_oid)
+        return self.query_clock
+    def _handle_batch_results(self, params):
+        next_clock = params['next_clock']
+        data = bytearray(params['data'])
+        for pos in range(0, len(data), 6):
+            callback = self.sensors.get(data[pos])
+            if callback is None:
+                continue
+            value = (data[pos+2] << 24) | (data[pos+3] << 16) \
+                | (data[pos+4] << 8) | data[pos+5]
+            callback(next_clock, value, data[pos+1])
+
 class SensorBase:
     def __init__(self, config, chip_type, config_cmd=None, spi_mode=1):
         self.printer = config.get_printer()
@@ -29,9 +61,9 @@ class SensorBase:
         self.mcu = mcu = self.spi.get_mcu()
         # Reader chip configuration
         self.oid = oid = mcu.create_oid()
-        mcu.register_serial_response(
-            self._handle_spi_response,
-            "thermocouple_result oid=%c next_clock=%u value=%u fault=%c", oid)
+        spi_temp = self.printer.lookup_object('spi_temperature')
+        self.batch_reader = spi_temp.get_batch_reader(mcu)
+        self.batch_reader.register(oid, self._handle_spi_response)
         mcu.register_config_callback(self._build_config)
     def setup_minmax(self, min_temp, max_temp):
         adc_range = [self.calc_adc(min_temp), self.calc_adc(max_temp)]
@@ -45,7 +77,7 @@ class SensorBase:
         self.mcu.add_config_cmd(
             "config_thermocouple oid=%u spi_oid=%u thermocouple_type=%s" % (
                 self.oid, self.spi.get_oid(), self.chip_type))
-        clock = self.mcu.get_query_slot(self.oid)
+        clock = self.batch_reader.get_query_clock()
         self._report_clock = self.mcu.seconds_to_clock(REPORT_TIME)
         self.mcu.add_config_cmd(
             "query_thermocouple oid=%u clock=%u rest_ticks=%u"
@@ -53,12 +85,12 @@ class SensorBase:
                 self.oid, clock, self._report_clock,
                 self.min_sample_value, self.max_sample_value,
                 MAX_INVALID_COUNT), is_init=True)
-    def _handle_spi_response(self, params):
-        if params['fault']:
-            self.handle_fault(params['value'], params['fault'])
+    def _handle_spi_response(self, next_clock, value, fault):
+        if fault:
+            self.handle_fault(value, fault)
             return
-        temp = self.calc_temp(params['value'])
-        next_clock      = self.mcu.clock32_to_clock64(params['next_clock'])
+        temp = self.calc_temp(value)
+        next_clock      = self.mcu.clock32_to_clock64(next_clock)
         last_read_clock = next_clock - self._report_clock
         last_read_time  = self.mcu.clock_to_print_time(last_read_clock)
         self._callback(last_read_time, temp)
@@ -350,8 +382,18 @@ Sensors = {
     "MAX31865": MAX31865,
 }
 
+class PrinterSPITemperature:
+    def __init__(self, config):
+        self.batch_readers = {}
+        # Register sensors
+        pheaters = config.get_printer().load_object(config, "heaters")
+        for name, klass in Sensors.items():
+            pheaters.add_sensor_factory(name, klass)
+    def get_batch_reader(self, mcu):
+        reader = self.batch_readers.get(mcu)
+        if reader is None:
+            self.batch_readers[mcu] = reader = BatchResultReader(mcu)
+        return reader
+
 def load_config(config):
-    # Register sensors
-    pheaters = config.get_printer().load_object(config, "heaters")
-    for name, klass in Sensors.items():
-        pheaters.add_sensor_factory(name, klass)
+    return PrinterSPITemperature(config)
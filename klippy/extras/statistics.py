@@ -54,6 +54,8 @@ class PrinterStats:
         self.printer = config.get_printer()
         self.reactor = reactor = self.printer.get_reactor()
         self.stats_timer = reactor.register_timer(self.generate_stats)
+        # Stats timing is not critical - allow batching with other wake-ups
+        reactor.set_timer_jitter(self.stats_timer, 0.250)
         self.stats_cb = []
         self.printer.register_event_handler("klippy:ready", self.handle_ready)
     def handle_ready(self):
@@ -64,9 +66,11 @@ class PrinterStats:
     def generate_stats(self, eventtime):
         with self.reactor.assert_no_pause():
             stats = [cb(eventtime) for cb in self.stats_cb]
+        stats_str = ' '.join([s[1] for s in stats if s[1]])
         if max([s[0] for s in stats]):
-            stats_str = ' '.join([s[1] for s in stats if s[1]])
             logging.info("Stats %.1f: %s", eventtime, stats_str)
+        self.printer.send_event("statistics:stats_sample",
+                                eventtime, stats_str)
         return eventtime + 1.
 
 def load_config(config):
@@ -0,0 +1,153 @@
+# Streaming of periodic statistics over the webhooks API
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import math
+from . import bulk_sensor
+
+# Number of aged sub-histograms making up the rolling window
+SUBWINDOW_COUNT = 10
+# Histogram bucket resolution (buckets per power of two)
+BUCKETS_PER_OCTAVE = 4
+
+# Stats fields reported with a per-mcu prefix (same convention as
+# scripts/graphstats.py - the primary 'mcu' prefix is stripped)
+APPLY_PREFIX = [
+    'mcu_awake', 'mcu_task_avg', 'mcu_task_stddev', 'bytes_write',
+    'bytes_read', 'bytes_retransmit', 'freq', 'adj',
+    'target', 'temp', 'pwm'
+]
+
+DEFAULT_FIELDS = [
+    'sysload', 'cputime', 'memavail', 'buffer_time', 'print_stall',
+    'bytes_write', 'bytes_read', 'bytes_retransmit', 'bytes_invalid',
+    'mcu_awake', 'srtt'
+]
+DEFAULT_COUNTER_FIELDS = [
+    'cputime', 'print_stall', 'bytes_write', 'bytes_read',
+    'bytes_retransmit', 'bytes_invalid'
+]
+
+# Rolling histogram of one stats field
+class FieldHistogram:
+    def __init__(self):
+        self.subwindows = [self._new_subwindow()
+                           for i in range(SUBWINDOW_COUNT)]
+    def _new_subwindow(self):
+        # Per-bucket counts plus [count, sum, min, max] summary
+        return ({}, [0, 0., None, None])
+    def note(self, value):
+        buckets, summary = self.subwindows[0]
+        if value > 0.:
+            bucket = int(math.floor(
+                BUCKETS_PER_OCTAVE * math.log(value, 2.)))
+            buckets[bucket] = buckets.get(bucket, 0) + 1
+        summary[0] += 1
+        summary[1] += value
+        if summary[2] is None or value < summary[2]:
+            summary[2] = value
+        if summary[3] is None or value > summary[3]:
+            summary[3] = value
+    def rotate(self):
+        self.subwindows.pop()
+        self.subwindows.insert(0, self._new_subwindow())
+    def report(self):
+        merged = {}
+        count = 0
+        total = 0.
+        vmin = vmax = None
+        for buckets, summary in self.subwindows:
+            for bucket, bcount in buckets.items():
+                merged[bucket] = merged.get(bucket, 0) + bcount
+            count += summary[0]
+            total += summary[1]
+            if summary[2] is not None and (vmin is None or summary[2] < vmin):
+                vmin = summary[2]
+            if summary[3] is not None and (vmax is None or summary[3] > vmax):
+                vmax = summary[3]
+        res = {'count': count, 'min': vmin, 'max': vmax,
+               'buckets': merged,
+               'bucket_base': 2. ** (1. / BUCKETS_PER_OCTAVE)}
+        if count:
+            res['avg'] = total / count
+        return res
+
+class PrinterStatsStream:
+    def __init__(self, config):
+        self.printer = config.get_printer()
+        self.fields = config.getlist('fields', DEFAULT_FIELDS)
+        self.counter_fields = set(config.getlist('counter_fields',
+                                                 DEFAULT_COUNTER_FIELDS))
+        window = config.getfloat('window', 600., above=0.)
+        self.subwindow_time = window / SUBWINDOW_COUNT
+        self.histograms = {f: FieldHistogram() for f in self.fields}
+        self.last_values = {}
+        self.last_sample = {}
+        self.pending_samples = []
+        self.next_rotate_time = 0.
+        self.printer.register_event_handler("statistics:stats_sample",
+                                            self._handle_stats_sample)
+        batch_interval = config.getfloat('batch_interval', 1., above=0.)
+        self.batch_bulk = bulk_sensor.BatchBulkHelper(
+            self.printer, self._process_batch,
+            batch_interval=batch_interval)
+        api_resp = {'header': ('time',) + tuple(self.fields)}
+        self.batch_bulk.add_mux_endpoint("stats_stream/dump_stats",
+                                         "name", None, api_resp)
+    def _parse_stats(self, stats_str):
+        # Parse 'key=value' pairs (with per-mcu prefix handling)
+        prefix = ""
+        keyparts = {}
+        for p in stats_str.split():
+            if '=' not in p:
+                prefix = p
+                if prefix == "mcu:":
+                    prefix = ''
+                continue
+            name, val = p.split('=', 1)
+            if name in APPLY_PREFIX:
+                name = prefix + name
+            try:
+                keyparts[name] = float(val)
+            except ValueError:
+                pass
+        return keyparts
+    def _handle_stats_sample(self, eventtime, stats_str):
+        # Age out old histogram data
+        if not self.next_rotate_time:
+            self.next_rotate_time = eventtime + self.subwindow_time
+        while eventtime >= self.next_rotate_time:
+            for hist in self.histograms.values():
+                hist.rotate()
+            self.next_rotate_time += self.subwindow_time
+        # Extract the tracked fields and update the histograms
+        keyparts = self._parse_stats(stats_str)
+        sample = {}
+        for field in self.fields:
+            value = keyparts.get(field)
+            if value is None:
+                continue
+            sample[field] = value
+            if field in self.counter_fields:
+                # Histogram the per-sample increments of counters
+                last_value = self.last_values.get(field)
+                self.last_values[field] = value
+                if last_value is None or value < last_value:
+                    continue
+                value = value - last_value
+            self.histograms[field].note(value)
+        self.last_sample = sample
+        self.pending_samples.append(
+            (eventtime,) + tuple(sample.get(f) for f in self.fields))
+    def _process_batch(self, eventtime):
+        samples = self.pending_samples
+        self.pending_samples = []
+        hists = {field: self.histograms[field].report()
+                 for field in self.fields}
+        return {'data': samples, 'histograms': hists}
+    def get_status(self, eventtime):
+        return {'last_stats': dict(self.last_sample)}
+
+def load_config(config):
+    return PrinterStatsStream(config)
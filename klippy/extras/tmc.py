@@ -359,6 +359,11 @@ class TMCCommandHelper:
                                    desc=self.cmd_SET_TMC_CURRENT_help)
     def _init_registers(self, print_time=None):
         # Send registers
+        set_registers = getattr(self.mcu_tmc, 'set_registers', None)
+        if set_registers is not None:
+            # Batched write of only the registers that changed
+            set_registers(dict(self.fields.registers), print_time)
+            return
         for reg_name in list(self.fields.registers.keys()):
             val = self.fields.registers[reg_name] # Val may change during loop
             self.mcu_tmc.set_register(reg_name, val, print_time)
@@ -366,6 +371,9 @@ class TMCCommandHelper:
     def cmd_INIT_TMC(self, gcmd):
         logging.info("INIT_TMC %s", self.name)
         print_time = self.printer.lookup_object('toolhead').get_last_move_time()
+        invalidate = getattr(self.mcu_tmc, 'invalidate_cache', None)
+        if invalidate is not None:
+            invalidate()
         self._init_registers(print_time)
     cmd_SET_TMC_FIELD_help = "Set a register field of a TMC driver"
     def cmd_SET_TMC_FIELD(self, gcmd):
@@ -450,6 +458,11 @@ class TMCCommandHelper:
         did_reset = self.echeck_helper.start_checks()
         if did_reset:
             self.mcu_phase_offset = None
+            # Driver lost power since last init - force a full rewrite
+            invalidate = getattr(self.mcu_tmc, 'invalidate_cache', None)
+            if invalidate is not None:
+                invalidate()
+                self._init_registers()
         # Calculate phase offset
         if self.mcu_phase_offset is not None:
             return
@@ -547,8 +560,14 @@ class TMCCommandHelper:
                 if reg_name not in self.read_registers:
                     gcmd.respond_info(self.fields.pretty_format(reg_name, val))
             gcmd.respond_info("========== Queried registers ==========")
+            get_batch = getattr(self.mcu_tmc, 'get_register_batch', None)
+            if get_batch is not None:
+                reg_vals = get_batch(self.read_registers)
+            else:
+                reg_vals = {rn: self.mcu_tmc.get_register(rn)
+                            for rn in self.read_registers}
             for reg_name in self.read_registers:
-                val = self.mcu_tmc.get_register(reg_name)
+                val = reg_vals[reg_name]
                 if self.read_translate is not None:
                     reg_name, val = self.read_translate(reg_name, val)
                 gcmd.respond_info(self.fields.pretty_format(reg_name, val))
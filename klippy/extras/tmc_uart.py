@@ -73,6 +73,10 @@ def lookup_tmc_uart_mutex(mcu):
 TMC_BAUD_RATE = 40000
 TMC_BAUD_RATE_AVR = 9000
 
+# Max register transactions in one mcu batch request (mcu buffer limits)
+TMC_UART_BATCH_MAX_READS = 4
+TMC_UART_BATCH_MAX_WRITES = 4
+
 # Code for sending messages on a TMC uart
 class MCU_TMC_uart_bitbang:
     def __init__(self, rx_pin_params, tx_pin_params, select_pins_desc):
@@ -88,7 +92,7 @@ class MCU_TMC_uart_bitbang:
             self.analog_mux = MCU_analog_mux(self.mcu, self.cmd_queue,
                                              select_pins_desc)
         self.instances = {}
-        self.tmcuart_send_cmd = None
+        self.tmcuart_send_cmd = self.tmcuart_batch_cmd = None
         self.mcu.register_config_callback(self.build_config)
     def build_config(self):
         baud = TMC_BAUD_RATE
@@ -103,6 +107,12 @@ class MCU_TMC_uart_bitbang:
             "tmcuart_send oid=%c write=%*s read=%c",
             "tmcuart_response oid=%c read=%*s", oid=self.oid,
             cq=self.cmd_queue, is_async=True)
+        if self.mcu.check_valid_response(
+                "tmcuart_batch_response oid=%c read=%*s"):
+            self.tmcuart_batch_cmd = self.mcu.lookup_query_command(
+                "tmcuart_batch_send oid=%c count=%c write=%*s read=%c",
+                "tmcuart_batch_response oid=%c read=%*s", oid=self.oid,
+                cq=self.cmd_queue, is_async=True)
     def register_instance(self, rx_pin_params, tx_pin_params,
                           select_pins_desc, addr):
         if (rx_pin_params['pin'] != self.rx_pin
@@ -187,6 +197,42 @@ class MCU_TMC_uart_bitbang:
             self.analog_mux.activate(instance_id)
         msg = self._encode_write(0xf5, addr, reg | 0x80, val)
         self.tmcuart_send_cmd.send([self.oid, msg, 0], minclock=minclock)
+    def have_batch(self):
+        return self.tmcuart_batch_cmd is not None
+    def reg_read_batch(self, instance_id, addr, regs):
+        # Read registers via mcu batch transactions (None if unsupported)
+        if self.tmcuart_batch_cmd is None:
+            return None
+        if self.analog_mux is not None:
+            self.analog_mux.activate(instance_id)
+        vals = []
+        for i in range(0, len(regs), TMC_UART_BATCH_MAX_READS):
+            group = regs[i:i+TMC_UART_BATCH_MAX_READS]
+            msg = bytearray()
+            for reg in group:
+                msg += self._encode_read(0xf5, addr, reg)
+            params = self.tmcuart_batch_cmd.send([self.oid, len(group),
+                                                  msg, 10])
+            data = bytearray(params['read'])
+            for j, reg in enumerate(group):
+                chunk = data[j*10:j*10+10]
+                if len(chunk) == 10:
+                    vals.append(self._decode_read(reg, bytes(chunk)))
+                else:
+                    # Batch aborted on a read timeout
+                    vals.append(None)
+        return vals
+    def reg_write_batch(self, instance_id, addr, reg_vals, print_time=None):
+        minclock = 0
+        if print_time is not None:
+            minclock = self.mcu.print_time_to_clock(print_time)
+        if self.analog_mux is not None:
+            self.analog_mux.activate(instance_id)
+        msg = bytearray()
+        for reg, val in reg_vals:
+            msg += self._encode_write(0xf5, addr, reg | 0x80, val)
+        self.tmcuart_batch_cmd.send([self.oid, len(reg_vals), msg, 0],
+                                    minclock=minclock)
     def get_mcu(self):
         return self.mcu
 
@@ -213,6 +259,10 @@ def lookup_tmc_uart_bitbang(config, max_addr):
                                              select_pins_desc, addr)
     return instance_id, addr, mcu_uart
 
+# Registers with write-one-to-clear semantics that must never be
+# suppressed by the write cache
+UNCACHED_REGISTERS = frozenset(['GSTAT'])
+
 # Helper code for communicating via TMC uart
 class MCU_TMC_uart:
     def __init__(self, config, name_to_reg, fields, max_addr, tmc_frequency):
@@ -221,6 +271,8 @@ class MCU_TMC_uart:
         self.name_to_reg = name_to_reg
         self.fields = fields
         self.ifcnt = None
+        # Cache of last written register values (for write suppression)
+        self.reg_cache = {}
         self.instance_id, self.addr, self.mcu_uart = lookup_tmc_uart_bitbang(
             config, max_addr)
         self.mutex = self.mcu_uart.mutex
@@ -245,22 +297,82 @@ class MCU_TMC_uart:
             return self._do_get_register(reg_name)
     def get_register(self, reg_name):
         return self.get_register_raw(reg_name)['data']
-    def set_register(self, reg_name, val, print_time=None):
+    def get_register_batch(self, reg_names):
+        # Read a list of registers, using mcu batching when available
+        vals = [None] * len(reg_names)
+        with self.mutex:
+            if self.printer.get_start_args().get('debugoutput') is None:
+                regs = [self.name_to_reg[rn] for rn in reg_names]
+                batch = self.mcu_uart.reg_read_batch(self.instance_id,
+                                                     self.addr, regs)
+                if batch is not None:
+                    vals = batch
+            res = {}
+            for reg_name, val in zip(reg_names, vals):
+                if val is None:
+                    val = self._do_get_register(reg_name)['data']
+                res[reg_name] = val
+            return res
+    def _do_set_register(self, reg_name, val, print_time):
         reg = self.name_to_reg[reg_name]
+        for retry in range(5):
+            ifcnt = self.ifcnt
+            if ifcnt is None:
+                self.ifcnt = ifcnt = self._do_get_register("IFCNT")['data']
+            self.mcu_uart.reg_write(self.instance_id, self.addr, reg, val,
+                                    print_time)
+            self.ifcnt = self._do_get_register("IFCNT")['data']
+            if self.ifcnt == (ifcnt + 1) & 0xff:
+                self.reg_cache[reg_name] = val
+                return
+        self.reg_cache.clear()
+        raise self.printer.command_error(
+            "Unable to write tmc uart '%s' register %s" % (self.name, reg_name))
+    def set_register(self, reg_name, val, print_time=None):
         if self.printer.get_start_args().get('debugoutput') is not None:
             return
         with self.mutex:
-            for retry in range(5):
-                ifcnt = self.ifcnt
-                if ifcnt is None:
-                    self.ifcnt = ifcnt = self._do_get_register("IFCNT")['data']
-                self.mcu_uart.reg_write(self.instance_id, self.addr, reg, val,
-                                        print_time)
-                self.ifcnt = self._do_get_register("IFCNT")['data']
-                if self.ifcnt == (ifcnt + 1) & 0xff:
-                    return
-        raise self.printer.command_error(
-            "Unable to write tmc uart '%s' register %s" % (self.name, reg_name))
+            if (reg_name not in UNCACHED_REGISTERS
+                and self.reg_cache.get(reg_name) == val):
+                return
+            self._do_set_register(reg_name, val, print_time)
+    def _do_set_register_batch(self, items, print_time):
+        # Returns items that still need to be written individually
+        pos = 0
+        while pos < len(items):
+            group = items[pos:pos+TMC_UART_BATCH_MAX_WRITES]
+            ifcnt = self.ifcnt
+            if ifcnt is None:
+                self.ifcnt = ifcnt = self._do_get_register("IFCNT")['data']
+            reg_vals = [(self.name_to_reg[rn], val) for rn, val in group]
+            self.mcu_uart.reg_write_batch(self.instance_id, self.addr,
+                                          reg_vals, print_time)
+            self.ifcnt = self._do_get_register("IFCNT")['data']
+            if self.ifcnt != (ifcnt + len(group)) & 0xff:
+                # Batch did not fully apply - rewrite remainder one at a time
+                return items[pos:]
+            for reg_name, val in group:
+                self.reg_cache[reg_name] = val
+            pos += len(group)
+        return []
+    def set_registers(self, reg_map, print_time=None):
+        # Write multiple registers, skipping those already at their value
+        items = [(rn, val) for rn, val in reg_map.items()
+                 if rn in UNCACHED_REGISTERS
+                 or self.reg_cache.get(rn) != val]
+        if not items:
+            return
+        if self.printer.get_start_args().get('debugoutput') is not None:
+            return
+        with self.mutex:
+            if self.mcu_uart.have_batch():
+                items = self._do_set_register_batch(items, print_time)
+            for reg_name, val in items:
+                self._do_set_register(reg_name, val, print_time)
+    def invalidate_cache(self):
+        # Force subsequent writes to be sent (e.g. after a driver reset)
+        self.reg_cache.clear()
+        self.ifcnt = None
     def get_tmc_frequency(self):
         return self.tmc_frequency
     def get_mcu(self):
@@ -236,6 +236,9 @@ class MCU_SosFilter:
 # Trigger Analog
 ######################################################################
 
+# Fractional bits in linearization segment gains
+LINEARIZE_FRAC_BITS = 16
+
 # MCU_trigger_analog is the interface to `trigger_analog` on the MCU
 class MCU_trigger_analog:
     MONITOR_MAX = 3
@@ -250,9 +253,15 @@ class MCU_trigger_analog:
         # Raw range checking
         self._raw_min = self._raw_max = 0
         self._last_range_args = None
+        # Raw value linearization and drift correction
+        self._linearize = []
+        self._last_linearize_args = {}
+        self._drift = 0
+        self._last_drift_args = None
         # Trigger type
         self._trigger_type = "unspecified"
         self._trigger_value = 0.
+        self._trigger_arm_value = 0.
         self._last_trigger_args = None
         # Error codes from MCU
         self._error_map = {}
@@ -261,6 +270,7 @@ class MCU_trigger_analog:
         self._oid = self._mcu.create_oid()
         self._home_cmd = self._query_state_cmd = None
         self._set_raw_range_cmd = self._set_trigger_cmd = None
+        self._set_linearize_cmd = self._set_drift_cmd = None
         self._mcu.register_config_callback(self._build_config)
 
     def setup_sos_filter(self, sos_filter):
@@ -284,7 +294,12 @@ class MCU_trigger_analog:
             cq=cmd_queue)
         self._set_trigger_cmd = self._mcu.lookup_command(
             "trigger_analog_set_trigger oid=%c trigger_analog_type=%c"
-            " trigger_value=%i", cq=cmd_queue)
+            " trigger_value=%i trigger_arm_value=%i", cq=cmd_queue)
+        self._set_linearize_cmd = self._mcu.lookup_command(
+            "trigger_analog_set_linearize oid=%c index=%c count=%c"
+            " raw_start=%i gain=%i offset=%i", cq=cmd_queue)
+        self._set_drift_cmd = self._mcu.lookup_command(
+            "trigger_analog_set_drift oid=%c drift=%i", cq=cmd_queue)
         self._home_cmd = self._mcu.lookup_command(
             "trigger_analog_home oid=%c trsync_oid=%c trigger_reason=%c"
             " error_reason=%c clock=%u monitor_ticks=%u monitor_max=%u",
@@ -309,14 +324,35 @@ class MCU_trigger_analog:
     def get_last_trigger_time(self):
         return self._last_trigger_time
 
-    def set_trigger(self, trigger_type, trigger_value):
+    def set_trigger(self, trigger_type, trigger_value, arm_value=0.):
         self._trigger_type = trigger_type
         self._trigger_value = trigger_value
+        self._trigger_arm_value = arm_value
 
     def set_raw_range(self, raw_min, raw_max):
         self._raw_min = raw_min
         self._raw_max = raw_max
 
+    def set_linearize(self, segments):
+        # Each segment is a (raw_start, gain, offset) tuple describing a
+        # piecewise linear conversion of raw values to trigger units
+        self._linearize = [
+            (int(raw_start), to_fixed_32(gain, LINEARIZE_FRAC_BITS),
+             to_fixed_32(offset))
+            for raw_start, gain, offset in segments]
+
+    def set_drift(self, drift):
+        # Update drift correction offset (may be called while homing)
+        self._drift = int(round(drift))
+        if self._set_drift_cmd is not None:
+            self._send_drift()
+
+    def _send_drift(self):
+        args = [self._oid, self._drift]
+        if args != self._last_drift_args:
+            self._set_drift_cmd.send(args)
+            self._last_drift_args = args
+
     def _reset_filter(self):
         # Update raw range parameters in mcu (if they have changed)
         args = [self._oid, self._raw_min, self._raw_max]
@@ -324,10 +360,23 @@ class MCU_trigger_analog:
             self._set_raw_range_cmd.send(args)
             self._last_range_args = args
         # Update trigger in mcu (if it has changed)
-        args = [self._oid, self._trigger_type, to_fixed_32(self._trigger_value)]
+        args = [self._oid, self._trigger_type, to_fixed_32(self._trigger_value),
+                to_fixed_32(self._trigger_arm_value)]
         if args != self._last_trigger_args:
             self._set_trigger_cmd.send(args)
             self._last_trigger_args = args
+        # Update linearization segments in mcu (if they have changed)
+        count = len(self._linearize)
+        seg_args = [(self._oid, i, count) + seg
+                    for i, seg in enumerate(self._linearize)]
+        if not seg_args:
+            seg_args = [(self._oid, 0, 0, 0, 0, 0)]
+        for args in seg_args:
+            if self._last_linearize_args.get(args[1]) != args:
+                self._set_linearize_cmd.send(args)
+                self._last_linearize_args[args[1]] = args
+        # Update drift offset in mcu (if it has changed)
+        self._send_drift()
         # Update sos filter in mcu
         self._sos_filter.reset_filter()
 
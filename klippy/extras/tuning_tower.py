@@ -14,6 +14,7 @@ class TuningTower:
         self.last_position = [0., 0., 0., 0.]
         self.last_z = self.start = self.factor = self.band = 0.
         self.last_command_value = None
+        self.band_range = (0., 0.)
         self.command_fmt = ""
         self.gcode_move = self.printer.load_object(config, "gcode_move")
         # Register command
@@ -47,6 +48,7 @@ class TuningTower:
         self.normal_transform = nt
         self.last_z = -99999999.9
         self.last_command_value = None
+        self.band_range = (0., 0.)
         self.get_position()
         message_parts = []
         message_parts.append("start=%.6f" % (self.start,))
@@ -74,27 +76,44 @@ class TuningTower:
         if self.band:
             z = (math.floor(z / self.band) + .5) * self.band
         return self.start + z * self.factor
+    def calc_band(self, z):
+        # Determine the gcode z range over which calc_value() is constant
+        if self.skip and z < self.skip:
+            return (-99999999.9, self.skip)
+        size = self.step_height if self.step_height else self.band
+        if not size:
+            # Value varies continuously with z - recalculate on any change
+            return (z, z)
+        band_start = self.skip + math.floor((z - self.skip) / size) * size
+        return (band_start, band_start + size)
     def move(self, newpos, speed):
-        normal_transform = self.normal_transform
-        if (newpos[3] > self.last_position[3] and newpos[2] != self.last_z
-            and newpos[:3] != self.last_position[:3]):
+        last_position = self.last_position
+        if (newpos[3] > last_position[3] and newpos[2] != self.last_z
+            and (newpos[0] != last_position[0]
+                 or newpos[1] != last_position[1]
+                 or newpos[2] != last_position[2])):
             # Extrusion move at new z height
             z = newpos[2]
             if z < self.last_z - CANCEL_Z_DELTA:
                 # Extrude at a lower z height - probably start of new print
                 self.end_test()
             else:
-                # Process update
-                gcode_z = self.gcode_move.get_status()['gcode_position'].z
-                newval = self.calc_value(gcode_z)
                 self.last_z = z
-                if newval != self.last_command_value:
-                    self.last_command_value = newval
-                    self.gcode.run_script_from_command(self.command_fmt
-                                                       % (newval,))
+                # The caller passes gcode_move's position - the gcode z
+                # height is the commanded z less the accumulated offsets
+                gcode_z = z - self.gcode_move.base_position[2]
+                lo, hi = self.band_range
+                if not (lo <= gcode_z < hi):
+                    # Crossed into a new band - process update
+                    self.band_range = self.calc_band(gcode_z)
+                    newval = self.calc_value(gcode_z)
+                    if newval != self.last_command_value:
+                        self.last_command_value = newval
+                        self.gcode.run_script_from_command(self.command_fmt
+                                                           % (newval,))
         # Forward move to actual handler
         self.last_position[:] = newpos
-        normal_transform.move(newpos, speed)
+        self.normal_transform.move(newpos, speed)
     def end_test(self):
         self.gcode.respond_info("Ending tuning test mode")
         self.gcode_move.set_move_transform(self.normal_transform, force=True)
@@ -3,7 +3,8 @@
 # Copyright (C) 2018-2024  Kevin O'Connor <kevin@koconnor.net>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
-import os, sys, logging, io
+import os, sys, logging, io, bisect, threading, collections
+import gcode
 
 VALID_GCODE_EXTS = ['gcode', 'g', 'gco']
 
@@ -13,6 +14,150 @@ DEFAULT_ERROR_GCODE = """
 {% endif %}
 """
 
+READ_CHUNK_SIZE = 8192
+READ_AHEAD_LINES = 2048
+
+# Background file reader with a decoded command buffer and marker
+# index.  Lines are tokenized on the reader thread so the reactor
+# thread can spend its time planning moves - the buffer acts as a
+# bounded ring of decoded commands with backpressure on the reader.
+class FileReadAhead:
+    def __init__(self, filename):
+        self.filename = filename
+        self.cond = threading.Condition()
+        self.buffer = collections.deque()
+        self.seek_pos = 0
+        self.need_seek = True
+        self.eof = self.shutdown = False
+        self.error = None
+        self.file_index = None
+        self.thread = threading.Thread(target=self._reader_thread)
+        self.thread.daemon = True
+        self.thread.start()
+    def _line_end(self, pos, line):
+        if sys.version_info.major >= 3:
+            return pos + len(line.encode()) + 1
+        return pos + len(line) + 1
+    def _build_index(self, f):
+        # One-time scan recording file offsets of layer changes and
+        # exclude_object markers
+        layers = []
+        objects = {}
+        pos = 0
+        partial_input = ""
+        while not self.shutdown:
+            data = f.read(READ_CHUNK_SIZE)
+            if not data:
+                break
+            lines = data.split('\n')
+            lines[0] = partial_input + lines[0]
+            partial_input = lines.pop()
+            for line in lines:
+                if line.startswith(';LAYER'):
+                    layers.append(pos)
+                elif line.startswith('EXCLUDE_OBJECT_START'):
+                    parts = line.split()
+                    for part in parts[1:]:
+                        if part.startswith('NAME='):
+                            objects.setdefault(part[5:], []).append(pos)
+                            break
+                pos = self._line_end(pos, line)
+        return {'layers': layers, 'objects': objects}
+    def _reader_thread(self):
+        parser = gcode.GCodeLineParser()
+        try:
+            f = io.open(self.filename, 'r', newline='')
+        except:
+            logging.exception("virtual_sdcard readahead open")
+            with self.cond:
+                self.error = "Unable to open file"
+                self.cond.notify_all()
+            return
+        try:
+            index = self._build_index(f)
+        except:
+            logging.exception("virtual_sdcard index")
+            index = {'layers': [], 'objects': {}}
+        with self.cond:
+            self.file_index = index
+            self.cond.notify_all()
+        pos = 0
+        partial_input = ""
+        while 1:
+            with self.cond:
+                while (len(self.buffer) >= READ_AHEAD_LINES
+                       and not self.need_seek and not self.shutdown):
+                    self.cond.wait()
+                if self.shutdown:
+                    break
+                if self.need_seek:
+                    pos = self.seek_pos
+                    self.need_seek = False
+                    self.eof = False
+                    self.buffer.clear()
+                    partial_input = ""
+                    try:
+                        f.seek(pos)
+                    except:
+                        logging.exception("virtual_sdcard readahead seek")
+                        self.error = "Unable to seek file"
+                        self.cond.notify_all()
+                        break
+                if self.eof:
+                    self.cond.wait()
+                    continue
+            try:
+                data = f.read(READ_CHUNK_SIZE)
+            except:
+                logging.exception("virtual_sdcard readahead read")
+                with self.cond:
+                    self.error = "Unable to read file"
+                    self.cond.notify_all()
+                break
+            with self.cond:
+                if self.need_seek or self.shutdown:
+                    continue
+                if not data:
+                    self.eof = True
+                    self.cond.notify_all()
+                    continue
+                lines = data.split('\n')
+                lines[0] = partial_input + lines[0]
+                partial_input = lines.pop()
+                for line in lines:
+                    pos = self._line_end(pos, line)
+                    self.buffer.append((line, pos, parser.parse(line)))
+                self.cond.notify_all()
+        f.close()
+    def get_line(self):
+        # Return (line, end_position, decoded) or None if no data is
+        # buffered (decoded is None for lines needing fallback parsing)
+        with self.cond:
+            if not self.buffer:
+                return None
+            entry = self.buffer.popleft()
+            self.cond.notify()
+            return entry
+    def is_eof(self):
+        with self.cond:
+            return self.eof and not self.buffer
+    def get_error(self):
+        with self.cond:
+            return self.error
+    def get_file_index(self):
+        with self.cond:
+            return self.file_index
+    def seek(self, pos):
+        with self.cond:
+            self.seek_pos = pos
+            self.need_seek = True
+            self.cond.notify()
+    def stop(self):
+        with self.cond:
+            self.shutdown = True
+            self.cond.notify()
+        self.thread.join(1.)
+
 class VirtualSD:
     def __init__(self, config):
         self.printer = config.get_printer()
@@ -20,6 +165,7 @@ class VirtualSD:
         sd = config.get('path')
         self.sdcard_dirname = os.path.normpath(os.path.expanduser(sd))
         self.current_file = None
+        self.fileread = None
         self.file_position = self.file_size = 0
         # Print Stat Tracking
         self.print_stats = self.printer.load_object(config, 'print_stats')
@@ -124,16 +270,22 @@ class VirtualSD:
             self.do_pause()
             self.current_file.close()
             self.current_file = None
+            self._stop_fileread()
             self.print_stats.note_cancel()
         self.file_position = self.file_size = 0
     # G-Code commands
     def cmd_error(self, gcmd):
         raise gcmd.error("SD write not supported")
+    def _stop_fileread(self):
+        if self.fileread is not None:
+            self.fileread.stop()
+            self.fileread = None
     def _reset_file(self):
         if self.current_file is not None:
             self.do_pause()
             self.current_file.close()
             self.current_file = None
+        self._stop_fileread()
         self.file_position = self.file_size = 0
         self.print_stats.reset()
         self.printer.send_event("virtual_sdcard:reset_file")
@@ -193,9 +345,30 @@ class VirtualSD:
         gcmd.respond_raw("File opened:%s Size:%d" % (filename, fsize))
         gcmd.respond_raw("File selected")
         self.current_file = f
+        self.fileread = FileReadAhead(fname)
         self.file_position = 0
         self.file_size = fsize
         self.print_stats.set_current_file(filename)
+    def get_file_index(self):
+        # Marker index (may be None while the background scan completes)
+        if self.fileread is None:
+            return None
+        return self.fileread.get_file_index()
+    def lookup_layer_position(self, layer):
+        index = self.get_file_index()
+        if index is None or layer >= len(index['layers']):
+            return None
+        return index['layers'][layer]
+    def lookup_object_position(self, name, file_pos=0):
+        # Find first EXCLUDE_OBJECT_START for name at or after file_pos
+        index = self.get_file_index()
+        if index is None:
+            return None
+        offsets = index['objects'].get(name, [])
+        i = bisect.bisect_left(offsets, file_pos)
+        if i >= len(offsets):
+            return None
+        return offsets[i]
     def cmd_M24(self, gcmd):
         # Start/resume SD print
         self.do_resume()
@@ -225,52 +398,42 @@ class VirtualSD:
     def work_handler(self, eventtime):
         logging.info("Starting SD card print (position %d)", self.file_position)
         self.reactor.unregister_timer(self.work_timer)
-        try:
-            self.current_file.seek(self.file_position)
-        except:
-            logging.exception("virtual_sdcard seek")
-            self.work_timer = None
-            return self.reactor.NEVER
+        self.fileread.seek(self.file_position)
         self.print_stats.note_start()
         gcode_mutex = self.gcode.get_mutex()
-        partial_input = ""
-        lines = []
+        dispatch_count = 0
         error_message = None
         while not self.must_pause_work:
-            if not lines:
-                # Read more data
-                try:
-                    data = self.current_file.read(8192)
-                except:
-                    logging.exception("virtual_sdcard read")
+            # Pause if any other request is pending in the gcode class
+            if gcode_mutex.test():
+                self.reactor.pause(self.reactor.monotonic() + 0.050)
+                continue
+            entry = self.fileread.get_line()
+            if entry is None:
+                if self.fileread.get_error() is not None:
+                    logging.error("virtual_sdcard read: %s",
+                                  self.fileread.get_error())
                     break
-                if not data:
+                if self.fileread.is_eof():
                     # End of file
                     self.current_file.close()
                     self.current_file = None
+                    self._stop_fileread()
                     logging.info("Finished SD card print")
                     self.gcode.respond_raw("Done printing file")
                     break
-                lines = data.split('\n')
-                lines[0] = partial_input + lines[0]
-                partial_input = lines.pop()
-                lines.reverse()
-                self.reactor.pause(self.reactor.NOW)
-                continue
-            # Pause if any other request is pending in the gcode class
-            if gcode_mutex.test():
-                self.reactor.pause(self.reactor.monotonic() + 0.050)
+                # Wait for the read-ahead thread to buffer more data
+                self.reactor.pause(self.reactor.monotonic() + 0.001)
                 continue
             # Dispatch command
             self.cmd_from_sd = True
-            line = lines.pop()
-            if sys.version_info.major >= 3:
-                next_file_position = self.file_position + len(line.encode()) + 1
-            else:
-                next_file_position = self.file_position + len(line) + 1
+            line, next_file_position, decoded = entry
             self.next_file_position = next_file_position
             try:
-                self.gcode.run_script(line)
+                if decoded is not None:
+                    self.gcode.run_decoded(decoded)
+                else:
+                    self.gcode.run_script(line)
             except self.gcode.error as e:
                 error_message = str(e)
                 try:
@@ -285,14 +448,10 @@ class VirtualSD:
             self.file_position = self.next_file_position
             # Do we need to skip around?
             if self.next_file_position != next_file_position:
-                try:
-                    self.current_file.seek(self.file_position)
-                except:
-                    logging.exception("virtual_sdcard seek")
-                    self.work_timer = None
-                    return self.reactor.NEVER
-                lines = []
-                partial_input = ""
+                self.fileread.seek(self.file_position)
+            dispatch_count += 1
+            if not dispatch_count % 128:
+                self.reactor.pause(self.reactor.NOW)
         logging.info("Exiting SD card print (position %d)", self.file_position)
         self.work_timer = None
         self.cmd_from_sd = False
@@ -0,0 +1,53 @@
+# Report reactor timer wake-up sources (for idle power diagnostics)
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+
+class WakeupAudit:
+    def __init__(self, config):
+        self.printer = config.get_printer()
+        self.reactor = self.printer.get_reactor()
+        self.last_fires = {}
+        self.last_time = None
+        gcode = self.printer.lookup_object('gcode')
+        gcode.register_command("WAKEUP_AUDIT", self.cmd_WAKEUP_AUDIT,
+                               desc=self.cmd_WAKEUP_AUDIT_help)
+    def _sample(self):
+        # Aggregate fire counts by callback name (transient reactor
+        # pause timers share a name and are summed)
+        fires = {}
+        jitters = {}
+        for t in self.reactor.get_timer_stats():
+            fires[t['name']] = fires.get(t['name'], 0) + t['fires']
+            jitters[t['name']] = t['jitter']
+        return fires, jitters
+    cmd_WAKEUP_AUDIT_help = "Report reactor timer wake-ups by source rate"
+    def cmd_WAKEUP_AUDIT(self, gcmd):
+        eventtime = self.reactor.monotonic()
+        fires, jitters = self._sample()
+        if self.last_time is None:
+            self.last_fires = fires
+            self.last_time = eventtime
+            gcmd.respond_info("Wakeup audit started - rerun WAKEUP_AUDIT"
+                              " to report rates")
+            return
+        interval = eventtime - self.last_time
+        rates = [(float(fires[name] - self.last_fires.get(name, 0))
+                  / interval, name)
+                 for name in fires]
+        rates.sort(reverse=True)
+        lines = ["Reactor wake-ups over last %.1fs:" % (interval,)]
+        total = 0.
+        for rate, name in rates:
+            total += rate
+            if rate > 0.:
+                lines.append("%8.1f/s jitter=%.3f %s"
+                             % (rate, jitters[name], name))
+        lines.append("Total timer wake-ups: %.1f/s" % (total,))
+        self.last_fires = fires
+        self.last_time = eventtime
+        gcmd.respond_info("\n".join(lines))
+
+def load_config(config):
+    return WakeupAudit(config)
@@ -0,0 +1,147 @@
+#!/usr/bin/env python2
+# Host multiple printers in a single klippy process
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import sys, os, gc, optparse, logging, time, threading
+import util, reactor, queuelogger
+import klippy
+
+# Running several Printer instances in one process shares the python
+# interpreter, the imported modules, and the read-only chelper library
+# between printers.  Each printer gets its own reactor running on a
+# dedicated thread (the reactors block in poll() and cannot share a
+# thread), its own pseudo-tty, and its own api server socket.
+
+# Forward rollover info to a shared background logger with a
+# per-printer prefix so printers do not clobber each other's entries
+class FarmLogger:
+    def __init__(self, bglogger, name):
+        self.bglogger = bglogger
+        self.name = name
+        self.known_names = set()
+    def set_rollover_info(self, name, info):
+        self.known_names.add(name)
+        self.bglogger.set_rollover_info("%s:%s" % (self.name, name), info)
+    def clear_rollover_info(self):
+        for name in self.known_names:
+            self.bglogger.set_rollover_info("%s:%s" % (self.name, name), None)
+        self.known_names.clear()
+
+class PrinterInstance:
+    def __init__(self, name, config_file, options, bglogger, base_start_args):
+        self.name = name
+        self.bglogger = bglogger
+        if bglogger is not None:
+            self.farm_logger = FarmLogger(bglogger, name)
+        else:
+            self.farm_logger = None
+        self.start_args = dict(base_start_args)
+        self.start_args['config_file'] = config_file
+        self.start_args['printer_name'] = name
+        self.start_args['gcode_fd'] = util.create_pty(
+            options.inputtty % (name,))
+        if options.apiserver is not None:
+            self.start_args['apiserver'] = options.apiserver % (name,)
+        self.run_result = None
+        self.thread = threading.Thread(target=self._run, name=name)
+    def start(self):
+        self.thread.start()
+    def join(self):
+        self.thread.join()
+    def _run(self):
+        # Per-printer variant of the restart loop in klippy.main()
+        while 1:
+            if self.farm_logger is not None:
+                self.farm_logger.clear_rollover_info()
+            gc.collect()
+            main_reactor = reactor.Reactor(gc_checking=True)
+            printer = klippy.Printer(main_reactor, self.farm_logger,
+                                     self.start_args)
+            res = printer.run()
+            if res in ['exit', 'error_exit']:
+                break
+            time.sleep(1.)
+            main_reactor.finalize()
+            main_reactor = printer = None
+            logging.info("Restarting printer %s", self.name)
+            self.start_args['start_reason'] = res
+        self.run_result = res
+
+def main():
+    usage = "%prog [options] <name=config file> ..."
+    opts = optparse.OptionParser(usage)
+    opts.add_option("-I", "--input-tty", dest="inputtty",
+                    default='/tmp/printer_%s',
+                    help="input tty name template; %s is replaced with the"
+                    " printer name (default is /tmp/printer_%s)")
+    opts.add_option("-a", "--api-server", dest="apiserver",
+                    help="api server unix domain socket filename template;"
+                    " %s is replaced with the printer name")
+    opts.add_option("-l", "--logfile", dest="logfile",
+                    help="write log to file instead of stderr")
+    opts.add_option("-v", action="store_true", dest="verbose",
+                    help="enable debug messages")
+    options, args = opts.parse_args()
+    if not args:
+        opts.error("At least one printer must be specified")
+    printer_defs = []
+    for arg in args:
+        if '=' not in arg:
+            opts.error("Printer argument '%s' is not in"
+                       " name=config_file format" % (arg,))
+        name, config_file = arg.split('=', 1)
+        if name in [n for n, cf in printer_defs]:
+            opts.error("Duplicate printer name '%s'" % (name,))
+        printer_defs.append((name, config_file))
+    for optname in ['inputtty', 'apiserver']:
+        template = getattr(options, optname)
+        if template is not None and '%s' not in template:
+            opts.error("Option --%s must contain %%s" % (optname,))
+
+    debuglevel = logging.INFO
+    if options.verbose:
+        debuglevel = logging.DEBUG
+    bglogger = None
+    if options.logfile:
+        bglogger = queuelogger.setup_bg_logging(options.logfile, debuglevel)
+    else:
+        logging.getLogger().setLevel(debuglevel)
+    # Attribute shared log messages to the originating printer thread
+    log_format = logging.Formatter('%(threadName)s: %(message)s')
+    if bglogger is not None:
+        bglogger.setFormatter(log_format)
+    else:
+        stderr_handler = logging.StreamHandler()
+        stderr_handler.setFormatter(log_format)
+        logging.getLogger().addHandler(stderr_handler)
+    logging.info("Starting Klippy farm with %d printers...",
+                 len(printer_defs))
+    base_start_args = {'start_reason': 'startup'}
+    if options.logfile:
+        base_start_args['log_file'] = options.logfile
+    versions = klippy.collect_version_info(base_start_args)
+    if bglogger is not None:
+        bglogger.set_rollover_info('versions', versions)
+        logging.info(versions)
+    else:
+        logging.warning("No log file specified!"
+                        " Severe timing issues may result!")
+    gc.disable()
+
+    # Start the printers and wait for all of them to exit
+    instances = [PrinterInstance(name, config_file, options,
+                                 bglogger, base_start_args)
+                 for name, config_file in printer_defs]
+    for inst in instances:
+        inst.start()
+    for inst in instances:
+        inst.join()
+
+    if bglogger is not None:
+        bglogger.stop()
+
+    if 'error_exit' in [inst.run_result for inst in instances]:
+        sys.exit(-1)
+
+if __name__ == '__main__':
+    main()
@@ -3,7 +3,8 @@
 # Copyright (C) 2016-2025  Kevin O'Connor <kevin@koconnor.net>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
-import os, re, logging, collections, shlex, operator
+import os, re, math, logging, collections, shlex, operator
+import chelper
 
 class CommandError(Exception):
     pass
@@ -23,11 +24,13 @@ class Coord(tuple):
 # Class for handling gcode command parameters (gcmd)
 class GCodeCommand:
     error = CommandError
-    def __init__(self, gcode, command, commandline, params, need_ack):
+    def __init__(self, gcode, command, commandline, params, need_ack,
+                 cfloats=None):
         self._command = command
         self._commandline = commandline
         self._params = params
         self._need_ack = need_ack
+        self._cfloats = cfloats
         # Method wrappers
         self.respond_info = gcode.respond_info
         self.respond_raw = gcode.respond_raw
@@ -70,11 +73,16 @@ class GCodeCommand:
                 raise self.error("Error on '%s': missing %s"
                                  % (self._commandline, name))
             return default
-        try:
-            value = parser(value)
-        except:
-            raise self.error("Error on '%s': unable to parse %s"
-                             % (self._commandline, value))
+        cfloats = self._cfloats
+        if parser is float and cfloats is not None and name in cfloats:
+            # Use value already parsed by the C tokenizer
+            value = cfloats[name]
+        else:
+            try:
+                value = parser(value)
+            except:
+                raise self.error("Error on '%s': unable to parse %s"
+                                 % (self._commandline, value))
         if minval is not None and value < minval:
             raise self.error("Error on '%s': %s must have minimum of %s"
                              % (self._commandline, name, minval))
@@ -95,6 +103,50 @@ class GCodeCommand:
         return self.get(name, default, parser=float, minval=minval,
                         maxval=maxval, above=above, below=below)
 
+# Decode gcode lines outside of command dispatch (may be used from a
+# background thread to fill a ring of decoded commands ahead of the
+# planner).  Produces entries for GCodeDispatch.run_decoded().
+class GCodeLineParser:
+    def __init__(self):
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.max_params = 32
+        self.params = self.ffi_main.new('struct gc_param[]', self.max_params)
+        self.cmd_bounds = self.ffi_main.new('int[2]')
+    def parse(self, line):
+        # Returns (command, commandline, params, cfloats) or None if
+        # the line requires the fallback parser in _process_commands()
+        line = origline = line.strip()
+        cpos = line.find(';')
+        if cpos >= 0:
+            line = line[:cpos]
+        upper = line.upper()
+        try:
+            data = upper.encode('ascii')
+        except UnicodeEncodeError:
+            return None
+        count = self.ffi_lib.gcodeparse_line(
+            data, len(data), self.params, self.max_params, self.cmd_bounds)
+        if count < 0:
+            return None
+        cmd = upper[self.cmd_bounds[0]:self.cmd_bounds[1]]
+        params = {}
+        cfloats = {}
+        gcp_params = self.params
+        for i in range(count):
+            p = gcp_params[i]
+            key = upper[p.key_pos:p.key_pos+p.key_len]
+            params[key] = upper[p.value_pos:p.value_pos+p.value_len]
+            if p.fvalid:
+                cfloats[key] = p.fvalue
+            elif key in cfloats:
+                del cfloats[key]
+        return (cmd, origline, params, cfloats)
+
+# Minimum time between repeats of an identical "//" output line
+OUTPUT_REPEAT_TIME = 0.250
+# Maximum number of buffers to pass to a single writev call
+WRITEV_MAX_COUNT = 1024
+
 # Parse and dispatch G-Code commands
 class GCodeDispatch:
     error = CommandError
@@ -115,13 +167,32 @@ class GCodeDispatch:
         self.mux_commands = {}
         self.gcode_help = {}
         self.status_commands = {}
+        self.status_info = {'commands': self.status_commands}
+        # Interned command dispatch (built lazily from gcode_handlers)
+        self.gcp_handlers = []
+        self.gcp_dirty = True
+        # Per-command execution time tracking
+        self.monotonic = printer.get_reactor().monotonic
+        # Duplicate output line suppression
+        self.last_output = None
+        self.last_output_time = 0.
+        self.cmd_timing = {}
+        self.slow_cmd_time = 0.100
         # Register commands needed before config file is loaded
-        handlers = ['M110', 'M112', 'M115',
-                    'RESTART', 'FIRMWARE_RESTART', 'ECHO', 'STATUS', 'HELP']
+        handlers = ['M110', 'M112', 'M115', 'RESTART', 'FIRMWARE_RESTART',
+                    'ECHO', 'STATUS', 'HELP', 'GCODE_TIMING']
         for cmd in handlers:
             func = getattr(self, 'cmd_' + cmd)
             desc = getattr(self, 'cmd_' + cmd + '_help', None)
             self.register_command(cmd, func, True, desc)
+        # C helper for command line parsing
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.gcp_max_params = 32
+        self.gcp_params = self.ffi_main.new('struct gc_param[]',
+                                            self.gcp_max_params)
+        self.gcp_cmd_bounds = self.ffi_main.new('int[2]')
+        self.gcp_lookup = self.ffi_main.gc(self.ffi_lib.gc_lookup_alloc(),
+                                           self.ffi_lib.gc_lookup_free)
     def is_traditional_gcode(self, cmd):
         # A "traditional" g-code command is a letter and followed by a number
         try:
@@ -174,13 +245,32 @@ class GCodeDispatch:
     def get_command_help(self):
         return dict(self.gcode_help)
     def get_status(self, eventtime):
-        return {'commands': self.status_commands}
+        return self.status_info
     def _build_status_commands(self):
         commands = {cmd: {} for cmd in self.gcode_handlers}
         for cmd in self.gcode_help:
             if cmd in commands:
                 commands[cmd]['help'] = self.gcode_help[cmd]
         self.status_commands = commands
+        self.status_info = {'commands': commands}
+        self.gcp_dirty = True
+    def _build_command_lookup(self):
+        # Intern the active handlers to integer ids for C assisted
+        # dispatch - handlers resolve without building a command string
+        self.gcp_dirty = False
+        ffi_lib = self.ffi_lib
+        ffi_lib.gc_lookup_clear(self.gcp_lookup)
+        handlers = []
+        for cmd, func in self.gcode_handlers.items():
+            try:
+                data = cmd.encode('ascii')
+            except UnicodeEncodeError:
+                continue
+            if ffi_lib.gc_lookup_add(self.gcp_lookup, data, len(data),
+                                     len(handlers)) < 0:
+                continue
+            handlers.append((cmd, func))
+        self.gcp_handlers = handlers
     def register_output_handler(self, cb):
         self.output_callbacks.append(cb)
     def _handle_shutdown(self):
@@ -200,6 +290,8 @@ class GCodeDispatch:
     # Parse input into commands
     args_r = re.compile('([A-Z_]+|[A-Z*])')
     def _process_commands(self, commands, need_ack=True):
+        if self.gcp_dirty:
+            self._build_command_lookup()
         for line in commands:
             # Ignore comments and leading/trailing spaces
             line = origline = line.strip()
@@ -207,18 +299,54 @@ class GCodeDispatch:
             if cpos >= 0:
                 line = line[:cpos]
             # Break line into parts and determine command
-            parts = self.args_r.split(line.upper())
-            if ''.join(parts[:2]) == 'N':
-                # Skip line number at start of command
-                cmd = ''.join(parts[3:5]).strip()
+            upper = line.upper()
+            count = -1
+            try:
+                data = upper.encode('ascii')
+            except UnicodeEncodeError:
+                data = None
+            if data is not None:
+                count = self.ffi_lib.gcodeparse_line(
+                    data, len(data), self.gcp_params, self.gcp_max_params,
+                    self.gcp_cmd_bounds)
+            if count >= 0:
+                # Resolve the command via the interned dispatch table
+                cmd_id = self.ffi_lib.gcodeparse_lookup(
+                    self.gcp_lookup, data, self.gcp_cmd_bounds)
+                if cmd_id >= 0:
+                    cmd, handler = self.gcp_handlers[cmd_id]
+                else:
+                    cmd = upper[self.gcp_cmd_bounds[0]:self.gcp_cmd_bounds[1]]
+                    handler = self.gcode_handlers.get(cmd, self.cmd_default)
+                # Build "params" from the C tokenizer results
+                params = {}
+                cfloats = {}
+                gcp_params = self.gcp_params
+                for i in range(count):
+                    p = gcp_params[i]
+                    key = upper[p.key_pos:p.key_pos+p.key_len]
+                    params[key] = upper[p.value_pos:p.value_pos+p.value_len]
+                    if p.fvalid:
+                        cfloats[key] = p.fvalue
+                    elif key in cfloats:
+                        del cfloats[key]
             else:
-                cmd = ''.join(parts[:3]).strip()
-            # Build gcode "params" dictionary
-            params = { parts[i]: parts[i+1].strip()
-                       for i in range(1, len(parts), 2) }
-            gcmd = GCodeCommand(self, cmd, origline, params, need_ack)
-            # Invoke handler for command
-            handler = self.gcode_handlers.get(cmd, self.cmd_default)
+                # Fallback for non-ascii lines or too many parameters
+                parts = self.args_r.split(upper)
+                if ''.join(parts[:2]) == 'N':
+                    # Skip line number at start of command
+                    cmd = ''.join(parts[3:5]).strip()
+                else:
+                    cmd = ''.join(parts[:3]).strip()
+                params = { parts[i]: parts[i+1].strip()
+                           for i in range(1, len(parts), 2) }
+                cfloats = None
+                handler = self.gcode_handlers.get(cmd, self.cmd_default)
+            gcmd = GCodeCommand(self, cmd, origline, params, need_ack, cfloats)
+            self._invoke_command(handler, gcmd, cmd, need_ack)
+    def _invoke_command(self, handler, gcmd, cmd, need_ack):
+        start_time = self.monotonic()
+        try:
             try:
                 handler(gcmd)
             except self.error as e:
@@ -234,17 +362,50 @@ class GCodeDispatch:
                 if not need_ack:
                     raise
             gcmd.ack()
+        finally:
+            # Track execution time (count, total, max, log2 histogram)
+            duration = self.monotonic() - start_time
+            timing = self.cmd_timing.get(cmd)
+            if timing is None:
+                timing = self.cmd_timing[cmd] = [0, 0., 0., {}]
+            timing[0] += 1
+            timing[1] += duration
+            if duration > timing[2]:
+                timing[2] = duration
+            buckets = timing[3]
+            b = math.frexp(duration)[1]
+            buckets[b] = buckets.get(b, 0) + 1
+            if duration >= self.slow_cmd_time:
+                logging.info("gcode: slow command '%s' took %.3f seconds"
+                             " (line '%s')", cmd, duration,
+                             gcmd.get_commandline())
     def run_script_from_command(self, script):
         self._process_commands(script.split('\n'), need_ack=False)
     def run_script(self, script):
         with self.mutex:
             self._process_commands(script.split('\n'), need_ack=False)
+    def run_decoded(self, decoded):
+        # Dispatch a command pre-parsed by GCodeLineParser
+        with self.mutex:
+            cmd, origline, params, cfloats = decoded
+            handler = self.gcode_handlers.get(cmd, self.cmd_default)
+            gcmd = GCodeCommand(self, cmd, origline, params, False, cfloats)
+            self._invoke_command(handler, gcmd, cmd, need_ack=False)
     def get_mutex(self):
         return self.mutex
     def create_gcode_command(self, command, commandline, params):
         return GCodeCommand(self, command, commandline, params, False)
     # Response handling
     def respond_raw(self, msg):
+        # Rate limit rapidly repeated identical info lines
+        if msg == self.last_output and msg[:2] == '//':
+            eventtime = self.monotonic()
+            if eventtime < self.last_output_time + OUTPUT_REPEAT_TIME:
+                return
+            self.last_output_time = eventtime
+        else:
+            self.last_output = msg
+            self.last_output_time = self.monotonic()
         for cb in self.output_callbacks:
             cb(msg)
     def respond_info(self, msg, log=True):
@@ -278,6 +439,7 @@ class GCodeDispatch:
         # Update gcmd with new parameters
         gcmd._params.clear()
         gcmd._params.update(eparams)
+        gcmd._cfloats = None
         return gcmd
     # G-Code special command handlers
     def cmd_default(self, gcmd):
@@ -385,6 +547,45 @@ class GCodeDispatch:
             if cmd in self.gcode_help:
                 cmdhelp.append("%-10s: %s" % (cmd, self.gcode_help[cmd]))
         gcmd.respond_info("\n".join(cmdhelp), log=False)
+    def _timing_percentile(self, buckets, count, pct):
+        # Estimate a percentile from the log2 histogram (upper bound
+        # of the bucket containing the requested sample)
+        target = count * pct
+        seen = 0
+        for b in sorted(buckets):
+            seen += buckets[b]
+            if seen >= target:
+                return math.ldexp(1., b)
+        return 0.
+    cmd_GCODE_TIMING_help = "Report gcode command execution time statistics"
+    def cmd_GCODE_TIMING(self, gcmd):
+        threshold = gcmd.get_float('THRESHOLD', None, minval=0.)
+        if threshold is not None:
+            self.slow_cmd_time = threshold
+        if gcmd.get_int('RESET', 0):
+            self.cmd_timing = {}
+            gcmd.respond_info("gcode timing statistics cleared")
+            return
+        cname = gcmd.get('CMD', None)
+        if cname is not None:
+            timing = self.cmd_timing.get(cname.upper())
+            items = []
+            if timing is not None:
+                items = [(cname.upper(), timing)]
+        else:
+            # Report the top commands by accumulated time
+            items = sorted(self.cmd_timing.items(),
+                           key=lambda i: -i[1][1])[:20]
+        out = ["gcode command timings (slow threshold %.3fs):"
+               % (self.slow_cmd_time,)]
+        for cmd, (count, total, max_time, buckets) in items:
+            p50 = self._timing_percentile(buckets, count, .50)
+            p99 = self._timing_percentile(buckets, count, .99)
+            out.append("%s: count=%d total=%.3f avg=%.6f"
+                       " p50=%.6f p99=%.6f max=%.6f"
+                       % (cmd, count, total, total / count, p50, p99,
+                          max_time))
+        gcmd.respond_info("\n".join(out), log=False)
 
 # Support reading gcode from a pseudo-tty interface
 class GCodeIO:
@@ -405,6 +606,8 @@ class GCodeIO:
                                                       self._process_data)
         self.partial_input = ""
         self.pending_commands = []
+        self.pending_output = []
+        self.output_flush_pending = False
         self.bytes_read = 0
         self.input_log = collections.deque([], 50)
         # Register event handlers
@@ -476,12 +679,25 @@ class GCodeIO:
             self.fd_handle = self.reactor.register_fd(self.fd,
                                                       self._process_data)
     def _respond_raw(self, msg):
-        if self.pipe_is_active:
-            try:
-                os.write(self.fd, (msg+"\n").encode())
-            except os.error:
-                logging.exception("Write g-code response")
-                self.pipe_is_active = False
+        # Batch responses and flush with one writev when the reactor is
+        # next idle (a burst of lines becomes a single syscall)
+        if not self.pipe_is_active:
+            return
+        self.pending_output.append((msg+"\n").encode())
+        if not self.output_flush_pending:
+            self.output_flush_pending = True
+            self.reactor.register_callback(self._flush_output)
+    def _flush_output(self, eventtime=None):
+        self.output_flush_pending = False
+        pending_output = self.pending_output
+        self.pending_output = []
+        try:
+            while pending_output:
+                os.writev(self.fd, pending_output[:WRITEV_MAX_COUNT])
+                del pending_output[:WRITEV_MAX_COUNT]
+        except os.error:
+            logging.exception("Write g-code response")
+            self.pipe_is_active = False
     def stats(self, eventtime):
         return False, "gcodein=%d" % (self.bytes_read,)
 
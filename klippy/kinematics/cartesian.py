@@ -4,7 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging
-import stepper
+import chelper, stepper
 from . import idex_modes
 
 class CartKinematics:
@@ -43,6 +43,14 @@ class CartKinematics:
         self.max_z_accel = config.getfloat('max_z_accel', max_accel,
                                            above=0., maxval=max_accel)
         self.limits = [(1.0, -1.0)] * 3
+        self.parallel_homing = config.getboolean('parallel_homing', False)
+        # Move limit checks are performed in C with precomputed geometry
+        ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.c_limits = ffi_main.new("struct kin_limits *")
+        self.c_limits.max_z_velocity = self.max_z_velocity
+        self.c_limits.max_z_accel = self.max_z_accel
+        self.c_move_limits = ffi_main.new("double[2]")
+        self._update_c_limits()
     def get_steppers(self):
         return [s for rail in self.rails for s in rail.get_steppers()]
     def calc_position(self, stepper_positions):
@@ -53,12 +61,18 @@ class CartKinematics:
             rails = (rails[:self.dual_carriage_axis] +
                      [dc_rail] + rails[self.dual_carriage_axis+1:])
         return [stepper_positions[rail.get_name()] for rail in rails]
+    def _update_c_limits(self):
+        # Mirror the axis limits into the C move validation helper
+        for i, (l, h) in enumerate(self.limits):
+            self.c_limits.limits[i][0] = l
+            self.c_limits.limits[i][1] = h
     def update_limits(self, i, range):
         l, h = self.limits[i]
         # Only update limits if this axis was already homed,
         # otherwise leave in un-homed state.
         if l <= h:
             self.limits[i] = range
+        self._update_c_limits()
     def set_position(self, newpos, homing_axes):
         for i, rail in enumerate(self.rails):
             rail.set_position(newpos)
@@ -70,11 +84,13 @@ class CartKinematics:
             if rail is None:
                 rail = self.rails[axis]
             self.limits[axis] = rail.get_range()
+        self._update_c_limits()
     def clear_homing_state(self, clear_axes):
         for axis, axis_name in enumerate("xyz"):
             if axis_name in clear_axes:
                 self.limits[axis] = (1.0, -1.0)
-    def home_axis(self, homing_state, axis, rail):
+        self._update_c_limits()
+    def _calc_home_request(self, axis, rail):
         # Determine movement
         position_min, position_max = rail.get_range()
         hi = rail.get_homing_info()
@@ -85,38 +101,45 @@ class CartKinematics:
             forcepos[axis] -= 1.5 * (hi.position_endstop - position_min)
         else:
             forcepos[axis] += 1.5 * (position_max - hi.position_endstop)
+        return ([rail], forcepos, homepos)
+    def home_axis(self, homing_state, axis, rail):
+        rails, forcepos, homepos = self._calc_home_request(axis, rail)
         # Perform homing
-        homing_state.home_rails([rail], forcepos, homepos)
+        homing_state.home_rails(rails, forcepos, homepos)
     def home(self, homing_state):
+        axes = homing_state.get_axes()
+        if self.parallel_homing:
+            # Home mechanically independent axes concurrently
+            requests = [self._calc_home_request(axis, self.rails[axis])
+                        for axis in axes
+                        if self.dc_module is None
+                        or axis != self.dual_carriage_axis]
+            if len(requests) > 1:
+                homing_state.home_rails_multi(requests)
+                if (self.dc_module is not None
+                    and self.dual_carriage_axis in axes):
+                    self.dc_module.home(homing_state,
+                                        self.dual_carriage_axis)
+                return
         # Each axis is homed independently and in order
-        for axis in homing_state.get_axes():
+        for axis in axes:
             if self.dc_module is not None and axis == self.dual_carriage_axis:
                 self.dc_module.home(homing_state, self.dual_carriage_axis)
             else:
                 self.home_axis(homing_state, axis, self.rails[axis])
-    def _check_endstops(self, move):
-        end_pos = move.end_pos
-        for i in (0, 1, 2):
-            if (move.axes_d[i]
-                and (end_pos[i] < self.limits[i][0]
-                     or end_pos[i] > self.limits[i][1])):
-                if self.limits[i][0] > self.limits[i][1]:
-                    raise move.move_error("Must home axis first")
-                raise move.move_error()
     def check_move(self, move):
-        limits = self.limits
-        xpos, ypos = move.end_pos[:2]
-        if (xpos < limits[0][0] or xpos > limits[0][1]
-            or ypos < limits[1][0] or ypos > limits[1][1]):
-            self._check_endstops(move)
-        if not move.axes_d[2]:
-            # Normal XY move - use defaults
+        sp, ep = move.start_pos, move.end_pos
+        res = self.ffi_lib.kincheck_cart_move(
+            self.c_limits, move.move_d, sp[0], sp[1], sp[2],
+            ep[0], ep[1], ep[2], self.c_move_limits)
+        if not res:
             return
-        # Move with Z - update velocity and accel for slower Z axis
-        self._check_endstops(move)
-        z_ratio = move.move_d / abs(move.axes_d[2])
-        move.limit_speed(
-            self.max_z_velocity * z_ratio, self.max_z_accel * z_ratio)
+        if res == self.ffi_lib.KC_LIMIT_SPEED:
+            move.limit_speed(self.c_move_limits[0], self.c_move_limits[1])
+        elif res == self.ffi_lib.KC_MUST_HOME:
+            raise move.move_error("Must home axis first")
+        else:
+            raise move.move_error()
     def get_status(self, eventtime):
         axes = [a for a, (l, h) in zip("xyz", self.limits) if l <= h]
         return {
@@ -4,7 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import logging, math
-import stepper
+import chelper, stepper
 
 class CoreXYKinematics:
     def __init__(self, toolhead, config):
@@ -30,6 +30,18 @@ class CoreXYKinematics:
         ranges = [r.get_range() for r in self.rails]
         self.axes_min = toolhead.Coord([r[0] for r in ranges])
         self.axes_max = toolhead.Coord([r[1] for r in ranges])
+        # Move limit checks are performed in C with precomputed geometry
+        ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.c_limits = ffi_main.new("struct kin_limits *")
+        self.c_limits.max_z_velocity = self.max_z_velocity
+        self.c_limits.max_z_accel = self.max_z_accel
+        self.c_move_limits = ffi_main.new("double[2]")
+        self._update_c_limits()
+    def _update_c_limits(self):
+        # Mirror the axis limits into the C move validation helper
+        for i, (l, h) in enumerate(self.limits):
+            self.c_limits.limits[i][0] = l
+            self.c_limits.limits[i][1] = h
     def get_steppers(self):
         return [s for rail in self.rails for s in rail.get_steppers()]
     def calc_position(self, stepper_positions):
@@ -40,10 +52,12 @@ class CoreXYKinematics:
             rail.set_position(newpos)
             if "xyz"[i] in homing_axes:
                 self.limits[i] = rail.get_range()
+        self._update_c_limits()
     def clear_homing_state(self, clear_axes):
         for axis, axis_name in enumerate("xyz"):
             if axis_name in clear_axes:
                 self.limits[axis] = (1.0, -1.0)
+        self._update_c_limits()
     def home(self, homing_state):
         # Each axis is homed independently and in order
         for axis in homing_state.get_axes():
@@ -60,29 +74,19 @@ class CoreXYKinematics:
                 forcepos[axis] += 1.5 * (position_max - hi.position_endstop)
             # Perform homing
             homing_state.home_rails([rail], forcepos, homepos)
-    def _check_endstops(self, move):
-        end_pos = move.end_pos
-        for i in (0, 1, 2):
-            if (move.axes_d[i]
-                and (end_pos[i] < self.limits[i][0]
-                     or end_pos[i] > self.limits[i][1])):
-                if self.limits[i][0] > self.limits[i][1]:
-                    raise move.move_error("Must home axis first")
-                raise move.move_error()
     def check_move(self, move):
-        limits = self.limits
-        xpos, ypos = move.end_pos[:2]
-        if (xpos < limits[0][0] or xpos > limits[0][1]
-            or ypos < limits[1][0] or ypos > limits[1][1]):
-            self._check_endstops(move)
-        if not move.axes_d[2]:
-            # Normal XY move - use defaults
+        sp, ep = move.start_pos, move.end_pos
+        res = self.ffi_lib.kincheck_cart_move(
+            self.c_limits, move.move_d, sp[0], sp[1], sp[2],
+            ep[0], ep[1], ep[2], self.c_move_limits)
+        if not res:
             return
-        # Move with Z - update velocity and accel for slower Z axis
-        self._check_endstops(move)
-        z_ratio = move.move_d / abs(move.axes_d[2])
-        move.limit_speed(
-            self.max_z_velocity * z_ratio, self.max_z_accel * z_ratio)
+        if res == self.ffi_lib.KC_LIMIT_SPEED:
+            move.limit_speed(self.c_move_limits[0], self.c_move_limits[1])
+        elif res == self.ffi_lib.KC_MUST_HOME:
+            raise move.move_error("Must home axis first")
+        else:
+            raise move.move_error()
     def get_status(self, eventtime):
         axes = [a for a, (l, h) in zip("xyz", self.limits) if l <= h]
         return {
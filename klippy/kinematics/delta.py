@@ -4,7 +4,7 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import math, logging
-import stepper, mathutil
+import chelper, stepper, mathutil
 
 # Slow moves once the ratio of tower to XY movement exceeds SLOW_RATIO
 SLOW_RATIO = 3.
@@ -54,7 +54,6 @@ class DeltaKinematics:
             s.set_trapq(toolhead.get_trapq())
         # Setup boundary checks
         self.need_home = True
-        self.limit_xy2 = -1.
         self.home_position = tuple(
             self._actuator_to_cartesian(self.abs_endstops))
         self.max_z = min([rail.get_homing_info().position_endstop
@@ -87,6 +86,22 @@ class DeltaKinematics:
                         math.sqrt(self.very_slow_xy2)))
         self.axes_min = toolhead.Coord((-max_xy, -max_xy, self.min_z))
         self.axes_max = toolhead.Coord((max_xy, max_xy, self.max_z))
+        # Move limit checks are performed in C with precomputed geometry
+        ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.c_limits = cl = ffi_main.new("struct kin_limits *")
+        cl.max_velocity, cl.max_accel = self.max_velocity, self.max_accel
+        cl.max_z_velocity = self.max_z_velocity
+        cl.max_z_accel = self.max_z_accel
+        cl.radius = radius
+        cl.min_arm2 = self.min_arm2
+        cl.min_arm_length = self.min_arm_length
+        cl.min_z, cl.max_z, cl.limit_z = self.min_z, self.max_z, self.limit_z
+        cl.home_x, cl.home_y, cl.home_z = self.home_position
+        cl.max_xy2 = self.max_xy2
+        cl.slow_xy2 = self.slow_xy2
+        cl.very_slow_xy2 = self.very_slow_xy2
+        cl.need_home = True
+        self.c_move_limits = ffi_main.new("double[2]")
         self.set_position([0., 0., 0.], "")
     def get_steppers(self):
         return [s for rail in self.rails for s in rail.get_steppers()]
@@ -99,14 +114,16 @@ class DeltaKinematics:
     def set_position(self, newpos, homing_axes):
         for rail in self.rails:
             rail.set_position(newpos)
-        self.limit_xy2 = -1.
+        self.c_limits.limit_xy2 = -1.
         if homing_axes == "xyz":
             self.need_home = False
+        self.c_limits.need_home = self.need_home
     def clear_homing_state(self, clear_axes):
         # Clearing homing state for each axis individually is not implemented
         if clear_axes:
-            self.limit_xy2 = -1
+            self.c_limits.limit_xy2 = -1.
             self.need_home = True
+            self.c_limits.need_home = True
     def home(self, homing_state):
         # All axes are homed simultaneously
         homing_state.set_axes([0, 1, 2])
@@ -114,42 +131,18 @@ class DeltaKinematics:
         forcepos[2] = -1.5 * math.sqrt(max(self.arm2)-self.max_xy2)
         homing_state.home_rails(self.rails, forcepos, self.home_position)
     def check_move(self, move):
-        end_pos = move.end_pos
-        end_xy2 = end_pos[0]**2 + end_pos[1]**2
-        if end_xy2 <= self.limit_xy2 and not move.axes_d[2]:
-            # Normal XY move
+        sp, ep = move.start_pos, move.end_pos
+        res = self.ffi_lib.kincheck_delta_move(
+            self.c_limits, move.move_d, sp[0], sp[1], sp[2],
+            ep[0], ep[1], ep[2], self.c_move_limits)
+        if not res:
             return
-        if self.need_home:
+        if res == self.ffi_lib.KC_LIMIT_SPEED:
+            move.limit_speed(self.c_move_limits[0], self.c_move_limits[1])
+        elif res == self.ffi_lib.KC_MUST_HOME:
             raise move.move_error("Must home first")
-        end_z = end_pos[2]
-        limit_xy2 = self.max_xy2
-        if end_z > self.limit_z:
-            above_z_limit = end_z - self.limit_z
-            allowed_radius = self.radius - math.sqrt(
-                self.min_arm2 - (self.min_arm_length - above_z_limit)**2
-            )
-            limit_xy2 = min(limit_xy2, allowed_radius**2)
-        if end_xy2 > limit_xy2 or end_z > self.max_z or end_z < self.min_z:
-            # Move out of range - verify not a homing move
-            if (end_pos[:2] != self.home_position[:2]
-                or end_z < self.min_z or end_z > self.home_position[2]):
-                raise move.move_error()
-            limit_xy2 = -1.
-        if move.axes_d[2]:
-            z_ratio = move.move_d / abs(move.axes_d[2])
-            move.limit_speed(self.max_z_velocity * z_ratio,
-                             self.max_z_accel * z_ratio)
-            limit_xy2 = -1.
-        # Limit the speed/accel of this move if is is at the extreme
-        # end of the build envelope
-        extreme_xy2 = max(end_xy2, move.start_pos[0]**2 + move.start_pos[1]**2)
-        if extreme_xy2 > self.slow_xy2:
-            r = 0.5
-            if extreme_xy2 > self.very_slow_xy2:
-                r = 0.25
-            move.limit_speed(self.max_velocity * r, self.max_accel * r)
-            limit_xy2 = -1.
-        self.limit_xy2 = min(limit_xy2, self.slow_xy2)
+        else:
+            raise move.move_error()
     def get_status(self, eventtime):
         return {
             'homed_axes': '' if self.need_home else 'xyz',
@@ -6,14 +6,23 @@
 import math, logging
 import stepper, chelper
 
+PA_TABLE_SIZE = 64
+
 class ExtruderStepper:
     def __init__(self, config):
         self.printer = config.get_printer()
         self.name = config.get_name().split()[-1]
         self.pressure_advance = self.pressure_advance_smooth_time = 0.
+        self.pa_enabled = False
         self.config_pa = config.getfloat('pressure_advance', 0., minval=0.)
         self.config_smooth_time = config.getfloat(
                 'pressure_advance_smooth_time', 0.040, above=0., maxval=.200)
+        # Optional nonlinear advance curve (velocity:advance pairs)
+        self.config_pa_table = None
+        pa_points = config.getlists('pressure_advance_table', None,
+                                    seps=(':', ','), parser=float, count=2)
+        if pa_points is not None:
+            self.config_pa_table = self._build_pa_table(config, pa_points)
         # Setup stepper
         self.stepper = stepper.PrinterStepper(config)
         ffi_main, ffi_lib = chelper.get_ffi()
@@ -39,7 +48,13 @@ class ExtruderStepper:
                                    self.name, self.cmd_SYNC_EXTRUDER_MOTION,
                                    desc=self.cmd_SYNC_EXTRUDER_MOTION_help)
     def _handle_connect(self):
-        self._set_pressure_advance(self.config_pa, self.config_smooth_time)
+        if self.config_pa_table is not None:
+            advances, vel_step = self.config_pa_table
+            self.set_pressure_advance_table(advances, vel_step,
+                                            self.config_smooth_time)
+        else:
+            self._set_pressure_advance(self.config_pa,
+                                       self.config_smooth_time)
     def get_status(self, eventtime):
         return {'pressure_advance': self.pressure_advance,
                 'smooth_time': self.pressure_advance_smooth_time,
@@ -64,28 +79,73 @@ class ExtruderStepper:
         self.stepper.set_trapq(extruder.get_trapq())
         self.motion_queue = extruder_name
         motion_queuing.check_step_generation_scan_windows()
-    def _set_pressure_advance(self, pressure_advance, smooth_time):
+    def _build_pa_table(self, config, pa_points):
+        # Validate user provided velocity:advance curve
+        if len(pa_points) < 2:
+            raise config.error(
+                "pressure_advance_table must have at least two points")
+        for (velocity, advance), (prev_v, prev_a) in zip(pa_points[1:],
+                                                         pa_points):
+            if velocity <= prev_v:
+                raise config.error(
+                    "pressure_advance_table velocities must be increasing")
+        if min([v for v, a in pa_points]) < 0.:
+            raise config.error(
+                "pressure_advance_table velocities must not be negative")
+        if min([a for v, a in pa_points]) < 0.:
+            raise config.error(
+                "pressure_advance_table advance must not be negative")
+        # Resample curve at uniform velocity intervals
+        vel_step = pa_points[-1][0] / (PA_TABLE_SIZE - 1)
+        advances = []
+        pos = 0
+        for i in range(PA_TABLE_SIZE):
+            velocity = i * vel_step
+            while (pos < len(pa_points) - 2
+                   and velocity > pa_points[pos + 1][0]):
+                pos += 1
+            (v1, a1), (v2, a2) = pa_points[pos], pa_points[pos + 1]
+            if velocity <= v1:
+                advances.append(a1)
+            else:
+                frac = (velocity - v1) / (v2 - v1)
+                advances.append(a1 + (a2 - a1) * frac)
+        return advances, vel_step
+    def _apply_pa_update(self, enabled, smooth_time, setter):
         old_smooth_time = self.pressure_advance_smooth_time
-        if not self.pressure_advance:
+        if not self.pa_enabled:
             old_smooth_time = 0.
         new_smooth_time = smooth_time
-        if not pressure_advance:
+        if not enabled:
             new_smooth_time = 0.
         toolhead = self.printer.lookup_object("toolhead")
-        ffi_main, ffi_lib = chelper.get_ffi()
-        espa = ffi_lib.extruder_set_pressure_advance
         if new_smooth_time != old_smooth_time:
             # Need full kinematic flush to change the smooth time
             toolhead.flush_step_generation()
-            espa(self.sk_extruder, 0., pressure_advance, new_smooth_time)
+            setter(0., new_smooth_time)
             motion_queuing = self.printer.lookup_object('motion_queuing')
             motion_queuing.check_step_generation_scan_windows()
         else:
             toolhead.register_lookahead_callback(
-                lambda print_time: espa(self.sk_extruder, print_time,
-                                        pressure_advance, new_smooth_time))
-        self.pressure_advance = pressure_advance
+                lambda print_time: setter(print_time, new_smooth_time))
+        self.pa_enabled = enabled
         self.pressure_advance_smooth_time = smooth_time
+    def _set_pressure_advance(self, pressure_advance, smooth_time):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        espa = ffi_lib.extruder_set_pressure_advance
+        def setter(print_time, new_smooth_time):
+            espa(self.sk_extruder, print_time,
+                 pressure_advance, new_smooth_time)
+        self._apply_pa_update(bool(pressure_advance), smooth_time, setter)
+        self.pressure_advance = pressure_advance
+    def set_pressure_advance_table(self, advances, vel_step, smooth_time):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        c_advances = ffi_main.new('double[]', advances)
+        def setter(print_time, new_smooth_time):
+            ffi_lib.extruder_set_pressure_advance_table(
+                self.sk_extruder, print_time, c_advances, len(advances),
+                vel_step, new_smooth_time)
+        self._apply_pa_update(True, smooth_time, setter)
     cmd_SET_PRESSURE_ADVANCE_help = "Set pressure advance parameters"
     def cmd_default_SET_PRESSURE_ADVANCE(self, gcmd):
         extruder = self.printer.lookup_object('toolhead').get_extruder()
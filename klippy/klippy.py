@@ -5,9 +5,27 @@
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
 import sys, os, gc, optparse, logging, time, collections, importlib
+import threading
 import util, reactor, queuelogger, msgproto
 import gcode, configfile, pins, mcu, toolhead, webhooks
 
+try:
+    # Precompiled bundles (scripts/build_bundle.py) ship a generated
+    # registry of available extras modules, avoiding directory stats
+    # during config parsing
+    import extras_registry
+    EXTRAS_MODULES = frozenset(extras_registry.EXTRAS_MODULES)
+except ImportError:
+    EXTRAS_MODULES = None
+
+def has_extras_module(module_name):
+    if EXTRAS_MODULES is not None:
+        return module_name in EXTRAS_MODULES
+    extras_dir = os.path.join(os.path.dirname(__file__), 'extras')
+    return (os.path.exists(os.path.join(extras_dir, module_name + '.py'))
+            or os.path.exists(os.path.join(extras_dir, module_name,
+                                           '__init__.py')))
+
 message_ready = "Printer is ready"
 
 message_startup = """
@@ -92,11 +110,7 @@ class Printer:
             return self.objects[section]
         module_parts = section.split()
         module_name = module_parts[0]
-        py_name = os.path.join(os.path.dirname(__file__),
-                               'extras', module_name + '.py')
-        py_dirname = os.path.join(os.path.dirname(__file__),
-                                  'extras', module_name, '__init__.py')
-        if not os.path.exists(py_name) and not os.path.exists(py_dirname):
+        if not has_extras_module(module_name):
             if default is not configfile.sentinel:
                 return default
             raise self.config_error("Unable to load module '%s'" % (section,))
@@ -111,18 +125,48 @@ class Printer:
             raise self.config_error("Unable to load module '%s'" % (section,))
         self.objects[section] = init_func(config.getsection(section))
         return self.objects[section]
+    def _preload_modules(self, config):
+        # Import extras module files on worker threads.  The import
+        # machinery serializes the loading of each individual module, so
+        # importing distinct modules concurrently is safe and overlaps
+        # the disk reads and bytecode compilation that dominate a cold
+        # startup.  Object instantiation still happens sequentially in
+        # config order via load_object().
+        module_names = set()
+        for section_config in config.get_prefix_sections(''):
+            module_name = section_config.get_name().split()[0]
+            if has_extras_module(module_name):
+                module_names.add(module_name)
+        def import_worker(names):
+            for module_name in names:
+                try:
+                    importlib.import_module('extras.' + module_name)
+                except Exception:
+                    # Errors are reported by the regular load_object() path
+                    pass
+        names = sorted(module_names)
+        num_workers = min(4, len(names))
+        threads = [threading.Thread(target=import_worker,
+                                    args=(names[i::num_workers],))
+                   for i in range(num_workers)]
+        for t in threads:
+            t.start()
+        return threads
     def _read_config(self):
         self.objects['configfile'] = pconfig = configfile.PrinterConfig(self)
         config = pconfig.read_main_config()
         if self.bglogger is not None:
             pconfig.log_config(config)
         # Create printer components
+        import_threads = self._preload_modules(config)
         for m in [pins, mcu]:
             m.add_printer_objects(config)
         for section_config in config.get_prefix_sections(''):
             self.load_object(config, section_config.get_name(), None)
         for m in [toolhead]:
             m.add_printer_objects(config)
+        for t in import_threads:
+            t.join()
         # Validate that there are no undefined parameters in the config file
         pconfig.check_unused_options(config)
     def _connect(self, eventtime):
@@ -259,6 +303,44 @@ def arg_dictionary(option, opt_str, value, parser):
         parser.values.dictionary = {}
     parser.values.dictionary[key] = fname
 
+def collect_version_info(start_args):
+    # Obtain software and host version info, store it in start_args,
+    # and return a human readable summary for the log header
+    git_info = util.get_git_version()
+    git_vers = git_info["version"]
+    extra_files = [fname for code, fname in git_info["file_status"]
+                   if (code in ('??', '!!') and fname.endswith('.py')
+                       and (fname.startswith('klippy/kinematics/')
+                            or fname.startswith('klippy/extras/')))]
+    modified_files = [fname for code, fname in git_info["file_status"]
+                      if code == 'M']
+    extra_git_desc = ""
+    if extra_files:
+        if not git_vers.endswith('-dirty'):
+            git_vers = git_vers + '-dirty'
+        if len(extra_files) > 10:
+            extra_files[10:] = ["(+%d files)" % (len(extra_files) - 10,)]
+        extra_git_desc += "\nUntracked files: %s" % (', '.join(extra_files),)
+    if modified_files:
+        if len(modified_files) > 10:
+            modified_files[10:] = ["(+%d files)" % (len(modified_files) - 10,)]
+        extra_git_desc += "\nModified files: %s" % (', '.join(modified_files),)
+    extra_git_desc += "\nBranch: %s" % (git_info["branch"])
+    extra_git_desc += "\nRemote: %s" % (git_info["remote"])
+    extra_git_desc += "\nTracked URL: %s" % (git_info["url"])
+    start_args['software_version'] = git_vers
+    start_args['cpu_info'] = util.get_cpu_info()
+    start_args['device'] = util.get_device_info()
+    start_args['linux_version'] = util.get_linux_version()
+    return "\n".join([
+        "Args: %s" % (sys.argv,),
+        "Git version: %s%s" % (repr(start_args['software_version']),
+                               extra_git_desc),
+        "CPU: %s" % (start_args['cpu_info'],),
+        "Device: %s" % (start_args['device']),
+        "Linux: %s" % (start_args['linux_version']),
+        "Python: %s" % (repr(sys.version),)])
+
 def main():
     usage = "%prog [options] <config file>"
     opts = optparse.OptionParser(usage)
@@ -307,41 +389,8 @@ def main():
     else:
         logging.getLogger().setLevel(debuglevel)
     logging.info("Starting Klippy...")
-    git_info = util.get_git_version()
-    git_vers = git_info["version"]
-    extra_files = [fname for code, fname in git_info["file_status"]
-                   if (code in ('??', '!!') and fname.endswith('.py')
-                       and (fname.startswith('klippy/kinematics/')
-                            or fname.startswith('klippy/extras/')))]
-    modified_files = [fname for code, fname in git_info["file_status"]
-                      if code == 'M']
-    extra_git_desc = ""
-    if extra_files:
-        if not git_vers.endswith('-dirty'):
-            git_vers = git_vers + '-dirty'
-        if len(extra_files) > 10:
-            extra_files[10:] = ["(+%d files)" % (len(extra_files) - 10,)]
-        extra_git_desc += "\nUntracked files: %s" % (', '.join(extra_files),)
-    if modified_files:
-        if len(modified_files) > 10:
-            modified_files[10:] = ["(+%d files)" % (len(modified_files) - 10,)]
-        extra_git_desc += "\nModified files: %s" % (', '.join(modified_files),)
-    extra_git_desc += "\nBranch: %s" % (git_info["branch"])
-    extra_git_desc += "\nRemote: %s" % (git_info["remote"])
-    extra_git_desc += "\nTracked URL: %s" % (git_info["url"])
-    start_args['software_version'] = git_vers
-    start_args['cpu_info'] = util.get_cpu_info()
-    start_args['device'] = util.get_device_info()
-    start_args['linux_version'] = util.get_linux_version()
+    versions = collect_version_info(start_args)
     if bglogger is not None:
-        versions = "\n".join([
-            "Args: %s" % (sys.argv,),
-            "Git version: %s%s" % (repr(start_args['software_version']),
-                                   extra_git_desc),
-            "CPU: %s" % (start_args['cpu_info'],),
-            "Device: %s" % (start_args['device']),
-            "Linux: %s" % (start_args['linux_version']),
-            "Python: %s" % (repr(sys.version),)])
         logging.info(versions)
     elif not options.debugoutput:
         logging.warning("No log file specified!"
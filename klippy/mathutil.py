@@ -11,8 +11,65 @@ import queuelogger
 # Coordinate descent
 ######################################################################
 
-# Helper code that implements coordinate descent
-def coordinate_descent(adj_params, params, error_func):
+DESCENT_THRESHOLD = 0.00001
+DESCENT_MAX_ROUNDS = 10000
+
+# Lookup the C helper library (or None if it is not available, such as
+# when this module is used outside of a full klippy installation)
+def _lookup_chelper():
+    try:
+        import chelper
+        return chelper.get_ffi()
+    except Exception:
+        return None, None
+
+# Helper code that implements coordinate descent.  If batch_error_func
+# is provided it is called with a list of candidate params dicts and
+# must return a list of errors (allowing vectorized objectives).
+def coordinate_descent(adj_params, params, error_func, batch_error_func=None):
+    params = dict(params)
+    ffi_main, ffi_lib = _lookup_chelper()
+    if ffi_main is None:
+        return _coordinate_descent_py(adj_params, params, error_func)
+    adj_params = list(adj_params)
+    num_params = len(adj_params)
+    c_params = ffi_main.new("double[]", [params[pn] for pn in adj_params])
+    c_rounds = ffi_main.new("int *")
+    caught = []
+    def eval_candidates(errors, cand, count, num_params):
+        try:
+            trials = []
+            for i in range(count):
+                trial = dict(params)
+                for j, pn in enumerate(adj_params):
+                    trial[pn] = cand[i*num_params + j]
+                trials.append(trial)
+            if batch_error_func is not None:
+                errs = batch_error_func(trials)
+            else:
+                errs = [error_func(trial) for trial in trials]
+            for i in range(count):
+                errors[i] = errs[i]
+        except Exception as e:
+            caught.append(e)
+            for i in range(count):
+                errors[i] = 9e99
+    eval_cb = ffi_main.callback(
+        "void(double *, const double *, int, int)", eval_candidates)
+    logging.info("Coordinate descent initial error: %s", error_func(params))
+    best_err = ffi_lib.coorddesc_solve(num_params, c_params,
+                                       DESCENT_THRESHOLD, DESCENT_MAX_ROUNDS,
+                                       c_rounds, eval_cb)
+    if caught:
+        raise caught[0]
+    logging.info("Coordinate descent best_err: %s  rounds: %d",
+                 best_err, c_rounds[0])
+    for i, pn in enumerate(adj_params):
+        params[pn] = c_params[i]
+    return params
+
+# Pure python fallback implementation of coordinate descent
+def _coordinate_descent_py(adj_params, params, error_func):
     # Define potential changes
     params = dict(params)
     dp = {param_name: 1. for param_name in adj_params}
@@ -20,10 +77,10 @@ def coordinate_descent(adj_params, params, error_func):
     best_err = error_func(params)
     logging.info("Coordinate descent initial error: %s", best_err)
 
-    threshold = 0.00001
+    threshold = DESCENT_THRESHOLD
     rounds = 0
 
-    while sum(dp.values()) > threshold and rounds < 10000:
+    while sum(dp.values()) > threshold and rounds < DESCENT_MAX_ROUNDS:
         rounds += 1
         for param_name in adj_params:
             orig = params[param_name]
@@ -47,14 +104,15 @@ def coordinate_descent(adj_params, params, error_func):
                  best_err, rounds)
     return params
 
-# Helper to run the coordinate descent function in a background
-# process so that it does not block the main thread.
-def background_coordinate_descent(printer, adj_params, params, error_func):
+# Start a background process performing a coordinate descent
+def _start_coordinate_descent(adj_params, params, error_func,
+                              batch_error_func=None):
     parent_conn, child_conn = multiprocessing.Pipe()
     def wrapper():
         queuelogger.clear_bg_logging()
         try:
-            res = coordinate_descent(adj_params, params, error_func)
+            res = coordinate_descent(adj_params, params, error_func,
+                                     batch_error_func)
         except:
             child_conn.send((True, traceback.format_exc()))
             child_conn.close()
@@ -65,6 +123,14 @@ def background_coordinate_descent(printer, adj_params, params, error_func):
     calc_proc = multiprocessing.Process(target=wrapper)
     calc_proc.daemon = True
     calc_proc.start()
+    return parent_conn, calc_proc
+
+# Helper to run the coordinate descent function in a background
+# process so that it does not block the main thread.
+def background_coordinate_descent(printer, adj_params, params, error_func,
+                                  batch_error_func=None):
+    parent_conn, calc_proc = _start_coordinate_descent(
+        adj_params, params, error_func, batch_error_func)
     # Wait for the process to finish
     reactor = printer.get_reactor()
     gcode = printer.lookup_object("gcode")
@@ -82,6 +148,34 @@ def background_coordinate_descent(printer, adj_params, params, error_func):
     parent_conn.close()
     return res
 
+# Run a coordinate descent in the background without blocking the
+# calling code.  Returns a reactor completion that completes with the
+# fit result (or None on an error); 'callback' (if provided) is also
+# invoked with the result from the reactor's main thread.
+def background_coordinate_descent_async(printer, adj_params, params,
+                                        error_func, callback=None,
+                                        batch_error_func=None):
+    parent_conn, calc_proc = _start_coordinate_descent(
+        adj_params, params, error_func, batch_error_func)
+    reactor = printer.get_reactor()
+    completion = reactor.completion()
+    def check_fit(eventtime):
+        if calc_proc.is_alive() and not parent_conn.poll():
+            return eventtime + .1
+        is_err, res = parent_conn.recv()
+        calc_proc.join()
+        parent_conn.close()
+        if is_err:
+            logging.error("Error in background coordinate descent: %s",
+                          (res,))
+            res = None
+        if callback is not None:
+            callback(res)
+        completion.complete(res)
+        return reactor.NEVER
+    reactor.register_timer(check_fit, reactor.NOW)
+    return completion
+
 
 ######################################################################
 # Trilateration
@@ -90,6 +184,33 @@ def background_coordinate_descent(printer, adj_params, params, error_func):
 # Trilateration finds the intersection of three spheres.  See the
 # wikipedia article for the details of the algorithm.
 def trilateration(sphere_coords, radius2):
+    ffi_main, ffi_lib = _lookup_chelper()
+    if ffi_main is None:
+        return _trilateration_py(sphere_coords, radius2)
+    c_coords = ffi_main.new("double[9]",
+                            [c for sc in sphere_coords for c in sc])
+    c_radius2 = ffi_main.new("double[3]", list(radius2))
+    c_out = ffi_main.new("double[3]")
+    ffi_lib.coorddesc_trilateration(c_coords, c_radius2, c_out)
+    return list(c_out)
+
+# Solve a list of independent trilateration problems in one call
+def trilateration_batch(sphere_coords_list, radius2_list):
+    ffi_main, ffi_lib = _lookup_chelper()
+    if ffi_main is None:
+        return [_trilateration_py(sc, r2)
+                for sc, r2 in zip(sphere_coords_list, radius2_list)]
+    count = len(sphere_coords_list)
+    c_coords = ffi_main.new("double[]", [c for scs in sphere_coords_list
+                                         for sc in scs for c in sc])
+    c_radius2 = ffi_main.new("double[]", [r for r2 in radius2_list
+                                          for r in r2])
+    c_out = ffi_main.new("double[]", 3 * count)
+    ffi_lib.coorddesc_trilateration_batch(c_coords, c_radius2, c_out, count)
+    return [list(c_out[3*i:3*i+3]) for i in range(count)]
+
+# Pure python fallback implementation of trilateration
+def _trilateration_py(sphere_coords, radius2):
     sphere_coord1, sphere_coord2, sphere_coord3 = sphere_coords
     s21 = matrix_sub(sphere_coord2, sphere_coord1)
     s31 = matrix_sub(sphere_coord3, sphere_coord1)
@@ -116,12 +116,38 @@ class CommandWrapper:
             cmd_queue = serial.get_default_command_queue()
         self._cmd_queue = cmd_queue
         self._msgtag = msgparser.lookup_msgid(msgformat) & 0xffffffff
+        # Encode directly into queue_message buffers when all the
+        # parameters are plain integers
+        self._mp_format = None
+        if self._cmd.mp_encode_ok:
+            self._mp_format = self._cmd.mp_format
         if conn_helper.get_mcu().is_fileoutput():
             # Can't use send_wait_ack when in debugging mode
             self.send_wait_ack = self.send
     def send(self, data=(), minclock=0, reqclock=0):
+        if self._mp_format is not None:
+            try:
+                self._serial.raw_send_template(
+                    self._mp_format, (data,), minclock, reqclock,
+                    self._cmd_queue)
+                return
+            except (TypeError, OverflowError):
+                pass
         cmd = self._cmd.encode(data)
         self._serial.raw_send(cmd, minclock, reqclock, self._cmd_queue)
+    def send_batch(self, data_batch, minclock=0, reqclock=0):
+        # Encode and queue a series of commands in a single native call
+        if self._mp_format is not None:
+            try:
+                self._serial.raw_send_template(
+                    self._mp_format, data_batch, minclock, reqclock,
+                    self._cmd_queue)
+                return
+            except (TypeError, OverflowError):
+                pass
+        for data in data_batch:
+            cmd = self._cmd.encode(data)
+            self._serial.raw_send(cmd, minclock, reqclock, self._cmd_queue)
     def send_wait_ack(self, data=(), minclock=0, reqclock=0):
         cmd = self._cmd.encode(data)
         self._serial.raw_send_wait_ack(cmd, minclock, reqclock, self._cmd_queue)
@@ -164,7 +190,7 @@ class MCU_trsync:
         self._steppers = []
         self._trdispatch_mcu = None
         self._oid = mcu.create_oid()
-        self._cmd_queue = mcu.alloc_command_queue()
+        self._cmd_queue = mcu.alloc_command_queue(serialhdl.LANE_REALTIME)
         self._response_trsync = None
         self._trsync_start_cmd = self._trsync_set_timeout_cmd = None
         self._trsync_trigger_cmd = self._trsync_query_cmd = None
@@ -212,6 +238,9 @@ class MCU_trsync:
             "trsync_set_timeout oid=%c clock=%u").get_command_tag()
         trigger_cmd = mcu.lookup_command("trsync_trigger oid=%c reason=%c")
         trigger_tag = trigger_cmd.get_command_tag()
+        set_window_tag = mcu.lookup_command(
+            "trsync_set_trigger_window oid=%c clock=%u"
+            " report_ticks=%u").get_command_tag()
         state_cmd = mcu.lookup_command(
             "trsync_state oid=%c can_trigger=%c trigger_reason=%c clock=%u")
         state_tag = state_cmd.get_command_tag()
@@ -219,7 +248,7 @@ class MCU_trsync:
         self._trdispatch_mcu = ffi_main.gc(ffi_lib.trdispatch_mcu_alloc(
             self._trdispatch, mcu._serial.get_serialqueue(), # XXX
             self._cmd_queue, self._oid, set_timeout_tag, trigger_tag,
-            state_tag), ffi_lib.free)
+            set_window_tag, state_tag), ffi_lib.free)
     def _shutdown(self):
         tc = self._trigger_completion
         if tc is not None:
@@ -264,6 +293,12 @@ class MCU_trsync:
                                           reqclock=clock)
     def set_home_end_time(self, home_end_time):
         self._home_end_clock = self._mcu.print_time_to_clock(home_end_time)
+    def set_trigger_window(self, trigger_time, report_time):
+        clock = self._mcu.print_time_to_clock(trigger_time)
+        report_ticks = self._mcu.seconds_to_clock(report_time)
+        ffi_main, ffi_lib = chelper.get_ffi()
+        ffi_lib.trdispatch_mcu_set_trigger_window(self._trdispatch_mcu,
+                                                  clock, report_ticks)
     def stop(self):
         self._response_trsync.unregister()
         self._response_trsync = None
@@ -323,6 +358,12 @@ class TriggerDispatch:
         ffi_lib.trdispatch_start(self._trdispatch, etrsync.REASON_HOST_REQUEST)
         return self._trigger_completion
     def wait_end(self, end_time):
+        expire_timeout = TRSYNC_TIMEOUT
+        if len(self._trsyncs) == 1:
+            expire_timeout = TRSYNC_SINGLE_MCU_TIMEOUT
+        for trsync in self._trsyncs:
+            # Tighten status reporting around the anticipated trigger
+            trsync.set_trigger_window(end_time, expire_timeout * .1)
         etrsync = self._trsyncs[0]
         etrsync.set_home_end_time(end_time)
         if self._mcu.is_fileoutput():
@@ -346,7 +387,6 @@ class MCU_endstop:
         self._oid = self._mcu.create_oid()
         self._home_cmd = self._query_cmd = None
         self._mcu.register_config_callback(self._build_config)
-        self._rest_ticks = 0
         self._dispatch = TriggerDispatch(mcu)
     def get_mcu(self):
         return self._mcu
@@ -370,13 +410,13 @@ class MCU_endstop:
             cq=cmd_queue)
         self._query_cmd = self._mcu.lookup_query_command(
             "endstop_query_state oid=%c",
-            "endstop_state oid=%c homing=%c next_clock=%u pin_value=%c",
+            "endstop_state oid=%c homing=%c next_clock=%u pin_value=%c"
+            " trigger_clock=%u",
             oid=self._oid, cq=cmd_queue)
     def home_start(self, print_time, sample_time, sample_count, rest_time,
                    triggered=True):
         clock = self._mcu.print_time_to_clock(print_time)
         rest_ticks = self._mcu.print_time_to_clock(print_time+rest_time) - clock
-        self._rest_ticks = rest_ticks
         trigger_completion = self._dispatch.start(print_time)
         self._home_cmd.send(
             [self._oid, clock, self._mcu.seconds_to_clock(sample_time),
@@ -396,8 +436,8 @@ class MCU_endstop:
         if self._mcu.is_fileoutput():
             return home_end_time
         params = self._query_cmd.send([self._oid])
-        next_clock = self._mcu.clock32_to_clock64(params['next_clock'])
-        return self._mcu.clock_to_print_time(next_clock - self._rest_ticks)
+        trigger_clock = self._mcu.clock32_to_clock64(params['trigger_clock'])
+        return self._mcu.clock_to_print_time(trigger_clock)
     def query_endstop(self, print_time):
         clock = self._mcu.print_time_to_clock(print_time)
         if self._mcu.is_fileoutput():
@@ -405,6 +445,80 @@ class MCU_endstop:
         params = self._query_cmd.send([self._oid], minclock=clock)
         return params['pin_value'] ^ self._invert
 
+# Coalesce scheduled output updates issued in the same reactor event
+# into batched mcu commands
+class MCU_output_batcher:
+    BATCH_DIGITAL_FMT = '>BII'
+    BATCH_PWM_FMT = '>BIH'
+    # Entries per message are limited by the 64 byte message length
+    BATCH_DIGITAL_MAX = 6
+    BATCH_PWM_MAX = 7
+    def __init__(self, mcu):
+        self._mcu = mcu
+        self._reactor = mcu.get_printer().get_reactor()
+        self._cmd_queue = mcu.alloc_command_queue(serialhdl.LANE_BULK)
+        self._digital_batch_cmd = mcu.try_lookup_command(
+            "queue_digital_out_batch data=%*s", cq=self._cmd_queue)
+        self._pwm_batch_cmd = mcu.try_lookup_command(
+            "queue_pwm_out_batch data=%*s", cq=self._cmd_queue)
+        self._digital = []
+        self._pwm = []
+        self._flush_pending = False
+    def get_command_queue(self):
+        return self._cmd_queue
+    def _note_update(self):
+        if not self._flush_pending:
+            self._flush_pending = True
+            self._reactor.register_callback(self._flush)
+    def queue_digital(self, send_cmd, oid, clock, on_ticks, minclock):
+        if self._digital_batch_cmd is None:
+            send_cmd.send([oid, clock, on_ticks],
+                          minclock=minclock, reqclock=clock)
+            return
+        self._digital.append((clock, send_cmd, oid, on_ticks, minclock))
+        self._note_update()
+    def queue_pwm(self, send_cmd, oid, clock, value, minclock):
+        if self._pwm_batch_cmd is None:
+            send_cmd.send([oid, clock, value],
+                          minclock=minclock, reqclock=clock)
+            return
+        self._pwm.append((clock, send_cmd, oid, value, minclock))
+        self._note_update()
+    def _flush(self, eventtime):
+        self._flush_pending = False
+        digital, self._digital = self._digital, []
+        pwm, self._pwm = self._pwm, []
+        self._send_batches(digital, self._digital_batch_cmd,
+                           self.BATCH_DIGITAL_FMT, self.BATCH_DIGITAL_MAX)
+        self._send_batches(pwm, self._pwm_batch_cmd,
+                           self.BATCH_PWM_FMT, self.BATCH_PWM_MAX)
+    def _send_batches(self, entries, batch_cmd, fmt, max_entries):
+        if not entries:
+            return
+        entries.sort(key=lambda e: e[0])
+        batch = []
+        batch_minclock = 0
+        for entry in entries:
+            minclock = entry[4]
+            # The batch must be transmittable before its first event
+            if batch and (len(batch) >= max_entries
+                          or max(batch_minclock, minclock) > batch[0][0]):
+                self._send_batch(batch_cmd, fmt, batch, batch_minclock)
+                batch = []
+                batch_minclock = 0
+            batch.append(entry)
+            batch_minclock = max(batch_minclock, minclock)
+        self._send_batch(batch_cmd, fmt, batch, batch_minclock)
+    def _send_batch(self, batch_cmd, fmt, batch, minclock):
+        if len(batch) == 1:
+            clock, send_cmd, oid, value, mclock = batch[0]
+            send_cmd.send([oid, clock, value],
+                          minclock=mclock, reqclock=clock)
+            return
+        data = b''.join([struct.pack(fmt, e[2], e[0] & 0xffffffff, e[3])
+                         for e in batch])
+        batch_cmd.send([data], minclock=minclock, reqclock=batch[0][0])
+
 class MCU_digital_out:
     def __init__(self, mcu, pin_params):
         self._mcu = mcu
@@ -416,6 +530,7 @@ class MCU_digital_out:
         self._max_duration = 2.
         self._last_clock = 0
         self._set_cmd = None
+        self._batcher = None
     def get_mcu(self):
         return self._mcu
     def setup_max_duration(self, max_duration):
@@ -439,13 +554,15 @@ class MCU_digital_out:
         self._mcu.add_config_cmd("update_digital_out oid=%d value=%d"
                                  % (self._oid, self._start_value),
                                  on_restart=True)
-        cmd_queue = self._mcu.alloc_command_queue()
+        self._batcher = self._mcu.get_output_batcher()
         self._set_cmd = self._mcu.lookup_command(
-            "queue_digital_out oid=%c clock=%u on_ticks=%u", cq=cmd_queue)
+            "queue_digital_out oid=%c clock=%u on_ticks=%u",
+            cq=self._batcher.get_command_queue())
     def set_digital(self, print_time, value):
         clock = self._mcu.print_time_to_clock(print_time)
-        self._set_cmd.send([self._oid, clock, (not not value) ^ self._invert],
-                           minclock=self._last_clock, reqclock=clock)
+        self._batcher.queue_digital(
+            self._set_cmd, self._oid, clock,
+            (not not value) ^ self._invert, self._last_clock)
         self._last_clock = clock
 
 class MCU_pwm:
@@ -463,6 +580,8 @@ class MCU_pwm:
         self._last_value = .0
         self._pwm_max = 0.
         self._set_cmd = None
+        self._batcher = None
+        self._hw_pwm_cmds = False
     def get_mcu(self):
         return self._mcu
     def setup_max_duration(self, max_duration):
@@ -481,7 +600,8 @@ class MCU_pwm:
         if self._max_duration and self._start_value != self._shutdown_value:
             raise pins.error("Pin with max duration must have start"
                              " value equal to shutdown value")
-        cmd_queue = self._mcu.alloc_command_queue()
+        self._batcher = self._mcu.get_output_batcher()
+        cmd_queue = self._batcher.get_command_queue()
         curtime = self._mcu.get_printer().get_reactor().monotonic()
         printtime = self._mcu.estimated_print_time(curtime)
         self._last_clock = self._mcu.print_time_to_clock(printtime + 0.200)
@@ -505,6 +625,7 @@ class MCU_pwm:
                                      on_restart=True)
             self._set_cmd = self._mcu.lookup_command(
                 "queue_pwm_out oid=%c clock=%u value=%hu", cq=cmd_queue)
+            self._hw_pwm_cmds = True
             return
         # Software PWM
         if self._shutdown_value not in [0., 1.]:
@@ -547,8 +668,12 @@ class MCU_pwm:
             value = 1. - value
         v = int(max(0., min(1., value)) * self._pwm_max + 0.5)
         clock = self._mcu.print_time_to_clock(print_time)
-        self._set_cmd.send([self._oid, clock, v],
-                           minclock=self._last_clock, reqclock=clock)
+        if self._hw_pwm_cmds:
+            self._batcher.queue_pwm(self._set_cmd, self._oid, clock, v,
+                                    self._last_clock)
+        else:
+            self._batcher.queue_digital(self._set_cmd, self._oid, clock, v,
+                                        self._last_clock)
         self._last_clock = clock
         self._last_value = value
 
@@ -567,6 +692,13 @@ class MCU_adc:
         self._unpack_from = struct.Struct('<H').unpack_from
     def get_mcu(self):
         return self._mcu
+    def get_oid(self):
+        return self._oid
+    def get_max_adc(self):
+        # Scale of raw summed adc counts (only valid after mcu config)
+        if not self._inv_max_adc:
+            return 0.
+        return 1. / self._inv_max_adc
     def setup_adc_sample(self, report_time, sample_time=0., sample_count=1,
                          batch_num=1, minval=0., maxval=1.,
                          range_check_count=0):
@@ -793,6 +925,8 @@ class MCUConnectHelper:
         self._emergency_stop_cmd = None
         self._is_shutdown = self._is_timeout = False
         self._shutdown_msg = ""
+        # Connection tracking
+        self._attach_completion = None
         # Register handlers
         printer.register_event_handler("klippy:mcu_identify",
                                        self._mcu_identify)
@@ -869,11 +1003,27 @@ class MCUConnectHelper:
             self._clocksync.connect(self._serial)
         except serialhdl.error as e:
             raise error(str(e))
+    def start_attach(self):
+        if self._attach_completion is None:
+            self._attach_completion = self._reactor.register_callback(
+                self._do_attach)
+    def _do_attach(self, eventtime):
+        try:
+            if self._mcu.is_fileoutput():
+                self._attach_file()
+            else:
+                self._attach()
+        except Exception as e:
+            return e
+        return None
     def _mcu_identify(self):
-        if self._mcu.is_fileoutput():
-            self._attach_file()
-        else:
-            self._attach()
+        # Launch the connection of all mcus in parallel, then wait for
+        # this mcu's connection to complete
+        for name, mcu_obj in self._printer.lookup_objects(module='mcu'):
+            mcu_obj.start_attach()
+        res = self._attach_completion.wait()
+        if res is not None:
+            raise res
         logging.info(self.log_info())
         # Setup shutdown handling
         self._emergency_stop_cmd = self._mcu.lookup_command("emergency_stop")
@@ -920,10 +1070,12 @@ class MCUStatsHelper:
         # Statistics tracking
         self._mcu_freq = 0.
         self._get_status_info = {}
+        self._status_cache = None
         self._stats_sumsq_base = 0.
         self._mcu_tick_avg = 0.
         self._mcu_tick_stddev = 0.
         self._mcu_tick_awake = 0.
+        self._mcu_move_max = 0
         # Register handlers
         printer.register_event_handler("klippy:ready", self._ready)
         printer.register_event_handler("klippy:mcu_identify",
@@ -937,6 +1089,7 @@ class MCUStatsHelper:
         diff = count*tick_sumsq - tick_sum**2
         self._mcu_tick_stddev = c * math.sqrt(max(0., diff))
         self._mcu_tick_awake = tick_sum / self._mcu_freq
+        self._mcu_move_max = params.get('move_max', 0)
     def _mcu_identify(self):
         self._mcu_freq = self._mcu.get_constant_float('CLOCK_FREQ')
         self._stats_sumsq_base = self._mcu.get_constant_float(
@@ -946,6 +1099,7 @@ class MCUStatsHelper:
         self._get_status_info['mcu_version'] = version
         self._get_status_info['mcu_build_versions'] = build_versions
         self._get_status_info['mcu_constants'] = msgparser.get_constants()
+        self._status_cache = None
         self._serial.register_response(self._handle_mcu_stats, 'stats')
     def _ready(self):
         if self._mcu.is_fileoutput():
@@ -964,15 +1118,22 @@ class MCUStatsHelper:
                     % (self._name, mcu_freq_mhz, calc_freq_mhz))
             pconfig.runtime_warning(msg)
     def get_status(self, eventtime=None):
-        return dict(self._get_status_info)
+        # Cached snapshot (treated as immutable by callers) - rebuilt
+        # only after the underlying info changes
+        if self._status_cache is None:
+            self._status_cache = dict(self._get_status_info)
+        return self._status_cache
     def stats(self, eventtime):
-        load = "mcu_awake=%.03f mcu_task_avg=%.06f mcu_task_stddev=%.06f" % (
-            self._mcu_tick_awake, self._mcu_tick_avg, self._mcu_tick_stddev)
+        load = ("mcu_awake=%.03f mcu_task_avg=%.06f mcu_task_stddev=%.06f"
+                " mcu_move_max=%d") % (
+            self._mcu_tick_awake, self._mcu_tick_avg, self._mcu_tick_stddev,
+            self._mcu_move_max)
         stats = ' '.join([load, self._serial.stats(eventtime),
                           self._clocksync.stats(eventtime)])
         parts = [s.split('=', 1) for s in stats.split()]
         last_stats = {k:(float(v) if '.' in v else int(v)) for k, v in parts}
         self._get_status_info['last_stats'] = last_stats
+        self._status_cache = None
         return False, '%s: %s' % (self._name, stats)
 
 # Handle process of configuring an mcu
@@ -994,6 +1155,7 @@ class MCUConfigHelper:
         self._restart_cmds = []
         self._init_cmds = []
         self._config_crc = 0
+        self._section_crcs = {}
         self._mcu_freq = 0.
         self._reserved_move_slots = 0
         # Register handlers
@@ -1014,14 +1176,53 @@ class MCUConfigHelper:
         for cmdlist in (self._config_cmds, self._restart_cmds, self._init_cmds):
             for i, cmd in enumerate(cmdlist):
                 cmdlist[i] = pin_resolver.update_command(cmd)
+        # Calculate per-oid section CRCs (if the MCU can store them)
+        if self._mcu.try_lookup_command(
+                "config_section_crc oid=%c crc=%u") is not None:
+            self._section_crcs = self._calc_section_crcs()
+            self._config_cmds.extend(
+                ["config_section_crc oid=%d crc=%d" % (oid, crc)
+                 for oid, crc in sorted(self._section_crcs.items())])
         # Calculate config CRC
         encoded_config = '\n'.join(self._config_cmds).encode()
         self._config_crc = zlib.crc32(encoded_config) & 0xffffffff
         self._config_cmds.append("finalize_config crc=%d" % (self._config_crc,))
+    def _calc_section_crcs(self):
+        # Group the config commands by their oid and crc each group
+        section_cmds = {}
+        for cmd in self._config_cmds:
+            for part in cmd.split()[1:]:
+                if part.startswith("oid="):
+                    try:
+                        oid = int(part[4:])
+                    except ValueError:
+                        break
+                    section_cmds.setdefault(oid, []).append(cmd)
+                    break
+        return {oid: zlib.crc32('\n'.join(cmds).encode()) & 0xffffffff
+                for oid, cmds in section_cmds.items()}
+    def _describe_crc_mismatch(self):
+        # Query the stored per-oid section CRCs to report what changed
+        if not self._section_crcs or self._mcu.is_fileoutput():
+            return ""
+        try:
+            query = self._mcu.lookup_query_command(
+                "get_config_section oid=%c",
+                "config_section oid=%c crc=%u")
+            changed = [oid for oid in sorted(self._section_crcs)
+                       if query.send([oid])['crc'] != self._section_crcs[oid]]
+        except Exception:
+            logging.exception("Error querying MCU '%s' config sections",
+                              self._name)
+            return ""
+        if not changed:
+            return " (only global config commands changed)"
+        return " (changed config sections: %s)" % (
+            ", ".join(["oid %d" % (oid,) for oid in changed]),)
     def _send_cfg_init_commands(self, cmds):
         try:
-            for c in cmds:
-                self._serial.send(c)
+            msgparser = self._serial.get_msgparser()
+            encoded = [msgparser.create_command(c) for c in cmds]
         except msgproto.enumeration_error as e:
             enum_name, enum_value = e.get_enum_params()
             if enum_name == 'pin':
@@ -1030,6 +1231,16 @@ class MCUConfigHelper:
                     "Pin '%s' is not a valid pin name on mcu '%s'"
                     % (enum_value, self._name))
             raise
+        # Batch the encoded commands into full serialqueue messages
+        cmd_queue = self._serial.get_default_command_queue()
+        batch = []
+        for cmd in encoded:
+            if batch and len(batch) + len(cmd) > msgproto.MESSAGE_PAYLOAD_MAX:
+                self._serial.raw_send(batch, 0, 0, cmd_queue)
+                batch = []
+            batch.extend(cmd)
+        if batch:
+            self._serial.raw_send(batch, 0, 0, cmd_queue)
     def _send_get_config(self):
         get_config_cmd = self._mcu.lookup_query_command(
             "get_config",
@@ -1063,9 +1274,10 @@ class MCUConfigHelper:
                             % (self._name,))
             self._finalize_config()
             if self._config_crc != config_params['crc']:
+                mismatch_note = self._describe_crc_mismatch()
                 restart_helper.check_restart_on_crc_mismatch()
-                raise error("MCU '%s' CRC does not match config"
-                            % (self._name,))
+                raise error("MCU '%s' CRC does not match config%s"
+                            % (self._name, mismatch_note))
             cfg_init_cmds = self._restart_cmds + self._init_cmds
         # Send config and init messages
         self._send_cfg_init_commands(cfg_init_cmds)
@@ -1156,6 +1368,7 @@ class MCU:
         self._serial = self._conn_helper.get_serial()
         self._config_helper = MCUConfigHelper(self, self._conn_helper)
         self._stats_helper = MCUStatsHelper(self, self._conn_helper)
+        self._output_batcher = None
         printer.load_object(config, "error_mcu")
         # Alter time reporting when debugging
         if self.is_fileoutput():
@@ -1168,6 +1381,8 @@ class MCU:
         return self._printer
     def is_fileoutput(self):
         return self._printer.get_start_args().get('debugoutput') is not None
+    def start_attach(self):
+        self._conn_helper.start_attach()
     # MCU Configuration wrappers
     def setup_pin(self, pin_type, pin_params):
         return self._config_helper.setup_pin(pin_type, pin_params)
@@ -1194,16 +1409,22 @@ class MCU:
                              cq=None, is_async=False):
         return CommandQueryWrapper(self._conn_helper, msgformat, respformat,
                                    oid, cq, is_async)
-    def try_lookup_command(self, msgformat):
+    def try_lookup_command(self, msgformat, cq=None):
         try:
-            return self.lookup_command(msgformat)
+            return self.lookup_command(msgformat, cq)
         except self._serial.get_msgparser().error as e:
             return None
-    def alloc_command_queue(self):
-        return self._serial.alloc_command_queue()
+    def alloc_command_queue(self, lane=serialhdl.LANE_NORMAL):
+        return self._serial.alloc_command_queue(lane)
+    def get_output_batcher(self):
+        if self._output_batcher is None:
+            self._output_batcher = MCU_output_batcher(self)
+        return self._output_batcher
     def register_serial_response(self, cb, msg, oid=None):
         return AsyncResponseWrapper(self._conn_helper, self._config_helper,
                                     cb, msg, oid)
+    def alloc_bulk_reader(self, msgformat, oid, ring_size=1024):
+        return self._serial.alloc_bulk_reader(msgformat, oid, ring_size)
     def check_valid_response(self, msgformat):
         try:
             self._serial.get_msgparser().lookup_command(msgformat)
@@ -121,6 +121,12 @@ MessageTypes = {
     '%s': PT_string(), '%.*s': PT_progmem_buffer(), '%*s': PT_buffer(),
 }
 
+# Parameter type ids for the C message codec (mirrors msgproto.c)
+MessageTypeIds = {
+    PT_uint32: 0, PT_int32: 1, PT_uint16: 2, PT_int16: 3, PT_byte: 4,
+    PT_string: 5, PT_progmem_buffer: 5, PT_buffer: 5,
+}
+
 # Lookup the message types for a format string
 def lookup_params(msgformat, enumerations={}):
     out = []
@@ -160,7 +166,7 @@ def convert_msg_format(msgformat):
     return msgformat
 
 class MessageFormat:
-    def __init__(self, msgid_bytes, msgformat, enumerations={}):
+    def __init__(self, msgid_bytes, msgformat, enumerations={}, ffi=None):
         self.msgid_bytes = msgid_bytes
         self.msgformat = msgformat
         self.debugformat = convert_msg_format(msgformat)
@@ -168,7 +174,53 @@ class MessageFormat:
         self.param_names = lookup_params(msgformat, enumerations)
         self.param_types = [t for name, t in self.param_names]
         self.name_to_type = dict(self.param_names)
+        self.mp_format = None
+        self.mp_encode_ok = False
+        if ffi is not None:
+            self._build_c_codec(ffi)
+    def _build_c_codec(self, ffi):
+        # Compile a parse/encode description of this format for the C codec
+        self.ffi_main, self.ffi_lib = ffi
+        ptypes = []
+        self.int_params = []
+        self.str_params = []
+        self.enum_params = []
+        for i, (name, t) in enumerate(self.param_names):
+            pt = t
+            if isinstance(t, Enumeration):
+                self.enum_params.append((name, i, t.reverse_enums))
+                pt = t.pt
+            elif t.is_dynamic_string:
+                self.str_params.append((name, i))
+            else:
+                self.int_params.append((name, i))
+            ptypes.append(MessageTypeIds[type(pt)])
+        mf = self.ffi_lib.msgproto_format_alloc(
+            bytes(bytearray(self.msgid_bytes)), len(self.msgid_bytes),
+            bytes(bytearray(ptypes)), len(ptypes))
+        if mf == self.ffi_main.NULL:
+            return
+        self.mp_format = self.ffi_main.gc(mf, self.ffi_lib.free)
+        self.mp_values = self.ffi_main.new('struct mp_value[]',
+                                           max(1, len(ptypes)))
+        if not self.str_params and not self.enum_params:
+            # All parameters are plain integers - can also encode in C
+            self.mp_encode_ok = True
+            self.mp_encode_buf = self.ffi_main.new(
+                'char[]', len(self.msgid_bytes) + 5 * len(ptypes))
     def encode(self, params):
+        if self.mp_encode_ok:
+            mv = self.mp_values
+            try:
+                for i in range(len(self.param_types)):
+                    mv[i].iv = params[i]
+            except (TypeError, OverflowError):
+                pass
+            else:
+                msglen = self.ffi_lib.msgproto_encode(self.mp_format,
+                                                      self.mp_encode_buf, mv)
+                return list(bytes(self.ffi_main.buffer(self.mp_encode_buf,
+                                                       msglen)))
         out = list(self.msgid_bytes)
         for i, t in enumerate(self.param_types):
             t.encode(out, params[i])
@@ -179,11 +231,31 @@ class MessageFormat:
             t.encode(out, params[name])
         return out
     def parse(self, s, pos):
-        pos += len(self.msgid_bytes)
+        if self.mp_format is None:
+            pos += len(self.msgid_bytes)
+            out = {}
+            for name, t in self.param_names:
+                v, pos = t.parse(s, pos)
+                out[name] = v
+            return out, pos
+        if not isinstance(s, bytes):
+            s = bytes(bytearray(s))
+        mv = self.mp_values
+        pos = self.ffi_lib.msgproto_parse(self.mp_format, s, len(s), pos, mv)
+        if pos < 0:
+            raise error("Unable to parse message '%s'" % (self.name,))
         out = {}
-        for name, t in self.param_names:
-            v, pos = t.parse(s, pos)
-            out[name] = v
+        for name, i in self.int_params:
+            out[name] = mv[i].iv
+        for name, i in self.str_params:
+            spos = mv[i].spos
+            out[name] = s[spos:spos+mv[i].slen]
+        for name, i, reverse_enums in self.enum_params:
+            v = mv[i].iv
+            tv = reverse_enums.get(v)
+            if tv is None:
+                tv = "?%d" % (v,)
+            out[name] = tv
         return out, pos
     def format_params(self, params):
         out = []
@@ -223,10 +295,25 @@ class UnknownFormat:
     def format_params(self, params):
         return "#unknown %s" % (repr(params['#msg']),)
 
+# Cache of decompressed identify data - mcus (possibly on multiple
+# printers hosted in one process) running identical firmware share a
+# single copy of the raw dictionary
+IDENTIFY_CACHE_MAX = 32
+IdentifyCache = {}
+
+def decompress_identify(data):
+    raw = IdentifyCache.get(data)
+    if raw is None:
+        raw = zlib.decompress(data)
+        if len(IdentifyCache) < IDENTIFY_CACHE_MAX:
+            IdentifyCache[data] = raw
+    return raw
+
 class MessageParser:
     error = error
-    def __init__(self, warn_prefix=""):
+    def __init__(self, warn_prefix="", ffi=None):
         self.warn_prefix = warn_prefix
+        self.ffi = ffi
         self.unknown = UnknownFormat()
         self.enumerations = {}
         self.messages = []
@@ -407,13 +494,14 @@ class MessageParser:
                 self.messages_by_id[msgid] = OutputFormat(msgid_bytes,
                                                           msgformat)
             else:
-                msg = MessageFormat(msgid_bytes, msgformat, self.enumerations)
+                msg = MessageFormat(msgid_bytes, msgformat, self.enumerations,
+                                    self.ffi)
                 self.messages_by_id[msgid] = msg
                 self.messages_by_name[msg.name] = msg
     def process_identify(self, data, decompress=True):
         try:
             if decompress:
-                data = zlib.decompress(data)
+                data = decompress_identify(data)
             self.raw_identify_data = data
             data = json.loads(data)
             self.fill_enumerations(data.get('enumerations', {}))
@@ -3,15 +3,58 @@
 # Copyright (C) 2016-2019  Kevin O'Connor <kevin@koconnor.net>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
-import logging, logging.handlers, threading, queue, time
+import logging, logging.handlers, threading, queue, collections, os, time
+
+# Rotated logs are compressed when the (optional) zstandard module is
+# installed
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
+# Maximum number of unwritten debug records held in memory
+DEBUG_RING_SIZE = 5000
+# Idle time (in seconds) before flushing pending debug records
+DEBUG_FLUSH_TIME = 2.
+
+# Bounded ring of raw debug records (oldest records drop on overrun so
+# that verbose logging can never block or exhaust memory)
+class DebugRing:
+    def __init__(self):
+        self.ring = collections.deque(maxlen=DEBUG_RING_SIZE)
+        self.push_count = self.pop_count = 0
+    def append(self, record):
+        self.ring.append(record)
+        self.push_count += 1
+    def drain(self):
+        out = []
+        while 1:
+            try:
+                out.append(self.ring.popleft())
+            except IndexError:
+                break
+        self.pop_count += len(out)
+        dropped = self.push_count - self.pop_count - len(self.ring)
+        if dropped:
+            self.pop_count += dropped
+            out.append(logging.makeLogRecord(
+                {'msg': "Dropped %d debug log lines" % (dropped,),
+                 'level': logging.INFO}))
+        return out
 
 # Class to forward all messages through a queue to a background thread
 class QueueHandler(logging.Handler):
-    def __init__(self, queue):
+    def __init__(self, queue, debug_ring):
         logging.Handler.__init__(self)
         self.queue = queue
+        self.debug_ring = debug_ring
     def emit(self, record):
         try:
+            if record.levelno <= logging.DEBUG and not record.exc_info:
+                # High-rate debug records are stored raw and only
+                # serialized when the background thread writes them
+                self.debug_ring.append(record)
+                return
             self.format(record)
             record.msg = record.message
             record.args = None
@@ -25,16 +68,57 @@ class QueueListener(logging.handlers.TimedRotatingFileHandler):
     def __init__(self, filename):
         logging.handlers.TimedRotatingFileHandler.__init__(
             self, filename, when='midnight', backupCount=5)
+        self.rotator = self._rotator
+        self.namer = self._namer
         self.bg_queue = queue.Queue()
+        self.debug_ring = DebugRing()
         self.bg_thread = threading.Thread(target=self._bg_thread)
         self.bg_thread.start()
         self.rollover_info = {}
     def _bg_thread(self):
-        while 1:
-            record = self.bg_queue.get(True)
+        done = False
+        while not done:
+            try:
+                record = self.bg_queue.get(True, DEBUG_FLUSH_TIME)
+            except queue.Empty:
+                self._write_records([])
+                continue
             if record is None:
                 break
-            self.handle(record)
+            # Drain any further pending records and write them as a batch
+            records = [record]
+            while 1:
+                try:
+                    record = self.bg_queue.get_nowait()
+                except queue.Empty:
+                    break
+                if record is None:
+                    done = True
+                    break
+                records.append(record)
+            self._write_records(records)
+        self._write_records([])
+    def _write_records(self, records):
+        # Interleave any pending debug records in timestamp order
+        debug_records = self.debug_ring.drain()
+        if debug_records:
+            records = sorted(records + debug_records,
+                             key=lambda r: r.created)
+        if not records:
+            return
+        lines = []
+        for record in records:
+            try:
+                lines.append(self.format(record))
+            except Exception:
+                self.handleError(record)
+        try:
+            if self.shouldRollover(records[-1]):
+                self.doRollover()
+            self.stream.write('\n'.join(lines) + '\n')
+            self.stream.flush()
+        except Exception:
+            self.handleError(records[-1])
     def stop(self):
         self.bg_queue.put_nowait(None)
         self.bg_thread.join()
@@ -54,13 +138,50 @@ class QueueListener(logging.handlers.TimedRotatingFileHandler):
                 time.asctime(),))
         self.emit(logging.makeLogRecord(
             {'msg': "\n".join(lines), 'level': logging.INFO}))
+    def _namer(self, name):
+        if zstandard is None:
+            return name
+        return name + ".zst"
+    def _rotator(self, source, dest):
+        if not os.path.exists(source):
+            return
+        if zstandard is None:
+            os.rename(source, dest)
+            return
+        # Compress in a separate thread so a large log does not stall
+        # the logging queue during rollover
+        tmpname = dest + ".tmp"
+        os.rename(source, tmpname)
+        ct = threading.Thread(target=self._compress_thread,
+                              args=(tmpname, dest))
+        ct.start()
+    def _compress_thread(self, source, dest):
+        try:
+            with open(source, 'rb') as src, open(dest, 'wb') as dst:
+                zstandard.ZstdCompressor().copy_stream(src, dst)
+            os.unlink(source)
+        except Exception:
+            logging.exception("Error compressing rotated log")
+    def getFilesToDelete(self):
+        if zstandard is None:
+            return logging.handlers.TimedRotatingFileHandler \
+                .getFilesToDelete(self)
+        dir_name, base_name = os.path.split(self.baseFilename)
+        prefix = base_name + "."
+        result = [os.path.join(dir_name, fname)
+                  for fname in os.listdir(dir_name)
+                  if fname.startswith(prefix) and fname.endswith(".zst")]
+        result.sort()
+        if len(result) <= self.backupCount:
+            return []
+        return result[:len(result) - self.backupCount]
 
 MainQueueHandler = None
 
 def setup_bg_logging(filename, debuglevel):
     global MainQueueHandler
     ql = QueueListener(filename)
-    MainQueueHandler = QueueHandler(ql.bg_queue)
+    MainQueueHandler = QueueHandler(ql.bg_queue, ql.debug_ring)
     root = logging.getLogger()
     root.addHandler(MainQueueHandler)
     root.setLevel(debuglevel)
@@ -18,6 +18,9 @@ class ReactorTimer:
         self.callback = callback
         self.waketime = waketime
         self.timer_is_running = False
+        # Tolerated wake-up delay (see set_timer_jitter) and fire count
+        self.jitter = 0.
+        self.nfires = 0
 
 class ReactorCompletion:
     class sentinel: pass
@@ -130,6 +133,8 @@ class SelectReactor:
         self._cached_dispatch_greenlets = []
         self._all_greenlets = []
         self._prevent_pause_count = 0
+        # Currently running handler (read by sampling profilers)
+        self._active_handler = None
     # Python garbage collection
     def get_gc_stats(self):
         return tuple(self._last_gc_times)
@@ -153,7 +158,8 @@ class SelectReactor:
         if timer_handler.timer_is_running:
             return
         timer_handler.waketime = waketime
-        self._next_timer = min(self._next_timer, waketime)
+        self._next_timer = min(self._next_timer,
+                               waketime + timer_handler.jitter)
     def register_timer(self, callback, waketime=NEVER):
         timer_handler = ReactorTimer(callback, waketime)
         timers = list(self._timers)
@@ -166,6 +172,22 @@ class SelectReactor:
         timers = list(self._timers)
         timers.pop(timers.index(timer_handler))
         self._timers = timers
+    def set_timer_jitter(self, timer_handler, jitter):
+        # Declare the wake-up delay a low-priority periodic timer
+        # tolerates.  The timer never forces a wake-up before
+        # waketime+jitter, but runs at any wake-up occurring after its
+        # waketime - coalescing it with other events when idle.
+        timer_handler.jitter = jitter
+    def get_timer_stats(self):
+        # Report wake-up sources (for idle-wake diagnostics)
+        out = []
+        for t in self._timers:
+            cb = t.callback
+            name = "%s.%s" % (getattr(cb, '__module__', '?'),
+                              getattr(cb, '__qualname__', repr(cb)))
+            out.append({'name': name, 'fires': t.nfires, 'jitter': t.jitter,
+                        'waketime': t.waketime})
+        return out
     def _check_timers(self, eventtime, busy):
         if eventtime < self._next_timer:
             if busy:
@@ -181,13 +203,17 @@ class SelectReactor:
             if eventtime >= waketime:
                 t.waketime = self.NEVER
                 t.timer_is_running = True
+                t.nfires += 1
+                self._active_handler = t.callback
                 t.waketime = waketime = t.callback(eventtime)
+                self._active_handler = None
                 t.timer_is_running = False
                 if g_dispatch is not self._g_dispatch:
-                    self._next_timer = min(self._next_timer, waketime)
+                    self._next_timer = min(self._next_timer,
+                                           waketime + t.jitter)
                     self._end_greenlet(g_dispatch)
                     return 0.
-            self._next_timer = min(self._next_timer, waketime)
+            self._next_timer = min(self._next_timer, waketime + t.jitter)
         return 0.
     # Callbacks and Completions
     def completion(self):
@@ -267,6 +293,10 @@ class SelectReactor:
         self._g_dispatch.switch(self.NEVER)
         # This greenlet reactivated from pause() - return to main dispatch loop
         self._g_dispatch = g_old
+    def get_active_handler(self):
+        # Handler most recently dispatched (may be read from another
+        # thread for sampling attribution)
+        return self._active_handler
     # Support for temporarily disabling pauses
     def assert_no_pause(self):
         return ReactorPreventPause(self)
@@ -302,12 +332,16 @@ class SelectReactor:
         for fd, event in hdls:
             hdl = self._fds.get(fd, self._dummy_fd_hdl)
             if event & self._READ:
+                self._active_handler = hdl.read_callback
                 hdl.read_callback(eventtime)
+                self._active_handler = None
                 if g_dispatch is not self._g_dispatch:
                     self._end_greenlet(g_dispatch)
                     return self.monotonic()
             if event & self._WRITE:
+                self._active_handler = hdl.write_callback
                 hdl.write_callback(eventtime)
+                self._active_handler = None
                 if g_dispatch is not self._g_dispatch:
                     self._end_greenlet(g_dispatch)
                     return self.monotonic()
@@ -427,9 +461,140 @@ class EPollReactor(SelectReactor):
                 busy = True
                 eventtime = self._check_fds(eventtime, res)
 
-# Use the poll based reactor if it is available
-try:
-    select.poll
-    Reactor = PollReactor
-except:
-    Reactor = SelectReactor
+class CReactor(SelectReactor):
+    def __init__(self, gc_checking=False):
+        SelectReactor.__init__(self, gc_checking)
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        hr = self.ffi_lib.hostreactor_alloc()
+        if hr == self.ffi_main.NULL:
+            raise ReactorError("C reactor core not available")
+        self._hostreactor = self.ffi_main.gc(hr, self.ffi_lib.hostreactor_free)
+        self._timers_by_id = {}
+        self._timer_ids = self.ffi_main.new('int[]', MAX_REACTOR_EVENTS)
+        self._fd_events = self.ffi_main.new('struct hr_fd_event[]',
+                                            MAX_REACTOR_EVENTS)
+    # Timers
+    def update_timer(self, timer_handler, waketime):
+        if timer_handler.timer_is_running:
+            return
+        if self._timers_by_id.get(timer_handler.timer_id) is not timer_handler:
+            # Timer is no longer registered
+            return
+        timer_handler.waketime = waketime
+        self.ffi_lib.hostreactor_update_timer(self._hostreactor,
+                                              timer_handler.timer_id, waketime)
+    def register_timer(self, callback, waketime=NEVER):
+        timer_handler = ReactorTimer(callback, waketime)
+        tid = self.ffi_lib.hostreactor_alloc_timer(self._hostreactor, waketime)
+        timer_handler.timer_id = tid
+        self._timers_by_id[tid] = timer_handler
+        return timer_handler
+    def unregister_timer(self, timer_handler):
+        timer_handler.waketime = self.NEVER
+        del self._timers_by_id[timer_handler.timer_id]
+        self.ffi_lib.hostreactor_free_timer(self._hostreactor,
+                                            timer_handler.timer_id)
+    def set_timer_jitter(self, timer_handler, jitter):
+        timer_handler.jitter = jitter
+        if self._timers_by_id.get(timer_handler.timer_id) is timer_handler:
+            self.ffi_lib.hostreactor_set_timer_jitter(
+                self._hostreactor, timer_handler.timer_id, jitter)
+    def get_timer_stats(self):
+        out = []
+        for t in self._timers_by_id.values():
+            cb = t.callback
+            name = "%s.%s" % (getattr(cb, '__module__', '?'),
+                              getattr(cb, '__qualname__', repr(cb)))
+            out.append({'name': name, 'fires': t.nfires, 'jitter': t.jitter,
+                        'waketime': t.waketime})
+        return out
+    def _check_timers(self, eventtime, busy):
+        ffi_lib = self.ffi_lib
+        next_timer = ffi_lib.hostreactor_next_timer(self._hostreactor)
+        if eventtime < next_timer:
+            if busy:
+                return 0.
+            gc_busy = self._check_gc(eventtime)
+            if gc_busy:
+                return 0.
+            return min(1., max(.001, next_timer - eventtime))
+        g_dispatch = self._g_dispatch
+        tids = self._timer_ids
+        count = ffi_lib.hostreactor_check_timers(self._hostreactor, eventtime,
+                                                 tids, MAX_REACTOR_EVENTS)
+        timers_by_id = self._timers_by_id
+        for i in range(count):
+            t = timers_by_id.get(tids[i])
+            if t is None or t.waketime > eventtime:
+                # Timer was unregistered (or reallocated) by an
+                # earlier callback in this batch
+                continue
+            t.timer_is_running = True
+            t.nfires += 1
+            self._active_handler = t.callback
+            waketime = t.callback(eventtime)
+            self._active_handler = None
+            t.timer_is_running = False
+            t.waketime = waketime
+            if timers_by_id.get(t.timer_id) is t:
+                ffi_lib.hostreactor_update_timer(self._hostreactor,
+                                                 t.timer_id, waketime)
+            if g_dispatch is not self._g_dispatch:
+                # Timer callback paused - reschedule remaining due timers
+                for j in range(i+1, count):
+                    t2 = timers_by_id.get(tids[j])
+                    if t2 is not None and not t2.timer_is_running:
+                        ffi_lib.hostreactor_update_timer(self._hostreactor,
+                                                         t2.timer_id,
+                                                         t2.waketime)
+                self._end_greenlet(g_dispatch)
+                return 0.
+        return 0.
+    # File descriptors
+    def register_fd(self, fd, read_callback, write_callback=None):
+        file_handler = ReactorFileHandler(fd, read_callback, write_callback)
+        self._fds[fd] = file_handler
+        self.ffi_lib.hostreactor_register_fd(self._hostreactor, fd)
+        return file_handler
+    def unregister_fd(self, file_handler):
+        self.ffi_lib.hostreactor_unregister_fd(self._hostreactor,
+                                               file_handler.fd)
+        del self._fds[file_handler.fd]
+    def set_fd_wake(self, file_handler, is_readable=True, is_writeable=False):
+        flags = (self._READ if is_readable else 0) \
+            | (self._WRITE if is_writeable else 0)
+        self.ffi_lib.hostreactor_set_fd_wake(self._hostreactor,
+                                             file_handler.fd, flags)
+    # Main loop
+    def _dispatch_loop(self):
+        busy = True
+        eventtime = self.monotonic()
+        while self._process:
+            timeout = self._check_timers(eventtime, busy)
+            busy = False
+            res = self.ffi_lib.hostreactor_wait(self._hostreactor, timeout,
+                                                self._fd_events,
+                                                MAX_REACTOR_EVENTS)
+            eventtime = self.monotonic()
+            if res > 0:
+                busy = True
+                fd_events = self._fd_events
+                hdls = [(fd_events[i].fd, fd_events[i].flags)
+                        for i in range(res)]
+                eventtime = self._check_fds(eventtime, hdls)
+            elif res < 0:
+                raise ReactorError("Error in reactor epoll wait")
+
+MAX_REACTOR_EVENTS = 64
+
+# Use the C reactor if available, or the poll based reactor otherwise
+def Reactor(gc_checking=False):
+    try:
+        return CReactor(gc_checking)
+    except ReactorError:
+        pass
+    try:
+        select.poll
+        return PollReactor(gc_checking)
+    except:
+        return SelectReactor(gc_checking)
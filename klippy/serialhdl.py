@@ -3,7 +3,7 @@
 # Copyright (C) 2016-2021  Kevin O'Connor <kevin@koconnor.net>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
-import logging, threading, os
+import logging, threading, os, hashlib
 import serial
 
 import msgproto, chelper, util
@@ -11,6 +11,58 @@ import msgproto, chelper, util
 class error(Exception):
     pass
 
+# Number of log-scale latency histogram buckets (must match serialqueue.c)
+SQ_LATENCY_BUCKETS = 32
+
+# Transmit priority lanes (must match serialqueue.h)
+LANE_REALTIME, LANE_NORMAL, LANE_BULK = 0, 1, 2
+
+# Link quality scoring (exponential average of clean vs resent bytes)
+LINK_QUALITY_DECAY = 0.75
+LINK_QUALITY_WARN = 0.90
+LINK_QUALITY_WARN_INTERVAL = 30.
+
+# Data dictionary "identify" transfer tuning
+IDENTIFY_CHUNK = 40
+IDENTIFY_WINDOW = 8
+IDENTIFY_CACHE_DIR = os.path.expanduser("~/.cache/klipper/mcu_dicts")
+
+# Cache of raw mcu data dictionaries (keyed by a hash of the first chunk)
+def _identify_cache_read(key):
+    try:
+        f = open(os.path.join(IDENTIFY_CACHE_DIR, key), 'rb')
+        data = f.read()
+        f.close()
+        return data
+    except OSError:
+        return None
+
+def _identify_cache_write(key, data):
+    try:
+        if not os.path.isdir(IDENTIFY_CACHE_DIR):
+            os.makedirs(IDENTIFY_CACHE_DIR)
+        tmpname = os.path.join(IDENTIFY_CACHE_DIR,
+                               "%s.tmp%d" % (key, os.getpid()))
+        f = open(tmpname, 'wb')
+        f.write(data)
+        f.close()
+        os.rename(tmpname, os.path.join(IDENTIFY_CACHE_DIR, key))
+    except OSError:
+        pass
+
+# Return the upper bound (in seconds) of the given histogram percentile
+def histogram_percentile(counts, percentile):
+    total = sum(counts)
+    if not total:
+        return 0.
+    want = total * percentile
+    cumulative = 0
+    for bucket, count in enumerate(counts):
+        cumulative += count
+        if cumulative >= want:
+            return 2.**(bucket + 1) / 1000000.
+    return 2.**SQ_LATENCY_BUCKETS / 1000000.
+
 class SerialReader:
     def __init__(self, reactor, mcu_name=""):
         self.reactor = reactor
@@ -22,17 +74,26 @@ class SerialReader:
         self.sq_name = sq_name.encode("utf-8")
         # Serial port
         self.serial_dev = None
-        self.msgparser = msgproto.MessageParser(warn_prefix=self.warn_prefix)
         # C interface
         self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.msgparser = msgproto.MessageParser(
+            warn_prefix=self.warn_prefix, ffi=(self.ffi_main, self.ffi_lib))
         self.serialqueue = None
         self.default_cmd_queue = self.alloc_command_queue()
         self.stats_buf = self.ffi_main.new('char[4096]')
+        self.latency_buf = self.ffi_main.new('uint32_t[]',
+                                             3 * SQ_LATENCY_BUCKETS)
+        # Link quality tracking
+        self.link_quality = 1.
+        self.last_bytes_write = self.last_bytes_retransmit = 0
+        self.last_bytes_invalid = 0
+        self.last_quality_warn_time = 0.
         # Threading
         self.lock = threading.Lock()
         self.background_thread = None
         # Message handlers
         self.handlers = {}
+        self.handlers_gen = 0
         self.register_response(self._handle_unknown_init, '#unknown')
         self.register_response(self.handle_output, '#output')
         # Sent message notification tracking
@@ -42,6 +103,8 @@ class SerialReader:
         name_short = ("serialhdl %s" % (self.mcu_name))[:15]
         self.ffi_lib.set_thread_name(name_short.encode('utf-8'))
         response = self.ffi_main.new('struct pull_queue_message *')
+        hdl_cache = {}
+        hdl_gen = -1
         while 1:
             self.ffi_lib.serialqueue_pull(self.serialqueue, response)
             count = response.len
@@ -53,36 +116,91 @@ class SerialReader:
                 completion = self.pending_notifications.pop(response.notify_id)
                 self.reactor.async_complete(completion, params)
                 continue
-            params = self.msgparser.parse(response.msg[0:count])
+            msg = bytes(self.ffi_main.buffer(response.msg, count))
+            params = self.msgparser.parse(msg)
             params['#sent_time'] = response.sent_time
             params['#receive_time'] = response.receive_time
-            hdl = (params['#name'], params.get('oid'))
-            try:
+            if hdl_gen != self.handlers_gen:
+                # Handler table changed - take a new snapshot so the
+                # per-message lookup can run without taking the lock
                 with self.lock:
-                    hdl = self.handlers.get(hdl, self.handle_default)
-                    hdl(params)
+                    hdl_gen = self.handlers_gen
+                    hdl_cache = dict(self.handlers)
+            hdl = hdl_cache.get((params['#name'], params.get('oid')),
+                                self.handle_default)
+            try:
+                hdl(params)
             except:
                 logging.exception("%sException in serial callback",
                                   self.warn_prefix)
     def _error(self, msg, *params):
         raise error(self.warn_prefix + (msg % params))
-    def _get_identify_data(self, eventtime):
-        # Query the "data dictionary" from the micro-controller
+    def _fetch_identify_chunk(self, responses, offset):
+        # Wait for a queued identify response (re-requesting if needed)
+        retries = 5
+        retry_delay = .010
+        while 1:
+            if offset not in responses:
+                msg = "identify offset=%d count=%d" % (offset, IDENTIFY_CHUNK)
+                cmd = self.msgparser.create_command(msg)
+                self.raw_send_wait_ack(cmd, 0, 0, self.default_cmd_queue)
+            if offset in responses:
+                return responses.pop(offset)
+            if retries <= 0:
+                self._error("Unable to obtain identify response")
+            self.reactor.pause(self.reactor.monotonic() + retry_delay)
+            retries -= 1
+            retry_delay *= 2.
+    def _check_identify_cache(self, responses, cache_key):
+        cached = _identify_cache_read(cache_key)
+        if cached is None or len(cached) <= IDENTIFY_CHUNK:
+            return None
+        # Verify length and tail (which contains the zlib checksum of
+        # the full dictionary) against the micro-controller copy
+        tail = len(cached) - IDENTIFY_CHUNK
+        if (self._fetch_identify_chunk(responses, tail) != cached[tail:]
+            or self._fetch_identify_chunk(responses, len(cached))):
+            return None
+        logging.info("%sLoaded mcu dictionary from cache", self.warn_prefix)
+        return cached
+    def _query_identify_data(self, responses):
+        # Keep a window of requests in flight to hide link round-trip
+        # latency (a large win on canbus connections)
         identify_data = b""
+        requested = 0
+        cache_key = None
         while 1:
-            msg = "identify offset=%d count=%d" % (len(identify_data), 40)
-            try:
-                params = self.send_with_response(msg, 'identify_response')
-            except error as e:
-                logging.exception("%sWait for identify_response",
-                                  self.warn_prefix)
-                return None
-            if params['offset'] == len(identify_data):
-                msgdata = params['data']
-                if not msgdata:
-                    # Done
-                    return identify_data
-                identify_data += msgdata
+            offset = len(identify_data)
+            while requested < offset + IDENTIFY_WINDOW * IDENTIFY_CHUNK:
+                self.send("identify offset=%d count=%d"
+                          % (requested, IDENTIFY_CHUNK))
+                requested += IDENTIFY_CHUNK
+            msgdata = self._fetch_identify_chunk(responses, offset)
+            if offset == 0 and len(msgdata) >= IDENTIFY_CHUNK:
+                # Check for a previously cached copy of this dictionary
+                cache_key = hashlib.sha256(msgdata).hexdigest()
+                cached = self._check_identify_cache(responses, cache_key)
+                if cached is not None:
+                    return cached
+            if not msgdata:
+                # Done
+                if cache_key is not None:
+                    _identify_cache_write(cache_key, identify_data)
+                return identify_data
+            identify_data += msgdata
+    def _get_identify_data(self, eventtime):
+        # Query the "data dictionary" from the micro-controller
+        responses = {}
+        def handle_identify_response(params):
+            responses[params['offset']] = params['data']
+        self.register_response(handle_identify_response, 'identify_response')
+        try:
+            return self._query_identify_data(responses)
+        except error as e:
+            logging.exception("%sWait for identify_response", self.warn_prefix)
+            return None
+        finally:
+            self.register_response(None, 'identify_response')
     def _start_session(self, serial_dev, serial_fd_type=b'u', client_id=0):
         self.serial_dev = serial_dev
         self.serialqueue = self.ffi_main.gc(
@@ -99,13 +217,20 @@ class SerialReader:
             logging.info("%sTimeout on connect", self.warn_prefix)
             self.disconnect()
             return False
-        msgparser = msgproto.MessageParser(warn_prefix=self.warn_prefix)
+        msgparser = msgproto.MessageParser(
+            warn_prefix=self.warn_prefix, ffi=(self.ffi_main, self.ffi_lib))
         msgparser.process_identify(identify_data)
         self.msgparser = msgparser
         self.register_response(self.handle_unknown, '#unknown')
         # Setup baud adjust
         if serial_fd_type == b'c':
             wire_freq = msgparser.get_constant_float('CANBUS_FREQUENCY', None)
+            fd_data_freq = msgparser.get_constant_float(
+                'CANBUS_FD_DATA_FREQUENCY', None)
+            if fd_data_freq is not None:
+                # Firmware transmits CAN-FD frames with bit-rate
+                # switching - do the same on the transmit path
+                self.ffi_lib.serialqueue_set_canbus_fd(self.serialqueue)
         else:
             wire_freq = msgparser.get_constant_float('SERIAL_BAUD', None)
         if wire_freq is not None:
@@ -116,6 +241,9 @@ class SerialReader:
             self.ffi_lib.serialqueue_set_receive_window(
                 self.serialqueue, receive_window)
         return True
+    def bond_secondary_fd(self, fd):
+        # Stripe bulk traffic across a second physical link to the mcu
+        self.ffi_lib.serialqueue_set_secondary_fd(self.serialqueue, fd)
     def connect_canbus(self, canbus_uuid, canbus_nodeid, canbus_iface="can0"):
         import can # XXX
         txid = canbus_nodeid * 2 + 256
@@ -140,9 +268,12 @@ class SerialReader:
             if self.reactor.monotonic() > start_time + 90.:
                 self._error("Unable to connect")
             try:
+                # Open with fd=True so that CAN-FD frames from the mcu
+                # are delivered (harmless on a classic CAN interface as
+                # the admin messages remain 8 byte classic frames)
                 bus = can.interface.Bus(channel=canbus_iface,
                                         can_filters=filters,
-                                        bustype='socketcan')
+                                        bustype='socketcan', fd=True)
                 bus.send(set_id_msg)
             except (can.CanError, os.error, IOError) as e:
                 logging.warning("%sUnable to open CAN port: %s",
@@ -231,7 +362,43 @@ class SerialReader:
             return ""
         self.ffi_lib.serialqueue_get_stats(self.serialqueue,
                                            self.stats_buf, len(self.stats_buf))
-        return str(self.ffi_main.string(self.stats_buf).decode())
+        stats = str(self.ffi_main.string(self.stats_buf).decode())
+        self.ffi_lib.serialqueue_get_latency_histograms(self.serialqueue,
+                                                        self.latency_buf)
+        parts = [stats, self._check_link_quality(stats, eventtime)]
+        for i, name in enumerate(('dwell', 'rtt', 'wakeup')):
+            counts = list(self.latency_buf[i*SQ_LATENCY_BUCKETS
+                                           :(i+1)*SQ_LATENCY_BUCKETS])
+            parts.append("%s_p99=%.6f %s_p999=%.6f"
+                         % (name, histogram_percentile(counts, .99),
+                            name, histogram_percentile(counts, .999)))
+        return ' '.join(parts)
+    def _check_link_quality(self, stats, eventtime):
+        # Score the fraction of cleanly delivered bytes since the last
+        # stats interval and fold it into an exponential average
+        fields = dict(p.split('=', 1) for p in stats.split())
+        bytes_write = int(fields['bytes_write'])
+        bytes_retransmit = int(fields['bytes_retransmit'])
+        bytes_invalid = int(fields['bytes_invalid'])
+        good = bytes_write - self.last_bytes_write
+        bad = (bytes_retransmit - self.last_bytes_retransmit
+               + bytes_invalid - self.last_bytes_invalid)
+        self.last_bytes_write = bytes_write
+        self.last_bytes_retransmit = bytes_retransmit
+        self.last_bytes_invalid = bytes_invalid
+        if good + bad > 0:
+            sample = good / (good + bad)
+            self.link_quality = (LINK_QUALITY_DECAY * self.link_quality
+                                 + (1. - LINK_QUALITY_DECAY) * sample)
+        if (self.link_quality < LINK_QUALITY_WARN and bad > 0
+            and eventtime > (self.last_quality_warn_time
+                             + LINK_QUALITY_WARN_INTERVAL)):
+            self.last_quality_warn_time = eventtime
+            logging.warning(
+                "%sDegraded link quality %.3f (%d bytes resent or invalid"
+                " in last interval) - check wiring and bitrate",
+                self.warn_prefix, self.link_quality, bad)
+        return "link_quality=%.3f" % (self.link_quality,)
     def get_reactor(self):
         return self.reactor
     def get_msgparser(self):
@@ -247,10 +414,27 @@ class SerialReader:
                 del self.handlers[name, oid]
             else:
                 self.handlers[name, oid] = callback
+            self.handlers_gen += 1
+    def alloc_bulk_reader(self, msgformat, oid, ring_size=1024):
+        if self.serialqueue is None or oid is None:
+            return None
+        try:
+            return BulkMessageReader(self, msgformat, oid, ring_size)
+        except (error, self.msgparser.error) as e:
+            logging.info("%sNo bulk reader for '%s': %s",
+                         self.warn_prefix, msgformat, e)
+            return None
     # Command sending
     def raw_send(self, cmd, minclock, reqclock, cmd_queue):
         self.ffi_lib.serialqueue_send(self.serialqueue, cmd_queue,
                                       cmd, len(cmd), minclock, reqclock, 0)
+    def raw_send_template(self, mp_format, data_batch, minclock, reqclock,
+                          cmd_queue):
+        params = self.ffi_main.new(
+            'int64_t[]', [v for data in data_batch for v in data])
+        self.ffi_lib.serialqueue_send_template(
+            self.serialqueue, cmd_queue, mp_format, params, len(data_batch),
+            minclock, reqclock)
     def raw_send_wait_ack(self, cmd, minclock, reqclock, cmd_queue):
         self.last_notify_id += 1
         nid = self.last_notify_id
@@ -269,9 +453,12 @@ class SerialReader:
         cmd = self.msgparser.create_command(msg)
         src = SerialRetryCommand(self, response)
         return src.get_response([cmd], self.default_cmd_queue)
-    def alloc_command_queue(self):
-        return self.ffi_main.gc(self.ffi_lib.serialqueue_alloc_commandqueue(),
-                                self.ffi_lib.serialqueue_free_commandqueue)
+    def alloc_command_queue(self, lane=LANE_NORMAL):
+        cq = self.ffi_main.gc(self.ffi_lib.serialqueue_alloc_commandqueue(),
+                              self.ffi_lib.serialqueue_free_commandqueue)
+        if lane != LANE_NORMAL:
+            self.ffi_lib.serialqueue_set_commandqueue_lane(cq, lane)
+        return cq
     # Dumping debug lists
     def dump_debug(self):
         out = []
@@ -309,6 +496,66 @@ class SerialReader:
     def handle_default(self, params):
         logging.warning("%sgot %s", self.warn_prefix, params)
 
+# Read high-rate messages directly from a serialqueue consumer ring.
+# Matching messages bypass the normal receive queue and callback
+# dispatch - the background C thread copies their payloads into a ring
+# that is decoded here on each pull() invocation.
+class BulkMessageReader:
+    def __init__(self, serial, msgformat, oid, ring_size):
+        self.ffi_main = serial.ffi_main
+        self.ffi_lib = serial.ffi_lib
+        mp = serial.get_msgparser().lookup_command(msgformat)
+        pnames = mp.param_names
+        if not pnames or pnames[0][0] != 'oid':
+            raise error("Bulk reader message must have a leading oid")
+        # The message prefix is the encoded msgid and oid
+        prefix = list(mp.msgid_bytes)
+        pnames[0][1].encode(prefix, oid)
+        # Remaining parameters must be integers with an optional
+        # trailing buffer (a limitation of the C payload scanner)
+        self.int_params = []
+        self.buffer_param = None
+        for i, (name, t) in enumerate(pnames[1:]):
+            if t.is_dynamic_string:
+                if i != len(pnames) - 2:
+                    raise error("Bulk reader buffer must be last parameter")
+                self.buffer_param = name
+            elif not t.is_int:
+                raise error("Bulk reader does not support enumerations")
+            else:
+                self.int_params.append((name, t))
+        self.bulkreader = self.ffi_lib.serialqueue_alloc_bulkreader(
+            serial.serialqueue, bytes(bytearray(prefix)), len(prefix),
+            len(self.int_params), ring_size)
+        self.pending_pop = 0
+        self.overflows = 0
+    def pull(self):
+        # Release the samples handed out by the previous pull()
+        if self.pending_pop:
+            self.ffi_lib.serialqueue_bulkreader_pop(self.bulkreader,
+                                                    self.pending_pop)
+        # Decode all pending samples (as memoryviews into the ring)
+        count = self.ffi_lib.serialqueue_bulkreader_count(self.bulkreader)
+        self.pending_pop = count
+        out = []
+        for i in range(count):
+            bs = self.ffi_lib.serialqueue_bulkreader_peek(self.bulkreader, i)
+            data = memoryview(self.ffi_main.buffer(bs.data, bs.len))
+            params = {'#receive_time': bs.receive_time}
+            pos = 0
+            for name, t in self.int_params:
+                params[name], pos = t.parse(data, pos)
+            if self.buffer_param is not None:
+                params[self.buffer_param] = data[pos+1:]
+            out.append(params)
+        overflows = self.ffi_lib.serialqueue_bulkreader_overflows(
+            self.bulkreader)
+        if overflows != self.overflows:
+            logging.warning("Bulk reader dropped %d messages",
+                            overflows - self.overflows)
+            self.overflows = overflows
+        return out
+
 # Class to send a query command and return the received response
 class SerialRetryCommand:
     def __init__(self, serial, name, oid=None):
@@ -17,6 +17,10 @@ class error(Exception):
 MIN_BOTH_EDGE_DURATION = 0.000000500
 MIN_OPTIMIZED_BOTH_EDGE_DURATION = 0.000000150
 MAX_STEPCOMPRESS_ERROR = 0.000025
+# Larger error budget granted to moves at (or above) the reference
+# velocity - longer queue_step sequences reduce bandwidth on slow links
+HIGHSPEED_STEPCOMPRESS_ERROR = 0.000075
+HIGHSPEED_ERROR_VELOCITY = 200.
 
 # Interface to low-level mcu and chelper code
 class MCU_stepper:
@@ -121,6 +125,17 @@ class MCU_stepper:
             "queue_step oid=%c interval=%u count=%hu add=%hi").get_command_tag()
         dir_cmd_tag = self._mcu.lookup_command(
             "set_next_step_dir oid=%c dir=%c").get_command_tag()
+        repeat_cmd_tag = 0
+        repeat_cmd = self._mcu.try_lookup_command(
+            "queue_step_repeat oid=%c interval=%u count=%hu add=%hi"
+            " repeat=%hu")
+        if repeat_cmd is not None:
+            repeat_cmd_tag = repeat_cmd.get_command_tag()
+        pack_cmd_tag = 0
+        pack_cmd = self._mcu.try_lookup_command("queue_step_pack oid=%c"
+                                                " data=%*s")
+        if pack_cmd is not None:
+            pack_cmd_tag = pack_cmd.get_command_tag()
         self._reset_cmd_tag = self._mcu.lookup_command(
             "reset_step_clock oid=%c clock=%u").get_command_tag()
         self._get_position_cmd = self._mcu.lookup_query_command(
@@ -129,7 +144,12 @@ class MCU_stepper:
         max_error_ticks = self._mcu.seconds_to_clock(MAX_STEPCOMPRESS_ERROR)
         ffi_main, ffi_lib = chelper.get_ffi()
         ffi_lib.stepcompress_fill(self._stepqueue, self._oid, max_error_ticks,
-                                  step_cmd_tag, dir_cmd_tag)
+                                  step_cmd_tag, dir_cmd_tag, repeat_cmd_tag,
+                                  pack_cmd_tag)
+        highspeed_error_ticks = self._mcu.seconds_to_clock(
+            HIGHSPEED_STEPCOMPRESS_ERROR)
+        ffi_lib.stepcompress_set_error_velocity(
+            self._stepqueue, highspeed_error_ticks, HIGHSPEED_ERROR_VELOCITY)
     def get_oid(self):
         return self._oid
     def get_step_dist(self):
@@ -181,6 +201,15 @@ class MCU_stepper:
         ffi_main, ffi_lib = chelper.get_ffi()
         pos = ffi_lib.stepcompress_find_past_position(self._stepqueue, clock)
         return int(pos)
+    def get_past_mcu_positions(self, start_print_time, sample_time, count):
+        # Sample 'count' past positions spaced 'sample_time' apart
+        start_clock = self._mcu.print_time_to_clock(start_print_time)
+        interval_clock = self._mcu.seconds_to_clock(sample_time)
+        ffi_main, ffi_lib = chelper.get_ffi()
+        positions = ffi_main.new('int64_t[]', count)
+        ffi_lib.stepcompress_find_past_positions(
+            self._stepqueue, start_clock, interval_clock, count, positions)
+        return list(positions)
     def mcu_to_commanded_position(self, mcu_pos):
         return mcu_pos * self._step_dist - self._mcu_position_offset
     def dump_steps(self, count, start_clock, end_clock):
@@ -189,6 +218,9 @@ class MCU_stepper:
         count = ffi_lib.stepcompress_extract_old(self._stepqueue, data, count,
                                                  start_clock, end_clock)
         return (data, count)
+    def set_shm_export(self, shm_ring):
+        ffi_main, ffi_lib = chelper.get_ffi()
+        ffi_lib.stepcompress_set_export(self._stepqueue, shm_ring)
     def get_stepper_kinematics(self):
         return self._stepper_kinematics
     def set_stepper_kinematics(self, sk):
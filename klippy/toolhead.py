@@ -12,6 +12,14 @@ import mcu, chelper, kinematics.extruder
 
 # Class to track each move request
 class Move:
+    # Millions of Move objects are created during a print - use
+    # __slots__ to reduce per-move memory and allocator pressure
+    __slots__ = (
+        'toolhead', 'start_pos', 'end_pos', 'accel', 'junction_deviation',
+        'timing_callbacks', 'is_kinematic_move', 'axes_d', 'move_d', 'axes_r',
+        'min_move_t', 'max_start_v2', 'max_cruise_v2', 'delta_v2',
+        'next_junction_v2', 'max_mcr_start_v2', 'mcr_delta_v2',
+        'start_v', 'cruise_v', 'end_v', 'accel_t', 'cruise_t', 'decel_t')
     def __init__(self, toolhead, start_pos, end_pos, speed):
         self.toolhead = toolhead
         self.start_pos = tuple(start_pos)
@@ -76,42 +84,17 @@ class Move:
         # Find max velocity using "approximated centripetal velocity"
         axes_r = self.axes_r
         prev_axes_r = prev_move.axes_r
-        junction_cos_theta = -(axes_r[0] * prev_axes_r[0]
-                               + axes_r[1] * prev_axes_r[1]
-                               + axes_r[2] * prev_axes_r[2])
-        sin_theta_d2 = math.sqrt(max(0.5*(1.0-junction_cos_theta), 0.))
-        cos_theta_d2 = math.sqrt(max(0.5*(1.0+junction_cos_theta), 0.))
-        one_minus_sin_theta_d2 = 1. - sin_theta_d2
-        if one_minus_sin_theta_d2 > 0. and cos_theta_d2 > 0.:
-            R_jd = sin_theta_d2 / one_minus_sin_theta_d2
-            move_jd_v2 = R_jd * self.junction_deviation * self.accel
-            pmove_jd_v2 = R_jd * prev_move.junction_deviation * prev_move.accel
-            # Approximated circle must contact moves no further than mid-move
-            #   centripetal_v2 = .5 * self.move_d * self.accel * tan_theta_d2
-            quarter_tan_theta_d2 = .25 * sin_theta_d2 / cos_theta_d2
-            move_centripetal_v2 = self.delta_v2 * quarter_tan_theta_d2
-            pmove_centripetal_v2 = prev_move.delta_v2 * quarter_tan_theta_d2
-            max_start_v2 = min(max_start_v2, move_jd_v2, pmove_jd_v2,
-                               move_centripetal_v2, pmove_centripetal_v2)
+        ffi_main, ffi_lib = chelper.get_ffi()
+        max_start_v2 = ffi_lib.lookahead_calc_junction(
+            prev_axes_r[0], prev_axes_r[1], prev_axes_r[2],
+            axes_r[0], axes_r[1], axes_r[2],
+            self.junction_deviation * self.accel,
+            prev_move.junction_deviation * prev_move.accel,
+            self.delta_v2, prev_move.delta_v2, max_start_v2)
         # Apply limits
         self.max_start_v2 = max_start_v2
         self.max_mcr_start_v2 = min(
             max_start_v2, prev_move.max_mcr_start_v2 + prev_move.mcr_delta_v2)
-    def set_junction(self, start_v2, cruise_v2, end_v2):
-        # Determine accel, cruise, and decel portions of the move distance
-        half_inv_accel = .5 / self.accel
-        accel_d = (cruise_v2 - start_v2) * half_inv_accel
-        decel_d = (cruise_v2 - end_v2) * half_inv_accel
-        cruise_d = self.move_d - accel_d - decel_d
-        # Determine move velocities
-        self.start_v = start_v = math.sqrt(start_v2)
-        self.cruise_v = cruise_v = math.sqrt(cruise_v2)
-        self.end_v = end_v = math.sqrt(end_v2)
-        # Determine time spent in each portion of move (time is the
-        # distance divided by average velocity)
-        self.accel_t = accel_d / ((start_v + cruise_v) * 0.5)
-        self.cruise_t = cruise_d / cruise_v
-        self.decel_t = decel_d / ((end_v + cruise_v) * 0.5)
 
 LOOKAHEAD_FLUSH_TIME = 0.150
 
@@ -121,6 +104,13 @@ class LookAheadQueue:
     def __init__(self):
         self.queue = []
         self.junction_flush = LOOKAHEAD_FLUSH_TIME
+        # Junction speeds are calculated in C - mirror the queued moves
+        # in an array of C move descriptors
+        self.ffi_main, self.ffi_lib = chelper.get_ffi()
+        self.cmove_size = self.ffi_main.sizeof("struct lookahead_move")
+        self.cmoves_alloc = 64
+        self.cmoves = self.ffi_main.new("struct lookahead_move[]",
+                                        self.cmoves_alloc)
     def reset(self):
         del self.queue[:]
         self.junction_flush = LOOKAHEAD_FLUSH_TIME
@@ -134,60 +124,58 @@ class LookAheadQueue:
         return None
     def flush(self, lazy=False):
         self.junction_flush = LOOKAHEAD_FLUSH_TIME
-        update_flush_count = lazy
         queue = self.queue
-        flush_count = len(queue)
-        # Traverse queue from last to first move and determine maximum
-        # junction speed assuming the robot comes to a complete stop
-        # after the last move.
-        junction_info = [None] * flush_count
-        next_start_v2 = next_mcr_start_v2 = peak_cruise_v2 = 0.
-        pending_cv2_assign = 0
-        for i in range(flush_count-1, -1, -1):
-            move = queue[i]
-            reachable_start_v2 = next_start_v2 + move.delta_v2
-            start_v2 = min(move.max_start_v2, reachable_start_v2)
-            cruise_v2 = None
-            pending_cv2_assign += 1
-            reach_mcr_start_v2 = next_mcr_start_v2 + move.mcr_delta_v2
-            mcr_start_v2 = min(move.max_mcr_start_v2, reach_mcr_start_v2)
-            if mcr_start_v2 < reach_mcr_start_v2:
-                # It's possible for this move to accelerate
-                if (mcr_start_v2 + move.mcr_delta_v2 > next_mcr_start_v2
-                    or pending_cv2_assign > 1):
-                    # This move can both accel and decel, or this is a
-                    # full accel move followed by a full decel move
-                    if update_flush_count and peak_cruise_v2:
-                        flush_count = i + pending_cv2_assign
-                        update_flush_count = False
-                    peak_cruise_v2 = (mcr_start_v2 + reach_mcr_start_v2) * .5
-                cruise_v2 = min((start_v2 + reachable_start_v2) * .5
-                                , move.max_cruise_v2, peak_cruise_v2)
-                pending_cv2_assign = 0
-            junction_info[i] = (move, start_v2, cruise_v2, next_start_v2)
-            next_start_v2 = start_v2
-            next_mcr_start_v2 = mcr_start_v2
-        if update_flush_count or not flush_count:
-            return []
-        # Traverse queue in forward direction to propagate cruise_v2
-        prev_cruise_v2 = 0.
+        # Determine junction speeds and move times in C
+        cmoves = self.cmoves
+        flush_count = self.ffi_lib.lookahead_flush(cmoves, len(queue), lazy)
+        # Copy calculated velocities and times to the move objects
         for i in range(flush_count):
-            move, start_v2, cruise_v2, next_start_v2 = junction_info[i]
-            if cruise_v2 is None:
-                # This move can't accelerate - propagate cruise_v2 from previous
-                cruise_v2 = min(prev_cruise_v2, start_v2)
-            move.set_junction(min(start_v2, cruise_v2), cruise_v2
-                              , min(next_start_v2, cruise_v2))
-            prev_cruise_v2 = cruise_v2
+            move = queue[i]
+            cm = cmoves[i]
+            move.start_v = cm.start_v
+            move.cruise_v = cm.cruise_v
+            move.end_v = cm.end_v
+            move.accel_t = cm.accel_t
+            move.cruise_t = cm.cruise_t
+            move.decel_t = cm.decel_t
+        return flush_count
+    def get_cmoves(self):
+        return self.cmoves
+    def pop_moves(self, flush_count):
         # Remove processed moves from the queue
+        queue = self.queue
         res = queue[:flush_count]
         del queue[:flush_count]
+        if queue:
+            self.ffi_main.memmove(self.cmoves, self.cmoves + flush_count,
+                                  len(queue) * self.cmove_size)
         return res
     def add_move(self, move):
-        self.queue.append(move)
-        if len(self.queue) == 1:
+        queue = self.queue
+        queue.append(move)
+        if len(queue) > 1:
+            move.calc_junction(queue[-2])
+        if len(queue) > self.cmoves_alloc:
+            # Grow the C move descriptor array
+            self.cmoves_alloc = 2 * self.cmoves_alloc
+            cmoves = self.ffi_main.new("struct lookahead_move[]",
+                                       self.cmoves_alloc)
+            self.ffi_main.memmove(cmoves, self.cmoves,
+                                  (len(queue) - 1) * self.cmove_size)
+            self.cmoves = cmoves
+        cm = self.cmoves[len(queue) - 1]
+        cm.move_d = move.move_d
+        cm.accel = move.accel
+        cm.max_start_v2 = move.max_start_v2
+        cm.max_cruise_v2 = move.max_cruise_v2
+        cm.delta_v2 = move.delta_v2
+        cm.max_mcr_start_v2 = move.max_mcr_start_v2
+        cm.mcr_delta_v2 = move.mcr_delta_v2
+        cm.start_x, cm.start_y, cm.start_z = move.start_pos[:3]
+        cm.x_r, cm.y_r, cm.z_r = move.axes_r[:3]
+        cm.is_kinematic = move.is_kinematic_move
+        if len(queue) == 1:
             return
-        move.calc_junction(self.queue[-2])
         self.junction_flush -= move.min_move_t
         # Check if enough moves have been queued to reach the target flush time.
         return self.junction_flush <= 0.
@@ -226,12 +214,14 @@ class ToolHead:
         self.print_time = 0.
         self.special_queuing_state = "NeedPrime"
         self.priming_timer = None
+        self.resync_buffer_time = BUFFER_TIME_START
         # Setup for generating moves
         self.motion_queuing = self.printer.load_object(config, 'motion_queuing')
         self.motion_queuing.register_flush_callback(self._handle_step_flush,
                                                     can_add_trapq=True)
         self.trapq = self.motion_queuing.allocate_trapq()
-        self.trapq_append = self.motion_queuing.lookup_trapq_append()
+        self.trapq_append_lookahead = (
+            self.motion_queuing.lookup_trapq_append_lookahead())
         # Create kinematics class
         gcode = self.printer.lookup_object('gcode')
         self.Coord = gcode.Coord
@@ -261,14 +251,15 @@ class ToolHead:
         curtime = self.reactor.monotonic()
         est_print_time = self.mcu.estimated_print_time(curtime)
         kin_time = self.motion_queuing.calc_step_gen_restart(est_print_time)
-        min_print_time = max(est_print_time + BUFFER_TIME_START, kin_time)
+        min_print_time = max(est_print_time + self.resync_buffer_time,
+                             kin_time)
         if min_print_time > self.print_time:
             self.print_time = min_print_time
             self.printer.send_event("toolhead:sync_print_time",
                                     curtime, est_print_time, self.print_time)
     def _process_lookahead(self, lazy=False):
-        moves = self.lookahead.flush(lazy=lazy)
-        if not moves:
+        flush_count = self.lookahead.flush(lazy=lazy)
+        if not flush_count:
             return
         # Resync print_time if necessary
         if self.special_queuing_state:
@@ -276,17 +267,14 @@ class ToolHead:
             self.special_queuing_state = ""
             self.need_check_pause = -1.
             self._calc_print_time()
-        # Queue moves into trapezoid motion queue (trapq)
         next_move_time = self.print_time
         with self.reactor.assert_no_pause():
+            # Hand flushed moves directly to trapezoid motion queue (trapq)
+            self.trapq_append_lookahead(self.trapq, next_move_time,
+                                        self.lookahead.get_cmoves(),
+                                        flush_count)
+            moves = self.lookahead.pop_moves(flush_count)
             for move in moves:
-                if move.is_kinematic_move:
-                    self.trapq_append(
-                        self.trapq, next_move_time,
-                        move.accel_t, move.cruise_t, move.decel_t,
-                        move.start_pos[0], move.start_pos[1], move.start_pos[2],
-                        move.axes_r[0], move.axes_r[1], move.axes_r[2],
-                        move.start_v, move.cruise_v, move.accel)
                 for e_index, ea in enumerate(self.extra_axes):
                     if move.axes_d[e_index + 3]:
                         ea.process_move(next_move_time, move, e_index + 3)
@@ -317,6 +305,13 @@ class ToolHead:
     def flush_step_generation(self):
         self._flush_lookahead()
         self.motion_queuing.flush_all_steps()
+    def set_resync_buffer_time(self, buffer_time):
+        # Set the scheduling buffer applied on a print time resync.  A
+        # reduced buffer lowers the latency of short host-supervised
+        # moves (such as probing sessions).  Returns the previous value.
+        last_buffer_time = self.resync_buffer_time
+        self.resync_buffer_time = buffer_time
+        return last_buffer_time
     def get_last_move_time(self):
         if self.special_queuing_state:
             self._flush_lookahead()
@@ -461,17 +456,12 @@ class ToolHead:
         if submit_move.move_d:
             self.commanded_pos[:] = submit_move.end_pos
             self.lookahead.add_move(submit_move)
-        moves = self.lookahead.flush()
+        flush_count = self.lookahead.flush()
         self._calc_print_time()
-        start_time = end_time = self.print_time
-        for move in moves:
-            self.trapq_append(
-                self.trapq, end_time,
-                move.accel_t, move.cruise_t, move.decel_t,
-                move.start_pos[0], move.start_pos[1], move.start_pos[2],
-                move.axes_r[0], move.axes_r[1], move.axes_r[2],
-                move.start_v, move.cruise_v, move.accel)
-            end_time = end_time + move.accel_t + move.cruise_t + move.decel_t
+        start_time = self.print_time
+        end_time = self.trapq_append_lookahead(self.trapq, start_time,
+                                               self.lookahead.get_cmoves(),
+                                               flush_count)
         self.lookahead.reset()
         return start_time, end_time
     def drip_move(self, newpos, speed, drip_completion):
@@ -3,9 +3,11 @@
 # Copyright (C) 2020 Eric Callahan <arksine.code@gmail.com>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license
-import logging, socket, os, sys, errno, collections
+import logging, socket, os, sys, errno, collections, struct
 import gcode
 
+msgpack_dumps = msgpack_loads = None
+
 try:
     import msgspec
 except ImportError:
@@ -35,9 +37,17 @@ except ImportError:
 else:
     json_dumps = msgspec.json.encode
     json_loads = msgspec.json.decode
+    msgpack_dumps = msgspec.msgpack.encode
+    msgpack_loads = msgspec.msgpack.decode
+
+# Maximum frame size accepted from clients using binary framing
+MSGPACK_MAX_FRAME = 1 << 20
 
 REQUEST_LOG_SIZE = 20
 
+# Maximum number of buffers to pass to a single writev call
+WRITEV_MAX_COUNT = 1024
+
 class WebRequestError(gcode.CommandError):
     def __init__(self, message,):
         Exception.__init__(self, message)
@@ -52,9 +62,11 @@ class Sentinel:
 
 class WebRequest:
     error = WebRequestError
-    def __init__(self, client_conn, request):
+    def __init__(self, client_conn, request, loads=None):
         self.client_conn = client_conn
-        base_request = json_loads(request)
+        if loads is None:
+            loads = json_loads
+        base_request = loads(request)
         if type(base_request) != dict:
             raise ValueError("Not a top-level dictionary")
         self.id = base_request.get('id', None)
@@ -64,6 +76,7 @@ class WebRequest:
             raise ValueError("Invalid request type")
         self.response = None
         self.is_error = False
+        self.is_serialized = False
 
     def get_client_connection(self):
         return self.client_conn
@@ -101,6 +114,13 @@ class WebRequest:
             raise WebRequestError("Multiple calls to send not allowed")
         self.response = data
 
+    def send_serialized(self, payload):
+        # Response payload is already json encoded
+        if self.response is not None:
+            raise WebRequestError("Multiple calls to send not allowed")
+        self.response = payload
+        self.is_serialized = True
+
     def finish(self):
         if self.id is None:
             return None
@@ -111,6 +131,9 @@ class WebRequest:
             # No error was set and the user never executed
             # send, default response is {}
             self.response = {}
+        if self.is_serialized and not self.is_error:
+            return (b'{"id":' + json_dumps(self.id) + b',"result":'
+                    + self.response + b'}')
         return {"id": self.id, rtype: self.response}
 
 class ServerSocket:
@@ -194,7 +217,10 @@ class ClientConnection:
         self.sock = sock
         self.fd_handle = self.reactor.register_fd(
             self.sock.fileno(), self.process_received, self._do_send)
-        self.partial_data = self.send_buffer = b""
+        self.partial_data = b""
+        self.send_buffers = []
+        self.flush_pending = False
+        self.encoding = 'json'
         self.is_blocking = False
         self.blocking_count = 0
         self.set_client_info("?", "New connection")
@@ -234,6 +260,25 @@ class ClientConnection:
     def is_closed(self):
         return self.fd_handle is None
 
+    def get_encoding(self):
+        return self.encoding
+
+    def set_encoding(self, encoding):
+        logging.info("webhooks client %s: Using '%s' encoding",
+                     self.uid, encoding)
+        self.encoding = encoding
+
+    def _note_request(self, eventtime, req, loads):
+        self.request_log.append((eventtime, req))
+        try:
+            web_request = WebRequest(self, req, loads)
+        except Exception:
+            logging.exception("webhooks: Error decoding Server Request %s"
+                              % (req))
+            return
+        self.reactor.register_callback(
+            lambda e, s=self, wr=web_request: s._process_request(wr))
+
     def process_received(self, eventtime):
         try:
             data = self.sock.recv(4096)
@@ -248,19 +293,27 @@ class ClientConnection:
             # Socket Closed
             self.close()
             return
+        if self.encoding == 'msgpack':
+            # Binary frames with a 4 byte big-endian length prefix
+            self.partial_data += data
+            while len(self.partial_data) >= 4:
+                flen = struct.unpack('>I', self.partial_data[:4])[0]
+                if flen > MSGPACK_MAX_FRAME:
+                    logging.info("webhooks: Oversized frame from client %d",
+                                 self.uid)
+                    self.close()
+                    return
+                if len(self.partial_data) < 4 + flen:
+                    break
+                req = self.partial_data[4:4+flen]
+                self.partial_data = self.partial_data[4+flen:]
+                self._note_request(eventtime, req, msgpack_loads)
+            return
         requests = data.split(b'\x03')
         requests[0] = self.partial_data + requests[0]
         self.partial_data = requests.pop()
         for req in requests:
-            self.request_log.append((eventtime, req))
-            try:
-                web_request = WebRequest(self, req)
-            except Exception:
-                logging.exception("webhooks: Error decoding Server Request %s"
-                                  % (req))
-                continue
-            self.reactor.register_callback(
-                lambda e, s=self, wr=web_request: s._process_request(wr))
+            self._note_request(eventtime, req, None)
 
     def _process_request(self, web_request):
         try:
@@ -280,29 +333,63 @@ class ClientConnection:
         self.send(result)
 
     def send(self, data):
-        try:
-            jmsg = json_dumps(data)
-            self.send_buffer += jmsg + b"\x03"
-        except (TypeError, ValueError) as e:
-            msg = ("json encoding error: %s" % (str(e),))
-            logging.exception(msg)
-            self.printer.invoke_shutdown(msg)
-            return
-        if not self.is_blocking:
-            self._do_send()
+        if self.encoding == 'msgpack':
+            if type(data) is bytes:
+                # Message was pre-serialized as json - re-encode
+                data = json_loads(data)
+            try:
+                msg = msgpack_dumps(data)
+            except (TypeError, ValueError) as e:
+                msg = ("msgpack encoding error: %s" % (str(e),))
+                logging.exception(msg)
+                self.printer.invoke_shutdown(msg)
+                return
+            self.send_buffers.append(struct.pack('>I', len(msg)) + msg)
+        else:
+            if type(data) is bytes:
+                # Message was already serialized by the caller
+                jmsg = data
+            else:
+                try:
+                    jmsg = json_dumps(data)
+                except (TypeError, ValueError) as e:
+                    msg = ("json encoding error: %s" % (str(e),))
+                    logging.exception(msg)
+                    self.printer.invoke_shutdown(msg)
+                    return
+            self.send_buffers.append(jmsg + b"\x03")
+        # Batch messages and flush with one writev when the reactor is
+        # next idle (a burst of messages becomes a single syscall)
+        if not self.is_blocking and not self.flush_pending:
+            self.flush_pending = True
+            self.reactor.register_callback(self._flush)
+
+    def _flush(self, eventtime=None):
+        self.flush_pending = False
+        self._do_send(eventtime)
 
     def _do_send(self, eventtime=None):
         if self.fd_handle is None:
             return
-        try:
-            sent = self.sock.send(self.send_buffer)
-        except socket.error as e:
-            if e.errno not in [errno.EAGAIN, errno.EWOULDBLOCK]:
-                logging.info("webhooks: socket write error %d" % (self.uid,))
-                self.close()
-                return
-            sent = 0
-        if sent < len(self.send_buffer):
+        while self.send_buffers:
+            bufs = self.send_buffers[:WRITEV_MAX_COUNT]
+            try:
+                sent = os.writev(self.sock.fileno(), bufs)
+            except OSError as e:
+                if e.errno not in [errno.EAGAIN, errno.EWOULDBLOCK]:
+                    logging.info("webhooks: socket write error %d"
+                                 % (self.uid,))
+                    self.close()
+                    return
+                sent = 0
+            is_partial = sent < sum([len(buf) for buf in bufs])
+            while sent and sent >= len(self.send_buffers[0]):
+                sent -= len(self.send_buffers.pop(0))
+            if sent:
+                self.send_buffers[0] = self.send_buffers[0][sent:]
+            if is_partial:
+                break
+        if self.send_buffers:
             if not self.is_blocking:
                 self.reactor.set_fd_wake(self.fd_handle, False, True)
                 self.is_blocking = True
@@ -310,7 +397,6 @@ class ClientConnection:
         elif self.is_blocking:
             self.reactor.set_fd_wake(self.fd_handle, True, False)
             self.is_blocking = False
-        self.send_buffer = self.send_buffer[sent:]
 
 class WebHooks:
     def __init__(self, printer):
@@ -322,6 +408,7 @@ class WebHooks:
         self.register_endpoint("emergency_stop", self._handle_estop_request)
         self.register_endpoint("register_remote_method",
                                self._handle_rpc_registration)
+        self.register_endpoint("set_encoding", self._handle_set_encoding)
         self.sconn = ServerSocket(self, printer)
 
     def register_endpoint(self, path, callback):
@@ -382,6 +469,19 @@ class WebHooks:
     def _handle_estop_request(self, web_request):
         self.printer.invoke_shutdown("Shutdown due to webhooks request")
 
+    def _handle_set_encoding(self, web_request):
+        encoding = web_request.get_str('encoding')
+        if encoding not in ('json', 'msgpack'):
+            raise web_request.error("Unknown encoding '%s'" % (encoding,))
+        if encoding == 'msgpack' and msgpack_dumps is None:
+            raise web_request.error(
+                "msgpack encoding requires the msgspec python module")
+        cconn = web_request.get_client_connection()
+        # Takes effect immediately - the response to this request is
+        # already sent in the new encoding
+        cconn.set_encoding(encoding)
+        web_request.send({'encoding': encoding})
+
     def _handle_rpc_registration(self, web_request):
         template = web_request.get_dict('response_template')
         method = web_request.get_str('remote_method')
@@ -475,6 +575,9 @@ class QueryStatusHelper:
         self.pending_queries = []
         self.query_timer = None
         self.last_query = {}
+        # Serialized status sections from the previous query round -
+        # unchanged sections are resent from these cached bytes
+        self.last_serialized = {}
         # Register webhooks
         webhooks = printer.lookup_object('webhooks')
         webhooks.register_endpoint("objects/list", self._handle_list)
@@ -486,10 +589,13 @@ class QueryStatusHelper:
         web_request.send({'objects': objects})
     def _do_query(self, eventtime):
         last_query = self.last_query
+        last_serialized = self.last_serialized
         query = self.last_query = {}
+        serialized = self.last_serialized = {}
         msglist = self.pending_queries
         self.pending_queries = []
         msglist.extend(self.clients.values())
+        eventtime_json = json_dumps(eventtime)
         # Generate get_status() info for each client
         reactor = self.printer.get_reactor()
         with reactor.assert_no_pause():
@@ -498,8 +604,11 @@ class QueryStatusHelper:
                 if not is_query and cconn.is_closed():
                     del self.clients[cconn]
                     continue
+                # Pre-serialized json is only useful to json clients
+                want_bytes = is_query or cconn.get_encoding() == 'json'
                 # Query each requested printer object
-                cquery = {}
+                sections = []
+                status = {}
                 for obj_name, req_items in subscription.items():
                     res = query.get(obj_name, None)
                     if res is None:
@@ -513,18 +622,53 @@ class QueryStatusHelper:
                         if req_items:
                             subscription[obj_name] = req_items
                     lres = last_query.get(obj_name, {})
+                    if not is_query and res is lres:
+                        # Object served the same cached snapshot as the
+                        # previous round - nothing can have changed
+                        continue
                     cres = {}
                     for ri in req_items:
                         rd = res.get(ri, None)
                         if is_query or rd != lres.get(ri):
                             cres[ri] = rd
                     if cres or is_query:
-                        cquery[obj_name] = cres
+                        if not want_bytes:
+                            status[obj_name] = cres
+                            continue
+                        if cres == res:
+                            # Full section - serialize it at most once
+                            # per round, reusing the previous round's
+                            # bytes when the section did not change
+                            sbytes = serialized.get(obj_name)
+                            if sbytes is None:
+                                if res == lres:
+                                    sbytes = last_serialized.get(obj_name)
+                                if sbytes is None:
+                                    sbytes = json_dumps(cres)
+                                serialized[obj_name] = sbytes
+                        else:
+                            sbytes = json_dumps(cres)
+                        sections.append(json_dumps(obj_name) + b':' + sbytes)
                 # Send data
-                if cquery or is_query:
-                    tmp = dict(template)
-                    tmp['params'] = {'eventtime': eventtime, 'status': cquery}
-                    send_func(tmp)
+                if not want_bytes:
+                    if status:
+                        out = {k: v for k, v in template.items()
+                               if k != 'params'}
+                        out['params'] = {'eventtime': eventtime,
+                                         'status': status}
+                        send_func(out)
+                elif sections or is_query:
+                    payload = (b'{"eventtime":' + eventtime_json
+                               + b',"status":{' + b','.join(sections) + b'}}')
+                    if is_query:
+                        send_func(payload)
+                        continue
+                    tmpl = {k: v for k, v in template.items() if k != 'params'}
+                    if tmpl:
+                        send_func(json_dumps(tmpl)[:-1] + b',"params":'
+                                  + payload + b'}')
+                    else:
+                        send_func(b'{"params":' + payload + b'}')
         if not query:
             # Unregister timer if there are no longer any subscriptions
             reactor.unregister_timer(self.query_timer)
@@ -554,8 +698,11 @@ class QueryStatusHelper:
             qt = reactor.register_timer(self._do_query, reactor.NOW)
             self.query_timer = qt
         # Wait for data to be queried
-        msg = complete.wait()
-        web_request.send(msg['params'])
+        payload = complete.wait()
+        if cconn.get_encoding() == 'json':
+            web_request.send_serialized(payload)
+        else:
+            web_request.send(json_loads(payload))
         if is_subscribe:
             self.clients[cconn] = (cconn, objects, cconn.send, template)
     def _handle_subscribe(self, web_request):
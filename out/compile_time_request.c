@@ -0,0 +1,2661 @@
+
+/* DO NOT EDIT! This is an autogenerated file. See scripts/buildcommands.py. */
+
+#include <string.h>
+#include "board/irq.h"
+#include "board/pgm.h"
+#include "command.h"
+#include "compiler.h"
+#include "initial_pins.h"
+#include "sched.h"
+
+void
+ctr_run_initfuncs(void)
+{
+    extern void alloc_init(void);
+    alloc_init();
+    extern void initial_pins_setup(void);
+    initial_pins_setup();
+    extern void stepper_stop_task_mask_init(void);
+    stepper_stop_task_mask_init();
+    extern void trsync_task_mask_init(void);
+    trsync_task_mask_init();
+    extern void analog_scan_task_mask_init(void);
+    analog_scan_task_mask_init();
+    extern void analog_in_task_mask_init(void);
+    analog_in_task_mask_init();
+    extern void encoder_task_mask_init(void);
+    encoder_task_mask_init();
+    extern void buttons_task_mask_init(void);
+    buttons_task_mask_init();
+    extern void tmcuart_task_mask_init(void);
+    tmcuart_task_mask_init();
+    extern void counter_task_mask_init(void);
+    counter_task_mask_init();
+    extern void thermocouple_task_mask_init(void);
+    thermocouple_task_mask_init();
+    extern void adxl345_task_mask_init(void);
+    adxl345_task_mask_init();
+    extern void timer_init(void);
+    timer_init();
+    extern void serial_init(void);
+    serial_init();
+}
+
+void
+ctr_run_shutdownfuncs(void)
+{
+    extern void sendf_shutdown(void);
+    sendf_shutdown();
+    extern void move_reset(void);
+    move_reset();
+    extern void step_benchmark_shutdown(void);
+    step_benchmark_shutdown();
+    extern void digital_out_shutdown(void);
+    digital_out_shutdown();
+    extern void stepper_shutdown(void);
+    stepper_shutdown();
+    extern void trsync_shutdown(void);
+    trsync_shutdown();
+    extern void analog_scan_shutdown(void);
+    analog_scan_shutdown();
+    extern void analog_in_shutdown(void);
+    analog_in_shutdown();
+    extern void spidev_shutdown(void);
+    spidev_shutdown();
+    extern void pwm_shutdown(void);
+    pwm_shutdown();
+    extern void tmcuart_shutdown(void);
+    tmcuart_shutdown();
+    extern void st7920_shutdown(void);
+    st7920_shutdown();
+    extern void hd44780_shutdown(void);
+    hd44780_shutdown();
+    extern void heater_pid_shutdown(void);
+    heater_pid_shutdown();
+}
+
+const uint32_t ctr_taskwake_mask_stepper_stop_task = 0x00000002;
+const uint32_t ctr_taskwake_mask_trsync_task = 0x00000004;
+const uint32_t ctr_taskwake_mask_analog_scan_task = 0x00000008;
+const uint32_t ctr_taskwake_mask_analog_in_task = 0x00000010;
+const uint32_t ctr_taskwake_mask_encoder_task = 0x00000020;
+const uint32_t ctr_taskwake_mask_buttons_task = 0x00000040;
+const uint32_t ctr_taskwake_mask_tmcuart_task = 0x00000080;
+const uint32_t ctr_taskwake_mask_counter_task = 0x00000100;
+const uint32_t ctr_taskwake_mask_thermocouple_task = 0x00000200;
+const uint32_t ctr_taskwake_mask_adxl345_task = 0x00000400;
+
+void
+ctr_run_taskfuncs(void)
+{
+    extern void step_benchmark_task(void);
+    extern void stepper_stop_task(void);
+    extern void trsync_task(void);
+    extern void analog_scan_task(void);
+    extern void analog_in_task(void);
+    extern void encoder_task(void);
+    extern void buttons_task(void);
+    extern void tmcuart_task(void);
+    extern void counter_task(void);
+    extern void thermocouple_task(void);
+    extern void adxl345_task(void);
+    extern void lis2dw_task(void);
+    extern void bmi160_task(void);
+    extern void hx71x_capture_task(void);
+    extern void ads1220_capture_task(void);
+    extern void spi_angle_task(void);
+    extern void timer_task(void);
+    extern void console_task(void);
+    static void (* const taskfuncs[])(void) = {
+        step_benchmark_task,
+        stepper_stop_task,
+        trsync_task,
+        analog_scan_task,
+        analog_in_task,
+        encoder_task,
+        buttons_task,
+        tmcuart_task,
+        counter_task,
+        thermocouple_task,
+        adxl345_task,
+        lis2dw_task,
+        bmi160_task,
+        hx71x_capture_task,
+        ads1220_capture_task,
+        spi_angle_task,
+        timer_task,
+        console_task,
+    };
+    uint32_t bitmap = (sched_claim_woken_tasks() & 0x0003ffff) | 0x0003f801;
+    while (bitmap) {
+        uint_fast8_t idx = __builtin_ctz(bitmap);
+        bitmap &= bitmap - 1;
+        irq_poll();
+        sched_run_task(idx, taskfuncs[idx]);
+    }
+    irq_poll();
+}
+
+uint8_t __always_inline
+ctr_lookup_static_string(const char *str)
+{
+    if (__builtin_strcmp(str, "Shutdown cleared when not shutdown") == 0)
+        return 2;
+    if (__builtin_strcmp(str, "Timer too close") == 0)
+        return 3;
+    if (__builtin_strcmp(str, "sentinel timer called") == 0)
+        return 4;
+    if (__builtin_strcmp(str, "Invalid command") == 0)
+        return 5;
+    if (__builtin_strcmp(str, "Message encode error") == 0)
+        return 6;
+    if (__builtin_strcmp(str, "Command parser error") == 0)
+        return 7;
+    if (__builtin_strcmp(str, "Command request") == 0)
+        return 8;
+    if (__builtin_strcmp(str, "config_reset only available when shutdown") == 0)
+        return 9;
+    if (__builtin_strcmp(str, "Can't assign oid") == 0)
+        return 10;
+    if (__builtin_strcmp(str, "oids already allocated") == 0)
+        return 11;
+    if (__builtin_strcmp(str, "Invalid oid type") == 0)
+        return 12;
+    if (__builtin_strcmp(str, "Already finalized") == 0)
+        return 13;
+    if (__builtin_strcmp(str, "Invalid move request size") == 0)
+        return 14;
+    if (__builtin_strcmp(str, "Move queue overflow") == 0)
+        return 15;
+    if (__builtin_strcmp(str, "alloc_chunks failed") == 0)
+        return 16;
+    if (__builtin_strcmp(str, "alloc_chunk failed") == 0)
+        return 17;
+    if (__builtin_strcmp(str, "Invalid count parameter") == 0)
+        return 18;
+    if (__builtin_strcmp(str, "Invalid step benchmark stepper count") == 0)
+        return 19;
+    if (__builtin_strcmp(str, "Step benchmark already running") == 0)
+        return 20;
+    if (__builtin_strcmp(str, "update_digital_out not valid with active queue") == 0)
+        return 21;
+    if (__builtin_strcmp(str, "Invalid queue_digital_out_batch length") == 0)
+        return 22;
+    if (__builtin_strcmp(str, "Scheduled digital out event will exceed max_duration") == 0)
+        return 23;
+    if (__builtin_strcmp(str, "Can not set soft pwm cycle ticks while updates pending") == 0)
+        return 24;
+    if (__builtin_strcmp(str, "Missed scheduling of next digital out event") == 0)
+        return 25;
+    if (__builtin_strcmp(str, "Can't reset time when stepper active") == 0)
+        return 26;
+    if (__builtin_strcmp(str, "Invalid queue_step_pack command") == 0)
+        return 27;
+    if (__builtin_strcmp(str, "Stepper too far in past") == 0)
+        return 28;
+    if (__builtin_strcmp(str, "Can't add signal that is already active") == 0)
+        return 29;
+    if (__builtin_strcmp(str, "Set analog_scan past maximum channel count") == 0)
+        return 30;
+    if (__builtin_strcmp(str, "Invalid analog_scan channel count") == 0)
+        return 31;
+    if (__builtin_strcmp(str, "ADC out of range") == 0)
+        return 32;
+    if (__builtin_strcmp(str, "Invalid analog_in bytes_per_report") == 0)
+        return 33;
+    if (__builtin_strcmp(str, "Invalid spi config") == 0)
+        return 34;
+    if (__builtin_strcmp(str, "Invalid queue_pwm_out_batch length") == 0)
+        return 35;
+    if (__builtin_strcmp(str, "Scheduled pwm event will exceed max_duration") == 0)
+        return 36;
+    if (__builtin_strcmp(str, "Missed scheduling of next hard pwm event") == 0)
+        return 37;
+    if (__builtin_strcmp(str, "Invalid encoder steps_per_detent") == 0)
+        return 38;
+    if (__builtin_strcmp(str, "Invalid buttons retransmit count") == 0)
+        return 39;
+    if (__builtin_strcmp(str, "Set button past maximum button count") == 0)
+        return 40;
+    if (__builtin_strcmp(str, "Max of 8 buttons") == 0)
+        return 41;
+    if (__builtin_strcmp(str, "tmcuart batch data too large") == 0)
+        return 42;
+    if (__builtin_strcmp(str, "tmcuart data too large") == 0)
+        return 43;
+    if (__builtin_strcmp(str, "Invalid neopixel update command") == 0)
+        return 44;
+    if (__builtin_strcmp(str, "Invalid neopixel data_size") == 0)
+        return 45;
+    if (__builtin_strcmp(str, "Thermocouple reader fault") == 0)
+        return 46;
+    if (__builtin_strcmp(str, "Invalid thermocouple chip type") == 0)
+        return 47;
+    if (__builtin_strcmp(str, "model type invalid") == 0)
+        return 48;
+    if (__builtin_strcmp(str, "bus_type invalid") == 0)
+        return 49;
+    if (__builtin_strcmp(str, "bus_type i2c unsupported") == 0)
+        return 50;
+    if (__builtin_strcmp(str, "bus_type spi unsupported") == 0)
+        return 51;
+    if (__builtin_strcmp(str, "HX71x gain/channel out of range 1-4") == 0)
+        return 52;
+    if (__builtin_strcmp(str, "angle sensor requires cs pin") == 0)
+        return 53;
+    if (__builtin_strcmp(str, "Invalid spi_angle chip type") == 0)
+        return 54;
+    if (__builtin_strcmp(str, "Filter section index larger than max_sections") == 0)
+        return 55;
+    if (__builtin_strcmp(str, "Linearize segment index larger than max segments") == 0)
+        return 56;
+    if (__builtin_strcmp(str, "heater_pid update timeout") == 0)
+        return 57;
+    if (__builtin_strcmp(str, "Rescheduled timer in the past") == 0)
+        return 58;
+    return 0xff;
+}
+
+const struct initial_pin_s initial_pins[] PROGMEM = {
+};
+const int initial_pins_size PROGMEM = ARRAY_SIZE(initial_pins);
+
+static const uint8_t command_parameters0[] PROGMEM = {
+    PT_uint16 };
+static const uint8_t command_parameters1[] PROGMEM = {
+    PT_uint32, PT_uint16 };
+static const uint8_t command_parameters2[] PROGMEM = {
+    PT_uint32, PT_progmem_buffer };
+static const uint8_t command_parameters3[] PROGMEM = {
+    PT_uint32, PT_uint32, PT_uint32, PT_uint16 };
+static const uint8_t command_parameters4[] PROGMEM = {
+    PT_uint32, PT_uint32 };
+static const uint8_t command_parameters5[] PROGMEM = {
+    PT_uint32 };
+static const uint8_t command_parameters6[] PROGMEM = {
+    PT_byte, PT_uint32 };
+static const uint8_t command_parameters7[] PROGMEM = {
+    PT_byte, PT_uint32, PT_byte, PT_uint16 };
+static const uint8_t command_parameters8[] PROGMEM = {
+    PT_uint32, PT_int32, PT_int32, PT_uint16 };
+static const uint8_t command_parameters9[] PROGMEM = {
+    PT_buffer };
+static const uint8_t command_parameters10[] PROGMEM = {
+    PT_byte, PT_int32 };
+static const uint8_t command_parameters11[] PROGMEM = {
+    PT_byte, PT_byte, PT_uint32, PT_byte, PT_uint32 };
+static const uint8_t command_parameters12[] PROGMEM = {
+    PT_byte, PT_byte, PT_byte, PT_uint32 };
+static const uint8_t command_parameters13[] PROGMEM = {
+    PT_byte, PT_uint32, PT_buffer };
+static const uint8_t command_parameters14[] PROGMEM = {
+    PT_byte, PT_buffer };
+static const uint8_t command_parameters15[] PROGMEM = {
+    PT_byte, PT_int16 };
+static const uint8_t command_parameters16[] PROGMEM = {
+    PT_byte, PT_byte, PT_buffer };
+static const uint8_t command_parameters17[] PROGMEM = {
+    PT_byte, PT_byte };
+static const uint8_t command_parameters18[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters19[] PROGMEM = {
+    PT_uint32, PT_buffer };
+static const uint8_t command_parameters20[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint16, PT_uint16 };
+static const uint8_t command_parameters21[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_uint16, PT_uint32, PT_uint16 };
+static const uint8_t command_parameters22[] PROGMEM = {
+    PT_byte, PT_uint16, PT_buffer };
+static const uint8_t command_parameters23[] PROGMEM = {
+    PT_byte, PT_byte, PT_uint32 };
+static const uint8_t command_parameters24[] PROGMEM = {
+    PT_byte, PT_uint16 };
+static const uint8_t command_parameters25[] PROGMEM = {
+    PT_byte, PT_byte, PT_uint16, PT_int32 };
+static const uint8_t command_parameters26[] PROGMEM = {
+    PT_uint32, PT_byte };
+static const uint8_t command_parameters27[] PROGMEM = {
+    PT_byte };
+static const uint8_t command_parameters28[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint16, PT_uint32 };
+static const uint8_t command_parameters29[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters30[] PROGMEM = {
+    PT_byte, PT_uint32, PT_byte, PT_byte, PT_uint32 };
+static const uint8_t command_parameters31[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint16, PT_int16, PT_uint16 };
+static const uint8_t command_parameters32[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint16, PT_int16 };
+static const uint8_t command_parameters33[] PROGMEM = {
+    PT_byte, PT_byte, PT_byte, PT_byte, PT_uint32 };
+static const uint8_t command_parameters34[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_byte, PT_uint32, PT_byte, PT_byte, PT_byte };
+static const uint8_t command_parameters35[] PROGMEM = {
+    PT_byte, PT_byte, PT_byte };
+static const uint8_t command_parameters36[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_byte };
+static const uint8_t command_parameters37[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_byte, PT_uint32, PT_byte };
+static const uint8_t command_parameters38[] PROGMEM = {
+    PT_byte, PT_byte, PT_uint32, PT_uint16, PT_uint16 };
+static const uint8_t command_parameters39[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_byte, PT_uint32, PT_byte, PT_uint16, PT_uint16, PT_byte };
+static const uint8_t command_parameters40[] PROGMEM = {
+    PT_byte, PT_uint32, PT_byte };
+static const uint8_t command_parameters41[] PROGMEM = {
+    PT_uint32, PT_uint32, PT_uint16 };
+static const uint8_t command_parameters42[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint16 };
+static const uint8_t command_parameters43[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_uint16, PT_uint16, PT_uint32 };
+static const uint8_t command_parameters44[] PROGMEM = {
+    PT_byte, PT_uint32, PT_byte, PT_uint32, PT_byte, PT_byte, PT_byte };
+static const uint8_t command_parameters45[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_byte, PT_byte };
+static const uint8_t command_parameters46[] PROGMEM = {
+    PT_byte, PT_byte, PT_uint32, PT_byte };
+static const uint8_t command_parameters47[] PROGMEM = {
+    PT_byte, PT_byte, PT_buffer, PT_byte };
+static const uint8_t command_parameters48[] PROGMEM = {
+    PT_byte, PT_buffer, PT_byte };
+static const uint8_t command_parameters49[] PROGMEM = {
+    PT_byte, PT_uint32, PT_byte, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters50[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint16, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters51[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_uint32, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters52[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_uint32, PT_uint32, PT_uint32, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters53[] PROGMEM = {
+    PT_byte, PT_uint32, PT_uint32, PT_uint32, PT_uint32, PT_byte };
+static const uint8_t command_parameters54[] PROGMEM = {
+    PT_byte, PT_byte, PT_byte, PT_byte };
+static const uint8_t command_parameters55[] PROGMEM = {
+    PT_byte, PT_byte, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters56[] PROGMEM = {
+    PT_byte, PT_byte, PT_int32, PT_uint32 };
+static const uint8_t command_parameters57[] PROGMEM = {
+    PT_byte, PT_int32, PT_int32, PT_byte, PT_byte };
+static const uint8_t command_parameters58[] PROGMEM = {
+    PT_byte, PT_byte, PT_int32, PT_int32 };
+static const uint8_t command_parameters59[] PROGMEM = {
+    PT_byte, PT_byte, PT_int32, PT_int32, PT_int32, PT_int32, PT_int32 };
+static const uint8_t command_parameters60[] PROGMEM = {
+    PT_byte, PT_byte, PT_byte, PT_byte, PT_uint32, PT_uint32, PT_uint32 };
+static const uint8_t command_parameters61[] PROGMEM = {
+    PT_byte, PT_byte, PT_byte, PT_int32, PT_int32, PT_int32 };
+static const uint8_t command_parameters62[] PROGMEM = {
+    PT_byte, PT_int32, PT_int32 };
+static const uint8_t command_parameters63[] PROGMEM = {
+    PT_byte, PT_uint32, PT_int32 };
+static const uint8_t command_parameters64[] PROGMEM = {
+    PT_byte, PT_int32, PT_int32, PT_int32, PT_int32, PT_int32, PT_uint16 };
+
+#if CONFIG_WANT_FAST_ENCODERS
+#define FE_FUNC(fn) .encode_func=fn,
+#define FE_ARG_U16(args) (sizeof(uint32_t) > sizeof(int) \
+                          ? va_arg(args, unsigned int) : va_arg(args, uint32_t))
+#define FE_ARG_I16(args) (sizeof(uint32_t) > sizeof(int) \
+                          ? (uint32_t)(int32_t)va_arg(args, int) \
+                          : va_arg(args, uint32_t))
+
+static uint_fast8_t
+command_fast_encode_117(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x75;
+    (void)args;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_118(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x76;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_119(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x77;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_120(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x78;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_121(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x79;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_122(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x7a;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_123(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x7b;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_124(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x7c;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_125(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x7d;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_126(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x7e;
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_127(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x7f;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_128(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x00;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_129(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x01;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_130(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x02;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_131(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x03;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_132(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x04;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_133(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x05;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_134(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x06;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_I16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_135(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x07;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_136(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x08;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_137(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x09;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_138(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x0a;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_139(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x0b;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_140(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x0c;
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_141(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x0d;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_142(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x0e;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_143(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x0f;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_144(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x10;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE + 59];
+    uint32_t blen = va_arg(args, int);
+    if (blen > maxend - p)
+        blen = maxend - p;
+    *p++ = blen;
+    memcpy(p, va_arg(args, uint8_t*), blen);
+    p += blen;
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_145(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x11;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_146(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x12;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+
+static uint_fast8_t
+command_fast_encode_147(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    *p++ = 0x81;
+    *p++ = 0x13;
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, FE_ARG_U16(args));
+    p = command_encode_int(p, va_arg(args, uint32_t));
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+#else
+#define FE_FUNC(fn)
+#endif
+
+const struct command_encoder command_encoder_117 PROGMEM = {    
+    // starting
+    .encoded_msgid=117, // msgid=-11
+    .num_params=0,
+    .param_types = 0,
+    .max_size=6,
+    FE_FUNC(command_fast_encode_117)
+};
+const struct command_encoder command_encoder_118 PROGMEM = {    
+    // is_shutdown static_string_id=%hu
+    .encoded_msgid=118, // msgid=-10
+    .num_params=1,
+    .param_types = command_parameters0,
+    .max_size=9,
+    FE_FUNC(command_fast_encode_118)
+};
+const struct command_encoder command_encoder_119 PROGMEM = {    
+    // shutdown clock=%u static_string_id=%hu
+    .encoded_msgid=119, // msgid=-9
+    .num_params=2,
+    .param_types = command_parameters1,
+    .max_size=14,
+    FE_FUNC(command_fast_encode_119)
+};
+const struct command_encoder command_encoder_0 PROGMEM = {    
+    // identify_response offset=%u data=%.*s
+    .encoded_msgid=0, // msgid=0
+    .num_params=2,
+    .param_types = command_parameters2,
+    .max_size=64,
+    FE_FUNC(0)
+};
+const struct command_encoder command_encoder_120 PROGMEM = {    
+    // stats count=%u sum=%u sumsq=%u move_max=%hu
+    .encoded_msgid=120, // msgid=-8
+    .num_params=4,
+    .param_types = command_parameters3,
+    .max_size=24,
+    FE_FUNC(command_fast_encode_120)
+};
+const struct command_encoder command_encoder_121 PROGMEM = {    
+    // uptime high=%u clock=%u
+    .encoded_msgid=121, // msgid=-7
+    .num_params=2,
+    .param_types = command_parameters4,
+    .max_size=16,
+    FE_FUNC(command_fast_encode_121)
+};
+const struct command_encoder command_encoder_122 PROGMEM = {    
+    // clock clock=%u
+    .encoded_msgid=122, // msgid=-6
+    .num_params=1,
+    .param_types = command_parameters5,
+    .max_size=11,
+    FE_FUNC(command_fast_encode_122)
+};
+const struct command_encoder command_encoder_123 PROGMEM = {    
+    // config_section oid=%c crc=%u
+    .encoded_msgid=123, // msgid=-5
+    .num_params=2,
+    .param_types = command_parameters6,
+    .max_size=13,
+    FE_FUNC(command_fast_encode_123)
+};
+const struct command_encoder command_encoder_124 PROGMEM = {    
+    // config is_config=%c crc=%u is_shutdown=%c move_count=%hu
+    .encoded_msgid=124, // msgid=-4
+    .num_params=4,
+    .param_types = command_parameters7,
+    .max_size=18,
+    FE_FUNC(command_fast_encode_124)
+};
+const struct command_encoder command_encoder_125 PROGMEM = {    
+    // step_benchmark_result steps=%u min_margin=%i avg_margin=%i samples=%hu
+    .encoded_msgid=125, // msgid=-3
+    .num_params=4,
+    .param_types = command_parameters8,
+    .max_size=24,
+    FE_FUNC(command_fast_encode_125)
+};
+const struct command_encoder command_encoder_126 PROGMEM = {    
+    // pong data=%*s
+    .encoded_msgid=126, // msgid=-2
+    .num_params=1,
+    .param_types = command_parameters9,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_126)
+};
+const struct command_encoder command_encoder_127 PROGMEM = {    
+    // debug_result val=%u
+    .encoded_msgid=127, // msgid=-1
+    .num_params=1,
+    .param_types = command_parameters5,
+    .max_size=11,
+    FE_FUNC(command_fast_encode_127)
+};
+const struct command_encoder command_encoder_128 PROGMEM = {    
+    // stepper_position oid=%c pos=%i
+    .encoded_msgid=128, // msgid=128
+    .num_params=2,
+    .param_types = command_parameters10,
+    .max_size=14,
+    FE_FUNC(command_fast_encode_128)
+};
+const struct command_encoder command_encoder_129 PROGMEM = {    
+    // endstop_state oid=%c homing=%c next_clock=%u pin_value=%c trigger_clock=%u
+    .encoded_msgid=129, // msgid=129
+    .num_params=5,
+    .param_types = command_parameters11,
+    .max_size=23,
+    FE_FUNC(command_fast_encode_129)
+};
+const struct command_encoder command_encoder_130 PROGMEM = {    
+    // trsync_state oid=%c can_trigger=%c trigger_reason=%c clock=%u
+    .encoded_msgid=130, // msgid=130
+    .num_params=4,
+    .param_types = command_parameters12,
+    .max_size=18,
+    FE_FUNC(command_fast_encode_130)
+};
+const struct command_encoder command_encoder_131 PROGMEM = {    
+    // analog_scan_state oid=%c next_clock=%u values=%*s
+    .encoded_msgid=131, // msgid=131
+    .num_params=3,
+    .param_types = command_parameters13,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_131)
+};
+const struct command_encoder command_encoder_132 PROGMEM = {    
+    // analog_in_state oid=%c next_clock=%u values=%*s
+    .encoded_msgid=132, // msgid=132
+    .num_params=3,
+    .param_types = command_parameters13,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_132)
+};
+const struct command_encoder command_encoder_133 PROGMEM = {    
+    // spi_transfer_response oid=%c response=%*s
+    .encoded_msgid=133, // msgid=133
+    .num_params=2,
+    .param_types = command_parameters14,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_133)
+};
+const struct command_encoder command_encoder_134 PROGMEM = {    
+    // encoder_state oid=%c count=%hi
+    .encoded_msgid=134, // msgid=134
+    .num_params=2,
+    .param_types = command_parameters15,
+    .max_size=12,
+    FE_FUNC(command_fast_encode_134)
+};
+const struct command_encoder command_encoder_135 PROGMEM = {    
+    // buttons_state oid=%c ack_count=%c state=%*s
+    .encoded_msgid=135, // msgid=135
+    .num_params=3,
+    .param_types = command_parameters16,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_135)
+};
+const struct command_encoder command_encoder_136 PROGMEM = {    
+    // tmcuart_response oid=%c read=%*s
+    .encoded_msgid=136, // msgid=136
+    .num_params=2,
+    .param_types = command_parameters14,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_136)
+};
+const struct command_encoder command_encoder_137 PROGMEM = {    
+    // tmcuart_batch_response oid=%c read=%*s
+    .encoded_msgid=137, // msgid=137
+    .num_params=2,
+    .param_types = command_parameters14,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_137)
+};
+const struct command_encoder command_encoder_138 PROGMEM = {    
+    // neopixel_result oid=%c success=%c
+    .encoded_msgid=138, // msgid=138
+    .num_params=2,
+    .param_types = command_parameters17,
+    .max_size=11,
+    FE_FUNC(command_fast_encode_138)
+};
+const struct command_encoder command_encoder_139 PROGMEM = {    
+    // counter_state oid=%c next_clock=%u count=%u count_clock=%u
+    .encoded_msgid=139, // msgid=139
+    .num_params=4,
+    .param_types = command_parameters18,
+    .max_size=24,
+    FE_FUNC(command_fast_encode_139)
+};
+const struct command_encoder command_encoder_140 PROGMEM = {    
+    // thermocouple_batch_results next_clock=%u data=%*s
+    .encoded_msgid=140, // msgid=140
+    .num_params=2,
+    .param_types = command_parameters19,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_140)
+};
+const struct command_encoder command_encoder_141 PROGMEM = {    
+    // spi_angle_transfer_response oid=%c clock=%u response=%*s
+    .encoded_msgid=141, // msgid=141
+    .num_params=3,
+    .param_types = command_parameters13,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_141)
+};
+const struct command_encoder command_encoder_142 PROGMEM = {    
+    // spi_angle_divergence oid=%c clock=%u expected=%hu measured=%hu
+    .encoded_msgid=142, // msgid=142
+    .num_params=4,
+    .param_types = command_parameters20,
+    .max_size=20,
+    FE_FUNC(command_fast_encode_142)
+};
+const struct command_encoder command_encoder_143 PROGMEM = {    
+    // sensor_bulk_status oid=%c clock=%u query_ticks=%u next_sequence=%hu buffered=%u possible_overflows=%hu
+    .encoded_msgid=143, // msgid=143
+    .num_params=6,
+    .param_types = command_parameters21,
+    .max_size=30,
+    FE_FUNC(command_fast_encode_143)
+};
+const struct command_encoder command_encoder_144 PROGMEM = {    
+    // sensor_bulk_data oid=%c sequence=%hu data=%*s
+    .encoded_msgid=144, // msgid=144
+    .num_params=3,
+    .param_types = command_parameters22,
+    .max_size=64,
+    FE_FUNC(command_fast_encode_144)
+};
+const struct command_encoder command_encoder_145 PROGMEM = {    
+    // trigger_analog_state oid=%c homing=%c homing_clock=%u
+    .encoded_msgid=145, // msgid=145
+    .num_params=3,
+    .param_types = command_parameters23,
+    .max_size=16,
+    FE_FUNC(command_fast_encode_145)
+};
+const struct command_encoder command_encoder_146 PROGMEM = {    
+    // heater_pid_pwm oid=%c pwm=%hu
+    .encoded_msgid=146, // msgid=146
+    .num_params=2,
+    .param_types = command_parameters24,
+    .max_size=12,
+    FE_FUNC(command_fast_encode_146)
+};
+const struct command_encoder command_encoder_147 PROGMEM = {    
+    // heater_pid_state oid=%c active=%c pwm=%hu integ=%i
+    .encoded_msgid=147, // msgid=147
+    .num_params=4,
+    .param_types = command_parameters25,
+    .max_size=19,
+    FE_FUNC(command_fast_encode_147)
+};
+
+const __always_inline struct command_encoder *
+ctr_lookup_encoder(const char *str)
+{
+    if (__builtin_strcmp(str, "starting") == 0)
+        return &command_encoder_117;
+    if (__builtin_strcmp(str, "is_shutdown static_string_id=%hu") == 0)
+        return &command_encoder_118;
+    if (__builtin_strcmp(str, "shutdown clock=%u static_string_id=%hu") == 0)
+        return &command_encoder_119;
+    if (__builtin_strcmp(str, "identify_response offset=%u data=%.*s") == 0)
+        return &command_encoder_0;
+    if (__builtin_strcmp(str, "stats count=%u sum=%u sumsq=%u move_max=%hu") == 0)
+        return &command_encoder_120;
+    if (__builtin_strcmp(str, "uptime high=%u clock=%u") == 0)
+        return &command_encoder_121;
+    if (__builtin_strcmp(str, "clock clock=%u") == 0)
+        return &command_encoder_122;
+    if (__builtin_strcmp(str, "config_section oid=%c crc=%u") == 0)
+        return &command_encoder_123;
+    if (__builtin_strcmp(str, "config is_config=%c crc=%u is_shutdown=%c move_count=%hu") == 0)
+        return &command_encoder_124;
+    if (__builtin_strcmp(str, "step_benchmark_result steps=%u min_margin=%i avg_margin=%i samples=%hu") == 0)
+        return &command_encoder_125;
+    if (__builtin_strcmp(str, "pong data=%*s") == 0)
+        return &command_encoder_126;
+    if (__builtin_strcmp(str, "debug_result val=%u") == 0)
+        return &command_encoder_127;
+    if (__builtin_strcmp(str, "stepper_position oid=%c pos=%i") == 0)
+        return &command_encoder_128;
+    if (__builtin_strcmp(str, "endstop_state oid=%c homing=%c next_clock=%u pin_value=%c trigger_clock=%u") == 0)
+        return &command_encoder_129;
+    if (__builtin_strcmp(str, "trsync_state oid=%c can_trigger=%c trigger_reason=%c clock=%u") == 0)
+        return &command_encoder_130;
+    if (__builtin_strcmp(str, "analog_scan_state oid=%c next_clock=%u values=%*s") == 0)
+        return &command_encoder_131;
+    if (__builtin_strcmp(str, "analog_in_state oid=%c next_clock=%u values=%*s") == 0)
+        return &command_encoder_132;
+    if (__builtin_strcmp(str, "spi_transfer_response oid=%c response=%*s") == 0)
+        return &command_encoder_133;
+    if (__builtin_strcmp(str, "encoder_state oid=%c count=%hi") == 0)
+        return &command_encoder_134;
+    if (__builtin_strcmp(str, "buttons_state oid=%c ack_count=%c state=%*s") == 0)
+        return &command_encoder_135;
+    if (__builtin_strcmp(str, "tmcuart_response oid=%c read=%*s") == 0)
+        return &command_encoder_136;
+    if (__builtin_strcmp(str, "tmcuart_batch_response oid=%c read=%*s") == 0)
+        return &command_encoder_137;
+    if (__builtin_strcmp(str, "neopixel_result oid=%c success=%c") == 0)
+        return &command_encoder_138;
+    if (__builtin_strcmp(str, "counter_state oid=%c next_clock=%u count=%u count_clock=%u") == 0)
+        return &command_encoder_139;
+    if (__builtin_strcmp(str, "thermocouple_batch_results next_clock=%u data=%*s") == 0)
+        return &command_encoder_140;
+    if (__builtin_strcmp(str, "spi_angle_transfer_response oid=%c clock=%u response=%*s") == 0)
+        return &command_encoder_141;
+    if (__builtin_strcmp(str, "spi_angle_divergence oid=%c clock=%u expected=%hu measured=%hu") == 0)
+        return &command_encoder_142;
+    if (__builtin_strcmp(str, "sensor_bulk_status oid=%c clock=%u query_ticks=%u next_sequence=%hu buffered=%u possible_overflows=%hu") == 0)
+        return &command_encoder_143;
+    if (__builtin_strcmp(str, "sensor_bulk_data oid=%c sequence=%hu data=%*s") == 0)
+        return &command_encoder_144;
+    if (__builtin_strcmp(str, "trigger_analog_state oid=%c homing=%c homing_clock=%u") == 0)
+        return &command_encoder_145;
+    if (__builtin_strcmp(str, "heater_pid_pwm oid=%c pwm=%hu") == 0)
+        return &command_encoder_146;
+    if (__builtin_strcmp(str, "heater_pid_state oid=%c active=%c pwm=%hu integ=%i") == 0)
+        return &command_encoder_147;
+    return NULL;
+}
+
+const __always_inline struct command_encoder *
+ctr_lookup_output(const char *str)
+{
+    
+    return NULL;
+}
+
+extern void ads1220_attach_trigger_analog(uint32_t*);
+extern void command_allocate_oids(uint32_t*);
+extern void command_analog_in_attach_heater_pid(uint32_t*);
+extern void command_analog_in_attach_trigger_analog(uint32_t*);
+extern void command_analog_scan_add_pin(uint32_t*);
+extern void command_buttons_ack(uint32_t*);
+extern void command_buttons_add(uint32_t*);
+extern void command_buttons_query(uint32_t*);
+extern void command_clear_shutdown(uint32_t*);
+extern void command_config_ads1220(uint32_t*);
+extern void command_config_adxl345(uint32_t*);
+extern void command_config_analog_in(uint32_t*);
+extern void command_config_analog_scan(uint32_t*);
+extern void command_config_bmi160(uint32_t*);
+extern void command_config_buttons(uint32_t*);
+extern void command_config_counter(uint32_t*);
+extern void command_config_digital_out(uint32_t*);
+extern void command_config_encoder(uint32_t*);
+extern void command_config_endstop(uint32_t*);
+extern void command_config_hd44780(uint32_t*);
+extern void command_config_heater_pid(uint32_t*);
+extern void command_config_hx71x(uint32_t*);
+extern void command_config_lis2dw(uint32_t*);
+extern void command_config_neopixel(uint32_t*);
+extern void command_config_pwm_out(uint32_t*);
+extern void command_config_section_crc(uint32_t*);
+extern void command_config_sos_filter(uint32_t*);
+extern void command_config_spi(uint32_t*);
+extern void command_config_spi_angle(uint32_t*);
+extern void command_config_spi_shutdown(uint32_t*);
+extern void command_config_spi_without_cs(uint32_t*);
+extern void command_config_st7920(uint32_t*);
+extern void command_config_stepper(uint32_t*);
+extern void command_config_thermocouple(uint32_t*);
+extern void command_config_tmcuart(uint32_t*);
+extern void command_config_trigger_analog(uint32_t*);
+extern void command_config_trsync(uint32_t*);
+extern void command_debug_nop(uint32_t*);
+extern void command_debug_ping(uint32_t*);
+extern void command_debug_read(uint32_t*);
+extern void command_debug_write(uint32_t*);
+extern void command_emergency_stop(uint32_t*);
+extern void command_encoder_query(uint32_t*);
+extern void command_endstop_home(uint32_t*);
+extern void command_endstop_query_state(uint32_t*);
+extern void command_finalize_config(uint32_t*);
+extern void command_get_clock(uint32_t*);
+extern void command_get_config(uint32_t*);
+extern void command_get_config_section(uint32_t*);
+extern void command_get_uptime(uint32_t*);
+extern void command_hd44780_send_cmds(uint32_t*);
+extern void command_hd44780_send_data(uint32_t*);
+extern void command_heater_pid_manual(uint32_t*);
+extern void command_heater_pid_query_state(uint32_t*);
+extern void command_heater_pid_set_gains(uint32_t*);
+extern void command_heater_pid_set_target(uint32_t*);
+extern void command_identify(uint32_t*);
+extern void command_neopixel_send(uint32_t*);
+extern void command_neopixel_update(uint32_t*);
+extern void command_query_ads1220(uint32_t*);
+extern void command_query_ads1220_status(uint32_t*);
+extern void command_query_adxl345(uint32_t*);
+extern void command_query_adxl345_status(uint32_t*);
+extern void command_query_analog_in(uint32_t*);
+extern void command_query_analog_scan(uint32_t*);
+extern void command_query_bmi160(uint32_t*);
+extern void command_query_bmi160_status(uint32_t*);
+extern void command_query_counter(uint32_t*);
+extern void command_query_hx71x(uint32_t*);
+extern void command_query_hx71x_status(uint32_t*);
+extern void command_query_lis2dw(uint32_t*);
+extern void command_query_lis2dw_status(uint32_t*);
+extern void command_query_spi_angle(uint32_t*);
+extern void command_query_thermocouple(uint32_t*);
+extern void command_queue_digital_out(uint32_t*);
+extern void command_queue_digital_out_batch(uint32_t*);
+extern void command_queue_pwm_out(uint32_t*);
+extern void command_queue_pwm_out_batch(uint32_t*);
+extern void command_queue_step(uint32_t*);
+extern void command_queue_step_pack(uint32_t*);
+extern void command_queue_step_repeat(uint32_t*);
+extern void command_reset_step_clock(uint32_t*);
+extern void command_set_digital_out(uint32_t*);
+extern void command_set_digital_out_pwm_cycle(uint32_t*);
+extern void command_set_next_step_dir(uint32_t*);
+extern void command_set_pwm_out(uint32_t*);
+extern void command_sos_filter_activate(uint32_t*);
+extern void command_sos_filter_set_section(uint32_t*);
+extern void command_sos_filter_set_state(uint32_t*);
+extern void command_spi_angle_set_burst(uint32_t*);
+extern void command_spi_angle_setup_compare(uint32_t*);
+extern void command_spi_angle_transfer(uint32_t*);
+extern void command_spi_send(uint32_t*);
+extern void command_spi_set_bus(uint32_t*);
+extern void command_spi_set_sw_bus(uint32_t*);
+extern void command_spi_transfer(uint32_t*);
+extern void command_st7920_send_cmds(uint32_t*);
+extern void command_st7920_send_data(uint32_t*);
+extern void command_start_step_benchmark(uint32_t*);
+extern void command_stepper_get_position(uint32_t*);
+extern void command_stepper_stop_on_trigger(uint32_t*);
+extern void command_tmcuart_batch_send(uint32_t*);
+extern void command_tmcuart_send(uint32_t*);
+extern void command_trigger_analog_home(uint32_t*);
+extern void command_trigger_analog_query_state(uint32_t*);
+extern void command_trigger_analog_set_drift(uint32_t*);
+extern void command_trigger_analog_set_linearize(uint32_t*);
+extern void command_trigger_analog_set_offset_scale(uint32_t*);
+extern void command_trigger_analog_set_raw_range(uint32_t*);
+extern void command_trigger_analog_set_trigger(uint32_t*);
+extern void command_trsync_set_timeout(uint32_t*);
+extern void command_trsync_set_trigger_window(uint32_t*);
+extern void command_trsync_start(uint32_t*);
+extern void command_trsync_trigger(uint32_t*);
+extern void command_update_digital_out(uint32_t*);
+extern void hx71x_attach_trigger_analog(uint32_t*);
+
+const struct command_parser command_index[] PROGMEM = {
+{
+}, {
+    // identify offset=%u count=%c
+    .encoded_msgid=1, // msgid=1
+    .num_params=2,
+    .param_types = command_parameters26,
+    .num_args=2,
+    .flags=0x01,
+    .func=command_identify
+}, {
+    // clear_shutdown
+    .encoded_msgid=2, // msgid=2
+    .num_params=0,
+    .param_types = 0,
+    .num_args=0,
+    .flags=0x01,
+    .func=command_clear_shutdown
+}, {
+    // emergency_stop
+    .encoded_msgid=3, // msgid=3
+    .num_params=0,
+    .param_types = 0,
+    .num_args=0,
+    .flags=0x01,
+    .func=command_emergency_stop
+}, {
+    // get_uptime
+    .encoded_msgid=4, // msgid=4
+    .num_params=0,
+    .param_types = 0,
+    .num_args=0,
+    .flags=0x01,
+    .func=command_get_uptime
+}, {
+    // get_clock
+    .encoded_msgid=5, // msgid=5
+    .num_params=0,
+    .param_types = 0,
+    .num_args=0,
+    .flags=0x01,
+    .func=command_get_clock
+}, {
+    // get_config_section oid=%c
+    .encoded_msgid=6, // msgid=6
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0x01,
+    .func=command_get_config_section
+}, {
+    // config_section_crc oid=%c crc=%u
+    .encoded_msgid=7, // msgid=7
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_section_crc
+}, {
+    // finalize_config crc=%u
+    .encoded_msgid=8, // msgid=8
+    .num_params=1,
+    .param_types = command_parameters5,
+    .num_args=1,
+    .flags=0,
+    .func=command_finalize_config
+}, {
+    // get_config
+    .encoded_msgid=9, // msgid=9
+    .num_params=0,
+    .param_types = 0,
+    .num_args=0,
+    .flags=0x01,
+    .func=command_get_config
+}, {
+    // allocate_oids count=%c
+    .encoded_msgid=10, // msgid=10
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_allocate_oids
+}, {
+    // start_step_benchmark oid_count=%c interval=%u count=%hu chunks=%u
+    .encoded_msgid=11, // msgid=11
+    .num_params=4,
+    .param_types = command_parameters28,
+    .num_args=4,
+    .flags=0,
+    .func=command_start_step_benchmark
+}, {
+    // debug_nop
+    .encoded_msgid=12, // msgid=12
+    .num_params=0,
+    .param_types = 0,
+    .num_args=0,
+    .flags=0x01,
+    .func=command_debug_nop
+}, {
+    // debug_ping data=%*s
+    .encoded_msgid=13, // msgid=13
+    .num_params=1,
+    .param_types = command_parameters9,
+    .num_args=2,
+    .flags=0x01,
+    .func=command_debug_ping
+}, {
+    // debug_write order=%c addr=%u val=%u
+    .encoded_msgid=14, // msgid=14
+    .num_params=3,
+    .param_types = command_parameters29,
+    .num_args=3,
+    .flags=0x01,
+    .func=command_debug_write
+}, {
+    // debug_read order=%c addr=%u
+    .encoded_msgid=15, // msgid=15
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0x01,
+    .func=command_debug_read
+}, {
+    // set_digital_out pin=%u value=%c
+    .encoded_msgid=16, // msgid=16
+    .num_params=2,
+    .param_types = command_parameters26,
+    .num_args=2,
+    .flags=0,
+    .func=command_set_digital_out
+}, {
+    // update_digital_out oid=%c value=%c
+    .encoded_msgid=17, // msgid=17
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_update_digital_out
+}, {
+    // queue_digital_out_batch data=%*s
+    .encoded_msgid=18, // msgid=18
+    .num_params=1,
+    .param_types = command_parameters9,
+    .num_args=2,
+    .flags=0,
+    .func=command_queue_digital_out_batch
+}, {
+    // queue_digital_out oid=%c clock=%u on_ticks=%u
+    .encoded_msgid=19, // msgid=19
+    .num_params=3,
+    .param_types = command_parameters29,
+    .num_args=3,
+    .flags=0,
+    .func=command_queue_digital_out
+}, {
+    // set_digital_out_pwm_cycle oid=%c cycle_ticks=%u
+    .encoded_msgid=20, // msgid=20
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_set_digital_out_pwm_cycle
+}, {
+    // config_digital_out oid=%c pin=%u value=%c default_value=%c max_duration=%u
+    .encoded_msgid=21, // msgid=21
+    .num_params=5,
+    .param_types = command_parameters30,
+    .num_args=5,
+    .flags=0,
+    .func=command_config_digital_out
+}, {
+    // stepper_stop_on_trigger oid=%c trsync_oid=%c
+    .encoded_msgid=22, // msgid=22
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_stepper_stop_on_trigger
+}, {
+    // stepper_get_position oid=%c
+    .encoded_msgid=23, // msgid=23
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_stepper_get_position
+}, {
+    // reset_step_clock oid=%c clock=%u
+    .encoded_msgid=24, // msgid=24
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_reset_step_clock
+}, {
+    // set_next_step_dir oid=%c dir=%c
+    .encoded_msgid=25, // msgid=25
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_set_next_step_dir
+}, {
+    // queue_step_pack oid=%c data=%*s
+    .encoded_msgid=26, // msgid=26
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_queue_step_pack
+}, {
+    // queue_step_repeat oid=%c interval=%u count=%hu add=%hi repeat=%hu
+    .encoded_msgid=27, // msgid=27
+    .num_params=5,
+    .param_types = command_parameters31,
+    .num_args=5,
+    .flags=0,
+    .func=command_queue_step_repeat
+}, {
+    // queue_step oid=%c interval=%u count=%hu add=%hi
+    .encoded_msgid=28, // msgid=28
+    .num_params=4,
+    .param_types = command_parameters32,
+    .num_args=4,
+    .flags=0,
+    .func=command_queue_step
+}, {
+    // config_stepper oid=%c step_pin=%c dir_pin=%c invert_step=%c step_pulse_ticks=%u
+    .encoded_msgid=29, // msgid=29
+    .num_params=5,
+    .param_types = command_parameters33,
+    .num_args=5,
+    .flags=0,
+    .func=command_config_stepper
+}, {
+    // endstop_query_state oid=%c
+    .encoded_msgid=30, // msgid=30
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_endstop_query_state
+}, {
+    // endstop_home oid=%c clock=%u sample_ticks=%u sample_count=%c rest_ticks=%u pin_value=%c trsync_oid=%c trigger_reason=%c
+    .encoded_msgid=31, // msgid=31
+    .num_params=8,
+    .param_types = command_parameters34,
+    .num_args=8,
+    .flags=0,
+    .func=command_endstop_home
+}, {
+    // config_endstop oid=%c pin=%c pull_up=%c
+    .encoded_msgid=32, // msgid=32
+    .num_params=3,
+    .param_types = command_parameters35,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_endstop
+}, {
+    // trsync_trigger oid=%c reason=%c
+    .encoded_msgid=33, // msgid=33
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_trsync_trigger
+}, {
+    // trsync_set_trigger_window oid=%c clock=%u report_ticks=%u
+    .encoded_msgid=34, // msgid=34
+    .num_params=3,
+    .param_types = command_parameters29,
+    .num_args=3,
+    .flags=0,
+    .func=command_trsync_set_trigger_window
+}, {
+    // trsync_set_timeout oid=%c clock=%u
+    .encoded_msgid=35, // msgid=35
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_trsync_set_timeout
+}, {
+    // trsync_start oid=%c report_clock=%u report_ticks=%u expire_reason=%c
+    .encoded_msgid=36, // msgid=36
+    .num_params=4,
+    .param_types = command_parameters36,
+    .num_args=4,
+    .flags=0,
+    .func=command_trsync_start
+}, {
+    // config_trsync oid=%c
+    .encoded_msgid=37, // msgid=37
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_config_trsync
+}, {
+    // query_analog_scan oid=%c clock=%u sample_ticks=%u sample_count=%c rest_ticks=%u range_check_count=%c
+    .encoded_msgid=38, // msgid=38
+    .num_params=6,
+    .param_types = command_parameters37,
+    .num_args=6,
+    .flags=0,
+    .func=command_query_analog_scan
+}, {
+    // analog_scan_add_pin oid=%c pos=%c pin=%u min_value=%hu max_value=%hu
+    .encoded_msgid=39, // msgid=39
+    .num_params=5,
+    .param_types = command_parameters38,
+    .num_args=5,
+    .flags=0,
+    .func=command_analog_scan_add_pin
+}, {
+    // config_analog_scan oid=%c channel_count=%c
+    .encoded_msgid=40, // msgid=40
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_analog_scan
+}, {
+    // analog_in_attach_heater_pid oid=%c heater_pid_oid=%c
+    .encoded_msgid=41, // msgid=41
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_analog_in_attach_heater_pid
+}, {
+    // analog_in_attach_trigger_analog oid=%c trigger_analog_oid=%c
+    .encoded_msgid=42, // msgid=42
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_analog_in_attach_trigger_analog
+}, {
+    // query_analog_in oid=%c clock=%u sample_ticks=%u sample_count=%c rest_ticks=%u bytes_per_report=%c min_value=%hu max_value=%hu range_check_count=%c
+    .encoded_msgid=43, // msgid=43
+    .num_params=9,
+    .param_types = command_parameters39,
+    .num_args=9,
+    .flags=0,
+    .func=command_query_analog_in
+}, {
+    // config_analog_in oid=%c pin=%u
+    .encoded_msgid=44, // msgid=44
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_analog_in
+}, {
+    // config_spi_shutdown oid=%c spi_oid=%c shutdown_msg=%*s
+    .encoded_msgid=45, // msgid=45
+    .num_params=3,
+    .param_types = command_parameters16,
+    .num_args=4,
+    .flags=0,
+    .func=command_config_spi_shutdown
+}, {
+    // spi_send oid=%c data=%*s
+    .encoded_msgid=46, // msgid=46
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_spi_send
+}, {
+    // spi_transfer oid=%c data=%*s
+    .encoded_msgid=47, // msgid=47
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_spi_transfer
+}, {
+    // spi_set_bus oid=%c spi_bus=%u mode=%u rate=%u
+    .encoded_msgid=48, // msgid=48
+    .num_params=4,
+    .param_types = command_parameters18,
+    .num_args=4,
+    .flags=0,
+    .func=command_spi_set_bus
+}, {
+    // config_spi_without_cs oid=%c
+    .encoded_msgid=49, // msgid=49
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_config_spi_without_cs
+}, {
+    // config_spi oid=%c pin=%u cs_active_high=%c
+    .encoded_msgid=50, // msgid=50
+    .num_params=3,
+    .param_types = command_parameters40,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_spi
+}, {
+    // set_pwm_out pin=%u cycle_ticks=%u value=%hu
+    .encoded_msgid=51, // msgid=51
+    .num_params=3,
+    .param_types = command_parameters41,
+    .num_args=3,
+    .flags=0,
+    .func=command_set_pwm_out
+}, {
+    // queue_pwm_out_batch data=%*s
+    .encoded_msgid=52, // msgid=52
+    .num_params=1,
+    .param_types = command_parameters9,
+    .num_args=2,
+    .flags=0,
+    .func=command_queue_pwm_out_batch
+}, {
+    // queue_pwm_out oid=%c clock=%u value=%hu
+    .encoded_msgid=53, // msgid=53
+    .num_params=3,
+    .param_types = command_parameters42,
+    .num_args=3,
+    .flags=0,
+    .func=command_queue_pwm_out
+}, {
+    // config_pwm_out oid=%c pin=%u cycle_ticks=%u value=%hu default_value=%hu max_duration=%u
+    .encoded_msgid=54, // msgid=54
+    .num_params=6,
+    .param_types = command_parameters43,
+    .num_args=6,
+    .flags=0,
+    .func=command_config_pwm_out
+}, {
+    // encoder_query oid=%c clock=%u rest_ticks=%u report_ticks=%u
+    .encoded_msgid=55, // msgid=55
+    .num_params=4,
+    .param_types = command_parameters18,
+    .num_args=4,
+    .flags=0,
+    .func=command_encoder_query
+}, {
+    // config_encoder oid=%c pin_a=%u pull_up_a=%c pin_b=%u pull_up_b=%c invert=%c steps_per_detent=%c
+    .encoded_msgid=56, // msgid=56
+    .num_params=7,
+    .param_types = command_parameters44,
+    .num_args=7,
+    .flags=0,
+    .func=command_config_encoder
+}, {
+    // buttons_ack oid=%c count=%c
+    .encoded_msgid=57, // msgid=57
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_buttons_ack
+}, {
+    // buttons_query oid=%c clock=%u rest_ticks=%u retransmit_count=%c invert=%c
+    .encoded_msgid=58, // msgid=58
+    .num_params=5,
+    .param_types = command_parameters45,
+    .num_args=5,
+    .flags=0,
+    .func=command_buttons_query
+}, {
+    // buttons_add oid=%c pos=%c pin=%u pull_up=%c
+    .encoded_msgid=59, // msgid=59
+    .num_params=4,
+    .param_types = command_parameters46,
+    .num_args=4,
+    .flags=0,
+    .func=command_buttons_add
+}, {
+    // config_buttons oid=%c button_count=%c
+    .encoded_msgid=60, // msgid=60
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_buttons
+}, {
+    // tmcuart_batch_send oid=%c count=%c write=%*s read=%c
+    .encoded_msgid=61, // msgid=61
+    .num_params=4,
+    .param_types = command_parameters47,
+    .num_args=5,
+    .flags=0,
+    .func=command_tmcuart_batch_send
+}, {
+    // tmcuart_send oid=%c write=%*s read=%c
+    .encoded_msgid=62, // msgid=62
+    .num_params=3,
+    .param_types = command_parameters48,
+    .num_args=4,
+    .flags=0,
+    .func=command_tmcuart_send
+}, {
+    // config_tmcuart oid=%c rx_pin=%u pull_up=%c tx_pin=%u bit_time=%u
+    .encoded_msgid=63, // msgid=63
+    .num_params=5,
+    .param_types = command_parameters49,
+    .num_args=5,
+    .flags=0,
+    .func=command_config_tmcuart
+}, {
+    // neopixel_send oid=%c
+    .encoded_msgid=64, // msgid=64
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_neopixel_send
+}, {
+    // neopixel_update oid=%c pos=%hu data=%*s
+    .encoded_msgid=65, // msgid=65
+    .num_params=3,
+    .param_types = command_parameters22,
+    .num_args=4,
+    .flags=0,
+    .func=command_neopixel_update
+}, {
+    // config_neopixel oid=%c pin=%u data_size=%hu bit_max_ticks=%u reset_min_ticks=%u
+    .encoded_msgid=66, // msgid=66
+    .num_params=5,
+    .param_types = command_parameters50,
+    .num_args=5,
+    .flags=0,
+    .func=command_config_neopixel
+}, {
+    // query_counter oid=%c clock=%u poll_ticks=%u sample_ticks=%u
+    .encoded_msgid=67, // msgid=67
+    .num_params=4,
+    .param_types = command_parameters18,
+    .num_args=4,
+    .flags=0,
+    .func=command_query_counter
+}, {
+    // config_counter oid=%c pin=%u pull_up=%c
+    .encoded_msgid=68, // msgid=68
+    .num_params=3,
+    .param_types = command_parameters40,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_counter
+}, {
+    // st7920_send_data oid=%c data=%*s
+    .encoded_msgid=69, // msgid=69
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_st7920_send_data
+}, {
+    // st7920_send_cmds oid=%c cmds=%*s
+    .encoded_msgid=70, // msgid=70
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_st7920_send_cmds
+}, {
+    // config_st7920 oid=%c cs_pin=%u sclk_pin=%u sid_pin=%u sync_delay_ticks=%u cmd_delay_ticks=%u
+    .encoded_msgid=71, // msgid=71
+    .num_params=6,
+    .param_types = command_parameters51,
+    .num_args=6,
+    .flags=0,
+    .func=command_config_st7920
+}, {
+    // hd44780_send_data oid=%c data=%*s
+    .encoded_msgid=72, // msgid=72
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_hd44780_send_data
+}, {
+    // hd44780_send_cmds oid=%c cmds=%*s
+    .encoded_msgid=73, // msgid=73
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_hd44780_send_cmds
+}, {
+    // config_hd44780 oid=%c rs_pin=%u e_pin=%u d4_pin=%u d5_pin=%u d6_pin=%u d7_pin=%u delay_ticks=%u
+    .encoded_msgid=74, // msgid=74
+    .num_params=8,
+    .param_types = command_parameters52,
+    .num_args=8,
+    .flags=0,
+    .func=command_config_hd44780
+}, {
+    // spi_set_sw_bus oid=%c miso_pin=%u mosi_pin=%u sclk_pin=%u mode=%u pulse_ticks=%u
+    .encoded_msgid=75, // msgid=75
+    .num_params=6,
+    .param_types = command_parameters51,
+    .num_args=6,
+    .flags=0,
+    .func=command_spi_set_sw_bus
+}, {
+    // query_thermocouple oid=%c clock=%u rest_ticks=%u min_value=%u max_value=%u max_invalid_count=%c
+    .encoded_msgid=76, // msgid=76
+    .num_params=6,
+    .param_types = command_parameters53,
+    .num_args=6,
+    .flags=0,
+    .func=command_query_thermocouple
+}, {
+    // config_thermocouple oid=%c spi_oid=%c thermocouple_type=%c
+    .encoded_msgid=77, // msgid=77
+    .num_params=3,
+    .param_types = command_parameters35,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_thermocouple
+}, {
+    // query_adxl345_status oid=%c
+    .encoded_msgid=78, // msgid=78
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_query_adxl345_status
+}, {
+    // query_adxl345 oid=%c rest_ticks=%u
+    .encoded_msgid=79, // msgid=79
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_query_adxl345
+}, {
+    // config_adxl345 oid=%c spi_oid=%c
+    .encoded_msgid=80, // msgid=80
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_adxl345
+}, {
+    // query_lis2dw_status oid=%c
+    .encoded_msgid=81, // msgid=81
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_query_lis2dw_status
+}, {
+    // query_lis2dw oid=%c rest_ticks=%u
+    .encoded_msgid=82, // msgid=82
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_query_lis2dw
+}, {
+    // config_lis2dw oid=%c bus_oid=%c bus_oid_type=%c lis_chip_type=%c
+    .encoded_msgid=83, // msgid=83
+    .num_params=4,
+    .param_types = command_parameters54,
+    .num_args=4,
+    .flags=0,
+    .func=command_config_lis2dw
+}, {
+    // query_bmi160_status oid=%c
+    .encoded_msgid=84, // msgid=84
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_query_bmi160_status
+}, {
+    // query_bmi160 oid=%c rest_ticks=%u
+    .encoded_msgid=85, // msgid=85
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_query_bmi160
+}, {
+    // config_bmi160 oid=%c bus_oid=%c bus_oid_type=%c
+    .encoded_msgid=86, // msgid=86
+    .num_params=3,
+    .param_types = command_parameters35,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_bmi160
+}, {
+    // query_hx71x_status oid=%c
+    .encoded_msgid=87, // msgid=87
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_query_hx71x_status
+}, {
+    // query_hx71x oid=%c rest_ticks=%u
+    .encoded_msgid=88, // msgid=88
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_query_hx71x
+}, {
+    // hx71x_attach_trigger_analog oid=%c trigger_analog_oid=%c
+    .encoded_msgid=89, // msgid=89
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=hx71x_attach_trigger_analog
+}, {
+    // config_hx71x oid=%c gain_channel=%c dout_pin=%u sclk_pin=%u
+    .encoded_msgid=90, // msgid=90
+    .num_params=4,
+    .param_types = command_parameters55,
+    .num_args=4,
+    .flags=0,
+    .func=command_config_hx71x
+}, {
+    // query_ads1220_status oid=%c
+    .encoded_msgid=91, // msgid=91
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_query_ads1220_status
+}, {
+    // query_ads1220 oid=%c rest_ticks=%u
+    .encoded_msgid=92, // msgid=92
+    .num_params=2,
+    .param_types = command_parameters6,
+    .num_args=2,
+    .flags=0,
+    .func=command_query_ads1220
+}, {
+    // ads1220_attach_trigger_analog oid=%c trigger_analog_oid=%c
+    .encoded_msgid=93, // msgid=93
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=ads1220_attach_trigger_analog
+}, {
+    // config_ads1220 oid=%c spi_oid=%c data_ready_pin=%u
+    .encoded_msgid=94, // msgid=94
+    .num_params=3,
+    .param_types = command_parameters23,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_ads1220
+}, {
+    // spi_angle_transfer oid=%c data=%*s
+    .encoded_msgid=95, // msgid=95
+    .num_params=2,
+    .param_types = command_parameters14,
+    .num_args=3,
+    .flags=0,
+    .func=command_spi_angle_transfer
+}, {
+    // query_spi_angle oid=%c clock=%u rest_ticks=%u time_shift=%c
+    .encoded_msgid=96, // msgid=-32
+    .num_params=4,
+    .param_types = command_parameters36,
+    .num_args=4,
+    .flags=0,
+    .func=command_query_spi_angle
+}, {
+    // spi_angle_setup_compare oid=%c stepper_oid=%c scale=%i threshold=%u
+    .encoded_msgid=97, // msgid=-31
+    .num_params=4,
+    .param_types = command_parameters56,
+    .num_args=4,
+    .flags=0,
+    .func=command_spi_angle_setup_compare
+}, {
+    // spi_angle_set_burst oid=%c count=%c
+    .encoded_msgid=98, // msgid=-30
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_spi_angle_set_burst
+}, {
+    // config_spi_angle oid=%c spi_oid=%c spi_angle_type=%c
+    .encoded_msgid=99, // msgid=-29
+    .num_params=3,
+    .param_types = command_parameters35,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_spi_angle
+}, {
+    // sos_filter_set_active oid=%c n_sections=%c coeff_frac_bits=%c
+    .encoded_msgid=100, // msgid=-28
+    .num_params=3,
+    .param_types = command_parameters35,
+    .num_args=3,
+    .flags=0,
+    .func=command_sos_filter_activate
+}, {
+    // sos_filter_set_offset_scale oid=%c offset=%i scale=%i scale_frac_bits=%c auto_offset=%c
+    .encoded_msgid=101, // msgid=-27
+    .num_params=5,
+    .param_types = command_parameters57,
+    .num_args=5,
+    .flags=0,
+    .func=command_trigger_analog_set_offset_scale
+}, {
+    // sos_filter_set_state oid=%c section_idx=%c state0=%i state1=%i
+    .encoded_msgid=102, // msgid=-26
+    .num_params=4,
+    .param_types = command_parameters58,
+    .num_args=4,
+    .flags=0,
+    .func=command_sos_filter_set_state
+}, {
+    // sos_filter_set_section oid=%c section_idx=%c sos0=%i sos1=%i sos2=%i sos3=%i sos4=%i
+    .encoded_msgid=103, // msgid=-25
+    .num_params=7,
+    .param_types = command_parameters59,
+    .num_args=7,
+    .flags=0,
+    .func=command_sos_filter_set_section
+}, {
+    // config_sos_filter oid=%c max_sections=%c
+    .encoded_msgid=104, // msgid=-24
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_sos_filter
+}, {
+    // trigger_analog_query_state oid=%c
+    .encoded_msgid=105, // msgid=-23
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_trigger_analog_query_state
+}, {
+    // trigger_analog_home oid=%c trsync_oid=%c trigger_reason=%c error_reason=%c clock=%u monitor_ticks=%u monitor_max=%u
+    .encoded_msgid=106, // msgid=-22
+    .num_params=7,
+    .param_types = command_parameters60,
+    .num_args=7,
+    .flags=0,
+    .func=command_trigger_analog_home
+}, {
+    // trigger_analog_set_trigger oid=%c trigger_analog_type=%c trigger_value=%i trigger_arm_value=%i
+    .encoded_msgid=107, // msgid=-21
+    .num_params=4,
+    .param_types = command_parameters58,
+    .num_args=4,
+    .flags=0,
+    .func=command_trigger_analog_set_trigger
+}, {
+    // trigger_analog_set_drift oid=%c drift=%i
+    .encoded_msgid=108, // msgid=-20
+    .num_params=2,
+    .param_types = command_parameters10,
+    .num_args=2,
+    .flags=0,
+    .func=command_trigger_analog_set_drift
+}, {
+    // trigger_analog_set_linearize oid=%c index=%c count=%c raw_start=%i gain=%i offset=%i
+    .encoded_msgid=109, // msgid=-19
+    .num_params=6,
+    .param_types = command_parameters61,
+    .num_args=6,
+    .flags=0,
+    .func=command_trigger_analog_set_linearize
+}, {
+    // trigger_analog_set_raw_range oid=%c raw_min=%i raw_max=%i
+    .encoded_msgid=110, // msgid=-18
+    .num_params=3,
+    .param_types = command_parameters62,
+    .num_args=3,
+    .flags=0,
+    .func=command_trigger_analog_set_raw_range
+}, {
+    // config_trigger_analog oid=%c sos_filter_oid=%c
+    .encoded_msgid=111, // msgid=-17
+    .num_params=2,
+    .param_types = command_parameters17,
+    .num_args=2,
+    .flags=0,
+    .func=command_config_trigger_analog
+}, {
+    // heater_pid_query_state oid=%c
+    .encoded_msgid=112, // msgid=-16
+    .num_params=1,
+    .param_types = command_parameters27,
+    .num_args=1,
+    .flags=0,
+    .func=command_heater_pid_query_state
+}, {
+    // heater_pid_manual oid=%c clock=%u value=%hu
+    .encoded_msgid=113, // msgid=-15
+    .num_params=3,
+    .param_types = command_parameters42,
+    .num_args=3,
+    .flags=0,
+    .func=command_heater_pid_manual
+}, {
+    // heater_pid_set_target oid=%c clock=%u target=%i
+    .encoded_msgid=114, // msgid=-14
+    .num_params=3,
+    .param_types = command_parameters63,
+    .num_args=3,
+    .flags=0,
+    .func=command_heater_pid_set_target
+}, {
+    // heater_pid_set_gains oid=%c kp=%i ki=%i kd=%i integ_min=%i integ_max=%i max_value=%hu
+    .encoded_msgid=115, // msgid=-13
+    .num_params=7,
+    .param_types = command_parameters64,
+    .num_args=7,
+    .flags=0,
+    .func=command_heater_pid_set_gains
+}, {
+    // config_heater_pid oid=%c pin=%u cycle_ticks=%u
+    .encoded_msgid=116, // msgid=-12
+    .num_params=3,
+    .param_types = command_parameters29,
+    .num_args=3,
+    .flags=0,
+    .func=command_config_heater_pid
+},
+};
+
+const uint16_t command_index_size PROGMEM = ARRAY_SIZE(command_index);
+
+// version: 8c1fbd1-dirty-20260831_092632-vm
+// build_versions: gcc: (Debian 12.2.0-14+deb12u1) 12.2.0 binutils: (GNU Binutils for Debian) 2.40
+
+const uint8_t command_identify_data[] PROGMEM = {
+    0x78, 0xda, 0x9d, 0x5a, 0x59, 0x8f, 0xdc, 0x46,
+    0x0e, 0xfe, 0x2b, 0x42, 0x03, 0xc6, 0x6e, 0x76,
+    0xdd, 0xde, 0xd6, 0xd1, 0xc7, 0x0c, 0xe0, 0x87,
+    0xc9, 0x78, 0x1c, 0x0f, 0xe2, 0x2b, 0x33, 0xce,
+    0xf1, 0x26, 0xa8, 0xa5, 0xea, 0xee, 0xc2, 0xe8,
+    0x8a, 0x4a, 0x9a, 0x63, 0x03, 0xff, 0xf7, 0x25,
+    0x8b, 0x75, 0x4a, 0x1a, 0x27, 0x9b, 0x00, 0xf1,
+    0x48, 0x55, 0x24, 0xab, 0xc4, 0x62, 0x91, 0x1f,
+    0xc9, 0xfe, 0x63, 0x91, 0xb5, 0xed, 0xe2, 0x7c,
+    0xf1, 0x63, 0xc9, 0xdb, 0x96, 0x75, 0x8b, 0x97,
+    0x8b, 0xfd, 0xc0, 0xcb, 0x22, 0xbd, 0x67, 0x9d,
+    0xe0, 0x4d, 0x2d, 0x60, 0xea, 0x98, 0xe7, 0xe7,
+    0xc1, 0x3f, 0xdf, 0xb0, 0x3d, 0xcf, 0xea, 0x20,
+    0x8c, 0x5e, 0x45, 0xaf, 0x56, 0xcb, 0x30, 0xf9,
+    0x77, 0xc1, 0xf6, 0x61, 0x34, 0x84, 0xdf, 0xa9,
+    0xa1, 0x60, 0xcf, 0xeb, 0xa1, 0xe7, 0xa5, 0x00,
+    0xda, 0x1f, 0x3e, 0xfe, 0x1c, 0x7c, 0xaf, 0x5e,
+    0x83, 0x43, 0xd3, 0x05, 0xc4, 0xfc, 0x5d, 0x10,
+    0xbd, 0x4a, 0x56, 0xb0, 0x44, 0xde, 0x54, 0x55,
+    0x56, 0x17, 0x20, 0xfc, 0x8f, 0x45, 0x56, 0x88,
+    0x30, 0x8a, 0x56, 0x69, 0xd6, 0xf7, 0x59, 0x7e,
+    0x4a, 0xfb, 0x8e, 0x1f, 0x8f, 0xac, 0x4b, 0xb3,
+    0x3a, 0x2b, 0x9b, 0x63, 0xd0, 0xf0, 0xe2, 0xf5,
+    0x8b, 0x3c, 0xf0, 0x47, 0x53, 0x1a, 0x5d, 0x9c,
+    0x9f, 0xc5, 0x2f, 0x17, 0x59, 0x59, 0x36, 0x79,
+    0xd6, 0x33, 0x1c, 0x14, 0x41, 0xde, 0x0c, 0x75,
+    0x2f, 0xe7, 0xc2, 0x15, 0xcc, 0x11, 0x39, 0xaf,
+    0xb5, 0xf4, 0x13, 0x03, 0xca, 0x2e, 0x6d, 0x79,
+    0xa1, 0x25, 0xdb, 0x11, 0x23, 0x35, 0x09, 0x67,
+    0x38, 0xff, 0xaf, 0x7d, 0x25, 0x91, 0x91, 0x20,
+    0xf2, 0x0c, 0x64, 0x14, 0x05, 0xac, 0x50, 0x6b,
+    0xae, 0xb6, 0x11, 0xf2, 0x0f, 0xaf, 0x5f, 0xbf,
+    0x18, 0x82, 0x0a, 0x16, 0xb9, 0xcf, 0xca, 0x81,
+    0xbd, 0x7e, 0x71, 0x82, 0xb7, 0xec, 0xd1, 0xbe,
+    0x2d, 0xce, 0xe3, 0x33, 0x3c, 0x90, 0xbe, 0x87,
+    0x93, 0x48, 0xb3, 0xfc, 0x4e, 0x4b, 0xb0, 0x9f,
+    0xb9, 0xde, 0x3a, 0x04, 0x45, 0x31, 0xbf, 0x44,
+    0x3b, 0x94, 0x65, 0x3a, 0xb4, 0xc4, 0xe0, 0x48,
+    0xfc, 0x7d, 0x60, 0xdd, 0x93, 0x91, 0x09, 0x7a,
+    0xbc, 0x43, 0xea, 0x8e, 0x89, 0x3e, 0xed, 0x79,
+    0x7e, 0x27, 0xe8, 0xad, 0xef, 0xb2, 0x5a, 0x54,
+    0xbc, 0x4f, 0xf5, 0xaa, 0x01, 0xaf, 0xc1, 0x3c,
+    0xd4, 0xfa, 0x3b, 0x38, 0xce, 0x92, 0x65, 0x5d,
+    0x2a, 0x4e, 0x43, 0x5f, 0x34, 0x0f, 0xf5, 0xe2,
+    0x3c, 0xc2, 0x13, 0xae, 0x0f, 0xfc, 0x98, 0xaa,
+    0xc3, 0xd5, 0x4b, 0x88, 0x96, 0x2b, 0x1d, 0x05,
+    0x45, 0xd6, 0x67, 0x69, 0xc7, 0xb2, 0xe2, 0x29,
+    0xa5, 0x4d, 0xc2, 0x69, 0x26, 0x0e, 0xdf, 0x63,
+    0x19, 0x27, 0xeb, 0x29, 0xdf, 0xe2, 0x7c, 0xb7,
+    0xb2, 0x54, 0xfa, 0x90, 0xcc, 0x57, 0x2b, 0x49,
+    0x49, 0x32, 0xa6, 0xc1, 0x63, 0x30, 0x1f, 0x7a,
+    0xca, 0xea, 0x9a, 0x95, 0xa9, 0x55, 0x62, 0x62,
+    0x65, 0xee, 0x2b, 0x1e, 0x6e, 0xcc, 0x86, 0xf7,
+    0x83, 0x48, 0xfd, 0xc7, 0xb4, 0x7f, 0x6a, 0x19,
+    0x6d, 0x64, 0x63, 0x99, 0x48, 0x9f, 0x96, 0x0b,
+    0x5f, 0x1d, 0xf9, 0x1b, 0x2b, 0x5f, 0x0e, 0xb2,
+    0xce, 0xdf, 0xb1, 0x77, 0x40, 0x9b, 0x9d, 0x21,
+    0x2e, 0xf8, 0x91, 0xf7, 0x59, 0x99, 0x36, 0x43,
+    0x3f, 0x62, 0x50, 0x26, 0x02, 0x7a, 0x64, 0x87,
+    0x6c, 0x28, 0xfb, 0xd4, 0x0c, 0xa0, 0x01, 0x15,
+    0x43, 0x97, 0xf5, 0x70, 0x7b, 0xa5, 0x32, 0xa2,
+    0xd0, 0xc8, 0x63, 0x75, 0xde, 0x14, 0xde, 0xe2,
+    0x69, 0xe6, 0x2c, 0x8f, 0x2f, 0x34, 0xba, 0x77,
+    0x47, 0xf7, 0xde, 0x91, 0x07, 0xa2, 0x67, 0xad,
+    0x48, 0xc1, 0x57, 0xa4, 0x05, 0xeb, 0x99, 0x36,
+    0xc3, 0x8d, 0xb3, 0x48, 0x21, 0xfa, 0xa6, 0xf5,
+    0x36, 0x9c, 0x7b, 0x5f, 0x18, 0x5b, 0x03, 0x39,
+    0x15, 0x49, 0xb2, 0xdd, 0x19, 0x7d, 0x77, 0x42,
+    0x59, 0x43, 0xc0, 0xf4, 0x43, 0x91, 0x98, 0xa7,
+    0xb5, 0x79, 0xda, 0x98, 0xa7, 0xad, 0x79, 0x62,
+    0x65, 0xf6, 0x64, 0xcc, 0x76, 0x71, 0xbe, 0xb5,
+    0x36, 0x30, 0xbd, 0xf5, 0x8a, 0x27, 0x7f, 0x02,
+    0xd3, 0x75, 0x78, 0x96, 0xa1, 0xb3, 0xb3, 0xc7,
+    0x6d, 0xf8, 0xa8, 0xe9, 0x8f, 0x19, 0x28, 0x45,
+    0xd9, 0x8d, 0xd4, 0x3a, 0x9c, 0x88, 0x5e, 0x58,
+    0xe4, 0xe5, 0x9d, 0xb5, 0x61, 0x7b, 0xd2, 0x25,
+    0x17, 0x51, 0xf1, 0xf0, 0xe7, 0x96, 0x14, 0x00,
+    0x21, 0xc8, 0xe6, 0xad, 0x63, 0x5a, 0xb1, 0x91,
+    0x52, 0xb3, 0xa6, 0xe5, 0x8f, 0xac, 0x1c, 0xed,
+    0x5c, 0x5e, 0x1f, 0xc1, 0xff, 0x4b, 0x4e, 0x63,
+    0x0f, 0x97, 0x13, 0xcf, 0xdd, 0xb9, 0xb4, 0x82,
+    0xc1, 0x10, 0x6c, 0xda, 0x7e, 0xdc, 0xc6, 0x1e,
+    0x51, 0xfb, 0x50, 0xcd, 0xd8, 0x94, 0xaf, 0x8d,
+    0xc0, 0xfa, 0xa4, 0x91, 0x8d, 0x29, 0x2f, 0xe5,
+    0x19, 0xd9, 0xda, 0x6a, 0x5b, 0xb0, 0x1c, 0x87,
+    0xd3, 0xbc, 0xcb, 0xcd, 0x8d, 0xeb, 0x72, 0x3a,
+    0x13, 0x4b, 0xd4, 0x88, 0xf4, 0xc0, 0x4b, 0xe7,
+    0x26, 0xa0, 0x48, 0xc5, 0x2a, 0xa4, 0x12, 0x96,
+    0x91, 0x23, 0xb3, 0xe5, 0xe3, 0xcd, 0xa2, 0x3f,
+    0xec, 0xf9, 0x3d, 0x4b, 0x4f, 0xfc, 0x78, 0x22,
+    0x1b, 0x5c, 0xb9, 0xf4, 0x70, 0xf3, 0x8f, 0x25,
+    0x9b, 0xf1, 0x3c, 0x66, 0xce, 0xea, 0x7b, 0x19,
+    0x9d, 0x79, 0xac, 0xda, 0x95, 0xcd, 0x71, 0xab,
+    0xa9, 0xb4, 0x12, 0xc7, 0xd7, 0x2f, 0xfe, 0x05,
+    0x21, 0x2c, 0x59, 0x7b, 0xbc, 0x0f, 0xbc, 0x3f,
+    0xa1, 0x75, 0xe4, 0xda, 0x1d, 0x00, 0x85, 0x23,
+    0xbd, 0xdf, 0x9e, 0x59, 0x7f, 0x98, 0x8b, 0x19,
+    0x23, 0x0a, 0x04, 0x2f, 0xcc, 0xe3, 0x53, 0x9d,
+    0xa7, 0xbe, 0x65, 0x07, 0x79, 0x55, 0xa4, 0x13,
+    0x63, 0x0f, 0x9d, 0x15, 0x18, 0x06, 0x72, 0xb3,
+    0x75, 0x78, 0x4d, 0xd5, 0x1d, 0x2c, 0x78, 0xa7,
+    0x1f, 0xe9, 0x3a, 0x4b, 0x62, 0x4b, 0x35, 0x94,
+    0xc2, 0xbd, 0x0d, 0x8e, 0x52, 0xfa, 0x13, 0xeb,
+    0xaa, 0x06, 0x7c, 0x57, 0x3b, 0xab, 0x52, 0x77,
+    0xda, 0x6a, 0x75, 0x6b, 0x8f, 0xbb, 0xaf, 0xf2,
+    0x21, 0xeb, 0x8c, 0xc1, 0x75, 0x8f, 0xe9, 0xc4,
+    0xf1, 0x05, 0xbd, 0x19, 0x44, 0x73, 0xee, 0x79,
+    0xc5, 0xc8, 0x6c, 0xed, 0x5d, 0x98, 0x8f, 0xc1,
+    0xd6, 0x94, 0x4c, 0x8c, 0x58, 0x86, 0xce, 0xd2,
+    0x1d, 0x2a, 0xd1, 0x9c, 0x45, 0x0c, 0x33, 0x80,
+    0x5c, 0x06, 0xb8, 0x59, 0x0d, 0xe0, 0x1e, 0xbc,
+    0xf0, 0xf4, 0x0a, 0x6b, 0x1f, 0xe5, 0xb5, 0xa2,
+    0x53, 0x0d, 0x63, 0x3d, 0x81, 0x41, 0x2a, 0x68,
+    0x3a, 0xf0, 0x9b, 0xb8, 0x1a, 0xc4, 0xd8, 0x4e,
+    0xee, 0x2b, 0x5c, 0x6b, 0x82, 0x87, 0x8e, 0xf7,
+    0x6c, 0x42, 0x81, 0xf7, 0x87, 0x08, 0xc1, 0x8c,
+    0x59, 0xc5, 0xba, 0x23, 0x78, 0xdf, 0xa7, 0x14,
+    0x5d, 0x23, 0xec, 0x02, 0x86, 0xc8, 0x17, 0xff,
+    0xc5, 0x18, 0xdc, 0x36, 0x5d, 0xef, 0x1c, 0xcd,
+    0x7a, 0x8d, 0x02, 0xa4, 0x9f, 0x4d, 0x4f, 0x4d,
+    0xc5, 0x26, 0xfc, 0x22, 0xab, 0x5a, 0xf7, 0x32,
+    0xab, 0x77, 0x13, 0xc1, 0x7d, 0xf9, 0xad, 0x85,
+    0x20, 0x88, 0x69, 0xa4, 0xd5, 0x8d, 0x10, 0x0e,
+    0x68, 0x41, 0xe0, 0x5d, 0x47, 0x15, 0x86, 0x76,
+    0x71, 0xb9, 0x7b, 0xf8, 0xa8, 0xac, 0x67, 0x56,
+    0xc5, 0x70, 0x0f, 0x0f, 0x1c, 0xce, 0x08, 0xdc,
+    0x53, 0x4a, 0xa7, 0x60, 0x3c, 0x00, 0xc4, 0xb6,
+    0x23, 0x78, 0x26, 0xb9, 0x4f, 0xf8, 0x0c, 0xf5,
+    0x26, 0x69, 0xc0, 0x79, 0xba, 0xaf, 0xda, 0x19,
+    0x18, 0xb1, 0x1b, 0x9a, 0x1d, 0x5a, 0x34, 0x0d,
+    0xb8, 0x54, 0x2f, 0x17, 0x2a, 0x78, 0x00, 0x65,
+    0x5d, 0xa4, 0x70, 0x2d, 0x4c, 0x00, 0xc6, 0x67,
+    0x3a, 0xc6, 0x6d, 0x3c, 0x22, 0xc3, 0x13, 0x0e,
+    0x1c, 0x0c, 0xa2, 0xc8, 0xc0, 0x0c, 0x1c, 0x24,
+    0x08, 0xe0, 0x74, 0xc8, 0xca, 0x89, 0x52, 0x1d,
+    0x5c, 0xb6, 0xc4, 0xe3, 0x77, 0x38, 0xe6, 0xf4,
+    0xb0, 0x0c, 0x37, 0x1e, 0x0d, 0xba, 0x64, 0x0c,
+    0x24, 0x66, 0x9b, 0x77, 0x60, 0xf7, 0x3c, 0xb8,
+    0xe3, 0xf2, 0xdf, 0x02, 0xff, 0xe5, 0x80, 0x0d,
+    0x8e, 0xe8, 0xb7, 0x9d, 0x97, 0xec, 0x11, 0x5f,
+    0x46, 0xb8, 0x70, 0x89, 0xf6, 0x39, 0x92, 0xdd,
+    0x67, 0x60, 0x63, 0xfd, 0x64, 0xd7, 0x34, 0x0c,
+    0x32, 0x90, 0x0b, 0xb5, 0x86, 0x81, 0xed, 0x6f,
+    0xc1, 0xda, 0x1d, 0x1c, 0x10, 0x2f, 0x20, 0xe4,
+    0xf3, 0x03, 0x58, 0xec, 0xe1, 0x20, 0x50, 0xec,
+    0xe0, 0x62, 0xee, 0x97, 0x0b, 0x1d, 0xaf, 0xa4,
+    0xb6, 0xed, 0xd9, 0x25, 0xce, 0xcc, 0xd0, 0x16,
+    0x56, 0x4d, 0x84, 0x54, 0x4f, 0x83, 0x73, 0x18,
+    0x1b, 0x50, 0x2d, 0xe9, 0x73, 0x04, 0x1f, 0x3d,
+    0xa3, 0x05, 0x73, 0x89, 0x46, 0x74, 0x52, 0xff,
+    0x83, 0xf5, 0xbb, 0x67, 0xa1, 0x25, 0xf0, 0xf0,
+    0xe4, 0x48, 0xd0, 0xf6, 0x6c, 0x44, 0x37, 0x16,
+    0xb4, 0xdd, 0x19, 0x82, 0x31, 0xe4, 0xfc, 0x9b,
+    0x37, 0x6e, 0xff, 0xd4, 0x33, 0x02, 0x51, 0x74,
+    0xb7, 0x65, 0x04, 0x7c, 0x3e, 0x11, 0x08, 0x00,
+    0x82, 0x1f, 0x41, 0xd8, 0x89, 0xe5, 0x77, 0x2e,
+    0x6e, 0x8d, 0x47, 0xfb, 0xf2, 0x60, 0xee, 0xdf,
+    0xdb, 0xd9, 0xfc, 0x4a, 0xb1, 0xd1, 0x80, 0x0f,
+    0x90, 0x47, 0x9a, 0xdc, 0xad, 0x7d, 0xb2, 0xb1,
+    0x22, 0x77, 0x89, 0x9e, 0x1f, 0xe1, 0x60, 0xb3,
+    0xd9, 0xb6, 0x81, 0x80, 0x30, 0xde, 0xaa, 0x03,
+    0x62, 0xb6, 0x5a, 0x80, 0x87, 0xcf, 0xc6, 0xdb,
+    0xd8, 0x79, 0x54, 0x93, 0x5d, 0x18, 0x21, 0x3e,
+    0x46, 0x1b, 0x4b, 0x89, 0x7c, 0xb2, 0x89, 0x18,
+    0x63, 0x5e, 0x13, 0xb8, 0xf1, 0x8c, 0x1f, 0x47,
+    0xcf, 0x05, 0xe0, 0x82, 0x1f, 0x48, 0xa9, 0xcb,
+    0xd8, 0xac, 0x30, 0x17, 0x60, 0x9f, 0x11, 0xe2,
+    0x98, 0x89, 0x67, 0x25, 0xf4, 0x02, 0x81, 0x1d,
+    0x1c, 0x6f, 0xe1, 0x1c, 0xdd, 0x76, 0x23, 0x17,
+    0x19, 0xd8, 0x5c, 0x3a, 0x61, 0xd6, 0x68, 0x5c,
+    0xa8, 0x18, 0x9e, 0xcd, 0xb0, 0xa4, 0xfb, 0xac,
+    0xcf, 0x4f, 0x6e, 0x88, 0xdc, 0x69, 0xaa, 0x11,
+    0x9e, 0x9c, 0x73, 0x98, 0xeb, 0x78, 0x44, 0x3c,
+    0x11, 0xb7, 0x8e, 0x34, 0x05, 0xa2, 0x11, 0x2d,
+    0x0b, 0x9d, 0x60, 0x47, 0xa1, 0x54, 0x3b, 0x1a,
+    0xb8, 0x0e, 0x10, 0x63, 0xe1, 0x2f, 0x78, 0xb4,
+    0x68, 0xe7, 0x32, 0xa5, 0xad, 0x93, 0x23, 0x5b,
+    0xc9, 0xd1, 0xc6, 0x23, 0x82, 0x1b, 0x07, 0x8e,
+    0xf3, 0x2f, 0x2d, 0x10, 0x10, 0x2d, 0x7d, 0x42,
+    0x04, 0x66, 0x43, 0xc0, 0x5a, 0x8a, 0x91, 0x5f,
+    0x39, 0xfe, 0x64, 0xa0, 0x02, 0x13, 0x47, 0x1a,
+    0x57, 0xd9, 0xa3, 0xa4, 0x0d, 0x54, 0xb7, 0x99,
+    0x10, 0x49, 0xbd, 0x48, 0x08, 0x6e, 0x64, 0x8e,
+    0xb2, 0x93, 0x68, 0x45, 0x4c, 0x35, 0x7b, 0x54,
+    0x5b, 0x00, 0x40, 0x67, 0xbe, 0x96, 0x77, 0x52,
+    0x72, 0xb4, 0x26, 0x22, 0x7d, 0x24, 0x7f, 0x82,
+    0xed, 0x41, 0xed, 0x60, 0xc5, 0x0e, 0x84, 0x42,
+    0x5e, 0x02, 0xd6, 0x5a, 0x72, 0xed, 0xc2, 0x72,
+    0x50, 0x11, 0x3b, 0x1c, 0xd2, 0x43, 0x97, 0xe5,
+    0x29, 0xc0, 0x34, 0x8d, 0xd4, 0x77, 0x13, 0x19,
+    0x14, 0x1e, 0xd0, 0x21, 0xd9, 0x0f, 0xd2, 0x21,
+    0x83, 0x07, 0x72, 0xd8, 0x3c, 0x78, 0xe2, 0x82,
+    0x6c, 0xe8, 0x9b, 0x54, 0x93, 0x4a, 0xe9, 0xdb,
+    0x89, 0x74, 0x1f, 0x1b, 0x04, 0x3a, 0xe5, 0xe0,
+    0xc5, 0xa3, 0x42, 0x84, 0x2b, 0x29, 0xbc, 0x11,
+    0xa1, 0xfa, 0x1b, 0xa9, 0xbf, 0xb1, 0xfa, 0x9b,
+    0x50, 0x3c, 0x94, 0xda, 0x1a, 0x89, 0x76, 0x62,
+    0xf8, 0x44, 0x30, 0xce, 0x91, 0x68, 0x7c, 0x0a,
+    0x95, 0x10, 0x3c, 0x4c, 0x93, 0x54, 0xa0, 0x8c,
+    0xfd, 0xd0, 0x89, 0x7e, 0x5a, 0xab, 0x59, 0x22,
+    0x32, 0xf2, 0x28, 0x21, 0xbb, 0xce, 0x9b, 0xaa,
+    0xcd, 0x3a, 0xe6, 0xe2, 0xf5, 0xd6, 0x40, 0x59,
+    0xab, 0xa8, 0xfe, 0x04, 0xa6, 0x77, 0x6a, 0xca,
+    0x82, 0x12, 0x55, 0xc4, 0x60, 0x4e, 0x22, 0x83,
+    0x15, 0x9a, 0x83, 0xf5, 0xa6, 0xd6, 0xf4, 0xcf,
+    0xd6, 0x44, 0xe7, 0x44, 0x63, 0x67, 0x36, 0xd9,
+    0xe8, 0x59, 0xdc, 0xb3, 0x70, 0x91, 0x3d, 0xbc,
+    0x4a, 0x97, 0x02, 0x18, 0x95, 0xa2, 0x42, 0x4f,
+    0x70, 0x3c, 0xd9, 0x59, 0x16, 0xf1, 0xe0, 0x72,
+    0x55, 0x5c, 0x34, 0x1a, 0xc1, 0x57, 0x8d, 0xe0,
+    0x73, 0xa9, 0x8d, 0x16, 0x37, 0x4e, 0x35, 0xb6,
+    0x6a, 0x9b, 0xcf, 0x7f, 0x48, 0x82, 0x46, 0x20,
+    0x93, 0xa7, 0x6f, 0xc2, 0xbd, 0x95, 0x4f, 0x35,
+    0x8f, 0xf6, 0x36, 0x67, 0x48, 0x95, 0xa9, 0xfc,
+    0x27, 0xdd, 0x03, 0x14, 0x3f, 0x55, 0x59, 0x27,
+    0x2f, 0xb3, 0x5b, 0xe4, 0x9a, 0x73, 0x0c, 0xf9,
+    0x69, 0xa8, 0xb5, 0x97, 0xc4, 0x33, 0x50, 0xc7,
+    0x85, 0xc8, 0x14, 0x90, 0x0c, 0xf7, 0x10, 0x6b,
+    0x14, 0x5b, 0x02, 0x89, 0x96, 0xd1, 0xc9, 0x12,
+    0xb4, 0xb2, 0x48, 0xcb, 0x01, 0xdb, 0xc0, 0x01,
+    0x3e, 0x50, 0xe5, 0x4a, 0xe4, 0x1f, 0xbd, 0x83,
+    0x33, 0x5b, 0x93, 0x19, 0x07, 0x7e, 0x4b, 0x80,
+    0xc9, 0x09, 0x21, 0xac, 0xd0, 0x72, 0xba, 0x3c,
+    0x73, 0xa4, 0xb8, 0x88, 0x8f, 0xf0, 0xdc, 0x1c,
+    0xe2, 0x4f, 0xf0, 0x7f, 0xc0, 0xba, 0xae, 0x71,
+    0xdf, 0x8d, 0xb7, 0xaf, 0x9a, 0x9a, 0xf7, 0x30,
+    0x65, 0x23, 0x95, 0x1a, 0x90, 0x10, 0x16, 0xad,
+    0x36, 0x9a, 0xae, 0x3c, 0x0b, 0x9c, 0x51, 0x71,
+    0x23, 0x3a, 0xe9, 0x2d, 0x3b, 0x88, 0x9c, 0xe6,
+    0x38, 0x3b, 0x19, 0x46, 0xe5, 0x05, 0x5c, 0xcd,
+    0x92, 0x97, 0xbc, 0x66, 0x59, 0x07, 0x49, 0x88,
+    0x75, 0xf5, 0x05, 0x7b, 0xf4, 0x14, 0xd9, 0x65,
+    0x32, 0xaa, 0x77, 0xd2, 0x29, 0x21, 0x36, 0xc7,
+    0xbf, 0xc6, 0x4d, 0x21, 0x60, 0x3e, 0x9b, 0x15,
+    0x8d, 0x7c, 0x12, 0x28, 0x19, 0xe8, 0x00, 0x03,
+    0x0a, 0xb6, 0xcb, 0x47, 0x09, 0xda, 0x91, 0x7f,
+    0x37, 0xcb, 0x3f, 0xb1, 0x02, 0x8f, 0x42, 0x17,
+    0x86, 0xf4, 0xb0, 0xf2, 0xd6, 0xdc, 0xd2, 0x75,
+    0x95, 0x19, 0xc4, 0xef, 0xc7, 0xb3, 0xa7, 0x53,
+    0x93, 0xc2, 0x01, 0x65, 0xcc, 0x44, 0x63, 0x00,
+    0x71, 0x6b, 0x9f, 0x4e, 0x49, 0x7b, 0x00, 0xbd,
+    0x34, 0x0f, 0x33, 0xa8, 0x63, 0x94, 0x74, 0xc6,
+    0x89, 0x65, 0xef, 0xdd, 0x6c, 0x9e, 0x08, 0x9f,
+    0x63, 0x0c, 0xd8, 0x63, 0xcb, 0x3b, 0xe6, 0x65,
+    0x90, 0x1b, 0x23, 0x69, 0xa4, 0x09, 0x97, 0x08,
+    0x8c, 0x80, 0x52, 0x85, 0x39, 0xe0, 0xe2, 0xc4,
+    0xd2, 0xed, 0x57, 0x9d, 0xec, 0x63, 0x3f, 0xe1,
+    0xf2, 0xfd, 0xa7, 0xcb, 0x1f, 0xd3, 0xb7, 0x37,
+    0x57, 0x3f, 0x61, 0xc4, 0xa4, 0xff, 0x5e, 0x2e,
+    0x6e, 0xae, 0x2e, 0xaf, 0xae, 0x7f, 0xb9, 0x4a,
+    0x7f, 0xbd, 0xfe, 0xf8, 0xe6, 0xd3, 0xaf, 0x88,
+    0x70, 0xc0, 0x14, 0x6f, 0xaf, 0x6e, 0xae, 0x2f,
+    0xde, 0xa7, 0xdf, 0x5f, 0xfc, 0xfc, 0x06, 0x03,
+    0x27, 0x51, 0xde, 0x7e, 0xb9, 0xf8, 0x72, 0x9b,
+    0xde, 0xfe, 0xfc, 0xe1, 0xf6, 0x27, 0x98, 0xb9,
+    0xbd, 0xc2, 0x99, 0x0d, 0x0e, 0x5f, 0x7d, 0xfe,
+    0x7c, 0x75, 0x93, 0xe2, 0xdf, 0xf4, 0xfb, 0x4f,
+    0x5f, 0xde, 0xa5, 0x57, 0x6f, 0x7e, 0x80, 0xc9,
+    0xf0, 0x2b, 0x26, 0xc3, 0x03, 0xe4, 0xf7, 0xb2,
+    0x18, 0x26, 0x5b, 0x1a, 0x6e, 0x81, 0x0f, 0xdf,
+    0x79, 0x44, 0xb9, 0x11, 0x78, 0xb8, 0xc5, 0xf9,
+    0x0a, 0x18, 0xbc, 0x8a, 0x1f, 0x52, 0xbc, 0xbf,
+    0xbe, 0x8d, 0xde, 0xc0, 0xb6, 0x60, 0x7d, 0x78,
+    0x8c, 0xdf, 0xbc, 0x23, 0xc1, 0x02, 0x60, 0x38,
+    0x88, 0xc9, 0xc4, 0x9d, 0xdb, 0x29, 0xc9, 0xb3,
+    0xb6, 0x1f, 0x40, 0xa1, 0x34, 0x8e, 0x29, 0x9d,
+    0x4e, 0x5b, 0xd4, 0x88, 0xd7, 0xf9, 0xa0, 0xb1,
+    0xc4, 0x6f, 0x48, 0xd0, 0x20, 0x28, 0x58, 0xc1,
+    0x74, 0xc5, 0x18, 0xd9, 0xd6, 0x00, 0x8d, 0x50,
+    0xc9, 0x50, 0x34, 0xa5, 0x59, 0x4d, 0x16, 0x56,
+    0x24, 0x74, 0x57, 0x23, 0x3b, 0x5b, 0xca, 0xa0,
+    0x81, 0xb5, 0x4e, 0x31, 0x47, 0xfb, 0x8c, 0xe5,
+    0x77, 0x23, 0x8e, 0x56, 0x03, 0x7e, 0x08, 0xa3,
+    0xb1, 0x35, 0x79, 0x4c, 0xeb, 0x93, 0xd5, 0xc4,
+    0x6a, 0xe4, 0x49, 0x15, 0x39, 0x98, 0x91, 0x57,
+    0x7a, 0x92, 0xa3, 0x78, 0x65, 0xe1, 0x0a, 0xe8,
+    0xfd, 0x20, 0xd6, 0xd2, 0x9e, 0x91, 0x46, 0xb6,
+    0xd6, 0xfa, 0xe4, 0x7b, 0xf4, 0xd5, 0xdb, 0x89,
+    0x3a, 0x93, 0x2c, 0x8c, 0xe3, 0x58, 0xae, 0x9c,
+    0x89, 0xf5, 0x2a, 0xd9, 0x16, 0x72, 0xbd, 0xaa,
+    0xdf, 0xec, 0xc2, 0x8d, 0xd4, 0x1d, 0x3e, 0x46,
+    0x1b, 0x21, 0x95, 0xdb, 0x97, 0x6c, 0xbd, 0x0a,
+    0xa3, 0xbd, 0x12, 0x06, 0xee, 0x8c, 0xe3, 0x2d,
+    0xe9, 0x78, 0x0d, 0x87, 0x50, 0xa0, 0xb8, 0x8b,
+    0x37, 0x97, 0x81, 0xb4, 0xdf, 0x03, 0xa5, 0x58,
+    0x54, 0x06, 0xbf, 0x28, 0x65, 0x0f, 0x24, 0xd0,
+    0xf5, 0x92, 0x82, 0x14, 0x75, 0x09, 0x69, 0x5c,
+    0xdd, 0xf4, 0x80, 0x3f, 0xe0, 0xff, 0x06, 0x9c,
+    0x1e, 0xc0, 0x39, 0xc2, 0x70, 0x81, 0xbc, 0x56,
+    0xc1, 0xc3, 0x89, 0xc3, 0x33, 0x5d, 0x0f, 0x11,
+    0xb4, 0xe0, 0xf0, 0x61, 0x25, 0x02, 0x9f, 0xc0,
+    0xfb, 0x8f, 0x1e, 0x01, 0x6c, 0x20, 0xf8, 0x11,
+    0xa4, 0x02, 0x74, 0x00, 0xb4, 0xcb, 0x45, 0x90,
+    0xa9, 0xb5, 0x08, 0xde, 0x51, 0x7d, 0x4f, 0x11,
+    0x0b, 0x24, 0xc5, 0xab, 0x45, 0xd6, 0x43, 0xa3,
+    0x12, 0xeb, 0xca, 0x9c, 0x05, 0x96, 0x63, 0xb5,
+    0x86, 0x26, 0x96, 0x1f, 0x14, 0x7b, 0x49, 0x9d,
+    0xbc, 0x00, 0x20, 0x8c, 0x80, 0x29, 0x19, 0x1b,
+    0xa4, 0x82, 0xf5, 0x44, 0xc7, 0xc0, 0xc3, 0x8b,
+    0x5e, 0xda, 0xc9, 0x5b, 0x2a, 0xf8, 0x6a, 0xf0,
+    0x26, 0xdd, 0x71, 0x50, 0x62, 0x79, 0xa2, 0xc3,
+    0x4d, 0xd6, 0x5e, 0x0d, 0x98, 0x8a, 0x5c, 0xef,
+    0x7e, 0xc3, 0x2c, 0x0f, 0x3d, 0xf3, 0x7f, 0x54,
+    0xf9, 0xdd, 0x53, 0x62, 0x10, 0x2e, 0x13, 0xca,
+    0x1c, 0xae, 0x29, 0xef, 0x09, 0x6c, 0x82, 0x3e,
+    0x4e, 0xb1, 0xc9, 0xa3, 0x8c, 0xe8, 0x64, 0xc2,
+    0xac, 0x25, 0x4b, 0xc3, 0xa6, 0xfa, 0x96, 0x26,
+    0xd3, 0x9d, 0x1d, 0xdb, 0x05, 0x33, 0x54, 0x67,
+    0x96, 0x4a, 0xf5, 0x33, 0xa5, 0xed, 0xdb, 0x31,
+    0x20, 0x43, 0xbd, 0x64, 0x15, 0x83, 0xaf, 0xa6,
+    0x74, 0x49, 0x4f, 0xea, 0x46, 0xcc, 0xb8, 0x97,
+    0x42, 0x89, 0xb6, 0xa6, 0xaa, 0x1a, 0x40, 0xe1,
+    0x4a, 0x81, 0x01, 0x16, 0xfb, 0xe9, 0xb6, 0xeb,
+    0x69, 0xd3, 0x1a, 0x30, 0xcd, 0x00, 0x2a, 0x46,
+    0x4f, 0xe6, 0x55, 0xc1, 0xc5, 0xec, 0x32, 0x71,
+    0x84, 0xc0, 0x99, 0x07, 0x64, 0xf1, 0xa1, 0xa3,
+    0xc5, 0xe7, 0x92, 0xbf, 0x92, 0xd5, 0xc7, 0xfe,
+    0x44, 0x38, 0xc5, 0xa7, 0xf5, 0xb3, 0x3a, 0x4d,
+    0x17, 0xaf, 0xc7, 0x74, 0x36, 0x4d, 0x33, 0xdb,
+    0x41, 0x7c, 0xaf, 0x89, 0xb0, 0xd0, 0xaf, 0x7d,
+    0x79, 0x9c, 0x78, 0xe3, 0x2a, 0xc3, 0x46, 0xbf,
+    0xa9, 0x76, 0xbc, 0x76, 0x09, 0x30, 0x67, 0xb4,
+    0x48, 0x4e, 0xdb, 0xaa, 0x3a, 0xac, 0xd0, 0x39,
+    0x2c, 0x2f, 0xd5, 0x76, 0xa4, 0x21, 0xc2, 0x7c,
+    0x6f, 0x20, 0x83, 0x60, 0xc7, 0x0a, 0x0e, 0x64,
+    0xde, 0x48, 0xf5, 0xac, 0xa0, 0xc6, 0xd7, 0x07,
+    0x18, 0x01, 0x8b, 0xdc, 0x69, 0x6b, 0xa1, 0x16,
+    0xf2, 0x07, 0x26, 0x44, 0x06, 0x26, 0x4a, 0x67,
+    0xad, 0xaf, 0x06, 0x92, 0x73, 0x21, 0x18, 0xec,
+    0x18, 0x9d, 0xfb, 0x50, 0x62, 0xd9, 0x19, 0x98,
+    0x31, 0xa9, 0x0b, 0x94, 0xc2, 0xa5, 0x89, 0xb3,
+    0x7b, 0x69, 0x0f, 0x98, 0xa1, 0x3c, 0xcf, 0x70,
+    0xca, 0xba, 0x42, 0xfa, 0x06, 0x45, 0x8d, 0xd5,
+    0xed, 0x0f, 0x68, 0x35, 0x52, 0xd9, 0x01, 0x3c,
+    0x75, 0x87, 0xb2, 0x79, 0x20, 0xc7, 0x7a, 0xc3,
+    0x94, 0x04, 0x90, 0x25, 0x1d, 0x24, 0x7c, 0x1c,
+    0x6a, 0x03, 0x8c, 0x14, 0x2f, 0x28, 0x76, 0x72,
+    0x6f, 0x0d, 0xc1, 0x64, 0x2b, 0xc1, 0x03, 0x2f,
+    0x4b, 0x88, 0xe5, 0x39, 0x83, 0x59, 0xb7, 0xff,
+    0x43, 0x38, 0xd7, 0x72, 0x9a, 0xed, 0x7c, 0x83,
+    0x03, 0x01, 0xc0, 0x2d, 0x38, 0x17, 0xf7, 0x16,
+    0xe2, 0x2e, 0x90, 0x8c, 0x57, 0x43, 0x35, 0xb9,
+    0x92, 0x2b, 0xa2, 0x27, 0x05, 0xfb, 0xa4, 0x6a,
+    0x4c, 0x51, 0x62, 0x2b, 0xf7, 0x56, 0xb7, 0x6f,
+    0x64, 0x63, 0x1a, 0x16, 0x97, 0xee, 0x4b, 0xfa,
+    0x53, 0xb7, 0x47, 0x7d, 0xeb, 0x9b, 0x8c, 0x76,
+    0x8f, 0xdd, 0x50, 0xd7, 0xe4, 0x4c, 0x57, 0x44,
+    0x83, 0x76, 0xd4, 0x37, 0x4d, 0x70, 0xc8, 0xa4,
+    0xc6, 0x48, 0x5b, 0x98, 0xf2, 0x7e, 0x71, 0x2d,
+    0x09, 0x99, 0x81, 0x50, 0x76, 0xca, 0x28, 0xb3,
+    0xfa, 0x22, 0x75, 0x8c, 0x9c, 0x00, 0x8d, 0x04,
+    0x93, 0x31, 0x43, 0xfe, 0x5a, 0x21, 0x95, 0x49,
+    0x04, 0x90, 0x82, 0x0f, 0x2f, 0x28, 0xa6, 0x3a,
+    0xe3, 0xc2, 0x4e, 0x6c, 0x30, 0x6a, 0xa3, 0xd1,
+    0x03, 0xa2, 0x17, 0x4d, 0x27, 0x7d, 0x01, 0x40,
+    0x29, 0x11, 0xe4, 0x02, 0x13, 0x7b, 0xaa, 0xaa,
+    0x20, 0xda, 0x40, 0x0b, 0x0e, 0x00, 0x66, 0x04,
+    0x43, 0x2d, 0x86, 0x16, 0xbd, 0x1d, 0xf2, 0x63,
+    0x43, 0xcc, 0xce, 0x92, 0xf9, 0x53, 0x37, 0xca,
+    0x8c, 0xe2, 0x7d, 0xf3, 0x79, 0x6c, 0x27, 0x89,
+    0xfc, 0x7f, 0x53, 0x97, 0x10, 0x32, 0xee, 0x61,
+    0x4b, 0xd9, 0xbe, 0xd4, 0x91, 0xc0, 0xa8, 0xf1,
+    0xcc, 0xad, 0x42, 0x6b, 0x47, 0xa3, 0x00, 0x28,
+    0xfd, 0x38, 0x01, 0x53, 0xbe, 0x32, 0x18, 0x6d,
+    0x01, 0x94, 0x27, 0x7f, 0xae, 0x61, 0x42, 0x92,
+    0xfa, 0x11, 0x47, 0xa1, 0x60, 0x01, 0xd6, 0x98,
+    0xf1, 0xf8, 0xc9, 0x4c, 0x21, 0x07, 0x96, 0xfa,
+    0x48, 0x4c, 0x20, 0x0f, 0x6c, 0xf1, 0x48, 0x2a,
+    0x58, 0xde, 0x4f, 0xfa, 0xdd, 0x85, 0xa6, 0x98,
+    0xcc, 0xcd, 0xc3, 0x49, 0xb4, 0x0a, 0xf2, 0x0b,
+    0xd8, 0xb8, 0x53, 0xb1, 0x8d, 0xae, 0x0f, 0xb6,
+    0xce, 0xbf, 0x8e, 0x11, 0x86, 0x02, 0x07, 0x1f,
+    0x2e, 0x7e, 0x8b, 0xc3, 0xdd, 0x7a, 0x2d, 0xf1,
+    0x81, 0x7a, 0xd9, 0x48, 0x80, 0x40, 0x2f, 0x9b,
+    0xb5, 0x34, 0x31, 0x78, 0xd9, 0x6c, 0xb6, 0xf0,
+    0x1c, 0x7f, 0x9d, 0xe4, 0x01, 0xd2, 0x21, 0x9c,
+    0x4b, 0x61, 0x9f, 0x3e, 0x5e, 0x7f, 0xf9, 0x74,
+    0x23, 0x39, 0x3e, 0xfd, 0x72, 0x75, 0xf3, 0xf6,
+    0xbd, 0x84, 0xa8, 0x70, 0x63, 0x2f, 0x7e, 0x4d,
+    0x6f, 0x2e, 0x3e, 0x22, 0xce, 0x44, 0x5b, 0xbc,
+    0xfa, 0x78, 0xfb, 0x09, 0x10, 0xe8, 0xe7, 0xab,
+    0xcb, 0xeb, 0xb7, 0xd7, 0x97, 0xb3, 0x42, 0x0d,
+    0x78, 0xd9, 0x8b, 0x14, 0xbf, 0x1a, 0xd8, 0x0a,
+    0x7e, 0x38, 0x40, 0x88, 0xc9, 0xee, 0xd2, 0x63,
+    0x2f, 0x97, 0xc0, 0x3f, 0x20, 0xfc, 0xf4, 0x24,
+    0xfa, 0x54, 0xd3, 0x21, 0x38, 0x43, 0x25, 0x7d,
+    0x95, 0xe8, 0x34, 0x07, 0x73, 0x83, 0xb7, 0x05,
+    0xfe, 0x8e, 0xe7, 0x87, 0xcf, 0xef, 0xef, 0xe3,
+    0x85, 0xac, 0x7c, 0xb5, 0xe0, 0xdb, 0x18, 0xfd,
+    0x68, 0xc7, 0xc0, 0x4b, 0xaf, 0x5c, 0x22, 0x2b,
+    0x53, 0x7e, 0xf5, 0x4f, 0xe8, 0x76, 0xda, 0xe8,
+    0x27, 0x31, 0x7f, 0x99, 0x2f, 0xb4, 0x98, 0xd4,
+    0xe3, 0xc9, 0x9c, 0xfa, 0x34, 0x95, 0x63, 0x34,
+    0x07, 0xf6, 0x63, 0x65, 0x6d, 0xce, 0x66, 0x3e,
+    0x4b, 0xd3, 0xfb, 0x0e, 0x10, 0x7a, 0xcb, 0x27,
+    0xdb, 0x98, 0xc6, 0x31, 0x6d, 0xd2, 0xb2, 0x92,
+    0x01, 0x7e, 0x33, 0x35, 0x29, 0x3f, 0x70, 0x4f,
+    0x9a, 0xdb, 0xe3, 0xc6, 0xf6, 0x72, 0x6d, 0x61,
+    0xf1, 0x37, 0xbe, 0x4c, 0xc9, 0x54, 0x0f, 0xa9,
+    0xdd, 0x5f, 0x88, 0x68, 0x42, 0xb7, 0x1b, 0x05,
+    0x78, 0x10, 0xd3, 0x3d, 0x5c, 0x86, 0x16, 0x5f,
+    0x7b, 0x92, 0xf5, 0xfe, 0x38, 0x72, 0x27, 0xb6,
+    0x23, 0xe7, 0x11, 0x41, 0x5e, 0x0f, 0xae, 0x6c,
+    0xba, 0x91, 0x51, 0xc3, 0x8f, 0x4c, 0xc8, 0xd9,
+    0x4e, 0xe4, 0xdd, 0x6b, 0x0c, 0xee, 0xa6, 0x5d,
+    0xf3, 0x50, 0x91, 0x52, 0xc2, 0x64, 0xd4, 0xdd,
+    0xf2, 0x0f, 0x07, 0xaf, 0x91, 0x43, 0x4f, 0xcd,
+    0x2c, 0x99, 0xae, 0x86, 0x18, 0x68, 0x75, 0x1b,
+    0x29, 0xd5, 0x66, 0xe5, 0xf4, 0x93, 0xa8, 0x50,
+    0xf3, 0x0a, 0x0f, 0x13, 0xcc, 0xd7, 0x39, 0x9b,
+    0x60, 0x8c, 0xab, 0x75, 0x2f, 0x6c, 0xe5, 0x74,
+    0x97, 0x94, 0xfe, 0x74, 0x29, 0x6b, 0xc8, 0x73,
+    0x88, 0xc3, 0x94, 0x28, 0x22, 0xb6, 0x82, 0xc5,
+    0xdc, 0x36, 0xef, 0x32, 0x92, 0xde, 0x06, 0x9c,
+    0x6b, 0xba, 0x1f, 0xca, 0x3b, 0xaf, 0x60, 0x24,
+    0x10, 0x79, 0xd5, 0x39, 0x1b, 0xb5, 0xa7, 0xc2,
+    0x24, 0xf1, 0x79, 0xbc, 0xb6, 0x80, 0xcd, 0x9f,
+    0x55, 0x61, 0x5f, 0x67, 0xc1, 0x54, 0xb5, 0x75,
+    0x45, 0xee, 0x87, 0xc3, 0x81, 0x41, 0x78, 0xa2,
+    0xb6, 0x07, 0x40, 0x70, 0xf0, 0xaf, 0xa9, 0x0e,
+    0xd9, 0x42, 0x6b, 0x19, 0x6b, 0x48, 0x36, 0x9e,
+    0xe9, 0x96, 0xce, 0xbc, 0x22, 0xce, 0xdc, 0x3c,
+    0xa6, 0x80, 0x13, 0x90, 0x4d, 0xe7, 0x69, 0x43,
+    0x01, 0x32, 0x72, 0xb0, 0x63, 0x56, 0x50, 0xa3,
+    0x09, 0x52, 0xee, 0xa1, 0x63, 0x85, 0x5e, 0x30,
+    0x9a, 0xab, 0x2c, 0x3a, 0xe7, 0x34, 0x6d, 0x4e,
+    0xc8, 0x09, 0xad, 0x9c, 0xd0, 0xaf, 0xe4, 0x4d,
+    0x18, 0x47, 0xf4, 0x71, 0xac, 0x6a, 0x71, 0x32,
+    0xe4, 0x2e, 0xa9, 0xa6, 0x96, 0xf5, 0xc2, 0xde,
+    0x15, 0x31, 0x54, 0xea, 0x8f, 0xf8, 0x9d, 0xaa,
+    0x4a, 0x70, 0x3b, 0x65, 0x81, 0x45, 0x7e, 0xf3,
+    0x6e, 0x92, 0x31, 0x2a, 0x0b, 0x90, 0xd8, 0x5a,
+    0x37, 0x4c, 0x60, 0xe2, 0x48, 0xe5, 0x99, 0xec,
+    0xfe, 0xe8, 0xbc, 0x51, 0x83, 0x49, 0x29, 0x7b,
+    0xe9, 0xd4, 0xeb, 0x46, 0xc5, 0x3c, 0x6a, 0x53,
+    0xa2, 0xf5, 0x62, 0xe0, 0xf7, 0x42, 0x02, 0xd5,
+    0xe9, 0x68, 0x51, 0x31, 0xba, 0x67, 0xae, 0xd5,
+    0xac, 0xc6, 0xa5, 0xbd, 0xa9, 0x66, 0xb0, 0x40,
+    0x47, 0x5a, 0xd9, 0x5a, 0xe2, 0x6f, 0x91, 0x6d,
+    0xa6, 0xd5, 0xa5, 0xf9, 0xeb, 0x4f, 0x4f, 0xee,
+    0x15, 0x4f, 0xd6, 0x6e, 0x35, 0xc7, 0xf1, 0x2b,
+    0x99, 0x29, 0x52, 0xce, 0xd7, 0xff, 0x5c, 0xaf,
+    0xb5, 0xc2, 0x98, 0x2a, 0x33, 0x44, 0xfa, 0x15,
+    0xce, 0xe0, 0xfa, 0x5c, 0xac, 0xcb, 0xa8, 0x9f,
+    0x91, 0x42, 0x2c, 0xd9, 0xe5, 0xe1, 0x61, 0x5f,
+    0x84, 0xcb, 0x82, 0x77, 0xfd, 0xd3, 0x32, 0x5a,
+    0x45, 0x9b, 0xd5, 0x2e, 0x0e, 0xd3, 0xd5, 0x59,
+    0xb4, 0x89, 0xa3, 0xe5, 0x7d, 0xb5, 0xf8, 0xfa,
+    0x3f, 0x80, 0xb2, 0x91, 0xc8,
+};
+
+// Identify size = 3589 (10891 uncompressed)
+const uint32_t command_identify_size PROGMEM
+    = ARRAY_SIZE(command_identify_data);
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# Build a precompiled klippy deployment bundle for fast cold starts
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+
+# The bundle is a copy of the klippy/ directory with everything a cold
+# start would otherwise generate on first use already in place:
+#   - bytecode precompiled for every module (with "unchecked hash"
+#     invalidation, so the interpreter loads .pyc files without
+#     re-reading or re-hashing the sources)
+#   - a generated extras_registry.py so module lookups during config
+#     parsing do not stat the extras/ directory per config section
+#   - the chelper c_helper.so prebuilt (no compiler needed at runtime)
+#   - a .version stamp so version reporting works without git
+# Run the result as usual: python3 <bundle>/klippy/klippy.py printer.cfg
+
+import compileall, optparse, os, py_compile, shutil, subprocess, sys
+
+def get_version(srcdir, distroname):
+    sys.path.insert(0, os.path.join(srcdir, 'klippy'))
+    import util
+    version = util.get_git_version(from_file=True)["version"]
+    if distroname:
+        version = "%s-%s" % (version, distroname.replace(' ', ''))
+    return version
+
+def list_extras_modules(extras_dir):
+    modules = []
+    for fname in sorted(os.listdir(extras_dir)):
+        if fname.endswith('.py') and fname != '__init__.py':
+            modules.append(fname[:-3])
+        elif os.path.exists(os.path.join(extras_dir, fname, '__init__.py')):
+            modules.append(fname)
+    return modules
+
+def main():
+    usage = "%prog [options] <output_dir>"
+    opts = optparse.OptionParser(usage)
+    opts.add_option("-s", "--srcdir",
+                    default=os.path.join(os.path.dirname(__file__), '..'),
+                    help="path to the klipper source checkout")
+    opts.add_option("-d", "--distroname", default=None,
+                    help="distribution name to append to the version stamp")
+    options, args = opts.parse_args()
+    if len(args) != 1:
+        opts.error("Incorrect number of arguments")
+    srcdir = os.path.realpath(options.srcdir)
+    outdir = os.path.realpath(args[0])
+    klippy_out = os.path.join(outdir, 'klippy')
+    if os.path.exists(klippy_out):
+        shutil.rmtree(klippy_out)
+    # Copy the klippy tree (sans caches and build output)
+    ignore = shutil.ignore_patterns('__pycache__', '*.pyc', '*.so', '_temp_*')
+    shutil.copytree(os.path.join(srcdir, 'klippy'), klippy_out, ignore=ignore)
+    # Version stamp (resolved before the .git directory is left behind)
+    version = get_version(srcdir, options.distroname)
+    with open(os.path.join(klippy_out, '.version'), 'w') as f:
+        f.write(version)
+    # Generate the extras module registry
+    modules = list_extras_modules(os.path.join(klippy_out, 'extras'))
+    with open(os.path.join(klippy_out, 'extras_registry.py'), 'w') as f:
+        f.write("# Extras module registry (generated by build_bundle.py)\n"
+                "EXTRAS_MODULES = [\n")
+        for module_name in modules:
+            f.write("    '%s',\n" % (module_name,))
+        f.write("]\n")
+    # Precompile bytecode for all modules
+    res = compileall.compile_dir(
+        klippy_out, quiet=1,
+        invalidation_mode=py_compile.PycInvalidationMode.UNCHECKED_HASH)
+    if not res:
+        sys.stderr.write("Bytecode compilation failed\n")
+        sys.exit(1)
+    # Prebuild the chelper C library in the bundle
+    sys.path.insert(0, klippy_out)
+    import chelper
+    chelper.check_build_c_library()
+    print("Built klippy bundle %s (version %s, %d extras modules)"
+          % (klippy_out, version, len(modules)))
+
+if __name__ == '__main__':
+    main()
@@ -12,11 +12,13 @@ import msgproto
 FILEHEADER = """
 /* DO NOT EDIT! This is an autogenerated file. See scripts/buildcommands.py. */
 
+#include <string.h>
 #include "board/irq.h"
 #include "board/pgm.h"
 #include "command.h"
 #include "compiler.h"
 #include "initial_pins.h"
+#include "sched.h"
 """
 
 def error(msg):
@@ -34,19 +36,69 @@ Handlers = []
 class HandleCallList:
     def __init__(self):
         self.call_lists = {'ctr_run_initfuncs': []}
-        self.ctr_dispatch = { '_DECL_CALLLIST': self.decl_calllist }
+        self.taskwake_funcs = set()
+        self.ctr_dispatch = { '_DECL_CALLLIST': self.decl_calllist,
+                              '_DECL_TASKWAKE': self.decl_taskwake }
     def decl_calllist(self, req):
         funcname, callname = req.split()[1:]
         self.call_lists.setdefault(funcname, []).append(callname)
+    def decl_taskwake(self, req):
+        callname, initname = req.split()[1:]
+        self.call_lists.setdefault('ctr_run_taskfuncs', []).append(callname)
+        self.call_lists['ctr_run_initfuncs'].append(initname)
+        self.taskwake_funcs.add(callname)
     def update_data_dictionary(self, data):
-        pass
+        # Export task dispatch order so hosts can map profiler ids
+        taskfuncs = self.call_lists.get('ctr_run_taskfuncs', [])
+        for i, f in enumerate(taskfuncs):
+            HandlerEnumerations.add_enumeration('sched_task', f, i)
+    def generate_taskfuncs(self, funcs):
+        # Bitmap dispatch - visit only tasks that have been woken
+        always_mask = 0
+        masks = []
+        for i, f in enumerate(funcs):
+            if f in self.taskwake_funcs:
+                masks.append('const uint32_t ctr_taskwake_mask_%s = 0x%08x;'
+                             % (f, 1 << i))
+            else:
+                always_mask |= 1 << i
+        decls = ['    extern void %s(void);' % (f,) for f in funcs]
+        table = ['    static void (* const taskfuncs[])(void) = {']
+        table += ['        %s,' % (f,) for f in funcs]
+        table += ['    };']
+        fmt = """
+%s
+
+void
+ctr_run_taskfuncs(void)
+{
+%s
+%s
+    uint32_t bitmap = (sched_claim_woken_tasks() & 0x%08x) | 0x%08x;
+    while (bitmap) {
+        uint_fast8_t idx = __builtin_ctz(bitmap);
+        bitmap &= bitmap - 1;
+        irq_poll();
+        sched_run_task(idx, taskfuncs[idx]);
+    }
+    irq_poll();
+}
+"""
+        return fmt % ("\n".join(masks), "\n".join(decls), "\n".join(table)
+                      , (1 << len(funcs)) - 1, always_mask)
     def generate_code(self, options):
         code = []
         for funcname, funcs in self.call_lists.items():
+            if funcname == 'ctr_run_taskfuncs' and len(funcs) <= 32:
+                code.append(self.generate_taskfuncs(funcs))
+                continue
             func_code = ['    extern void %s(void);\n    %s();' % (f, f)
                          for f in funcs]
             if funcname == 'ctr_run_taskfuncs':
                 add_poll = '    irq_poll();\n'
+                func_code = [
+                    '    extern void %s(void);\n    sched_run_task(%d, %s);'
+                    % (f, i, f) for i, f in enumerate(funcs)]
                 func_code = [add_poll + fc for fc in func_code]
                 func_code.append(add_poll)
             fmt = """
@@ -356,8 +408,59 @@ class HandleCommandGeneration:
                             + sum([t.max_length for t in param_types])))
             out += "    .max_size=%d," % (max_size,)
         return out
+    def build_fast_encoder(self, encoded_msgid, msgformat):
+        # Generate a straight-line encoder (for simple message layouts)
+        param_types = [t for name, t in msgproto.lookup_params(msgformat)]
+        names = [t.__class__.__name__ for t in param_types]
+        for i, n in enumerate(names):
+            if n == 'PT_buffer':
+                if i != len(names) - 1:
+                    return None
+            elif n not in ('PT_uint32', 'PT_int32', 'PT_uint16',
+                           'PT_int16', 'PT_byte'):
+                return None
+        msgid_size = 1
+        if encoded_msgid >= 0x80:
+            msgid_size = 2
+        max_size = min(msgproto.MESSAGE_MAX,
+                       (msgproto.MESSAGE_MIN + msgid_size
+                        + sum([t.max_length for t in param_types])))
+        lines = []
+        if encoded_msgid >= 0x80:
+            lines.append('*p++ = 0x%02x;' % ((encoded_msgid >> 7) | 0x80,))
+        lines.append('*p++ = 0x%02x;' % (encoded_msgid & 0x7f,))
+        if not names:
+            lines.append('(void)args;')
+        for n in names:
+            if n == 'PT_buffer':
+                lines.append('uint8_t *maxend = &buf[MESSAGE_HEADER_SIZE'
+                             ' + %d];' % (max_size - msgproto.MESSAGE_MIN,))
+                lines.append('uint32_t blen = va_arg(args, int);')
+                lines.append('if (blen > maxend - p)\n'
+                             '        blen = maxend - p;')
+                lines.append('*p++ = blen;')
+                lines.append('memcpy(p, va_arg(args, uint8_t*), blen);')
+                lines.append('p += blen;')
+            elif n == 'PT_int16':
+                lines.append('p = command_encode_int(p, FE_ARG_I16(args));')
+            elif n in ('PT_uint16', 'PT_byte'):
+                lines.append('p = command_encode_int(p, FE_ARG_U16(args));')
+            else:
+                lines.append('p = command_encode_int(p,'
+                             ' va_arg(args, uint32_t));')
+        fmt = """
+static uint_fast8_t
+command_fast_encode_%d(uint8_t *buf, va_list args)
+{
+    uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
+    %s
+    return p - buf + MESSAGE_TRAILER_SIZE;
+}
+"""
+        return fmt % (encoded_msgid, "\n    ".join(lines))
     def generate_responses_code(self):
         encoder_defs = []
+        fast_defs = []
         output_code = []
         encoder_code = []
         did_output = {}
@@ -369,17 +472,35 @@ class HandleCommandGeneration:
             code = ('    if (__builtin_strcmp(str, "%s") == 0)\n'
                     '        return &command_encoder_%s;\n'
                     % (msg, encoded_msgid))
+            fastfunc = '0'
             if msgname is None:
                 parsercode = self.build_parser(encoded_msgid, msg, 'output')
                 output_code.append(code)
             else:
                 parsercode = self.build_parser(encoded_msgid, msg, 'command')
                 encoder_code.append(code)
+                fastcode = self.build_fast_encoder(encoded_msgid, msg)
+                if fastcode is not None:
+                    fast_defs.append(fastcode)
+                    fastfunc = 'command_fast_encode_%d' % (encoded_msgid,)
             encoder_defs.append(
                 "const struct command_encoder command_encoder_%s PROGMEM = {"
-                "    %s\n};\n" % (
-                    encoded_msgid, parsercode))
+                "    %s\n    FE_FUNC(%s)\n};\n" % (
+                    encoded_msgid, parsercode, fastfunc))
         fmt = """
+#if CONFIG_WANT_FAST_ENCODERS
+#define FE_FUNC(fn) .encode_func=fn,
+#define FE_ARG_U16(args) (sizeof(uint32_t) > sizeof(int) \\
+                          ? va_arg(args, unsigned int) : va_arg(args, uint32_t))
+#define FE_ARG_I16(args) (sizeof(uint32_t) > sizeof(int) \\
+                          ? (uint32_t)(int32_t)va_arg(args, int) \\
+                          : va_arg(args, uint32_t))
+
+%s
+#else
+#define FE_FUNC(fn)
+#endif
+
 %s
 
 const __always_inline struct command_encoder *
@@ -396,7 +517,8 @@ ctr_lookup_output(const char *str)
     return NULL;
 }
 """
-        return fmt % ("".join(encoder_defs).strip(),
+        return fmt % ("".join(fast_defs).strip(),
+                      "".join(encoder_defs).strip(),
                       "".join(encoder_code).strip(),
                       "".join(output_code).strip())
     def generate_commands_code(self):
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# Replay a recorded gcode session through the host code and report timings
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+#
+# Runs klippy.py in its batch mode (see Debugging.md) in-process under
+# the profiler - the full host pipeline executes (gcode parsing,
+# toolhead lookahead, chelper step generation, mcu message encoding)
+# with the serial output written to a file instead of a real mcu.
+# Reports wall time per pipeline stage and, optionally, allocation
+# counts so host-side performance regressions show up in seconds
+# instead of on printers.
+#
+# Typical usage:
+#   python3 scripts/perf_klippy.py test/klippy/printer.cfg \
+#     -d out/klipper.dict -i session.gcode
+import sys, os, time, optparse, cProfile, pstats
+
+TEMP_OUTPUT_FILE = "_perf_output"
+
+# Map of klippy source files to reported pipeline stages
+STAGES = [
+    ('gcode parse', ('klippy/gcode.py', 'klippy/gcode_move.py',
+                     'klippy/extras/gcode_macro.py',
+                     'klippy/extras/virtual_sdcard.py')),
+    ('toolhead lookahead', ('klippy/toolhead.py', 'klippy/kinematics/',
+                            'klippy/extras/input_shaper.py',
+                            'klippy/extras/skew_correction.py')),
+    ('step generation', ('klippy/stepper.py', 'klippy/mcu.py',
+                         'klippy/chelper/')),
+    ('serial output', ('klippy/serialhdl.py', 'klippy/msgproto.py',
+                       'klippy/clocksync.py')),
+    ('reactor', ('klippy/reactor.py',)),
+]
+
+def stage_lookup(fname):
+    fname = fname.replace('\\', '/')
+    for name, prefixes in STAGES:
+        for prefix in prefixes:
+            if prefix in fname:
+                return name
+    return 'other'
+
+def report_profile(profile, total_time):
+    stats = pstats.Stats(profile)
+    stage_times = {}
+    profiled_time = 0.
+    for (fname, lineno, func), (cc, nc, tt, ct, callers) in stats.stats.items():
+        stage = stage_lookup(fname)
+        stage_times[stage] = stage_times.get(stage, 0.) + tt
+        profiled_time += tt
+    sys.stdout.write("\nWall time per stage:\n")
+    stages = [name for name, prefixes in STAGES] + ['other']
+    for stage in stages:
+        st = stage_times.get(stage, 0.)
+        sys.stdout.write("  %-20s %8.3fs %5.1f%%\n"
+                         % (stage, st, 100. * st / profiled_time))
+    sys.stdout.write("  %-20s %8.3fs (total wall %.3fs)\n"
+                     % ('profiled total', profiled_time, total_time))
+
+def report_funcs(profile, count):
+    sys.stdout.write("\nTop functions by internal time:\n")
+    stats = pstats.Stats(profile, stream=sys.stdout)
+    stats.sort_stats('tottime').print_stats(count)
+
+def report_allocs(snapshot):
+    stage_counts = {}
+    stage_sizes = {}
+    for stat in snapshot.statistics('filename'):
+        stage = stage_lookup(stat.traceback[0].filename)
+        stage_counts[stage] = stage_counts.get(stage, 0) + stat.count
+        stage_sizes[stage] = stage_sizes.get(stage, 0) + stat.size
+    sys.stdout.write("\nLive allocations per stage (at end of replay):\n")
+    stages = [name for name, prefixes in STAGES] + ['other']
+    for stage in stages:
+        sys.stdout.write("  %-20s %9d blocks %9.0f KiB\n"
+                         % (stage, stage_counts.get(stage, 0),
+                            stage_sizes.get(stage, 0) / 1024.))
+
+def main():
+    usage = "%prog [options] <config file>"
+    opts = optparse.OptionParser(usage)
+    opts.add_option("-i", "--input", dest="input",
+                    help="recorded gcode session to replay")
+    opts.add_option("-d", "--dictionary", dest="dictionary", action="append",
+                    help="file to read for mcu protocol dictionary")
+    opts.add_option("-o", "--output", dest="output",
+                    help="serial output file (default is a temp file)")
+    opts.add_option("-l", "--logfile", dest="logfile",
+                    help="write log to file instead of stderr")
+    opts.add_option("-f", "--funcs", type="int", dest="funcs", default=0,
+                    help="also show the top N functions by internal time")
+    opts.add_option("--allocs", action="store_true", dest="allocs",
+                    help="track allocations (adds noticeable overhead)")
+    options, args = opts.parse_args()
+    if len(args) != 1:
+        opts.error("Incorrect number of arguments")
+    if options.input is None:
+        opts.error("gcode session file not specified")
+    if not options.dictionary:
+        opts.error("data dictionary file not specified")
+    output = options.output
+    if output is None:
+        output = TEMP_OUTPUT_FILE
+
+    # Build the klippy.py batch mode command line and import klippy
+    kdir = os.path.join(os.path.dirname(os.path.dirname(
+        os.path.realpath(__file__))), 'klippy')
+    sys.path.insert(0, kdir)
+    import klippy
+    argv = [os.path.join(kdir, 'klippy.py'), args[0],
+            '-i', options.input, '-o', output]
+    for df in options.dictionary:
+        argv += ['-d', df]
+    if options.logfile:
+        argv += ['-l', options.logfile]
+    sys.argv = argv
+
+    # Run the replay under the profiler
+    if options.allocs:
+        import tracemalloc
+        tracemalloc.start()
+    profile = cProfile.Profile()
+    start_time = time.time()
+    try:
+        profile.runcall(klippy.main)
+    except SystemExit as e:
+        if e.code:
+            sys.stderr.write("Error during replay - see log\n")
+            sys.exit(e.code)
+    total_time = time.time() - start_time
+    snapshot = None
+    if options.allocs:
+        snapshot = tracemalloc.take_snapshot()
+        tracemalloc.stop()
+
+    sys.stdout.write("Replayed %s in %.3f seconds\n"
+                     % (options.input, total_time))
+    report_profile(profile, total_time)
+    if options.funcs:
+        report_funcs(profile, options.funcs)
+    if snapshot is not None:
+        report_allocs(snapshot)
+
+    # Remove temporary output files
+    if options.output is None:
+        outdir = os.path.dirname(output) or '.'
+        for fname in os.listdir(outdir):
+            if fname.startswith(TEMP_OUTPUT_FILE):
+                os.unlink(os.path.join(outdir, fname))
+
+if __name__ == '__main__':
+    main()
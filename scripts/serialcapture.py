@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+# Tool to inspect and replay serialqueue traffic capture files
+#
+# Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+#
+# This file may be distributed under the terms of the GNU GPLv3 license.
+import optparse, os, struct, sys, time
+
+sys.path.append(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                             '..', 'klippy'))
+
+RECORD_MAGIC = 0x4b515253
+RECORD_VERSION = 1
+HEADER_FORMAT = '<IIII'
+ENTRY_FORMAT = '<dII64s'
+RT_SENT, RT_RECEIVED, RT_RETRANSMIT, RT_ACK_LATENCY = 1, 2, 3, 4
+RT_NAMES = {RT_SENT: 'sent', RT_RECEIVED: 'received',
+            RT_RETRANSMIT: 'retransmit', RT_ACK_LATENCY: 'ack_latency'}
+
+def read_capture(filename):
+    with open(filename, 'rb') as f:
+        data = f.read()
+    hdr_size = struct.calcsize(HEADER_FORMAT)
+    magic, version, num_records, next_index = struct.unpack_from(
+        HEADER_FORMAT, data)
+    if magic != RECORD_MAGIC or version != RECORD_VERSION:
+        raise ValueError("Not a serialqueue capture file")
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    entries = []
+    for i in range(num_records):
+        idx = (next_index + i) % num_records
+        eventtime, kind, mlen, mdata = struct.unpack_from(
+            ENTRY_FORMAT, data, hdr_size + idx * entry_size)
+        if not kind:
+            # Ring slot never written
+            continue
+        entries.append((eventtime, kind, mdata[:mlen]))
+    return entries
+
+def report_summary(entries):
+    counts = {}
+    bytecounts = {}
+    latencies = []
+    for eventtime, kind, mdata in entries:
+        counts[kind] = counts.get(kind, 0) + 1
+        bytecounts[kind] = bytecounts.get(kind, 0) + len(mdata)
+        if kind == RT_ACK_LATENCY:
+            latencies.append(struct.unpack('<d', mdata)[0])
+    duration = entries[-1][0] - entries[0][0]
+    print("Capture of %d events over %.3f seconds" % (len(entries), duration))
+    for kind in sorted(counts):
+        print("  %-12s %7d events %9d bytes"
+              % (RT_NAMES.get(kind, kind), counts[kind], bytecounts[kind]))
+    if duration and RT_SENT in bytecounts:
+        print("Send bandwidth: %.1f bytes/sec"
+              % (bytecounts[RT_SENT] / duration,))
+    if latencies:
+        latencies.sort()
+        print("Ack latency: min=%.6f median=%.6f max=%.6f"
+              % (latencies[0], latencies[len(latencies) // 2], latencies[-1]))
+
+def replay(entries, loops):
+    # Re-drive captured command traffic through a debug file serialqueue
+    import chelper
+    ffi_main, ffi_lib = chelper.get_ffi()
+    payloads = [mdata[2:-3] for eventtime, kind, mdata in entries
+                if kind == RT_SENT and len(mdata) > 5]
+    if not payloads:
+        print("No sent messages in capture")
+        return
+    devnull = os.open(os.devnull, os.O_WRONLY)
+    sq = ffi_lib.serialqueue_alloc(devnull, b'f', 0, b"replay")
+    cq = ffi_lib.serialqueue_alloc_commandqueue()
+    starttime = time.time()
+    for i in range(loops):
+        for payload in payloads:
+            ffi_lib.serialqueue_send(sq, cq, payload, len(payload), 0, 0, 0)
+    ffi_lib.serialqueue_exit(sq)
+    endtime = time.time()
+    ffi_lib.serialqueue_free(sq)
+    ffi_lib.serialqueue_free_commandqueue(cq)
+    os.close(devnull)
+    total = len(payloads) * loops
+    print("Replayed %d messages in %.3f seconds (%.0f messages/sec)"
+          % (total, endtime - starttime, total / (endtime - starttime)))
+
+def main():
+    usage = "%prog [options] <capture_file>"
+    opts = optparse.OptionParser(usage)
+    opts.add_option("-r", "--replay", action="store_true",
+                    help="replay captured sends through a debug serialqueue")
+    opts.add_option("-l", "--loops", type="int", default=1,
+                    help="number of times to replay the capture")
+    options, args = opts.parse_args()
+    if len(args) != 1:
+        opts.error("Incorrect number of arguments")
+    entries = read_capture(args[0])
+    if not entries:
+        print("Capture file is empty")
+        return
+    report_summary(entries)
+    if options.replay:
+        replay(entries, options.loops)
+
+if __name__ == '__main__':
+    main()
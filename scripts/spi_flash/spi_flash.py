@@ -21,6 +21,7 @@ import util
 import reactor
 import serialhdl
 import clocksync
+import msgproto
 
 ###########################################################
 #
@@ -133,6 +134,14 @@ SDIO_READ_DATA_BUFFER="sdio_read_data_buffer oid=%c offset=%u len=%c"
 SDIO_READ_DATA_BUFFER_RESPONSE="sdio_read_data_buffer_response oid=%c data=%*s"
 SDIO_WRITE_DATA_BUFFER="sdio_write_data_buffer oid=%c offset=%u data=%*s"
 SDIO_SET_SPEED="sdio_set_speed oid=%c speed=%u"
+SDIO_READ_DATA_BLOCKS="sdio_read_data_blocks oid=%c cmd=%c argument=%u " \
+    "blocks=%c"
+SDIO_READ_DATA_BLOCKS_RESPONSE="sdio_read_data_blocks_response oid=%c " \
+    "error=%c read=%u"
+SDIO_WRITE_DATA_BLOCKS="sdio_write_data_blocks oid=%c cmd=%c argument=%u " \
+    "blocks=%c"
+SDIO_WRITE_DATA_BLOCKS_RESPONSE="sdio_write_data_blocks_response oid=%c " \
+    "error=%c write=%u"
 
 FINALIZE_CFG_CMD = "finalize_config crc=%d"
 
@@ -197,6 +206,28 @@ class SDIODirect:
         self._sdio_write_data_buffer = CommandWrapper(ser,
             SDIO_WRITE_DATA_BUFFER)
         self._sdio_set_speed = CommandWrapper(ser, SDIO_SET_SPEED)
+        # Multi-block transfers (not available on older firmware)
+        try:
+            self._sdio_read_data_blocks = CommandQueryWrapper(
+                ser, SDIO_READ_DATA_BLOCKS, SDIO_READ_DATA_BLOCKS_RESPONSE,
+                self.oid)
+            self._sdio_write_data_blocks = CommandQueryWrapper(
+                ser, SDIO_WRITE_DATA_BLOCKS, SDIO_WRITE_DATA_BLOCKS_RESPONSE,
+                self.oid)
+        except msgproto.error:
+            self._sdio_read_data_blocks = None
+            self._sdio_write_data_blocks = None
+
+    def has_multiblock(self):
+        return self._sdio_read_data_blocks is not None
+
+    def sdio_read_data_blocks(self, cmd, argument, blocks):
+        return self._sdio_read_data_blocks.send(
+            [self.oid, cmd, argument, blocks])
+
+    def sdio_write_data_blocks(self, cmd, argument, blocks):
+        return self._sdio_write_data_blocks.send(
+            [self.oid, cmd, argument, blocks])
 
     def sdio_send_cmd(self, cmd, argument, wait):
         return self._sdio_send_cmd.send([self.oid, cmd, argument, wait])
@@ -232,6 +263,10 @@ STA_NO_INIT = 1 << 0
 STA_NO_DISK = 1 << 1
 STA_WRITE_PROTECT = 1 << 2
 SECTOR_SIZE = 512
+# Multi-block transfers are limited by the MCU's 4KiB data buffer
+MAX_XFER_BLOCKS = 8
+# Largest buffer read/write chunk that fits in one mcu message
+XFER_CHUNK = 48
 
 # FAT16/32 File System Support
 class FatFS:
@@ -286,6 +321,15 @@ class FatFS:
         return self.disk_status
 
     def _fatfs_cb_disk_read(self, readbuf, sector, count):
+        if count > 1 and self.sdcard.supports_multiblock():
+            # Stream all sectors in one multi-block transfer
+            try:
+                buf = self.sdcard.read_sectors(sector, count)
+            except Exception:
+                logging.exception("SD Card Multi-Block Read Error")
+            else:
+                readbuf[0:count*SECTOR_SIZE] = list(buf)
+                return 0
         start = 0
         end = SECTOR_SIZE
         for sec in range(sector, sector + count, 1):
@@ -309,6 +353,15 @@ class FatFS:
         return 0
 
     def _fatfs_cb_disk_write(self, writebuf, sector, count):
+        if count > 1 and self.sdcard.supports_multiblock():
+            # Stream all sectors in one multi-block transfer
+            try:
+                self.sdcard.write_sectors(
+                    sector, bytearray(writebuf[0:count*SECTOR_SIZE]))
+            except Exception:
+                logging.exception("SD Card Multi-Block Write Error")
+            else:
+                return 0
         start = 0
         end = SECTOR_SIZE
         for sec in range(sector, sector + count, 1):
@@ -522,9 +575,12 @@ SD_COMMANDS = {
     'SEND_CID': 10,
     'SD_SEND_OP_COND': 41,
     'SEND_STATUS': 13,
+    'STOP_TRANSMISSION': 12,
     'SET_BLOCKLEN': 16,
     'READ_SINGLE_BLOCK': 17,
+    'READ_MULTIPLE_BLOCK': 18,
     'WRITE_BLOCK': 24,
+    'WRITE_MULTIPLE_BLOCK': 25,
     'APP_CMD': 55,
     'READ_OCR': 58,
     'CRC_ON_OFF': 59,
@@ -763,6 +819,9 @@ class SDCardSPI:
         for name, val in self.card_info.items():
             print_func("%s: %s" % (name, val))
 
+    def supports_multiblock(self):
+        return False
+
     def read_sector(self, sector):
         buf = None
         err_msg = "flash_sdcard: read error, sector %d" % (sector,)
@@ -1111,6 +1170,102 @@ class SDCardSDIO:
         for name, val in self.card_info.items():
             print_func("%s: %s" % (name, val))
 
+    def supports_multiblock(self):
+        return self.sdio.has_multiblock()
+
+    def _drain_data_buffer(self, length):
+        buf = bytearray()
+        offset = 0
+        while length - len(buf) > 0:
+            rest = min(length - len(buf), XFER_CHUNK)
+            params = self.sdio.sdio_read_data_buffer(offset, length=rest)
+            temp = bytearray(params['data'])
+            if len(temp) == 0:
+                raise OSError("Read zero bytes from buffer")
+            buf += temp
+            offset += len(temp)
+        return buf
+
+    def read_sectors(self, sector, count):
+        # Multi-block read (CMD18) into the MCU buffer, then drain it
+        buf = bytearray()
+        with self.mutex:
+            if not 0 <= sector <= sector + count <= self.total_sectors:
+                raise OSError("flash_sdcard: read error, sectors %d-%d"
+                              " out of range" % (sector, sector + count))
+            if not self.initialized:
+                raise OSError("flash_sdcard: read error, SD Card not"
+                              " initialized")
+            while count:
+                blocks = min(count, MAX_XFER_BLOCKS)
+                offset = sector
+                if not self.high_capacity:
+                    offset = sector * SECTOR_SIZE
+                params = self.sdio.sdio_read_data_blocks(
+                    SD_COMMANDS['READ_MULTIPLE_BLOCK'], offset, blocks)
+                stop = self.sdio.sdio_send_cmd(
+                    SD_COMMANDS['STOP_TRANSMISSION'], 0, 1)
+                if params['error'] != 0 or stop['error'] != 0:
+                    raise OSError(
+                        'Read data failed. Error code=%d stop=%d'
+                        % (params['error'], stop['error']))
+                nbytes = blocks * SECTOR_SIZE
+                if params['read'] != nbytes:
+                    raise OSError(
+                        'Read data failed. Expected %d bytes but got %d.'
+                        % (nbytes, params['read']))
+                buf += self._drain_data_buffer(nbytes)
+                sector += blocks
+                count -= blocks
+        return buf
+
+    def write_sectors(self, sector, data):
+        # Multi-block write (CMD25) staged through the MCU buffer
+        outbuf = bytearray(data)
+        count = (len(outbuf) + SECTOR_SIZE - 1) // SECTOR_SIZE
+        if len(outbuf) < count * SECTOR_SIZE:
+            outbuf += bytearray([0] * (count * SECTOR_SIZE - len(outbuf)))
+        with self.mutex:
+            if not 0 <= sector <= sector + count <= self.total_sectors:
+                raise OSError("flash_sdcard: write error, sectors %d-%d"
+                              " out of range" % (sector, sector + count))
+            if not self.initialized:
+                raise OSError("flash_sdcard: write error, SD Card not"
+                              " initialized")
+            pos = 0
+            while count:
+                blocks = min(count, MAX_XFER_BLOCKS)
+                nbytes = blocks * SECTOR_SIZE
+                for i in range(0, nbytes, XFER_CHUNK):
+                    self.sdio.sdio_write_data_buffer(
+                        i, outbuf[pos+i:pos+i+XFER_CHUNK])
+                offset = sector
+                if not self.high_capacity:
+                    offset = sector * SECTOR_SIZE
+                params = self.sdio.sdio_write_data_blocks(
+                    SD_COMMANDS['WRITE_MULTIPLE_BLOCK'], offset, blocks)
+                stop = self.sdio.sdio_send_cmd(
+                    SD_COMMANDS['STOP_TRANSMISSION'], 0, 1)
+                if (params['error'] != 0 or stop['error'] != 0
+                        or params['write'] != nbytes):
+                    raise OSError(
+                        "flash_sdcard: Error writing to sectors %d-%d"
+                        % (sector, sector + blocks))
+                status = self._send_command_with_response(
+                    'SEND_STATUS', self.rca << 16)
+                if len(status) != 4:
+                    raise OSError("flash_sdcard: Failed to get status"
+                                  " response after write: %s"
+                                  % (repr(status),))
+                if ((status[3]>>1) & 0x0F) != 0:
+                    # Bit 12:9 are not "0" (card is in idle)
+                    raise OSError("flash_sdcard: Write error."
+                                  " Card is not in transfer state: 0x%02X"
+                                  % (((status[3]>>1) & 0x0F)))
+                pos += nbytes
+                sector += blocks
+                count -= blocks
+
     def read_sector(self, sector):
         buf = None
         err_msg = "flash_sdcard: read error, sector %d" % (sector,)
@@ -3,11 +3,19 @@
 # Copyright (C) 2018  Kevin O'Connor <kevin@koconnor.net>
 #
 # This file may be distributed under the terms of the GNU GPLv3 license.
-import sys, os, optparse, logging, subprocess
+import sys, os, optparse, logging, subprocess, time, threading
+from multiprocessing.pool import ThreadPool
 
-TEMP_GCODE_FILE = "_test_.gcode"
-TEMP_LOG_FILE = "_test_.log"
-TEMP_OUTPUT_FILE = "_test_output"
+TEMP_GCODE_FILE = "_test_%s.gcode"
+TEMP_LOG_FILE = "_test_%s.log"
+TEMP_OUTPUT_FILE = "_test_output_%s"
+
+# Serialize writes to stderr when tests run in parallel
+OutputLock = threading.Lock()
+
+def report(msg):
+    with OutputLock:
+        sys.stderr.write(msg)
 
 
 ######################################################################
@@ -18,12 +26,18 @@ class error(Exception):
     pass
 
 class TestCase:
-    def __init__(self, fname, dictdir, tempdir, verbose, keepfiles):
+    def __init__(self, fname, dictdir, tempdir, verbose, keepfiles, perf):
         self.fname = fname
         self.dictdir = dictdir
         self.tempdir = tempdir
         self.verbose = verbose
         self.keepfiles = keepfiles
+        self.perf = perf
+        # Per-case temporary file names (so tests can run in parallel)
+        base = os.path.splitext(os.path.basename(fname))[0]
+        self.temp_gcode_file = TEMP_GCODE_FILE % (base,)
+        self.temp_log_file = TEMP_LOG_FILE % (base,)
+        self.temp_output_file = TEMP_OUTPUT_FILE % (base,)
     def relpath(self, fname, rel='test'):
         if rel == 'dict':
             reldir = self.dictdir
@@ -76,7 +90,7 @@ class TestCase:
                     should_fail):
         gcode_is_temp = False
         if gcode_fname is None:
-            gcode_fname = self.relpath(TEMP_GCODE_FILE, 'temp')
+            gcode_fname = self.relpath(self.temp_gcode_file, 'temp')
             gcode_is_temp = True
             f = open(gcode_fname, 'w')
             f.write('\n'.join(gcode + ['']))
@@ -88,15 +102,25 @@ class TestCase:
         if dict_fnames is None:
             raise error("data dictionary file not specified")
         # Call klippy
-        sys.stderr.write("    Starting %s (%s)\n" % (
+        report("    Starting %s (%s)\n" % (
             self.fname, os.path.basename(config_fname)))
-        args = [ sys.executable, './klippy/klippy.py', config_fname,
-                 '-i', gcode_fname, '-o', TEMP_OUTPUT_FILE, '-v' ]
+        script = './klippy/klippy.py'
+        if self.perf:
+            script = './scripts/perf_klippy.py'
+        args = [ sys.executable, script, config_fname,
+                 '-i', gcode_fname, '-o', self.temp_output_file ]
+        if not self.perf:
+            args += ['-v']
         for df in dict_fnames:
             args += ['-d', df]
         if not self.verbose:
-            args += ['-l', TEMP_LOG_FILE]
-        res = subprocess.call(args)
+            args += ['-l', self.temp_log_file]
+        start_time = time.time()
+        if self.perf:
+            res = self.launch_perf_test(args)
+        else:
+            res = subprocess.call(args)
+        elapsed = time.time() - start_time
         is_fail = (should_fail and not res) or (not should_fail and res)
         if is_fail:
             if not self.verbose:
@@ -104,18 +128,28 @@ class TestCase:
             if should_fail:
                 raise error("Test failed to raise an error")
             raise error("Error during test")
+        report("    Finished %s (%s) in %.1fs\n" % (
+            self.fname, os.path.basename(config_fname), elapsed))
         # Do cleanup
         if self.keepfiles:
             return
         for fname in os.listdir(self.tempdir):
-            if fname.startswith(TEMP_OUTPUT_FILE):
+            if fname.startswith(self.temp_output_file):
                 os.unlink(fname)
         if not self.verbose:
-            os.unlink(TEMP_LOG_FILE)
-        else:
-            sys.stderr.write('\n')
+            os.unlink(self.temp_log_file)
+        elif not self.perf:
+            report('\n')
         if gcode_is_temp:
             os.unlink(gcode_fname)
+    def launch_perf_test(self, args):
+        # Run via perf_klippy.py and report its per-stage timings
+        proc = subprocess.run(args, stdout=subprocess.PIPE,
+                              universal_newlines=True)
+        lines = ["      %s\n" % (l.strip(),)
+                 for l in proc.stdout.split('\n') if l.strip()]
+        report("".join(lines))
+        return proc.returncode
     def run(self):
         try:
             self.parse_test()
@@ -126,10 +160,11 @@ class TestCase:
             return "internal error"
         return "success"
     def show_log(self):
-        f = open(TEMP_LOG_FILE, 'r')
+        f = open(self.temp_log_file, 'r')
         data = f.read()
         f.close()
-        sys.stdout.write(data)
+        with OutputLock:
+            sys.stdout.write(data)
 
 
 ######################################################################
@@ -144,25 +179,43 @@ def main():
                     help="directory for dictionary files")
     opts.add_option("-t", "--tempdir", dest="tempdir", default=".",
                     help="directory for temporary files")
+    opts.add_option("-j", "--jobs", type="int", dest="jobs", default=1,
+                    help="number of test cases to run in parallel")
     opts.add_option("-k", action="store_true", dest="keepfiles",
                     help="do not remove temporary files")
     opts.add_option("-v", action="store_true", dest="verbose",
                     help="show all output from tests")
+    opts.add_option("-p", "--perf", action="store_true", dest="perf",
+                    help="run tests under scripts/perf_klippy.py and report"
+                    " per-stage timings")
     options, args = opts.parse_args()
     if len(args) < 1:
         opts.error("Incorrect number of arguments")
     logging.basicConfig(level=logging.DEBUG)
 
-    # Run each test
-    for fname in args:
-        tc = TestCase(fname, options.dictdir, options.tempdir, options.verbose,
-                      options.keepfiles)
-        res = tc.run()
+    # Run the tests (in parallel when requested)
+    cases = [TestCase(fname, options.dictdir, options.tempdir, options.verbose,
+                      options.keepfiles, options.perf)
+             for fname in args]
+    start_time = time.time()
+    if options.jobs > 1:
+        pool = ThreadPool(options.jobs)
+        results = pool.map(TestCase.run, cases)
+        pool.close()
+        pool.join()
+    else:
+        results = [tc.run() for tc in cases]
+    elapsed = time.time() - start_time
+    have_fail = False
+    for tc, res in zip(cases, results):
         if res != 'success':
-            sys.stderr.write("\n\nTest case %s FAILED (%s)!\n\n" % (fname, res))
-            sys.exit(-1)
+            have_fail = True
+            sys.stderr.write("\nTest case %s FAILED (%s)!\n" % (tc.fname, res))
+    if have_fail:
+        sys.exit(-1)
 
-    sys.stderr.write("\n    All %d test cases passed\n" % (len(args),))
+    sys.stderr.write("\n    All %d test cases passed in %.1fs\n"
+                     % (len(args), elapsed))
 
 if __name__ == '__main__':
     main()
@@ -8,6 +8,7 @@
 #include "board/gpio.h" // struct gpio_adc
 #include "board/irq.h" // irq_disable
 #include "command.h" // DECL_COMMAND
+#include "heater_pid.h" // heater_pid_update
 #include "sched.h" // DECL_TASK
 #include "trigger_analog.h" // trigger_analog_update
 
@@ -21,6 +22,7 @@ struct analog_in {
     uint8_t bytes_per_report, data_count;
     uint8_t data[48];
     struct trigger_analog *ta;
+    struct heater_pid *hp;
 };
 
 static struct task_wake analog_wake;
@@ -69,6 +71,7 @@ command_config_analog_in(uint32_t *args)
     struct analog_in *a = oid_alloc(
         args[0], command_config_analog_in, sizeof(*a));
     a->timer.func = analog_in_event;
+    a->timer.flags = TF_DEFERRABLE;
     a->pin = pin;
     a->state = 1;
 }
@@ -112,6 +115,16 @@ DECL_COMMAND(command_analog_in_attach_trigger_analog,
     "analog_in_attach_trigger_analog oid=%c trigger_analog_oid=%c");
 #endif
 
+void
+command_analog_in_attach_heater_pid(uint32_t *args) {
+    struct analog_in *a = oid_lookup(args[0], command_config_analog_in);
+    a->hp = heater_pid_oid_lookup(args[1]);
+}
+#if CONFIG_WANT_HEATER_PID
+DECL_COMMAND(command_analog_in_attach_heater_pid,
+    "analog_in_attach_heater_pid oid=%c heater_pid_oid=%c");
+#endif
+
 #define BYTES_PER_SAMPLE 2
 
 void
@@ -134,6 +147,7 @@ analog_in_task(void)
         a->state++;
         irq_enable();
         trigger_analog_update(a->ta, value);
+        heater_pid_update(a->hp, value);
         uint8_t *d = &a->data[a->data_count];
         d[0] = value;
         d[1] = value >> 8;
@@ -145,7 +159,7 @@ analog_in_task(void)
         }
     }
 }
-DECL_TASK(analog_in_task);
+DECL_TASK_WAKE(analog_in_task, analog_wake);
 
 void
 analog_in_shutdown(void)
@@ -164,3 +178,173 @@ analog_in_shutdown(void)
     }
 }
 DECL_SHUTDOWN(analog_in_shutdown);
+
+
+/****************************************************************
+ * Grouped channel scanning
+ ****************************************************************/
+
+// A scan group samples a set of channels from a single timer and
+// reports all values in one message - boards with many thermistors
+// avoid per-channel timer overhead and serial traffic.
+
+struct scan_chan {
+    struct gpio_adc pin;
+    uint16_t value, min_value, max_value;
+    uint8_t invalid_count;
+};
+
+struct analog_scan {
+    struct timer timer;
+    uint32_t rest_time, sample_time, next_begin_time;
+    uint8_t count, chan, state, sample_count;
+    uint8_t range_check_count, flags;
+    struct scan_chan chans[0];
+};
+
+enum { ASF_READY=1<<0 };
+
+#define MAX_SCAN_CHANS 16
+
+static struct task_wake analog_scan_wake;
+
+static uint_fast8_t
+analog_scan_event(struct timer *timer)
+{
+    struct analog_scan *a = container_of(timer, struct analog_scan, timer);
+    struct scan_chan *sc = &a->chans[a->chan];
+    uint32_t sample_delay = gpio_adc_sample(sc->pin);
+    if (sample_delay) {
+        a->timer.waketime += sample_delay;
+        return SF_RESCHEDULE;
+    }
+    uint16_t value = gpio_adc_read(sc->pin);
+    if (!a->state)
+        sc->value = value;
+    else
+        sc->value += value;
+    if (++a->chan >= a->count) {
+        a->chan = 0;
+        if (++a->state >= a->sample_count) {
+            // Scan pass complete - verify ranges and report
+            a->state = 0;
+            uint8_t i;
+            for (i=0; i<a->count; i++) {
+                sc = &a->chans[i];
+                if (likely(sc->value >= sc->min_value
+                           && sc->value <= sc->max_value)) {
+                    sc->invalid_count = 0;
+                } else {
+                    sc->invalid_count++;
+                    if (sc->invalid_count >= a->range_check_count) {
+                        try_shutdown("ADC out of range");
+                        sc->invalid_count = 0;
+                    }
+                }
+            }
+            a->flags |= ASF_READY;
+            sched_wake_task(&analog_scan_wake);
+            a->next_begin_time += a->rest_time;
+            a->timer.waketime = a->next_begin_time;
+            return SF_RESCHEDULE;
+        }
+    }
+    a->timer.waketime += a->sample_time;
+    return SF_RESCHEDULE;
+}
+
+void
+command_config_analog_scan(uint32_t *args)
+{
+    uint8_t count = args[1];
+    if (!count || count > MAX_SCAN_CHANS)
+        shutdown("Invalid analog_scan channel count");
+    struct analog_scan *a = oid_alloc(
+        args[0], command_config_analog_scan
+        , sizeof(*a) + count * sizeof(a->chans[0]));
+    a->timer.func = analog_scan_event;
+    a->timer.flags = TF_DEFERRABLE;
+    a->count = count;
+}
+DECL_COMMAND(command_config_analog_scan,
+             "config_analog_scan oid=%c channel_count=%c");
+
+void
+command_analog_scan_add_pin(uint32_t *args)
+{
+    struct analog_scan *a = oid_lookup(args[0], command_config_analog_scan);
+    uint8_t pos = args[1];
+    if (pos >= a->count)
+        shutdown("Set analog_scan past maximum channel count");
+    struct scan_chan *sc = &a->chans[pos];
+    sc->pin = gpio_adc_setup(args[2]);
+    sc->min_value = args[3];
+    sc->max_value = args[4];
+}
+DECL_COMMAND(command_analog_scan_add_pin,
+             "analog_scan_add_pin oid=%c pos=%c pin=%u"
+             " min_value=%hu max_value=%hu");
+
+void
+command_query_analog_scan(uint32_t *args)
+{
+    struct analog_scan *a = oid_lookup(args[0], command_config_analog_scan);
+    sched_del_timer(&a->timer);
+    gpio_adc_cancel_sample(a->chans[a->chan].pin);
+    a->next_begin_time = args[1];
+    a->timer.waketime = a->next_begin_time;
+    a->sample_time = args[2];
+    a->sample_count = args[3];
+    a->rest_time = args[4];
+    a->range_check_count = args[5];
+    a->chan = a->state = 0;
+    a->flags = 0;
+    if (! a->sample_count)
+        return;
+    sched_add_timer(&a->timer);
+}
+DECL_COMMAND(command_query_analog_scan,
+             "query_analog_scan oid=%c clock=%u sample_ticks=%u"
+             " sample_count=%c rest_ticks=%u range_check_count=%c");
+
+void
+analog_scan_task(void)
+{
+    if (!sched_check_wake(&analog_scan_wake))
+        return;
+    uint8_t oid;
+    struct analog_scan *a;
+    foreach_oid(oid, a, command_config_analog_scan) {
+        if (!(a->flags & ASF_READY))
+            continue;
+        uint8_t data[MAX_SCAN_CHANS * BYTES_PER_SAMPLE], i;
+        irq_disable();
+        a->flags &= ~ASF_READY;
+        uint32_t next_begin_time = a->next_begin_time;
+        for (i=0; i<a->count; i++) {
+            data[i*BYTES_PER_SAMPLE] = a->chans[i].value;
+            data[i*BYTES_PER_SAMPLE + 1] = a->chans[i].value >> 8;
+        }
+        irq_enable();
+        sendf("analog_scan_state oid=%c next_clock=%u values=%*s"
+              , oid, next_begin_time, a->count * BYTES_PER_SAMPLE, data);
+    }
+}
+DECL_TASK_WAKE(analog_scan_task, analog_scan_wake);
+
+void
+analog_scan_shutdown(void)
+{
+    uint8_t i;
+    struct analog_scan *a;
+    foreach_oid(i, a, command_config_analog_scan) {
+        gpio_adc_cancel_sample(a->chans[a->chan].pin);
+        if (a->sample_count) {
+            a->chan = a->state = 0;
+            a->next_begin_time += a->rest_time;
+            a->timer.waketime = a->next_begin_time;
+            sched_add_timer(&a->timer);
+        }
+    }
+}
+DECL_SHUTDOWN(analog_scan_shutdown);
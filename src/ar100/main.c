@@ -25,8 +25,14 @@ DECL_CONSTANT_STR("MCU", "ar100");
 static struct task_wake console_wake;
 static uint8_t receive_buf[192];
 static int receive_pos;
+// Transmit ring buffer (size must be a power of two - the push and
+// pull indexes are free running)
+static uint8_t transmit_buf[512];
+static uint32_t transmit_push, transmit_pull;
 static char dynmem_pool[8 * 1024];
 
+static void flush_transmit_buf(void);
+
 void *
 dynmem_start(void)
 {
@@ -76,6 +82,8 @@ irq_poll(void)
     }
     if(r_uart_fifo_rcv())
         sched_wake_task(&console_wake);
+    if(transmit_push != transmit_pull)
+        flush_transmit_buf();
 }
 
 /****************************************************************
@@ -110,6 +118,17 @@ console_task(void)
 }
 DECL_TASK(console_task);
 
+// Move buffered response bytes into the uart transmit fifo
+static void
+flush_transmit_buf(void)
+{
+    uint32_t pull = transmit_pull;
+    uint32_t space = R_UART_FIFO_SIZE - r_uart_fifo_snd();
+    while (space-- && transmit_push != pull)
+        r_uart_putc_async(transmit_buf[pull++ % sizeof(transmit_buf)]);
+    transmit_pull = pull;
+}
+
 // Encode and transmit a "response" message
 void
 console_sendf(const struct command_encoder *ce, va_list args)
@@ -117,9 +136,16 @@ console_sendf(const struct command_encoder *ce, va_list args)
     uint8_t buf[MESSAGE_MAX];
     uint_fast8_t msglen = command_encode_and_frame(buf, ce, args);
 
+    // Wait for enough credit in the transmit ring (only block when
+    // both the ring and the hardware fifo are full)
+    uint32_t push = transmit_push;
+    while (sizeof(transmit_buf) - (push - transmit_pull) < msglen)
+        flush_transmit_buf();
     for(int i=0; i<msglen; i++) {
-        r_uart_putc(buf[i]);
+        transmit_buf[push++ % sizeof(transmit_buf)] = buf[i];
     }
+    transmit_push = push;
+    flush_transmit_buf();
 }
 
 void restore_data(void)
@@ -40,6 +40,14 @@ uint32_t r_uart_fifo_rcv(void){
   return read_reg(R_UART_RFL);
 }
 
+uint32_t r_uart_fifo_snd(void){
+  return read_reg(R_UART_TFL);
+}
+
+void r_uart_putc_async(char c){
+  write_reg(R_UART_THR, c);
+}
+
 void r_uart_putc(char c){
   while(!(read_reg(R_UART_LSR) & 1<<5))
     ;
@@ -18,6 +18,8 @@
 #define R_UART_RFL  R_UART_BASE + 0x84 // UART_RFL
 #define R_UART_HLT  R_UART_BASE + 0xA4 // UART Halt TX Register
 
+#define R_UART_FIFO_SIZE 64
+
 #define UART0_BASE  0x01C28000
 #define UART0_RBR  UART0_BASE + 0x00 // UART Receive Buffer Register
 #define UART0_THR  UART0_BASE + 0x00 // UART Transmit Holding Register
@@ -43,8 +45,10 @@
 
 void r_uart_init(void);
 void r_uart_putc(char c);
+void r_uart_putc_async(char c);
 char r_uart_getc(void);
 uint32_t r_uart_fifo_rcv(void);
+uint32_t r_uart_fifo_snd(void);
 void uart_putc(char c);
 void uart_puts(char *s);
 void uart_puti(uint32_t u);
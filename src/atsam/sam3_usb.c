@@ -43,8 +43,8 @@ usb_read_packet(uint32_t ep, uint8_t *data, uint32_t len)
         *data++ = *src++;
 }
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     uint32_t eps = UOTGHS->UOTGHS_DEVEPTISR[USB_CDC_EP_BULK_OUT];
     if (!(eps & UOTGHS_DEVEPTISR_RXOUTI)) {
@@ -59,8 +59,8 @@ usb_read_bulk_out(void *data, uint_fast8_t max_len)
     return len;
 }
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     uint32_t eps = UOTGHS->UOTGHS_DEVEPTISR[USB_CDC_EP_BULK_IN];
     if (!(eps & UOTGHS_DEVEPTISR_TXINI)) {
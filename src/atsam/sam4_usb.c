@@ -35,8 +35,8 @@ usb_read_packet(uint32_t ep, uint32_t csr, uint8_t *data, uint32_t max_len)
     return orig_len;
 }
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     static uint32_t next_bk = UDP_CSR_RX_DATA_BK0;
     const uint32_t other_irqs = (UDP_CSR_RXSETUP | UDP_CSR_STALLSENT
@@ -59,8 +59,8 @@ usb_read_bulk_out(void *data, uint_fast8_t max_len)
     return len;
 }
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     const uint32_t other_irqs = (UDP_CSR_RXSETUP | UDP_CSR_STALLSENT
                                  | UDP_CSR_RX_DATA_BK0 | UDP_CSR_RX_DATA_BK1);
@@ -39,11 +39,15 @@ void gpio_adc_cancel_sample(struct gpio_adc g);
 struct spi_config {
     void *ss;
     uint32_t ctrla, baud;
+    uint8_t sercom_id;
 };
 struct spi_config spi_setup(uint32_t bus, uint8_t mode, uint32_t rate);
 void spi_prepare(struct spi_config config);
 void spi_transfer(struct spi_config config, uint8_t receive_data
                   , uint8_t len, uint8_t *data);
+void spi_transfer_dma_start(struct spi_config config, uint8_t receive_data
+                            , uint8_t len, uint8_t *data);
+int spi_transfer_dma_check(struct spi_config config);
 
 struct i2c_config {
     void *si;
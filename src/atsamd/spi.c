@@ -5,6 +5,8 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include "autoconf.h" // CONFIG_WANT_SPI_DMA
+#include "compiler.h" // __aligned
 #include "internal.h" // enable_pclock
 #include "gpio.h" // spi_setup
 
@@ -35,7 +37,8 @@ spi_setup(uint32_t bus, uint8_t mode, uint32_t rate)
     SercomSpi *ss = &sercom->SPI;
     uint32_t baud = sercom_get_pclock_frequency(bus) / (2 * rate) - 1;
     spi_init(bus, ss, ctrla, baud);
-    return (struct spi_config){ .ss = ss, .ctrla = ctrla, .baud = baud };
+    return (struct spi_config){ .ss = ss, .ctrla = ctrla, .baud = baud
+                                , .sercom_id = bus };
 }
 
 void
@@ -76,3 +79,113 @@ spi_transfer(struct spi_config config, uint8_t receive_data
         }
     }
 }
+
+
+/****************************************************************
+ * DMA based transfers
+ ****************************************************************/
+#if CONFIG_WANT_SPI_DMA
+
+#define SPI_DMA_RX_CHAN 0
+#define SPI_DMA_TX_CHAN 1
+
+// Dmac transfer descriptors (and hardware write-back area)
+static DmacDescriptor dma_descs[2] __aligned(16), dma_wrbs[2] __aligned(16);
+
+static uint8_t spi_dma_discard;
+
+// One time setup of the dmac engine
+static void
+dmac_setup(void)
+{
+    static uint8_t have_run_init;
+    if (have_run_init)
+        return;
+    have_run_init = 1;
+
+#if CONFIG_MACH_SAMD21
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+#else
+    MCLK->AHBMASK.reg |= MCLK_AHBMASK_DMAC;
+#endif
+    DMAC->BASEADDR.reg = (uint32_t)dma_descs;
+    DMAC->WRBADDR.reg = (uint32_t)dma_wrbs;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+}
+
+// Enable a dma channel with the given sercom trigger
+static void
+dmac_chan_start(uint32_t chan, uint32_t trigsrc)
+{
+#if CONFIG_MACH_SAMX2
+    // Channel registers are accessed via the shared CHID selector (the
+    // dma code only runs from task context, so no locking is needed)
+    DMAC->CHID.reg = chan;
+    DMAC->CHCTRLA.reg = 0;
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    DMAC->CHCTRLB.reg = (DMAC_CHCTRLB_TRIGSRC(trigsrc)
+                         | DMAC_CHCTRLB_TRIGACT_BEAT);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+#else
+    DmacChannel *ch = &DMAC->Channel[chan];
+    ch->CHCTRLA.reg = 0;
+    ch->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    ch->CHCTRLA.reg = (DMAC_CHCTRLA_TRIGSRC(trigsrc)
+                       | DMAC_CHCTRLA_TRIGACT_BURST
+                       | DMAC_CHCTRLA_BURSTLEN_SINGLE
+                       | DMAC_CHCTRLA_ENABLE);
+#endif
+}
+
+// Begin a transfer using dma (caller polls spi_transfer_dma_check())
+void
+spi_transfer_dma_start(struct spi_config config, uint8_t receive_data
+                       , uint8_t len, uint8_t *data)
+{
+    dmac_setup();
+    SercomSpi *ss = (SercomSpi *)config.ss;
+    // Received bytes are drained first so the rx fifo can not overrun
+    // (incrementing addresses must be programmed as their end address)
+    DmacDescriptor *rx = &dma_descs[SPI_DMA_RX_CHAN];
+    rx->BTCTRL.reg = (DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE
+                      | (receive_data ? DMAC_BTCTRL_DSTINC : 0));
+    rx->BTCNT.reg = len;
+    rx->SRCADDR.reg = (uint32_t)&ss->DATA.reg;
+    rx->DSTADDR.reg = (receive_data ? (uint32_t)data + len
+                       : (uint32_t)&spi_dma_discard);
+    rx->DESCADDR.reg = 0;
+    DmacDescriptor *tx = &dma_descs[SPI_DMA_TX_CHAN];
+    tx->BTCTRL.reg = (DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE
+                      | DMAC_BTCTRL_SRCINC);
+    tx->BTCNT.reg = len;
+    tx->SRCADDR.reg = (uint32_t)data + len;
+    tx->DSTADDR.reg = (uint32_t)&ss->DATA.reg;
+    tx->DESCADDR.reg = 0;
+    uint32_t trig_rx = SERCOM0_DMAC_ID_RX + config.sercom_id * 2;
+    uint32_t trig_tx = SERCOM0_DMAC_ID_TX + config.sercom_id * 2;
+    dmac_chan_start(SPI_DMA_RX_CHAN, trig_rx);
+    dmac_chan_start(SPI_DMA_TX_CHAN, trig_tx);
+}
+
+// Report if a transfer started by spi_transfer_dma_start() has completed
+int
+spi_transfer_dma_check(struct spi_config config)
+{
+    // The rx channel finishes after the last byte was received, which
+    // also implies the bus is idle
+#if CONFIG_MACH_SAMX2
+    DMAC->CHID.reg = SPI_DMA_RX_CHAN;
+    if (!(DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL))
+        return 0;
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+#else
+    DmacChannel *ch = &DMAC->Channel[SPI_DMA_RX_CHAN];
+    if (!(ch->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL))
+        return 0;
+    ch->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+#endif
+    return 1;
+}
+
+#endif // CONFIG_WANT_SPI_DMA
@@ -114,14 +114,14 @@ usb_read_packet(uint32_t ep, uint32_t bank, void *data, uint_fast8_t max_len)
  * Interface
  ****************************************************************/
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     return usb_read_packet(USB_CDC_EP_BULK_OUT, 0, data, max_len);
 }
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     return usb_write_packet(USB_CDC_EP_BULK_IN, 1, data, len);
 }
@@ -83,12 +83,6 @@ gpio_out_reset(struct gpio_out g, uint8_t val)
     irq_restore(flag);
 }
 
-void
-gpio_out_toggle_noirq(struct gpio_out g)
-{
-    g.regs->in = g.bit;
-}
-
 void
 gpio_out_toggle(struct gpio_out g)
 {
@@ -2,6 +2,7 @@
 #define __AVR_GPIO_H
 
 #include <stdint.h>
+#include "internal.h" // struct gpio_digital_regs
 
 struct gpio_out {
     struct gpio_digital_regs *regs;
@@ -10,7 +11,15 @@ struct gpio_out {
 };
 struct gpio_out gpio_out_setup(uint8_t pin, uint8_t val);
 void gpio_out_reset(struct gpio_out g, uint8_t val);
-void gpio_out_toggle_noirq(struct gpio_out g);
+
+// Toggle an output pin (a write to the PINx register flips the output
+// latch).  Inlined so step generation does not pay a call per edge.
+static inline void
+gpio_out_toggle_noirq(struct gpio_out g)
+{
+    g.regs->in = g.bit;
+}
+
 void gpio_out_toggle(struct gpio_out g);
 void gpio_out_write(struct gpio_out g, uint8_t val);
 
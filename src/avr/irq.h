@@ -3,6 +3,7 @@
 // Definitions for irq enable/disable on AVR
 
 #include <avr/interrupt.h> // cli
+#include "autoconf.h" // CONFIG_AVR_SLEEP_ON_IDLE
 #include "compiler.h" // barrier
 
 static inline void irq_disable(void) {
@@ -29,7 +30,12 @@ static inline void irq_restore(irqstatus_t flag) {
 }
 
 static inline void irq_wait(void) {
-    asm("sei\n    nop\n    cli" : : : "memory");
+    if (CONFIG_AVR_SLEEP_ON_IDLE)
+        // Halt the cpu clock until the next irq (timers keep running
+        // and a pending irq wakes the sleep immediately)
+        asm("sei\n    sleep\n    cli" : : : "memory");
+    else
+        asm("sei\n    nop\n    cli" : : : "memory");
 }
 
 static inline void irq_poll(void) {
@@ -5,6 +5,7 @@
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
 #include <avr/io.h> // AVR_STACK_POINTER_REG
+#include <avr/sleep.h> // set_sleep_mode
 #include <util/crc16.h> // _crc_ccitt_update
 #include "autoconf.h" // CONFIG_MCU
 #include "board/misc.h" // dynmem_start
@@ -52,6 +53,17 @@ prescaler_init(void)
 }
 DECL_INIT(prescaler_init);
 
+// Configure the "idle" sleep mode used by irq_wait()
+void
+sleep_init(void)
+{
+    if (CONFIG_AVR_SLEEP_ON_IDLE) {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_enable();
+    }
+}
+DECL_INIT(sleep_init);
+
 // Optimized crc16_ccitt for the avr processor
 uint16_t
 crc16_ccitt(uint8_t *buf, uint_fast8_t len)
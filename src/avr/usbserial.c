@@ -44,8 +44,8 @@ usb_read_packet(uint8_t *data, uint8_t len)
         *data++ = UEDATX;
 }
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     UENUM = USB_CDC_EP_BULK_OUT;
     if (!(UEINTX & (1<<RXOUTI))) {
@@ -59,8 +59,8 @@ usb_read_bulk_out(void *data, uint_fast8_t max_len)
     return len;
 }
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     UENUM = USB_CDC_EP_BULK_IN;
     if (!(UEINTX & (1<<TXINI))) {
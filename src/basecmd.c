@@ -60,11 +60,11 @@ alloc_chunks(size_t size, size_t count, uint16_t *avail)
 
 static struct move_node *move_free_list;
 static void *move_list;
-static uint16_t move_count;
+static uint16_t move_count, move_inuse, move_max_inuse;
 static uint8_t move_item_size;
 
 // Is the config and move queue finalized?
-static int
+int
 is_finalized(void)
 {
     return !!move_count;
@@ -78,6 +78,7 @@ move_free(void *m)
     struct move_node *mf = m;
     mf->next = move_free_list;
     move_free_list = mf;
+    move_inuse--;
 }
 
 // Allocate runtime storage
@@ -89,10 +90,24 @@ move_alloc(void)
     if (!mf)
         shutdown("Move queue overflow");
     move_free_list = mf->next;
+    move_inuse++;
+    if (move_inuse > move_max_inuse)
+        move_max_inuse = move_inuse;
     irq_restore(flag);
     return mf;
 }
 
+// Report (and restart tracking of) the pool occupancy high-water mark
+static uint_fast16_t
+move_get_max_inuse(void)
+{
+    irqstatus_t flag = irq_save();
+    uint_fast16_t res = move_max_inuse;
+    move_max_inuse = move_inuse;
+    irq_restore(flag);
+    return res;
+}
+
 // Check if a move_queue is empty
 int
 move_queue_empty(struct move_queue_head *mh)
@@ -163,6 +178,7 @@ move_reset(void)
     struct move_node *mf = move_list + (move_count - 1)*move_item_size;
     mf->next = NULL;
     move_free_list = move_list;
+    move_inuse = 0;
 }
 DECL_SHUTDOWN(move_reset);
 
@@ -173,7 +189,9 @@ move_finalize(void)
         shutdown("Already finalized");
     struct move_queue_head dummy;
     move_queue_setup(&dummy, sizeof(*move_free_list));
-    move_list = alloc_chunks(move_item_size, 1024, &move_count);
+    // Dedicate all remaining memory to the move pool - the host sizes
+    // its queues from the move_count reported in get_config.
+    move_list = alloc_chunks(move_item_size, UINT16_MAX, &move_count);
     move_reset();
 }
 
@@ -184,6 +202,7 @@ move_finalize(void)
 
 struct oid_s {
     void *type, *data;
+    uint32_t crc;
 };
 
 static struct oid_s *oids;
@@ -257,6 +276,28 @@ command_finalize_config(uint32_t *args)
 }
 DECL_COMMAND(command_finalize_config, "finalize_config crc=%u");
 
+// Store the crc of the config commands associated with one oid (so
+// the host can determine which oids changed after a soft restart)
+void
+command_config_section_crc(uint32_t *args)
+{
+    uint8_t oid = args[0];
+    if (oid >= oid_count || is_finalized())
+        shutdown("Can't assign oid");
+    oids[oid].crc = args[1];
+}
+DECL_COMMAND(command_config_section_crc, "config_section_crc oid=%c crc=%u");
+
+void
+command_get_config_section(uint32_t *args)
+{
+    uint8_t oid = args[0];
+    uint32_t crc = oid < oid_count ? oids[oid].crc : 0;
+    sendf("config_section oid=%c crc=%u", oid, crc);
+}
+DECL_COMMAND_FLAGS(command_get_config_section, HF_IN_SHUTDOWN
+                   , "get_config_section oid=%c");
+
 // Attempt a full manual reset of the config
 void
 config_reset(uint32_t *args)
@@ -269,7 +310,8 @@ config_reset(uint32_t *args)
     oids = NULL;
     move_free_list = NULL;
     move_list = NULL;
-    move_count = move_item_size = 0;
+    move_count = move_inuse = move_max_inuse = 0;
+    move_item_size = 0;
     alloc_init();
     sched_timer_reset();
     sched_clear_shutdown();
@@ -331,7 +373,8 @@ stats_update(uint32_t start, uint32_t cur)
 
     if (!timer_has_elapsed(stats_send_time, cur, timer_from_us(5000000)))
         return;
-    sendf("stats count=%u sum=%u sumsq=%u", count, sum, sumsq);
+    sendf("stats count=%u sum=%u sumsq=%u move_max=%hu"
+          , count, sum, sumsq, move_get_max_inuse());
     if (cur < stats_send_time)
         stats_send_time_high++;
     stats_send_time = cur;
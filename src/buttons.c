@@ -7,6 +7,7 @@
 #include "basecmd.h" // oid_alloc
 #include "board/gpio.h" // struct gpio_in
 #include "board/irq.h" // irq_disable
+#include "board/misc.h" // timer_is_before
 #include "command.h" // DECL_COMMAND
 #include "sched.h" // struct timer
 
@@ -160,4 +161,138 @@ buttons_task(void)
               , oid, b->ack_count, report_count, b->reports);
     }
 }
-DECL_TASK(buttons_task);
+DECL_TASK_WAKE(buttons_task, buttons_wake);
+
+/****************************************************************
+ * Rotary encoders
+ ****************************************************************/
+
+struct rotary_encoder {
+    struct timer time;
+    uint32_t rest_ticks, report_ticks, next_report_time;
+    const uint8_t (*table)[4];
+    struct gpio_in pin_a, pin_b;
+    int16_t count;
+    uint8_t state, invert, flags;
+};
+
+enum { EF_PENDING = 1 };
+enum { ENCODER_DIR_CW = 0x10, ENCODER_DIR_CCW = 0x20,
+       ENCODER_DIR_MASK = 0x30 };
+
+// Quadrature decoder state tables from https://github.com/brianlow/Rotary
+// Copyright 2011 Ben Buxton (bb@cactii.net).  Licenced under the GNU
+// GPL Version 3.
+
+// Full-step table (emits a code at 00 only)
+static const uint8_t encoder_full_step_table[7][4] = {
+    {0, 2, 4, 0},                       // R_START
+    {3, 0, 1, 0 | ENCODER_DIR_CW},      // R_CW_FINAL
+    {3, 2, 0, 0},                       // R_CW_BEGIN
+    {3, 2, 1, 0},                       // R_CW_NEXT
+    {6, 0, 4, 0},                       // R_CCW_BEGIN
+    {6, 5, 0, 0 | ENCODER_DIR_CCW},     // R_CCW_FINAL
+    {6, 5, 4, 0},                       // R_CCW_NEXT
+};
+
+// Half-step table (emits a code at 00 and 11)
+static const uint8_t encoder_half_step_table[6][4] = {
+    {3, 2, 1, 0},                       // R_START
+    {3 | ENCODER_DIR_CCW, 0, 1, 0},     // R_CCW_BEGIN
+    {3 | ENCODER_DIR_CW, 2, 0, 0},      // R_CW_BEGIN
+    {3, 5, 4, 0},                       // R_START_M
+    {3, 3, 4, 0 | ENCODER_DIR_CW},      // R_CW_BEGIN_M
+    {3, 5, 3, 0 | ENCODER_DIR_CCW},     // R_CCW_BEGIN_M
+};
+
+static struct task_wake encoder_wake;
+
+static uint_fast8_t
+encoder_event(struct timer *t)
+{
+    struct rotary_encoder *e = container_of(t, struct rotary_encoder, time);
+
+    // Run the quadrature state machine on the current pin levels
+    uint8_t pins = ((!!gpio_in_read(e->pin_b) << 1)
+                    | !!gpio_in_read(e->pin_a));
+    uint8_t es = e->table[e->state & 0xf][pins ^ e->invert];
+    e->state = es;
+    es &= ENCODER_DIR_MASK;
+    if (es == ENCODER_DIR_CW)
+        e->count++;
+    else if (es == ENCODER_DIR_CCW)
+        e->count--;
+
+    // Report accumulated movement at most once per report interval
+    uint32_t time = e->time.waketime;
+    if (timer_is_before(e->next_report_time, time)) {
+        e->next_report_time = time + e->report_ticks;
+        if (e->count) {
+            e->flags |= EF_PENDING;
+            sched_wake_task(&encoder_wake);
+        }
+    }
+
+    e->time.waketime += e->rest_ticks;
+    return SF_RESCHEDULE;
+}
+
+void
+command_config_encoder(uint32_t *args)
+{
+    struct rotary_encoder *e = oid_alloc(args[0], command_config_encoder
+                                         , sizeof(*e));
+    e->pin_a = gpio_in_setup(args[1], args[2]);
+    e->pin_b = gpio_in_setup(args[3], args[4]);
+    e->invert = args[5] & 0x03;
+    uint8_t steps_per_detent = args[6];
+    if (steps_per_detent == 4)
+        e->table = encoder_full_step_table;
+    else if (steps_per_detent == 2)
+        e->table = encoder_half_step_table;
+    else
+        shutdown("Invalid encoder steps_per_detent");
+    e->time.func = encoder_event;
+}
+DECL_COMMAND(command_config_encoder,
+             "config_encoder oid=%c pin_a=%u pull_up_a=%c pin_b=%u"
+             " pull_up_b=%c invert=%c steps_per_detent=%c");
+
+void
+command_encoder_query(uint32_t *args)
+{
+    struct rotary_encoder *e = oid_lookup(args[0], command_config_encoder);
+    sched_del_timer(&e->time);
+    e->time.waketime = args[1];
+    e->rest_ticks = args[2];
+    e->report_ticks = args[3];
+    e->next_report_time = e->time.waketime;
+    e->count = 0;
+    e->state = 0;
+    e->flags = 0;
+    if (! e->rest_ticks)
+        return;
+    sched_add_timer(&e->time);
+}
+DECL_COMMAND(command_encoder_query,
+             "encoder_query oid=%c clock=%u rest_ticks=%u report_ticks=%u");
+
+void
+encoder_task(void)
+{
+    if (!sched_check_wake(&encoder_wake))
+        return;
+    uint8_t oid;
+    struct rotary_encoder *e;
+    foreach_oid(oid, e, command_config_encoder) {
+        if (!(e->flags & EF_PENDING))
+            continue;
+        irq_disable();
+        int_fast16_t count = e->count;
+        e->count = 0;
+        e->flags &= ~EF_PENDING;
+        irq_enable();
+        sendf("encoder_state oid=%c count=%hi", oid, count);
+    }
+}
+DECL_TASK_WAKE(encoder_task, encoder_wake);
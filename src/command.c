@@ -37,8 +37,8 @@ command_decode_ptr(uint32_t v)
  ****************************************************************/
 
 // Encode an integer as a variable length quantity (vlq)
-static uint8_t *
-encode_int(uint8_t *p, uint32_t v)
+uint8_t *
+command_encode_int(uint8_t *p, uint32_t v)
 {
     int32_t sv = v;
     if (sv < (3L<<5)  && sv >= -(1L<<5))  goto f4;
@@ -54,8 +54,8 @@ f4: *p++ = v & 0x7f;
 }
 
 // Parse an integer that was encoded as a "variable length quantity"
-static uint32_t
-parse_int(uint8_t **pp)
+uint32_t
+command_parse_int(uint8_t **pp)
 {
     uint8_t *p = *pp, c = *p++;
     uint32_t v = c & 0x7f;
@@ -109,7 +109,7 @@ command_parsef(uint8_t *p, uint8_t *maxend
         case PT_uint16:
         case PT_int16:
         case PT_byte:
-            *args++ = parse_int(&p);
+            *args++ = command_parse_int(&p);
             break;
         case PT_buffer: {
             uint_fast8_t len = *p++;
@@ -137,6 +137,12 @@ command_encodef(uint8_t *buf, const struct command_encoder *ce, va_list args)
     if (max_size <= MESSAGE_MIN)
         // Ack/Nak message
         return max_size;
+#if CONFIG_WANT_FAST_ENCODERS
+    // Use generated straight-line encoder (if available)
+    uint_fast8_t (*efunc)(uint8_t *, va_list) = READP(ce->encode_func);
+    if (efunc)
+        return efunc(buf, args);
+#endif
     uint8_t *p = &buf[MESSAGE_HEADER_SIZE];
     uint8_t *maxend = &p[max_size - MESSAGE_MIN];
     uint_fast8_t num_params = READP(ce->num_params);
@@ -161,7 +167,7 @@ command_encodef(uint8_t *buf, const struct command_encoder *ce, va_list args)
                     v = va_arg(args, unsigned int);
             else
                 v = va_arg(args, uint32_t);
-            p = encode_int(p, v);
+            p = command_encode_int(p, v);
             break;
         case PT_string: {
             uint8_t *s = va_arg(args, uint8_t*), *lenp = p++;
@@ -253,7 +259,12 @@ command_lookup_parser(uint_fast16_t cmdid)
 {
     if (!cmdid || cmdid >= READP(command_index_size))
         shutdown("Invalid command");
-    return &command_index[cmdid];
+    // The command index is a dense table indexed by msgid - msgids
+    // assigned to responses appear as empty (func-less) entries
+    const struct command_parser *cp = &command_index[cmdid];
+    if (!READP(cp->func))
+        shutdown("Invalid command");
+    return cp;
 }
 
 // Empty message (for ack/nak transmission)
@@ -4,6 +4,7 @@
 #include <stdarg.h> // va_list
 #include <stddef.h>
 #include <stdint.h> // uint8_t
+#include "autoconf.h" // CONFIG_WANT_FAST_ENCODERS
 #include "ctr.h" // DECL_CTR
 
 // Declare a function to run when the specified command is received
@@ -60,6 +61,10 @@ struct command_encoder {
     uint16_t encoded_msgid;
     uint8_t max_size, num_params;
     const uint8_t *param_types;
+#if CONFIG_WANT_FAST_ENCODERS
+    // Generated straight-line encoder (NULL if not available)
+    uint_fast8_t (*encode_func)(uint8_t *buf, va_list args);
+#endif
 };
 struct command_parser {
     uint16_t encoded_msgid;
@@ -74,6 +79,8 @@ enum {
 
 // command.c
 void *command_decode_ptr(uint32_t v);
+uint8_t *command_encode_int(uint8_t *p, uint32_t v);
+uint32_t command_parse_int(uint8_t **pp);
 uint_fast16_t command_parse_msgid(uint8_t **pp);
 uint8_t *command_parsef(uint8_t *p, uint8_t *maxend
                         , const struct command_parser *cp, uint32_t *args);
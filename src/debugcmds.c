@@ -4,9 +4,13 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include "autoconf.h" // CONFIG_HAVE_GPIO
 #include "board/io.h" // readl
 #include "board/irq.h" // irq_save
+#include "board/misc.h" // timer_read_time
 #include "command.h" // DECL_COMMAND
+#include "sched.h" // DECL_TASK
+#include "stepper.h" // stepper_queue_step
 
 void
 command_debug_read(uint32_t *args)
@@ -57,3 +61,117 @@ command_debug_nop(uint32_t *args)
 {
 }
 DECL_COMMAND_FLAGS(command_debug_nop, HF_IN_SHUTDOWN, "debug_nop");
+
+
+/****************************************************************
+ * Step rate benchmark
+ ****************************************************************/
+
+#if CONFIG_HAVE_GPIO
+
+#define BENCH_MAX_STEPPERS 8
+
+static struct {
+    struct stepper *steppers[BENCH_MAX_STEPPERS];
+    uint32_t interval, chunks, queued_chunks, queue_end_time;
+    int32_t min_margin, avg_margin;
+    uint16_t count, margin_samples;
+    uint8_t num_steppers, active;
+} step_bench;
+
+// Queue one "chunk" of steps on each benchmarked stepper
+static void
+step_bench_queue_chunk(void)
+{
+    // Alternate the step direction so net movement stays bounded
+    uint_fast8_t dir = step_bench.queued_chunks & 1, i;
+    for (i=0; i<step_bench.num_steppers; i++) {
+        struct stepper *s = step_bench.steppers[i];
+        stepper_set_next_step_dir(s, dir);
+        stepper_queue_step(s, step_bench.interval, step_bench.count, 0);
+    }
+    step_bench.queued_chunks++;
+    step_bench.queue_end_time += (step_bench.interval
+                                  * (uint32_t)step_bench.count);
+}
+
+// Start a step rate benchmark on steppers at oids 0 to oid_count-1
+void
+command_start_step_benchmark(uint32_t *args)
+{
+    if (step_bench.active)
+        shutdown("Step benchmark already running");
+    uint_fast8_t num = args[0], i;
+    if (!num || num > BENCH_MAX_STEPPERS)
+        shutdown("Invalid step benchmark stepper count");
+    step_bench.interval = args[1];
+    step_bench.count = args[2];
+    step_bench.chunks = args[3];
+    if (!step_bench.count || step_bench.chunks < 2)
+        shutdown("Invalid count parameter");
+    uint32_t start = timer_read_time() + timer_from_us(5000);
+    step_bench.num_steppers = num;
+    step_bench.queued_chunks = 0;
+    step_bench.queue_end_time = start;
+    step_bench.min_margin = 0x7fffffff;
+    step_bench.avg_margin = 0;
+    step_bench.margin_samples = 0;
+    for (i=0; i<num; i++) {
+        struct stepper *s = stepper_oid_lookup(i);
+        step_bench.steppers[i] = s;
+        stepper_reset_step_clock(s, start);
+    }
+    // Queue two chunks upfront - the task then tops up one at a time
+    step_bench_queue_chunk();
+    step_bench_queue_chunk();
+    step_bench.active = 1;
+}
+DECL_COMMAND(command_start_step_benchmark,
+             "start_step_benchmark oid_count=%c interval=%u count=%hu"
+             " chunks=%u");
+
+// Top up the benchmark step queues and collect scheduling margins
+void
+step_benchmark_task(void)
+{
+    if (!step_bench.active)
+        return;
+    uint32_t now = timer_read_time();
+    int32_t margin = step_bench.queue_end_time - now;
+    if (step_bench.queued_chunks >= step_bench.chunks) {
+        if (margin > 0)
+            // Final steps still being executed
+            return;
+        step_bench.active = 0;
+        sendf("step_benchmark_result steps=%u min_margin=%i avg_margin=%i"
+              " samples=%hu"
+              , step_bench.chunks * (uint32_t)step_bench.count
+              , step_bench.min_margin, step_bench.avg_margin
+              , step_bench.margin_samples);
+        return;
+    }
+    if (margin > (int32_t)(step_bench.interval * (uint32_t)step_bench.count))
+        // More than a full chunk of steps still queued
+        return;
+    step_bench_queue_chunk();
+    // The margin is the amount of queued work (in clock ticks)
+    // remaining when the dispatch loop managed to run this refill - it
+    // shrinks as timer irqs starve the main processing loop
+    if (margin < step_bench.min_margin)
+        step_bench.min_margin = margin;
+    if (!step_bench.margin_samples)
+        step_bench.avg_margin = margin;
+    else
+        step_bench.avg_margin += (margin - step_bench.avg_margin) / 8;
+    step_bench.margin_samples++;
+}
+DECL_TASK(step_benchmark_task);
+
+void
+step_benchmark_shutdown(void)
+{
+    step_bench.active = 0;
+}
+DECL_SHUTDOWN(step_benchmark_shutdown);
+
+#endif // CONFIG_HAVE_GPIO
@@ -7,6 +7,7 @@
 #include "basecmd.h" // oid_alloc
 #include "board/gpio.h" // struct gpio
 #include "board/irq.h" // irq_disable
+#include "board/misc.h" // timer_read_time
 #include "command.h" // DECL_COMMAND
 #include "sched.h" // struct timer
 #include "trsync.h" // trsync_do_trigger
@@ -14,7 +15,7 @@
 struct endstop {
     struct timer time;
     struct gpio_in pin;
-    uint32_t rest_time, sample_time, nextwake;
+    uint32_t rest_time, sample_time, nextwake, trigger_clock;
     struct trsync *ts;
     uint8_t flags, sample_count, trigger_count, trigger_reason;
 };
@@ -35,6 +36,8 @@ endstop_event(struct timer *t)
         e->time.waketime = nextwake;
         return SF_RESCHEDULE;
     }
+    // Latch the clock of the first matching sample read
+    e->trigger_clock = timer_read_time();
     e->nextwake = nextwake;
     e->time.func = endstop_oversample_event;
     return endstop_oversample_event(t);
@@ -106,10 +109,12 @@ command_endstop_query_state(uint32_t *args)
 
     irq_disable();
     uint8_t eflags = e->flags;
-    uint32_t nextwake = e->nextwake;
+    uint32_t nextwake = e->nextwake, trigger_clock = e->trigger_clock;
     irq_enable();
 
     sendf("endstop_state oid=%c homing=%c next_clock=%u pin_value=%c"
-          , oid, !!(eflags & ESF_HOMING), nextwake, gpio_in_read(e->pin));
+          " trigger_clock=%u"
+          , oid, !!(eflags & ESF_HOMING), nextwake, gpio_in_read(e->pin)
+          , trigger_clock);
 }
 DECL_COMMAND(command_endstop_query_state, "endstop_query_state oid=%c");
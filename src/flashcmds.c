@@ -0,0 +1,83 @@
+// Commands for streaming new firmware to an inactive flash bank
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "board/flash_bank.h" // flash_bank_size
+#include "command.h" // DECL_COMMAND_FLAGS
+#include "sched.h" // shutdown
+
+// The commands in this file allow a host to stream a firmware image
+// to the flash bank that the mcu is not currently executing from,
+// verify the written image, and then swap the active bank with a
+// quick reset.  All offsets are relative to the start of the inactive
+// bank - the running image can not be overwritten.
+
+void
+command_flash_bank_query(uint32_t *args)
+{
+    sendf("flash_bank_state active=%c size=%u block=%u"
+          , flash_bank_active(), flash_bank_size(), flash_bank_block_size());
+}
+DECL_COMMAND_FLAGS(command_flash_bank_query, HF_IN_SHUTDOWN
+                   , "flash_bank_query");
+
+void
+command_flash_bank_erase(uint32_t *args)
+{
+    uint32_t offset = args[0];
+    if (offset >= flash_bank_size())
+        shutdown("Invalid flash bank offset");
+    flash_bank_erase_sector(offset);
+    sendf("flash_bank_erase_done offset=%u", offset);
+}
+DECL_COMMAND_FLAGS(command_flash_bank_erase, HF_IN_SHUTDOWN
+                   , "flash_bank_erase offset=%u");
+
+void
+command_flash_bank_write(uint32_t *args)
+{
+    uint32_t offset = args[0], len = args[1];
+    uint8_t *data = command_decode_ptr(args[2]);
+    uint32_t block = flash_bank_block_size();
+    if (len != block || offset % block || offset >= flash_bank_size())
+        shutdown("Invalid flash bank write");
+    flash_bank_write_block(offset, data);
+    sendf("flash_bank_write_done offset=%u", offset);
+}
+DECL_COMMAND_FLAGS(command_flash_bank_write, HF_IN_SHUTDOWN
+                   , "flash_bank_write offset=%u data=%*s");
+
+// Incremental variant of the crc16_ccitt algorithm
+static uint16_t
+crc16_ccitt_update(uint16_t crc, uint8_t data)
+{
+    data ^= crc & 0xff;
+    data ^= data << 4;
+    return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4)
+            ^ ((uint16_t)data << 3));
+}
+
+void
+command_flash_bank_crc(uint32_t *args)
+{
+    uint32_t offset = args[0], count = args[1];
+    if (offset + count > flash_bank_size() || offset + count < offset)
+        shutdown("Invalid flash bank offset");
+    const uint8_t *data = flash_bank_inactive_base() + offset;
+    uint16_t crc = 0xffff;
+    while (count--)
+        crc = crc16_ccitt_update(crc, *data++);
+    sendf("flash_bank_crc_result offset=%u crc=%u", args[0], crc);
+}
+DECL_COMMAND_FLAGS(command_flash_bank_crc, HF_IN_SHUTDOWN
+                   , "flash_bank_crc offset=%u count=%u");
+
+void
+command_flash_bank_swap(uint32_t *args)
+{
+    flash_bank_swap();
+}
+DECL_COMMAND_FLAGS(command_flash_bank_swap, HF_IN_SHUTDOWN
+                   , "flash_bank_swap");
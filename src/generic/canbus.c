@@ -10,6 +10,30 @@
 #include "command.h" // DECL_CONSTANT
 
 DECL_CONSTANT("CANBUS_FREQUENCY", CONFIG_CANBUS_FREQUENCY);
+#if CONFIG_CANBUS_FD
+DECL_CONSTANT("CANBUS_FD_DATA_FREQUENCY", CONFIG_CANBUS_FD_DATA_FREQUENCY);
+#endif
+
+// Convert a CAN "data length code" to the frame data size
+uint32_t
+canbus_dlc2len(uint32_t dlc)
+{
+    static const uint8_t dlc2len[16] = {
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+    return dlc2len[dlc & 0x0f];
+}
+
+// Convert an exact CAN-FD frame data size to its "data length code"
+uint32_t
+canbus_len2dlc(uint32_t len)
+{
+    if (len <= 8)
+        return len;
+    uint32_t dlc = 8;
+    while (dlc < 15 && canbus_dlc2len(dlc + 1) <= len)
+        dlc++;
+    return dlc;
+}
 
 int
 canbus_send(struct canbus_msg *msg)
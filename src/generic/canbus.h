@@ -2,20 +2,31 @@
 #define __CANBUS_H__
 
 #include <stdint.h> // uint32_t
+#include "autoconf.h" // CONFIG_CANBUS_FD
+
+#if CONFIG_CANBUS_FD
+#define CANMSG_DATA_MAX 64
+#else
+#define CANMSG_DATA_MAX 8
+#endif
 
 struct canbus_msg {
     uint32_t id;
     uint32_t dlc;
     union {
-        uint8_t data[8];
-        uint32_t data32[2];
+        uint8_t data[CANMSG_DATA_MAX];
+        uint32_t data32[CANMSG_DATA_MAX / 4];
     };
 };
 
 #define CANMSG_ID_RTR (1<<30)
 #define CANMSG_ID_EFF (1<<31)
 
+#if CONFIG_CANBUS_FD
+#define CANMSG_DATA_LEN(msg) canbus_dlc2len((msg)->dlc)
+#else
 #define CANMSG_DATA_LEN(msg) ((msg)->dlc > 8 ? 8 : (msg)->dlc)
+#endif
 
 struct canbus_status {
     uint32_t rx_error, tx_error, tx_retries;
@@ -33,6 +44,8 @@ void canhw_set_filter(uint32_t id);
 void canhw_get_status(struct canbus_status *status);
 
 // canbus.c
+uint32_t canbus_dlc2len(uint32_t dlc);
+uint32_t canbus_len2dlc(uint32_t len);
 int canbus_send(struct canbus_msg *msg);
 void canbus_set_filter(uint32_t id);
 void canbus_notify_tx(void);
@@ -27,6 +27,7 @@ static struct canbus_data {
     // Tx data
     struct task_wake tx_wake;
     uint8_t transmit_pos, transmit_max;
+    const struct command_encoder *bulk_encoder;
 
     // Rx data
     struct task_wake rx_wake;
@@ -35,10 +36,15 @@ static struct canbus_data {
 
     // Transfer buffers
     struct canbus_msg admin_queue[8];
-    uint8_t transmit_buf[96];
+    uint8_t transmit_buf[192];
     uint8_t receive_buf[192];
 } CanData;
 
+// Tail bytes of the transmit buffer that bulk sensor telemetry may
+// not use - latency critical responses (eg, trsync state during
+// probing) always find space even when telemetry saturates the buffer
+#define TRANSMIT_RESERVE 32
+
 
 /****************************************************************
  * Data transmission over CAN
@@ -50,6 +56,17 @@ canserial_notify_tx(void)
     sched_wake_task(&CanData.tx_wake);
 }
 
+// Choose the largest frame size that can be completely filled (CAN-FD
+// frames have a fixed set of valid sizes and padding bytes would
+// corrupt the serial stream framing)
+static int
+can_frame_size(int avail)
+{
+    if (!CONFIG_CANBUS_FD || avail <= 8)
+        return avail > 8 ? 8 : avail;
+    return canbus_dlc2len(canbus_len2dlc(avail));
+}
+
 void
 canserial_tx_task(void)
 {
@@ -64,10 +81,10 @@ canserial_tx_task(void)
     msg.id = id + 1;
     uint32_t tpos = CanData.transmit_pos, tmax = CanData.transmit_max;
     for (;;) {
-        int avail = tmax - tpos, now = avail > 8 ? 8 : avail;
+        int avail = tmax - tpos, now = can_frame_size(avail);
         if (avail <= 0)
             break;
-        msg.dlc = now;
+        msg.dlc = canbus_len2dlc(now);
         memcpy(msg.data, &CanData.transmit_buf[tpos], now);
         int ret = canbus_send(&msg);
         if (ret <= 0)
@@ -76,7 +93,7 @@ canserial_tx_task(void)
     }
     CanData.transmit_pos = tpos;
 }
-DECL_TASK(canserial_tx_task);
+DECL_TASK_WAKE(canserial_tx_task, CanData.tx_wake);
 
 // Encode and transmit a "response" message
 void
@@ -87,8 +104,11 @@ console_sendf(const struct command_encoder *ce, va_list args)
     if (tpos >= tmax)
         CanData.transmit_pos = CanData.transmit_max = tpos = tmax = 0;
     uint32_t max_size = ce->max_size;
-    if (tmax + max_size > sizeof(CanData.transmit_buf)) {
-        if (tmax + max_size - tpos > sizeof(CanData.transmit_buf))
+    uint32_t limit = sizeof(CanData.transmit_buf);
+    if (ce == CanData.bulk_encoder)
+        limit -= TRANSMIT_RESERVE;
+    if (tmax + max_size > limit) {
+        if (tmax + max_size - tpos > limit)
             // Not enough space for message
             return;
         // Move buffer
@@ -311,7 +331,7 @@ canserial_rx_task(void)
             command_send_ack();
     }
 }
-DECL_TASK(canserial_rx_task);
+DECL_TASK_WAKE(canserial_rx_task, CanData.rx_wake);
 
 
 /****************************************************************
@@ -345,6 +365,16 @@ command_get_canbus_id(uint32_t *args)
 }
 DECL_COMMAND_FLAGS(command_get_canbus_id, HF_IN_SHUTDOWN, "get_canbus_id");
 
+void
+canserial_init(void)
+{
+    // Identify bulk sensor telemetry so it can be held to the
+    // non-reserved part of the transmit buffer
+    CanData.bulk_encoder = _DECL_ENCODER(
+        "sensor_bulk_data oid=%c sequence=%hu data=%*s");
+}
+DECL_INIT(canserial_init);
+
 void
 canserial_set_uuid(uint8_t *raw_uuid, uint32_t raw_uuid_len)
 {
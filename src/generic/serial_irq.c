@@ -34,6 +34,20 @@ serial_rx_byte(uint_fast8_t data)
     receive_buf[receive_pos++] = data;
 }
 
+// Store a block of read data (from a fifo or dma based backend)
+void
+serial_rx_data(uint8_t *data, uint_fast8_t len)
+{
+    if (memchr(data, MESSAGE_SYNC, len))
+        sched_wake_tasks();
+    uint_fast8_t rpos = receive_pos;
+    if (rpos + len > sizeof(receive_buf))
+        // Serial overflow - ignore it as crc error will force retransmit
+        len = sizeof(receive_buf) - rpos;
+    memcpy(&receive_buf[rpos], data, len);
+    receive_pos = rpos + len;
+}
+
 // Tx interrupt - get next byte to transmit
 int
 serial_get_tx_byte(uint8_t *pdata)
@@ -8,6 +8,7 @@ void serial_enable_tx_irq(void);
 
 // serial_irq.c
 void serial_rx_byte(uint_fast8_t data);
+void serial_rx_data(uint8_t *data, uint_fast8_t len);
 int serial_get_tx_byte(uint8_t *pdata);
 
 #endif // serial_irq.h
@@ -82,6 +82,19 @@ struct gs_device_mode {
     uint32_t flags;
 } __packed;
 
+// Klipper specific extension - pack multiple frames into each USB
+// packet sent to the host.  Advertised via the bt_const feature mask
+// and enabled by the host with a device mode flag; hosts that do not
+// request it receive the standard one frame per packet.
+#define GS_CAN_FEATURE_KLIPPER_BATCH_FRAMES (1<<31)
+#define GS_CAN_MODE_KLIPPER_BATCH_FRAMES    (1<<31)
+
+// Maximum number of gs_usb frames that fit in a single USB packet
+#define FRAMES_PER_IN_PACKET                                    \
+    (USB_CDC_EP_BULK_IN_SIZE / sizeof(struct gs_host_frame))
+#define FRAMES_PER_OUT_PACKET                                   \
+    (USB_CDC_EP_BULK_OUT_SIZE / sizeof(struct gs_host_frame))
+
 struct gs_host_frame {
     uint32_t echo_id;
     uint32_t can_id;
@@ -134,16 +147,26 @@ enum {
     HS_TX_LOCAL = 4,
 };
 
+extern struct gs_device_mode device_mode;
+
+// Fill a gs_usb frame from a canbus message
+static void
+fill_frame(struct gs_host_frame *gs, struct canbus_msg *msg)
+{
+    memset(gs, 0, sizeof(*gs));
+    gs->echo_id = 0xffffffff;
+    gs->can_id = msg->id;
+    gs->can_dlc = msg->dlc;
+    gs->data32[0] = msg->data32[0];
+    gs->data32[1] = msg->data32[1];
+}
+
 // Send a message to the Linux host
 static int
 send_frame(struct canbus_msg *msg)
 {
-    struct gs_host_frame gs = {};
-    gs.echo_id = 0xffffffff;
-    gs.can_id = msg->id;
-    gs.can_dlc = msg->dlc;
-    gs.data32[0] = msg->data32[0];
-    gs.data32[1] = msg->data32[1];
+    struct gs_host_frame gs;
+    fill_frame(&gs, msg);
     return usb_send_bulk_in(&gs, sizeof(gs));
 }
 
@@ -152,21 +175,33 @@ static void
 drain_canhw_queue(void)
 {
     uint32_t pull_pos = UsbCan.canhw_pull_pos;
+    uint32_t max_frames = 1;
+    if (device_mode.flags & GS_CAN_MODE_KLIPPER_BATCH_FRAMES)
+        // Host supports multiple frames per USB packet
+        max_frames = FRAMES_PER_IN_PACKET;
     for (;;) {
         uint32_t push_pos = readl(&UsbCan.canhw_push_pos);
-        if (push_pos == pull_pos) {
+        uint32_t count = push_pos - pull_pos;
+        if (!count) {
             // No more data to send
             UsbCan.usb_send_busy = 0;
             return;
         }
-        uint32_t pos = pull_pos % ARRAY_SIZE(UsbCan.canhw_queue);
-        int ret = send_frame(&UsbCan.canhw_queue[pos]);
+        if (count > max_frames)
+            count = max_frames;
+        struct gs_host_frame frames[FRAMES_PER_IN_PACKET];
+        uint32_t i;
+        for (i = 0; i < count; i++) {
+            uint32_t pos = (pull_pos + i) % ARRAY_SIZE(UsbCan.canhw_queue);
+            fill_frame(&frames[i], &UsbCan.canhw_queue[pos]);
+        }
+        int ret = usb_send_bulk_in(frames, count * sizeof(frames[0]));
         if (ret < 0) {
             // USB is busy - retry later
             UsbCan.usb_send_busy = 1;
             return;
         }
-        UsbCan.canhw_pull_pos = pull_pos = pull_pos + 1;
+        UsbCan.canhw_pull_pos = pull_pos = pull_pos + count;
     }
 }
 
@@ -176,16 +211,23 @@ drain_usb_host_messages(void)
 {
     uint32_t pull_pos = UsbCan.host_pull_pos, push_pos = UsbCan.host_push_pos;
     for (;;) {
-        if (push_pos - pull_pos >= ARRAY_SIZE(UsbCan.host_frames))
-            // No more space in queue
+        if (ARRAY_SIZE(UsbCan.host_frames) - (push_pos - pull_pos)
+            < FRAMES_PER_OUT_PACKET)
+            // Not enough space for a full packet of frames
             break;
-        uint32_t pushp = push_pos % ARRAY_SIZE(UsbCan.host_frames);
-        struct gs_host_frame *gs = &UsbCan.host_frames[pushp];
-        int ret = usb_read_bulk_out(gs, sizeof(*gs));
+        uint8_t packet[USB_CDC_EP_BULK_OUT_SIZE];
+        int ret = usb_read_bulk_out(packet, sizeof(packet));
         if (ret <= 0)
             // No more messages ready
             break;
-        UsbCan.host_push_pos = push_pos = push_pos + 1;
+        uint32_t i, count = ret / sizeof(struct gs_host_frame);
+        for (i = 0; i < count; i++) {
+            uint32_t pushp = push_pos % ARRAY_SIZE(UsbCan.host_frames);
+            memcpy(&UsbCan.host_frames[pushp]
+                   , &packet[i * sizeof(struct gs_host_frame)]
+                   , sizeof(struct gs_host_frame));
+            UsbCan.host_push_pos = push_pos = push_pos + 1;
+        }
     }
 }
 
@@ -689,7 +731,7 @@ gs_breq_device_config(struct usb_ctrlrequest *req)
 
 static const struct gs_device_bt_const bt_const PROGMEM = {
     // These are just dummy values for now
-    .feature = 0,
+    .feature = GS_CAN_FEATURE_KLIPPER_BATCH_FRAMES,
     .fclk_can = 48000000,
     .tseg1_min = 1,
     .tseg1_max = 16,
@@ -31,7 +31,13 @@
  ****************************************************************/
 
 static struct task_wake usb_bulk_in_wake;
+#if CONFIG_USB_HIGHSPEED
+// High-speed bulk endpoints are 512 bytes - buffer several packets
+static uint8_t transmit_buf[3 * USB_CDC_EP_BULK_IN_SIZE];
+static uint16_t transmit_pos;
+#else
 static uint8_t transmit_buf[192], transmit_pos;
+#endif
 
 void
 usb_notify_bulk_in(void)
@@ -44,31 +50,33 @@ usb_bulk_in_task(void)
 {
     if (!sched_check_wake(&usb_bulk_in_wake))
         return;
-    uint_fast8_t tpos = transmit_pos, max_tpos = tpos;
-    if (!tpos)
-        return;
-    if (max_tpos > USB_CDC_EP_BULK_IN_SIZE)
-        max_tpos = USB_CDC_EP_BULK_IN_SIZE;
-    else if (max_tpos == USB_CDC_EP_BULK_IN_SIZE)
-        max_tpos = USB_CDC_EP_BULK_IN_SIZE-1; // Avoid zero-length-packets
-    int_fast8_t ret = usb_send_bulk_in(transmit_buf, max_tpos);
-    if (ret <= 0)
-        return;
-    uint_fast8_t needcopy = tpos - ret;
-    if (needcopy) {
-        memmove(transmit_buf, &transmit_buf[ret], needcopy);
-        usb_notify_bulk_in();
+    // Fill as many hardware buffers as the endpoint will accept
+    for (;;) {
+        uint_fast16_t tpos = transmit_pos, max_tpos = tpos;
+        if (!tpos)
+            return;
+        if (max_tpos > USB_CDC_EP_BULK_IN_SIZE)
+            max_tpos = USB_CDC_EP_BULK_IN_SIZE;
+        else if (max_tpos == USB_CDC_EP_BULK_IN_SIZE)
+            max_tpos = USB_CDC_EP_BULK_IN_SIZE-1; // Avoid zero-length-packets
+        int_fast16_t ret = usb_send_bulk_in(transmit_buf, max_tpos);
+        if (ret <= 0)
+            // Controller busy - wait for transmit complete irq
+            return;
+        uint_fast16_t needcopy = tpos - ret;
+        if (needcopy)
+            memmove(transmit_buf, &transmit_buf[ret], needcopy);
+        transmit_pos = needcopy;
     }
-    transmit_pos = needcopy;
 }
-DECL_TASK(usb_bulk_in_task);
+DECL_TASK_WAKE(usb_bulk_in_task, usb_bulk_in_wake);
 
 // Encode and transmit a "response" message
 void
 console_sendf(const struct command_encoder *ce, va_list args)
 {
     // Verify space for message
-    uint_fast8_t tpos = transmit_pos, max_size = READP(ce->max_size);
+    uint_fast16_t tpos = transmit_pos, max_size = READP(ce->max_size);
     if (tpos + max_size > sizeof(transmit_buf))
         // Not enough space for message
         return;
@@ -88,7 +96,12 @@ console_sendf(const struct command_encoder *ce, va_list args)
  ****************************************************************/
 
 static struct task_wake usb_bulk_out_wake;
+#if CONFIG_USB_HIGHSPEED
+static uint8_t receive_buf[2 * USB_CDC_EP_BULK_OUT_SIZE];
+static uint16_t receive_pos;
+#else
 static uint8_t receive_buf[128], receive_pos;
+#endif
 
 void
 usb_notify_bulk_out(void)
@@ -101,23 +114,25 @@ usb_bulk_out_task(void)
 {
     if (!sched_check_wake(&usb_bulk_out_wake))
         return;
-    // Read data
-    uint_fast8_t rpos = receive_pos, pop_count;
-    if (rpos + USB_CDC_EP_BULK_OUT_SIZE <= sizeof(receive_buf)) {
-        int_fast8_t ret = usb_read_bulk_out(
+    // Read as many packets as the buffer can hold
+    uint_fast16_t rpos = receive_pos;
+    uint_fast8_t pop_count;
+    while (rpos + USB_CDC_EP_BULK_OUT_SIZE <= sizeof(receive_buf)) {
+        int_fast16_t ret = usb_read_bulk_out(
             &receive_buf[rpos], USB_CDC_EP_BULK_OUT_SIZE);
-        if (ret > 0) {
-            rpos += ret;
-            usb_notify_bulk_out();
-        }
-    } else {
+        if (ret <= 0)
+            break;
+        rpos += ret;
         usb_notify_bulk_out();
     }
+    if (rpos + USB_CDC_EP_BULK_OUT_SIZE > sizeof(receive_buf))
+        // Buffer full - retry after dispatching a message block
+        usb_notify_bulk_out();
     // Process a message block
     int_fast8_t ret = command_find_and_dispatch(receive_buf, rpos, &pop_count);
     if (ret) {
         // Move buffer
-        uint_fast8_t needcopy = rpos - pop_count;
+        uint_fast16_t needcopy = rpos - pop_count;
         if (needcopy) {
             memmove(receive_buf, &receive_buf[pop_count], needcopy);
             usb_notify_bulk_out();
@@ -126,7 +141,7 @@ usb_bulk_out_task(void)
     }
     receive_pos = rpos;
 }
-DECL_TASK(usb_bulk_out_task);
+DECL_TASK_WAKE(usb_bulk_out_task, usb_bulk_out_wake);
 
 
 /****************************************************************
@@ -250,7 +265,8 @@ static const struct config_s {
         .bEndpointAddress = USB_CDC_EP_ACM | USB_DIR_IN,
         .bmAttributes = USB_ENDPOINT_XFER_INT,
         .wMaxPacketSize = cpu_to_le16(USB_CDC_EP_ACM_SIZE),
-        .bInterval = 255,
+        // High-speed interrupt intervals are in 2**(n-1) microframes
+        .bInterval = CONFIG_USB_HIGHSPEED ? 11 : 255,
     },
     .iface1 = {
         .bLength = sizeof(cdc_config_descriptor.iface1),
@@ -275,6 +291,19 @@ static const struct config_s {
     },
 };
 
+#if CONFIG_USB_HIGHSPEED
+// Device qualifier descriptor (required from high-speed capable devices)
+static const struct usb_device_qualifier_descriptor
+cdc_qualifier_descriptor PROGMEM = {
+    .bLength = sizeof(cdc_qualifier_descriptor),
+    .bDescriptorType = USB_DT_DEVICE_QUALIFIER,
+    .bcdUSB = cpu_to_le16(0x0200),
+    .bDeviceClass = USB_CLASS_COMM,
+    .bMaxPacketSize0 = USB_CDC_EP0_SIZE,
+    .bNumConfigurations = 1,
+};
+#endif
+
 // List of available descriptors
 static const struct descriptor_s {
     uint_fast16_t wValue;
@@ -286,6 +315,10 @@ static const struct descriptor_s {
       &cdc_device_descriptor, sizeof(cdc_device_descriptor) },
     { USB_DT_CONFIG<<8, 0x0000,
       &cdc_config_descriptor, sizeof(cdc_config_descriptor) },
+#if CONFIG_USB_HIGHSPEED
+    { USB_DT_DEVICE_QUALIFIER<<8, 0x0000,
+      &cdc_qualifier_descriptor, sizeof(cdc_qualifier_descriptor) },
+#endif
     { USB_DT_STRING<<8, 0x0000,
       &cdc_string_langids, SIZE_cdc_string_langids },
     { (USB_DT_STRING<<8) | USB_STR_ID_MANUFACTURER, USB_LANGID_ENGLISH_US,
@@ -527,7 +560,7 @@ usb_ep0_task(void)
     else
         usb_state_ready();
 }
-DECL_TASK(usb_ep0_task);
+DECL_TASK_WAKE(usb_ep0_task, usb_ep0_wake);
 
 void
 usb_shutdown(void)
@@ -4,8 +4,8 @@
 #include <stdint.h> // uint_fast8_t
 
 // callbacks provided by board specific code
-int_fast8_t usb_read_bulk_out(void *data, uint_fast8_t max_len);
-int_fast8_t usb_send_bulk_in(void *data, uint_fast8_t len);
+int_fast16_t usb_read_bulk_out(void *data, uint_fast16_t max_len);
+int_fast16_t usb_send_bulk_in(void *data, uint_fast16_t len);
 int_fast8_t usb_read_ep0(void *data, uint_fast8_t max_len);
 int_fast8_t usb_read_ep0_setup(void *data, uint_fast8_t max_len);
 int_fast8_t usb_send_ep0(const void *data, uint_fast8_t len);
@@ -1,6 +1,8 @@
 #ifndef __GENERIC_USB_CDC_EP_H
 #define __GENERIC_USB_CDC_EP_H
 
+#include "autoconf.h" // CONFIG_USB_HIGHSPEED
+
 // Default USB endpoint ids
 enum {
     USB_CDC_EP_BULK_IN = 1,
@@ -8,6 +10,18 @@ enum {
     USB_CDC_EP_ACM = 3,
 };
 
+#if CONFIG_USB_HIGHSPEED
+
+// High-speed endpoint sizes (ep0 and bulk sizes are fixed by the spec)
+enum {
+    USB_CDC_EP0_SIZE = 64,
+    USB_CDC_EP_ACM_SIZE = 8,
+    USB_CDC_EP_BULK_OUT_SIZE = 512,
+    USB_CDC_EP_BULK_IN_SIZE = 512,
+};
+
+#else
+
 // Default endpoint sizes
 enum {
     USB_CDC_EP0_SIZE = 16,
@@ -16,4 +30,6 @@ enum {
     USB_CDC_EP_BULK_IN_SIZE = 64,
 };
 
+#endif
+
 #endif // usb_cdc_ep.h
@@ -61,6 +61,19 @@ struct usb_device_descriptor {
     uint8_t  bNumConfigurations;
 } PACKED;
 
+struct usb_device_qualifier_descriptor {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+
+    uint16_t bcdUSB;
+    uint8_t  bDeviceClass;
+    uint8_t  bDeviceSubClass;
+    uint8_t  bDeviceProtocol;
+    uint8_t  bMaxPacketSize0;
+    uint8_t  bNumConfigurations;
+    uint8_t  bRESERVED;
+} PACKED;
+
 #define USB_CLASS_PER_INTERFACE         0       /* for DeviceClass */
 #define USB_CLASS_AUDIO                 1
 #define USB_CLASS_COMM                  2
@@ -4,6 +4,7 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include "autoconf.h" // CONFIG_WANT_SOFT_PWM_GROUPS
 #include "basecmd.h" // oid_alloc
 #include "board/gpio.h" // struct gpio_out
 #include "board/irq.h" // irq_disable
@@ -17,6 +18,10 @@ struct digital_out_s {
     struct gpio_out pin;
     uint32_t max_duration, cycle_time;
     struct move_queue_head mq;
+#if CONFIG_WANT_SOFT_PWM_GROUPS
+    struct soft_pwm_group *group;
+    struct digital_out_s *next_member;
+#endif
     uint8_t flags;
 };
 
@@ -26,7 +31,8 @@ struct digital_move {
 };
 
 enum {
-    DF_ON=1<<0, DF_TOGGLING=1<<1, DF_CHECK_END=1<<2, DF_DEFAULT_ON=1<<4
+    DF_ON=1<<0, DF_TOGGLING=1<<1, DF_CHECK_END=1<<2, DF_SCHEDULED=1<<3,
+    DF_DEFAULT_ON=1<<4
 };
 
 static uint_fast8_t digital_load_event(struct timer *timer);
@@ -91,7 +97,7 @@ digital_load_event(struct timer *timer)
         flags |= DF_CHECK_END;
     }
     d->end_time = end_time;
-    d->flags = flags | (d->flags & DF_DEFAULT_ON);
+    d->flags = flags | (d->flags & (DF_SCHEDULED|DF_DEFAULT_ON));
 
     // Schedule next event
     if (!(flags & DF_TOGGLING)) {
@@ -113,6 +119,153 @@ digital_load_event(struct timer *timer)
     return SF_RESCHEDULE;
 }
 
+
+/****************************************************************
+ * Gang scheduling of soft pwm pins
+ ****************************************************************/
+
+#if CONFIG_WANT_SOFT_PWM_GROUPS
+
+// Pins sharing a pwm cycle time are driven from one common timer
+struct soft_pwm_group {
+    struct timer timer;
+    struct soft_pwm_group *next;
+    struct digital_out_s *members;
+    uint32_t cycle_time, merge_ticks;
+    uint8_t scheduled;
+};
+
+static struct soft_pwm_group *soft_pwm_groups;
+
+// Apply all member edges that are due from a single timer wakeup
+static uint_fast8_t
+soft_pwm_group_event(struct timer *timer)
+{
+    struct soft_pwm_group *g = container_of(
+        timer, struct soft_pwm_group, timer);
+    // Edges due within merge_ticks fire on this wakeup.  The nominal
+    // event times are retained when rescheduling, so long term pulse
+    // timing (and thus duty cycle) is not skewed - an edge is just
+    // emitted marginally early.
+    uint32_t merge_end = g->timer.waketime + g->merge_ticks;
+    uint32_t next = 0;
+    uint8_t have_next = 0;
+    struct digital_out_s *d;
+    for (d = g->members; d; d = d->next_member) {
+        if (!(d->flags & DF_SCHEDULED))
+            continue;
+        while (!timer_is_before(merge_end, d->timer.waketime)) {
+            uint_fast8_t res = d->timer.func(&d->timer);
+            if (res != SF_RESCHEDULE) {
+                d->flags &= ~DF_SCHEDULED;
+                break;
+            }
+        }
+        if (!(d->flags & DF_SCHEDULED))
+            continue;
+        if (!have_next || timer_is_before(d->timer.waketime, next)) {
+            next = d->timer.waketime;
+            have_next = 1;
+        }
+    }
+    if (!have_next) {
+        g->scheduled = 0;
+        return SF_DONE;
+    }
+    g->timer.waketime = next;
+    return SF_RESCHEDULE;
+}
+
+// Arrange to run d's next event (at d->timer.waketime) - irqs disabled
+static void
+digital_out_sched(struct digital_out_s *d)
+{
+    struct soft_pwm_group *g = d->group;
+    if (!g) {
+        sched_add_timer(&d->timer);
+        return;
+    }
+    d->flags |= DF_SCHEDULED;
+    if (!g->scheduled) {
+        g->scheduled = 1;
+        g->timer.waketime = d->timer.waketime;
+        sched_add_timer(&g->timer);
+    } else if (timer_is_before(d->timer.waketime, g->timer.waketime)) {
+        sched_del_timer(&g->timer);
+        g->timer.waketime = d->timer.waketime;
+        sched_add_timer(&g->timer);
+    }
+}
+
+// Cancel a pending event on d - caller disables irqs
+static void
+digital_out_desched(struct digital_out_s *d)
+{
+    if (!d->group) {
+        sched_del_timer(&d->timer);
+        return;
+    }
+    // The group timer trims itself on its next wakeup
+    d->flags &= ~DF_SCHEDULED;
+}
+
+// Place d in the group for its cycle time - caller disables irqs
+static void
+soft_pwm_assign_group(struct digital_out_s *d)
+{
+    struct soft_pwm_group *old = d->group;
+    if (old && old->cycle_time == d->cycle_time)
+        return;
+    uint8_t active = d->flags & (DF_TOGGLING|DF_CHECK_END);
+    if (active)
+        digital_out_desched(d);
+    if (old) {
+        struct digital_out_s **pprev = &old->members;
+        while (*pprev != d)
+            pprev = &(*pprev)->next_member;
+        *pprev = d->next_member;
+        d->group = NULL;
+    }
+    struct soft_pwm_group *g = soft_pwm_groups;
+    while (g && g->cycle_time != d->cycle_time)
+        g = g->next;
+    if (!g) {
+        if (is_finalized()) {
+            // Can't allocate a new group - run d from its own timer
+            if (active)
+                sched_add_timer(&d->timer);
+            return;
+        }
+        g = alloc_chunk(sizeof(*g));
+        g->timer.func = soft_pwm_group_event;
+        g->cycle_time = d->cycle_time;
+        g->merge_ticks = d->cycle_time >> 10;
+        g->next = soft_pwm_groups;
+        soft_pwm_groups = g;
+    }
+    d->next_member = g->members;
+    g->members = d;
+    d->group = g;
+    if (active)
+        digital_out_sched(d);
+}
+
+#else
+
+static void
+digital_out_sched(struct digital_out_s *d)
+{
+    sched_add_timer(&d->timer);
+}
+
+static void
+digital_out_desched(struct digital_out_s *d)
+{
+    sched_del_timer(&d->timer);
+}
+
+#endif // CONFIG_WANT_SOFT_PWM_GROUPS
+
 void
 command_config_digital_out(uint32_t *args)
 {
@@ -136,6 +289,9 @@ command_set_digital_out_pwm_cycle(uint32_t *args)
     if (!move_queue_empty(&d->mq))
         shutdown("Can not set soft pwm cycle ticks while updates pending");
     d->cycle_time = args[1];
+#if CONFIG_WANT_SOFT_PWM_GROUPS
+    soft_pwm_assign_group(d);
+#endif
     irq_enable();
 }
 DECL_COMMAND(command_set_digital_out_pwm_cycle,
@@ -164,21 +320,49 @@ command_queue_digital_out(uint32_t *args)
         // digital_toggle_event() will schedule a load event when ready
     } else {
         // Schedule the loading of the parameters at the requested time
-        sched_del_timer(&d->timer);
+        digital_out_desched(d);
         d->timer.waketime = time;
         d->timer.func = digital_load_event;
-        sched_add_timer(&d->timer);
+        digital_out_sched(d);
     }
     irq_enable();
 }
 DECL_COMMAND(command_queue_digital_out,
              "queue_digital_out oid=%c clock=%u on_ticks=%u");
 
+// Read a big-endian 32bit value from a batched update buffer
+static uint32_t
+batch_read_u32(uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+        | ((uint32_t)p[2] << 8) | p[3];
+}
+
+void
+command_queue_digital_out_batch(uint32_t *args)
+{
+    uint_fast8_t len = args[0];
+    uint8_t *data = command_decode_ptr(args[1]);
+    if (len % 9)
+        shutdown("Invalid queue_digital_out_batch length");
+    while (len) {
+        uint32_t eargs[3] = { data[0], batch_read_u32(&data[1])
+                              , batch_read_u32(&data[5]) };
+        command_queue_digital_out(eargs);
+        data += 9;
+        len -= 9;
+    }
+}
+DECL_COMMAND(command_queue_digital_out_batch,
+             "queue_digital_out_batch data=%*s");
+
 void
 command_update_digital_out(uint32_t *args)
 {
     struct digital_out_s *d = oid_lookup(args[0], command_config_digital_out);
-    sched_del_timer(&d->timer);
+    irq_disable();
+    digital_out_desched(d);
+    irq_enable();
     if (!move_queue_empty(&d->mq))
         shutdown("update_digital_out not valid with active queue");
     uint8_t value = args[1], flags = d->flags, on_flag = value ? DF_ON : 0;
@@ -187,7 +371,9 @@ command_update_digital_out(uint32_t *args)
         d->timer.waketime = d->end_time = timer_read_time() + d->max_duration;
         d->timer.func = digital_load_event;
         d->flags = (flags & DF_DEFAULT_ON) | on_flag | DF_CHECK_END;
-        sched_add_timer(&d->timer);
+        irq_disable();
+        digital_out_sched(d);
+        irq_enable();
     } else {
         d->flags = (flags & DF_DEFAULT_ON) | on_flag;
     }
@@ -204,6 +390,15 @@ digital_out_shutdown(void)
         d->flags = d->flags & DF_DEFAULT_ON ? DF_ON | DF_DEFAULT_ON : 0;
         move_queue_clear(&d->mq);
     }
+#if CONFIG_WANT_SOFT_PWM_GROUPS
+    struct soft_pwm_group *g;
+    for (g = soft_pwm_groups; g; g = g->next)
+        g->scheduled = 0;
+    // Orphan the group list so a config_reset can not resurrect
+    // groups from a reinitialized memory arena.  Pins configured at
+    // the time of shutdown keep their direct group references.
+    soft_pwm_groups = NULL;
+#endif
 }
 DECL_SHUTDOWN(digital_out_shutdown);
 
@@ -0,0 +1,166 @@
+// Micro-controller based PID control of a heater output pin
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "basecmd.h" // oid_alloc
+#include "board/gpio.h" // struct gpio_pwm
+#include "board/misc.h" // timer_read_time
+#include "command.h" // DECL_COMMAND
+#include "heater_pid.h" // heater_pid_update
+#include "sched.h" // DECL_SHUTDOWN
+
+// The host linearizes the thermistor response around the target
+// temperature and sends gains relating raw ADC counts to pwm duty.
+// Gains are Q16 fixed point - the host also sends the integral bounds
+// so the sign of Ki (inverted for NTC thermistors) is transparent here.
+
+struct heater_pid {
+    struct gpio_pwm pin;
+    uint8_t oid;
+    int32_t kp, ki, kd;
+    int32_t integ, integ_min, integ_max;
+    int32_t target;
+    uint32_t watchdog_clock;
+    uint16_t max_value, last_pwm, last_report_pwm;
+    int32_t prev_value;
+    uint8_t flags;
+};
+
+enum { HP_ACTIVE=1<<0, HP_HAVE_PREV=1<<1 };
+
+// Minimum duty change (as fraction of max) that triggers a state report
+#define REPORT_PWM_DELTA_SHIFT 6
+
+void
+command_config_heater_pid(uint32_t *args)
+{
+    struct gpio_pwm pin = gpio_pwm_setup(args[1], args[2], 0);
+    struct heater_pid *hp = oid_alloc(
+        args[0], command_config_heater_pid, sizeof(*hp));
+    hp->pin = pin;
+    hp->oid = args[0];
+}
+DECL_COMMAND(command_config_heater_pid,
+             "config_heater_pid oid=%c pin=%u cycle_ticks=%u");
+
+struct heater_pid *
+heater_pid_oid_lookup(uint8_t oid)
+{
+    return oid_lookup(oid, command_config_heater_pid);
+}
+
+void
+command_heater_pid_set_gains(uint32_t *args)
+{
+    struct heater_pid *hp = oid_lookup(args[0], command_config_heater_pid);
+    hp->kp = args[1];
+    hp->ki = args[2];
+    hp->kd = args[3];
+    hp->integ_min = args[4];
+    hp->integ_max = args[5];
+    hp->max_value = args[6];
+    if (hp->integ < hp->integ_min)
+        hp->integ = hp->integ_min;
+    else if (hp->integ > hp->integ_max)
+        hp->integ = hp->integ_max;
+}
+DECL_COMMAND(command_heater_pid_set_gains,
+             "heater_pid_set_gains oid=%c kp=%i ki=%i kd=%i"
+             " integ_min=%i integ_max=%i max_value=%hu");
+
+// Enable the control loop (also serves as the host keepalive refresh)
+void
+command_heater_pid_set_target(uint32_t *args)
+{
+    struct heater_pid *hp = oid_lookup(args[0], command_config_heater_pid);
+    hp->watchdog_clock = args[1];
+    hp->target = args[2];
+    if (!(hp->flags & HP_ACTIVE)) {
+        hp->integ = 0;
+        hp->flags = HP_ACTIVE;
+    }
+}
+DECL_COMMAND(command_heater_pid_set_target,
+             "heater_pid_set_target oid=%c clock=%u target=%i");
+
+// Disable the control loop and directly set the output duty
+void
+command_heater_pid_manual(uint32_t *args)
+{
+    struct heater_pid *hp = oid_lookup(args[0], command_config_heater_pid);
+    hp->flags = 0;
+    hp->watchdog_clock = args[1];
+    hp->last_pwm = args[2];
+    gpio_pwm_write(hp->pin, args[2]);
+}
+DECL_COMMAND(command_heater_pid_manual,
+             "heater_pid_manual oid=%c clock=%u value=%hu");
+
+void
+command_heater_pid_query_state(uint32_t *args)
+{
+    struct heater_pid *hp = oid_lookup(args[0], command_config_heater_pid);
+    sendf("heater_pid_state oid=%c active=%c pwm=%hu integ=%i"
+          , args[0], !!(hp->flags & HP_ACTIVE), hp->last_pwm, hp->integ);
+}
+DECL_COMMAND(command_heater_pid_query_state, "heater_pid_query_state oid=%c");
+
+// Handle a new ADC sample (called from the analog_in task)
+void
+heater_pid_update(struct heater_pid *hp, uint16_t value)
+{
+    if (!hp)
+        return;
+    if (hp->last_pwm && timer_is_before(hp->watchdog_clock
+                                        , timer_read_time())) {
+        // Host has not refreshed the target recently - disable heater
+        hp->flags = 0;
+        hp->last_pwm = 0;
+        gpio_pwm_write(hp->pin, 0);
+        try_shutdown("heater_pid update timeout");
+        return;
+    }
+    if (!(hp->flags & HP_ACTIVE))
+        return;
+    int32_t err = hp->target - (int32_t)value;
+    int32_t deriv = 0;
+    if (hp->flags & HP_HAVE_PREV)
+        deriv = (int32_t)value - hp->prev_value;
+    hp->prev_value = value;
+    hp->flags |= HP_HAVE_PREV;
+    int32_t integ = hp->integ + err;
+    if (integ < hp->integ_min)
+        integ = hp->integ_min;
+    else if (integ > hp->integ_max)
+        integ = hp->integ_max;
+    int64_t co = ((int64_t)hp->kp * err + (int64_t)hp->ki * integ
+                  - (int64_t)hp->kd * deriv) >> 16;
+    int32_t bounded_co = co < 0 ? 0 : (co > hp->max_value ? hp->max_value : co);
+    if (co == bounded_co)
+        // Only wind the integral while the output is unsaturated
+        hp->integ = integ;
+    gpio_pwm_write(hp->pin, bounded_co);
+    hp->last_pwm = bounded_co;
+    // Notify host of significant duty changes
+    uint16_t delta = hp->last_pwm > hp->last_report_pwm
+        ? hp->last_pwm - hp->last_report_pwm
+        : hp->last_report_pwm - hp->last_pwm;
+    if (delta >= ((uint16_t)hp->max_value >> REPORT_PWM_DELTA_SHIFT) + 1) {
+        hp->last_report_pwm = hp->last_pwm;
+        sendf("heater_pid_pwm oid=%c pwm=%hu", hp->oid, hp->last_pwm);
+    }
+}
+
+void
+heater_pid_shutdown(void)
+{
+    uint8_t i;
+    struct heater_pid *hp;
+    foreach_oid(i, hp, command_config_heater_pid) {
+        hp->flags = 0;
+        gpio_pwm_write(hp->pin, 0);
+    }
+}
+DECL_SHUTDOWN(heater_pid_shutdown);
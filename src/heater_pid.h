@@ -0,0 +1,22 @@
+#ifndef __HEATER_PID_H
+#define __HEATER_PID_H
+
+#include <stdint.h> // uint16_t
+#include "autoconf.h" // CONFIG_WANT_HEATER_PID
+
+#if CONFIG_WANT_HEATER_PID
+
+struct heater_pid *heater_pid_oid_lookup(uint8_t oid);
+void heater_pid_update(struct heater_pid *hp, uint16_t value);
+
+#else
+// Dummy versions of code to avoid compile errors when not using heater_pid
+
+static inline struct heater_pid *heater_pid_oid_lookup(uint8_t oid) {
+    return NULL;
+}
+static inline void heater_pid_update(struct heater_pid *hp, uint16_t value) { }
+
+#endif
+
+#endif // heater_pid.h
@@ -9,16 +9,31 @@
 #include "autoconf.h" // CONFIG_CLOCK_FREQ
 #include "board/gpio.h" // gpio_out_setup
 #include "board/internal.h" // gpio_peripheral
+#include "board/irq.h" // irq_poll
 #include "board/misc.h" // timer_read_time
 #include "basecmd.h" // oid_alloc
 #include "command.h" // DECL_COMMAND
+#include "sched.h" // struct timer
 #include "i2ccmds.h" // i2cdev_set_software_bus
 
+// The bus is advanced one edge per timer event by a small state
+// machine, so transfers complete asynchronously and do not block the
+// task loop for the duration of the transaction.
+
+enum {
+    IP_DONE, IP_START, IP_SEND, IP_RECV, IP_STOP
+};
+
 struct i2c_software {
+    struct timer timer;
     struct gpio_out scl_out, sda_out;
     struct gpio_in scl_in, sda_in;
     uint8_t addr;
     uint32_t ticks;
+    // Active transaction state
+    uint8_t *send_pos, *send_end, *recv_pos, *recv_end;
+    uint8_t phase, step, cur, cur_addr;
+    uint8_t sda_state, in_read, is_addr, status;
 };
 
 void
@@ -38,159 +53,228 @@ DECL_COMMAND(command_i2c_set_sw_bus,
              "i2c_set_sw_bus oid=%c scl_pin=%u sda_pin=%u"
              " pulse_ticks=%u address=%u");
 
+// Set the sda line (emulating open-drain with the input pullup)
 static void
-i2c_delay(uint32_t ticks)
+i2c_set_sda(struct i2c_software *is, uint_fast8_t bit)
 {
-    uint32_t end = timer_read_time() + ticks;
-    while (timer_is_before(timer_read_time(), end))
-        ;
+    if (bit) {
+        if (is->sda_state != 1)
+            gpio_in_reset(is->sda_in, 1);
+    } else {
+        if (is->sda_state != 0)
+            gpio_out_reset(is->sda_out, 0);
+    }
+    is->sda_state = bit;
 }
 
+// Begin clocking out a byte (caller sets up is->cur)
 static void
-i2c_software_send_ack(struct i2c_software *is, const uint8_t ack)
+i2c_load_byte(struct i2c_software *is, uint8_t b, uint_fast8_t is_addr)
 {
-    if (!ack) {
-        gpio_out_reset(is->sda_out, 0);
-    }
-    i2c_delay(is->ticks);
-    gpio_in_reset(is->scl_in, 1);
-    i2c_delay(is->ticks);
-    gpio_out_reset(is->scl_out, 0);
+    is->cur = b;
+    is->is_addr = is_addr;
+    is->phase = IP_SEND;
+    is->step = 0;
 }
 
-static uint8_t
-i2c_software_read_ack(struct i2c_software *is, uint_fast8_t state)
+// A byte (and its ack) completed - determine what happens next.
+// Called with scl just driven low; sda may be updated in the same
+// edge, matching the timing of a synchronous bit-bang loop.
+static void
+i2c_next_action(struct i2c_software *is)
 {
-    uint8_t nack = 0;
-    if (state == 0)
-        gpio_in_reset(is->sda_in, 1);
-    i2c_delay(is->ticks);
-    gpio_in_reset(is->scl_in, 1);
-    nack = gpio_in_read(is->sda_in);
-    i2c_delay(is->ticks);
-    gpio_out_reset(is->scl_out, 0);
-    return nack;
+    if (is->in_read) {
+        if (is->recv_pos < is->recv_end) {
+            // Clock in next data byte (sda already released)
+            is->phase = IP_RECV;
+            is->step = 0;
+            return;
+        }
+    } else if (is->send_pos < is->send_end) {
+        // Send next data byte (first data bit set on this edge)
+        i2c_load_byte(is, *is->send_pos++, 0);
+        i2c_set_sda(is, !!(is->cur & 0x80));
+        is->cur <<= 1;
+        is->step = 1;
+        return;
+    } else if (is->recv_pos < is->recv_end) {
+        // Repeated start before the read segment
+        is->cur_addr = is->addr | 0x01;
+        is->in_read = 1;
+        is->phase = IP_START;
+        is->step = 0;
+        return;
+    }
+    // Transaction complete - generate stop
+    i2c_set_sda(is, 0);
+    is->phase = IP_STOP;
+    is->step = 0;
 }
 
-static int
-i2c_software_send_byte(struct i2c_software *is, uint8_t b)
+// Advance the bus one edge
+static uint_fast8_t
+i2c_software_event(struct timer *t)
 {
-    uint_fast8_t state = 2;
-    for (uint_fast8_t i = 0; i < 8; i++) {
-        if (b & 0x80) {
-            if (state != 1)
-                gpio_in_reset(is->sda_in, 1);
-            state = 1;
+    struct i2c_software *is = container_of(t, struct i2c_software, timer);
+    uint_fast8_t step = is->step;
+    switch (is->phase) {
+    case IP_START:
+        if (step == 0) {
+            i2c_set_sda(is, 1);
+            gpio_in_reset(is->scl_in, 1);
+        } else if (step == 1) {
+            i2c_set_sda(is, 0);
         } else {
-            if (state > 0)
-                gpio_out_reset(is->sda_out, 0);
-            state = 0;
+            gpio_out_reset(is->scl_out, 0);
+            i2c_load_byte(is, is->cur_addr, 1);
+            i2c_set_sda(is, !!(is->cur & 0x80));
+            is->cur <<= 1;
+            is->step = 1;
+            goto reschedule;
         }
-        b <<= 1;
-        i2c_delay(is->ticks);
-        gpio_in_reset(is->scl_in, 1);
-        i2c_delay(is->ticks);
-        gpio_out_reset(is->scl_out, 0);
-    }
-
-    if (i2c_software_read_ack(is, state)) {
-        return I2C_BUS_NACK;
+        break;
+    case IP_SEND:
+        if (step < 16) {
+            if (!(step & 1)) {
+                // Drive scl low and setup the next data bit
+                gpio_out_reset(is->scl_out, 0);
+                i2c_set_sda(is, !!(is->cur & 0x80));
+                is->cur <<= 1;
+            } else {
+                gpio_in_reset(is->scl_in, 1);
+            }
+        } else if (step == 16) {
+            // Release sda so the device can ack
+            gpio_out_reset(is->scl_out, 0);
+            i2c_set_sda(is, 1);
+        } else if (step == 17) {
+            gpio_in_reset(is->scl_in, 1);
+            if (gpio_in_read(is->sda_in)) {
+                // Device did not ack
+                if (is->is_addr)
+                    is->status = (is->in_read ? I2C_BUS_START_READ_NACK
+                                  : I2C_BUS_START_NACK);
+                else
+                    is->status = I2C_BUS_NACK;
+            }
+        } else {
+            gpio_out_reset(is->scl_out, 0);
+            if (is->status != I2C_BUS_SUCCESS) {
+                // Abort transaction with a stop
+                i2c_set_sda(is, 0);
+                is->phase = IP_STOP;
+                is->step = 0;
+                goto reschedule;
+            }
+            i2c_next_action(is);
+            goto reschedule;
+        }
+        break;
+    case IP_RECV:
+        if (step < 16) {
+            if (!(step & 1)) {
+                gpio_in_reset(is->scl_in, 1);
+            } else {
+                // Sample the data bit
+                uint8_t b = (is->cur << 1) | gpio_in_read(is->sda_in);
+                is->cur = b;
+                gpio_out_reset(is->scl_out, 0);
+                if (step == 15) {
+                    *is->recv_pos++ = b;
+                    // Ack (unless this was the final byte)
+                    i2c_set_sda(is, is->recv_pos >= is->recv_end);
+                }
+            }
+        } else if (step == 16) {
+            gpio_in_reset(is->scl_in, 1);
+        } else {
+            gpio_out_reset(is->scl_out, 0);
+            i2c_set_sda(is, 1);
+            is->cur = 0;
+            i2c_next_action(is);
+            goto reschedule;
+        }
+        break;
+    case IP_STOP:
+    default:
+        if (step == 0) {
+            gpio_in_reset(is->scl_in, 1);
+        } else {
+            i2c_set_sda(is, 1);
+            is->phase = IP_DONE;
+            return SF_DONE;
+        }
+        break;
     }
-
-    return I2C_BUS_SUCCESS;
+    is->step = step + 1;
+reschedule:
+    is->timer.waketime += is->ticks;
+    return SF_RESCHEDULE;
 }
 
-static uint8_t
-i2c_software_read_byte(struct i2c_software *is, uint8_t remaining)
+// Launch a transaction (write_len bytes written, then read_len read)
+void
+i2c_software_start_async(struct i2c_software *is, uint8_t write_len
+                         , uint8_t *write, uint8_t read_len, uint8_t *read)
 {
-    uint8_t b = 0;
-    gpio_in_reset(is->sda_in, 1);
-    for (uint_fast8_t i = 0; i < 8; i++) {
-        i2c_delay(is->ticks);
-        gpio_in_reset(is->scl_in, 1);
-        i2c_delay(is->ticks);
-        b <<= 1;
-        b |= gpio_in_read(is->sda_in);
-        gpio_out_reset(is->scl_out, 0);
+    is->send_pos = write;
+    is->send_end = write + write_len;
+    is->recv_pos = read;
+    is->recv_end = read + read_len;
+    is->in_read = 0;
+    is->cur_addr = is->addr;
+    if (!write_len && read_len) {
+        is->cur_addr |= 0x01;
+        is->in_read = 1;
     }
-    i2c_software_send_ack(is, remaining == 0);
-    return b;
+    is->status = I2C_BUS_SUCCESS;
+    is->sda_state = 2;
+    is->cur = 0;
+    is->phase = IP_START;
+    is->step = 0;
+    is->timer.func = i2c_software_event;
+    is->timer.flags = TF_DEFERRABLE;
+    irq_disable();
+    is->timer.waketime = timer_read_time() + is->ticks;
+    sched_add_timer(&is->timer);
+    irq_enable();
 }
 
-static int
-i2c_software_start(struct i2c_software *is, uint8_t addr)
+// Check if a transaction has completed (negative if still running)
+int
+i2c_software_check_async(struct i2c_software *is)
 {
-    int ret;
-    i2c_delay(is->ticks);
-    gpio_in_reset(is->sda_in, 1);
-    gpio_in_reset(is->scl_in, 1);
-    i2c_delay(is->ticks);
-    gpio_out_reset(is->sda_out, 0);
-    i2c_delay(is->ticks);
-    gpio_out_reset(is->scl_out, 0);
-
-    ret = i2c_software_send_byte(is, addr);
-    if (ret == I2C_BUS_NACK)
-        return I2C_BUS_START_NACK;
-    return ret;
+    if (is->phase != IP_DONE)
+        return -1;
+    return is->status;
 }
 
-static void
-i2c_software_stop(struct i2c_software *is)
+// Wait for a transaction to complete
+static int
+i2c_software_wait(struct i2c_software *is)
 {
-    gpio_out_reset(is->sda_out, 0);
-    i2c_delay(is->ticks);
-    gpio_in_reset(is->scl_in, 1);
-    i2c_delay(is->ticks);
-    gpio_in_reset(is->sda_in, 1);
+    for (;;) {
+        int ret = i2c_software_check_async(is);
+        if (ret >= 0)
+            return ret;
+        if (sched_is_shutdown())
+            // Timers were cleared - transaction will never complete
+            return I2C_BUS_TIMEOUT;
+        irq_poll();
+    }
 }
 
 int
 i2c_software_write(struct i2c_software *is, uint8_t write_len, uint8_t *write)
 {
-    int ret = i2c_software_start(is, is->addr);
-    if (ret != I2C_BUS_SUCCESS)
-        goto out;
-
-    while (write_len--) {
-        ret = i2c_software_send_byte(is, *write++);
-        if (ret != I2C_BUS_SUCCESS)
-            break;
-    }
-
-out:
-    i2c_software_stop(is);
-    return ret;
+    i2c_software_start_async(is, write_len, write, 0, NULL);
+    return i2c_software_wait(is);
 }
 
 int
 i2c_software_read(struct i2c_software *is, uint8_t reg_len, uint8_t *reg
                   , uint8_t read_len, uint8_t *read)
 {
-    int ret;
-    if (reg_len) {
-        // write the register
-        ret = i2c_software_start(is, is->addr);
-        if (ret != I2C_BUS_SUCCESS)
-            goto out;
-        while(reg_len--) {
-            ret = i2c_software_send_byte(is, *reg++);
-            if (ret != I2C_BUS_SUCCESS)
-                goto out;
-        }
-
-    }
-    // start/re-start and read data
-    ret = i2c_software_start(is, is->addr | 0x01);
-    if (ret != I2C_BUS_SUCCESS) {
-        ret = I2C_BUS_START_READ_NACK;
-        goto out;
-    }
-    while(read_len--) {
-        *read = i2c_software_read_byte(is, read_len);
-        read++;
-    }
-out:
-    i2c_software_stop(is);
-    return ret;
+    i2c_software_start_async(is, reg_len, reg, read_len, read);
+    return i2c_software_wait(is);
 }
@@ -4,6 +4,10 @@
 #include <stdint.h> // uint8_t
 
 struct i2c_software *i2c_software_oid_lookup(uint8_t oid);
+void i2c_software_start_async(struct i2c_software *sw_i2c
+                              , uint8_t write_len, uint8_t *write
+                              , uint8_t read_len, uint8_t *read);
+int i2c_software_check_async(struct i2c_software *sw_i2c);
 int i2c_software_write(struct i2c_software *sw_i2c
                        , uint8_t write_len, uint8_t *write);
 int i2c_software_read(struct i2c_software *sw_i2c
@@ -55,6 +55,67 @@ i2cdev_set_software_bus(struct i2cdev_s *i2c, struct i2c_software *is)
     i2c->flags |= IF_SOFTWARE;
 }
 
+#if CONFIG_WANT_SOFTWARE_I2C
+
+// A host i2c_transfer on a software bus completes asynchronously - the
+// response is sent once the bit-bang engine finishes.  Only one such
+// transfer is tracked at a time; a new request drains the prior one.
+static struct {
+    struct i2c_software *sw;
+    uint8_t oid, write_len, read_len;
+    uint8_t data[48];
+} i2c_async;
+static uint8_t i2c_async_active;
+static struct task_wake i2ccmds_wake;
+
+// Send the response for a completed transfer
+static void
+i2c_async_finish(int ret)
+{
+    sendf("i2c_response oid=%c i2c_bus_status=%c response=%*s"
+          , i2c_async.oid, ret, i2c_async.read_len
+          , &i2c_async.data[i2c_async.write_len]);
+    i2c_async_active = 0;
+}
+
+// Wait for any in-progress transfer to complete
+static void
+i2c_async_drain(void)
+{
+    while (i2c_async_active) {
+        int ret = i2c_software_check_async(i2c_async.sw);
+        if (ret >= 0) {
+            i2c_async_finish(ret);
+            return;
+        }
+        if (sched_is_shutdown()) {
+            i2c_async_active = 0;
+            return;
+        }
+    }
+}
+
+void
+i2ccmds_task(void)
+{
+    if (!sched_check_wake(&i2ccmds_wake) || !i2c_async_active)
+        return;
+    int ret = i2c_software_check_async(i2c_async.sw);
+    if (ret < 0) {
+        // Transfer still in progress - check again on next task run
+        sched_wake_task(&i2ccmds_wake);
+        return;
+    }
+    i2c_async_finish(ret);
+}
+DECL_TASK_WAKE(i2ccmds_task, i2ccmds_wake);
+
+#else
+
+static inline void i2c_async_drain(void) { }
+
+#endif // CONFIG_WANT_SOFTWARE_I2C
+
 void i2c_shutdown_on_err(int ret)
 {
     switch (ret) {
@@ -72,9 +133,10 @@ void i2c_shutdown_on_err(int ret)
 int i2c_dev_write(struct i2cdev_s *i2c, uint8_t write_len, uint8_t *data)
 {
     uint_fast8_t flags = i2c->flags;
-    if (CONFIG_WANT_SOFTWARE_I2C && flags & IF_SOFTWARE)
+    if (CONFIG_WANT_SOFTWARE_I2C && flags & IF_SOFTWARE) {
+        i2c_async_drain();
         return i2c_software_write(i2c->i2c_sw, write_len, data);
-    else
+    } else
         return i2c_write(i2c->i2c_hw, write_len, data);
 }
 
@@ -82,9 +144,10 @@ int i2c_dev_read(struct i2cdev_s *i2c, uint8_t reg_len, uint8_t *reg
                   , uint8_t read_len, uint8_t *read)
 {
     uint_fast8_t flags = i2c->flags;
-    if (CONFIG_WANT_SOFTWARE_I2C && flags & IF_SOFTWARE)
+    if (CONFIG_WANT_SOFTWARE_I2C && flags & IF_SOFTWARE) {
+        i2c_async_drain();
         return i2c_software_read(i2c->i2c_sw, reg_len, reg, read_len, read);
-    else
+    } else
         return i2c_read(i2c->i2c_hw, reg_len, reg, read_len, read);
 }
 
@@ -95,6 +158,22 @@ void command_i2c_transfer(uint32_t *args)
     uint8_t wlen = args[1];
     uint8_t *wdata = command_decode_ptr(args[2]);
     uint8_t rlen = args[3];
+#if CONFIG_WANT_SOFTWARE_I2C
+    if (i2c->flags & IF_SOFTWARE && wlen + rlen <= sizeof(i2c_async.data)) {
+        // Start transfer - the response is sent when it completes
+        i2c_async_drain();
+        i2c_async.sw = i2c->i2c_sw;
+        i2c_async.oid = oid;
+        i2c_async.write_len = wlen;
+        i2c_async.read_len = rlen;
+        memcpy(i2c_async.data, wdata, wlen);
+        i2c_async_active = 1;
+        i2c_software_start_async(i2c->i2c_sw, wlen, i2c_async.data
+                                 , rlen, &i2c_async.data[wlen]);
+        sched_wake_task(&i2ccmds_wake);
+        return;
+    }
+#endif
     uint8_t rdata[rlen];
     uint8_t nack;
     if (rlen > 0)
@@ -178,6 +178,15 @@ console_sendf(const struct command_encoder *ce, va_list args)
         report_errno("write", ret);
 }
 
+// Check for console input without sleeping (used in busy-poll mode)
+void
+console_poll(void)
+{
+    int ret = poll(main_pfd, ARRAY_SIZE(main_pfd), 0);
+    if (ret > 0 && main_pfd[MP_TTY_IDX].revents)
+        sched_wake_task(&console_wake);
+}
+
 // Sleep until a signal received (waking early for console input if needed)
 void
 console_sleep(sigset_t *sigset)
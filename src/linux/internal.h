@@ -19,10 +19,12 @@ void report_errno(char *where, int rc);
 int set_non_blocking(int fd);
 int set_close_on_exec(int fd);
 int console_setup(char *name);
+void console_poll(void);
 void console_sleep(sigset_t *sigset);
 
 // timer.c
 int timer_check_periodic(uint32_t *ts);
+void timer_enable_busypoll(void);
 void timer_disable_signals(void);
 void timer_enable_signals(void);
 
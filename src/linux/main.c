@@ -4,8 +4,10 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#define _GNU_SOURCE
 #include <sched.h> // sched_setscheduler sched_get_priority_max
 #include <stdio.h> // fprintf
+#include <stdlib.h> // atoi
 #include <string.h> // memset
 #include <unistd.h> // getopt
 #include <sys/mman.h> // mlockall MCL_CURRENT MCL_FUTURE
@@ -41,6 +43,22 @@ realtime_setup(void)
     return 0;
 }
 
+// Pin the process to a single cpu core (ideally one isolated from the
+// general scheduler via the isolcpus/nohz_full kernel options)
+static int
+affinity_setup(int core)
+{
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    CPU_SET(core, &cs);
+    int ret = sched_setaffinity(0, sizeof(cs), &cs);
+    if (ret < 0) {
+        report_errno("sched_setaffinity", ret);
+        return -1;
+    }
+    return 0;
+}
+
 
 /****************************************************************
  * Restart
@@ -68,9 +86,9 @@ main(int argc, char **argv)
 {
     // Parse program args
     orig_argv = argv;
-    int opt, watchdog = 0, realtime = 0;
+    int opt, watchdog = 0, realtime = 0, busypoll = 0, core = -1;
     char *serial = "/tmp/klipper_host_mcu";
-    while ((opt = getopt(argc, argv, "wrI:")) != -1) {
+    while ((opt = getopt(argc, argv, "wrbc:I:")) != -1) {
         switch (opt) {
         case 'w':
             watchdog = 1;
@@ -78,11 +96,18 @@ main(int argc, char **argv)
         case 'r':
             realtime = 1;
             break;
+        case 'b':
+            busypoll = 1;
+            break;
+        case 'c':
+            core = atoi(optarg);
+            break;
         case 'I':
             serial = optarg;
             break;
         default:
-            fprintf(stderr, "Usage: %s [-w] [-r] [-I path]\n", argv[0]);
+            fprintf(stderr, "Usage: %s [-w] [-r] [-b] [-c core] [-I path]\n"
+                    , argv[0]);
             return -1;
         }
     }
@@ -93,6 +118,13 @@ main(int argc, char **argv)
         if (ret)
             return ret;
     }
+    if (core >= 0) {
+        int ret = affinity_setup(core);
+        if (ret)
+            return ret;
+    }
+    if (busypoll)
+        timer_enable_busypoll();
     int ret = console_setup(serial);
     if (ret)
         return -1;
@@ -19,12 +19,18 @@
 
 #define W1_READ_TIMEOUT_SEC 5
 
+// Writing "trigger" to this sysfs file starts a temperature conversion
+// on all bulk-read capable sensors on the bus at once
+#define W1_BULK_TRIGGER_PATH \
+    "/sys/bus/w1/devices/w1_bus_master1/therm_bulk_read"
+
 // Status of a sensor
 enum {
     W1_IDLE = 0, // No read requested yet
-    W1_READ_REQUESTED = 1, // Reading or waiting to read
+    W1_READ_REQUESTED = 1, // Waiting for the reader thread
     W1_READY = 2, // Read complete, waiting to report
     W1_ERROR = 3, // Request shutdown
+    W1_READING = 4, // Reader thread is reading
 };
 
 enum {
@@ -41,12 +47,8 @@ struct ds18_s {
     // Should only be accessed by reader thread after configuration.
     int fd;
 
-    // Used for guarding shared members.
-    pthread_mutex_t lock;
-    pthread_cond_t cond;
-
-    // Protect all reads/writes to the following members using the mutex
-    // once reader thread is initialized.
+    // Protect all reads/writes to the following members using the
+    // shared w1_reader lock once the reader thread is initialized.
     int temperature;
     struct timespec request_time;
     uint8_t status;
@@ -54,19 +56,49 @@ struct ds18_s {
     uint8_t max_error_count;
 };
 
-// Lock ds18_s mutex, set error status, unlock mutex.
-static void
-locking_handle_read_error(struct ds18_s *d)
+void command_config_ds18b20(uint32_t *args);
+
+// One reader thread services all sensors - the kernel serializes bus
+// access anyway, and a single thread can batch conversion triggering
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int started;
+    int bulk_fd;
+} w1_reader = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, -1
+};
+
+// Read and parse a w1_slave file - no locking (runs in reader thread)
+static int
+read_temperature(struct ds18_s *d, int *val)
 {
-    pthread_mutex_lock(&d->lock);
-    d->status = W1_ERROR;
-    d->error_count++;
-    if (d->error_count <= d->max_error_count) {
-        pthread_mutex_unlock(&d->lock);
-    } else {
-        pthread_mutex_unlock(&d->lock);
-        pthread_exit(NULL);
+    // The temperature data is at the end of the report, after a "t=".
+    // Example (3.062 degrees C):
+    //
+    // 31 00 4b 46 7f ff 0c 10 77 : crc=77 YES
+    // 31 00 4b 46 7f ff 0c 10 77 t=3062
+    char data[128];
+    int ret = read(d->fd, data, sizeof(data)-1);
+    if (ret < 0) {
+        report_errno("read DS18B20", ret);
+        return -1;
     }
+    data[ret] = '\0';
+    char *temp_string = strstr(data, "t=");
+    if (temp_string == NULL || temp_string[2] == '\0')
+        return -1;
+    // Don't pass 't' and '=' to atoi
+    temp_string += 2;
+    *val = atoi(temp_string);
+
+    // Seek file in preparation of next read
+    ret = lseek(d->fd, 0, SEEK_SET);
+    if (ret < 0) {
+        report_errno("seek DS18B20", ret);
+        return -1;
+    }
+    return 0;
 }
 
 // The kernel interface to DS18B20 sensors is a sysfs entry that blocks for
@@ -74,51 +106,49 @@ locking_handle_read_error(struct ds18_s *d)
 // to be ready. Read in a separate thread in order to avoid blocking time-
 // sensitive work.
 static void *
-reader_start_routine(void *param) {
-    struct ds18_s *d = param;
+reader_start_routine(void *param)
+{
+    pthread_mutex_lock(&w1_reader.lock);
     for (;;) {
-        // Wait for requests to read temperature sensors
-        pthread_mutex_lock(&d->lock);
-        while (d->status != W1_READ_REQUESTED) {
-            pthread_cond_wait(&d->cond, &d->lock);
+        // Claim all sensors with a requested read (the oid table is
+        // stable by the time temperature queries begin)
+        int num_requested = 0;
+        uint8_t oid;
+        struct ds18_s *d;
+        foreach_oid(oid, d, command_config_ds18b20) {
+            if (d->status == W1_READ_REQUESTED) {
+                d->status = W1_READING;
+                num_requested++;
+            }
         }
-        pthread_mutex_unlock(&d->lock);
-
-        // Read temp.
-        // The temperature data is at the end of the report, after a "t=".
-        // Example (3.062 degrees C):
-        //
-        // 31 00 4b 46 7f ff 0c 10 77 : crc=77 YES
-        // 31 00 4b 46 7f ff 0c 10 77 t=3062
-        char data[128];
-        int ret = read(d->fd, data, sizeof(data)-1);
-        if (ret < 0) {
-            report_errno("read DS18B20", ret);
-            locking_handle_read_error(d);
+        if (!num_requested) {
+            pthread_cond_wait(&w1_reader.cond, &w1_reader.lock);
             continue;
         }
-        data[ret] = '\0';
-        char *temp_string = strstr(data, "t=");
-        if (temp_string == NULL || temp_string[2] == '\0') {
-            locking_handle_read_error(d);
-            continue;
+        if (num_requested > 1 && w1_reader.bulk_fd >= 0) {
+            // Start conversion on all sensors at once so the per
+            // sensor reads below do not each wait for a conversion
+            int ret = write(w1_reader.bulk_fd, "trigger", 7);
+            if (ret < 0) {
+                report_errno("write w1 bulk trigger", ret);
+                close(w1_reader.bulk_fd);
+                w1_reader.bulk_fd = -1;
+            }
         }
-        // Don't pass 't' and '=' to atoi
-        temp_string += 2;
-        int val = atoi(temp_string);
-
-        // Store temperature
-        pthread_mutex_lock(&d->lock);
-        d->status = W1_READY;
-        d->temperature = val;
-        pthread_mutex_unlock(&d->lock);
-
-        // Seek file in preparation of next read
-        ret = lseek(d->fd, 0, SEEK_SET);
-        if (ret < 0) {
-            report_errno("seek DS18B20", ret);
-            locking_handle_read_error(d);
-            continue;
+        foreach_oid(oid, d, command_config_ds18b20) {
+            if (d->status != W1_READING)
+                continue;
+            pthread_mutex_unlock(&w1_reader.lock);
+            int val = 0;
+            int ret = read_temperature(d, &val);
+            pthread_mutex_lock(&w1_reader.lock);
+            if (ret) {
+                d->status = W1_ERROR;
+                d->error_count++;
+            } else {
+                d->status = W1_READY;
+                d->temperature = val;
+            }
         }
     }
     pthread_exit(NULL);
@@ -144,14 +174,14 @@ command_config_ds18b20(uint32_t *args)
     uint8_t serial_len = args[1];
     uint8_t *serial = command_decode_ptr(args[2]);
     if (memchr(serial, '/', serial_len))
-        goto fail1;
+        shutdown("Invalid DS18B20 serial id, must not contain '/'");
     char fname[56];
     snprintf(fname, sizeof(fname), "/sys/bus/w1/devices/%.*s/w1_slave"
              , serial_len, serial);
     int fd = open(fname, O_RDONLY|O_CLOEXEC);
     if (fd < 0) {
         report_errno("open ds18", fd);
-        goto fail2;
+        shutdown("Invalid DS18B20 serial id, could not open for reading");
     }
 
     struct ds18_s *d = oid_alloc(args[0], command_config_ds18b20, sizeof(*d));
@@ -160,32 +190,20 @@ command_config_ds18b20(uint32_t *args)
     d->timer.func = ds18_event;
     d->fd = fd;
     d->status = W1_IDLE;
-    int ret;
-    ret = pthread_mutex_init(&d->lock, NULL);
-    if (ret)
-        goto fail3;
-    ret = pthread_cond_init(&d->cond, NULL);
-    if (ret)
-        goto fail4;
 
-    pthread_t reader_tid; // Not used
-    timer_disable_signals();
-    ret = pthread_create(&reader_tid, NULL, reader_start_routine, d);
-    timer_enable_signals();
-    if (ret)
-        goto fail5;
-
-    return;
-fail1:
-    shutdown("Invalid DS18B20 serial id, must not contain '/'");
-fail2:
-    shutdown("Invalid DS18B20 serial id, could not open for reading");
-fail3:
-    shutdown("Could not start DS18B20 reader thread (mutex init)");
-fail4:
-    shutdown("Could not start DS18B20 reader thread (cond init)");
-fail5:
-    shutdown("Could not start DS18B20 reader thread");
+    if (!w1_reader.started) {
+        // Batched conversion triggering is optional (it requires a
+        // bulk-read capable kernel w1_therm driver)
+        w1_reader.bulk_fd = open(W1_BULK_TRIGGER_PATH, O_WRONLY|O_CLOEXEC);
+        pthread_t reader_tid; // Not used
+        timer_disable_signals();
+        int ret = pthread_create(&reader_tid, NULL, reader_start_routine
+                                 , NULL);
+        timer_enable_signals();
+        if (ret)
+            shutdown("Could not start DS18B20 reader thread");
+        w1_reader.started = 1;
+    }
 }
 DECL_COMMAND(command_config_ds18b20,
              "config_ds18b20 oid=%c serial=%*s max_error_count=%c");
@@ -220,15 +238,16 @@ ds18_send_and_request(struct ds18_s *d, uint32_t next_begin_time, uint8_t oid)
         return;
     }
 
-    pthread_mutex_lock(&d->lock);
+    pthread_mutex_lock(&w1_reader.lock);
     if (d->status == W1_ERROR) {
         if (d->error_count > d->max_error_count) {
             try_shutdown("Error reading DS18B20 sensor");
-            pthread_mutex_unlock(&d->lock);
+            pthread_mutex_unlock(&w1_reader.lock);
             return;
         } else {
           sendf("ds18b20_result oid=%c next_clock=%u value=%i fault=%u"
                   , oid, next_begin_time, d->temperature, d->error_count);
+          d->request_time = request_time;
           d->status = W1_READ_REQUESTED;
         }
     } else if (d->status == W1_IDLE) {
@@ -241,14 +260,14 @@ ds18_send_and_request(struct ds18_s *d, uint32_t next_begin_time, uint8_t oid)
         sendf("ds18b20_result oid=%c next_clock=%u value=%i fault=%u"
               , oid, next_begin_time, d->temperature, 0);
         if (d->temperature < d->min_value || d->temperature > d->max_value) {
-            pthread_mutex_unlock(&d->lock);
+            pthread_mutex_unlock(&w1_reader.lock);
             try_shutdown("DS18B20 out of range");
             return;
         }
         d->request_time = request_time;
         d->status = W1_READ_REQUESTED;
         d->error_count = 0; //successful reading, reset error count
-    } else if (d->status == W1_READ_REQUESTED) {
+    } else if (d->status == W1_READ_REQUESTED || d->status == W1_READING) {
         // Reader thread is already reading (or will be soon).
         // This can happen if two queries come in quick enough
         // succession. Wait for the existing read to finish.
@@ -257,13 +276,13 @@ ds18_send_and_request(struct ds18_s *d, uint32_t next_begin_time, uint8_t oid)
         // is too far in the past.
         if (request_time.tv_sec - d->request_time.tv_sec > W1_READ_TIMEOUT_SEC)
         {
-            pthread_mutex_unlock(&d->lock);
+            pthread_mutex_unlock(&w1_reader.lock);
             try_shutdown("DS18B20 sensor didn't respond in time");
             return;
         }
     }
-    pthread_cond_signal(&d->cond);
-    pthread_mutex_unlock(&d->lock);
+    pthread_cond_signal(&w1_reader.cond);
+    pthread_mutex_unlock(&w1_reader.lock);
 }
 
 // task to read temperature and send response
@@ -21,6 +21,8 @@ static struct {
     time_t start_sec;
     // Flags for tracking irq_enable()/irq_disable()
     uint32_t must_wake_timers;
+    // Poll the clock directly instead of scheduling SIGALRM signals
+    uint32_t busy_poll;
     // Time of next software timer (also used to convert from ticks to systime)
     uint32_t next_wake_counter;
     struct timespec next_wake;
@@ -118,10 +120,21 @@ timer_read_time(void)
 void
 timer_kick(void)
 {
+    if (TimerInfo.busy_poll) {
+        writel(&TimerInfo.must_wake_timers, 1);
+        return;
+    }
     struct itimerspec it = { .it_interval = {0, 0}, .it_value = {0, 1} };
     timer_settime(TimerInfo.t_alarm, TIMER_ABSTIME, &it, NULL);
 }
 
+// Switch to busy-poll mode - meant for use with a dedicated cpu core
+void
+timer_enable_busypoll(void)
+{
+    TimerInfo.busy_poll = 1;
+}
+
 #define TIMER_IDLE_REPEAT_COUNT 100
 #define TIMER_REPEAT_COUNT 20
 
@@ -162,13 +175,14 @@ timer_dispatch(void)
             diff = next - timer_read_time();
     }
 
-    // Schedule SIGALRM signal
+    // Schedule SIGALRM signal (irq_poll() checks the clock in busy-poll mode)
     struct itimerspec it;
     it.it_interval = (struct timespec){0, 0};
     TimerInfo.next_wake = it.it_value = timespec_from_time(next);
     TimerInfo.next_wake_counter = next;
     TimerInfo.must_wake_timers = 0;
-    timer_settime(TimerInfo.t_alarm, TIMER_ABSTIME, &it, NULL);
+    if (!TimerInfo.busy_poll)
+        timer_settime(TimerInfo.t_alarm, TIMER_ABSTIME, &it, NULL);
 }
 
 // OS signal handler
@@ -267,6 +281,12 @@ irq_restore(irqstatus_t flag)
 void
 irq_wait(void)
 {
+    if (TimerInfo.busy_poll) {
+        // Spin checking the console and clock rather than sleep
+        console_poll();
+        irq_poll();
+        return;
+    }
     // Must atomically sleep until signaled
     if (!readl(&TimerInfo.must_wake_timers)) {
         timer_disable_signals();
@@ -280,6 +300,8 @@ irq_wait(void)
 void
 irq_poll(void)
 {
-    if (readl(&TimerInfo.must_wake_timers))
+    if (readl(&TimerInfo.must_wake_timers)
+        || (TimerInfo.busy_poll && !timer_is_before(
+                timer_read_time(), TimerInfo.next_wake_counter)))
         timer_dispatch();
 }
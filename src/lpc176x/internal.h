@@ -18,6 +18,7 @@
 #define PCLK_SSP0 21
 #define PCLK_UART3 25
 #define PCLK_I2C2 26
+#define PCLK_GPDMA 29
 #define PCLK_USB 31
 int is_enabled_pclock(uint32_t pclk);
 void enable_pclock(uint32_t pclk);
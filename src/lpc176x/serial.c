@@ -55,10 +55,17 @@ void
 UARTx_IRQHandler(void)
 {
     uint32_t iir = LPC_UARTx->IIR, status = iir & 0x0f;
-    if (status == 0x04)
-        serial_rx_byte(LPC_UARTx->RBR);
-    else if (status == 0x02)
+    if (status == 0x04 || status == 0x0c) {
+        // Rx fifo above watermark (or idle with pending bytes) -
+        // drain all available data with one irq invocation
+        uint8_t data[16];
+        uint_fast8_t pos = 0;
+        while (pos < sizeof(data) && LPC_UARTx->LSR & 0x01)
+            data[pos++] = LPC_UARTx->RBR;
+        serial_rx_data(data, pos);
+    } else if (status == 0x02) {
         kick_tx();
+    }
 }
 
 void
@@ -84,8 +91,8 @@ serial_init(void)
     LPC_UARTx->FDR = 0x10;
     LPC_UARTx->LCR = 3; // 8N1 ; clear DLAB bit
 
-    // Enable fifo
-    LPC_UARTx->FCR = 0x01;
+    // Enable and reset fifos with an 8 byte rx irq trigger level
+    LPC_UARTx->FCR = (2<<6) | 0x07;
 
     // Setup pins
     gpio_peripheral(GPIO_Rx, GPIO_FUNCTION_UARTx, 0);
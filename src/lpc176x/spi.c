@@ -4,6 +4,7 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include "autoconf.h" // CONFIG_WANT_SPI_DMA
 #include "command.h" // shutdown
 #include "gpio.h" // spi_setup
 #include "internal.h" // gpio_peripheral
@@ -99,3 +100,85 @@ spi_transfer(struct spi_config config, uint8_t receive_data
         }
     }
 }
+
+
+/****************************************************************
+ * GPDMA based transfers
+ ****************************************************************/
+#if CONFIG_WANT_SPI_DMA
+
+// GPDMA channels reserved for spi (channel 0 has the highest priority)
+#define SPI_DMA_RX_CHAN 0
+#define SPI_DMA_TX_CHAN 1
+
+#define GPDMA_CHAN(n) ((LPC_GPDMACH_TypeDef *)                  \
+                       (LPC_GPDMACH0_BASE + (n) * 0x20))
+
+// GPDMA channel control - byte transfers with a burst size of four
+// (the ssp fifo request watermark), memory side address increment
+#define GPDMA_CTRL_SRC_BURST4 (1 << 12)
+#define GPDMA_CTRL_DST_BURST4 (1 << 15)
+#define GPDMA_CTRL_SRC_INCR (1 << 26)
+#define GPDMA_CTRL_DST_INCR (1 << 27)
+// GPDMA channel config - enable with peripheral request routing
+#define GPDMA_CFG_ENABLE (1 << 0)
+#define GPDMA_CFG_SRC_PERIPH(p) ((p) << 1)
+#define GPDMA_CFG_DST_PERIPH(p) ((p) << 6)
+#define GPDMA_CFG_M2P (0x1 << 11)
+#define GPDMA_CFG_P2M (0x2 << 11)
+
+static uint8_t spi_dma_discard;
+
+// GPDMA peripheral request line for an ssp bus (0=SSP0 Tx, 1=SSP0 Rx,
+// 2=SSP1 Tx, 3=SSP1 Rx)
+static uint32_t
+spi_dma_periph(LPC_SSP_TypeDef *spi, int is_rx)
+{
+    return (spi == LPC_SSP0 ? 0 : 2) + is_rx;
+}
+
+// Begin a transfer using dma (caller polls spi_transfer_dma_check())
+void
+spi_transfer_dma_start(struct spi_config config, uint8_t receive_data
+                       , uint8_t len, uint8_t *data)
+{
+    if (!is_enabled_pclock(PCLK_GPDMA)) {
+        enable_pclock(PCLK_GPDMA);
+        LPC_GPDMA->DMACConfig = 0x01;
+    }
+    LPC_SSP_TypeDef *spi = config.spi;
+    spi->DMACR = 0x03; // RXDMAE | TXDMAE
+    LPC_GPDMA->DMACIntTCClear = LPC_GPDMA->DMACIntErrClr = (
+        (1 << SPI_DMA_RX_CHAN) | (1 << SPI_DMA_TX_CHAN));
+    // Received bytes are drained first so the rx fifo can not overrun
+    LPC_GPDMACH_TypeDef *rx = GPDMA_CHAN(SPI_DMA_RX_CHAN);
+    rx->DMACCSrcAddr = (uint32_t)&spi->DR;
+    rx->DMACCDestAddr = (uint32_t)(receive_data ? data : &spi_dma_discard);
+    rx->DMACCLLI = 0;
+    rx->DMACCControl = (len | GPDMA_CTRL_SRC_BURST4 | GPDMA_CTRL_DST_BURST4
+                        | (receive_data ? GPDMA_CTRL_DST_INCR : 0));
+    rx->DMACCConfig = (GPDMA_CFG_ENABLE | GPDMA_CFG_P2M
+                       | GPDMA_CFG_SRC_PERIPH(spi_dma_periph(spi, 1)));
+    LPC_GPDMACH_TypeDef *tx = GPDMA_CHAN(SPI_DMA_TX_CHAN);
+    tx->DMACCSrcAddr = (uint32_t)data;
+    tx->DMACCDestAddr = (uint32_t)&spi->DR;
+    tx->DMACCLLI = 0;
+    tx->DMACCControl = (len | GPDMA_CTRL_SRC_BURST4 | GPDMA_CTRL_DST_BURST4
+                        | GPDMA_CTRL_SRC_INCR);
+    tx->DMACCConfig = (GPDMA_CFG_ENABLE | GPDMA_CFG_M2P
+                       | GPDMA_CFG_DST_PERIPH(spi_dma_periph(spi, 0)));
+}
+
+// Report if a transfer started by spi_transfer_dma_start() has completed
+int
+spi_transfer_dma_check(struct spi_config config)
+{
+    LPC_SSP_TypeDef *spi = config.spi;
+    if (LPC_GPDMA->DMACEnbldChns & (1 << SPI_DMA_RX_CHAN)
+        || spi->SR & (1<<4)) // BSY
+        return 0;
+    spi->DMACR = 0;
+    return 1;
+}
+
+#endif // CONFIG_WANT_SPI_DMA
@@ -173,14 +173,14 @@ usb_read_packet(uint32_t ep, void *data, uint_fast8_t max_len)
     return plen;
 }
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     return usb_read_packet(EP2OUT, data, max_len);
 }
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     return usb_write_packet(EP5IN, data, len);
 }
@@ -90,6 +90,9 @@ struct neopixel_s {
     struct gpio_out pin;
     neopixel_time_t bit_max_ticks;
     uint32_t last_req_time, reset_min_ticks;
+#if CONFIG_HAVE_GPIO_HARD_NEOPIXEL
+    struct neopixel_hw *hw;
+#endif
     uint16_t data_size;
     uint8_t data[0];
 };
@@ -107,6 +110,11 @@ command_config_neopixel(uint32_t *args)
     n->data_size = data_size;
     n->bit_max_ticks = args[3];
     n->reset_min_ticks = args[4];
+#if CONFIG_HAVE_GPIO_HARD_NEOPIXEL
+    // Offload bit timing to hardware (fall back to bit-banging if
+    // all hardware channels are claimed)
+    n->hw = neopixel_hw_setup(args[1]);
+#endif
 }
 DECL_COMMAND(command_config_neopixel, "config_neopixel oid=%c pin=%u"
              " data_size=%hu bit_max_ticks=%u reset_min_ticks=%u");
@@ -122,6 +130,14 @@ send_data(struct neopixel_s *n)
         cur = timer_read_time();
     }
 
+#if CONFIG_HAVE_GPIO_HARD_NEOPIXEL
+    if (n->hw) {
+        int ret = neopixel_hw_send(n->hw, n->data, n->data_size);
+        n->last_req_time = timer_read_time();
+        return ret;
+    }
+#endif
+
     // Transmit data
     uint8_t *data = n->data;
     uint_fast16_t data_len = n->data_size;
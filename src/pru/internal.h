@@ -28,13 +28,31 @@
 
 #define ALT_PRU_PTR(ptr) ((typeof(ptr))((uint32_t)(ptr) ^ 0x2000))
 
+// Command descriptor (filled by PRU0, executed by PRU1)
+struct command_desc {
+    const struct command_parser *parser;
+    uint32_t args[16];
+};
+
+// Response descriptor (filled by PRU1, encoded and sent by PRU0)
+struct response_desc {
+    uint32_t encoder;
+    uint32_t args[16];
+};
+
+// Ring sizes must be a power of two (indexes are free running)
+#define COMMAND_RING_SIZE 4
+#define RESPONSE_RING_SIZE 4
+
 // Layout of shared memory
 struct shared_mem {
     uint32_t signal;
-    void *next_encoder_args;
-    uint32_t next_encoder;
-    const struct command_parser *next_command;
-    uint32_t next_command_args[16];
+    // Command descriptor ring (PRU0 writes push, PRU1 writes pull)
+    uint32_t command_push, command_pull;
+    struct command_desc command_ring[COMMAND_RING_SIZE];
+    // Response descriptor ring (PRU1 writes push, PRU0 writes pull)
+    uint32_t response_push, response_pull;
+    struct response_desc response_ring[RESPONSE_RING_SIZE];
     const struct command_parser *command_index;
     uint32_t command_index_size;
     const struct command_parser *shutdown_handler;
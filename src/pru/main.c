@@ -5,6 +5,7 @@
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
 #include <stdint.h> // uint32_t
+#include <string.h> // memcpy
 #include <pru/io.h> // read_r31
 #include <pru_iep.h> // CT_IEP
 
@@ -126,41 +127,76 @@ DECL_CONSTANT("RECEIVE_WINDOW", 496 - 1);
 void
 console_task(void)
 {
-    const struct command_parser *cp = SHARED_MEM->next_command;
-    if (!cp)
-        return;
-
-    if (sched_is_shutdown() && !(cp->flags & HF_IN_SHUTDOWN)) {
-        sched_report_shutdown();
-    } else {
-        void (*func)(uint32_t*) = cp->func;
-        func(SHARED_MEM->next_command_args);
+    uint32_t pull = SHARED_MEM->command_pull;
+    while (readl(&SHARED_MEM->command_push) != pull) {
+        struct command_desc *cd =
+            &SHARED_MEM->command_ring[pull % COMMAND_RING_SIZE];
+        const struct command_parser *cp = cd->parser;
+        if (sched_is_shutdown() && !(cp->flags & HF_IN_SHUTDOWN)) {
+            sched_report_shutdown();
+        } else {
+            void (*func)(uint32_t*) = cp->func;
+            func(cd->args);
+        }
+        // Return the descriptor to PRU0
+        pull++;
+        writel(&SHARED_MEM->command_pull, pull);
     }
-
-    writel(&SHARED_MEM->next_command, 0);
 }
 DECL_TASK(console_task);
 
+// Report if a message references memory that PRU0 must read at encode time
+static int
+message_has_pointer(const struct command_encoder *ce)
+{
+    uint32_t i, count = ce->num_params;
+    for (i=0; i<count; i++) {
+        uint32_t t = ce->param_types[i];
+        if (t == PT_string || t == PT_progmem_buffer || t == PT_buffer)
+            return 1;
+    }
+    return 0;
+}
+
 // Encode and transmit a "response" message
 void
 console_sendf(const struct command_encoder *ce, va_list args)
 {
-    SHARED_MEM->next_encoder_args = args;
-    writel(&SHARED_MEM->next_encoder, (uint32_t)ce);
+    // Wait for a free response descriptor (reread the push index each
+    // iteration as irq_poll() may recursively send a message)
+    uint32_t push, itd = in_timer_dispatch;
+    for (;;) {
+        push = SHARED_MEM->response_push;
+        if (push - readl(&SHARED_MEM->response_pull) < RESPONSE_RING_SIZE)
+            break;
+        if (!itd)
+            irq_poll();
+    }
+    struct response_desc *rd =
+        &SHARED_MEM->response_ring[push % RESPONSE_RING_SIZE];
+    memcpy(rd->args, args, sizeof(rd->args));
+    rd->encoder = (uint32_t)ce;
+    barrier();
+    writel(&SHARED_MEM->response_push, push + 1);
 
     // Signal PRU0 to transmit message - 20 | (18-16)  = 22 = 0010 0010
     write_r31(R31_WRITE_IRQ_SELECT | (KICK_PRU0_EVENT - R31_WRITE_IRQ_OFFSET));
-    uint32_t itd = in_timer_dispatch;
-    while (readl(&SHARED_MEM->next_encoder))
-        if (!itd)
-            irq_poll();
+
+    // Buffer and string parameters are read from local memory when
+    // PRU0 encodes the message - wait for that before the caller can
+    // reuse the referenced buffers
+    if (message_has_pointer(ce))
+        while ((int32_t)(readl(&SHARED_MEM->response_pull) - (push + 1)) < 0)
+            if (!itd)
+                irq_poll();
 }
 
 void
 console_shutdown(void)
 {
-    writel(&SHARED_MEM->next_command, 0);
-    writel(&SHARED_MEM->next_encoder, 0);
+    // Discard any pending commands and responses
+    writel(&SHARED_MEM->command_pull, readl(&SHARED_MEM->command_push));
+    writel(&SHARED_MEM->response_push, readl(&SHARED_MEM->response_pull));
     in_timer_dispatch = 0;
 }
 DECL_SHUTDOWN(console_shutdown);
@@ -65,19 +65,17 @@ finalize_transmit(int msglen)
 static void
 check_can_send(void)
 {
-    for (;;) {
-        uint32_t rce = readl(&SHARED_MEM->next_encoder);
-        if (!rce)
-            break;
-        // Copy va_args on pru1 for use on pru0
-        void *pru1_args = ALT_PRU_PTR(SHARED_MEM->next_encoder_args);
+    uint32_t pull = SHARED_MEM->response_pull;
+    while (readl(&SHARED_MEM->response_push) != pull) {
+        struct response_desc *rd =
+            &SHARED_MEM->response_ring[pull % RESPONSE_RING_SIZE];
+        // Copy descriptor args for use on pru0
         uint32_t local_args[16];
-        memcpy(local_args, pru1_args, sizeof(local_args));
-        const struct command_encoder *pru1_ce = ALT_PRU_PTR((void*)rce);
+        memcpy(local_args, rd->args, sizeof(local_args));
+        const struct command_encoder *pru1_ce =
+            ALT_PRU_PTR((void*)rd->encoder);
         struct command_encoder ce;
         memcpy(&ce, pru1_ce, sizeof(ce));
-        if (readl(&SHARED_MEM->next_encoder) != rce)
-            continue;
         // Fixup any pointers in va_args
         ce.param_types = ALT_PRU_PTR(ce.param_types);
         uint32_t pos=0, v, i, count = ce.num_params;
@@ -98,39 +96,60 @@ check_can_send(void)
         // Encode and build message
         uint8_t *data = get_transmit_ptr(&ce);
         int msglen = command_encode_and_frame(data, &ce, (void*)local_args);
-        if (readl(&SHARED_MEM->next_encoder) != rce)
-            continue;
-        writel(&SHARED_MEM->next_encoder, 0);
         finalize_transmit(msglen);
+        // Return the descriptor to PRU1
+        pull++;
+        writel(&SHARED_MEM->response_pull, pull);
     }
 }
 
-// Wait for PRU1 to finish processing a command
+// Ring the PRU1 doorbell
+static void
+kick_pru1(void)
+{
+    write_r31(R31_WRITE_IRQ_SELECT | (KICK_PRU1_EVENT - R31_WRITE_IRQ_OFFSET));
+}
+
+// Wait for PRU1 to drain the command descriptor ring
 static void
-wait_pru1_command(void)
+wait_pru1_commands(void)
 {
-    while (readl(&SHARED_MEM->next_command))
+    while (readl(&SHARED_MEM->command_pull) != SHARED_MEM->command_push)
         check_can_send();
     check_can_send();
 }
 
-// Signal PRU1 that a new command is ready
+// Claim the next free command descriptor (draining responses while waiting)
+static struct command_desc *
+claim_command_desc(void)
+{
+    uint32_t push = SHARED_MEM->command_push;
+    while (push - readl(&SHARED_MEM->command_pull) >= COMMAND_RING_SIZE) {
+        // Ring full - make sure PRU1 is awake and consuming
+        kick_pru1();
+        check_can_send();
+    }
+    return &SHARED_MEM->command_ring[push % COMMAND_RING_SIZE];
+}
+
+// Publish a filled command descriptor to PRU1
 static void
-send_pru1_command(const struct command_parser *cp)
+publish_command_desc(void)
 {
     barrier();
-    SHARED_MEM->next_command = cp;
-    barrier();
-    write_r31(R31_WRITE_IRQ_SELECT | (KICK_PRU1_EVENT - R31_WRITE_IRQ_OFFSET));
+    writel(&SHARED_MEM->command_push, SHARED_MEM->command_push + 1);
 }
 
 // Instruct PRU1 to shutdown
 static void
 send_pru1_shutdown(void)
 {
-    wait_pru1_command();
-    send_pru1_command(SHARED_MEM->shutdown_handler);
-    wait_pru1_command();
+    wait_pru1_commands();
+    struct command_desc *cd = claim_command_desc();
+    cd->parser = SHARED_MEM->shutdown_handler;
+    publish_command_desc();
+    kick_pru1();
+    wait_pru1_commands();
 }
 
 // Dispatch all the commands in a message block
@@ -144,15 +163,17 @@ do_dispatch(uint8_t *buf, uint32_t msglen)
         uint_fast16_t cmdid = command_parse_msgid(&p);
         const struct command_parser *cp = &SHARED_MEM->command_index[cmdid];
         if (!cmdid || cmdid >= SHARED_MEM->command_index_size
-            || cp->num_args > ARRAY_SIZE(SHARED_MEM->next_command_args)) {
+            || cp->num_args > ARRAY_SIZE(SHARED_MEM->command_ring[0].args)) {
             send_pru1_shutdown();
             return;
         }
-        p = command_parsef(p, msgend, cp, SHARED_MEM->next_command_args);
-
-        send_pru1_command(ALT_PRU_PTR(cp));
-        wait_pru1_command();
+        struct command_desc *cd = claim_command_desc();
+        p = command_parsef(p, msgend, cp, cd->args);
+        cd->parser = ALT_PRU_PTR(cp);
+        publish_command_desc();
     }
+    // One doorbell covers all the commands queued from this block
+    kick_pru1();
 }
 
 // See if there are commands from the host ready to be processed
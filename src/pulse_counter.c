@@ -4,6 +4,7 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include "autoconf.h" // CONFIG_HAVE_GPIO_HARD_COUNTER
 #include "basecmd.h" // oid_alloc
 #include "board/gpio.h" // struct gpio_in
 #include "board/irq.h" // irq_disable
@@ -18,6 +19,10 @@ struct counter {
     uint32_t count, last_count_time;
     uint8_t flags;
     struct gpio_in pin;
+#if CONFIG_HAVE_GPIO_HARD_COUNTER
+    struct gpio_counter hw_counter;
+    uint16_t last_raw;
+#endif
 };
 
 enum {
@@ -61,6 +66,46 @@ command_config_counter(uint32_t *args)
 DECL_COMMAND(command_config_counter,
              "config_counter oid=%c pin=%u pull_up=%c");
 
+#if CONFIG_HAVE_GPIO_HARD_COUNTER
+
+static uint_fast8_t
+counter_hw_event(struct timer *timer)
+{
+    struct counter *c = container_of(timer, struct counter, timer);
+
+    uint32_t time = c->timer.waketime;
+    uint16_t raw = gpio_counter_read(c->hw_counter);
+    uint16_t diff = raw - c->last_raw;
+    if (diff) {
+        c->last_raw = raw;
+        // The hardware counts rising edges - report both edges
+        c->count += 2 * (uint32_t)diff;
+        c->last_count_time = time;
+    }
+
+    if (timer_is_before(c->next_sample_time, time)) {
+        c->flags |= CF_PENDING;
+        c->next_sample_time = time + c->sample_ticks;
+        sched_wake_task(&counter_wake);
+    }
+
+    c->timer.waketime += c->poll_ticks;
+    return SF_RESCHEDULE;
+}
+
+void
+command_config_counter_hw(uint32_t *args)
+{
+    struct counter *c = oid_alloc(
+        args[0], command_config_counter, sizeof(*c));
+    c->hw_counter = gpio_counter_setup(args[1], args[2]);
+    c->timer.func = counter_hw_event;
+}
+DECL_COMMAND(command_config_counter_hw,
+             "config_counter_hw oid=%c pin=%u pull_up=%c");
+
+#endif
+
 void
 command_query_counter(uint32_t *args)
 {
@@ -96,4 +141,4 @@ counter_task(void)
               oid, waketime, count, count_time);
     }
 }
-DECL_TASK(counter_task);
+DECL_TASK_WAKE(counter_task, counter_wake);
@@ -104,6 +104,31 @@ command_queue_pwm_out(uint32_t *args)
 }
 DECL_COMMAND(command_queue_pwm_out, "queue_pwm_out oid=%c clock=%u value=%hu");
 
+// Read a big-endian 32bit value from a batched update buffer
+static uint32_t
+batch_read_u32(uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+        | ((uint32_t)p[2] << 8) | p[3];
+}
+
+void
+command_queue_pwm_out_batch(uint32_t *args)
+{
+    uint_fast8_t len = args[0];
+    uint8_t *data = command_decode_ptr(args[1]);
+    if (len % 7)
+        shutdown("Invalid queue_pwm_out_batch length");
+    while (len) {
+        uint32_t eargs[3] = { data[0], batch_read_u32(&data[1])
+                              , ((uint32_t)data[5] << 8) | data[6] };
+        command_queue_pwm_out(eargs);
+        data += 7;
+        len -= 7;
+    }
+}
+DECL_COMMAND(command_queue_pwm_out_batch, "queue_pwm_out_batch data=%*s");
+
 void
 pwm_shutdown(void)
 {
@@ -0,0 +1,48 @@
+// Hardware pulse counting using PWM slice edge counters on rp2040
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "command.h" // shutdown
+#include "gpio.h" // gpio_counter_setup
+#include "hardware/structs/pwm.h" // pwm_hw
+#include "hardware/structs/iobank0.h" // iobank0_hw
+#include "hardware/regs/resets.h" // RESETS_RESET_PWM_BITS
+#include "internal.h" // enable_pclock
+#include "sched.h" // sched_shutdown
+
+// Setup a PWM slice to count rising edges on the given pin
+struct gpio_counter
+gpio_counter_setup(uint8_t pin, int8_t pull_up)
+{
+    // Only PWM "B" channel pins can act as a counter clock input
+    if (pin >= 30 || !(pin & 1))
+        shutdown("Hardware counter requires a pwm channel B pin");
+    pwm_slice_hw_t *slice = &pwm_hw->slice[(pin >> 1) & 0x7];
+
+    if (!is_enabled_pclock(RESETS_RESET_PWM_BITS))
+        enable_pclock(RESETS_RESET_PWM_BITS);
+    if (slice->csr & PWM_CH0_CSR_EN_BITS)
+        shutdown("PWM slice already in use");
+
+    slice->div = 1 << PWM_CH0_DIV_INT_LSB;
+    slice->top = 0xffff;
+    slice->ctr = PWM_CH0_CTR_RESET;
+    slice->cc = PWM_CH0_CC_RESET;
+    slice->csr = (PWM_CH0_CSR_EN_BITS
+                  | (PWM_CH0_CSR_DIVMODE_VALUE_RISE
+                     << PWM_CH0_CSR_DIVMODE_LSB));
+
+    gpio_peripheral(pin, IO_BANK0_GPIO0_CTRL_FUNCSEL_VALUE_PWM_A_0, pull_up);
+
+    return (struct gpio_counter){ .slice = (void*)slice };
+}
+
+// Report the current raw count (wraps at 2^16)
+uint16_t
+gpio_counter_read(struct gpio_counter g)
+{
+    pwm_slice_hw_t *slice = g.slice;
+    return slice->ctr;
+}
@@ -37,6 +37,21 @@ gpio_peripheral(uint32_t gpio, int func, int pull_up)
     iobank0_hw->io[gpio].ctrl = func << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB;
 }
 
+// Claim an unused PIO1 state machine (shared by pio based backends)
+static uint8_t pio1_sm_claimed;
+
+int_fast8_t
+pio1_sm_alloc(void)
+{
+    uint_fast8_t sm;
+    for (sm = 0; sm < 4; sm++)
+        if (!(pio1_sm_claimed & (1 << sm))) {
+            pio1_sm_claimed |= 1 << sm;
+            return sm;
+        }
+    return -1;
+}
+
 // Convert a register and bit location back to an integer pin identifier
 static int
 mask_to_pin(void *sio, uint32_t mask)
@@ -28,6 +28,16 @@ struct gpio_pwm {
 struct gpio_pwm gpio_pwm_setup(uint8_t pin, uint32_t cycle_time, uint32_t val);
 void gpio_pwm_write(struct gpio_pwm g, uint32_t val);
 
+struct gpio_counter {
+    void *slice;
+};
+struct gpio_counter gpio_counter_setup(uint8_t pin, int8_t pull_up);
+uint16_t gpio_counter_read(struct gpio_counter g);
+
+struct neopixel_hw;
+struct neopixel_hw *neopixel_hw_setup(uint8_t pin);
+int neopixel_hw_send(struct neopixel_hw *h, uint8_t *data, uint_fast16_t len);
+
 struct gpio_adc {
     uint8_t chan;
 };
@@ -44,6 +54,9 @@ struct spi_config spi_setup(uint32_t bus, uint8_t mode, uint32_t rate);
 void spi_prepare(struct spi_config config);
 void spi_transfer(struct spi_config config, uint8_t receive_data
                   , uint8_t len, uint8_t *data);
+void spi_transfer_dma_start(struct spi_config config, uint8_t receive_data
+                            , uint8_t len, uint8_t *data);
+int spi_transfer_dma_check(struct spi_config config);
 
 struct i2c_config {
     void *i2c;
@@ -0,0 +1,104 @@
+// Hardware clocked HX711/HX717 reads using a PIO state machine
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "board/irq.h" // irq_poll
+#include "compiler.h" // ARRAY_SIZE
+#include "hardware/structs/pio.h" // pio1_hw
+#include "hardware/regs/resets.h" // RESETS_RESET_PIO1_BITS
+#include "internal.h" // pio1_sm_alloc
+#include "sensor_hx71x.h" // hx71x_hw_setup
+
+// A sample is read by pulsing the clock pin 'num_bits' times on a
+// 250ns cycle grid and shifting the data pin into the ISR after each
+// falling edge (autopush returns the bits once the last one arrives):
+//
+//      8: pull block           ; wait for a bit count
+//      9: out x, 32
+//     10: bitloop: set pins, 1 [1] ; sclk high (500ns)
+//     11: set pins, 0          ; sclk low
+//     12: in pins, 1           ; sample dout after the falling edge
+//     13: jmp x--, bitloop     ; (wraps to 8 when done)
+//
+// The program sits just above the stepper dma program in the PIO1
+// instruction memory (the neopixel program uses the top).
+#define HX71X_PROG_OFFSET 8
+static const uint16_t hx71x_program[] = {
+    0x80a0, 0x6020, 0xe101, 0xe000, 0x4001,
+    0x0040 | (HX71X_PROG_OFFSET + 2),
+};
+// State machine cycles per second (250ns grid)
+#define HX71X_SM_FREQ 4000000
+
+// All hx71x sensors share one state machine (reads are serialized in
+// task context)
+static int_fast8_t hx71x_sm = -1;
+static uint8_t hx71x_setup_done;
+
+#define GPIO_FUNC_PIO1 7
+#define GPIO_FUNC_SIO 5
+
+// Run an instruction on a (disabled) state machine
+static void
+hx71x_sm_exec(uint32_t sm, uint16_t instr)
+{
+    pio1_hw->sm[sm].instr = instr;
+}
+
+// Claim a PIO1 state machine and load the clocking program
+int
+hx71x_hw_setup(uint32_t dout_pin, uint32_t sclk_pin)
+{
+    if (hx71x_setup_done)
+        return hx71x_sm >= 0 ? 0 : -1;
+    hx71x_setup_done = 1;
+    int_fast8_t sm = pio1_sm_alloc();
+    if (sm < 0)
+        return -1;
+
+    if (!is_enabled_pclock(RESETS_RESET_PIO1_BITS))
+        enable_pclock(RESETS_RESET_PIO1_BITS);
+    uint32_t i;
+    for (i = 0; i < ARRAY_SIZE(hx71x_program); i++)
+        pio1_hw->instr_mem[HX71X_PROG_OFFSET + i] = hx71x_program[i];
+
+    // Run the state machine on the 250ns cycle grid
+    uint32_t sys_freq = get_pclock_frequency(RESETS_RESET_PIO1_BITS);
+    pio1_hw->ctrl &= ~(1 << sm);
+    pio1_hw->sm[sm].clkdiv = DIV_ROUND_UP(sys_freq, HX71X_SM_FREQ) << 16;
+    pio1_hw->sm[sm].execctrl = (((HX71X_PROG_OFFSET + 5) << 12) // wrap
+                                | (HX71X_PROG_OFFSET << 7));
+    hx71x_sm = sm;
+    return 0;
+}
+
+// Read 'num_bits' from a sensor (called from task context)
+uint32_t
+hx71x_hw_read(uint32_t dout_pin, uint32_t sclk_pin, uint_fast8_t num_bits)
+{
+    // Point the state machine at this sensor's pins
+    uint_fast8_t sm = hx71x_sm;
+    pio1_hw->ctrl &= ~(1 << sm);
+    pio1_hw->sm[sm].shiftctrl = ((1 << 16) // autopush
+                                 | ((num_bits & 0x1f) << 20)); // threshold
+    pio1_hw->sm[sm].pinctrl = ((1 << 26) | (sclk_pin << 5) // set: sclk pin
+                               | (dout_pin << 15)); // in: dout pin
+    hx71x_sm_exec(sm, 0xe081); // set pindirs, 1
+    hx71x_sm_exec(sm, 0xe000); // set pins, 0
+    hx71x_sm_exec(sm, 0x0000 | HX71X_PROG_OFFSET); // jmp to program start
+    gpio_peripheral(sclk_pin, GPIO_FUNC_PIO1, 0);
+
+    // Clock out the sample
+    pio1_hw->ctrl |= 1 << sm;
+    pio1_hw->txf[sm] = num_bits - 1;
+    while (pio1_hw->fstat & (1 << (8 + sm))) // rx fifo empty
+        irq_poll();
+    uint32_t bits_read = pio1_hw->rxf[sm];
+
+    // Return the clock pin to regular gpio control (it idles low)
+    pio1_hw->ctrl &= ~(1 << sm);
+    gpio_peripheral(sclk_pin, GPIO_FUNC_SIO, 0);
+    return bits_read;
+}
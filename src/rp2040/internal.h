@@ -14,8 +14,11 @@ void enable_pclock(uint32_t reset_bit);
 int is_enabled_pclock(uint32_t reset_bit);
 uint32_t get_pclock_frequency(uint32_t reset_bit);
 void gpio_peripheral(uint32_t gpio, int func, int pull_up);
+int_fast8_t pio1_sm_alloc(void);
 void bootrom_reboot_usb_bootloader(void);
 void bootrom_read_unique_id(uint8_t *out, uint32_t maxlen);
+void multicore_start(void);
+void TIMER0_IRQHandler(void);
 
 // Force a function to run from ram
 #define UNIQSEC __FILE__ "." __stringify(__LINE__)
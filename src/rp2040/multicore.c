@@ -0,0 +1,230 @@
+// Dual-core support for rp2040 - dispatch timers on the second core
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <setjmp.h> // setjmp
+#include <stdint.h> // uint32_t
+#include "board/armcm_boot.h" // armcm_enable_irq
+#include "board/irq.h" // irqstatus_t
+#include "compiler.h" // ARRAY_SIZE
+#include "hardware/structs/sio.h" // sio_hw
+#include "internal.h" // multicore_start
+#include "sched.h" // sched_try_shutdown, DECL_SHUTDOWN
+
+// Core1 runs only the timer irq (and the timer callbacks it invokes);
+// tasks, command parsing, and the usb/serial irqs stay on core0.  The
+// two cores synchronize through the irq_save() critical sections,
+// which become sections of a single hardware spinlock below.
+
+
+/****************************************************************
+ * Cross-core irq enable/disable
+ ****************************************************************/
+
+// Hardware spinlock backing all irq critical sections
+#define CROSS_LOCK_NUM 31
+
+// Per-core flag noting if this core currently owns the lock.  Nesting
+// is handled the same way as the primask in generic/armcm_irq.c - the
+// flag returned by irq_save() records whether the outermost section
+// ends at the matching irq_restore().  The acquire and release below
+// are thus idempotent, which also keeps them safe across the
+// longjmp() taken on a shutdown.
+static uint8_t lock_held[2];
+
+static void
+cross_lock_acquire(void)
+{
+    uint32_t cpu = sio_hw->cpuid;
+    if (lock_held[cpu])
+        return;
+    // Reading a spinlock register returns non-zero on lock success
+    while (!sio_hw->spinlock[CROSS_LOCK_NUM])
+        ;
+    lock_held[cpu] = 1;
+}
+
+static void
+cross_lock_release(void)
+{
+    uint32_t cpu = sio_hw->cpuid;
+    if (!lock_held[cpu])
+        return;
+    lock_held[cpu] = 0;
+    sio_hw->spinlock[CROSS_LOCK_NUM] = 0;
+    // Wake the other core if it is sleeping in irq_wait()
+    asm volatile("sev" ::: "memory");
+}
+
+void
+irq_disable(void)
+{
+    asm volatile("cpsid i" ::: "memory");
+    cross_lock_acquire();
+}
+
+void
+irq_enable(void)
+{
+    cross_lock_release();
+    asm volatile("cpsie i" ::: "memory");
+}
+
+irqstatus_t
+irq_save(void)
+{
+    irqstatus_t flag;
+    asm volatile("mrs %0, primask" : "=r" (flag) :: "memory");
+    irq_disable();
+    return flag;
+}
+
+void
+irq_restore(irqstatus_t flag)
+{
+    if (!flag)
+        cross_lock_release();
+    asm volatile("msr primask, %0" :: "r" (flag) : "memory");
+}
+
+void
+irq_wait(void)
+{
+    // Release the cross-core lock while sleeping - both an irq on
+    // this core and a critical section exit on the other core (which
+    // emits a sev) end the sleep
+    cross_lock_release();
+    asm volatile("cpsie i\n    wfe\n    cpsid i" ::: "memory");
+    cross_lock_acquire();
+}
+
+void
+irq_poll(void)
+{
+}
+
+// Clear the active irq if a shutdown happened in an irq handler
+void
+clear_active_irq(void)
+{
+    uint32_t psr;
+    asm volatile("mrs %0, psr" : "=r" (psr));
+    if (!(psr & 0x1ff))
+        // Shutdown did not occur in an irq - nothing to do.
+        return;
+    // Clear active irq status
+    psr = 1<<24; // T-bit
+    uint32_t temp;
+    asm volatile(
+        "  push { %1 }\n"
+        "  adr %0, 1f\n"
+        "  push { %0 }\n"
+        "  push { r0, r1, r2, r3, r4, lr }\n"
+        "  bx %2\n"
+        ".balign 4\n"
+        "1:\n"
+        : "=&r"(temp) : "r"(psr), "r"(0xfffffff9) : "r12", "cc");
+}
+DECL_SHUTDOWN(clear_active_irq);
+
+
+/****************************************************************
+ * Shutdown handling
+ ****************************************************************/
+
+// A shutdown raised in a timer callback on core1 can not jump into
+// core0's stack - it jumps back to core1_main() below, which forwards
+// the reason through the inter-core fifo.  Core0 receives it in an
+// irq and runs the regular shutdown sequence.
+static jmp_buf core1_shutdown_jmp;
+
+void *
+board_get_shutdown_jmp(void *main_jmp)
+{
+    if (sio_hw->cpuid)
+        return &core1_shutdown_jmp;
+    return main_jmp;
+}
+
+// Core0 irq handler for shutdown requests forwarded by core1
+void
+SIO_PROC0_IRQHandler(void)
+{
+    // Clear fifo error flags and extract the forwarded reason
+    sio_hw->fifo_st = 0;
+    while (sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS) {
+        uint32_t reason = sio_hw->fifo_rd;
+        sched_try_shutdown(reason);
+    }
+}
+
+
+/****************************************************************
+ * Core1 startup
+ ****************************************************************/
+
+static uint32_t core1_stack[512];
+
+// Core1 entry point - enable the timer irq and sleep
+static noinline void
+core1_main(void)
+{
+    int ret = setjmp(core1_shutdown_jmp);
+    if (ret) {
+        // A timer callback on this core raised a shutdown - forward
+        // the reason to core0 (which runs the shutdown handlers)
+        clear_active_irq();
+        while (!(sio_hw->fifo_st & SIO_FIFO_ST_RDY_BITS))
+            ;
+        sio_hw->fifo_wr = ret;
+        asm volatile("sev" ::: "memory");
+    }
+    armcm_enable_irq(TIMER0_IRQHandler, TIMER_IRQ_0_IRQn, 2);
+    irq_enable();
+    for (;;)
+        asm volatile("wfi" ::: "memory");
+}
+
+// Wake core1 out of its bootrom wait loop (rp2040 datasheet 2.8.2)
+static void
+core1_launch(void)
+{
+    extern uint32_t _ram_vectortable_start;
+    const uint32_t cmds[] = {
+        0, 0, 1, (uint32_t)&_ram_vectortable_start,
+        (uint32_t)&core1_stack[ARRAY_SIZE(core1_stack)],
+        (uint32_t)core1_main,
+    };
+    uint_fast8_t seq = 0;
+    while (seq < ARRAY_SIZE(cmds)) {
+        uint32_t cmd = cmds[seq];
+        if (!cmd) {
+            // Flush the read fifo before sending a zero
+            while (sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS)
+                (void)sio_hw->fifo_rd;
+            asm volatile("sev" ::: "memory");
+        }
+        while (!(sio_hw->fifo_st & SIO_FIFO_ST_RDY_BITS))
+            ;
+        sio_hw->fifo_wr = cmd;
+        asm volatile("sev" ::: "memory");
+        while (!(sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS))
+            asm volatile("wfe" ::: "memory");
+        uint32_t resp = sio_hw->fifo_rd;
+        seq = cmd == resp ? seq + 1 : 0;
+    }
+}
+
+// Start timer dispatch on core1 (called from timer_init() on core0)
+void
+multicore_start(void)
+{
+    core1_launch();
+    // Discard core1's launch acknowledgment and take shutdown requests
+    sio_hw->fifo_st = 0;
+    while (sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS)
+        (void)sio_hw->fifo_rd;
+    armcm_enable_irq(SIO_PROC0_IRQHandler, SIO_IRQ_PROC0_IRQn, 2);
+}
@@ -0,0 +1,118 @@
+// Hardware "neopixel" bit timing using a PIO state machine
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "board/irq.h" // irq_poll
+#include "command.h" // shutdown
+#include "compiler.h" // ARRAY_SIZE
+#include "gpio.h" // neopixel_hw_setup
+#include "hardware/structs/pio.h" // pio1_hw
+#include "hardware/regs/resets.h" // RESETS_RESET_PIO1_BITS
+#include "internal.h" // pio1_sm_alloc
+
+// Each bit is emitted by a small PIO program running on a 50ns cycle
+// grid (a 1250ns bit period).  A zero bit is high for 8 cycles
+// (400ns) and a one bit for 16 cycles (800ns), with the pin driven
+// via side-set so a stalled state machine idles low:
+//
+//     28: bitloop: out x, 1        side 0 [8]  ; low tail (450ns)
+//     29: jmp !x, do_zero          side 1 [7]  ; high pulse (400ns)
+//     30: jmp bitloop              side 1 [7]  ; extend high for a one
+//     31: do_zero: nop             side 0 [7]  ; extend low for a zero
+//
+// The program sits in the top of the PIO1 instruction memory (the
+// stepper dma program uses the bottom).
+#define NEO_PROG_OFFSET 28
+static const uint16_t neopixel_program[] = {
+    0x6821, 0x173f, 0x171c, 0xa742,
+};
+// State machine cycles per second (50ns grid)
+#define NEO_SM_FREQ 20000000
+
+struct neopixel_hw {
+    uint8_t sm;
+};
+
+static struct neopixel_hw hw_channels[4];
+static uint8_t neopixel_program_loaded;
+
+#define GPIO_FUNC_PIO1 7
+
+// Run an instruction on a (disabled) state machine
+static void
+neo_sm_exec(uint32_t sm, uint16_t instr)
+{
+    pio1_hw->sm[sm].instr = instr;
+}
+
+// Claim a PIO1 state machine and dedicate it to driving a led strip
+struct neopixel_hw *
+neopixel_hw_setup(uint8_t pin)
+{
+    int_fast8_t sm = pio1_sm_alloc();
+    if (sm < 0)
+        return NULL;
+    struct neopixel_hw *h = &hw_channels[sm];
+    h->sm = sm;
+
+    if (!is_enabled_pclock(RESETS_RESET_PIO1_BITS))
+        enable_pclock(RESETS_RESET_PIO1_BITS);
+    if (!neopixel_program_loaded) {
+        neopixel_program_loaded = 1;
+        uint32_t i;
+        for (i = 0; i < ARRAY_SIZE(neopixel_program); i++)
+            pio1_hw->instr_mem[NEO_PROG_OFFSET + i] = neopixel_program[i];
+    }
+
+    // Run the state machine on the 50ns cycle grid (16.8 fixed point)
+    uint32_t sys_freq = get_pclock_frequency(RESETS_RESET_PIO1_BITS);
+    uint32_t div256 = (uint64_t)sys_freq * 256 / NEO_SM_FREQ;
+    pio1_hw->ctrl &= ~(1 << sm);
+    pio1_hw->sm[sm].clkdiv = div256 << 8;
+    pio1_hw->sm[sm].execctrl = (31 << 12) | (NEO_PROG_OFFSET << 7); // wrap
+    pio1_hw->sm[sm].shiftctrl = ((1 << 17) // autopull
+                                 | (8 << 25) // pull threshold 8 bits
+                                 | (1 << 30)); // join tx fifo
+    // Drive the strip pin via both set (for init) and side-set mappings
+    pio1_hw->sm[sm].pinctrl = ((1 << 29) // side-set count
+                               | (1 << 26) | (pin << 5) // set: strip pin
+                               | (pin << 10)); // side-set: strip pin
+    neo_sm_exec(sm, 0xe081); // set pindirs, 1
+    neo_sm_exec(sm, 0xe000); // set pins, 0
+    neo_sm_exec(sm, 0x0000 | NEO_PROG_OFFSET); // jmp to program start
+    gpio_peripheral(pin, GPIO_FUNC_PIO1, 0);
+
+    // Enable - the state machine stalls (pin low) until data arrives
+    pio1_hw->ctrl |= 1 << sm;
+    return h;
+}
+
+// Transmit a full led strip update (blocks until transmission ends)
+int
+neopixel_hw_send(struct neopixel_hw *h, uint8_t *data, uint_fast16_t len)
+{
+    if (!len)
+        return 0;
+    uint_fast8_t sm = h->sm;
+    uint32_t stall_bit = 1 << (24 + sm); // fdebug txstall
+    pio1_hw->fdebug = stall_bit;
+    int ret = 0;
+    while (len--) {
+        while (pio1_hw->fstat & (1 << (16 + sm))) // tx fifo full
+            irq_poll();
+        if (!len && pio1_hw->fdebug & stall_bit)
+            // The state machine starved mid frame - data may have
+            // latched early, so report a failure (the host resends)
+            ret = -1;
+        pio1_hw->txf[sm] = (uint32_t)*data++ << 24;
+    }
+    // Wait for the frame to fully transmit (so the caller can track
+    // the start of the inter-frame reset time)
+    while (!(pio1_hw->fstat & (1 << (24 + sm)))) // tx fifo empty
+        irq_poll();
+    while (!(pio1_hw->fdebug & stall_bit))
+        irq_poll();
+    return ret;
+}
@@ -90,9 +90,13 @@ UARTx_IRQHandler(void)
 {
     uint32_t mis = UARTx->mis;
     if (mis & (UART_UARTMIS_RXMIS_BITS | UART_UARTMIS_RTMIS_BITS)) {
+        // Drain the receive fifo in one pass
+        uint8_t data[32];
+        uint_fast8_t pos = 0;
         do {
-            serial_rx_byte(UARTx->dr);
-        } while (!(UARTx->fr & UART_UARTFR_RXFE_BITS));
+            data[pos++] = UARTx->dr;
+        } while (pos < sizeof(data) && !(UARTx->fr & UART_UARTFR_RXFE_BITS));
+        serial_rx_data(data, pos);
     } else if (mis & UART_UARTMIS_TXMIS_BITS) {
         kick_tx();
     }
@@ -130,7 +134,8 @@ serial_init(void)
 
     // Enable fifo, set 8N1
     UARTx->lcr_h = UART_UARTLCR_H_FEN_BITS | UART_UARTLCR_H_WLEN_BITS;
-    UARTx->ifls = 0;
+    // Raise rx fifo irq at half full - the rx timeout irq bounds latency
+    UARTx->ifls = 2 << UART_UARTIFLS_RXIFLSEL_LSB;
     UARTx->cr = (UART_UARTCR_RXE_BITS | UART_UARTCR_TXE_BITS
                  | UART_UARTCR_UARTEN_BITS);
 
@@ -4,11 +4,14 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include "autoconf.h" // CONFIG_WANT_SPI_DMA
 #include "gpio.h" // spi_setup, spi_prepare, spi_transfer
 #include "command.h" // shutdown"
 #include "sched.h" // sched_shutdown"
 #include "internal.h" // pclock, gpio_peripheral
+#include "hardware/structs/dma.h" // dma_hw
 #include "hardware/structs/spi.h" // spi_hw_t
+#include "hardware/regs/dreq.h" // DREQ_SPI0_TX
 #include "hardware/regs/resets.h" // RESETS_RESET_SPI*_BITS
 #include "board/misc.h" // timer_is_before
 
@@ -152,3 +155,60 @@ spi_transfer(struct spi_config config, uint8_t receive_data,
            != SPI_SSPSR_TFE_BITS)
         ;
 }
+
+
+/****************************************************************
+ * DMA based transfers
+ ****************************************************************/
+#if CONFIG_WANT_SPI_DMA
+
+// DMA channels reserved for spi (step generation may use channels 0-3)
+#define SPI_DMA_TX_CHAN 10
+#define SPI_DMA_RX_CHAN 11
+
+static uint8_t spi_dma_discard;
+
+// Begin a transfer using dma (caller polls spi_transfer_dma_check())
+void
+spi_transfer_dma_start(struct spi_config config, uint8_t receive_data
+                       , uint8_t len, uint8_t *data)
+{
+    if (!is_enabled_pclock(RESETS_RESET_DMA_BITS))
+        enable_pclock(RESETS_RESET_DMA_BITS);
+    spi_hw_t *spi = config.spi;
+    uint32_t dreq_tx = spi == spi0_hw ? DREQ_SPI0_TX : DREQ_SPI1_TX;
+    uint32_t dreq_rx = spi == spi0_hw ? DREQ_SPI0_RX : DREQ_SPI1_RX;
+    spi->dmacr = SPI_SSPDMACR_TXDMAE_BITS | SPI_SSPDMACR_RXDMAE_BITS;
+    // Received bytes are drained first so the rx fifo can not overrun
+    dma_channel_hw_t *rx = &dma_hw->ch[SPI_DMA_RX_CHAN];
+    rx->read_addr = (uint32_t)&spi->dr;
+    rx->write_addr = (uint32_t)(receive_data ? data : &spi_dma_discard);
+    rx->transfer_count = len;
+    rx->ctrl_trig = (DMA_CH0_CTRL_TRIG_EN_BITS
+                     | (receive_data ? DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS : 0)
+                     | (SPI_DMA_RX_CHAN << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB)
+                     | (dreq_rx << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB));
+    dma_channel_hw_t *tx = &dma_hw->ch[SPI_DMA_TX_CHAN];
+    tx->read_addr = (uint32_t)data;
+    tx->write_addr = (uint32_t)&spi->dr;
+    tx->transfer_count = len;
+    tx->ctrl_trig = (DMA_CH0_CTRL_TRIG_EN_BITS
+                     | DMA_CH0_CTRL_TRIG_INCR_READ_BITS
+                     | (SPI_DMA_TX_CHAN << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB)
+                     | (dreq_tx << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB));
+}
+
+// Report if a transfer started by spi_transfer_dma_start() has completed
+int
+spi_transfer_dma_check(struct spi_config config)
+{
+    spi_hw_t *spi = config.spi;
+    dma_channel_hw_t *rx = &dma_hw->ch[SPI_DMA_RX_CHAN];
+    if (rx->ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS
+        || spi->sr & SPI_SSPSR_BSY_BITS)
+        return 0;
+    spi->dmacr = 0;
+    return 1;
+}
+
+#endif // CONFIG_WANT_SPI_DMA
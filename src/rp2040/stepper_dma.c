@@ -0,0 +1,272 @@
+// Hardware step pulse generation using PIO and DMA
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "autoconf.h" // CONFIG_CLOCK_FREQ
+#include "board/irq.h" // irq_disable
+#include "board/misc.h" // timer_read_time
+#include "command.h" // shutdown
+#include "compiler.h" // ARRAY_SIZE
+#include "hardware/structs/dma.h" // dma_hw
+#include "hardware/structs/iobank0.h" // iobank0_hw
+#include "hardware/structs/pio.h" // pio1_hw
+#include "hardware/regs/dreq.h" // DREQ_PIO1_TX0
+#include "hardware/regs/resets.h" // RESETS_RESET_PIO1_BITS
+#include "internal.h" // gpio_peripheral
+#include "sched.h" // struct timer
+#include "stepper.h" // stepper_dma_setup
+
+// Steps are emitted by a small PIO program that reads one 32-bit word
+// from its TX FIFO per step.  Bit 0 of the word drives the dir pin and
+// the remaining 31 bits give the delay (in mcu clock ticks) before the
+// step pulse.  The step pulse width is preloaded into the ISR register
+// so all state machines can share one program:
+//
+//     0: out pins, 1      ; update dir pin
+//     1: out x, 31        ; load inter-step delay
+//     2: mov y, isr       ; load pulse width
+//     3: set pins, 1      ; step high
+//     4: jmp y--, 4       ; hold pulse
+//     5: set pins, 0      ; step low
+//     6: jmp x--, 6       ; wait for next step (wraps to 0)
+//
+static const uint16_t step_program[] = {
+    0x6001, 0x603f, 0xa046, 0xe001, 0x0064, 0xe000, 0x0046,
+};
+#define PROG_WRAP_TOP (ARRAY_SIZE(step_program) - 1)
+// Fixed per-step overhead in state machine cycles (excluding x and y)
+#define PROG_FIXED_CYCLES 7
+// Cycles of pulse high time not counted by the y loop
+#define PROG_PULSE_BIAS 2
+
+#define NUM_CHANNELS 4
+// Words in each DMA submission buffer (two buffers per channel)
+#define CHUNK_WORDS 64
+
+struct stepper_dma {
+    uint8_t sm, started, fill, invert_step;
+    uint16_t fill_len, active_len;
+    // Conversion from mcu clock ticks to state machine cycles
+    uint32_t freq_num, freq_den, conv_rem;
+    uint32_t overhead_cycles;
+    // Absolute mcu clock time the first queued step should occur
+    uint32_t start_time;
+    // Words handed to the state machine and words in completed chunks
+    uint32_t pushed, submitted;
+    uint32_t step_pin, dir_pin;
+    uint32_t bufs[2][CHUNK_WORDS];
+};
+
+static struct stepper_dma channels[NUM_CHANNELS];
+static uint8_t step_program_loaded;
+
+#define GPIO_FUNC_PIO1 7
+#define GPIO_FUNC_SIO 5
+
+// Run an instruction on a (disabled) state machine
+static void
+sm_exec(uint32_t sm, uint16_t instr)
+{
+    pio1_hw->sm[sm].instr = instr;
+}
+
+// Claim PIO pin control of a gpio (with optional output inversion)
+static void
+pin_to_pio(uint32_t gpio, uint32_t invert)
+{
+    gpio_peripheral(gpio, GPIO_FUNC_PIO1, 0);
+    if (invert)
+        iobank0_hw->io[gpio].ctrl |= 1 << 8; // OUTOVER invert
+}
+
+// Setup a PIO state machine and DMA channel for step generation
+struct stepper_dma *
+stepper_dma_setup(uint32_t step_pin, uint32_t dir_pin, uint32_t invert_step
+                  , uint32_t step_pulse_ticks)
+{
+    // Claim a state machine (the matching dma channel number is used)
+    int_fast8_t chan = pio1_sm_alloc();
+    if (chan < 0 || chan >= NUM_CHANNELS)
+        return NULL;
+    struct stepper_dma *sd = &channels[chan];
+
+    if (!is_enabled_pclock(RESETS_RESET_PIO1_BITS))
+        enable_pclock(RESETS_RESET_PIO1_BITS);
+    if (!step_program_loaded) {
+        step_program_loaded = 1;
+        // Load the (shared) step program at offset zero
+        uint32_t i;
+        for (i = 0; i < ARRAY_SIZE(step_program); i++)
+            pio1_hw->instr_mem[i] = step_program[i];
+    }
+    if (!is_enabled_pclock(RESETS_RESET_DMA_BITS))
+        enable_pclock(RESETS_RESET_DMA_BITS);
+
+    // Determine mcu tick to state machine cycle conversion ratio
+    uint32_t sys_freq = get_pclock_frequency(RESETS_RESET_PIO1_BITS);
+    uint32_t a = sys_freq, b = CONFIG_CLOCK_FREQ;
+    while (b) {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    sd->freq_num = sys_freq / a;
+    sd->freq_den = CONFIG_CLOCK_FREQ / a;
+    uint32_t pulse_cycles = step_pulse_ticks * sd->freq_num / sd->freq_den;
+    if (pulse_cycles < PROG_PULSE_BIAS)
+        pulse_cycles = PROG_PULSE_BIAS;
+    sd->overhead_cycles = pulse_cycles + PROG_FIXED_CYCLES - PROG_PULSE_BIAS;
+    sd->step_pin = step_pin;
+    sd->dir_pin = dir_pin;
+    sd->invert_step = invert_step;
+
+    // Configure the state machine (runs at full system clock)
+    uint32_t sm = chan;
+    pio1_hw->ctrl &= ~(1 << sm);
+    pio1_hw->sm[sm].clkdiv = 1 << 16;
+    pio1_hw->sm[sm].execctrl = (PROG_WRAP_TOP << 12) | (0 << 7);
+    pio1_hw->sm[sm].shiftctrl = ((1 << 17) // autopull
+                                 | (1 << 19) // shift right
+                                 | (1 << 30)); // join tx fifo
+    // Output enables and initial pin state (via set/out mappings)
+    pio1_hw->sm[sm].pinctrl = (1 << 26) | (step_pin << 5);
+    sm_exec(sm, 0xe081); // set pindirs, 1
+    sm_exec(sm, 0xe000); // set pins, 0
+    pio1_hw->sm[sm].pinctrl = (1 << 26) | (dir_pin << 5);
+    sm_exec(sm, 0xe081); // set pindirs, 1
+    sm_exec(sm, 0xe000); // set pins, 0
+    pio1_hw->sm[sm].pinctrl = ((1 << 26) | (step_pin << 5) // set: step pin
+                               | (1 << 20) | dir_pin); // out: dir pin
+    // Preload the pulse width into ISR
+    pio1_hw->txf[sm] = pulse_cycles - PROG_PULSE_BIAS;
+    sm_exec(sm, 0x80a0); // pull block
+    sm_exec(sm, 0xa0c7); // mov isr, osr
+    pin_to_pio(step_pin, invert_step);
+    pin_to_pio(dir_pin, 0);
+
+    sd->sm = sm;
+    return sd;
+}
+
+// Report the number of words that may be queued without blocking
+int_fast16_t
+stepper_dma_space(struct stepper_dma *sd)
+{
+    return CHUNK_WORDS - sd->fill_len;
+}
+
+// Queue one step (delay given in mcu clock ticks)
+void
+stepper_dma_push(struct stepper_dma *sd, uint32_t interval, uint_fast8_t dir)
+{
+    // Convert mcu ticks to state machine cycles (tracking the
+    // remainder so rounding errors do not accumulate)
+    if (interval > (0xffffffff - sd->conv_rem) / sd->freq_num)
+        shutdown("Stepper dma interval too large");
+    uint32_t scaled = interval * sd->freq_num + sd->conv_rem;
+    uint32_t cycles = scaled / sd->freq_den;
+    sd->conv_rem = scaled % sd->freq_den;
+    uint32_t delay = 0;
+    if (cycles > sd->overhead_cycles)
+        delay = cycles - sd->overhead_cycles;
+    if (delay > 0x7fffffff)
+        delay = 0x7fffffff;
+    sd->bufs[sd->fill][sd->fill_len++] = (delay << 1) | (dir & 1);
+    sd->pushed++;
+}
+
+// Note the absolute mcu clock time of the first queued step
+void
+stepper_dma_start(struct stepper_dma *sd, uint32_t first_step_time)
+{
+    sd->start_time = first_step_time;
+}
+
+// Hand the current buffer to the DMA engine (if it is idle)
+void
+stepper_dma_flush(struct stepper_dma *sd)
+{
+    if (!sd->fill_len)
+        return;
+    dma_channel_hw_t *ch = &dma_hw->ch[sd->sm];
+    if (sd->started) {
+        if (ch->ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS)
+            // Previous chunk still transferring
+            return;
+        sd->submitted += sd->active_len;
+    } else {
+        // Reclaim the step/dir pins (a stop may have released them)
+        pin_to_pio(sd->step_pin, sd->invert_step);
+        pin_to_pio(sd->dir_pin, 0);
+        // Rewrite the first word so the initial delay is relative to
+        // the moment the state machine starts
+        uint32_t now = timer_read_time();
+        int32_t delta = sd->start_time - now;
+        if (delta < 0)
+            delta = 0;
+        uint32_t cycles = (uint32_t)delta * sd->freq_num / sd->freq_den;
+        uint32_t delay = 0;
+        if (cycles > sd->overhead_cycles)
+            delay = cycles - sd->overhead_cycles;
+        sd->bufs[sd->fill][0] = ((delay << 1) | (sd->bufs[sd->fill][0] & 1));
+    }
+    // Submit the filled buffer
+    ch->read_addr = (uint32_t)sd->bufs[sd->fill];
+    ch->write_addr = (uint32_t)&pio1_hw->txf[sd->sm];
+    ch->transfer_count = sd->fill_len;
+    ch->ctrl_trig = (DMA_CH0_CTRL_TRIG_EN_BITS
+                     | (2 << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB) // 32-bit
+                     | DMA_CH0_CTRL_TRIG_INCR_READ_BITS
+                     | (sd->sm << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB) // no chain
+                     | ((DREQ_PIO1_TX0 + sd->sm)
+                        << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB));
+    sd->active_len = sd->fill_len;
+    sd->fill ^= 1;
+    sd->fill_len = 0;
+    if (!sd->started) {
+        sd->started = 1;
+        pio1_hw->ctrl |= 1 << sd->sm;
+    }
+}
+
+// Report the number of queued steps not yet emitted on the step pin
+uint32_t
+stepper_dma_pending(struct stepper_dma *sd)
+{
+    if (!sd->started)
+        return sd->pushed;
+    dma_channel_hw_t *ch = &dma_hw->ch[sd->sm];
+    uint32_t in_hw = ch->transfer_count; // words dma has yet to copy
+    in_hw += (pio1_hw->flevel >> (sd->sm * 8)) & 0xf; // tx fifo words
+    uint32_t addr = pio1_hw->sm[sd->sm].addr;
+    uint32_t txstall = pio1_hw->fdebug & (1 << (24 + sd->sm));
+    if (!(addr == 0 && txstall) && addr < 3)
+        // A word is being processed but its step has not fired yet
+        in_hw++;
+    uint32_t done = sd->submitted + sd->active_len - in_hw;
+    return sd->pushed - done;
+}
+
+// Abort step generation and release the step/dir pins back to the gpio
+void
+stepper_dma_stop(struct stepper_dma *sd)
+{
+    // Abort any active DMA transfer
+    dma_hw->abort = 1 << sd->sm;
+    while (dma_hw->abort & (1 << sd->sm))
+        ;
+    // Stop the state machine and flush its FIFO
+    pio1_hw->ctrl &= ~(1 << sd->sm);
+    sm_exec(sd->sm, 0xe000); // set pins, 0
+    pio1_hw->sm[sd->sm].shiftctrl &= ~(1 << 30);
+    pio1_hw->sm[sd->sm].shiftctrl |= 1 << 30; // rejoin clears the fifo
+    sm_exec(sd->sm, 0x0000 | 0); // jmp 0 (reset program counter)
+    // Return the pins to regular gpio control
+    gpio_peripheral(sd->step_pin, GPIO_FUNC_SIO, 0);
+    gpio_peripheral(sd->dir_pin, GPIO_FUNC_SIO, 0);
+    sd->started = 0;
+    sd->pushed = sd->submitted = sd->active_len = sd->fill_len = 0;
+    sd->conv_rem = 0;
+}
@@ -62,7 +62,11 @@ timer_init(void)
     enable_pclock(RESETS_RESET_TIMER_BITS);
     timer_hw->timelw = 0;
     timer_hw->timehw = 0;
-    armcm_enable_irq(TIMER0_IRQHandler, TIMER_IRQ_0_IRQn, 2);
+    if (CONFIG_MULTICORE)
+        // Second core enables the timer irq on its own nvic
+        multicore_start();
+    else
+        armcm_enable_irq(TIMER0_IRQHandler, TIMER_IRQ_0_IRQn, 2);
     timer_hw->inte = 1;
     timer_kick();
     irq_enable();
@@ -99,8 +99,8 @@ dpram_memset(void *s, int c, size_t n)
 
 static uint32_t bulk_out_push_count;
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     // Check if there is a packet ready
     uint32_t bopc = bulk_out_push_count, bufnum = bopc & 1;
@@ -126,8 +126,8 @@ usb_read_bulk_out(void *data, uint_fast8_t max_len)
 
 static uint32_t bulk_in_pop_count;
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     // Check if there is room for this packet
     uint32_t bipc = bulk_in_pop_count, bufnum = bipc & 1;
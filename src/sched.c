@@ -24,6 +24,90 @@ static struct {
 } SchedStatus = {.timer_list = &periodic_timer, .last_insert = &periodic_timer};
 
 
+/****************************************************************
+ * Run time profiling
+ ****************************************************************/
+
+#if CONFIG_WANT_SCHED_PROFILE
+
+#define PROFILE_MAX_TASKS 32
+#define PROFILE_TIMER_SLOTS 16
+
+struct profile_entry {
+    void *func;
+    uint32_t count, max_ticks, total_ticks;
+};
+static struct profile_entry profile_tasks[PROFILE_MAX_TASKS];
+static struct profile_entry profile_timers[PROFILE_TIMER_SLOTS];
+
+// Invoke a task function, recording its run time (from generated code)
+void
+sched_profile_task(uint8_t idx, void (*func)(void))
+{
+    uint32_t start = timer_read_time();
+    func();
+    uint32_t elapsed = timer_read_time() - start;
+    if (idx >= PROFILE_MAX_TASKS)
+        return;
+    struct profile_entry *pe = &profile_tasks[idx];
+    pe->count++;
+    pe->total_ticks += elapsed;
+    if (elapsed > pe->max_ticks)
+        pe->max_ticks = elapsed;
+}
+
+// Record a timer callback run time (called from timer dispatch)
+static void
+profile_note_timer(void *func, uint32_t elapsed)
+{
+    uint_fast8_t i;
+    for (i=0; i<PROFILE_TIMER_SLOTS; i++) {
+        struct profile_entry *pe = &profile_timers[i];
+        if (pe->func != func) {
+            if (pe->func)
+                continue;
+            pe->func = func;
+        }
+        pe->count++;
+        pe->total_ticks += elapsed;
+        if (elapsed > pe->max_ticks)
+            pe->max_ticks = elapsed;
+        return;
+    }
+}
+
+void
+command_sched_profile_dump(uint32_t *args)
+{
+    uint_fast8_t clear = args[0], i;
+    for (i=0; i<PROFILE_MAX_TASKS; i++) {
+        struct profile_entry *pe = &profile_tasks[i];
+        if (!pe->count)
+            continue;
+        sendf("sched_profile_task id=%c count=%u max_ticks=%u total_ticks=%u"
+              , i, pe->count, pe->max_ticks, pe->total_ticks);
+        if (clear)
+            pe->count = pe->max_ticks = pe->total_ticks = 0;
+    }
+    for (i=0; i<PROFILE_TIMER_SLOTS; i++) {
+        struct profile_entry copy, *pe = &profile_timers[i];
+        irq_disable();
+        copy = *pe;
+        if (clear)
+            pe->count = pe->max_ticks = pe->total_ticks = 0;
+        irq_enable();
+        if (!copy.count)
+            continue;
+        sendf("sched_profile_timer func=%u count=%u max_ticks=%u"
+              " total_ticks=%u", (uint32_t)(uintptr_t)copy.func
+              , copy.count, copy.max_ticks, copy.total_ticks);
+    }
+}
+DECL_COMMAND(command_sched_profile_dump, "sched_profile_dump clear=%c");
+
+#endif // CONFIG_WANT_SCHED_PROFILE
+
+
 /****************************************************************
  * Timers
  ****************************************************************/
@@ -63,6 +147,189 @@ static struct timer sentinel_timer = {
     .waketime = 0x80000000,
 };
 
+// The deleted timer is used when deleting an active timer.
+static uint_fast8_t
+deleted_event(struct timer *t)
+{
+    return SF_DONE;
+}
+
+static struct timer deleted_timer = {
+    .func = deleted_event,
+};
+
+// Ticks reserved ahead of an urgent timer - a deferrable timer
+// callback is only started when no urgent timer is due within this
+// window, so a deferrable callback that completes within it can never
+// delay an urgent timer (see TF_DEFERRABLE).
+#define TIMER_TIER_GUARD timer_from_us(50)
+
+#if CONFIG_WANT_TIMER_HEAP
+
+// Active timers are stored in a 4-ary min-heap ordered by waketime
+#define TIMER_HEAP_SIZE 128
+static struct timer *timer_heap[TIMER_HEAP_SIZE] = { &periodic_timer };
+static int_fast16_t timer_heap_count = 1;
+
+// Move the timer at 'pos' towards the heap root until ordered
+static int_fast16_t
+heap_sift_up(int_fast16_t pos)
+{
+    struct timer *t = timer_heap[pos];
+    while (pos) {
+        int_fast16_t parent = (pos - 1) / 4;
+        if (!timer_is_before(t->waketime, timer_heap[parent]->waketime))
+            break;
+        timer_heap[pos] = timer_heap[parent];
+        pos = parent;
+    }
+    timer_heap[pos] = t;
+    return pos;
+}
+
+// Move the timer at 'pos' away from the heap root until ordered
+static void
+heap_sift_down(int_fast16_t pos)
+{
+    struct timer *t = timer_heap[pos];
+    for (;;) {
+        int_fast16_t best = pos, i = pos * 4 + 1, end = i + 4;
+        uint32_t best_waketime = t->waketime;
+        if (end > timer_heap_count)
+            end = timer_heap_count;
+        for (; i < end; i++)
+            if (timer_is_before(timer_heap[i]->waketime, best_waketime)) {
+                best = i;
+                best_waketime = timer_heap[i]->waketime;
+            }
+        if (best == pos)
+            break;
+        timer_heap[pos] = timer_heap[best];
+        pos = best;
+    }
+    timer_heap[pos] = t;
+}
+
+// Schedule a function call at a supplied time.
+void
+sched_add_timer(struct timer *add)
+{
+    uint32_t waketime = add->waketime;
+    irqstatus_t flag = irq_save();
+    if (unlikely(timer_heap_count >= TIMER_HEAP_SIZE))
+        shutdown("Timer heap full");
+    timer_heap[timer_heap_count] = add;
+    int_fast16_t pos = heap_sift_up(timer_heap_count++);
+    if (unlikely(!pos)) {
+        // This timer is before all other scheduled timers
+        if (timer_is_before(waketime, timer_read_time()))
+            try_shutdown("Timer too close");
+        timer_kick();
+    }
+    irq_restore(flag);
+}
+
+// Remove a timer that may be live.
+void
+sched_del_timer(struct timer *del)
+{
+    irqstatus_t flag = irq_save();
+    if (timer_heap[0] == del) {
+        // Deleting the next timer - swap in deleted_timer so an
+        // already armed hardware irq for this waketime stays harmless
+        deleted_timer.waketime = del->waketime;
+        timer_heap[0] = &deleted_timer;
+    } else {
+        // Find and remove from the heap (if present)
+        int_fast16_t pos;
+        for (pos = 1; pos < timer_heap_count; pos++) {
+            if (timer_heap[pos] != del)
+                continue;
+            timer_heap[pos] = timer_heap[--timer_heap_count];
+            if (pos < timer_heap_count)
+                heap_sift_down(heap_sift_up(pos));
+            break;
+        }
+    }
+    irq_restore(flag);
+}
+
+#if CONFIG_WANT_TIMER_TIERS
+// Check if a deferrable timer must yield to an imminent urgent timer.
+// On yield the timer is pushed just past the urgent timer's waketime.
+static uint_fast8_t
+timer_defer_check(struct timer *t)
+{
+    // Find the soonest pending urgent timer
+    uint32_t next_urgent = 0;
+    uint_fast8_t found = 0;
+    int_fast16_t i;
+    for (i = 1; i < timer_heap_count; i++) {
+        struct timer *pos = timer_heap[i];
+        if (pos->flags & TF_DEFERRABLE)
+            continue;
+        if (!found || timer_is_before(pos->waketime, next_urgent)) {
+            next_urgent = pos->waketime;
+            found = 1;
+        }
+    }
+    if (!found
+        || timer_is_before(timer_read_time() + TIMER_TIER_GUARD, next_urgent))
+        return 0;
+    // Resume strictly after the urgent timer so it dispatches first
+    t->waketime = next_urgent + 1;
+    return 1;
+}
+#endif
+
+// Invoke the next timer - called from board hardware irq code.
+unsigned int
+sched_timer_dispatch(void)
+{
+    // Invoke timer callback
+    struct timer *t = timer_heap[0];
+    uint_fast8_t res;
+#if CONFIG_WANT_TIMER_TIERS
+    if (unlikely(t->flags & TF_DEFERRABLE) && timer_defer_check(t)) {
+        // Yield to an imminent urgent timer - reschedule without running
+        heap_sift_down(0);
+        return timer_heap[0]->waketime;
+    }
+#endif
+#if CONFIG_WANT_SCHED_PROFILE
+    void *tfunc = (CONFIG_INLINE_STEPPER_HACK && !t->func
+                   ? (void*)stepper_event : (void*)t->func);
+    uint32_t profile_start = timer_read_time();
+#endif
+    if (CONFIG_INLINE_STEPPER_HACK && likely(!t->func))
+        res = stepper_event(t);
+    else
+        res = t->func(t);
+#if CONFIG_WANT_SCHED_PROFILE
+    profile_note_timer(tfunc, timer_read_time() - profile_start);
+#endif
+
+    // Update the heap (rescheduling current timer if necessary)
+    if (unlikely(res == SF_DONE))
+        timer_heap[0] = timer_heap[--timer_heap_count];
+    heap_sift_down(0);
+    return timer_heap[0]->waketime;
+}
+
+// Remove all user timers
+void
+sched_timer_reset(void)
+{
+    // Keep deleted_timer first so an already armed irq stays harmless
+    deleted_timer.waketime = periodic_timer.waketime;
+    timer_heap[0] = &deleted_timer;
+    timer_heap[1] = &periodic_timer;
+    timer_heap_count = 2;
+    timer_kick();
+}
+
+#else
+
 // Find position for a timer in timer_list and insert it
 static void __always_inline
 insert_timer(struct timer *pos, struct timer *t, uint32_t waketime)
@@ -106,17 +373,6 @@ sched_add_timer(struct timer *add)
     irq_restore(flag);
 }
 
-// The deleted timer is used when deleting an active timer.
-static uint_fast8_t
-deleted_event(struct timer *t)
-{
-    return SF_DONE;
-}
-
-static struct timer deleted_timer = {
-    .func = deleted_event,
-};
-
 // Remove a timer that may be live.
 void
 sched_del_timer(struct timer *del)
@@ -142,6 +398,25 @@ sched_del_timer(struct timer *del)
     irq_restore(flag);
 }
 
+#if CONFIG_WANT_TIMER_TIERS
+// Check if a deferrable timer must yield to an imminent urgent timer.
+// On yield the timer is pushed to the urgent timer's waketime (the
+// sorted insert places it after all equal waketimes).
+static uint_fast8_t
+timer_defer_check(struct timer *t)
+{
+    // The list is sorted - the first non-deferrable timer is soonest
+    struct timer *pos = t->next;
+    while (pos->flags & TF_DEFERRABLE)
+        pos = pos->next;
+    uint32_t next_urgent = pos->waketime;
+    if (timer_is_before(timer_read_time() + TIMER_TIER_GUARD, next_urgent))
+        return 0;
+    t->waketime = next_urgent;
+    return 1;
+}
+#endif
+
 // Invoke the next timer - called from board hardware irq code.
 unsigned int
 sched_timer_dispatch(void)
@@ -150,6 +425,24 @@ sched_timer_dispatch(void)
     struct timer *t = SchedStatus.timer_list;
     uint_fast8_t res;
     uint32_t updated_waketime;
+#if CONFIG_WANT_TIMER_TIERS
+    if (unlikely(t->flags & TF_DEFERRABLE) && timer_defer_check(t)) {
+        // Yield to an imminent urgent timer - reschedule without running
+        unsigned int next_waketime = t->next->waketime;
+        SchedStatus.timer_list = t->next;
+        struct timer *pos = SchedStatus.last_insert;
+        if (timer_is_before(t->waketime, pos->waketime))
+            pos = SchedStatus.timer_list;
+        insert_timer(pos, t, t->waketime);
+        SchedStatus.last_insert = t;
+        return next_waketime;
+    }
+#endif
+#if CONFIG_WANT_SCHED_PROFILE
+    void *tfunc = (CONFIG_INLINE_STEPPER_HACK && !t->func
+                   ? (void*)stepper_event : (void*)t->func);
+    uint32_t profile_start = timer_read_time();
+#endif
     if (CONFIG_INLINE_STEPPER_HACK && likely(!t->func)) {
         res = stepper_event(t);
         updated_waketime = t->waketime;
@@ -157,6 +450,9 @@ sched_timer_dispatch(void)
         res = t->func(t);
         updated_waketime = t->waketime;
     }
+#if CONFIG_WANT_SCHED_PROFILE
+    profile_note_timer(tfunc, timer_read_time() - profile_start);
+#endif
 
     // Update timer_list (rescheduling current timer if necessary)
     unsigned int next_waketime = updated_waketime;
@@ -189,6 +485,8 @@ sched_timer_reset(void)
     timer_kick();
 }
 
+#endif // !CONFIG_WANT_TIMER_HEAP
+
 
 /****************************************************************
  * Tasks
@@ -198,11 +496,17 @@ sched_timer_reset(void)
 #define TS_REQUESTED 0
 #define TS_RUNNING   1
 
+// Bitmap of tasks woken since the last dispatch pass
+static uint32_t tasks_wake_bitmap;
+
 // Note that at least one task is ready to run
 void
 sched_wake_tasks(void)
 {
+    irqstatus_t flag = irq_save();
     SchedStatus.tasks_status = TS_REQUESTED;
+    tasks_wake_bitmap = ~(uint32_t)0;
+    irq_restore(flag);
 }
 
 // Check if tasks busy (called from low-level timer dispatch code)
@@ -220,10 +524,25 @@ sched_check_set_tasks_busy(void)
 void
 sched_wake_task(struct task_wake *w)
 {
-    sched_wake_tasks();
+    uint32_t mask = w->task_mask;
+    irqstatus_t flag = irq_save();
+    SchedStatus.tasks_status = TS_REQUESTED;
+    tasks_wake_bitmap |= mask ? mask : ~(uint32_t)0;
+    irq_restore(flag);
     writeb(&w->wake, 1);
 }
 
+// Claim the woken task bitmap (used by generated task dispatch code)
+uint32_t
+sched_claim_woken_tasks(void)
+{
+    irqstatus_t flag = irq_save();
+    uint32_t bitmap = tasks_wake_bitmap;
+    tasks_wake_bitmap = 0;
+    irq_restore(flag);
+    return bitmap;
+}
+
 // Check if a task is ready to run (as indicated by sched_wake_task)
 uint8_t
 sched_check_wake(struct task_wake *w)
@@ -328,12 +647,23 @@ sched_try_shutdown(uint_fast8_t reason)
 
 static jmp_buf shutdown_jmp;
 
+#if CONFIG_HAVE_SECONDARY_CORE
+// On boards running code on a second cpu core a shutdown raised there
+// must not jump into the main core's stack - the board code selects
+// the jmp_buf for the executing core (see rp2040/multicore.c)
+void *board_get_shutdown_jmp(void *main_jmp);
+#endif
+
 // Force the machine to immediately run the shutdown handlers
 void
 sched_shutdown(uint_fast8_t reason)
 {
     irq_disable();
+#if CONFIG_HAVE_SECONDARY_CORE
+    longjmp(*(jmp_buf*)board_get_shutdown_jmp(&shutdown_jmp), reason);
+#else
     longjmp(shutdown_jmp, reason);
+#endif
 }
 
 
@@ -2,12 +2,22 @@
 #define __SCHED_H
 
 #include <stdint.h> // uint32_t
+#include "autoconf.h" // CONFIG_WANT_SCHED_PROFILE
 #include "ctr.h" // DECL_CTR
 
 // Declare an init function (called at firmware startup)
 #define DECL_INIT(FUNC) _DECL_CALLLIST(ctr_run_initfuncs, FUNC)
 // Declare a task function (called periodically during normal runtime)
 #define DECL_TASK(FUNC) _DECL_CALLLIST(ctr_run_taskfuncs, FUNC)
+// Declare a task function with a dedicated wake struct - the dispatch
+// loop will only visit the task when its wake flag has been set
+#define DECL_TASK_WAKE(FUNC, WAKE)                                      \
+    void FUNC ## _mask_init(void) {                                     \
+        extern const uint32_t ctr_taskwake_mask_ ## FUNC;               \
+        (WAKE).task_mask = ctr_taskwake_mask_ ## FUNC;                  \
+    }                                                                   \
+    DECL_CTR("_DECL_TASKWAKE " __stringify(FUNC)                        \
+             " " __stringify(FUNC ## _mask_init))
 // Declare a shutdown function (called on an emergency stop)
 #define DECL_SHUTDOWN(FUNC) _DECL_CALLLIST(ctr_run_shutdownfuncs, FUNC)
 
@@ -16,15 +26,34 @@ struct timer {
     struct timer *next;
     uint_fast8_t (*func)(struct timer*);
     uint32_t waketime;
+    uint8_t flags;
 };
 
 enum { SF_DONE=0, SF_RESCHEDULE=1 };
 
+// Timer flags
+enum {
+    // Timer may be delayed when an urgent timer is imminent (see
+    // CONFIG_WANT_TIMER_TIERS) - for housekeeping and bulk sensor
+    // timers whose callbacks tolerate extra scheduling jitter
+    TF_DEFERRABLE = 1<<0,
+};
+
 // Task waking struct
 struct task_wake {
     uint8_t wake;
+    // Dispatch bitmap bit assigned via DECL_TASK_WAKE (zero wakes all tasks)
+    uint32_t task_mask;
 };
 
+// Task invocation helper (used by generated ctr_run_taskfuncs code)
+#if CONFIG_WANT_SCHED_PROFILE
+void sched_profile_task(uint8_t idx, void (*func)(void));
+#define sched_run_task(idx, func) sched_profile_task(idx, func)
+#else
+#define sched_run_task(idx, func) func()
+#endif
+
 // sched.c
 void sched_add_timer(struct timer*);
 void sched_del_timer(struct timer *del);
@@ -34,6 +63,7 @@ void sched_wake_tasks(void);
 uint8_t sched_check_set_tasks_busy(void);
 void sched_wake_task(struct task_wake *w);
 uint8_t sched_check_wake(struct task_wake *w);
+uint32_t sched_claim_woken_tasks(void);
 uint8_t sched_is_shutdown(void);
 void sched_clear_shutdown(void);
 void sched_try_shutdown(uint_fast8_t reason);
@@ -131,6 +131,68 @@ command_sdio_write_data(uint32_t *args)
 DECL_COMMAND(command_sdio_write_data
              , "sdio_write_data oid=%c cmd=%c argument=%u");
 
+void
+command_sdio_read_data_blocks(uint32_t *args)
+{
+    uint8_t oid = args[0];
+    uint8_t cmd = args[1];
+    uint32_t argument = args[2];
+    uint32_t blocks = args[3];
+    struct sdiodev_s *sdio = sdiodev_oid_lookup(oid);
+    uint32_t timeout = TIMEOUT_MSEC*sdio->speed/1000;
+    uint32_t data_len = blocks * sdio->blocksize;
+    uint8_t err = 0;
+    if (!blocks || data_len > sizeof(sdio->data_buffer)) {
+        data_len = 0;
+    } else {
+        err = sdio_prepare_data_transfer(sdio->sdio_config, 1, blocks
+                                         , sdio->blocksize, timeout);
+        if (err == 0)
+            err = sdio_send_command(sdio->sdio_config, cmd, argument
+                                    , 1, NULL, NULL);
+        if (err == 0)
+            err = sdio_read_data(sdio->sdio_config, sdio->data_buffer
+                                 , blocks, sdio->blocksize);
+        if (err != 0)
+            data_len = 0;
+    }
+    sendf("sdio_read_data_blocks_response oid=%c error=%c read=%u"
+          , oid, err, data_len);
+}
+DECL_COMMAND(command_sdio_read_data_blocks
+             , "sdio_read_data_blocks oid=%c cmd=%c argument=%u blocks=%c");
+
+void
+command_sdio_write_data_blocks(uint32_t *args)
+{
+    uint8_t oid = args[0];
+    uint8_t cmd = args[1];
+    uint32_t argument = args[2];
+    uint32_t blocks = args[3];
+    struct sdiodev_s *sdio = sdiodev_oid_lookup(oid);
+    uint32_t timeout = TIMEOUT_MSEC*sdio->speed/1000;
+    uint32_t data_len = blocks * sdio->blocksize;
+    uint8_t err = 0;
+    if (!blocks || data_len > sizeof(sdio->data_buffer)) {
+        data_len = 0;
+    } else {
+        err = sdio_prepare_data_transfer(sdio->sdio_config, 0, blocks
+                                         , sdio->blocksize, timeout);
+        if (err == 0)
+            err = sdio_send_command(sdio->sdio_config, cmd, argument
+                                    , 1, NULL, NULL);
+        if (err == 0)
+            err = sdio_write_data(sdio->sdio_config, sdio->data_buffer
+                                  , blocks, sdio->blocksize);
+        if (err != 0)
+            data_len = 0;
+    }
+    sendf("sdio_write_data_blocks_response oid=%c error=%c write=%u"
+          , oid, err, data_len);
+}
+DECL_COMMAND(command_sdio_write_data_blocks
+             , "sdio_write_data_blocks oid=%c cmd=%c argument=%u blocks=%c");
+
 void
 command_sdio_read_data_buffer(uint32_t *args)
 {
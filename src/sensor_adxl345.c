@@ -5,6 +5,8 @@
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
 #include <string.h> // memcpy
+#include "autoconf.h" // CONFIG_WANT_SPI_DMA
+#include "board/gpio.h" // gpio_in_setup
 #include "board/irq.h" // irq_disable
 #include "board/misc.h" // timer_read_time
 #include "basecmd.h" // oid_alloc
@@ -19,10 +21,14 @@ struct adxl345 {
     struct spidev_s *spi;
     uint8_t flags;
     struct sensor_bulk sb;
+#if CONFIG_WANT_SPI_DMA
+    struct spidev_dma_request dreq;
+    uint8_t msg[9];
+#endif
 };
 
 enum {
-    AX_PENDING = 1<<0,
+    AX_PENDING = 1<<0, AX_DMA = 1<<1, AX_DMA_DONE = 1<<2,
 };
 
 static struct task_wake adxl345_wake;
@@ -47,6 +53,29 @@ command_config_adxl345(uint32_t *args)
 }
 DECL_COMMAND(command_config_adxl345, "config_adxl345 oid=%c spi_oid=%c");
 
+#if CONFIG_HAVE_GPIO_IRQ && CONFIG_WANT_GPIO_IRQ
+// Handler invoked on rising edges of the sensor's fifo watermark pin
+static void
+adxl345_irq(void *data)
+{
+    struct adxl345 *ax = data;
+    ax->flags |= AX_PENDING;
+    sched_wake_task(&adxl345_wake);
+}
+
+// Wake the drain task directly from the sensor's INT pin
+void
+command_attach_adxl345_irq(uint32_t *args)
+{
+    struct adxl345 *ax = oid_lookup(args[0], command_config_adxl345);
+    struct gpio_in pin = gpio_in_setup(args[1], 0);
+    if (gpio_in_attach_irq(pin, adxl345_irq, ax) < 0)
+        shutdown("adxl345 irq line already in use");
+}
+DECL_COMMAND(command_attach_adxl345_irq
+             , "attach_adxl345_irq oid=%c int_pin=%u");
+#endif
+
 // Helper code to reschedule the adxl345_event() timer
 static void
 adxl_reschedule_timer(struct adxl345 *ax)
@@ -67,13 +96,10 @@ adxl_reschedule_timer(struct adxl345 *ax)
 
 #define BYTES_PER_SAMPLE 5
 
-// Query accelerometer data
+// Extract a sample from a completed fifo readback
 static void
-adxl_query(struct adxl345 *ax, uint8_t oid)
+adxl_process(struct adxl345 *ax, uint8_t oid, uint8_t *msg)
 {
-    // Read data
-    uint8_t msg[9] = { AR_DATAX0 | AM_READ | AM_MULTI, 0, 0, 0, 0, 0, 0, 0, 0 };
-    spidev_transfer(ax->spi, 1, sizeof(msg), msg);
     // Extract x, y, z measurements
     uint_fast8_t fifo_status = msg[8] & ~0x80; // Ignore trigger bit
     uint8_t *d = &ax->sb.data[ax->sb.data_count];
@@ -108,12 +134,66 @@ adxl_query(struct adxl345 *ax, uint8_t oid)
     }
 }
 
+// Query accelerometer data
+static void
+adxl_query(struct adxl345 *ax, uint8_t oid)
+{
+    // Read data
+    uint8_t msg[9] = { AR_DATAX0 | AM_READ | AM_MULTI, 0, 0, 0, 0, 0, 0, 0, 0 };
+    spidev_transfer(ax->spi, 1, sizeof(msg), msg);
+    adxl_process(ax, oid, msg);
+}
+
+#if CONFIG_WANT_SPI_DMA
+
+// Completion callback invoked from the spi dma queue
+static void
+adxl_dma_complete(struct spidev_dma_request *dreq)
+{
+    struct adxl345 *ax = container_of(dreq, struct adxl345, dreq);
+    ax->flags |= AX_DMA_DONE;
+    sched_wake_task(&adxl345_wake);
+}
+
+// Query accelerometer data (via dma - processing overlaps the transfer)
+static void
+adxl_query_dma(struct adxl345 *ax, uint8_t oid)
+{
+    if (!(ax->flags & AX_DMA)) {
+        // Begin a fifo readback
+        memset(ax->msg, 0, sizeof(ax->msg));
+        ax->msg[0] = AR_DATAX0 | AM_READ | AM_MULTI;
+        ax->dreq = (struct spidev_dma_request){
+            .spi = ax->spi, .receive_data = 1, .data_len = sizeof(ax->msg),
+            .data = ax->msg, .complete = adxl_dma_complete };
+        if (!spidev_dma_submit(&ax->dreq)) {
+            // Dma unavailable (software spi) - perform a regular transfer
+            adxl_query(ax, oid);
+            return;
+        }
+        ax->flags |= AX_DMA;
+        return;
+    }
+    if (!(ax->flags & AX_DMA_DONE))
+        // Transfer still queued or in progress - the completion
+        // callback wakes this task again
+        return;
+    ax->flags &= ~(AX_DMA|AX_DMA_DONE);
+    adxl_process(ax, oid, ax->msg);
+}
+
+#endif // CONFIG_WANT_SPI_DMA
+
 void
 command_query_adxl345(uint32_t *args)
 {
     struct adxl345 *ax = oid_lookup(args[0], command_config_adxl345);
 
     sched_del_timer(&ax->timer);
+#if CONFIG_WANT_SPI_DMA
+    while ((ax->flags & (AX_DMA|AX_DMA_DONE)) == AX_DMA)
+        spidev_dma_poll();
+#endif
     ax->flags = 0;
     if (!args[1])
         // End measurements
@@ -130,6 +210,17 @@ void
 command_query_adxl345_status(uint32_t *args)
 {
     struct adxl345 *ax = oid_lookup(args[0], command_config_adxl345);
+#if CONFIG_WANT_SPI_DMA
+    // Complete any fifo readback in progress before using the bus
+    while (ax->flags & AX_DMA) {
+        if (ax->flags & AX_DMA_DONE) {
+            ax->flags &= ~(AX_DMA|AX_DMA_DONE);
+            adxl_process(ax, args[0], ax->msg);
+            break;
+        }
+        spidev_dma_poll();
+    }
+#endif
     uint8_t msg[2] = { AR_FIFO_STATUS | AM_READ, 0x00 };
 
     uint32_t time1 = timer_read_time();
@@ -154,8 +245,13 @@ adxl345_task(void)
     struct adxl345 *ax;
     foreach_oid(oid, ax, command_config_adxl345) {
         uint_fast8_t flags = ax->flags;
+#if CONFIG_WANT_SPI_DMA
+        if (flags & (AX_PENDING|AX_DMA))
+            adxl_query_dma(ax, oid);
+#else
         if (flags & AX_PENDING)
             adxl_query(ax, oid);
+#endif
     }
 }
-DECL_TASK(adxl345_task);
+DECL_TASK_WAKE(adxl345_task, adxl345_wake);
@@ -12,6 +12,7 @@
 #include "sched.h" // DECL_TASK
 #include "sensor_bulk.h" // sensor_bulk_report
 #include "spicmds.h" // spidev_transfer
+#include "stepper.h" // stepper_get_commanded_position
 
 enum {
     SA_CHIP_A1333,
@@ -39,12 +40,18 @@ struct spi_angle {
     struct timer timer;
     uint32_t rest_ticks;
     struct spidev_s *spi;
-    uint8_t flags, chip_type, time_shift, overflow;
+    uint8_t flags, chip_type, time_shift, overflow, burst_count;
     struct sensor_bulk sb;
+    // Commanded vs measured position comparator
+    struct stepper *stepper;
+    int32_t compare_scale;
+    uint32_t compare_mtime;
+    uint16_t compare_threshold, compare_offset, compare_angle;
 };
 
 enum {
-    SA_PENDING = 1<<2,
+    SA_PENDING = 1<<2, SA_COMPARE_REF = 1<<3, SA_DIVERGED = 1<<4,
+    SA_HAVE_SAMPLE = 1<<5,
 };
 
 #define BYTES_PER_SAMPLE 3
@@ -79,10 +86,23 @@ command_config_spi_angle(uint32_t *args)
     if (!spidev_have_cs_pin(sa->spi))
         shutdown("angle sensor requires cs pin");
     sa->chip_type = chip_type;
+    sa->burst_count = 1;
 }
 DECL_COMMAND(command_config_spi_angle,
              "config_spi_angle oid=%c spi_oid=%c spi_angle_type=%c");
 
+// Set the number of back-to-back samples taken per timer event
+void
+command_spi_angle_set_burst(uint32_t *args)
+{
+    struct spi_angle *sa = oid_lookup(args[0], command_config_spi_angle);
+    uint8_t count = args[1];
+    if (!count)
+        count = 1;
+    sa->burst_count = count;
+}
+DECL_COMMAND(command_spi_angle_set_burst, "spi_angle_set_burst oid=%c count=%c");
+
 // Send spi_angle_data message if buffer is full
 static void
 angle_check_report(struct spi_angle *sa, uint8_t oid)
@@ -105,6 +125,9 @@ angle_add(struct spi_angle *sa, uint_fast8_t tcode, uint_fast16_t data)
 static void
 angle_add_error(struct spi_angle *sa, uint_fast8_t error_code)
 {
+    if (sa->compare_threshold)
+        // Comparator mode - faulty samples are skipped
+        return;
     angle_add(sa, TCODE_ERROR, error_code);
 }
 
@@ -113,6 +136,13 @@ static void
 angle_add_data(struct spi_angle *sa, uint32_t stime, uint32_t mtime
                , uint_fast16_t angle)
 {
+    if (sa->compare_threshold) {
+        // Comparator mode - stash the sample for spi_angle_task()
+        sa->compare_angle = angle;
+        sa->compare_mtime = mtime;
+        sa->flags |= SA_HAVE_SAMPLE;
+        return;
+    }
     uint32_t tdiff = mtime - stime;
     if (sa->time_shift)
         tdiff = (tdiff + (1<<(sa->time_shift - 1))) >> sa->time_shift;
@@ -283,6 +313,59 @@ tle5012b_query(struct spi_angle *sa, uint32_t stime)
         angle_add(sa, (msg[6] >> 1) & 0x3f, (msg[2] << 9) | (msg[3] << 1));
 }
 
+// Configure on-mcu comparison of measured angle vs commanded position.
+// (Issue after query_spi_angle - the first valid sample sets the angle
+// reference.)  Only divergence events are reported to the host.
+void
+command_spi_angle_setup_compare(uint32_t *args)
+{
+    struct spi_angle *sa = oid_lookup(args[0], command_config_spi_angle);
+    uint16_t threshold = args[3];
+    if (!threshold) {
+        // Disable comparator - revert to bulk streaming
+        sa->compare_threshold = 0;
+        sa->flags &= ~(SA_COMPARE_REF|SA_DIVERGED|SA_HAVE_SAMPLE);
+        return;
+    }
+    sa->stepper = stepper_oid_lookup(args[1]);
+    sa->compare_scale = args[2];
+    sa->compare_threshold = threshold;
+    sa->flags |= SA_COMPARE_REF;
+    sa->flags &= ~(SA_DIVERGED|SA_HAVE_SAMPLE);
+}
+DECL_COMMAND(command_spi_angle_setup_compare,
+             "spi_angle_setup_compare oid=%c stepper_oid=%c scale=%i"
+             " threshold=%u");
+
+// Compare the latest sample against the commanded stepper position
+static void
+angle_compare(struct spi_angle *sa, uint8_t oid)
+{
+    uint16_t angle = sa->compare_angle;
+    uint32_t position = stepper_get_commanded_position(sa->stepper);
+    uint16_t expected = (position * (uint32_t)sa->compare_scale) >> 16;
+    if (sa->flags & SA_COMPARE_REF) {
+        // First valid sample sets the angle reference
+        sa->compare_offset = angle - expected;
+        sa->flags &= ~SA_COMPARE_REF;
+        return;
+    }
+    expected += sa->compare_offset;
+    int16_t diff = angle - expected;
+    if (diff < 0)
+        diff = -diff;
+    if (diff > sa->compare_threshold) {
+        if (!(sa->flags & SA_DIVERGED)) {
+            sa->flags |= SA_DIVERGED;
+            sendf("spi_angle_divergence oid=%c clock=%u expected=%hu"
+                  " measured=%hu", oid, sa->compare_mtime, expected, angle);
+        }
+    } else if (diff <= sa->compare_threshold / 2) {
+        // Hysteresis - rearm reporting once well within the threshold
+        sa->flags &= ~SA_DIVERGED;
+    }
+}
+
 void
 command_query_spi_angle(uint32_t *args)
 {
@@ -291,6 +374,7 @@ command_query_spi_angle(uint32_t *args)
 
     sched_del_timer(&sa->timer);
     sa->flags = 0;
+    sa->compare_threshold = 0;
     if (!args[2])
         // End measurements
         return;
@@ -355,26 +439,37 @@ spi_angle_task(void)
         irq_disable();
         uint32_t stime = sa->timer.waketime;
         uint_fast8_t overflow = sa->overflow;
-        sa->flags = 0;
+        sa->flags &= ~SA_PENDING;
         sa->overflow = 0;
         irq_enable();
         stime -= sa->rest_ticks;
+        uint_fast8_t burst = sa->burst_count;
         while (overflow--) {
-            angle_add_error(sa, SE_OVERFLOW);
+            // A missed event loses an entire burst of samples
+            uint_fast8_t n = burst;
+            while (n--) {
+                angle_add_error(sa, SE_OVERFLOW);
+                angle_check_report(sa, oid);
+            }
+        }
+        uint_fast8_t chip = sa->chip_type, n = burst;
+        while (n--) {
+            if (chip == SA_CHIP_A1333)
+                a1333_query(sa, stime);
+            else if (chip == SA_CHIP_AS5047D)
+                as5047d_query(sa, stime);
+            else if (chip == SA_CHIP_TLE5012B)
+                tle5012b_query(sa, stime);
+            else if (chip == SA_CHIP_MT6816)
+                mt6816_query(sa, stime);
+            else if (chip == SA_CHIP_MT6826S)
+                mt6826s_query(sa, stime);
             angle_check_report(sa, oid);
         }
-        uint_fast8_t chip = sa->chip_type;
-        if (chip == SA_CHIP_A1333)
-            a1333_query(sa, stime);
-        else if (chip == SA_CHIP_AS5047D)
-            as5047d_query(sa, stime);
-        else if (chip == SA_CHIP_TLE5012B)
-            tle5012b_query(sa, stime);
-        else if (chip == SA_CHIP_MT6816)
-            mt6816_query(sa, stime);
-        else if (chip == SA_CHIP_MT6826S)
-            mt6826s_query(sa, stime);
-        angle_check_report(sa, oid);
+        if (sa->flags & SA_HAVE_SAMPLE) {
+            sa->flags &= ~SA_HAVE_SAMPLE;
+            angle_compare(sa, oid);
+        }
     }
 }
 DECL_TASK(spi_angle_task);
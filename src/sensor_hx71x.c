@@ -14,8 +14,15 @@
 #include "command.h" // DECL_COMMAND
 #include "sched.h" // sched_add_timer
 #include "sensor_bulk.h" // sensor_bulk_report
+#include "sensor_hx71x.h" // hx71x_hw_read
 #include "trigger_analog.h" // trigger_analog_update
 
+#if CONFIG_HAVE_HX71X_HW_READ && CONFIG_WANT_HX71X_HW_READ
+ #define HAVE_HW_READ 1
+#else
+ #define HAVE_HW_READ 0
+#endif
+
 struct hx71x_adc {
     struct timer timer;
     uint8_t gain_channel;   // the gain+channel selection (1-4)
@@ -24,6 +31,10 @@ struct hx71x_adc {
     uint32_t last_error;
     struct gpio_in dout; // pin used to receive data from the hx71x
     struct gpio_out sclk; // pin used to generate clock for the hx71x
+#if HAVE_HW_READ
+    uint8_t hw_read; // reads are clocked by hardware
+    uint32_t dout_pin, sclk_pin;
+#endif
     struct sensor_bulk sb;
     struct trigger_analog *ta;
 };
@@ -95,6 +106,17 @@ hx71x_raw_read(struct gpio_in dout, struct gpio_out sclk, int num_bits)
     return bits_read;
 }
 
+// Read 'num_bits' using hardware clocking (if available)
+static uint32_t
+hx71x_read_sample(struct hx71x_adc *hx71x, uint_fast8_t num_bits)
+{
+#if HAVE_HW_READ
+    if (hx71x->hw_read)
+        return hx71x_hw_read(hx71x->dout_pin, hx71x->sclk_pin, num_bits);
+#endif
+    return hx71x_raw_read(hx71x->dout, hx71x->sclk, num_bits);
+}
+
 
 /****************************************************************
  * HX711 and HX717 Sensor Support
@@ -149,7 +171,7 @@ hx71x_read_adc(struct hx71x_adc *hx71x, uint8_t oid)
 {
     // Read from sensor
     uint_fast8_t gain_channel = hx71x->gain_channel;
-    uint32_t adc = hx71x_raw_read(hx71x->dout, hx71x->sclk, 24 + gain_channel);
+    uint32_t adc = hx71x_read_sample(hx71x, 24 + gain_channel);
 
     // Clear pending flag (and note if an overflow occurred)
     irq_disable();
@@ -200,6 +222,12 @@ command_config_hx71x(uint32_t *args)
     hx71x->gain_channel = gain_channel;
     hx71x->dout = gpio_in_setup(args[2], 1);
     hx71x->sclk = gpio_out_setup(args[3], 0);
+#if HAVE_HW_READ
+    hx71x->dout_pin = args[2];
+    hx71x->sclk_pin = args[3];
+    // Fall back to bit-banging if no hardware unit is available
+    hx71x->hw_read = hx71x_hw_setup(args[2], args[3]) >= 0;
+#endif
     gpio_out_write(hx71x->sclk, 1); // put chip in power down state
 }
 DECL_COMMAND(command_config_hx71x, "config_hx71x oid=%c gain_channel=%c"
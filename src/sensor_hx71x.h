@@ -0,0 +1,11 @@
+#ifndef __SENSOR_HX71X_H
+#define __SENSOR_HX71X_H
+
+#include <stdint.h> // uint32_t
+
+// Hardware clocked sample reads (boards with CONFIG_HAVE_HX71X_HW_READ)
+int hx71x_hw_setup(uint32_t dout_pin, uint32_t sclk_pin);
+uint32_t hx71x_hw_read(uint32_t dout_pin, uint32_t sclk_pin
+                       , uint_fast8_t num_bits);
+
+#endif // sensor_hx71x.h
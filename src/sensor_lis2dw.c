@@ -110,6 +110,29 @@ command_config_lis2dw(uint32_t *args)
 DECL_COMMAND(command_config_lis2dw, "config_lis2dw oid=%c"
                 " bus_oid=%c bus_oid_type=%c lis_chip_type=%c");
 
+#if CONFIG_HAVE_GPIO_IRQ && CONFIG_WANT_GPIO_IRQ
+// Handler invoked on rising edges of the sensor's fifo watermark pin
+static void
+lis2dw_irq(void *data)
+{
+    struct lis2dw *ax = data;
+    ax->flags |= LIS_PENDING;
+    sched_wake_task(&lis2dw_wake);
+}
+
+// Wake the drain task directly from the sensor's INT pin
+void
+command_attach_lis2dw_irq(uint32_t *args)
+{
+    struct lis2dw *ax = oid_lookup(args[0], command_config_lis2dw);
+    struct gpio_in pin = gpio_in_setup(args[1], 0);
+    if (gpio_in_attach_irq(pin, lis2dw_irq, ax) < 0)
+        shutdown("lis2dw irq line already in use");
+}
+DECL_COMMAND(command_attach_lis2dw_irq
+             , "attach_lis2dw_irq oid=%c int_pin=%u");
+#endif
+
 // Helper code to reschedule the lis2dw_event() timer
 static void
 lis2dw_reschedule_timer(struct lis2dw *ax)
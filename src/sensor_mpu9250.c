@@ -24,6 +24,9 @@
 
 #define BYTES_PER_FIFO_ENTRY 6
 #define BYTES_PER_BLOCK 48
+// Max fifo bytes read in one i2c transaction (a multiple of
+// BYTES_PER_BLOCK - longer bursts amortize the i2c addressing overhead)
+#define BYTES_PER_BURST 144
 
 struct mpu9250 {
     struct timer timer;
@@ -99,13 +102,23 @@ mp9250_query(struct mpu9250 *mp, uint8_t oid)
     if (mp->fifo_pkts_bytes < BYTES_PER_BLOCK)
         mp->fifo_pkts_bytes = get_fifo_status(mp);
 
-    // If we have enough bytes to fill the buffer do it and send report
+    // Read all pending full blocks in one repeated-start transaction
+    // and carve the burst into report sized chunks
     if (mp->fifo_pkts_bytes >= BYTES_PER_BLOCK) {
+        static uint8_t burst[BYTES_PER_BURST];
+        uint16_t blen = mp->fifo_pkts_bytes;
+        if (blen > BYTES_PER_BURST)
+            blen = BYTES_PER_BURST;
+        blen -= blen % BYTES_PER_BLOCK;
         uint8_t reg = AR_FIFO;
-        read_mpu(mp->i2c, sizeof(reg), &reg, BYTES_PER_BLOCK, &mp->sb.data[0]);
-        mp->sb.data_count = BYTES_PER_BLOCK;
-        mp->fifo_pkts_bytes -= BYTES_PER_BLOCK;
-        sensor_bulk_report(&mp->sb, oid);
+        read_mpu(mp->i2c, sizeof(reg), &reg, blen, burst);
+        mp->fifo_pkts_bytes -= blen;
+        uint16_t pos;
+        for (pos = 0; pos < blen; pos += BYTES_PER_BLOCK) {
+            memcpy(&mp->sb.data[0], &burst[pos], BYTES_PER_BLOCK);
+            mp->sb.data_count = BYTES_PER_BLOCK;
+            sensor_bulk_report(&mp->sb, oid);
+        }
     }
 
     // If we have enough bytes remaining to fill another report wake again
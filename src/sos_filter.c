@@ -41,7 +41,29 @@ fixed_mul(int32_t coeff, int32_t value, uint_fast8_t frac_bits, int32_t *res)
     int64_t result = (int64_t)coeff * (int64_t)value;
     if (frac_bits) {
         // round up at the last bit to be shifted away
-        result += 1 << (frac_bits - 1);
+        result += (int64_t)1 << (frac_bits - 1);
+        // shift the decimal right to discard the coefficient fractional bits
+        result >>= frac_bits;
+    }
+    // truncate significant 32 bits
+    *res = (int32_t)result;
+    // check for overflow of int32_t
+    if (overflows_int32(result))
+        return -1;
+    return 0;
+}
+
+// Compute (ca*va - cb*vb) >> frac_bits without intermediate truncation
+static int
+fixed_mul_sub(int32_t ca, int32_t va, int32_t cb, int32_t vb
+              , uint_fast8_t frac_bits, int32_t *res)
+{
+    // The products accumulate in 64 bits - on Arm Cortex M3/M4/M7 this
+    // compiles to an SMULL/SMLAL pair with a single shift and round
+    int64_t result = (int64_t)ca * (int64_t)va - (int64_t)cb * (int64_t)vb;
+    if (frac_bits) {
+        // round up at the last bit to be shifted away
+        result += (int64_t)1 << (frac_bits - 1);
         // shift the decimal right to discard the coefficient fractional bits
         result >>= frac_bits;
     }
@@ -76,23 +98,24 @@ sos_filter_apply(struct sos_filter *sf, int32_t *pvalue)
 
     // foreach section
     uint_fast8_t cfb = sf->coeff_frac_bits;
+    ret = 0;
     for (int section_idx = 0; section_idx < sf->n_sections; section_idx++) {
         struct sos_filter_section *section = &(sf->filter[section_idx]);
         // apply the section's filter coefficients to input
-        int32_t next_val, c1_cur, c2_cur, c3_next, c4_next;
-        int ret = fixed_mul(section->coeff[0], cur_val, cfb, &next_val);
+        int32_t next_val, s0_part, s1_next;
+        ret |= fixed_mul(section->coeff[0], cur_val, cfb, &next_val);
         next_val += section->state[0];
-        ret |= fixed_mul(section->coeff[1], cur_val, cfb, &c1_cur);
-        ret |= fixed_mul(section->coeff[3], next_val, cfb, &c3_next);
-        ret |= fixed_mul(section->coeff[2], cur_val, cfb, &c2_cur);
-        ret |= fixed_mul(section->coeff[4], next_val, cfb, &c4_next);
-        if (ret)
-            // Overflow
-            return -1;
-        section->state[0] = c1_cur - c3_next + section->state[1];
-        section->state[1] = c2_cur - c4_next;
+        ret |= fixed_mul_sub(section->coeff[1], cur_val
+                             , section->coeff[3], next_val, cfb, &s0_part);
+        ret |= fixed_mul_sub(section->coeff[2], cur_val
+                             , section->coeff[4], next_val, cfb, &s1_next);
+        section->state[0] = s0_part + section->state[1];
+        section->state[1] = s1_next;
         cur_val = next_val;
     }
+    if (ret)
+        // Overflow (state is stale, but the caller halts on overflow)
+        return -1;
 
     *pvalue = cur_val;
     return 0;
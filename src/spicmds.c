@@ -83,6 +83,111 @@ spidev_get_cs_pin(struct spidev_s *spi)
     return spi->pin;
 }
 
+#if CONFIG_WANT_SPI_DMA
+
+/****************************************************************
+ * DMA transfer queue
+ ****************************************************************/
+
+// Queue of dma transfers (the dma engine runs one at a time)
+static struct spidev_dma_request *spi_dma_queue;
+// The transfer at the head of the queue is on the dma engine
+static uint8_t spi_dma_started;
+static struct task_wake spi_dma_wake;
+
+// Start the transfer at the head of the queue
+static void
+spi_dma_begin(struct spidev_dma_request *dr)
+{
+    struct spidev_s *spi = dr->spi;
+    spi_prepare(spi->spi_config);
+    if (spi->flags & SF_HAVE_PIN)
+        gpio_out_write(spi->pin, !!(spi->flags & SF_CS_ACTIVE_HIGH));
+    spi_transfer_dma_start(spi->spi_config, dr->receive_data
+                           , dr->data_len, dr->data);
+    spi_dma_started = 1;
+}
+
+// Release the CS pin and report completion of the head transfer
+static void
+spi_dma_finish(struct spidev_dma_request *dr)
+{
+    struct spidev_s *spi = dr->spi;
+    if (spi->flags & SF_HAVE_PIN)
+        gpio_out_write(spi->pin, !(spi->flags & SF_CS_ACTIVE_HIGH));
+    spi_dma_queue = dr->next;
+    spi_dma_started = 0;
+    dr->complete(dr);
+}
+
+// Queue a dma transfer - dr->complete() is invoked when it finishes
+// (returns zero if the caller must fall back to spidev_transfer())
+int
+spidev_dma_submit(struct spidev_dma_request *dr)
+{
+    if (!(dr->spi->flags & SF_HARDWARE))
+        // No dma support on software spi
+        return 0;
+    dr->next = NULL;
+    if (!spi_dma_queue) {
+        spi_dma_queue = dr;
+    } else {
+        struct spidev_dma_request *tail = spi_dma_queue;
+        while (tail->next)
+            tail = tail->next;
+        tail->next = dr;
+    }
+    sched_wake_task(&spi_dma_wake);
+    return 1;
+}
+
+// Check for dma completion and chain queued transfers back-to-back
+void
+spidev_dma_poll(void)
+{
+    for (;;) {
+        struct spidev_dma_request *dr = spi_dma_queue;
+        if (!dr)
+            return;
+        if (!spi_dma_started) {
+            spi_dma_begin(dr);
+            continue;
+        }
+        if (!spi_transfer_dma_check(dr->spi->spi_config)) {
+            // Still in progress - check again on next task run
+            sched_wake_task(&spi_dma_wake);
+            return;
+        }
+        spi_dma_finish(dr);
+    }
+}
+
+void
+spi_dma_task(void)
+{
+    if (!sched_check_wake(&spi_dma_wake))
+        return;
+    spidev_dma_poll();
+}
+DECL_TASK_WAKE(spi_dma_task, spi_dma_wake);
+
+// Let a synchronous transfer use the bus ahead of queued dma transfers
+static void
+spi_dma_wait_active(void)
+{
+    struct spidev_dma_request *dr = spi_dma_queue;
+    if (!dr || !spi_dma_started)
+        return;
+    while (!spi_transfer_dma_check(dr->spi->spi_config))
+        ;
+    spi_dma_finish(dr);
+    if (spi_dma_queue)
+        // Remaining queued transfers restart from spi_dma_task()
+        sched_wake_task(&spi_dma_wake);
+}
+
+#endif // CONFIG_WANT_SPI_DMA
+
 void
 spidev_transfer(struct spidev_s *spi, uint8_t receive_data
                 , uint8_t data_len, uint8_t *data)
@@ -92,6 +197,12 @@ spidev_transfer(struct spidev_s *spi, uint8_t receive_data
         // Not yet initialized
         return;
 
+#if CONFIG_WANT_SPI_DMA
+    // A synchronous transfer (driver status reads) has priority - wait
+    // only for a transfer already on the engine, not for queued ones
+    spi_dma_wait_active();
+#endif
+
     if (CONFIG_WANT_SOFTWARE_SPI && flags & SF_SOFTWARE)
         spi_software_prepare(spi->spi_software);
     else
@@ -160,6 +271,16 @@ DECL_COMMAND(command_config_spi_shutdown,
 void
 spidev_shutdown(void)
 {
+#if CONFIG_WANT_SPI_DMA
+    // Wait for any transfer on the dma engine; drop queued transfers
+    struct spidev_dma_request *dr = spi_dma_queue;
+    if (dr && spi_dma_started)
+        while (!spi_transfer_dma_check(dr->spi->spi_config))
+            ;
+    spi_dma_queue = NULL;
+    spi_dma_started = 0;
+#endif
+
     // Cancel any transmissions that may be in progress
     uint8_t oid;
     struct spidev_s *spi;
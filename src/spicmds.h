@@ -11,4 +11,15 @@ struct gpio_out spidev_get_cs_pin(struct spidev_s *spi);
 void spidev_transfer(struct spidev_s *spi, uint8_t receive_data
                      , uint8_t data_len, uint8_t *data);
 
+// A queued dma transfer (see spidev_dma_submit() )
+struct spidev_dma_request {
+    struct spidev_dma_request *next;
+    struct spidev_s *spi;
+    uint8_t receive_data, data_len;
+    uint8_t *data;
+    void (*complete)(struct spidev_dma_request *dr);
+};
+int spidev_dma_submit(struct spidev_dma_request *dr);
+void spidev_dma_poll(void);
+
 #endif // spicmds.h
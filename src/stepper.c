@@ -4,6 +4,7 @@
 //
 // This file may be distributed under the terms of the GNU GPLv3 license.
 
+#include <string.h> // memcpy
 #include "autoconf.h" // CONFIG_*
 #include "basecmd.h" // oid_alloc
 #include "board/gpio.h" // gpio_out_write
@@ -27,6 +28,36 @@ DECL_CONSTANT("STEPPER_STEP_BOTH_EDGE", 1);
  #define HAVE_AVR_OPTIMIZATION 0
 #endif
 
+#if CONFIG_HAVE_STEPPER_DMA && CONFIG_WANT_STEPPER_DMA
+ #define HAVE_DMA_OFFLOAD 1
+#else
+ #define HAVE_DMA_OFFLOAD 0
+#endif
+
+#if CONFIG_WANT_STEPPER_PREDECODE && !CONFIG_MACH_AVR
+ #define HAVE_RING_PREDECODE 1
+#else
+ #define HAVE_RING_PREDECODE 0
+#endif
+
+#if CONFIG_WANT_STEP_GROUPING
+ #define HAVE_STEP_GROUPING 1
+#else
+ #define HAVE_STEP_GROUPING 0
+#endif
+
+#if CONFIG_WANT_STEPPER_JITTER_AUDIT
+ #define HAVE_JITTER_AUDIT 1
+#else
+ #define HAVE_JITTER_AUDIT 0
+#endif
+// Number of log2 latency buckets in the step jitter histogram
+#define JITTER_BUCKETS 12
+// Step events this close together are merged into one port write
+#define STEP_GROUP_WINDOW_TICKS DIV_ROUND_UP(CONFIG_CLOCK_FREQ, 1000000)
+// Number of pre-decoded interval entries in each stepper ring
+#define STEP_RING_SIZE 64
+
 struct stepper_move {
     struct move_node node;
     uint32_t interval;
@@ -47,6 +78,26 @@ struct stepper {
     uint32_t position;
     struct move_queue_head mq;
     struct trsync_signal stop_signal;
+#if HAVE_DMA_OFFLOAD
+    struct stepper_dma *sd;
+    uint8_t dma_dir;
+#endif
+#if HAVE_RING_PREDECODE
+    // Pre-decoded interval words ((interval << 1) | dir_change)
+    uint32_t ring[STEP_RING_SIZE];
+    uint16_t pd_count;
+    uint8_t ring_head, ring_tail;
+#endif
+#if HAVE_STEP_GROUPING
+    // Ring of steppers wired to the same gpio port
+    struct stepper *group_next;
+#endif
+#if HAVE_JITTER_AUDIT
+    // Histogram of step dispatch latency (log2 tick buckets)
+    uint8_t jitter_active;
+    uint32_t jitter_max;
+    uint32_t jitter_counts[JITTER_BUCKETS];
+#endif
     // gcc (pre v6) does better optimization when uint8_t are bitfields
     uint8_t flags : 8;
 };
@@ -55,9 +106,44 @@ enum { POSITION_BIAS=0x40000000 };
 
 enum {
     SF_LAST_DIR=1<<0, SF_NEXT_DIR=1<<1, SF_INVERT_STEP=1<<2, SF_NEED_RESET=1<<3,
-    SF_SINGLE_SCHED=1<<4, SF_OPTIMIZED_PATH=1<<5, SF_HAVE_ADD=1<<6
+    SF_SINGLE_SCHED=1<<4, SF_OPTIMIZED_PATH=1<<5, SF_HAVE_ADD=1<<6,
+    SF_DMA_ACTIVE=1<<7
 };
 
+#if HAVE_JITTER_AUDIT
+
+// Record the latency of a step dispatch against its scheduled waketime
+static void
+stepper_jitter_note(struct stepper *s, uint32_t curtime)
+{
+    if (!s->jitter_active)
+        return;
+    uint32_t latency = curtime - s->time.waketime;
+    if (latency > s->jitter_max)
+        s->jitter_max = latency;
+    uint_fast8_t bucket = 0;
+    while (latency > 1 && bucket < JITTER_BUCKETS - 1) {
+        latency >>= 1;
+        bucket++;
+    }
+    s->jitter_counts[bucket]++;
+}
+
+// Audit hook for step paths that do not otherwise read the clock
+static void
+stepper_jitter_check(struct stepper *s)
+{
+    if (s->jitter_active)
+        stepper_jitter_note(s, timer_read_time());
+}
+
+#else
+
+static inline void stepper_jitter_note(struct stepper *s, uint32_t time) { }
+static inline void stepper_jitter_check(struct stepper *s) { }
+
+#endif
+
 // Setup a stepper for the next move in its queue
 static uint_fast8_t
 stepper_load_next(struct stepper *s)
@@ -134,12 +220,57 @@ stepper_load_next(struct stepper *s)
  DECL_CONSTANT("STEPPER_OPTIMIZED_EDGE", EDGE_STEP_TICKS);
 #endif
 
+#if HAVE_STEP_GROUPING
+
+// Emit this step edge along with any near-coincident step edges of
+// other steppers wired to the same gpio port.  Merged steppers have
+// their edge emitted up to STEP_GROUP_WINDOW_TICKS early, but their
+// following steps stay on the original schedule.  Only safe with the
+// heap timer scheduler - rescheduling a merged stepper can not
+// displace the currently dispatching timer at the heap root because
+// the new waketime is always after the dispatching waketime.
+static void
+stepper_group_toggle(struct stepper *s)
+{
+    struct stepper *m = s->group_next;
+    if (likely(m == s)) {
+        gpio_out_toggle_noirq(s->step_pin);
+        return;
+    }
+    uint32_t bits = gpio_out_bit(s->step_pin);
+    uint32_t grouptime = s->time.waketime + STEP_GROUP_WINDOW_TICKS;
+    for (; m != s; m = m->group_next) {
+        if (!m->count || timer_is_before(grouptime, m->time.waketime))
+            continue;
+        // Emit m's edge in the combined write and advance its schedule
+        sched_del_timer(&m->time);
+        bits |= gpio_out_bit(m->step_pin);
+        uint32_t count = m->count - 1;
+        if (likely(count)) {
+            m->count = count;
+            m->time.waketime += m->interval;
+            m->interval += m->add;
+            sched_add_timer(&m->time);
+        } else if (stepper_load_next(m) != SF_DONE) {
+            sched_add_timer(&m->time);
+        }
+    }
+    gpio_out_port_toggle_noirq(gpio_out_port(s->step_pin), bits);
+}
+
+#endif // HAVE_STEP_GROUPING
+
 // Optimized step function to step on each step pin edge
 static uint_fast8_t
 stepper_event_edge(struct timer *t)
 {
     struct stepper *s = container_of(t, struct stepper, time);
+    stepper_jitter_check(s);
+#if HAVE_STEP_GROUPING
+    stepper_group_toggle(s);
+#else
     gpio_out_toggle_noirq(s->step_pin);
+#endif
     uint32_t count = s->count - 1;
     if (likely(count)) {
         s->count = count;
@@ -160,6 +291,7 @@ static uint_fast8_t
 stepper_event_avr(struct timer *t)
 {
     struct stepper *s = container_of(t, struct stepper, time);
+    stepper_jitter_check(s);
     gpio_out_toggle_noirq(s->step_pin);
     uint16_t *pcount = (void*)&s->count, count = *pcount - 1;
     if (likely(count)) {
@@ -182,6 +314,7 @@ stepper_event_full(struct timer *t)
     struct stepper *s = container_of(t, struct stepper, time);
     gpio_out_toggle_noirq(s->step_pin);
     uint32_t curtime = timer_read_time();
+    stepper_jitter_note(s, curtime);
     uint32_t min_next_time = curtime + s->step_pulse_ticks;
     uint32_t count = s->count - 1;
     if (likely(count & 1 && !(s->flags & SF_SINGLE_SCHED)))
@@ -205,6 +338,199 @@ reschedule_min:
     return SF_RESCHEDULE;
 }
 
+#if HAVE_DMA_OFFLOAD
+
+// Expand queued moves into step pulse buffers fed to dedicated hardware
+static uint_fast8_t
+stepper_event_dma(struct timer *t)
+{
+    struct stepper *s = container_of(t, struct stepper, time);
+    uint_fast8_t do_start = !(s->flags & SF_DMA_ACTIVE);
+    s->flags |= SF_DMA_ACTIVE;
+    for (;;) {
+        if (!s->count) {
+            if (move_queue_empty(&s->mq))
+                break;
+            // Load next move
+            struct move_node *mn = move_queue_pop(&s->mq);
+            struct stepper_move *m = container_of(mn, struct stepper_move
+                                                  , node);
+            if (m->flags & MF_DIR) {
+                s->position = -s->position;
+                s->dma_dir ^= 1;
+            }
+            s->position += m->count;
+            s->interval = m->interval;
+            s->add = m->add;
+            s->count = m->count;
+            move_free(m);
+        }
+        if (stepper_dma_space(s->sd) <= 0)
+            break;
+        stepper_dma_push(s->sd, s->interval, s->dma_dir);
+        s->next_step_time += s->interval;
+        if (do_start) {
+            // Note absolute time of first step for hardware startup
+            stepper_dma_start(s->sd, s->next_step_time);
+            do_start = 0;
+        }
+        s->interval += s->add;
+        s->count--;
+    }
+    stepper_dma_flush(s->sd);
+
+    // Schedule next buffer refill
+    if (!s->count && move_queue_empty(&s->mq)
+        && !stepper_dma_pending(s->sd)) {
+        // All queued steps have been emitted
+        stepper_dma_stop(s->sd);
+        s->flags &= ~SF_DMA_ACTIVE;
+        return SF_DONE;
+    }
+    uint32_t curtime = timer_read_time();
+    int32_t lead = s->next_step_time - curtime;
+    uint32_t delay = lead > 0 ? lead / 2 : 0;
+    if (delay < timer_from_us(50))
+        delay = timer_from_us(50);
+    s->time.waketime = curtime + delay;
+    return SF_RESCHEDULE;
+}
+
+#endif // HAVE_DMA_OFFLOAD
+
+#if HAVE_RING_PREDECODE
+
+static struct task_wake stepper_wake;
+
+// Step event function consuming pre-decoded intervals from a flat ring
+static uint_fast8_t
+stepper_event_ring(struct timer *t)
+{
+    struct stepper *s = container_of(t, struct stepper, time);
+    gpio_out_toggle_noirq(s->step_pin);
+    uint32_t curtime = timer_read_time();
+    stepper_jitter_note(s, curtime);
+    uint32_t min_next_time = curtime + s->step_pulse_ticks;
+    uint32_t count = s->count - 1;
+    if (likely(count & 1 && !(s->flags & SF_SINGLE_SCHED)))
+        // Schedule unstep event
+        goto reschedule_min;
+    if (likely(count)) {
+        // Pop the next pre-decoded interval from the ring
+        uint_fast8_t head = s->ring_head;
+        uint32_t e = s->ring[head % STEP_RING_SIZE];
+        s->ring_head = head + 1;
+        sched_wake_task(&stepper_wake);
+        if (unlikely(e & 1)) {
+            // Direction change decoded into this entry
+            if (s->flags & SF_SINGLE_SCHED)
+                while (timer_is_before(timer_read_time(), min_next_time))
+                    ;
+            gpio_out_toggle_noirq(s->dir_pin);
+            curtime = timer_read_time();
+            min_next_time = curtime + s->step_pulse_ticks;
+        }
+        s->next_step_time += e >> 1;
+        if (unlikely(timer_is_before(s->next_step_time, min_next_time)))
+            // The next step event is too close - push it back
+            goto reschedule_min;
+        s->count = count;
+        s->time.waketime = s->next_step_time;
+        return SF_RESCHEDULE;
+    }
+    s->count = 0;
+    if (unlikely(s->pd_count || !move_queue_empty(&s->mq)))
+        // Pre-decode task was unable to keep the ring filled
+        shutdown("Stepper ring underrun");
+    return SF_DONE;
+reschedule_min:
+    s->count = count;
+    s->time.waketime = min_next_time;
+    return SF_RESCHEDULE;
+}
+
+// Expand queued moves into raw interval words (runs in task context)
+static void
+stepper_ring_fill(struct stepper *s)
+{
+    while ((uint8_t)(s->ring_tail - s->ring_head) < STEP_RING_SIZE) {
+        uint32_t dirbit = 0;
+        if (!s->pd_count) {
+            // Decode the next queued move
+            irq_disable();
+            if (move_queue_empty(&s->mq)) {
+                irq_enable();
+                break;
+            }
+            struct move_node *mn = move_queue_pop(&s->mq);
+            struct stepper_move *m = container_of(mn, struct stepper_move
+                                                  , node);
+            if (m->flags & MF_DIR) {
+                s->position = -s->position;
+                dirbit = 1;
+            }
+            s->position += m->count;
+            s->interval = m->interval;
+            s->add = m->add;
+            s->pd_count = m->count;
+            move_free(m);
+            irq_enable();
+        }
+        uint32_t interval = s->interval;
+        if (unlikely(interval & 0x80000000))
+            shutdown("Stepper interval too large");
+        s->ring[s->ring_tail % STEP_RING_SIZE] = (interval << 1) | dirbit;
+        s->interval += s->add;
+        s->pd_count--;
+        // Publish the new entry to the step irq handler
+        irq_disable();
+        if (unlikely(s->flags & SF_NEED_RESET)) {
+            // Stepper was stopped while decoding - discard this entry
+            s->pd_count = 0;
+            irq_enable();
+            return;
+        }
+        s->ring_tail++;
+        s->count += s->flags & SF_SINGLE_SCHED ? 1 : 2;
+        irq_enable();
+    }
+}
+
+// Schedule the first pre-decoded step (caller must disable irqs)
+static void
+stepper_ring_arm(struct stepper *s)
+{
+    if (!s->count || s->flags & SF_NEED_RESET)
+        return;
+    uint_fast8_t head = s->ring_head;
+    uint32_t e = s->ring[head % STEP_RING_SIZE];
+    s->ring_head = head + 1;
+    if (e & 1)
+        gpio_out_toggle_noirq(s->dir_pin);
+    s->next_step_time += e >> 1;
+    s->time.waketime = s->next_step_time;
+    sched_add_timer(&s->time);
+}
+
+void command_config_stepper(uint32_t *args);
+
+// Keep the per-stepper rings filled from the main task loop
+void
+stepper_predecode_task(void)
+{
+    if (!sched_check_wake(&stepper_wake))
+        return;
+    uint8_t i;
+    struct stepper *s;
+    foreach_oid(i, s, command_config_stepper) {
+        if (s->time.func == stepper_event_ring)
+            stepper_ring_fill(s);
+    }
+}
+DECL_TASK_WAKE(stepper_predecode_task, stepper_wake);
+
+#endif // HAVE_RING_PREDECODE
+
 // Optimized entry point for step function (may be inlined into sched.c code)
 uint_fast8_t
 stepper_event(struct timer *t)
@@ -230,11 +556,41 @@ command_config_stepper(uint32_t *args)
     s->position = -POSITION_BIAS;
     s->step_pulse_ticks = args[4];
     move_queue_setup(&s->mq, sizeof(struct stepper_move));
+#if HAVE_DMA_OFFLOAD
+    s->sd = stepper_dma_setup(args[1], args[2], s->flags & SF_INVERT_STEP
+                              , s->step_pulse_ticks);
+    if (s->sd) {
+        s->time.func = stepper_event_dma;
+        return;
+    }
+    // No hardware channel available - fall back to timer based stepping
+#endif
+#if HAVE_RING_PREDECODE
+    s->time.func = stepper_event_ring;
+    return;
+#endif
     if (HAVE_EDGE_OPTIMIZATION) {
         if (invert_step < 0 && s->step_pulse_ticks <= EDGE_STEP_TICKS)
             s->flags |= SF_OPTIMIZED_PATH;
         else
             s->time.func = stepper_event_full;
+#if HAVE_STEP_GROUPING
+        s->group_next = s;
+        if (s->flags & SF_OPTIMIZED_PATH) {
+            // Link edge optimized steppers sharing a gpio port into a ring
+            void *port = gpio_out_port(s->step_pin);
+            uint8_t i;
+            struct stepper *m;
+            foreach_oid(i, m, command_config_stepper) {
+                if (m == s || !(m->flags & SF_OPTIMIZED_PATH)
+                    || gpio_out_port(m->step_pin) != port)
+                    continue;
+                s->group_next = m->group_next;
+                m->group_next = s;
+                break;
+            }
+        }
+#endif
     } else if (HAVE_AVR_OPTIMIZATION) {
         if (invert_step >= 0 && s->step_pulse_ticks <= AVR_STEP_TICKS)
             s->flags |= SF_SINGLE_SCHED | SF_OPTIMIZED_PATH;
@@ -248,7 +604,7 @@ DECL_COMMAND(command_config_stepper, "config_stepper oid=%c step_pin=%c"
              " dir_pin=%c invert_step=%c step_pulse_ticks=%u");
 
 // Return the 'struct stepper' for a given stepper oid
-static struct stepper *
+struct stepper *
 stepper_oid_lookup(uint8_t oid)
 {
     return oid_lookup(oid, command_config_stepper);
@@ -256,15 +612,15 @@ stepper_oid_lookup(uint8_t oid)
 
 // Schedule a set of steps with a given timing
 void
-command_queue_step(uint32_t *args)
+stepper_queue_step(struct stepper *s, uint32_t interval, uint16_t count
+                   , int16_t add)
 {
-    struct stepper *s = stepper_oid_lookup(args[0]);
     struct stepper_move *m = move_alloc();
-    m->interval = args[1];
-    m->count = args[2];
+    m->interval = interval;
+    m->count = count;
     if (!m->count)
         shutdown("Invalid count parameter");
-    m->add = args[3];
+    m->add = add;
     m->flags = 0;
 
     irq_disable();
@@ -273,7 +629,7 @@ command_queue_step(uint32_t *args)
         flags ^= SF_LAST_DIR;
         m->flags |= MF_DIR;
     }
-    if (s->count) {
+    if (s->count || (HAVE_DMA_OFFLOAD && flags & SF_DMA_ACTIVE)) {
         s->flags = flags;
         move_queue_push(&m->node, &s->mq);
     } else if (flags & SF_NEED_RESET) {
@@ -281,39 +637,121 @@ command_queue_step(uint32_t *args)
     } else {
         s->flags = flags;
         move_queue_push(&m->node, &s->mq);
+#if HAVE_DMA_OFFLOAD
+        if (s->sd) {
+            // Fill the hardware buffers from the timer dispatch loop
+            s->time.waketime = timer_read_time() + timer_from_us(50);
+            sched_add_timer(&s->time);
+            irq_enable();
+            return;
+        }
+#endif
+#if HAVE_RING_PREDECODE
+        if (s->time.func == stepper_event_ring) {
+            // Decode the first entries and schedule the initial step
+            irq_enable();
+            stepper_ring_fill(s);
+            irq_disable();
+            stepper_ring_arm(s);
+            irq_enable();
+            return;
+        }
+#endif
         stepper_load_next(s);
         sched_add_timer(&s->time);
     }
     irq_enable();
+#if HAVE_RING_PREDECODE
+    sched_wake_task(&stepper_wake);
+#endif
+}
+
+void
+command_queue_step(uint32_t *args)
+{
+    struct stepper *s = stepper_oid_lookup(args[0]);
+    stepper_queue_step(s, args[1], args[2], args[3]);
 }
 DECL_COMMAND(command_queue_step,
              "queue_step oid=%c interval=%u count=%hu add=%hi");
 
-// Set the direction of the next queued step
+// Schedule a run of identical queue_step commands
 void
-command_set_next_step_dir(uint32_t *args)
+command_queue_step_repeat(uint32_t *args)
 {
     struct stepper *s = stepper_oid_lookup(args[0]);
-    uint8_t nextdir = args[1] ? SF_NEXT_DIR : 0;
+    uint16_t repeat = args[4];
+    if (!repeat)
+        shutdown("Invalid count parameter");
+    while (repeat--)
+        stepper_queue_step(s, args[1], args[2], args[3]);
+}
+DECL_COMMAND(command_queue_step_repeat,
+             "queue_step_repeat oid=%c interval=%u count=%hu add=%hi"
+             " repeat=%hu");
+
+// Schedule a series of delta encoded queue_step commands.  The data
+// is a stream of (interval delta, count, add) vlq tuples - each
+// interval is relative to the interval of the previous tuple.
+void
+command_queue_step_pack(uint32_t *args)
+{
+    struct stepper *s = stepper_oid_lookup(args[0]);
+    uint_fast8_t len = args[1];
+    uint8_t *data = command_decode_ptr(args[2]), *end = data + len;
+    uint32_t interval = 0;
+    while (data < end) {
+        interval += command_parse_int(&data);
+        uint16_t count = command_parse_int(&data);
+        int16_t add = command_parse_int(&data);
+        if (data > end)
+            shutdown("Invalid queue_step_pack command");
+        stepper_queue_step(s, interval, count, add);
+    }
+}
+DECL_COMMAND(command_queue_step_pack, "queue_step_pack oid=%c data=%*s");
+
+// Set the direction of the next queued step
+void
+stepper_set_next_step_dir(struct stepper *s, uint_fast8_t dir)
+{
+    uint8_t nextdir = dir ? SF_NEXT_DIR : 0;
     irq_disable();
     s->flags = (s->flags & ~SF_NEXT_DIR) | nextdir;
     irq_enable();
 }
+
+void
+command_set_next_step_dir(uint32_t *args)
+{
+    struct stepper *s = stepper_oid_lookup(args[0]);
+    stepper_set_next_step_dir(s, args[1]);
+}
 DECL_COMMAND(command_set_next_step_dir, "set_next_step_dir oid=%c dir=%c");
 
 // Set an absolute time that the next step will be relative to
 void
-command_reset_step_clock(uint32_t *args)
+stepper_reset_step_clock(struct stepper *s, uint32_t waketime)
 {
-    struct stepper *s = stepper_oid_lookup(args[0]);
-    uint32_t waketime = args[1];
     irq_disable();
-    if (s->count)
+    if (s->count || (HAVE_DMA_OFFLOAD && s->flags & SF_DMA_ACTIVE))
         shutdown("Can't reset time when stepper active");
+    // Free queued moves if a stepper stop was not yet fully reaped
+    while (!move_queue_empty(&s->mq)) {
+        struct move_node *mn = move_queue_pop(&s->mq);
+        move_free(container_of(mn, struct stepper_move, node));
+    }
     s->next_step_time = s->time.waketime = waketime;
     s->flags &= ~SF_NEED_RESET;
     irq_enable();
 }
+
+void
+command_reset_step_clock(uint32_t *args)
+{
+    struct stepper *s = stepper_oid_lookup(args[0]);
+    stepper_reset_step_clock(s, args[1]);
+}
 DECL_COMMAND(command_reset_step_clock, "reset_step_clock oid=%c clock=%u");
 
 // Return the current stepper position.  Caller must disable irqs.
@@ -322,6 +760,14 @@ stepper_get_position(struct stepper *s)
 {
     uint32_t position = s->position;
     // If stepper is mid-move, subtract out steps not yet taken
+#if HAVE_RING_PREDECODE
+    position -= s->pd_count;
+#endif
+#if HAVE_DMA_OFFLOAD
+    if (s->sd)
+        position -= s->count + stepper_dma_pending(s->sd);
+    else
+#endif
     if (s->flags & SF_SINGLE_SCHED)
         position -= s->count;
     else
@@ -332,6 +778,16 @@ stepper_get_position(struct stepper *s)
     return position;
 }
 
+// Return the commanded position (for on-mcu comparison against sensors)
+uint32_t
+stepper_get_commanded_position(struct stepper *s)
+{
+    irq_disable();
+    uint32_t position = stepper_get_position(s);
+    irq_enable();
+    return position;
+}
+
 // Report the current position of the stepper
 void
 command_stepper_get_position(uint32_t *args)
@@ -345,7 +801,55 @@ command_stepper_get_position(uint32_t *args)
 }
 DECL_COMMAND(command_stepper_get_position, "stepper_get_position oid=%c");
 
-// Stop all moves for a given stepper (caller must disable IRQs)
+#if HAVE_JITTER_AUDIT
+
+// Arm (or disarm) jitter auditing and clear the histogram
+void
+command_stepper_set_jitter_audit(uint32_t *args)
+{
+    struct stepper *s = stepper_oid_lookup(args[0]);
+    irq_disable();
+    memset(s->jitter_counts, 0, sizeof(s->jitter_counts));
+    s->jitter_max = 0;
+    s->jitter_active = !!args[1];
+    irq_enable();
+}
+DECL_COMMAND(command_stepper_set_jitter_audit,
+             "stepper_set_jitter_audit oid=%c enable=%c");
+
+// Report the accumulated dispatch latency histogram
+void
+command_stepper_get_jitter(uint32_t *args)
+{
+    uint8_t oid = args[0];
+    struct stepper *s = stepper_oid_lookup(oid);
+    uint32_t counts[JITTER_BUCKETS], jitter_max;
+    irq_disable();
+    memcpy(counts, s->jitter_counts, sizeof(counts));
+    jitter_max = s->jitter_max;
+    irq_enable();
+    // Encode bucket counts as 32bit little endian values
+    uint8_t data[JITTER_BUCKETS * 4];
+    uint_fast8_t i;
+    for (i = 0; i < JITTER_BUCKETS; i++) {
+        data[i*4] = counts[i];
+        data[i*4 + 1] = counts[i] >> 8;
+        data[i*4 + 2] = counts[i] >> 16;
+        data[i*4 + 3] = counts[i] >> 24;
+    }
+    sendf("stepper_jitter oid=%c max=%u counts=%*s"
+          , oid, jitter_max, sizeof(data), data);
+}
+DECL_COMMAND(command_stepper_get_jitter, "stepper_get_jitter oid=%c");
+
+#endif // HAVE_JITTER_AUDIT
+
+static struct task_wake stepper_stop_wake;
+
+// Stop all moves for a given stepper (caller must disable IRQs).
+// This runs from the trsync trigger walk, so it must stay short and
+// of uniform cost across steppers - freeing the queued moves is
+// deferred to stepper_stop_task().
 static void
 stepper_stop(struct trsync_signal *tss, uint8_t reason)
 {
@@ -354,6 +858,15 @@ stepper_stop(struct trsync_signal *tss, uint8_t reason)
     s->next_step_time = s->time.waketime = 0;
     s->position = -stepper_get_position(s);
     s->count = 0;
+#if HAVE_DMA_OFFLOAD
+    if (s->sd)
+        stepper_dma_stop(s->sd);
+    s->dma_dir = 0;
+#endif
+#if HAVE_RING_PREDECODE
+    s->pd_count = 0;
+    s->ring_head = s->ring_tail = 0;
+#endif
     s->flags = ((s->flags & (SF_INVERT_STEP|SF_SINGLE_SCHED|SF_OPTIMIZED_PATH))
                 | SF_NEED_RESET);
     gpio_out_write(s->dir_pin, 0);
@@ -361,12 +874,32 @@ stepper_stop(struct trsync_signal *tss, uint8_t reason)
         || (HAVE_AVR_OPTIMIZATION && s->flags & SF_OPTIMIZED_PATH))
         // Must return step pin to "unstep" state
         gpio_out_write(s->step_pin, s->flags & SF_INVERT_STEP);
-    while (!move_queue_empty(&s->mq)) {
-        struct move_node *mn = move_queue_pop(&s->mq);
-        struct stepper_move *m = container_of(mn, struct stepper_move, node);
-        move_free(m);
+    if (!move_queue_empty(&s->mq))
+        sched_wake_task(&stepper_stop_wake);
+}
+
+// Free the moves left queued on stopped steppers
+void
+stepper_stop_task(void)
+{
+    if (!sched_check_wake(&stepper_stop_wake))
+        return;
+    uint8_t i;
+    struct stepper *s;
+    foreach_oid(i, s, command_config_stepper) {
+        for (;;) {
+            irq_disable();
+            if (!(s->flags & SF_NEED_RESET) || move_queue_empty(&s->mq)) {
+                irq_enable();
+                break;
+            }
+            struct move_node *mn = move_queue_pop(&s->mq);
+            move_free(container_of(mn, struct stepper_move, node));
+            irq_enable();
+        }
     }
 }
+DECL_TASK_WAKE(stepper_stop_task, stepper_stop_wake);
 
 // Set the stepper to stop on a "trigger event" (used in homing)
 void
@@ -5,4 +5,25 @@
 
 uint_fast8_t stepper_event(struct timer *t);
 
+struct stepper;
+struct stepper *stepper_oid_lookup(uint8_t oid);
+void stepper_queue_step(struct stepper *s, uint32_t interval, uint16_t count
+                        , int16_t add);
+void stepper_set_next_step_dir(struct stepper *s, uint_fast8_t dir);
+void stepper_reset_step_clock(struct stepper *s, uint32_t waketime);
+uint32_t stepper_get_commanded_position(struct stepper *s);
+
+// Hardware step pulse offload (boards with CONFIG_HAVE_STEPPER_DMA)
+struct stepper_dma;
+struct stepper_dma *stepper_dma_setup(uint32_t step_pin, uint32_t dir_pin
+                                      , uint32_t invert_step
+                                      , uint32_t step_pulse_ticks);
+int_fast16_t stepper_dma_space(struct stepper_dma *sd);
+void stepper_dma_push(struct stepper_dma *sd, uint32_t interval
+                      , uint_fast8_t dir);
+void stepper_dma_start(struct stepper_dma *sd, uint32_t first_step_time);
+void stepper_dma_flush(struct stepper_dma *sd);
+uint32_t stepper_dma_pending(struct stepper_dma *sd);
+void stepper_dma_stop(struct stepper_dma *sd);
+
 #endif // stepper.h
@@ -0,0 +1,113 @@
+// GPIO edge interrupt support on stm32 (EXTI peripheral)
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <string.h> // ffs
+#include "autoconf.h" // CONFIG_MACH_STM32F1
+#include "board/armcm_boot.h" // armcm_enable_irq
+#include "board/irq.h" // irq_save
+#include "gpio.h" // gpio_in_attach_irq
+#include "internal.h" // enable_pclock
+
+// The EXTI register layout varies between stm32 generations
+#if CONFIG_MACH_STM32G0
+ #define EXTI_IMR_REG   (EXTI->IMR1)
+ #define EXTI_RTSR_REG  (EXTI->RTSR1)
+ #define EXTI_PEND_REG  (EXTI->RPR1)
+ #define EXTI_EXTICR    (EXTI->EXTICR)
+ #define EXTICR_SHIFT   8
+#elif CONFIG_MACH_STM32G4 || CONFIG_MACH_STM32H7 || CONFIG_MACH_STM32L4
+ #define EXTI_IMR_REG   (EXTI->IMR1)
+ #define EXTI_RTSR_REG  (EXTI->RTSR1)
+ #define EXTI_PEND_REG  (EXTI->PR1)
+ #define EXTI_EXTICR    (SYSCFG->EXTICR)
+ #define EXTICR_SHIFT   4
+#elif CONFIG_MACH_STM32F1
+ #define EXTI_IMR_REG   (EXTI->IMR)
+ #define EXTI_RTSR_REG  (EXTI->RTSR)
+ #define EXTI_PEND_REG  (EXTI->PR)
+ #define EXTI_EXTICR    (AFIO->EXTICR)
+ #define EXTICR_SHIFT   4
+#else
+ #define EXTI_IMR_REG   (EXTI->IMR)
+ #define EXTI_RTSR_REG  (EXTI->RTSR)
+ #define EXTI_PEND_REG  (EXTI->PR)
+ #define EXTI_EXTICR    (SYSCFG->EXTICR)
+ #define EXTICR_SHIFT   4
+#endif
+
+// One handler per exti line (a line serves the same pin of every port)
+static struct {
+    void (*func)(void *);
+    void *data;
+} exti_handlers[16];
+static uint16_t exti_claimed;
+
+// Dispatch pending gpio edge events to their attached handlers
+static void
+exti_IRQHandler(void)
+{
+    uint32_t pend = EXTI_PEND_REG & exti_claimed;
+    EXTI_PEND_REG = pend; // clear the events (write one to clear)
+    while (pend) {
+        uint32_t line = ffs(pend) - 1;
+        pend &= ~(1 << line);
+        exti_handlers[line].func(exti_handlers[line].data);
+    }
+}
+
+// Enable the nvic interrupts used by the exti lines
+static void
+exti_enable_irqs(void)
+{
+#if CONFIG_MACH_STM32F0 || CONFIG_MACH_STM32G0
+    armcm_enable_irq(exti_IRQHandler, EXTI0_1_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI2_3_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI4_15_IRQn, 1);
+#else
+    armcm_enable_irq(exti_IRQHandler, EXTI0_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI1_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI2_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI3_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI4_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI9_5_IRQn, 1);
+    armcm_enable_irq(exti_IRQHandler, EXTI15_10_IRQn, 1);
+#endif
+}
+
+// Call 'func(data)' on rising edges of an input pin.  Returns -1 if
+// the pin's exti line is already claimed by another pin.
+int
+gpio_in_attach_irq(struct gpio_in g, void (*func)(void *), void *data)
+{
+    uint32_t port = ((uint32_t)g.regs - GPIOA_BASE) / 0x400;
+    uint32_t line = ffs(g.bit) - 1;
+    if (exti_claimed & (1 << line))
+        return -1;
+    if (!exti_claimed) {
+#if CONFIG_MACH_STM32F1
+        if (!is_enabled_pclock(AFIO_BASE))
+            enable_pclock(AFIO_BASE);
+#elif !CONFIG_MACH_STM32G0
+        if (!is_enabled_pclock(SYSCFG_BASE))
+            enable_pclock(SYSCFG_BASE);
+#endif
+        exti_enable_irqs();
+    }
+    exti_handlers[line].func = func;
+    exti_handlers[line].data = data;
+    exti_claimed |= 1 << line;
+
+    // Route the pin's port to the exti line and unmask rising edges
+    irqstatus_t flag = irq_save();
+    uint32_t shift = (line % 4) * EXTICR_SHIFT, mask = (1 << EXTICR_SHIFT) - 1;
+    EXTI_EXTICR[line / 4] = ((EXTI_EXTICR[line / 4] & ~(mask << shift))
+                             | (port << shift));
+    EXTI_RTSR_REG |= 1 << line;
+    EXTI_PEND_REG = 1 << line; // clear any stale event
+    EXTI_IMR_REG |= 1 << line;
+    irq_restore(flag);
+    return 0;
+}
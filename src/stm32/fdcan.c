@@ -99,6 +99,9 @@ struct fdcan_fifo {
 #define FDCAN_XTD (1<<30)
 #define FDCAN_RTR (1<<29)
 
+#define FDCAN_FDF (1<<21)
+#define FDCAN_BRS (1<<20)
+
 struct fdcan_msg_ram {
     uint32_t FLS[28]; // Filter list standard
     uint32_t FLE[16]; // Filter list extended
@@ -138,9 +141,13 @@ canhw_send(struct canbus_msg *msg)
         ids = (msg->id & 0x7ff) << 18;
     ids |= msg->id & CANMSG_ID_RTR ? FDCAN_RTR : 0;
     txfifo->id_section = ids;
-    txfifo->dlc_section = (msg->dlc & 0x0f) << 16;
-    txfifo->data[0] = msg->data32[0];
-    txfifo->data[1] = msg->data32[1];
+    uint32_t dlcs = (msg->dlc & 0x0f) << 16;
+    if (CONFIG_CANBUS_FD)
+        dlcs |= FDCAN_FDF | FDCAN_BRS;
+    txfifo->dlc_section = dlcs;
+    uint32_t len = CANMSG_DATA_LEN(msg), i;
+    for (i = 0; i < DIV_ROUND_UP(len, 4); i++)
+        txfifo->data[i] = msg->data32[i];
     barrier();
     SOC_CAN->TXBAR = ((uint32_t)1 << w_index);
     return CANMSG_DATA_LEN(msg);
@@ -243,8 +250,9 @@ CAN_IRQHandler(void)
                 msg.id = (ids >> 18) & 0x7ff;
             msg.id |= ids & FDCAN_RTR ? CANMSG_ID_RTR : 0;
             msg.dlc = (rxf0->dlc_section >> 16) & 0x0f;
-            msg.data32[0] = rxf0->data[0];
-            msg.data32[1] = rxf0->data[1];
+            uint32_t len = CANMSG_DATA_LEN(&msg), i;
+            for (i = 0; i < DIV_ROUND_UP(len, 4); i++)
+                msg.data32[i] = rxf0->data[i];
             barrier();
             SOC_CAN->RXF0A = idx;
 
@@ -349,6 +357,25 @@ can_init(void)
 
     SOC_CAN->NBTP = btr;
 
+    if (CONFIG_CANBUS_FD) {
+        // Setup data phase bit timing and enable bit-rate switching
+        uint32_t dclocks = pclock / CONFIG_CANBUS_FD_DATA_FREQUENCY, dqs;
+        for (dqs = 18; dqs > 9; dqs--) {
+            if (dclocks % dqs == 0)
+                break;
+        }
+        uint32_t dbrp = dclocks / dqs;
+        uint32_t dseg2 = dqs / 8, dseg1 = dqs - (1 + dseg2);
+        SOC_CAN->DBTP = (FDCAN_DBTP_TDC
+                         | ((uint32_t)(2-1)) << FDCAN_DBTP_DSJW_Pos
+                         | (dseg1-1) << FDCAN_DBTP_DTSEG1_Pos
+                         | (dseg2-1) << FDCAN_DBTP_DTSEG2_Pos
+                         | (dbrp-1) << FDCAN_DBTP_DBRP_Pos);
+        // Compensate for transceiver loop delay at the data bit rate
+        SOC_CAN->TDCR = (dbrp * (1 + dseg1)) << FDCAN_TDCR_TDCO_Pos;
+        SOC_CAN->CCCR |= FDCAN_CCCR_FDOE | FDCAN_CCCR_BRSE;
+    }
+
 #if CONFIG_MACH_STM32H7
     /* Setup message RAM addresses */
     uint32_t f0sa = (uint32_t)MSG_RAM.RXF0 - SRAMCAN_BASE;
@@ -0,0 +1,151 @@
+// Dual-bank flash update support for STM32H743
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include <string.h> // memcpy
+#include "autoconf.h" // CONFIG_FLASH_SIZE
+#include "board/flash_bank.h" // flash_bank_swap
+#include "board/irq.h" // irq_disable
+#include "internal.h" // FLASH
+#include "sched.h" // shutdown
+
+// The stm32h743 flash is split into two symmetric banks that can be
+// erased and programmed independently while code executes from the
+// other bank.  The SWAP_BANK option bit exchanges the memory mapping
+// of the banks - the inactive bank is always visible at the alias
+// address of the second bank.  The swap only takes effect on the next
+// option byte load, so flash_bank_swap() programs the bit and
+// immediately resets the chip.
+
+#define FLASH_KEY1 0x45670123
+#define FLASH_KEY2 0xCDEF89AB
+#define FLASH_OPTKEY1 0x08192A3B
+#define FLASH_OPTKEY2 0x4C5D6E7F
+
+#define BANK_SIZE (CONFIG_FLASH_SIZE / 2)
+#define SECTOR_SIZE (128 * 1024)
+#define FLASH_WORD_SIZE 32
+#define INACTIVE_BANK_BASE (CONFIG_FLASH_BOOT_ADDRESS + BANK_SIZE)
+
+struct bank_regs {
+    volatile uint32_t *keyr, *cr, *sr, *ccr;
+};
+
+static int
+is_swapped(void)
+{
+    return !!(FLASH->OPTCR & FLASH_OPTCR_SWAP_BANK);
+}
+
+// Lookup the control registers of the inactive physical bank
+static void
+get_inactive_regs(struct bank_regs *regs)
+{
+    if (is_swapped()) {
+        regs->keyr = &FLASH->KEYR1;
+        regs->cr = &FLASH->CR1;
+        regs->sr = &FLASH->SR1;
+        regs->ccr = &FLASH->CCR1;
+    } else {
+        regs->keyr = &FLASH->KEYR2;
+        regs->cr = &FLASH->CR2;
+        regs->sr = &FLASH->SR2;
+        regs->ccr = &FLASH->CCR2;
+    }
+}
+
+static void
+wait_flash_idle(struct bank_regs *regs)
+{
+    while (*regs->sr & (FLASH_SR_BSY | FLASH_SR_QW))
+        ;
+    // Clear any prior operation status
+    *regs->ccr = *regs->sr;
+}
+
+static void
+unlock_inactive(struct bank_regs *regs)
+{
+    if (*regs->cr & FLASH_CR_LOCK) {
+        *regs->keyr = FLASH_KEY1;
+        *regs->keyr = FLASH_KEY2;
+    }
+}
+
+uint8_t
+flash_bank_active(void)
+{
+    return is_swapped() ? 2 : 1;
+}
+
+uint32_t
+flash_bank_size(void)
+{
+    return BANK_SIZE;
+}
+
+uint32_t
+flash_bank_block_size(void)
+{
+    return FLASH_WORD_SIZE;
+}
+
+const uint8_t *
+flash_bank_inactive_base(void)
+{
+    return (const uint8_t *)INACTIVE_BANK_BASE;
+}
+
+void
+flash_bank_erase_sector(uint32_t offset)
+{
+    struct bank_regs regs;
+    get_inactive_regs(&regs);
+    wait_flash_idle(&regs);
+    unlock_inactive(&regs);
+    uint32_t snb = offset / SECTOR_SIZE;
+    *regs.cr = (FLASH_CR_SER | FLASH_CR_PSIZE_1
+                | (snb << FLASH_CR_SNB_Pos));
+    *regs.cr |= FLASH_CR_START;
+    wait_flash_idle(&regs);
+    *regs.cr = FLASH_CR_LOCK;
+}
+
+void
+flash_bank_write_block(uint32_t offset, const uint8_t *data)
+{
+    // Copy to an aligned buffer (the command data may be unaligned)
+    uint32_t buf[FLASH_WORD_SIZE / 4];
+    memcpy(buf, data, FLASH_WORD_SIZE);
+    struct bank_regs regs;
+    get_inactive_regs(&regs);
+    wait_flash_idle(&regs);
+    unlock_inactive(&regs);
+    *regs.cr = FLASH_CR_PG | FLASH_CR_PSIZE_1;
+    volatile uint32_t *dest = (void *)(INACTIVE_BANK_BASE + offset);
+    int i;
+    for (i = 0; i < FLASH_WORD_SIZE / 4; i++)
+        dest[i] = buf[i];
+    wait_flash_idle(&regs);
+    *regs.cr = FLASH_CR_LOCK;
+}
+
+void
+flash_bank_swap(void)
+{
+    struct bank_regs regs;
+    get_inactive_regs(&regs);
+    wait_flash_idle(&regs);
+    irq_disable();
+    if (FLASH->OPTCR & FLASH_OPTCR_OPTLOCK) {
+        FLASH->OPTKEYR = FLASH_OPTKEY1;
+        FLASH->OPTKEYR = FLASH_OPTKEY2;
+    }
+    FLASH->OPTSR_PRG = FLASH->OPTSR_CUR ^ FLASH_OPTSR_SWAP_BANK_OPT;
+    FLASH->OPTCR |= FLASH_OPTCR_OPTSTART;
+    while (FLASH->OPTSR_CUR & FLASH_OPTSR_OPT_BUSY)
+        ;
+    NVIC_SystemReset();
+}
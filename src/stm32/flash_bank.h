@@ -0,0 +1,14 @@
+#ifndef __STM32_FLASH_BANK_H
+#define __STM32_FLASH_BANK_H
+
+#include <stdint.h> // uint32_t
+
+uint8_t flash_bank_active(void);
+uint32_t flash_bank_size(void);
+uint32_t flash_bank_block_size(void);
+const uint8_t *flash_bank_inactive_base(void);
+void flash_bank_erase_sector(uint32_t offset);
+void flash_bank_write_block(uint32_t offset, const uint8_t *data);
+void flash_bank_swap(void);
+
+#endif // flash_bank.h
@@ -125,6 +125,26 @@ gpio_out_write(struct gpio_out g, uint32_t val)
         regs->BSRR = g.bit << 16;
 }
 
+// Helpers for toggling several outputs on one port in a single write
+void *
+gpio_out_port(struct gpio_out g)
+{
+    return g.regs;
+}
+
+uint32_t
+gpio_out_bit(struct gpio_out g)
+{
+    return g.bit;
+}
+
+void
+gpio_out_port_toggle_noirq(void *port, uint32_t bits)
+{
+    GPIO_TypeDef *regs = port;
+    regs->ODR ^= bits;
+}
+
 
 struct gpio_in
 gpio_in_setup(uint32_t pin, int32_t pull_up)
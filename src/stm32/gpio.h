@@ -15,6 +15,9 @@ void gpio_out_reset(struct gpio_out g, uint32_t val);
 void gpio_out_toggle_noirq(struct gpio_out g);
 void gpio_out_toggle(struct gpio_out g);
 void gpio_out_write(struct gpio_out g, uint32_t val);
+void *gpio_out_port(struct gpio_out g);
+uint32_t gpio_out_bit(struct gpio_out g);
+void gpio_out_port_toggle_noirq(void *port, uint32_t bits);
 
 struct gpio_in {
     void *regs;
@@ -23,6 +26,7 @@ struct gpio_in {
 struct gpio_in gpio_in_setup(uint32_t pin, int32_t pull_up);
 void gpio_in_reset(struct gpio_in g, int32_t pull_up);
 uint8_t gpio_in_read(struct gpio_in g);
+int gpio_in_attach_irq(struct gpio_in g, void (*func)(void *), void *data);
 
 struct gpio_pwm {
     void *reg;
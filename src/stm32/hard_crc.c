@@ -0,0 +1,44 @@
+// CRC16 calculation using the crc peripheral
+//
+// Copyright (C) 2026  Kevin O'Connor <kevin@koconnor.net>
+//
+// This file may be distributed under the terms of the GNU GPLv3 license.
+
+#include "board/irq.h" // irq_save
+#include "board/misc.h" // crc16_ccitt
+#include "internal.h" // RCC
+#include "sched.h" // DECL_INIT
+
+// Implement the standard crc "ccitt" algorithm using the crc unit.
+// The peripheral is shared global state, so irqs are disabled while a
+// calculation is in progress (frames are at most 64 bytes).
+uint16_t
+crc16_ccitt(uint8_t *buf, uint_fast8_t len)
+{
+    irqstatus_t flag = irq_save();
+    CRC->POL = 0x1021;
+    CRC->INIT = 0xffff;
+    CRC->CR = (CRC_CR_REV_OUT | CRC_CR_REV_IN_0 | CRC_CR_POLYSIZE_0
+               | CRC_CR_RESET);
+    while (len--)
+        *(volatile uint8_t *)&CRC->DR = *buf++;
+    uint16_t crc = CRC->DR;
+    irq_restore(flag);
+    return crc;
+}
+
+void
+hard_crc_init(void)
+{
+#if defined(RCC_AHB4ENR_CRCEN)
+    RCC->AHB4ENR |= RCC_AHB4ENR_CRCEN;
+    RCC->AHB4ENR;
+#elif defined(RCC_AHB1ENR_CRCEN)
+    RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+    RCC->AHB1ENR;
+#else
+    RCC->AHBENR |= RCC_AHBENR_CRCEN;
+    RCC->AHBENR;
+#endif
+}
+DECL_INIT(hard_crc_init);
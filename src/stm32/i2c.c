@@ -83,11 +83,17 @@ i2c_setup(uint32_t bus, uint32_t rate, uint8_t addr)
         i2c->CR1 = I2C_CR1_SWRST;
         i2c->CR1 = 0;
 
-        // Set 100Khz frequency and enable
+        // Set frequency and enable (this i2c peripheral has no
+        // fast-mode plus support - the rate is capped at 400Khz)
         uint32_t pclk = get_pclock_frequency((uint32_t)i2c);
         i2c->CR2 = pclk / 1000000;
-        i2c->CCR = pclk / 100000 / 2;
-        i2c->TRISE = (pclk / 1000000) + 1;
+        if (rate >= 400000) {
+            i2c->CCR = I2C_CCR_FS | DIV_ROUND_UP(pclk, 3 * 400000);
+            i2c->TRISE = (pclk / 1000000) * 300 / 1000 + 1;
+        } else {
+            i2c->CCR = pclk / 100000 / 2;
+            i2c->TRISE = (pclk / 1000000) + 1;
+        }
         i2c->CR1 = I2C_CR1_PE;
     }
 
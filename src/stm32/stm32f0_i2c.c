@@ -160,8 +160,13 @@ i2c_setup(uint32_t bus, uint32_t rate, uint8_t addr)
         uint32_t sclh = 48; // 48 * 83.3ns = 4us
         uint32_t sdadel = 6; // 6 * 83.3ns = 500ns
         uint32_t scldel = 15; // 15 * 83.3ns = 1250ns
-        // Clamp the rate to 400Khz
-        if (rate >= 400000) {
+        // Clamp the rate to 1Mhz (fast-mode plus)
+        if (rate >= 1000000) {
+            scll = 6; // 6 * 83.3ns = 500ns
+            sclh = 4; // 4 * 83.3 = 333ns
+            sdadel = 2; // 2 * 83.3 = 167ns
+            scldel = 3; // 3 * 83.3 = 250ns
+        } else if (rate >= 400000) {
             scll = 15; // 15 * 83.3ns = 1250ns
             sclh = 6; // 6 * 83.3 = 500ns
             sdadel = 4; // 4 * 83.3 = 333ns
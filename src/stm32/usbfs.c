@@ -216,8 +216,8 @@ epr_is_dbuf_blocking(uint32_t epr)
 
 static uint32_t bulk_out_pop_count, bulk_out_push_flag;
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     if (readl(&bulk_out_push_flag))
         // No data ready
@@ -277,8 +277,8 @@ usb_send_bulk_in_double_buffer(void *data, uint_fast8_t len)
 }
 
 // Send bulk usb packet to host
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     if (CONFIG_STM32_USB_DOUBLE_BUFFER_TX)
         return usb_send_bulk_in_double_buffer(data, len);
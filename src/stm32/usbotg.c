@@ -14,8 +14,14 @@
 #include "internal.h" // GPIO
 #include "sched.h" // DECL_INIT
 
-#if CONFIG_STM32_USB_PB14_PB15
+#if CONFIG_STM32_USB_HS_ULPI
   #define IS_OTG_HS 1
+  #define IS_ULPI_PHY 1
+  DECL_CONSTANT_STR("RESERVE_PINS_USB",
+                    "PA3,PA5,PB0,PB1,PB5,PB10,PB11,PB12,PB13,PC0,PC2,PC3");
+#elif CONFIG_STM32_USB_PB14_PB15
+  #define IS_OTG_HS 1
+  #define IS_ULPI_PHY 0
   #define GPIO_D_NEG GPIO('B', 14)
   #define GPIO_D_POS GPIO('B', 15)
   #define GPIO_FUNC GPIO_FUNCTION(12)
@@ -26,6 +32,7 @@
   #else
     #define IS_OTG_HS 0
   #endif
+  #define IS_ULPI_PHY 0
   #define GPIO_D_NEG GPIO('A', 11)
   #define GPIO_D_POS GPIO('A', 12)
   #define GPIO_FUNC GPIO_FUNCTION(10)
@@ -88,10 +95,14 @@ fifo_configure(void)
         | (ep_size << USB_OTG_DIEPTXF_INEPTXFD_Pos));
     fpos += ep_size;
 
+    // Bulk in fifo must hold a full packet
+    uint32_t in_size = DIV_ROUND_UP(USB_CDC_EP_BULK_IN_SIZE, 4);
+    if (in_size < ep_size)
+        in_size = ep_size;
     OTG->DIEPTXF[USB_CDC_EP_BULK_IN - 1] = (
         (fpos << USB_OTG_DIEPTXF_INEPTXSA_Pos)
-        | (ep_size << USB_OTG_DIEPTXF_INEPTXFD_Pos));
-    fpos += ep_size;
+        | (in_size << USB_OTG_DIEPTXF_INEPTXFD_Pos));
+    fpos += in_size;
 }
 
 // Write a packet to a tx fifo
@@ -138,8 +149,8 @@ fifo_write_packet_fast(uint32_t ep, const uint32_t *src, uint32_t len)
 }
 
 // Read a packet from the rx queue
-static int_fast8_t
-fifo_read_packet(uint8_t *dest, uint_fast8_t max_len)
+static int_fast16_t
+fifo_read_packet(uint8_t *dest, uint_fast16_t max_len)
 {
     // Transfer data
     void *fifo = EPFIFO(0);
@@ -169,7 +180,8 @@ enable_rx_endpoint(uint32_t ep)
     USB_OTG_OUTEndpointTypeDef *epo = EPOUT(ep);
     uint32_t ctl = epo->DOEPCTL;
     if (!(ctl & USB_OTG_DOEPCTL_EPENA) || ctl & USB_OTG_DOEPCTL_NAKSTS) {
-        epo->DOEPTSIZ = 64 | (1 << USB_OTG_DOEPTSIZ_PKTCNT_Pos);
+        uint32_t xfrsiz = ep ? USB_CDC_EP_BULK_OUT_SIZE : 64;
+        epo->DOEPTSIZ = xfrsiz | (1 << USB_OTG_DOEPTSIZ_PKTCNT_Pos);
         epo->DOEPCTL = ctl | USB_OTG_DOEPCTL_EPENA | USB_OTG_DOEPCTL_CNAK;
     }
 }
@@ -209,8 +221,8 @@ peek_rx_queue(uint32_t ep)
  * USB interface
  ****************************************************************/
 
-int_fast8_t
-usb_read_bulk_out(void *data, uint_fast8_t max_len)
+int_fast16_t
+usb_read_bulk_out(void *data, uint_fast16_t max_len)
 {
     usb_irq_disable();
     uint32_t grx = peek_rx_queue(USB_CDC_EP_BULK_OUT);
@@ -232,8 +244,8 @@ static struct {
     uint32_t buf[USB_CDC_EP_BULK_IN_SIZE / sizeof(uint32_t)];
 } TX_BUF;
 
-int_fast8_t
-usb_send_bulk_in(void *data, uint_fast8_t len)
+int_fast16_t
+usb_send_bulk_in(void *data, uint_fast16_t len)
 {
     usb_irq_disable();
     uint32_t ctl = EPIN(USB_CDC_EP_BULK_IN)->DIEPCTL;
@@ -387,7 +399,8 @@ usb_set_configure(void)
 
     // Configure and enable USB_CDC_EP_BULK_OUT
     USB_OTG_OUTEndpointTypeDef *epo = EPOUT(USB_CDC_EP_BULK_OUT);
-    epo->DOEPTSIZ = 64 | (1 << USB_OTG_DOEPTSIZ_PKTCNT_Pos);
+    epo->DOEPTSIZ = (USB_CDC_EP_BULK_OUT_SIZE
+                     | (1 << USB_OTG_DOEPTSIZ_PKTCNT_Pos));
     epo->DOEPCTL = (
         USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_USBAEP | USB_OTG_DOEPCTL_EPENA
         | (0x02 << USB_OTG_DOEPCTL_EPTYP_Pos) | USB_OTG_DOEPCTL_SD0PID_SEVNFRM
@@ -460,31 +473,52 @@ usb_init(void)
         SET_BIT(PWR->CR3, PWR_CR3_USB33DEN);
     }
     SET_BIT(RCC->AHB1ENR, USBOTGEN);
+    if (IS_ULPI_PHY)
+        SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_USB1OTGHSULPIEN);
 #else
     RCC->AHB2ENR |= RCC_AHB2ENR_OTGFSEN;
 #endif
     while (!(OTG->GRSTCTL & USB_OTG_GRSTCTL_AHBIDL))
         ;
 
-    // Configure USB in full-speed device mode
-    OTG->GUSBCFG = (USB_OTG_GUSBCFG_FDMOD | USB_OTG_GUSBCFG_PHYSEL
-                    | (6 << USB_OTG_GUSBCFG_TRDT_Pos));
-    OTGD->DCFG |= (3 << USB_OTG_DCFG_DSPD_Pos);
+    if (IS_ULPI_PHY) {
+        // Configure USB in high-speed device mode (external ULPI phy)
+        OTG->GUSBCFG = (USB_OTG_GUSBCFG_FDMOD
+                        | (9 << USB_OTG_GUSBCFG_TRDT_Pos));
+        OTGD->DCFG &= ~USB_OTG_DCFG_DSPD_Msk;
+    } else {
+        // Configure USB in full-speed device mode
+        OTG->GUSBCFG = (USB_OTG_GUSBCFG_FDMOD | USB_OTG_GUSBCFG_PHYSEL
+                        | (6 << USB_OTG_GUSBCFG_TRDT_Pos));
+        OTGD->DCFG |= (3 << USB_OTG_DCFG_DSPD_Pos);
+    }
 #if CONFIG_MACH_STM32F446 || CONFIG_MACH_STM32H7 || CONFIG_MACH_STM32F7
     OTG->GOTGCTL = USB_OTG_GOTGCTL_BVALOEN | USB_OTG_GOTGCTL_BVALOVAL;
 #else
     OTG->GCCFG |= USB_OTG_GCCFG_NOVBUSSENS;
 #endif
 
+#if CONFIG_STM32_USB_HS_ULPI
+    // Route ULPI pins
+    static const uint32_t ulpi_pins[] = {
+        GPIO('A', 3), GPIO('A', 5), GPIO('B', 0), GPIO('B', 1),
+        GPIO('B', 5), GPIO('B', 10), GPIO('B', 11), GPIO('B', 12),
+        GPIO('B', 13), GPIO('C', 0), GPIO('C', 2), GPIO('C', 3),
+    };
+    uint32_t i;
+    for (i = 0; i < ARRAY_SIZE(ulpi_pins); i++)
+        gpio_peripheral(ulpi_pins[i], GPIO_FUNCTION(10) | GPIO_HIGH_SPEED, 0);
+#else
     // Route pins
     gpio_peripheral(GPIO_D_NEG, GPIO_FUNC, 0);
     gpio_peripheral(GPIO_D_POS, GPIO_FUNC, 0);
+#endif
 
     // Setup USB packet memory
     fifo_configure();
 
-    // Configure and enable ep0
-    uint32_t mpsize_ep0 = 2;
+    // Configure and enable ep0 (MPSIZ encoding: 0 is 64 bytes, 2 is 16)
+    uint32_t mpsize_ep0 = CONFIG_USB_HIGHSPEED ? 0 : 2;
     USB_OTG_INEndpointTypeDef *epi = EPIN(0);
     USB_OTG_OUTEndpointTypeDef *epo = EPOUT(0);
     epi->DIEPCTL = mpsize_ep0 | USB_OTG_DIEPCTL_SNAK;
@@ -499,7 +533,9 @@ usb_init(void)
     armcm_enable_irq(OTG_FS_IRQHandler, OTG_IRQn, 1);
 
     // Enable USB
-    OTG->GCCFG |= USB_OTG_GCCFG_PWRDWN;
+    if (!IS_ULPI_PHY)
+        // Power up the internal full-speed transceiver
+        OTG->GCCFG |= USB_OTG_GCCFG_PWRDWN;
     OTGD->DCTL = 0;
 }
 DECL_INIT(usb_init);
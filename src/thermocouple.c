@@ -57,6 +57,7 @@ command_config_thermocouple(uint32_t *args)
     struct thermocouple_spi *spi = oid_alloc(
         args[0], command_config_thermocouple, sizeof(*spi));
     spi->timer.func = thermocouple_event;
+    spi->timer.flags = TF_DEFERRABLE;
     spi->spi = spidev_oid_lookup(args[1]);
     spi->chip_type = chip_type;
 }
@@ -85,11 +86,8 @@ DECL_COMMAND(command_query_thermocouple,
              " min_value=%u max_value=%u max_invalid_count=%c");
 
 static void
-thermocouple_respond(struct thermocouple_spi *spi, uint32_t next_begin_time
-                     , uint32_t value, uint8_t fault, uint8_t oid)
+thermocouple_check(struct thermocouple_spi *spi, uint32_t value, uint8_t fault)
 {
-    sendf("thermocouple_result oid=%c next_clock=%u value=%u fault=%c",
-          oid, next_begin_time, value, fault);
     /* check the result and stop if below or above allowed range */
     if (fault || value < spi->min_value || value > spi->max_value) {
         spi->invalid_count++;
@@ -100,24 +98,23 @@ thermocouple_respond(struct thermocouple_spi *spi, uint32_t next_begin_time
     spi->invalid_count = 0;
 }
 
-static void
-thermocouple_handle_max31855(struct thermocouple_spi *spi
-                             , uint32_t next_begin_time, uint8_t oid)
+static uint32_t
+thermocouple_read_max31855(struct thermocouple_spi *spi, uint8_t *fault)
 {
     uint8_t msg[4] = { 0x00, 0x00, 0x00, 0x00 };
     spidev_transfer(spi->spi, 1, sizeof(msg), msg);
     uint32_t value;
     memcpy(&value, msg, sizeof(value));
     value = be32_to_cpu(value);
-    thermocouple_respond(spi, next_begin_time, value, value & 0x07, oid);
+    *fault = value & 0x07;
+    return value;
 }
 
 #define MAX31856_LTCBH_REG 0x0C
 #define MAX31856_SR_REG 0x0F
 
-static void
-thermocouple_handle_max31856(struct thermocouple_spi *spi
-                             , uint32_t next_begin_time, uint8_t oid)
+static uint32_t
+thermocouple_read_max31856(struct thermocouple_spi *spi, uint8_t *fault)
 {
     uint8_t msg[4] = { MAX31856_LTCBH_REG, 0x00, 0x00, 0x00 };
     spidev_transfer(spi->spi, 1, sizeof(msg), msg);
@@ -128,15 +125,15 @@ thermocouple_handle_max31856(struct thermocouple_spi *spi
     msg[0] = MAX31856_SR_REG;
     msg[1] = 0x00;
     spidev_transfer(spi->spi, 1, 2, msg);
-    thermocouple_respond(spi, next_begin_time, value, msg[1], oid);
+    *fault = msg[1];
+    return value;
 }
 
 #define MAX31865_RTDMSB_REG 0x01
 #define MAX31865_FAULTSTAT_REG 0x07
 
-static void
-thermocouple_handle_max31865(struct thermocouple_spi *spi
-                             , uint32_t next_begin_time, uint8_t oid)
+static uint32_t
+thermocouple_read_max31865(struct thermocouple_spi *spi, uint8_t *fault)
 {
     uint8_t msg[4] = { MAX31865_RTDMSB_REG, 0x00, 0x00, 0x00 };
     spidev_transfer(spi->spi, 1, 3, msg);
@@ -147,28 +144,35 @@ thermocouple_handle_max31865(struct thermocouple_spi *spi
     msg[0] = MAX31865_FAULTSTAT_REG;
     msg[1] = 0x00;
     spidev_transfer(spi->spi, 1, 2, msg);
-    uint8_t fault = (msg[1] & ~0x03) | (value & 0x0001);
-    thermocouple_respond(spi, next_begin_time, value, fault, oid);
+    *fault = (msg[1] & ~0x03) | (value & 0x0001);
+    return value;
 }
 
-static void
-thermocouple_handle_max6675(struct thermocouple_spi *spi
-                            , uint32_t next_begin_time, uint8_t oid)
+static uint32_t
+thermocouple_read_max6675(struct thermocouple_spi *spi, uint8_t *fault)
 {
     uint8_t msg[2] = { 0x00, 0x00};
     spidev_transfer(spi->spi, 1, sizeof(msg), msg);
     uint16_t value;
     memcpy(&value, msg, sizeof(msg));
     value = be16_to_cpu(value);
-    thermocouple_respond(spi, next_begin_time, value, value & 0x06, oid);
+    *fault = value & 0x06;
+    return value;
 }
 
-// task to read thermocouple and send response
+// Size of an (oid, fault, value) record in a batched result report
+#define TC_RECORD_SIZE 6
+// Maximum records that fit in one report message
+#define TC_MAX_RECORDS 8
+
+// task to read pending thermocouples and send batched responses
 void
 thermocouple_task(void)
 {
     if (!sched_check_wake(&thermocouple_wake))
         return;
+    uint8_t data[TC_MAX_RECORDS * TC_RECORD_SIZE], pos = 0;
+    uint32_t report_clock = 0;
     uint8_t oid;
     struct thermocouple_spi *spi;
     foreach_oid(oid, spi, command_config_thermocouple) {
@@ -178,20 +182,39 @@ thermocouple_task(void)
         uint32_t next_begin_time = spi->timer.waketime;
         spi->flags &= ~TS_PENDING;
         irq_enable();
+        // Flush accumulated records on clock change or full buffer
+        if (pos && (next_begin_time != report_clock || pos >= sizeof(data))) {
+            sendf("thermocouple_batch_results next_clock=%u data=%*s"
+                  , report_clock, pos, data);
+            pos = 0;
+        }
+        report_clock = next_begin_time;
+        uint8_t fault = 0;
+        uint32_t value = 0;
         switch (spi->chip_type) {
         case TS_CHIP_MAX31855:
-            thermocouple_handle_max31855(spi, next_begin_time, oid);
+            value = thermocouple_read_max31855(spi, &fault);
             break;
         case TS_CHIP_MAX31856:
-            thermocouple_handle_max31856(spi, next_begin_time, oid);
+            value = thermocouple_read_max31856(spi, &fault);
             break;
         case TS_CHIP_MAX31865:
-            thermocouple_handle_max31865(spi, next_begin_time, oid);
+            value = thermocouple_read_max31865(spi, &fault);
             break;
         case TS_CHIP_MAX6675:
-            thermocouple_handle_max6675(spi, next_begin_time, oid);
+            value = thermocouple_read_max6675(spi, &fault);
             break;
         }
+        data[pos++] = oid;
+        data[pos++] = fault;
+        data[pos++] = value >> 24;
+        data[pos++] = value >> 16;
+        data[pos++] = value >> 8;
+        data[pos++] = value;
+        thermocouple_check(spi, value, fault);
     }
+    if (pos)
+        sendf("thermocouple_batch_results next_clock=%u data=%*s"
+              , report_clock, pos, data);
 }
-DECL_TASK(thermocouple_task);
+DECL_TASK_WAKE(thermocouple_task, thermocouple_wake);
@@ -20,11 +20,15 @@ struct tmcuart_s {
     uint8_t pos, read_count, write_count;
     uint32_t cfg_bit_time, bit_time;
     uint8_t data[10];
+    // Queued multi-frame (batch) transaction state
+    uint8_t batch_pos, batch_count, frame_len, batch_read_len, resp_pos;
+    uint8_t batch[40], resp[40];
 };
 
 enum {
     TU_LINE_HIGH = 1<<0, TU_ACTIVE = 1<<1, TU_READ_SYNC = 1<<2,
-    TU_REPORT = 1<<3, TU_PULLUP = 1<<4, TU_SINGLE_WIRE = 1<<5
+    TU_REPORT = 1<<3, TU_PULLUP = 1<<4, TU_SINGLE_WIRE = 1<<5,
+    TU_BATCH = 1<<6
 };
 
 static struct task_wake tmcuart_wake;
@@ -40,10 +44,51 @@ tmcuart_reset_line(struct tmcuart_s *t)
     t->flags = (t->flags & (TU_PULLUP | TU_SINGLE_WIRE)) | TU_LINE_HIGH;
 }
 
+static uint_fast8_t tmcuart_send_event(struct timer *timer);
+static uint_fast8_t tmcuart_send_sync_event(struct timer *timer);
+
+// Setup bit timing and timer function for sending the frame in t->data
+static void
+tmcuart_start_frame(struct tmcuart_s *t)
+{
+    t->pos = 0;
+    if (t->write_count && (t->data[0] & 0x3f) == 0x2a) {
+        t->timer.func = tmcuart_send_sync_event;
+    } else {
+        t->bit_time = t->cfg_bit_time;
+        t->timer.func = tmcuart_send_event;
+    }
+}
+
 // Helper function to end a transmission and schedule a response
 static uint_fast8_t
 tmcuart_finalize(struct tmcuart_s *t)
 {
+    if (t->flags & TU_BATCH) {
+        // Store response bytes (none on a read timeout or tx only frame)
+        uint8_t rbytes = t->read_count / 8;
+        memcpy(&t->resp[t->resp_pos], t->data, rbytes);
+        t->resp_pos += rbytes;
+        t->batch_pos++;
+        if (t->batch_pos < t->batch_count
+            && !(t->batch_read_len && !rbytes)) {
+            // Start next queued frame after an idle line gap
+            tmcuart_reset_line(t);
+            t->flags |= TU_ACTIVE | TU_BATCH;
+            memcpy(t->data, &t->batch[t->batch_pos * t->frame_len]
+                   , t->frame_len);
+            t->write_count = t->frame_len * 8;
+            t->read_count = t->batch_read_len * 8;
+            tmcuart_start_frame(t);
+            t->timer.waketime += t->cfg_bit_time * 12;
+            return SF_RESCHEDULE;
+        }
+        // Batch complete (or aborted after a timeout)
+        tmcuart_reset_line(t);
+        t->flags |= TU_BATCH | TU_REPORT;
+        sched_wake_task(&tmcuart_wake);
+        return SF_DONE;
+    }
     tmcuart_reset_line(t);
     t->flags |= TU_REPORT;
     sched_wake_task(&tmcuart_wake);
@@ -200,16 +245,10 @@ command_tmcuart_send(uint32_t *args)
     if (write_len > sizeof(t->data) || read_len > sizeof(t->data))
         shutdown("tmcuart data too large");
     memcpy(t->data, write, write_len);
-    t->pos = 0;
     t->flags = (t->flags & (TU_LINE_HIGH|TU_PULLUP|TU_SINGLE_WIRE)) | TU_ACTIVE;
     t->write_count = write_len * 8;
     t->read_count = read_len * 8;
-    if (write_len >= 1 && (t->data[0] & 0x3f) == 0x2a) {
-        t->timer.func = tmcuart_send_sync_event;
-    } else {
-        t->bit_time = t->cfg_bit_time;
-        t->timer.func = tmcuart_send_event;
-    }
+    tmcuart_start_frame(t);
     irq_disable();
     t->timer.waketime = timer_read_time() + timer_from_us(200);
     sched_add_timer(&t->timer);
@@ -217,6 +256,42 @@ command_tmcuart_send(uint32_t *args)
 }
 DECL_COMMAND(command_tmcuart_send, "tmcuart_send oid=%c write=%*s read=%c");
 
+// Parse and schedule a multi-frame TMC UART transmission request
+void
+command_tmcuart_batch_send(uint32_t *args)
+{
+    struct tmcuart_s *t = oid_lookup(args[0], command_config_tmcuart);
+    if (t->flags & TU_ACTIVE)
+        // Uart is busy - silently drop this request (host should retransmit)
+        return;
+    uint8_t count = args[1];
+    uint8_t write_len = args[2];
+    uint8_t *write = command_decode_ptr(args[3]);
+    uint8_t read_len = args[4];
+    if (!count || write_len > sizeof(t->batch) || write_len % count
+        || write_len / count > sizeof(t->data) || read_len > sizeof(t->data)
+        || count * read_len > sizeof(t->resp))
+        shutdown("tmcuart batch data too large");
+    memcpy(t->batch, write, write_len);
+    t->batch_count = count;
+    t->batch_pos = 0;
+    t->frame_len = write_len / count;
+    t->batch_read_len = read_len;
+    t->resp_pos = 0;
+    t->flags = (t->flags & (TU_LINE_HIGH|TU_PULLUP|TU_SINGLE_WIRE))
+        | TU_ACTIVE | TU_BATCH;
+    memcpy(t->data, t->batch, t->frame_len);
+    t->write_count = t->frame_len * 8;
+    t->read_count = read_len * 8;
+    tmcuart_start_frame(t);
+    irq_disable();
+    t->timer.waketime = timer_read_time() + timer_from_us(200);
+    sched_add_timer(&t->timer);
+    irq_enable();
+}
+DECL_COMMAND(command_tmcuart_batch_send,
+             "tmcuart_batch_send oid=%c count=%c write=%*s read=%c");
+
 // Report completed response message back to host
 void
 tmcuart_task(void)
@@ -229,13 +304,18 @@ tmcuart_task(void)
         if (!(t->flags & TU_REPORT))
             continue;
         irq_disable();
-        t->flags &= ~TU_REPORT;
+        uint8_t is_batch = t->flags & TU_BATCH;
+        t->flags &= ~(TU_REPORT | TU_BATCH);
         irq_enable();
-        sendf("tmcuart_response oid=%c read=%*s"
-              , oid, t->read_count / 8, t->data);
+        if (is_batch)
+            sendf("tmcuart_batch_response oid=%c read=%*s"
+                  , oid, t->resp_pos, t->resp);
+        else
+            sendf("tmcuart_response oid=%c read=%*s"
+                  , oid, t->read_count / 8, t->data);
     }
 }
-DECL_TASK(tmcuart_task);
+DECL_TASK_WAKE(tmcuart_task, tmcuart_wake);
 
 void
 tmcuart_shutdown(void)
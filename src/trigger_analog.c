@@ -15,15 +15,29 @@
 #include "trigger_analog.h" // trigger_analog_update
 #include "trsync.h" // trsync_do_trigger
 
+// Maximum piecewise linear segments in raw value linearization
+#define LINEARIZE_MAX_SEGMENTS 16
+// Fractional bits in linearization segment gains
+#define LINEARIZE_FRAC_BITS 16
+
+// One segment of the piecewise linear raw value conversion
+struct linearize_segment {
+    int32_t raw_start, gain, offset;
+};
+
 // Main trigger_analog storage
 struct trigger_analog {
     // Raw value range check
     int32_t raw_min, raw_max;
+    // Raw value conversion (eg, frequency to height)
+    int32_t drift_offset;
+    uint8_t linearize_count;
+    struct linearize_segment linearize[LINEARIZE_MAX_SEGMENTS];
     // Filtering
     struct sos_filter *sf;
     // Trigger value checking
-    int32_t trigger_value, trigger_peak;
-    uint8_t trigger_type;
+    int32_t trigger_value, trigger_arm_value, trigger_peak;
+    uint8_t trigger_type, trigger_armed;
     // Trsync triggering
     uint8_t flags, trigger_reason, error_reason;
     struct trsync *ts;
@@ -41,11 +55,13 @@ enum {
 
 // Trigger types
 enum {
-    TT_ABS_GE, TT_GT, TT_DIFF_PEAK_GT
+    TT_ABS_GE, TT_GT, TT_DIFF_PEAK_GT, TT_HYST_ABS_GE, TT_LE
 };
 DECL_ENUMERATION("trigger_analog_type", "abs_ge", TT_ABS_GE);
 DECL_ENUMERATION("trigger_analog_type", "gt", TT_GT);
 DECL_ENUMERATION("trigger_analog_type", "diff_peak_gt", TT_DIFF_PEAK_GT);
+DECL_ENUMERATION("trigger_analog_type", "hyst_abs_ge", TT_HYST_ABS_GE);
+DECL_ENUMERATION("trigger_analog_type", "le", TT_LE);
 
 // Sample errors sent via trsync error code
 enum {
@@ -100,15 +116,47 @@ check_trigger(struct trigger_analog *ta, uint32_t time, int32_t value)
         }
         uint32_t delta = ta->trigger_peak - value;
         return delta > ta->trigger_value;
+    case TT_HYST_ABS_GE:
+        if (!ta->trigger_armed) {
+            // Await the signal settling within the arm threshold
+            if (abs(value) <= ta->trigger_arm_value)
+                ta->trigger_armed = 1;
+            return 0;
+        }
+        return abs(value) >= ta->trigger_value;
+    case TT_LE:
+        return value <= ta->trigger_value;
     }
     return 0;
 }
 
+// Convert a raw sensor value via the piecewise linear segment table
+static int32_t
+linearize_sample(struct trigger_analog *ta, int32_t sample)
+{
+    struct linearize_segment *ls = &ta->linearize[0];
+    uint_fast8_t i;
+    for (i = 1; i < ta->linearize_count; i++) {
+        if (sample < ta->linearize[i].raw_start)
+            break;
+        ls = &ta->linearize[i];
+    }
+    int64_t delta = (int64_t)(sample - ls->raw_start) * ls->gain;
+    int64_t res = ls->offset + (delta >> LINEARIZE_FRAC_BITS);
+    // Saturate extrapolation beyond the table endpoints
+    if (res > INT32_MAX)
+        return INT32_MAX;
+    if (res < INT32_MIN)
+        return INT32_MIN;
+    return res;
+}
+
 // Reset fields associated with trigger checking
 static void
 trigger_reset(struct trigger_analog *ta)
 {
     ta->trigger_peak = INT32_MIN;
+    ta->trigger_armed = 0;
 }
 
 // Stop homing due to an error
@@ -156,6 +204,11 @@ trigger_analog_update(struct trigger_analog *ta, int32_t sample)
         return;
     }
 
+    // Apply drift correction and conversion to trigger units
+    sample += ta->drift_offset;
+    if (ta->linearize_count)
+        sample = linearize_sample(ta, sample);
+
     // Perform filtering
     int32_t filtered_value = sample;
     int ret = sos_filter_apply(ta->sf, &filtered_value);
@@ -204,6 +257,33 @@ command_trigger_analog_set_raw_range(uint32_t *args)
 DECL_COMMAND(command_trigger_analog_set_raw_range,
     "trigger_analog_set_raw_range oid=%c raw_min=%i raw_max=%i");
 
+// Set one segment of the raw value linearization table
+void
+command_trigger_analog_set_linearize(uint32_t *args)
+{
+    struct trigger_analog *ta = trigger_analog_oid_lookup(args[0]);
+    uint8_t index = args[1], count = args[2];
+    if (index >= LINEARIZE_MAX_SEGMENTS || count > LINEARIZE_MAX_SEGMENTS)
+        shutdown("Linearize segment index larger than max segments");
+    ta->linearize[index].raw_start = args[3];
+    ta->linearize[index].gain = args[4];
+    ta->linearize[index].offset = args[5];
+    ta->linearize_count = count;
+}
+DECL_COMMAND(command_trigger_analog_set_linearize,
+    "trigger_analog_set_linearize oid=%c index=%c count=%c"
+    " raw_start=%i gain=%i offset=%i");
+
+// Set the drift correction offset (may be updated while homing)
+void
+command_trigger_analog_set_drift(uint32_t *args)
+{
+    struct trigger_analog *ta = trigger_analog_oid_lookup(args[0]);
+    ta->drift_offset = args[1];
+}
+DECL_COMMAND(command_trigger_analog_set_drift,
+             "trigger_analog_set_drift oid=%c drift=%i");
+
 // Set the triggering type and value
 void
 command_trigger_analog_set_trigger(uint32_t *args)
@@ -211,9 +291,10 @@ command_trigger_analog_set_trigger(uint32_t *args)
     struct trigger_analog *ta = trigger_analog_oid_lookup(args[0]);
     ta->trigger_type = args[1];
     ta->trigger_value = args[2];
+    ta->trigger_arm_value = args[3];
 }
 DECL_COMMAND(command_trigger_analog_set_trigger, "trigger_analog_set_trigger"
-    " oid=%c trigger_analog_type=%c trigger_value=%i");
+    " oid=%c trigger_analog_type=%c trigger_value=%i trigger_arm_value=%i");
 
 // Home an axis
 void
@@ -15,6 +15,7 @@
 struct trsync {
     struct timer report_time, expire_time;
     uint32_t report_ticks;
+    uint32_t window_clock, window_report_ticks;
     struct trsync_signal *signals;
     uint8_t flags, trigger_reason, expire_reason;
 };
@@ -63,7 +64,14 @@ trsync_report_event(struct timer *t)
     struct trsync *ts = container_of(t, struct trsync, report_time);
     ts->flags |= TSF_REPORT;
     sched_wake_task(&trsync_wake);
-    ts->report_time.waketime += ts->report_ticks;
+    uint32_t ticks = ts->report_ticks;
+    if (ts->window_report_ticks
+        && !timer_is_before(ts->report_time.waketime + ticks
+                            , ts->window_clock))
+        // Next report lands in the anticipated trigger window - tighten
+        // the reporting interval so the host can use smaller margins
+        ticks = ts->window_report_ticks;
+    ts->report_time.waketime += ticks;
     return SF_RESCHEDULE;
 }
 
@@ -111,6 +119,7 @@ trsync_clear(struct trsync *ts)
         tss = next;
     }
     ts->signals = NULL;
+    ts->window_clock = ts->window_report_ticks = 0;
     ts->flags = ts->trigger_reason = ts->expire_reason = 0;
 }
 
@@ -147,6 +156,20 @@ command_trsync_set_timeout(uint32_t *args)
 }
 DECL_COMMAND(command_trsync_set_timeout, "trsync_set_timeout oid=%c clock=%u");
 
+void
+command_trsync_set_trigger_window(uint32_t *args)
+{
+    struct trsync *ts = trsync_oid_lookup(args[0]);
+    irq_disable();
+    if (ts->flags & TSF_CAN_TRIGGER) {
+        ts->window_clock = args[1];
+        ts->window_report_ticks = args[2];
+    }
+    irq_enable();
+}
+DECL_COMMAND(command_trsync_set_trigger_window,
+             "trsync_set_trigger_window oid=%c clock=%u report_ticks=%u");
+
 static void
 trsync_report(uint8_t oid, uint8_t flags, uint8_t reason, uint32_t clock)
 {
@@ -189,7 +212,7 @@ trsync_task(void)
         trsync_report(oid, flags, trigger_reason, time);
     }
 }
-DECL_TASK(trsync_task);
+DECL_TASK_WAKE(trsync_task, trsync_wake);
 
 void
 trsync_shutdown(void)